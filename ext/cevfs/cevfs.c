@@ -34,7 +34,9 @@ SOFTWARE.
 #include "btreeInt.h"
 #endif
 #include <sys/stat.h>
+#include <time.h>
 #include "cevfs.h"
+#include "cevfs_codec.c"
 
 // Standard Sqlite3 pager header
 #define CEVFS_DB_HEADER1_OFST      000
@@ -53,6 +55,71 @@ SOFTWARE.
 #define CEVFS_FILE_SCHEMA_NO         1
 #define CEVFS_FIRST_MAPPED_PAGE      3
 
+// Upper pager write-ahead log layout (see wal.c)
+#define CEVFS_WAL_HDRSIZE          32
+#define CEVFS_WAL_FRAME_HDRSIZE    24
+#define CEVFS_WAL_CKPT_LOCK        1
+#define CEVFS_WAL_READ_LOCK0       3
+
+// Default number of decompressed upper pages cached per file.
+// Can be changed with the page_cache URI parameter; 0 disables the cache.
+#ifndef CEVFS_DEFAULT_PAGE_CACHE
+#define CEVFS_DEFAULT_PAGE_CACHE   64
+#endif
+
+// Default number of upper pages decoded ahead of a sequential scan.
+// Can be changed with the read_ahead URI parameter; 0 disables read-ahead.
+// Off by default like threads: pages are decoded on a background thread,
+// so xUncompress and xDecrypt must be safe to call from two threads.
+// Never more than half the page cache is used for pages read ahead.
+#ifndef CEVFS_DEFAULT_READ_AHEAD
+#define CEVFS_DEFAULT_READ_AHEAD   0
+#endif
+
+// Consecutive reads of upper pages in pgno order before read-ahead starts
+#define CEVFS_READ_AHEAD_TRIGGER   4
+
+// Number of codec scratch buffers kept for reuse per file
+#define CEVFS_SCRATCH_POOL         4
+
+// Default number of threads compressing and encrypting pages at commit.
+// Can be changed with the threads URI parameter; 0 or 1 encodes each page
+// as it is written.
+#ifndef CEVFS_DEFAULT_THREADS
+#define CEVFS_DEFAULT_THREADS      0
+#endif
+#define CEVFS_MAX_THREADS          16
+
+// Max full upper pages held back until commit. When this many are staged
+// they are encoded and handed to the lower pager early.
+#ifndef CEVFS_MAX_STAGED
+#define CEVFS_MAX_STAGED           1024
+#endif
+#define CEVFS_STAGED_HASH          (CEVFS_MAX_STAGED*2)
+
+// Default number of pages cevfs_build writes between checkpoints
+#ifndef CEVFS_BUILD_CHECKPOINT
+#define CEVFS_BUILD_CHECKPOINT     16384
+#endif
+
+// Default number of compressed pages moved by one free space reclamation step
+#define CEVFS_COMPACT_STEP         1000
+
+// Times a connection sleeps CEVFS_BUSY_SLEEP microseconds waiting for another
+// one to let go of the lower pager before giving up with SQLITE_BUSY
+#define CEVFS_BUSY_RETRIES         100
+#define CEVFS_BUSY_SLEEP           1000
+
+// Most upper pages that can be compressed together as one frame
+#define CEVFS_MAX_FRAME_PAGES      16
+
+// Fewest staged pages worth handing to a thread of their own
+#define CEVFS_MIN_PAGES_PER_THREAD 16
+
+// Each WAL frame is stored in the real -wal file as a record:
+// 4-byte frame number, 4-byte payload size, 24-byte frame header, payload.
+#define CEVFS_WAL_RECORD_HDRSIZE   (8+CEVFS_WAL_FRAME_HDRSIZE)
+
 #ifdef SQLITE_DEBUG
 #define CEVFS_PRINTF(a,b,...) cevfs_printf(a,b,##__VA_ARGS__)
 #else
@@ -97,7 +164,10 @@ struct cevfs_header {
   Pgno uppPageFile;                    // 04 max pgno in upper pager, used to report filesize
   u16 mmTblMaxCnt;                     // 02 max entries avail for master map table, computed when table is loaded
   u16 mmTblCurrCnt;                    // 02 curr total elements used in master map table
-  unsigned char reserved[79];          // 79 pad structure to 100 bytes
+  u8 cmprCodec;                        // 01 built-in compression codec id, 0 if set up by xAutoDetect
+  u8 encCodec;                         // 01 built-in cipher id, 0 if set up by xAutoDetect
+  u8 framePages;                       // 01 upper pages compressed together as a frame, 0 if alone
+  unsigned char reserved[76];          // 76 pad structure to 100 bytes
 };
 
 /*
@@ -137,6 +207,66 @@ struct __attribute__ ((__packed__)) cevfs_map_entry {
   CevfsCmpOfst cmprOfst;               // 02 lower page offset for compressed page
 };
 
+/*
+** Location of the most recent record for an upper WAL frame
+** within the real (compressed) -wal file.
+*/
+typedef struct CevfsWalFrame CevfsWalFrame;
+struct CevfsWalFrame {
+  sqlite3_int64 iOfst;                 // Offset of the record in the real file
+  u32 nPayload;                        // Size of the compressed/encrypted page
+};
+
+/*
+** A decompressed, decrypted upper page kept in the per-file page cache.
+** Slots not holding a page have uppPgno 0 and sit at the LRU end of the list.
+*/
+typedef struct CevfsCachedPage CevfsCachedPage;
+struct CevfsCachedPage {
+  Pgno uppPgno;                        // Upper pager pgno
+  CevfsCachedPage *pHashNext;          // Next page in the same hash bucket
+  CevfsCachedPage *pLruPrev;           // Neighbour towards most recently used
+  CevfsCachedPage *pLruNext;           // Neighbour towards least recently used
+  u8 *aData;                           // Upper page image
+};
+
+/*
+** An unused byte range on a lower pager data page, left behind when a
+** compressed page shrinks or moves. Sizes can reach a whole lower page,
+** which may be 64K, hence u32.
+*/
+typedef struct CevfsFreeRange CevfsFreeRange;
+struct CevfsFreeRange {
+  Pgno lwrPgno;                        // Lower pager page holding the range
+  u32 ofst;                            // Offset of the range within the page
+  u32 sz;                              // Size of the range in bytes
+};
+
+/*
+** A small pool of equally sized codec buffers kept for reuse.
+*/
+typedef struct CevfsScratch CevfsScratch;
+struct CevfsScratch {
+  u8 *ap[CEVFS_SCRATCH_POOL];          // Buffers available for reuse
+  int n;                               // Number of buffers in ap
+  size_t nSz;                          // Size of each buffer
+};
+
+/*
+** A full upper page written since the last sync, waiting to be
+** compressed and encrypted together with the rest of the commit.
+** In frame mode the same structure holds a whole frame while it is encoded.
+*/
+typedef struct CevfsStagedPage CevfsStagedPage;
+struct CevfsStagedPage {
+  Pgno uppPgno;                        // Upper pager pgno, first page of the frame in frame mode
+  u32 nPage;                           // Number of upper pages in aData
+  u8 *aData;                           // Upper page image
+  void *pOut;                          // Encoded page, filled in by an encoding thread
+  size_t nOut;                         // Size of pOut
+  int rc;                              // Result of encoding the page
+};
+
 /*
 ** An instance of this structure is attached to each cevfs VFS to
 ** provide auxiliary non-persisted information.
@@ -158,6 +288,26 @@ struct cevfs_info {
   u32 upperPgSize;                     // Temp storage for upperPgSize
 };
 
+/*
+** A batch of upper pages read ahead of a sequential scan. Their encoded
+** slots are copied out of the lower pager, then decoded on a background
+** thread and moved into the page cache once the scan gets there.
+*/
+typedef struct CevfsReadAhead CevfsReadAhead;
+struct CevfsReadAhead {
+  cevfs_file *p;                       // File being read
+  SQLiteThread *pThread;               // Decoding thread, NULL if not started
+  u32 nPage;                           // Number of pages in the batch
+  u32 nPgSz;                           // Upper page size
+  Pgno *aPgno;                         // Upper pgno of each page
+  u32 *aSlotOfst;                      // Offset of each encoded page in aSlot
+  u32 *aSlotSz;                        // Encoded size of each page
+  int *aRc;                            // Result of decoding each page
+  u8 *aSlot;                           // Encoded pages back to back
+  u8 *aOut;                            // Decoded pages back to back
+  CevfsStats stats;                    // Codec counters, added to the file's once decoded
+};
+
 /*
 ** The sqlite3_file object for the shim.
 */
@@ -171,15 +321,23 @@ struct cevfs_file {
   cevfs_header cevfsHeader;            // Cevfs header with page mapping data
   CevfsMethods vfsMethods;             // Custom methods for compression/enctyption
   size_t nEncIvSz;                     // IV blob size in bytes for encryption/decryption routines
+  void *pCmprCtx;                      // Context passed to the compression methods
+  void *pEncCtx;                       // Context passed to the encryption methods
+  void *pCipher;                       // Built-in cipher context owned by this file
 
   // map
   CevfsMMTblEntry *mmTbl;              // The master mapping table
-  u16 mmTblCurrIx;                     // Index of the current page map in mmTbl
-  cevfs_map_entry *pPgMap;             // The current page map
+  cevfs_map_entry *aPgMap;             // All page maps back to back, indexed by upper pgno-1
   cevfs_map_entry *pBigEndianPgMap;    // Used for converting integers to big-endian when saving
+  u8 *aPgMapDirty;                     // Bitset of page maps (by mmTbl index) needing to be persisted
+  u32 nPgMapAlloc;                     // Number of page maps aPgMap has room for
   u16 pgMapMaxCnt;                     // Max entries for a page map, based on page size
   u16 pgMapSz;                         // Size in bytes for the page map allocation
-  u32 nBytesPerPgMap;                  // Performance optimization premultiplication store
+
+  // free space, rebuilt from the page maps on the first write
+  CevfsFreeRange *aFree;               // Unused ranges on lower data pages
+  u32 nFree;                           // Number of entries in aFree
+  u32 nFreeAlloc;                      // Allocated entries in aFree
 
   // pager
   CevfsMemPage *pPage1;                // Page 1 of the pager
@@ -188,12 +346,61 @@ struct cevfs_file {
   u32 pageSize;                        // Page size of the lower pager
   u32 usableSize;                      // Number of usable bytes on each page
   u8 nTransactions;                    // Number of open transactions on the pager
+  u32 iLwrChangeCtr;                   // Lower change counter when the page maps were loaded
+  u8 eUppLock;                         // Lock the upper pager holds on this file
+  u8 nBusy;                            // Busy handler calls for the current lower lock attempt
+
+  // wal
+  cevfs_file *pDbFile;                 // Main db file when this file is its write-ahead log
+  cevfs_file *pWalFile;                // Write-ahead log of this main db file while it is open
+  u32 walPgSz;                         // Upper page size recorded in the WAL header
+  u8 walSalt[8];                       // Salts of the WAL generation currently indexed
+  CevfsWalFrame *aWalFrame;            // Record location of each frame, indexed by frame# - 1
+  u32 nWalFrame;                       // Number of frames indexed
+  u32 nWalFrameAlloc;                  // Allocated entries in aWalFrame
+  sqlite3_int64 iWalEnd;               // Real file offset just past the last record
+  u8 *aWalPending;                     // Frame being assembled from partial writes
+  u32 iWalPending;                     // Frame# held in aWalPending, 0 if none
+  u32 nWalPending;                     // Bytes of aWalPending filled so far
+  u8 *aWalFrameBuf;                    // Scratch buffer for decoding a frame
+
+  // decompressed page cache
+  CevfsCachedPage *aCache;             // Cache slots, nCacheMax entries
+  CevfsCachedPage **apCacheHash;       // Cached pages hashed by upper pgno
+  CevfsCachedPage *pCacheMru;          // Most recently used slot
+  CevfsCachedPage *pCacheLru;          // Least recently used slot
+  u8 *aCacheSpace;                     // Page images for all slots
+  u32 nCacheMax;                       // Max pages to cache, 0 disables the cache
+  u32 nCacheUsed;                      // Slots handed out so far
+  u32 nCacheHash;                      // Buckets in apCacheHash, a power of 2
+  u32 nCachePgSz;                      // Upper page size the cache was built for
+
+  // sequential read-ahead
+  u32 nReadAhead;                      // Pages to decode ahead of a scan, 0 disables read-ahead
+  Pgno iSeqNext;                       // Upper pgno read next if access stays sequential
+  u32 nSeqRun;                         // Sequential reads in a row so far
+  Pgno iAheadEnd;                      // Last upper pgno read ahead in the current scan
+  CevfsReadAhead *pAhead;              // Batch being decoded, if any
+
+  // pages staged for encoding at commit
+  CevfsStagedPage *aStaged;            // Staged upper pages, CEVFS_MAX_STAGED slots
+  u32 *aStagedHash;                    // Index+1 into aStaged, hashed by upper pgno
+  u32 nStaged;                         // Slots of aStaged holding a page
+  u32 nStagedAlloc;                    // Slots of aStaged with an aData buffer
+  u32 nStagedPgSz;                     // Upper page size of the aData buffers
+  int nThreads;                        // Encoding threads; less than 2 encodes on write
+
+  CevfsScratch scratch;                // Codec scratch buffers
+  CevfsStats stats;                    // I/O and codec counters
 
   // bools
-  u8 bPgMapDirty:1;                    // Curr page map needs to be persisted
   u8 bReadOnly:1;                      // True when db was open for read-only
   u8 bCompressionEnabled:1;
   u8 bEncryptionEnabled:1;
+  u8 bWal:1;                           // This file is the upper pager's write-ahead log
+  u8 bFreeMap:1;                       // aFree describes all free space in the lower pager
+  u8 bLwrDirty:1;                      // The open lower transaction changed something
+  u8 bLwrStale:1;                      // Page maps must be reloaded before they are used again
 
 };
 
@@ -243,6 +450,10 @@ static int cevfsWriteUncompressed(cevfs_file *, Pgno, CevfsCmpOfst, const void *
 static int cevfsReadUncompressed(cevfs_file *, Pgno, CevfsCmpOfst, void *zBuf, int iAmt);
 static int cevfsSaveHeader(cevfs_file *p);
 static int cevfsLoadHeader(cevfs_file *p);
+static void cevfsReadAheadEnd(cevfs_file *p, int bKeep);
+static void cevfsCacheFree(cevfs_file *p);
+static void cevfsFreeMapClear(cevfs_file *p);
+static void cevfsStagedTruncate(cevfs_file *p, Pgno uppPgno);
 
 /*
 ** Return a pointer to the tail of the pathname.  Examples:
@@ -428,7 +639,6 @@ static int cevfsCreateMMTbl(cevfs_file *p, int *memSzOut){
   // At this point, header may already be loaded from persistent storage
   // so be careful modifying header values that could be needed elsewhere.
   p->cevfsHeader.mmTblMaxCnt = maxEntries;
-  p->mmTblCurrIx = -1; // u16, so results in some large number to mean "not defined"
 
   // allocate
   int memSz = maxEntries*sizeof(CevfsMMTblEntry);
@@ -439,12 +649,58 @@ static int cevfsCreateMMTbl(cevfs_file *p, int *memSzOut){
   return SQLITE_OK;
 }
 
+/*
+** Make room in aPgMap for at least nMap page maps.
+*/
+static int cevfsGrowPageMaps(cevfs_file *p, u32 nMap){
+  if( nMap>p->nPgMapAlloc ){
+    u32 nNew = p->nPgMapAlloc ? p->nPgMapAlloc*2 : 4;
+    while( nNew<nMap ) nNew *= 2;
+    if( nNew>p->cevfsHeader.mmTblMaxCnt ) nNew = p->cevfsHeader.mmTblMaxCnt;
+    if( nNew<nMap ) return CEVFS_ERROR_PAGE_SIZE_TOO_SMALL;
+    cevfs_map_entry *aNew = sqlite3_realloc64(p->aPgMap, (sqlite3_uint64)nNew*p->pgMapSz);
+    if( !aNew ) return SQLITE_NOMEM;
+    u8 *aDirty = sqlite3_realloc64(p->aPgMapDirty, (nNew+7)/8);
+    if( !aDirty ){
+      p->aPgMap = aNew;
+      return SQLITE_NOMEM;
+    }
+    memset((u8 *)aNew + (size_t)p->nPgMapAlloc*p->pgMapSz, 0, (size_t)(nNew-p->nPgMapAlloc)*p->pgMapSz);
+    memset(aDirty + (p->nPgMapAlloc+7)/8, 0, (nNew+7)/8 - (p->nPgMapAlloc+7)/8);
+    p->aPgMap = aNew;
+    p->aPgMapDirty = aDirty;
+    p->nPgMapAlloc = nNew;
+  }
+  return SQLITE_OK;
+}
+
+static void cevfsSetPageMapDirty(cevfs_file *p, u32 iEntry){
+  u32 ix = iEntry / p->pgMapMaxCnt;
+  p->aPgMapDirty[ix/8] |= (u8)(1<<(ix&7));
+}
+
+/*
+** Persist every page map that changed since the last save.
+*/
 static int cevfsSavePagemapData(cevfs_file *p){
   int rc = SQLITE_OK;
-  if( p->bPgMapDirty ){
-    Pgno pgno = p->mmTbl[p->mmTblCurrIx].lwrPgno;
-    rc = cevfsWriteUncompressed(p, pgno, 0, p->pBigEndianPgMap, p->pgMapSz);
-    if( rc==SQLITE_OK ) p->bPgMapDirty = 0;
+  cevfs_header *header = &p->cevfsHeader;
+  for(u16 ix=0; ix<header->mmTblCurrCnt && rc==SQLITE_OK; ix++){
+    if( p->aPgMapDirty[ix/8] & (1<<(ix&7)) ){
+      cevfs_map_entry *aMap = &p->aPgMap[(size_t)ix*p->pgMapMaxCnt];
+      u16 maxCnt = ix==header->mmTblCurrCnt-1 ? header->pgMapCnt : p->pgMapMaxCnt;
+      memset(p->pBigEndianPgMap, 0, p->pgMapSz);
+      for(u16 i=0; i<maxCnt; i++){
+        put4byte((u8 *)&p->pBigEndianPgMap[i].lwrPgno, aMap[i].lwrPgno);
+        put2byte((u8 *)&p->pBigEndianPgMap[i].cmprSz, aMap[i].cmprSz);
+        put2byte((u8 *)&p->pBigEndianPgMap[i].cmprOfst, aMap[i].cmprOfst);
+      }
+      rc = cevfsWriteUncompressed(p, p->mmTbl[ix].lwrPgno, 0, p->pBigEndianPgMap, p->pgMapSz);
+      if( rc==SQLITE_OK ){
+        p->aPgMapDirty[ix/8] &= (u8)~(1<<(ix&7));
+        p->stats.nPageMapWrites++;
+      }
+    }
   }
   return rc;
 }
@@ -460,28 +716,40 @@ static int cevfsSaveMMTbl(cevfs_file *p){
       put2byte((u8 *)&buf[i].lwrPgno, p->mmTbl[i].lwrPgno);
     }
     if( (rc = cevfsWriteUncompressed(p, 1, CEVFS_DB_MMTBL_OFST, buf, memSz))==SQLITE_OK){
-      sqlite3_free(buf);
       rc = cevfsSavePagemapData(p);
     }
+    sqlite3_free(buf);
   }else rc = SQLITE_NOMEM;
   return rc;
 }
 
+/*
+** Read page map ix from the lower pager into its slot in aPgMap.
+*/
 static int cevfsLoadPagemapData(cevfs_file *p, u16 ix){
   int rc;
   cevfs_header *header = &p->cevfsHeader;
-  assert( p->bPgMapDirty==0 );
-  assert( ix != p->mmTblCurrIx ); // mmTblCurrIx initially large number to mean no entries yet
   Pgno pgno = p->mmTbl[ix].lwrPgno;
   rc = cevfsReadUncompressed(p, pgno, 0, p->pBigEndianPgMap, p->pgMapSz);
   if( rc==SQLITE_OK ){
+    cevfs_map_entry *aMap = &p->aPgMap[(size_t)ix*p->pgMapMaxCnt];
     u16 maxCnt = ix==header->mmTblCurrCnt-1 ? header->pgMapCnt : p->pgMapMaxCnt;
     for(u16 i = 0; i<maxCnt; i++){
-      p->pPgMap[i].lwrPgno = get4byte((u8 *)&p->pBigEndianPgMap[i].lwrPgno);
-      p->pPgMap[i].cmprSz = get2byte((u8 *)&p->pBigEndianPgMap[i].cmprSz);
-      p->pPgMap[i].cmprOfst = get2byte((u8 *)&p->pBigEndianPgMap[i].cmprOfst);
+      aMap[i].lwrPgno = get4byte((u8 *)&p->pBigEndianPgMap[i].lwrPgno);
+      aMap[i].cmprSz = get2byte((u8 *)&p->pBigEndianPgMap[i].cmprSz);
+      aMap[i].cmprOfst = get2byte((u8 *)&p->pBigEndianPgMap[i].cmprOfst);
     }
-    p->mmTblCurrIx = ix;
+  }
+  return rc;
+}
+
+/*
+** Load every page map so that lookups never need to touch the lower pager.
+*/
+static int cevfsLoadAllPagemaps(cevfs_file *p){
+  int rc = cevfsGrowPageMaps(p, p->cevfsHeader.mmTblCurrCnt);
+  for(u16 ix=0; rc==SQLITE_OK && ix<p->cevfsHeader.mmTblCurrCnt; ix++){
+    rc = cevfsLoadPagemapData(p, ix);
   }
   return rc;
 }
@@ -509,59 +777,121 @@ static int cevfsLoadMMTbl(cevfs_file *p){
   return rc;
 }
 
+/*
+** (Re)load the cevfs header, master map table and page maps from the
+** lower pager, dropping everything derived from the previous ones.
+*/
+static int cevfsPagerLoad(cevfs_file *p, int nPageFile){
+  cevfs_header *header = &p->cevfsHeader;
+  int rc = SQLITE_OK;
+
+  cevfsReadAheadEnd(p, 0);
+  cevfsCacheFree(p);
+  cevfsFreeMapClear(p);
+  if( p->mmTbl ){
+    sqlite3_free(p->mmTbl);
+    p->mmTbl = NULL;
+  }
+
+  // calc max entries for each page map based on page size
+  p->pgMapMaxCnt = p->pageSize / sizeof(cevfs_map_entry);
+  p->pgMapSz = p->pgMapMaxCnt * sizeof(cevfs_map_entry);
+  if( p->aPgMap ){
+    memset((void *)p->aPgMap, 0, (size_t)p->nPgMapAlloc*p->pgMapSz);
+    memset(p->aPgMapDirty, 0, (p->nPgMapAlloc+7)/8);
+  }
+  p->lwrPageFile = (Pgno)nPageFile;
+
+  /* All page maps are kept in memory (aPgMap, grown as maps are added).
+   This buffer is only used to convert a map to big-endian when saving. */
+  if( !p->pBigEndianPgMap && !(p->pBigEndianPgMap = sqlite3_malloc(p->pgMapSz)) ) return SQLITE_NOMEM;
+  memset((void *)p->pBigEndianPgMap, 0, p->pgMapSz);
+  if( nPageFile==0 ){
+    /* We will be creating a new database so set up some data that is
+     needed right away that would be too late to do in cevfsNewDatabase(). */
+    header->currPgno = CEVFS_FIRST_MAPPED_PAGE;
+    header->currPageOfst = 0;
+    header->pgMapCnt = 0;
+    header->uppPageFile = 0;
+    if( (rc = cevfsCreateMMTbl(p, NULL))==SQLITE_OK ){
+      p->mmTbl[0].lwrPgno = 2;
+      header->mmTblCurrCnt = 1;
+      rc = cevfsGrowPageMaps(p, 1);
+    }
+  }else{
+    // restore some data
+    rc = cevfsLoadHeader(p);
+    if( rc==SQLITE_OK && header->schema > CEVFS_FILE_SCHEMA_NO ){
+      // The file schema# is larger than this version can handle.
+      // A newer version is needed to read this file.
+      rc = CEVFS_ERROR_EXT_VERSION_TOO_OLD;
+    }
+    if( rc==SQLITE_OK ) rc = cevfsLoadMMTbl(p);
+    if( rc==SQLITE_OK ) rc = cevfsLoadAllPagemaps(p);
+  }
+  return rc;
+}
+
+/*
+** True while the lower pager has to stay locked: a lower transaction is
+** open or pages are staged for one, or the upper pager holds a lock on the
+** database in rollback mode. In WAL mode the upper lock is kept on the
+** -wal file instead and the lower pager is only locked for each read.
+*/
+static int cevfsPagerHeld(cevfs_file *p){
+  return p->nTransactions>0 || p->nStaged>0
+      || (p->eUppLock>=SQLITE_LOCK_SHARED && p->pWalFile==NULL);
+}
+
+static void cevfsPagerUnlock(cevfs_file *p){
+  if( p->pPage1 && !cevfsPagerHeld(p) ) cevfsReleasePage1(p);
+}
+
+/*
+** Lock the lower pager and hold page 1 until cevfsPagerUnlock(). Another
+** connection may have committed since page 1 was last held, so the page
+** maps are reloaded whenever the lower change counter has moved.
+*/
 static int cevfsPagerLock(cevfs_file *p){
-  int rc;
-  assert( p->pPage1==0 );
-  if( (rc = sqlite3PagerSharedLock(p->pPager))==SQLITE_OK ){
+  int rc = SQLITE_OK;
+  int nPageFile = 0;
+  u32 iChangeCtr;
+
+  if( !p->pPage1 ){
     DbPage *pDbPage1;
-    if( (rc = sqlite3PagerGet(p->pPager, 1, &pDbPage1, 0))==SQLITE_OK ){
-      p->pPage1 = memPageFromDbPage(pDbPage1, 1);
-      int nPageFile = 0;
-      sqlite3PagerPagecount(p->pPager, &nPageFile);
+    p->nBusy = 0;
+    if( (rc = sqlite3PagerSharedLock(p->pPager))!=SQLITE_OK ) return rc;
+    if( (rc = sqlite3PagerGet(p->pPager, 1, &pDbPage1, 0))!=SQLITE_OK ) return rc;
+    /* reminder: page 1 stays referenced while the lower pager is in use, as
+     unreferencing it resets the pager to PAGER_OPEN and drops its lock. */
+    p->pPage1 = memPageFromDbPage(pDbPage1, 1);
+    // A recycled cache slot can keep pgno 1 while its page handle was cleared
+    p->pPage1->pDbPage = pDbPage1;
+    p->pPage1->aData = sqlite3PagerGetData(pDbPage1);
+  }else if( !p->bLwrStale ){
+    return SQLITE_OK;
+  }
 
-      // calc max entries for each page map based on page size
-      p->pgMapMaxCnt = p->pageSize / sizeof(cevfs_map_entry);
-      p->pgMapSz = p->pgMapMaxCnt * sizeof(cevfs_map_entry);
-
-      // Optimization: Do this multiplication and store it for later use.
-      p->nBytesPerPgMap = p->pgMapMaxCnt * p->cevfsHeader.uppPgSz;
-
-      /* Allocate space for a single page map.
-       Only one page map will be in memory at a time. */
-      p->pPgMap = sqlite3_malloc(p->pgMapSz);
-      p->pBigEndianPgMap = sqlite3_malloc(p->pgMapSz);
-      if( p->pPgMap && p->pBigEndianPgMap ){
-        memset((void *)p->pPgMap, 0, p->pgMapSz);
-        memset((void *)p->pBigEndianPgMap, 0, p->pgMapSz);
-        if( nPageFile==0 ){
-          /* We will be creating a new database so set up some data that is
-           needed right away that would be too late to do in cevfsNewDatabase(). */
-          if( (rc = cevfsCreateMMTbl(p, NULL))==SQLITE_OK ){
-            p->mmTbl[0].lwrPgno = 2;
-            p->cevfsHeader.mmTblCurrCnt = 1;
-          }
-        }else{
-          // restore some data
-          rc = cevfsLoadHeader(p);
-          if( rc==SQLITE_OK && p->cevfsHeader.schema > CEVFS_FILE_SCHEMA_NO ){
-            // The file schema# is larger than this version can handle.
-            // A newer version is needed to read this file.
-            rc = CEVFS_ERROR_EXT_VERSION_TOO_OLD;
-          }
-          if( rc==SQLITE_OK ) rc = cevfsLoadMMTbl(p);
-          if( rc==SQLITE_OK ) rc = cevfsLoadPagemapData(p, 0);
-        }
-        /* reminder: do not call sqlite3PagerUnref(pDbPage1) here as this will
-         cause pager state to reset to PAGER_OPEN which is not desirable for writing to pager. */
-      }else rc = SQLITE_NOMEM;
+  sqlite3PagerPagecount(p->pPager, &nPageFile);
+  iChangeCtr = nPageFile>0 ? get4byte(p->pPage1->aData+24) : 0;
+  if( !p->mmTbl || p->bLwrStale || iChangeCtr!=p->iLwrChangeCtr ){
+    p->bLwrStale = 1;
+    if( (rc = cevfsPagerLoad(p, nPageFile))==SQLITE_OK ){
+      p->iLwrChangeCtr = iChangeCtr;
+      p->bLwrStale = 0;
     }
   }
+  if( rc!=SQLITE_OK ) cevfsPagerUnlock(p);
   return rc;
 }
 
-static int cevfsPagerWrite(cevfs_file *p, PgHdr *pPg){
+/*
+** Start a lower pager write transaction unless one is already open.
+*/
+static int cevfsPagerBegin(cevfs_file *p){
   int rc = SQLITE_OK;
   if( p->nTransactions == 0 ){
+    p->nBusy = 0;
     if( (rc = sqlite3PagerBegin(p->pPager, 0, 1))==SQLITE_OK ){
       p->nTransactions++;
       if( p->lwrPageFile==0 ){
@@ -569,10 +899,62 @@ static int cevfsPagerWrite(cevfs_file *p, PgHdr *pPg){
       }
     }
   }
-  if( rc==SQLITE_OK ) return sqlite3PagerWrite(pPg);
   return rc;
 }
 
+static int cevfsPagerWrite(cevfs_file *p, PgHdr *pPg){
+  int rc = cevfsPagerBegin(p);
+  if( rc==SQLITE_OK ){
+    p->bLwrDirty = 1;
+    rc = sqlite3PagerWrite(pPg);
+  }
+  return rc;
+}
+
+/*
+** Take the lower pager lock standing for upper lock eLock in rollback mode.
+*/
+static int cevfsPagerLockUpper(cevfs_file *p, int eLock){
+  int rc;
+  if( (rc = cevfsPagerLock(p))==SQLITE_OK && eLock>=SQLITE_LOCK_RESERVED ){
+    rc = cevfsPagerBegin(p);
+    if( rc==SQLITE_OK && eLock==SQLITE_LOCK_EXCLUSIVE ){
+      p->nBusy = 0;
+      rc = sqlite3PagerExclusiveLock(p->pPager);
+    }
+  }
+  return rc;
+}
+
+/*
+** Roll back the lower transaction after a failed commit. Whatever was
+** written since the last commit is lost, so the page maps are reloaded and
+** decoded pages thrown away before they are used again.
+*/
+static void cevfsPagerRollback(cevfs_file *p){
+  cevfsReadAheadEnd(p, 0);
+  cevfsStagedTruncate(p, 1);
+  if( p->nTransactions>0 ){
+    sqlite3PagerRollback(p->pPager);
+    p->nTransactions = 0;
+  }
+  p->bLwrDirty = 0;
+  p->bLwrStale = 1;
+  cevfsCacheFree(p);
+}
+
+/*
+** Busy handler of the lower pager. In WAL mode other connections only lock
+** it for a single read, so waiting a little is usually enough.
+*/
+static int cevfsPagerBusy(void *pArg){
+  cevfs_file *p = (cevfs_file *)pArg;
+  if( p->nBusy>=CEVFS_BUSY_RETRIES ) return 0;
+  p->nBusy++;
+  sqlite3OsSleep(p->pInfo->pRootVfs, CEVFS_BUSY_SLEEP);
+  return 1;
+}
+
 static int cevfsWriteUncompressed(
   cevfs_file *pFile,
   Pgno pgno,
@@ -604,7 +986,10 @@ static int cevfsSaveHeader(cevfs_file *p){
   put4byte(buf+13, header->uppPageFile);
   put2byte(buf+17, header->mmTblMaxCnt);
   put2byte(buf+19, header->mmTblCurrCnt);
-  memset(buf+21, 0, 79);
+  buf[21] = header->cmprCodec;
+  buf[22] = header->encCodec;
+  buf[23] = header->framePages;
+  memset(buf+24, 0, 76);
   return cevfsWriteUncompressed(p, 1, CEVFS_DB_HEADER2_OFST, buf, CEVFS_DB_HEADER2_SZ);
 }
 
@@ -621,6 +1006,9 @@ static int cevfsLoadHeader(cevfs_file *p){
     header->uppPageFile = get4byte(buf+13);
     header->mmTblMaxCnt = get2byte(buf+17);
     header->mmTblCurrCnt = get2byte(buf+19);
+    header->cmprCodec = buf[21];
+    header->encCodec = buf[22];
+    header->framePages = buf[23];
   }
   return rc;
 }
@@ -674,42 +1062,6 @@ static int cevfsNewDatabase(cevfs_file *pFile){
   return rc;
 }
 
-/*
-** Switch to a specific page map based on pager offset,
-** saving the current page map if needed.
-** @returns index# of page map switched to.
-*/
-static u16 cevfsSwitchPageMap(cevfs_file *p, sqlite_int64 iUppOfst){
-  int rc = SQLITE_ERROR;
-  cevfs_info *pInfo = p->pInfo;
-  cevfs_header *header = &p->cevfsHeader;
-  u16 ix = 0;
-
-  /*
-    Calculate map index based on upper pager offset.
-    Check last entry first as an optimization in case we are writing.
-    Perhaps we can do this check only when we are writing, skip for read-only.
-  */
-  ix = iUppOfst >= (p->nBytesPerPgMap * header->mmTblCurrCnt)
-  ? header->mmTblCurrCnt-1
-  : (u16)(iUppOfst / p->nBytesPerPgMap);
-  if( ix<header->mmTblCurrCnt ) rc=SQLITE_OK;
-
-  // switch
-  if( rc==SQLITE_OK && ix != p->mmTblCurrIx ){
-    CEVFS_PRINTF(pInfo, "Switching to map #%u for offset %lld\n", (unsigned)ix, iUppOfst);
-    // save
-    if( (rc = cevfsSavePagemapData(p))==SQLITE_OK ){
-      // reset
-      memset(p->pPgMap, 0, p->pgMapSz);
-      //load
-      rc = cevfsLoadPagemapData(p, ix);
-      if( rc==SQLITE_OK ) p->mmTblCurrIx = ix;
-    }
-  }
-  return ix;
-}
-
 static int cevfsPageMapGet(
   cevfs_file *pFile,
   sqlite_uint64 uSrcOfst,
@@ -717,25 +1069,19 @@ static int cevfsPageMapGet(
   Pgno *outLwrPgno,
   CevfsCmpOfst *outCmpOfst,
   CevfsCmpSize *outCmpSz,
-  u16 *outIx
+  u32 *outIx
 ){
   cevfs_header *header = &pFile->cevfsHeader;
-  if( outUppPgno ) *outUppPgno = (Pgno)(uSrcOfst/header->uppPgSz+1);
-  int currPgMapNo = cevfsSwitchPageMap(pFile, uSrcOfst);
-  if( pFile->pPgMap ){
-    // determine max elements based on if last page map is currently in memory
-    u16 maxCnt = pFile->mmTblCurrIx==header->mmTblCurrCnt-1 ? header->pgMapCnt : pFile->pgMapMaxCnt;
-    // determine which page map
-    u16 pgMapIx = (u16)(uSrcOfst/pFile->nBytesPerPgMap);
-    // determine index of entry on page map
-    int ix = uSrcOfst % pFile->nBytesPerPgMap / header->uppPgSz;
-    if(
-      ix<maxCnt                 // if we reach or go beyond maxCnt, entry doesn't exist yet
-      && pgMapIx==currPgMapNo   // if pgMap not yet created, entry doesn't exist yet
-    ){
-      if( outLwrPgno ) *outLwrPgno = pFile->pPgMap[ix].lwrPgno;
-      if( outCmpSz ) *outCmpSz = pFile->pPgMap[ix].cmprSz;
-      if( outCmpOfst ) *outCmpOfst = pFile->pPgMap[ix].cmprOfst;
+  // Entries for all page maps are contiguous, so the upper pgno is the index.
+  u32 ix = (u32)(uSrcOfst/header->uppPgSz);
+  if( outUppPgno ) *outUppPgno = (Pgno)ix+1;
+  if( pFile->aPgMap && header->mmTblCurrCnt>0 ){
+    u32 nEntry = (u32)(header->mmTblCurrCnt-1)*pFile->pgMapMaxCnt + header->pgMapCnt;
+    // if we reach or go beyond nEntry, entry doesn't exist yet
+    if( ix<nEntry ){
+      if( outLwrPgno ) *outLwrPgno = pFile->aPgMap[ix].lwrPgno;
+      if( outCmpSz ) *outCmpSz = pFile->aPgMap[ix].cmprSz;
+      if( outCmpOfst ) *outCmpOfst = pFile->aPgMap[ix].cmprOfst;
       if( outIx ) *outIx = ix;
       return SQLITE_OK;
     }
@@ -743,6 +1089,222 @@ static int cevfsPageMapGet(
   return SQLITE_ERROR;
 }
 
+/*
+** Number of upper pages compressed together as one frame, 1 unless the
+** database was created in frame mode. Frames only pay off with compression.
+*/
+static u32 cevfsFramePages(cevfs_file *p){
+  u32 n = p->cevfsHeader.framePages;
+  return (n>1 && p->bCompressionEnabled) ? n : 1;
+}
+
+static int cevfsFreeAppend(cevfs_file *p, Pgno lwrPgno, u32 ofst, u32 sz){
+  if( p->nFree==p->nFreeAlloc ){
+    u32 nNew = p->nFreeAlloc ? p->nFreeAlloc*2 : 64;
+    CevfsFreeRange *aNew = sqlite3_realloc64(p->aFree, (sqlite3_uint64)nNew*sizeof(CevfsFreeRange));
+    if( !aNew ) return SQLITE_NOMEM;
+    p->aFree = aNew;
+    p->nFreeAlloc = nNew;
+  }
+  p->aFree[p->nFree].lwrPgno = lwrPgno;
+  p->aFree[p->nFree].ofst = ofst;
+  p->aFree[p->nFree].sz = sz;
+  p->nFree++;
+  return SQLITE_OK;
+}
+
+static void cevfsFreeRemove(cevfs_file *p, u32 i){
+  p->aFree[i] = p->aFree[--p->nFree];
+}
+
+static void cevfsFreeMapClear(cevfs_file *p){
+  sqlite3_free(p->aFree);
+  p->aFree = NULL;
+  p->nFree = p->nFreeAlloc = 0;
+  p->bFreeMap = 0;
+}
+
+/*
+** Return a byte range of a lower page to the free map, merging it with
+** the free ranges on either side.
+** If the free map cannot grow the range is simply lost, as it was
+** before free space was tracked.
+*/
+static void cevfsFreeAdd(cevfs_file *p, Pgno lwrPgno, u32 ofst, u32 sz){
+  u32 iPrev = p->nFree, iNext = p->nFree;
+  if( lwrPgno==0 || sz==0 ) return;
+  p->stats.nAbandonedBytes += sz;
+  if( !p->bFreeMap ) return;
+  for(u32 i=0; i<p->nFree; i++){
+    CevfsFreeRange *pRange = &p->aFree[i];
+    if( pRange->lwrPgno!=lwrPgno ) continue;
+    if( pRange->ofst+pRange->sz==ofst ) iPrev = i;
+    else if( ofst+sz==pRange->ofst ) iNext = i;
+  }
+  if( iPrev<p->nFree && iNext<p->nFree ){
+    p->aFree[iPrev].sz += sz + p->aFree[iNext].sz;
+    cevfsFreeRemove(p, iNext);
+  }else if( iPrev<p->nFree ){
+    p->aFree[iPrev].sz += sz;
+  }else if( iNext<p->nFree ){
+    p->aFree[iNext].ofst = ofst;
+    p->aFree[iNext].sz += sz;
+  }else{
+    cevfsFreeAppend(p, lwrPgno, ofst, sz);
+  }
+}
+
+/*
+** Carve sz bytes out of the smallest free range that can hold them,
+** preferring lower pages on ties. Only pages below maxPgno are considered
+** unless maxPgno is 0. Returns 0 if there is no such range.
+*/
+static int cevfsFreeTake(cevfs_file *p, u32 sz, Pgno maxPgno, Pgno *pLwrPgno, u32 *pOfst){
+  u32 iBest = p->nFree;
+  for(u32 i=0; i<p->nFree; i++){
+    CevfsFreeRange *pRange = &p->aFree[i];
+    if( pRange->sz<sz || (maxPgno && pRange->lwrPgno>=maxPgno) ) continue;
+    if( iBest==p->nFree || pRange->sz<p->aFree[iBest].sz
+     || (pRange->sz==p->aFree[iBest].sz && pRange->lwrPgno<p->aFree[iBest].lwrPgno)
+    ){
+      iBest = i;
+      if( pRange->sz==sz && maxPgno==0 ) break;
+    }
+  }
+  if( iBest==p->nFree ) return 0;
+  *pLwrPgno = p->aFree[iBest].lwrPgno;
+  *pOfst = p->aFree[iBest].ofst;
+  p->aFree[iBest].ofst += sz;
+  p->aFree[iBest].sz -= sz;
+  if( p->aFree[iBest].sz==0 ) cevfsFreeRemove(p, iBest);
+  return 1;
+}
+
+/*
+** Location of a compressed page, used when sorting slots by position.
+*/
+typedef struct CevfsSlot CevfsSlot;
+struct CevfsSlot {
+  Pgno lwrPgno;                        // Lower pager page holding the slot
+  u32 ofst;                            // Offset within the page
+  u32 sz;                              // Compressed size
+  u32 ix;                              // Index of the page map entry
+};
+
+static int cevfsSlotCmp(const void *a, const void *b){
+  const CevfsSlot *x = (const CevfsSlot *)a, *y = (const CevfsSlot *)b;
+  if( x->lwrPgno!=y->lwrPgno ) return x->lwrPgno<y->lwrPgno ? -1 : 1;
+  return x->ofst<y->ofst ? -1 : x->ofst>y->ofst;
+}
+
+/*
+** Collect every live compressed page, sorted by lower pgno and offset.
+*/
+static int cevfsCollectSlots(cevfs_file *p, CevfsSlot **paSlot, u32 *pnSlot){
+  cevfs_header *header = &p->cevfsHeader;
+  u32 nEntry = header->mmTblCurrCnt ? (u32)(header->mmTblCurrCnt-1)*p->pgMapMaxCnt + header->pgMapCnt : 0;
+  CevfsSlot *aSlot = sqlite3_malloc64((sqlite3_uint64)(nEntry ? nEntry : 1)*sizeof(CevfsSlot));
+  u32 nSlot = 0;
+  if( !aSlot ) return SQLITE_NOMEM;
+  for(u32 i=0; i<nEntry; i++){
+    cevfs_map_entry *pEntry = &p->aPgMap[i];
+    if( pEntry->lwrPgno && pEntry->cmprSz ){
+      aSlot[nSlot].lwrPgno = pEntry->lwrPgno;
+      aSlot[nSlot].ofst = pEntry->cmprOfst;
+      aSlot[nSlot].sz = pEntry->cmprSz;
+      aSlot[nSlot].ix = i;
+      nSlot++;
+    }
+  }
+  qsort(aSlot, nSlot, sizeof(CevfsSlot), cevfsSlotCmp);
+  // The pages of a frame share one slot
+  if( nSlot>1 ){
+    u32 j = 0;
+    for(u32 i=1; i<nSlot; i++){
+      if( aSlot[i].lwrPgno!=aSlot[j].lwrPgno || aSlot[i].ofst!=aSlot[j].ofst ) aSlot[++j] = aSlot[i];
+    }
+    nSlot = j+1;
+  }
+  *paSlot = aSlot;
+  *pnSlot = nSlot;
+  return SQLITE_OK;
+}
+
+/*
+** Point map entry ix, and in frame mode every entry of its frame
+** sharing the same slot, at a new location.
+*/
+static void cevfsSlotMove(cevfs_file *p, u32 ix, Pgno lwrPgno, u32 ofst){
+  cevfs_header *header = &p->cevfsHeader;
+  u32 nEntry = (u32)(header->mmTblCurrCnt-1)*p->pgMapMaxCnt + header->pgMapCnt;
+  u32 nFramePages = cevfsFramePages(p);
+  u32 first = ix/nFramePages*nFramePages;
+  Pgno oldPgno = p->aPgMap[ix].lwrPgno;
+  CevfsCmpOfst oldOfst = p->aPgMap[ix].cmprOfst;
+  for(u32 i=first; i<first+nFramePages && i<nEntry; i++){
+    cevfs_map_entry *pEntry = &p->aPgMap[i];
+    if( pEntry->cmprSz && pEntry->lwrPgno==oldPgno && pEntry->cmprOfst==oldOfst ){
+      pEntry->lwrPgno = lwrPgno;
+      pEntry->cmprOfst = (CevfsCmpOfst)ofst;
+      cevfsSetPageMapDirty(p, i);
+    }
+  }
+}
+
+static int cevfsIsPageMapPage(cevfs_file *p, Pgno pgno){
+  for(u16 i=0; i<p->cevfsHeader.mmTblCurrCnt; i++){
+    if( p->mmTbl[i].lwrPgno==pgno ) return 1;
+  }
+  return 0;
+}
+
+static int cevfsPgnoCmp(const void *a, const void *b){
+  Pgno x = *(const Pgno *)a, y = *(const Pgno *)b;
+  return x<y ? -1 : x>y;
+}
+
+/*
+** Build the free map from the page maps: every gap between compressed
+** pages on a lower data page, up to the page being filled, is free.
+** Space past the fill point of the current page stays with the
+** sequential allocator.
+*/
+static int cevfsFreeMapBuild(cevfs_file *p){
+  cevfs_header *header = &p->cevfsHeader;
+  CevfsSlot *aSlot;
+  u32 nSlot, iSlot = 0;
+  int rc;
+
+  Pgno *aMapPgno;
+  u16 nMap = header->mmTblCurrCnt, iMap = 0;
+
+  p->nFree = 0;
+  if( (aMapPgno = sqlite3_malloc64((nMap+1)*sizeof(Pgno)))==NULL ) return SQLITE_NOMEM;
+  for(u16 i=0; i<nMap; i++) aMapPgno[i] = p->mmTbl[i].lwrPgno;
+  qsort(aMapPgno, nMap, sizeof(Pgno), cevfsPgnoCmp);
+  if( (rc = cevfsCollectSlots(p, &aSlot, &nSlot))!=SQLITE_OK ){
+    sqlite3_free(aMapPgno);
+    return rc;
+  }
+  for(Pgno pgno=CEVFS_FIRST_MAPPED_PAGE; pgno<=header->currPgno && rc==SQLITE_OK; pgno++){
+    u32 pos = 0;
+    u32 end = pgno==header->currPgno ? header->currPageOfst : p->pageSize;
+    while( iMap<nMap && aMapPgno[iMap]<pgno ) iMap++;
+    if( iMap<nMap && aMapPgno[iMap]==pgno ) continue;
+    while( iSlot<nSlot && aSlot[iSlot].lwrPgno<pgno ) iSlot++;
+    for(; iSlot<nSlot && aSlot[iSlot].lwrPgno==pgno && rc==SQLITE_OK; iSlot++){
+      if( aSlot[iSlot].ofst>pos ) rc = cevfsFreeAppend(p, pgno, pos, aSlot[iSlot].ofst-pos);
+      if( aSlot[iSlot].ofst+aSlot[iSlot].sz>pos ) pos = aSlot[iSlot].ofst+aSlot[iSlot].sz;
+    }
+    if( rc==SQLITE_OK && end>pos ) rc = cevfsFreeAppend(p, pgno, pos, end-pos);
+  }
+  sqlite3_free(aSlot);
+  sqlite3_free(aMapPgno);
+  if( rc==SQLITE_OK ) p->bFreeMap = 1;
+  else cevfsFreeMapClear(p);
+  return rc;
+}
+
 /*
 ** Allocate space to store a compressed page.
 **
@@ -752,12 +1314,22 @@ static int cevfsPageMapGet(
 void cevfsAllocCmpPageSpace(
   cevfs_file *pFile,
   CevfsCmpSize cmpSz,           // Current compressed size of data for allocation
-  u16 pgMapIx                   // Index of map entry to record allocation data
+  u32 pgMapIx                   // Index of map entry to record allocation data
 ){
   cevfs_header *header = &pFile->cevfsHeader;
   CevfsCmpOfst ofst = header->currPageOfst;
-  cevfs_map_entry *pMapEntry = &pFile->pPgMap[pgMapIx];
-  cevfs_map_entry *pBigEndianPgMapEntry = &pFile->pBigEndianPgMap[pgMapIx];
+  cevfs_map_entry *pMapEntry = &pFile->aPgMap[pgMapIx];
+  Pgno lwrPgno;
+  u32 freeOfst;
+
+  // Reuse freed space where possible, best fit first
+  if( cmpSz>0 && pFile->bFreeMap && cevfsFreeTake(pFile, cmpSz, 0, &lwrPgno, &freeOfst) ){
+    pMapEntry->lwrPgno = lwrPgno;
+    pMapEntry->cmprOfst = (CevfsCmpOfst)freeOfst;
+    pMapEntry->cmprSz = cmpSz;
+    cevfsSetPageMapDirty(pFile, pgMapIx);
+    return;
+  }
   // Since we no longer write compressed pages to page 1, we can optimize this
   //u32 realPageSize = pFile->pageSize - (header->currPgno == 1 ? CEVFS_DB_HEADER_SIZE : 0);
   header->currPageOfst += cmpSz;
@@ -772,14 +1344,11 @@ void cevfsAllocCmpPageSpace(
     else
       header->currPgno++;
   }
-  // Set data in map and in Big Endian version of map for fast save to persistent storage
+  // Set data in map; it is converted to big-endian when the map is saved
   pMapEntry->lwrPgno = header->currPgno;
   pMapEntry->cmprOfst = ofst;
   pMapEntry->cmprSz = cmpSz;
-  put4byte((u8 *)&pBigEndianPgMapEntry->lwrPgno, pMapEntry->lwrPgno);
-  put2byte((u8 *)&pBigEndianPgMapEntry->cmprSz, pMapEntry->cmprSz);
-  put2byte((u8 *)&pBigEndianPgMapEntry->cmprOfst, pMapEntry->cmprOfst);
-  pFile->bPgMapDirty = 1;
+  cevfsSetPageMapDirty(pFile, pgMapIx);
 }
 
 int cevfsAddPageEntry(
@@ -794,22 +1363,22 @@ int cevfsAddPageEntry(
 
   // if no more room, start a new pagemap
   if( header->pgMapCnt == pFile->pgMapMaxCnt ){
-    if( pFile->mmTblCurrIx == header->mmTblMaxCnt ){
+    int rc;
+    if( header->mmTblCurrCnt == header->mmTblMaxCnt ){
       // We've run out of room in the master map table.
       // User will need to increase pager size.
       return CEVFS_ERROR_PAGE_SIZE_TOO_SMALL;
     }
+    if( (rc = cevfsGrowPageMaps(pFile, header->mmTblCurrCnt+1))!=SQLITE_OK ) return rc;
     CevfsMMTblEntry *entry = &pFile->mmTbl[header->mmTblCurrCnt];
     entry->lwrPgno = header->currPgno+1; // use next pgno but don't incr. counter!
     header->mmTblCurrCnt++;
     header->pgMapCnt = 0;
-    // reminder: can't change pInfo->mmTblCurrIx until after cevfsSwitchPageMap
-    cevfsSwitchPageMap(pFile, uppOfst);
   }
 
   // add new page map entry
-  u16 ix = header->pgMapCnt++;
-  cevfs_map_entry *pPgMapEntry = &pFile->pPgMap[ix];
+  u32 ix = (u32)(header->mmTblCurrCnt-1)*pFile->pgMapMaxCnt + header->pgMapCnt++;
+  cevfs_map_entry *pPgMapEntry = &pFile->aPgMap[ix];
 
   // assign space to store compressed page
   cevfsAllocCmpPageSpace(pFile, cmpSz, ix);
@@ -819,7 +1388,7 @@ int cevfsAddPageEntry(
   if( !outCmpOfst ) pPgMapEntry->cmprOfst = 0;
 
   // output params
-  if( outLwrPgno ) *outLwrPgno = header->currPgno;
+  if( outLwrPgno ) *outLwrPgno = pPgMapEntry->lwrPgno;
   if( outCmpOfst ) *outCmpOfst = pPgMapEntry->cmprOfst;
 
   return SQLITE_OK;
@@ -846,49 +1415,1272 @@ static int cevfsPageMapSet(
   cevfs_header *header = &pFile->cevfsHeader;
   CevfsCmpSize oldCmpSz;
   int rc = SQLITE_OK;
-  u16 ix;
+  u32 ix;
 
   assert( outUppPgno );
   assert( outLwrPgno );
   assert( outCmpOfst );
 
+  if( !pFile->bFreeMap && (rc = cevfsFreeMapBuild(pFile))!=SQLITE_OK ) return rc;
+
   if( (rc = cevfsPageMapGet(pFile, uppOfst, outUppPgno, outLwrPgno, outCmpOfst, &oldCmpSz, &ix))==SQLITE_OK ){
     /*
     ** We found a map entry. It's either a placeholder entry that needs valid data,
     ** an outdated entry that needs updating, or a valid up-to-date entry.
     ** If the entry needs updating, we will reuse the space used to hold the previously compressed
-    ** data if the compressed data now takes up less space or allocate a new space at the end of
-    ** the db if it now needs more space.
-    ** Any previously used and now abandoned space will need to be recovered through a vacuum process.
+    ** data if the compressed data now takes up less space or allocate new space if it now needs
+    ** more. Space given up either way goes back to the free map for reuse.
     */
     if( oldCmpSz==0 || cmpSz>oldCmpSz ){
       // entry found was either a placeholder or we now need more room, so allocate new space.
-      cevfs_map_entry *pMapEntry = &pFile->pPgMap[ix];
+      cevfs_map_entry *pMapEntry = &pFile->aPgMap[ix];
+      if( oldCmpSz ){
+        cevfsFreeAdd(pFile, pMapEntry->lwrPgno, pMapEntry->cmprOfst, oldCmpSz);
+        pFile->stats.nSlotReallocs++;
+      }
       cevfsAllocCmpPageSpace(pFile, cmpSz, ix);
 
-      *outLwrPgno = pMapEntry->lwrPgno;
-      *outCmpOfst = pMapEntry->cmprOfst;
-      CEVFS_PRINTF(pInfo, "Updated entry (uppOfst=%lld, lwrPgno=%lu,cmpOfst=%lu,cmpSz=%lu)\n",
-                   (long long)uppOfst, (unsigned long)pMapEntry->lwrPgno, (unsigned long)pMapEntry->cmprOfst, (unsigned long)pMapEntry->cmprSz);
-      return SQLITE_OK;
-    }else if( cmpSz<oldCmpSz ){
-      // Update map entry data and keep compressed page slot. Abandoned space will need to be recovered via a vacuum operaion.
-      pFile->pPgMap[ix].cmprSz = cmpSz;
-      put2byte((u8 *)&pFile->pBigEndianPgMap[ix].cmprSz, cmpSz);
-      pFile->bPgMapDirty = 1;
+      *outLwrPgno = pMapEntry->lwrPgno;
+      *outCmpOfst = pMapEntry->cmprOfst;
+      CEVFS_PRINTF(pInfo, "Updated entry (uppOfst=%lld, lwrPgno=%lu,cmpOfst=%lu,cmpSz=%lu)\n",
+                   (long long)uppOfst, (unsigned long)pMapEntry->lwrPgno, (unsigned long)pMapEntry->cmprOfst, (unsigned long)pMapEntry->cmprSz);
+      return SQLITE_OK;
+    }else if( cmpSz<oldCmpSz ){
+      // Update map entry data and keep compressed page slot, freeing its tail.
+      cevfsFreeAdd(pFile, *outLwrPgno, *outCmpOfst+cmpSz, oldCmpSz-cmpSz);
+      pFile->aPgMap[ix].cmprSz = cmpSz;
+      cevfsSetPageMapDirty(pFile, ix);
+    }
+    return rc;
+  }else{
+    sqlite3_int64 nextOfst = ((sqlite3_int64)(header->mmTblCurrCnt-1) * pFile->pgMapMaxCnt + header->pgMapCnt) * header->uppPgSz;
+    while( uppOfst>nextOfst ){
+      if( (rc = cevfsAddPageEntry(pFile, nextOfst, 0, NULL, NULL))!=SQLITE_OK ) return rc;
+      CEVFS_PRINTF(pInfo, "Added intermin entry (uppOfst=%lld, lwrPgno=0,cmpOfst=0,cmpSz=0)\n", (long long)nextOfst);
+      nextOfst += header->uppPgSz;
+    }
+    assert( uppOfst==nextOfst );
+    rc = cevfsAddPageEntry(pFile, uppOfst, cmpSz, outCmpOfst, outLwrPgno);
+  }
+  return rc;
+}
+
+/*
+** Monotonic clock in nanoseconds for the codec timers.
+*/
+static u64 cevfsNow(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (u64)ts.tv_sec*1000000000 + (u64)ts.tv_nsec;
+}
+
+static void cevfsStatsAdd(CevfsStats *pTo, const CevfsStats *pFrom){
+  unsigned long long *aTo = (unsigned long long *)pTo;
+  const unsigned long long *aFrom = (const unsigned long long *)pFrom;
+  for(size_t i=0; i<sizeof(CevfsStats)/sizeof(unsigned long long); i++) aTo[i] += aFrom[i];
+}
+
+/*
+** Counters to update for file p. A WAL file counts towards its database.
+*/
+static CevfsStats *cevfsStatsOf(cevfs_file *p){
+  return p->pDbFile ? &p->pDbFile->stats : &p->stats;
+}
+
+/*
+** Get a codec scratch buffer of at least n bytes.
+** Buffers are recycled through a small pool to avoid a malloc/free pair
+** for every page read or written. Each file has its own pool and so
+** does each worker thread encoding staged pages.
+*/
+static u8 *cevfsScratchGet(CevfsScratch *pPool, size_t n){
+  if( n>pPool->nSz ){
+    // Pooled buffers are too small from now on.
+    while( pPool->n>0 ) sqlite3_free(pPool->ap[--pPool->n]);
+    pPool->nSz = n;
+  }
+  if( pPool->n>0 ) return pPool->ap[--pPool->n];
+  return sqlite3_malloc64(pPool->nSz);
+}
+
+static void cevfsScratchPut(CevfsScratch *pPool, void *pBuf){
+  if( pBuf==NULL ) return;
+  if( pPool->n<CEVFS_SCRATCH_POOL && sqlite3_msize(pBuf)>=pPool->nSz ){
+    pPool->ap[pPool->n++] = pBuf;
+  }else{
+    sqlite3_free(pBuf);
+  }
+}
+
+static void cevfsScratchFree(CevfsScratch *pPool){
+  while( pPool->n>0 ) sqlite3_free(pPool->ap[--pPool->n]);
+  pPool->nSz = 0;
+}
+
+static void cevfsCacheFree(cevfs_file *p){
+  sqlite3_free(p->aCache);
+  sqlite3_free(p->apCacheHash);
+  sqlite3_free(p->aCacheSpace);
+  p->aCache = NULL;
+  p->apCacheHash = NULL;
+  p->aCacheSpace = NULL;
+  p->pCacheMru = p->pCacheLru = NULL;
+  p->nCacheUsed = 0;
+  p->nCachePgSz = 0;
+}
+
+/*
+** Allocate the page cache for the current upper page size.
+** The cache is (re)built lazily since the upper page size is not final
+** until the first page is read or written.
+*/
+static int cevfsCacheInit(cevfs_file *p){
+  u32 uppPgSz = p->cevfsHeader.uppPgSz;
+  if( p->nCacheMax==0 ) return SQLITE_ERROR;
+  if( p->aCache && p->nCachePgSz==uppPgSz ) return SQLITE_OK;
+  cevfsCacheFree(p);
+
+  u32 nHash = 1;
+  while( nHash<p->nCacheMax*2 ) nHash <<= 1;
+  p->aCache = sqlite3_malloc64(p->nCacheMax*sizeof(CevfsCachedPage));
+  p->apCacheHash = sqlite3_malloc64(nHash*sizeof(CevfsCachedPage *));
+  p->aCacheSpace = sqlite3_malloc64((sqlite3_uint64)p->nCacheMax*uppPgSz);
+  if( !p->aCache || !p->apCacheHash || !p->aCacheSpace ){
+    cevfsCacheFree(p);
+    return SQLITE_NOMEM;
+  }
+  memset(p->aCache, 0, p->nCacheMax*sizeof(CevfsCachedPage));
+  memset(p->apCacheHash, 0, nHash*sizeof(CevfsCachedPage *));
+  p->nCacheHash = nHash;
+  p->nCachePgSz = uppPgSz;
+  return SQLITE_OK;
+}
+
+static void cevfsCacheUnlink(cevfs_file *p, CevfsCachedPage *pPg){
+  if( pPg->pLruPrev ) pPg->pLruPrev->pLruNext = pPg->pLruNext;
+  else p->pCacheMru = pPg->pLruNext;
+  if( pPg->pLruNext ) pPg->pLruNext->pLruPrev = pPg->pLruPrev;
+  else p->pCacheLru = pPg->pLruPrev;
+  pPg->pLruPrev = pPg->pLruNext = NULL;
+}
+
+static void cevfsCacheLinkMru(cevfs_file *p, CevfsCachedPage *pPg){
+  pPg->pLruPrev = NULL;
+  pPg->pLruNext = p->pCacheMru;
+  if( p->pCacheMru ) p->pCacheMru->pLruPrev = pPg;
+  p->pCacheMru = pPg;
+  if( !p->pCacheLru ) p->pCacheLru = pPg;
+}
+
+static void cevfsCacheUnhash(cevfs_file *p, CevfsCachedPage *pPg){
+  CevfsCachedPage **pp = &p->apCacheHash[pPg->uppPgno & (p->nCacheHash-1)];
+  while( *pp && *pp!=pPg ) pp = &(*pp)->pHashNext;
+  if( *pp ) *pp = pPg->pHashNext;
+  pPg->pHashNext = NULL;
+  pPg->uppPgno = 0;
+}
+
+/*
+** Return the cached image of upper page uppPgno, marking it most recently used,
+** or NULL if it is not cached.
+*/
+static CevfsCachedPage *cevfsCacheFind(cevfs_file *p, Pgno uppPgno){
+  CevfsCachedPage *pPg;
+  if( !p->aCache || p->nCachePgSz!=p->cevfsHeader.uppPgSz ) return NULL;
+  for(pPg=p->apCacheHash[uppPgno & (p->nCacheHash-1)]; pPg; pPg=pPg->pHashNext){
+    if( pPg->uppPgno==uppPgno ){
+      if( p->pCacheMru!=pPg ){
+        cevfsCacheUnlink(p, pPg);
+        cevfsCacheLinkMru(p, pPg);
+      }
+      return pPg;
+    }
+  }
+  return NULL;
+}
+
+/*
+** Claim a slot for upper page uppPgno, evicting the least recently used page
+** if the cache is full. The caller fills in aData.
+*/
+static CevfsCachedPage *cevfsCacheInsert(cevfs_file *p, Pgno uppPgno){
+  CevfsCachedPage *pPg;
+  if( cevfsCacheInit(p)!=SQLITE_OK ) return NULL;
+  if( p->nCacheUsed<p->nCacheMax ){
+    pPg = &p->aCache[p->nCacheUsed];
+    pPg->aData = p->aCacheSpace + (size_t)p->nCacheUsed*p->nCachePgSz;
+    p->nCacheUsed++;
+  }else{
+    pPg = p->pCacheLru;
+    cevfsCacheUnlink(p, pPg);
+    if( pPg->uppPgno ) cevfsCacheUnhash(p, pPg);
+  }
+  u32 h = uppPgno & (p->nCacheHash-1);
+  pPg->uppPgno = uppPgno;
+  pPg->pHashNext = p->apCacheHash[h];
+  p->apCacheHash[h] = pPg;
+  cevfsCacheLinkMru(p, pPg);
+  return pPg;
+}
+
+/*
+** Discard a cached page. Its slot becomes the first candidate for reuse.
+*/
+static void cevfsCacheDrop(cevfs_file *p, CevfsCachedPage *pPg){
+  cevfsCacheUnhash(p, pPg);
+  cevfsCacheUnlink(p, pPg);
+  pPg->pLruPrev = p->pCacheLru;
+  if( p->pCacheLru ) p->pCacheLru->pLruNext = pPg;
+  p->pCacheLru = pPg;
+  if( !p->pCacheMru ) p->pCacheMru = pPg;
+}
+
+/*
+** Discard all cached pages with pgno greater than or equal to uppPgno.
+*/
+static void cevfsCacheTruncate(cevfs_file *p, Pgno uppPgno){
+  for(u32 i=0; i<p->nCacheUsed; i++){
+    CevfsCachedPage *pPg = &p->aCache[i];
+    if( pPg->uppPgno>=uppPgno ) cevfsCacheDrop(p, pPg);
+  }
+}
+
+/*
+** Compress and encrypt nIn bytes of upper pager data.
+** On success *ppOut points to the encoded data and *pnOut holds its size.
+** If neither compression nor encryption is enabled, *ppOut is pIn itself,
+** otherwise it is a buffer from pPool to be returned with cevfsScratchPut().
+** Only reads p, so it may run on several threads at once given distinct
+** pools and stats.
+*/
+static int cevfsEncode(
+  cevfs_file *p,
+  CevfsScratch *pPool,
+  CevfsStats *pStats,
+  const void *pIn,
+  size_t nIn,
+  void **ppOut,
+  size_t *pnOut
+){
+  u8 *pCmpBuf = NULL;
+  void *pSrcData = (void *)pIn;
+  size_t nSrcAmt = nIn;
+  int rc = SQLITE_OK;
+
+  if( p->bCompressionEnabled ){
+    size_t nDest = p->vfsMethods.xCompressBound(p->pCmprCtx, nSrcAmt);
+    pCmpBuf = cevfsScratchGet(pPool, nDest+p->nEncIvSz);
+    if( pCmpBuf ){
+      u64 t = cevfsNow();
+      if( p->vfsMethods.xCompress(p->pCmprCtx, (char *)pCmpBuf, &nDest, pSrcData, nSrcAmt) ){
+        pSrcData = pCmpBuf;
+        nSrcAmt = nDest;
+      }else rc=CEVFS_ERROR_COMPRESSION_FAILED;
+      pStats->nCompress++;
+      pStats->nsCompress += cevfsNow()-t;
+    }else rc=SQLITE_NOMEM;
+  }
+
+  if( p->bEncryptionEnabled && rc==SQLITE_OK ){
+    void *pEncBuf = NULL;
+    size_t tmp_csz = 0;
+    u8 iv[64];
+    u8 *aIv = p->nEncIvSz<=sizeof(iv) ? iv : sqlite3_malloc((int)p->nEncIvSz);
+    if( aIv ){
+      u64 t = cevfsNow();
+      int bSuccess = p->vfsMethods.xEncrypt(
+        p->pEncCtx,
+        pSrcData,      // dataIn
+        nSrcAmt,       // data-in length
+        aIv,           // IV out
+        &pEncBuf,      // dataOut; result is written here.
+        &tmp_csz,      // On successful return, the number of bytes written to dataOut.
+        sqlite3_malloc
+      );
+      pStats->nEncrypt++;
+      pStats->nsEncrypt += cevfsNow()-t;
+      if( bSuccess && pEncBuf ){
+        // Join IV and pEncBuf. If IV is greater than pInfo->nEncIvSz, it will be truncated.
+        u8 *pIvEncBuf = cevfsScratchGet(pPool, p->nEncIvSz+tmp_csz);
+        if( pIvEncBuf ){
+          memcpy(pIvEncBuf, aIv, p->nEncIvSz);
+          memcpy(pIvEncBuf+p->nEncIvSz, pEncBuf, tmp_csz);
+          pSrcData = pIvEncBuf;
+          nSrcAmt = p->nEncIvSz+tmp_csz;
+        }else rc=SQLITE_NOMEM;
+      }else rc=CEVFS_ERROR_ENCRYPTION_FAILED;
+      if( pEncBuf ) sqlite3_free(pEncBuf);
+      if( aIv!=iv ) sqlite3_free(aIv);
+    }else rc=SQLITE_NOMEM;
+    cevfsScratchPut(pPool, pCmpBuf);
+    pCmpBuf = NULL;
+  }
+
+  if( rc==SQLITE_OK ){
+    *ppOut = pSrcData;
+    *pnOut = nSrcAmt;
+  }else{
+    cevfsScratchPut(pPool, pCmpBuf);
+  }
+  return rc;
+}
+
+/*
+** Decrypt and uncompress nIn bytes of stored data into the nOut byte
+** buffer pOut, which must be large enough to hold an entire upper page.
+** If pnDecoded is not NULL it receives the decoded size, which may be less
+** than nOut, otherwise the data must decode to exactly nOut bytes.
+** Like cevfsEncode() it may run on several threads given distinct pools
+** and stats.
+*/
+static int cevfsDecode(
+  cevfs_file *p,
+  CevfsScratch *pPool,
+  CevfsStats *pStats,
+  const void *pIn,
+  size_t nIn,
+  void *pOut,
+  size_t nOut,
+  size_t *pnDecoded
+){
+  u8 *pDecBuf = NULL;
+  const void *pSrcData = pIn;
+  size_t nSrcAmt = nIn;
+  int rc = SQLITE_OK;
+
+  if( p->bEncryptionEnabled ){
+    // The IV is stored first followed by the enctypted data
+    const u8 *iv = pIn;
+    pDecBuf = cevfsScratchGet(pPool, nIn);
+    if( pDecBuf ){
+      size_t nFinalSz;
+      u64 t = cevfsNow();
+      int bSuccess = p->vfsMethods.xDecrypt(
+        p->pEncCtx,
+        iv+p->nEncIvSz,           // dataIn
+        nIn-p->nEncIvSz,          // data-in length
+        iv,                       // IvIn
+        pDecBuf,                  // dataOut; result is written here.
+        nIn,                      // The size of the dataOut buffer in bytes
+        &nFinalSz                 // On successful return, the number of bytes written to dataOut.
+      );
+      pStats->nDecrypt++;
+      pStats->nsDecrypt += cevfsNow()-t;
+      if( bSuccess ){
+        pSrcData = pDecBuf;
+        nSrcAmt = nFinalSz;
+      }else rc=CEVFS_ERROR_DECRYPTION_FAILED;
+    }else rc=SQLITE_NOMEM;
+  }
+
+  if( rc==SQLITE_OK ){
+    if( p->bCompressionEnabled ){
+      size_t iDstAmt = nOut;
+      u64 t = cevfsNow();
+      int bSuccess = p->vfsMethods.xUncompress(p->pCmprCtx, pOut, &iDstAmt, (char *)pSrcData, nSrcAmt);
+      pStats->nDecompress++;
+      pStats->nsDecompress += cevfsNow()-t;
+      if( bSuccess ){
+        if( pnDecoded ) *pnDecoded = iDstAmt;
+        else assert( iDstAmt==nOut );
+      }else rc=CEVFS_ERROR_DECOMPRESSION_FAILED;
+    }else{
+      memcpy(pOut, pSrcData, nSrcAmt<nOut ? nSrcAmt : nOut);
+      if( pnDecoded ) *pnDecoded = nSrcAmt<nOut ? nSrcAmt : nOut;
+    }
+  }
+
+  cevfsScratchPut(pPool, pDecBuf);
+  return rc;
+}
+
+/*
+** Forget every indexed WAL frame. Called when a new WAL generation starts.
+*/
+static void cevfsWalReset(cevfs_file *p){
+  p->nWalFrame = 0;
+  p->iWalEnd = CEVFS_WAL_HDRSIZE;
+  p->iWalPending = 0;
+  p->nWalPending = 0;
+}
+
+/*
+** Release the buffers used to assemble and decode frames.
+** They are sized from the WAL page size, so must be dropped when it changes.
+*/
+static void cevfsWalFreeBuffers(cevfs_file *p){
+  if( p->aWalPending ){
+    sqlite3_free(p->aWalPending);
+    p->aWalPending = NULL;
+  }
+  if( p->aWalFrameBuf ){
+    sqlite3_free(p->aWalFrameBuf);
+    p->aWalFrameBuf = NULL;
+  }
+  p->iWalPending = 0;
+  p->nWalPending = 0;
+}
+
+/*
+** Read the WAL header from the real file and make sure the frame index
+** belongs to the generation it describes.
+** *pbExists is set to false if the log does not have a header yet.
+*/
+static int cevfsWalCheckHeader(cevfs_file *p, int *pbExists){
+  u8 aHdr[CEVFS_WAL_HDRSIZE];
+  int rc = p->pReal->pMethods->xRead(p->pReal, aHdr, CEVFS_WAL_HDRSIZE, 0);
+  if( rc==SQLITE_IOERR_SHORT_READ ){
+    *pbExists = 0;
+    cevfsWalReset(p);
+    memset(p->walSalt, 0, sizeof(p->walSalt));
+    return SQLITE_OK;
+  }
+  if( rc==SQLITE_OK ){
+    u32 pgSz = get4byte(aHdr+8);
+    *pbExists = 1;
+    if( pgSz!=p->walPgSz ){
+      cevfsWalFreeBuffers(p);
+      p->walPgSz = pgSz;
+    }
+    if( memcmp(p->walSalt, aHdr+16, sizeof(p->walSalt)) ){
+      memcpy(p->walSalt, aHdr+16, sizeof(p->walSalt));
+      cevfsWalReset(p);
+    }
+  }
+  return rc;
+}
+
+/*
+** Record that the latest copy of frame iFrame lives at real offset iOfst.
+*/
+static int cevfsWalSetFrame(cevfs_file *p, u32 iFrame, sqlite3_int64 iOfst, u32 nPayload){
+  if( iFrame>p->nWalFrameAlloc ){
+    u32 nNew = p->nWalFrameAlloc ? p->nWalFrameAlloc*2 : 64;
+    while( nNew<iFrame ) nNew *= 2;
+    CevfsWalFrame *aNew = sqlite3_realloc64(p->aWalFrame, nNew*sizeof(CevfsWalFrame));
+    if( !aNew ) return SQLITE_NOMEM;
+    p->aWalFrame = aNew;
+    p->nWalFrameAlloc = nNew;
+  }
+  p->aWalFrame[iFrame-1].iOfst = iOfst;
+  p->aWalFrame[iFrame-1].nPayload = nPayload;
+  if( iFrame>p->nWalFrame ) p->nWalFrame = iFrame;
+  return SQLITE_OK;
+}
+
+/*
+** Index the records appended to the real file since the last scan.
+** Scanning stops at the first record that is torn or belongs to
+** an older generation of the log.
+*/
+static int cevfsWalScan(cevfs_file *p){
+  sqlite3_int64 nSize;
+  int rc = p->pReal->pMethods->xFileSize(p->pReal, &nSize);
+  while( rc==SQLITE_OK && p->iWalEnd+CEVFS_WAL_RECORD_HDRSIZE<=nSize ){
+    u8 aRec[CEVFS_WAL_RECORD_HDRSIZE];
+    rc = p->pReal->pMethods->xRead(p->pReal, aRec, CEVFS_WAL_RECORD_HDRSIZE, p->iWalEnd);
+    if( rc!=SQLITE_OK ) break;
+    u32 iFrame = get4byte(aRec);
+    u32 nPayload = get4byte(aRec+4);
+    if( iFrame==0 || iFrame>p->nWalFrame+1
+     || nPayload==0 || nPayload>2*p->walPgSz+p->nEncIvSz+64
+     || memcmp(aRec+8+8, p->walSalt, sizeof(p->walSalt))
+     || p->iWalEnd+CEVFS_WAL_RECORD_HDRSIZE+nPayload>nSize
+    ){
+      break;
+    }
+    rc = cevfsWalSetFrame(p, iFrame, p->iWalEnd, nPayload);
+    p->iWalEnd += CEVFS_WAL_RECORD_HDRSIZE+nPayload;
+  }
+  if( rc==SQLITE_IOERR_SHORT_READ ) rc = SQLITE_OK;
+  return rc;
+}
+
+/*
+** Decode frame iFrame (header followed by page) into aFrame.
+** Returns SQLITE_IOERR_SHORT_READ if the frame is not in the log.
+*/
+static int cevfsWalLoadFrame(cevfs_file *p, u32 iFrame, u8 *aFrame){
+  u32 szFrame = p->walPgSz+CEVFS_WAL_FRAME_HDRSIZE;
+  int rc = SQLITE_OK;
+
+  if( iFrame==p->iWalPending ){
+    memcpy(aFrame, p->aWalPending, szFrame);
+    return SQLITE_OK;
+  }
+
+  for(int nTry=0; nTry<2; nTry++){
+    u8 aRec[CEVFS_WAL_RECORD_HDRSIZE];
+    if( nTry>0 ){
+      // Index is stale, most likely because another connection restarted the log.
+      int bExists;
+      cevfsWalReset(p);
+      if( (rc = cevfsWalCheckHeader(p, &bExists))!=SQLITE_OK ) return rc;
+    }
+    if( iFrame>p->nWalFrame && (rc = cevfsWalScan(p))!=SQLITE_OK ) return rc;
+    if( iFrame>p->nWalFrame ) return SQLITE_IOERR_SHORT_READ;
+
+    CevfsWalFrame *pFrame = &p->aWalFrame[iFrame-1];
+    rc = p->pReal->pMethods->xRead(p->pReal, aRec, CEVFS_WAL_RECORD_HDRSIZE, pFrame->iOfst);
+    if( rc!=SQLITE_OK && rc!=SQLITE_IOERR_SHORT_READ ) return rc;
+    if( rc==SQLITE_OK && get4byte(aRec)==iFrame && get4byte(aRec+4)==pFrame->nPayload
+     && memcmp(aRec+8+8, p->walSalt, sizeof(p->walSalt))==0
+    ){
+      u8 *pPayload = cevfsScratchGet(&p->scratch, pFrame->nPayload);
+      if( !pPayload ) return SQLITE_NOMEM;
+      rc = p->pReal->pMethods->xRead(
+        p->pReal, pPayload, (int)pFrame->nPayload, pFrame->iOfst+CEVFS_WAL_RECORD_HDRSIZE
+      );
+      if( rc==SQLITE_OK ){
+        memcpy(aFrame, aRec+8, CEVFS_WAL_FRAME_HDRSIZE);
+        rc = cevfsDecode(p, &p->scratch, cevfsStatsOf(p), pPayload, pFrame->nPayload, aFrame+CEVFS_WAL_FRAME_HDRSIZE, p->walPgSz, NULL);
+      }
+      cevfsScratchPut(&p->scratch, pPayload);
+      return rc;
+    }
+  }
+  return SQLITE_IOERR_SHORT_READ;
+}
+
+/*
+** Compress/encrypt the pending frame and append it to the real file.
+*/
+static int cevfsWalFlush(cevfs_file *p){
+  int rc;
+  void *pPayload;
+  size_t nPayload;
+  if( p->iWalPending==0 ) return SQLITE_OK;
+
+  rc = cevfsEncode(p, &p->scratch, cevfsStatsOf(p), p->aWalPending+CEVFS_WAL_FRAME_HDRSIZE, p->walPgSz, &pPayload, &nPayload);
+  if( rc==SQLITE_OK ){
+    u32 nRec = CEVFS_WAL_RECORD_HDRSIZE+(u32)nPayload;
+    u8 *aRec = sqlite3_malloc((int)nRec);
+    if( aRec ){
+      put4byte(aRec, p->iWalPending);
+      put4byte(aRec+4, (u32)nPayload);
+      memcpy(aRec+8, p->aWalPending, CEVFS_WAL_FRAME_HDRSIZE);
+      memcpy(aRec+CEVFS_WAL_RECORD_HDRSIZE, pPayload, nPayload);
+      rc = p->pReal->pMethods->xWrite(p->pReal, aRec, (int)nRec, p->iWalEnd);
+      if( rc==SQLITE_OK ) rc = cevfsWalSetFrame(p, p->iWalPending, p->iWalEnd, (u32)nPayload);
+      if( rc==SQLITE_OK ){
+        p->iWalEnd += nRec;
+        p->iWalPending = 0;
+        p->nWalPending = 0;
+      }
+      sqlite3_free(aRec);
+    }else rc = SQLITE_NOMEM;
+    if( pPayload!=p->aWalPending+CEVFS_WAL_FRAME_HDRSIZE ) cevfsScratchPut(&p->scratch, pPayload);
+  }
+  return rc;
+}
+
+/*
+** Read from the upper pager's view of the WAL file.
+** The 32-byte WAL header is stored as is; frames are decoded on demand.
+*/
+static int cevfsWalRead(cevfs_file *p, void *zBuf, int iAmt, sqlite_int64 iOfst){
+  u8 *zOut = zBuf;
+  int bExists;
+  int rc;
+
+  if( iOfst<CEVFS_WAL_HDRSIZE ){
+    return p->pReal->pMethods->xRead(p->pReal, zBuf, iAmt, iOfst);
+  }
+  if( (rc = cevfsWalCheckHeader(p, &bExists))!=SQLITE_OK ) return rc;
+  if( !bExists ){
+    memset(zBuf, 0, iAmt);
+    return SQLITE_IOERR_SHORT_READ;
+  }
+  if( !p->aWalFrameBuf ){
+    p->aWalFrameBuf = sqlite3_malloc((int)(p->walPgSz+CEVFS_WAL_FRAME_HDRSIZE));
+    if( !p->aWalFrameBuf ) return SQLITE_NOMEM;
+  }
+
+  u32 szFrame = p->walPgSz+CEVFS_WAL_FRAME_HDRSIZE;
+  while( iAmt>0 && rc==SQLITE_OK ){
+    u32 iFrame = (u32)((iOfst-CEVFS_WAL_HDRSIZE)/szFrame)+1;
+    u32 iFrameOfst = (u32)((iOfst-CEVFS_WAL_HDRSIZE)%szFrame);
+    int n = szFrame-iFrameOfst < (u32)iAmt ? (int)(szFrame-iFrameOfst) : iAmt;
+    if( (rc = cevfsWalLoadFrame(p, iFrame, p->aWalFrameBuf))==SQLITE_OK ){
+      memcpy(zOut, p->aWalFrameBuf+iFrameOfst, n);
+      zOut += n;
+      iOfst += n;
+      iAmt -= n;
+    }
+  }
+  if( rc==SQLITE_IOERR_SHORT_READ ) memset(zOut, 0, iAmt);
+  return rc;
+}
+
+/*
+** Write to the upper pager's view of the WAL file.
+** SQLite writes a frame header and the page as separate calls and may later
+** patch either half of a frame already in the log. Bytes are collected in
+** aWalPending until the frame is complete, then appended as a single record.
+*/
+static int cevfsWalWrite(cevfs_file *p, const void *zBuf, int iAmt, sqlite_int64 iOfst){
+  const u8 *zIn = zBuf;
+  int rc = SQLITE_OK;
+
+  if( iOfst<CEVFS_WAL_HDRSIZE ){
+    // A new header starts a new generation of the log.
+    if( (rc = cevfsWalFlush(p))!=SQLITE_OK ) return rc;
+    rc = p->pReal->pMethods->xWrite(p->pReal, zBuf, iAmt, iOfst);
+    if( rc==SQLITE_OK && iOfst==0 && iAmt>=CEVFS_WAL_HDRSIZE ){
+      u32 pgSz = get4byte(zIn+8);
+      if( pgSz!=p->walPgSz ){
+        cevfsWalFreeBuffers(p);
+        p->walPgSz = pgSz;
+      }
+      memcpy(p->walSalt, zIn+16, sizeof(p->walSalt));
+      cevfsWalReset(p);
+    }
+    return rc;
+  }
+
+  if( p->walPgSz==0 ){
+    int bExists;
+    if( (rc = cevfsWalCheckHeader(p, &bExists))!=SQLITE_OK ) return rc;
+    if( !bExists ) return SQLITE_IOERR_WRITE;
+  }
+
+  u32 szFrame = p->walPgSz+CEVFS_WAL_FRAME_HDRSIZE;
+  if( !p->aWalPending ){
+    p->aWalPending = sqlite3_malloc((int)szFrame);
+    if( !p->aWalPending ) return SQLITE_NOMEM;
+  }
+
+  while( iAmt>0 && rc==SQLITE_OK ){
+    u32 iFrame = (u32)((iOfst-CEVFS_WAL_HDRSIZE)/szFrame)+1;
+    u32 iFrameOfst = (u32)((iOfst-CEVFS_WAL_HDRSIZE)%szFrame);
+    u32 n = szFrame-iFrameOfst < (u32)iAmt ? szFrame-iFrameOfst : (u32)iAmt;
+
+    if( iFrame!=p->iWalPending ){
+      if( (rc = cevfsWalFlush(p))!=SQLITE_OK ) break;
+      if( iFrame>p->nWalFrame ){
+        // Another connection may have appended or restarted the log since we last looked.
+        int bExists;
+        if( (rc = cevfsWalCheckHeader(p, &bExists))!=SQLITE_OK ) break;
+        if( (rc = cevfsWalScan(p))!=SQLITE_OK ) break;
+      }
+      if( iFrame<=p->nWalFrame ){
+        // Patching a frame already in the log
+        if( (rc = cevfsWalLoadFrame(p, iFrame, p->aWalPending))!=SQLITE_OK ) break;
+        p->nWalPending = szFrame;
+      }else{
+        memset(p->aWalPending, 0, szFrame);
+        p->nWalPending = 0;
+      }
+      p->iWalPending = iFrame;
+    }
+
+    memcpy(p->aWalPending+iFrameOfst, zIn, n);
+    if( iFrameOfst<=p->nWalPending && iFrameOfst+n>p->nWalPending ){
+      p->nWalPending = iFrameOfst+n;
+    }
+    if( p->nWalPending==szFrame ) rc = cevfsWalFlush(p);
+
+    zIn += n;
+    iOfst += n;
+    iAmt -= n;
+  }
+  return rc;
+}
+
+/*
+** Truncate the WAL. SQLite only shrinks the log once it has been reset,
+** so truncating to a non-zero size just discards stale records.
+*/
+static int cevfsWalTruncate(cevfs_file *p, sqlite_int64 size){
+  int rc;
+  if( size<=CEVFS_WAL_HDRSIZE ){
+    cevfsWalReset(p);
+    memset(p->walSalt, 0, sizeof(p->walSalt));
+    return p->pReal->pMethods->xTruncate(p->pReal, size);
+  }
+  if( (rc = cevfsWalFlush(p))==SQLITE_OK && p->walPgSz ){
+    u32 nFrame = (u32)((size-CEVFS_WAL_HDRSIZE)/(p->walPgSz+CEVFS_WAL_FRAME_HDRSIZE));
+    if( nFrame<p->nWalFrame ){
+      p->nWalFrame = nFrame;
+      p->iWalEnd = CEVFS_WAL_HDRSIZE;
+      for(u32 i=0; i<nFrame; i++){
+        sqlite3_int64 iEnd = p->aWalFrame[i].iOfst+CEVFS_WAL_RECORD_HDRSIZE+p->aWalFrame[i].nPayload;
+        if( iEnd>p->iWalEnd ) p->iWalEnd = iEnd;
+      }
+    }
+    rc = p->pReal->pMethods->xTruncate(p->pReal, p->iWalEnd);
+  }
+  return rc;
+}
+
+/*
+** Report the size the upper pager expects: header plus fixed-size frames.
+*/
+static int cevfsWalFileSize(cevfs_file *p, sqlite_int64 *pSize){
+  int bExists;
+  int rc = cevfsWalCheckHeader(p, &bExists);
+  if( rc==SQLITE_OK && !bExists ){
+    return p->pReal->pMethods->xFileSize(p->pReal, pSize);
+  }
+  if( rc==SQLITE_OK ) rc = cevfsWalScan(p);
+  if( rc==SQLITE_OK ){
+    u32 nFrame = p->nWalFrame>p->iWalPending ? p->nWalFrame : p->iWalPending;
+    *pSize = CEVFS_WAL_HDRSIZE + (sqlite_int64)nFrame*(p->walPgSz+CEVFS_WAL_FRAME_HDRSIZE);
+  }
+  return rc;
+}
+
+/*
+** Store already encoded upper pager data in the lower pager.
+** iOfst and iAmt describe the upper pager write the data came from.
+*/
+static int cevfsWriteEncoded(
+  cevfs_file *p,
+  sqlite_int64 iOfst,
+  int iAmt,
+  const void *pSrcData,
+  size_t nSrcAmt
+){
+  cevfs_info *pInfo = p->pInfo;
+  int rc;
+
+  // Make sure dest/lwr page size is large enough for incoming page of data
+  assert( nSrcAmt <= p->pageSize );
+  if( nSrcAmt <= p->pageSize ){
+    DbPage *pPage;
+    Pgno uppPgno, mappedPgno;
+    CevfsCmpOfst cmprPgOfst;
+
+    rc = cevfsPageMapSet(p, iOfst, nSrcAmt, &uppPgno, &mappedPgno, &cmprPgOfst);
+
+    // write
+    if( rc==SQLITE_OK && (rc = sqlite3PagerGet(p->pPager, mappedPgno, &pPage, 0))==SQLITE_OK ){
+      CevfsMemPage *pMemPage = memPageFromDbPage(pPage, mappedPgno);
+      if( (rc = cevfsPagerWrite(p, pPage))==SQLITE_OK ){
+        CEVFS_PRINTF(
+          pInfo,
+          "%s.xWrite(%s, pgno=%u->%u, offset=%08lld->%06lu, amt=%06d->%06d)",
+          pInfo->zVfsName, p->zFName,
+          uppPgno, mappedPgno,
+          iOfst, (unsigned long)(pMemPage->dbHdrOffset+pMemPage->pgHdrOffset+cmprPgOfst),
+          iAmt, nSrcAmt
+        );
+        memcpy(
+          pMemPage->aData
+          +pMemPage->dbHdrOffset
+          +pMemPage->pgHdrOffset
+          +cmprPgOfst,
+          pSrcData,
+          nSrcAmt
+        );
+
+        // Keep track of sizes of upper and lower pagers
+        if( p->cevfsHeader.uppPageFile<uppPgno ) p->cevfsHeader.uppPageFile = uppPgno;
+        if( p->lwrPageFile<mappedPgno ) p->lwrPageFile = mappedPgno;
+        p->stats.nCmprBytesWritten += nSrcAmt;
+      }
+      sqlite3PagerUnref(pPage);
+    }
+  }else rc=CEVFS_ERROR_PAGE_SIZE_TOO_SMALL;
+  return rc;
+}
+
+static void cevfsStagedFree(cevfs_file *p){
+  if( p->aStaged ){
+    for(u32 i=0; i<p->nStagedAlloc; i++) sqlite3_free(p->aStaged[i].aData);
+    sqlite3_free(p->aStaged);
+    p->aStaged = NULL;
+  }
+  if( p->aStagedHash ){
+    sqlite3_free(p->aStagedHash);
+    p->aStagedHash = NULL;
+  }
+  p->nStaged = 0;
+  p->nStagedAlloc = 0;
+  p->nStagedPgSz = 0;
+}
+
+static void cevfsStagedRehash(cevfs_file *p){
+  memset(p->aStagedHash, 0, CEVFS_STAGED_HASH*sizeof(u32));
+  for(u32 i=0; i<p->nStaged; i++){
+    u32 h = p->aStaged[i].uppPgno % CEVFS_STAGED_HASH;
+    while( p->aStagedHash[h] ) h = (h+1) % CEVFS_STAGED_HASH;
+    p->aStagedHash[h] = i+1;
+  }
+}
+
+/*
+** Return the staged image of upper page uppPgno, or NULL if it isn't staged.
+*/
+static CevfsStagedPage *cevfsStagedFind(cevfs_file *p, Pgno uppPgno){
+  if( p->nStaged==0 ) return NULL;
+  for(u32 h=uppPgno % CEVFS_STAGED_HASH; p->aStagedHash[h]; h=(h+1) % CEVFS_STAGED_HASH){
+    CevfsStagedPage *pPg = &p->aStaged[p->aStagedHash[h]-1];
+    if( pPg->uppPgno==uppPgno ) return pPg;
+  }
+  return NULL;
+}
+
+/*
+** Claim a slot for upper page uppPgno, which must not be staged already.
+** The caller checks that fewer than CEVFS_MAX_STAGED pages are staged.
+*/
+static CevfsStagedPage *cevfsStagedInsert(cevfs_file *p, Pgno uppPgno){
+  u32 uppPgSz = p->cevfsHeader.uppPgSz;
+  CevfsStagedPage *pPg;
+  if( p->nStagedPgSz!=uppPgSz ){
+    assert( p->nStaged==0 );
+    cevfsStagedFree(p);
+  }
+  if( !p->aStaged ){
+    p->aStaged = sqlite3_malloc64(CEVFS_MAX_STAGED*sizeof(CevfsStagedPage));
+    p->aStagedHash = sqlite3_malloc64(CEVFS_STAGED_HASH*sizeof(u32));
+    if( !p->aStaged || !p->aStagedHash ){
+      cevfsStagedFree(p);
+      return NULL;
+    }
+    memset(p->aStaged, 0, CEVFS_MAX_STAGED*sizeof(CevfsStagedPage));
+    memset(p->aStagedHash, 0, CEVFS_STAGED_HASH*sizeof(u32));
+    p->nStagedPgSz = uppPgSz;
+  }
+  assert( p->nStaged<CEVFS_MAX_STAGED );
+  pPg = &p->aStaged[p->nStaged];
+  if( p->nStaged==p->nStagedAlloc ){
+    // Page buffers are kept from one commit to the next
+    if( (pPg->aData = sqlite3_malloc64(uppPgSz))==NULL ) return NULL;
+    p->nStagedAlloc++;
+  }
+  pPg->uppPgno = uppPgno;
+  pPg->nPage = 1;
+  pPg->pOut = NULL;
+  pPg->nOut = 0;
+  pPg->rc = SQLITE_OK;
+  p->nStaged++;
+
+  u32 h = uppPgno % CEVFS_STAGED_HASH;
+  while( p->aStagedHash[h] ) h = (h+1) % CEVFS_STAGED_HASH;
+  p->aStagedHash[h] = p->nStaged;
+  return pPg;
+}
+
+/*
+** Discard staged pages with pgno greater than or equal to uppPgno.
+*/
+static void cevfsStagedTruncate(cevfs_file *p, Pgno uppPgno){
+  u32 i = 0;
+  if( p->nStaged==0 ) return;
+  while( i<p->nStaged ){
+    if( p->aStaged[i].uppPgno>=uppPgno ){
+      // Swap with the last page, keeping its buffer for reuse
+      CevfsStagedPage tmp = p->aStaged[i];
+      p->aStaged[i] = p->aStaged[--p->nStaged];
+      p->aStaged[p->nStaged] = tmp;
+    }else i++;
+  }
+  cevfsStagedRehash(p);
+}
+
+static int cevfsStagedCmp(const void *a, const void *b){
+  Pgno x = ((const CevfsStagedPage *)a)->uppPgno;
+  Pgno y = ((const CevfsStagedPage *)b)->uppPgno;
+  return x<y ? -1 : x>y;
+}
+
+/*
+** A share of the staged pages or frames to be encoded by one thread.
+*/
+typedef struct CevfsEncodeTask CevfsEncodeTask;
+struct CevfsEncodeTask {
+  cevfs_file *p;                       // File the pages belong to
+  CevfsStagedPage *aPage;              // First page to encode
+  u32 nPage;                           // Number of pages to encode
+  CevfsStats stats;                    // Codec counters, added to the file's afterwards
+};
+
+static void *cevfsEncodeTask(void *pArg){
+  CevfsEncodeTask *pTask = (CevfsEncodeTask *)pArg;
+  cevfs_file *p = pTask->p;
+  CevfsScratch pool;
+  memset(&pool, 0, sizeof(pool));
+  for(u32 i=0; i<pTask->nPage; i++){
+    CevfsStagedPage *pPg = &pTask->aPage[i];
+    pPg->rc = cevfsEncode(p, &pool, &pTask->stats, pPg->aData, (size_t)pPg->nPage*p->nStagedPgSz, &pPg->pOut, &pPg->nOut);
+  }
+  cevfsScratchFree(&pool);
+  return NULL;
+}
+
+/*
+** Compress and encrypt nPage staged pages or frames, spreading them over
+** up to p->nThreads threads including the calling one.
+*/
+static void cevfsStagedEncode(cevfs_file *p, CevfsStagedPage *aPage, u32 nPage){
+  CevfsEncodeTask aTask[CEVFS_MAX_THREADS];
+  u32 nTask = nPage/CEVFS_MIN_PAGES_PER_THREAD;
+  u32 iPage = 0;
+  u32 i;
+
+  if( nTask>(u32)p->nThreads ) nTask = p->nThreads;
+  if( nTask<1 ) nTask = 1;
+  for(i=0; i<nTask; i++){
+    u32 nShare = (nPage-iPage)/(nTask-i);
+    aTask[i].p = p;
+    aTask[i].aPage = &aPage[iPage];
+    aTask[i].nPage = nShare;
+    memset(&aTask[i].stats, 0, sizeof(CevfsStats));
+    iPage += nShare;
+  }
+
+#if SQLITE_MAX_WORKER_THREADS>0
+  {
+    SQLiteThread *apThread[CEVFS_MAX_THREADS];
+    for(i=1; i<nTask; i++){
+      if( sqlite3ThreadCreate(&apThread[i], cevfsEncodeTask, &aTask[i])!=SQLITE_OK ){
+        apThread[i] = NULL;
+      }
+    }
+    cevfsEncodeTask(&aTask[0]);
+    for(i=1; i<nTask; i++){
+      void *pOut;
+      if( apThread[i] ) sqlite3ThreadJoin(apThread[i], &pOut);
+      else cevfsEncodeTask(&aTask[i]);
+    }
+  }
+#else
+  for(i=0; i<nTask; i++) cevfsEncodeTask(&aTask[i]);
+#endif
+  for(i=0; i<nTask; i++) cevfsStatsAdd(&p->stats, &aTask[i].stats);
+}
+
+/*
+** Release the slots of every page in the frame starting at map entry ix,
+** leaving placeholder entries. A slot shared by several pages is released once.
+*/
+static int cevfsFrameDetach(cevfs_file *p, u32 ix){
+  cevfs_header *header = &p->cevfsHeader;
+  u32 nEntry = header->mmTblCurrCnt ? (u32)(header->mmTblCurrCnt-1)*p->pgMapMaxCnt + header->pgMapCnt : 0;
+  u32 end = ix+cevfsFramePages(p);
+  int rc;
+
+  if( !p->bFreeMap && (rc = cevfsFreeMapBuild(p))!=SQLITE_OK ) return rc;
+  if( end>nEntry ) end = nEntry;
+  for(u32 i=ix; i<end; i++){
+    cevfs_map_entry *pEntry = &p->aPgMap[i];
+    u32 j = ix;
+    if( pEntry->cmprSz==0 ) continue;
+    while( j<i && (p->aPgMap[j].lwrPgno!=pEntry->lwrPgno || p->aPgMap[j].cmprOfst!=pEntry->cmprOfst) ) j++;
+    if( j==i ) cevfsFreeAdd(p, pEntry->lwrPgno, pEntry->cmprOfst, pEntry->cmprSz);
+  }
+  for(u32 i=ix; i<end; i++){
+    if( p->aPgMap[i].cmprSz || p->aPgMap[i].lwrPgno ){
+      memset(&p->aPgMap[i], 0, sizeof(cevfs_map_entry));
+      cevfsSetPageMapDirty(p, i);
+    }
+  }
+  return SQLITE_OK;
+}
+
+/*
+** Store an encoded frame holding nPage upper pages from firstPgno on.
+** All pages of the frame get map entries pointing at the same slot.
+*/
+static int cevfsWriteFrame(
+  cevfs_file *p,
+  Pgno firstPgno,
+  u32 nPage,
+  const void *pSrcData,
+  size_t nSrcAmt
+){
+  cevfs_header *header = &p->cevfsHeader;
+  u32 ix = firstPgno-1;
+  int rc;
+
+  if( nSrcAmt>p->pageSize || nSrcAmt>0xffff ) return CEVFS_ERROR_PAGE_SIZE_TOO_SMALL;
+
+  // Make sure every page of the frame has a map entry
+  u32 nEntry = header->mmTblCurrCnt ? (u32)(header->mmTblCurrCnt-1)*p->pgMapMaxCnt + header->pgMapCnt : 0;
+  while( nEntry<ix+nPage ){
+    if( (rc = cevfsAddPageEntry(p, (sqlite3_int64)nEntry*header->uppPgSz, 0, NULL, NULL))!=SQLITE_OK ) return rc;
+    nEntry++;
+  }
+  if( (rc = cevfsFrameDetach(p, ix))!=SQLITE_OK ) return rc;
+
+  cevfsAllocCmpPageSpace(p, (CevfsCmpSize)nSrcAmt, ix);
+  for(u32 i=1; i<nPage; i++){
+    p->aPgMap[ix+i] = p->aPgMap[ix];
+    cevfsSetPageMapDirty(p, ix+i);
+  }
+  CEVFS_PRINTF(p->pInfo, "%s.xWrite(%s, frame pgno=%u..%u->%u, offset=%06u, amt=%06lu)\n",
+               p->pInfo->zVfsName, p->zFName, firstPgno, firstPgno+nPage-1,
+               p->aPgMap[ix].lwrPgno, p->aPgMap[ix].cmprOfst, (unsigned long)nSrcAmt);
+  rc = cevfsWriteUncompressed(p, p->aPgMap[ix].lwrPgno, p->aPgMap[ix].cmprOfst, pSrcData, (int)nSrcAmt);
+  if( rc==SQLITE_OK ){
+    if( header->uppPageFile<firstPgno+nPage-1 ) header->uppPageFile = firstPgno+nPage-1;
+    if( p->lwrPageFile<p->aPgMap[ix].lwrPgno ) p->lwrPageFile = p->aPgMap[ix].lwrPgno;
+    p->stats.nCmprBytesWritten += nSrcAmt;
+  }
+  return rc;
+}
+
+/*
+** Store the pages of a frame one by one, for frames that do not
+** compress into a single lower page.
+*/
+static int cevfsWriteFramePages(cevfs_file *p, CevfsStagedPage *pFrame){
+  u32 uppPgSz = p->nStagedPgSz;
+  int rc = cevfsFrameDetach(p, pFrame->uppPgno-1);
+  for(u32 i=0; i<pFrame->nPage && rc==SQLITE_OK; i++){
+    u8 *aPage = pFrame->aData+(size_t)i*uppPgSz;
+    void *pSrcData = NULL;
+    size_t nSrcAmt = 0;
+    rc = cevfsEncode(p, &p->scratch, &p->stats, aPage, uppPgSz, &pSrcData, &nSrcAmt);
+    if( rc==SQLITE_OK ){
+      rc = cevfsWriteEncoded(p, (sqlite_int64)(pFrame->uppPgno+i-1)*uppPgSz, (int)uppPgSz, pSrcData, nSrcAmt);
+    }
+    if( pSrcData && pSrcData!=aPage ) cevfsScratchPut(&p->scratch, pSrcData);
+  }
+  return rc;
+}
+
+/*
+** Frame mode version of writing out the staged pages, which must be sorted.
+** Each frame holding a staged page is rebuilt from the staged pages and the
+** current images of its other pages, then encoded and stored as a whole.
+** Frames are processed in batches of at most CEVFS_MAX_STAGED pages.
+*/
+static int cevfsFrameFlush(cevfs_file *p){
+  u32 uppPgSz = p->nStagedPgSz;
+  u32 nFramePages = cevfsFramePages(p);
+  CevfsStagedPage *aFrame;
+  u32 iStaged = 0;
+  int rc = SQLITE_OK;
+
+  if( (aFrame = sqlite3_malloc64(p->nStaged*sizeof(CevfsStagedPage)))==NULL ) return SQLITE_NOMEM;
+  while( iStaged<p->nStaged && rc==SQLITE_OK ){
+    u32 nFrame = 0;
+    u32 nBatch = 0;
+
+    // Assemble the next batch of frames
+    while( iStaged<p->nStaged && nBatch+nFramePages<=CEVFS_MAX_STAGED && rc==SQLITE_OK ){
+      CevfsStagedPage *pFrame = &aFrame[nFrame++];
+      Pgno first = (p->aStaged[iStaged].uppPgno-1)/nFramePages*nFramePages+1;
+      Pgno last = first+nFramePages-1;
+      if( last>p->cevfsHeader.uppPageFile ) last = p->cevfsHeader.uppPageFile;
+      memset(pFrame, 0, sizeof(CevfsStagedPage));
+      pFrame->uppPgno = first;
+      pFrame->nPage = last-first+1;
+      if( (pFrame->aData = sqlite3_malloc64((size_t)pFrame->nPage*uppPgSz))==NULL ){
+        rc = SQLITE_NOMEM;
+        break;
+      }
+      for(Pgno pgno=first; pgno<=last && rc==SQLITE_OK; pgno++){
+        u8 *aPage = pFrame->aData+(size_t)(pgno-first)*uppPgSz;
+        if( iStaged<p->nStaged && p->aStaged[iStaged].uppPgno==pgno ){
+          memcpy(aPage, p->aStaged[iStaged++].aData, uppPgSz);
+        }else{
+          rc = cevfsRead((sqlite3_file *)p, aPage, (int)uppPgSz, (sqlite_int64)(pgno-1)*uppPgSz);
+        }
+      }
+      nBatch += pFrame->nPage;
+    }
+
+    if( rc==SQLITE_OK ) cevfsStagedEncode(p, aFrame, nFrame);
+    for(u32 i=0; i<nFrame; i++){
+      CevfsStagedPage *pFrame = &aFrame[i];
+      if( rc==SQLITE_OK ) rc = pFrame->rc;
+      if( rc==SQLITE_OK ){
+        if( pFrame->nOut<=p->pageSize && pFrame->nOut<=0xffff ){
+          rc = cevfsWriteFrame(p, pFrame->uppPgno, pFrame->nPage, pFrame->pOut, pFrame->nOut);
+        }else{
+          rc = cevfsWriteFramePages(p, pFrame);
+        }
+      }
+      if( pFrame->pOut && pFrame->pOut!=pFrame->aData ) cevfsScratchPut(&p->scratch, pFrame->pOut);
+      sqlite3_free(pFrame->aData);
+    }
+  }
+  sqlite3_free(aFrame);
+  return rc;
+}
+
+/*
+** Encode the staged pages and write them to the lower pager in upper pgno
+** order, so that pages written together end up next to each other.
+*/
+static int cevfsStagedFlush(cevfs_file *p){
+  u32 uppPgSz = p->nStagedPgSz;
+  int rc = SQLITE_OK;
+  if( p->nStaged==0 ) return SQLITE_OK;
+
+  qsort(p->aStaged, p->nStaged, sizeof(CevfsStagedPage), cevfsStagedCmp);
+  if( cevfsFramePages(p)>1 ){
+    rc = cevfsFrameFlush(p);
+    p->nStaged = 0;
+    memset(p->aStagedHash, 0, CEVFS_STAGED_HASH*sizeof(u32));
+    return rc;
+  }
+  cevfsStagedEncode(p, p->aStaged, p->nStaged);
+
+  for(u32 i=0; i<p->nStaged; i++){
+    CevfsStagedPage *pPg = &p->aStaged[i];
+    if( rc==SQLITE_OK ) rc = pPg->rc;
+    if( rc==SQLITE_OK ){
+      rc = cevfsWriteEncoded(p, (sqlite_int64)(pPg->uppPgno-1)*uppPgSz, (int)uppPgSz, pPg->pOut, pPg->nOut);
+    }
+    if( pPg->pOut && pPg->pOut!=pPg->aData ) cevfsScratchPut(&p->scratch, pPg->pOut);
+    pPg->pOut = NULL;
+  }
+  p->nStaged = 0;
+  memset(p->aStagedHash, 0, CEVFS_STAGED_HASH*sizeof(u32));
+  return rc;
+}
+
+/*
+** Persist the lower pager: staged pages, file size, cevfs header, master
+** map table and current page map, then commit the lower pager transaction.
+*/
+static int cevfsCommit(cevfs_file *p){
+  int rc;
+  u8 buf[4];
+  if( (rc = cevfsPagerLock(p))!=SQLITE_OK ) return rc;
+  if( (rc = cevfsStagedFlush(p))!=SQLITE_OK ) return rc;
+  // A transaction that changed nothing ends without taking an exclusive lock
+  if( p->bLwrDirty ){
+    sqlite3Put4byte(buf, p->lwrPageFile);
+    if( (rc = cevfsWriteUncompressed(p, 1, 28, buf, 4))!=SQLITE_OK
+     || (rc = cevfsSaveHeader(p))!=SQLITE_OK
+     || (rc = cevfsSaveMMTbl(p))!=SQLITE_OK
+    ){
+      return rc;
+    }
+  }
+  p->nBusy = 0;
+  for(int i=0; i<p->nTransactions && rc==SQLITE_OK; i++){
+    if( (rc = sqlite3PagerCommitPhaseOne(p->pPager, NULL, 0))==SQLITE_OK ){
+      rc = sqlite3PagerCommitPhaseTwo(p->pPager);
+    }
+  }
+  if( rc==SQLITE_OK ){
+    p->nTransactions = 0;
+    p->bLwrDirty = 0;
+    // Our own commit does not make the page maps stale
+    p->iLwrChangeCtr = get4byte(p->pPage1->aData+24);
+  }
+  return rc;
+}
+
+/*
+** Close the page the sequential allocator is filling: its unused tail goes
+** to the free map and the next sequential allocation starts a new page.
+** currPageOfst is only 16 bits, so with 64K pages the last byte stays behind.
+*/
+static void cevfsCloseFillPage(cevfs_file *p){
+  cevfs_header *header = &p->cevfsHeader;
+  u32 end = p->pageSize>0xffff ? 0xffff : p->pageSize;
+  if( header->currPgno>=CEVFS_FIRST_MAPPED_PAGE && header->currPageOfst<end ){
+    cevfsFreeAdd(p, header->currPgno, header->currPageOfst, end-header->currPageOfst);
+  }
+  header->currPageOfst = (CevfsCmpOfst)end;
+}
+
+/*
+** One bounded step of free space reclamation. Moves up to nMax compressed
+** pages from the end of the lower pager into the best fitting free ranges
+** on earlier pages, moves page maps out of the way, then truncates the
+** lower pager after the last page still in use.
+** *pnMoved is set to the number of compressed pages moved. Repeat until
+** it is 0 to compact the file as far as the free space allows.
+*/
+static int cevfsCompact(cevfs_file *p, int nMax, int *pnMoved){
+  cevfs_header *header = &p->cevfsHeader;
+  int bCommit = p->nTransactions==0 && p->nStaged==0;
+  int bChanged = 0;
+  CevfsSlot *aSlot = NULL;
+  u32 nSlot = 0;
+  u8 *aBuf = NULL;
+  int nMoved = 0;
+  int rc;
+
+  *pnMoved = 0;
+  if( !p->pPager ) return SQLITE_OK;
+  if( p->bReadOnly ) return SQLITE_READONLY;
+  if( (rc = cevfsPagerLock(p))!=SQLITE_OK ) return rc;
+  if( (rc = cevfsStagedFlush(p))!=SQLITE_OK
+   || (!p->bFreeMap && (rc = cevfsFreeMapBuild(p))!=SQLITE_OK)
+  ){
+    cevfsPagerUnlock(p);
+    return rc;
+  }
+  cevfsCloseFillPage(p);
+
+  // Move compressed pages down, starting from the end of the file
+  if( (rc = cevfsCollectSlots(p, &aSlot, &nSlot))==SQLITE_OK
+   && (aBuf = sqlite3_malloc(p->pageSize))==NULL
+  ){
+    rc = SQLITE_NOMEM;
+  }
+  for(u32 i=nSlot; i>0 && nMoved<nMax && rc==SQLITE_OK; i--){
+    CevfsSlot *pSlot = &aSlot[i-1];
+    Pgno lwrPgno;
+    u32 ofst;
+    if( !cevfsFreeTake(p, pSlot->sz, pSlot->lwrPgno, &lwrPgno, &ofst) ) break;
+    if( (rc = cevfsReadUncompressed(p, pSlot->lwrPgno, pSlot->ofst, aBuf, pSlot->sz))==SQLITE_OK
+     && (rc = cevfsWriteUncompressed(p, lwrPgno, ofst, aBuf, pSlot->sz))==SQLITE_OK
+    ){
+      cevfsSlotMove(p, pSlot->ix, lwrPgno, ofst);
+      cevfsFreeAdd(p, pSlot->lwrPgno, pSlot->ofst, pSlot->sz);
+      nMoved++;
+      bChanged = 1;
+    }
+  }
+  sqlite3_free(aBuf);
+  sqlite3_free(aSlot);
+
+  if( rc==SQLITE_OK ){
+    u32 nEntry = (u32)(header->mmTblCurrCnt-1)*p->pgMapMaxCnt + header->pgMapCnt;
+    Pgno nPage = 2;
+    int nPageFile = 0;
+
+    for(u32 i=0; i<nEntry; i++){
+      if( p->aPgMap[i].cmprSz && p->aPgMap[i].lwrPgno>nPage ) nPage = p->aPgMap[i].lwrPgno;
     }
-    return rc;
-  }else{
-    sqlite3_int64 nextOfst = ((header->mmTblCurrCnt-1) * header->uppPgSz * pFile->pgMapMaxCnt) + (header->pgMapCnt * header->uppPgSz);
-    while( uppOfst>nextOfst ){
-      cevfsAddPageEntry(pFile, nextOfst, 0, NULL, NULL);
-      CEVFS_PRINTF(pInfo, "Added intermin entry (uppOfst=%lld, lwrPgno=0,cmpOfst=0,cmpSz=0)\n", (long long)nextOfst);
-      nextOfst += header->uppPgSz;
+    // Page maps past the last data page move into whole free pages
+    for(u16 i=0; i<header->mmTblCurrCnt; i++){
+      Pgno mapPgno = p->mmTbl[i].lwrPgno;
+      Pgno lwrPgno;
+      u32 ofst;
+      if( mapPgno>nPage && cevfsFreeTake(p, p->pageSize, mapPgno, &lwrPgno, &ofst) ){
+        assert( ofst==0 );
+        p->mmTbl[i].lwrPgno = lwrPgno;
+        p->aPgMapDirty[i/8] |= (u8)(1<<(i&7));
+        cevfsFreeAdd(p, mapPgno, 0, p->pageSize);
+        bChanged = 1;
+      }
     }
-    assert( uppOfst==nextOfst );
-    cevfsAddPageEntry(pFile, uppOfst, cmpSz, outCmpOfst, outLwrPgno);
+    for(u16 i=0; i<header->mmTblCurrCnt; i++){
+      if( p->mmTbl[i].lwrPgno>nPage ) nPage = p->mmTbl[i].lwrPgno;
+    }
+
+    sqlite3PagerPagecount(p->pPager, &nPageFile);
+    if( nPage<(Pgno)nPageFile && (rc = cevfsPagerWrite(p, p->pPage1->pDbPage))==SQLITE_OK ){
+      sqlite3PagerTruncateImage(p->pPager, nPage);
+      p->lwrPageFile = nPage;
+      for(u32 i=0; i<p->nFree; ){
+        if( p->aFree[i].lwrPgno>nPage ) cevfsFreeRemove(p, i);
+        else i++;
+      }
+      bChanged = 1;
+    }
+    // Sequential allocation resumes after the last page in use
+    header->currPgno = nPage;
   }
-  return SQLITE_OK;
+
+  if( rc==SQLITE_OK && bChanged && bCommit && (rc = cevfsCommit(p))!=SQLITE_OK ){
+    cevfsPagerRollback(p);
+  }
+  if( rc==SQLITE_OK ) *pnMoved = nMoved;
+  cevfsPagerUnlock(p);
+  return rc;
 }
 
 /*
@@ -901,24 +2693,11 @@ static int cevfsClose(sqlite3_file *pFile){
   CEVFS_PRINTF(pInfo, "%s.xClose(%s)", pInfo->zVfsName, p->zFName);
 
   if( p->pPager ){
-    if( !p->bReadOnly ){
+    if( !p->bReadOnly && (p->nTransactions>0 || p->nStaged>0) ){
       int nPageFile = 0;   /* Number of pages in the database file */
       sqlite3PagerPagecount(p->pPager, &nPageFile);
       assert( p->lwrPageFile==nPageFile );
-
-      u8 buf[4];
-      sqlite3Put4byte(buf, p->lwrPageFile);
-      rc = cevfsWriteUncompressed(p, 1, 28, buf, 4);
-      rc = cevfsSaveHeader(p);
-
-      if( (rc = cevfsSaveMMTbl(p))==SQLITE_OK ){
-        for(int i=0; i<p->nTransactions; i++){
-          if( (rc = sqlite3PagerCommitPhaseOne(p->pPager, NULL, 0))==SQLITE_OK ){
-            sqlite3PagerCommitPhaseTwo(p->pPager);
-          }
-        }
-        p->nTransactions = 0;
-      }
+      rc = cevfsCommit(p);
     }
 
     if( rc==SQLITE_OK ){
@@ -933,9 +2712,13 @@ static int cevfsClose(sqlite3_file *pFile){
           sqlite3_free(p->mmTbl);
           p->mmTbl = NULL;
         }
-        if( p->pPgMap ){
-          sqlite3_free(p->pPgMap);
-          p->pPgMap = NULL;
+        if( p->aPgMap ){
+          sqlite3_free(p->aPgMap);
+          p->aPgMap = NULL;
+        }
+        if( p->aPgMapDirty ){
+          sqlite3_free(p->aPgMapDirty);
+          p->aPgMapDirty = NULL;
         }
         if( p->pBigEndianPgMap ){
           sqlite3_free(p->pBigEndianPgMap);
@@ -945,6 +2728,32 @@ static int cevfsClose(sqlite3_file *pFile){
     }
   }
 
+  if( p->bWal ){
+    rc = cevfsWalFlush(p);
+    cevfsWalFreeBuffers(p);
+    if( p->pDbFile && p->pDbFile->pWalFile==p ){
+      // The upper lock on the database goes back to the lower pager
+      p->pDbFile->pWalFile = NULL;
+      if( p->pDbFile->eUppLock>=SQLITE_LOCK_SHARED ){
+        cevfsPagerLockUpper(p->pDbFile, p->pDbFile->eUppLock);
+      }
+    }
+    if( p->aWalFrame ){
+      sqlite3_free(p->aWalFrame);
+      p->aWalFrame = NULL;
+    }
+  }
+
+  cevfsReadAheadEnd(p, 0);
+  cevfsStagedFree(p);
+  cevfsFreeMapClear(p);
+  cevfsCacheFree(p);
+  cevfsScratchFree(&p->scratch);
+  if( p->pCipher ){
+    cevfsCodecFree(p->pCipher);
+    p->pCipher = NULL;
+  }
+
   if( (rc == SQLITE_OK) && ((rc = p->pReal->pMethods->xClose(p->pReal)) == SQLITE_OK) ){
     sqlite3_free((void*)p->base.pMethods);
     p->base.pMethods = NULL;
@@ -954,6 +2763,206 @@ static int cevfsClose(sqlite3_file *pFile){
   return rc;
 }
 
+static void cevfsReadAheadFree(CevfsReadAhead *pAhead){
+  sqlite3_free(pAhead->aPgno);
+  sqlite3_free(pAhead->aSlotOfst);
+  sqlite3_free(pAhead->aSlotSz);
+  sqlite3_free(pAhead->aRc);
+  sqlite3_free(pAhead->aSlot);
+  sqlite3_free(pAhead->aOut);
+  sqlite3_free(pAhead);
+}
+
+static void *cevfsReadAheadTask(void *pArg){
+  CevfsReadAhead *pAhead = (CevfsReadAhead *)pArg;
+  CevfsScratch pool;
+  memset(&pool, 0, sizeof(pool));
+  for(u32 i=0; i<pAhead->nPage; i++){
+    pAhead->aRc[i] = cevfsDecode(pAhead->p, &pool, &pAhead->stats, pAhead->aSlot+pAhead->aSlotOfst[i], pAhead->aSlotSz[i],
+                                 pAhead->aOut+(size_t)i*pAhead->nPgSz, pAhead->nPgSz, NULL);
+  }
+  cevfsScratchFree(&pool);
+  return NULL;
+}
+
+/*
+** Finish the pending read-ahead batch. If bKeep is true its pages go into
+** the page cache, otherwise they are thrown away, as they must be once
+** anything is written since the slots were copied.
+*/
+static void cevfsReadAheadEnd(cevfs_file *p, int bKeep){
+  CevfsReadAhead *pAhead = p->pAhead;
+  if( !pAhead ) return;
+  p->pAhead = NULL;
+#if SQLITE_MAX_WORKER_THREADS>0
+  if( pAhead->pThread ){
+    void *pOut;
+    sqlite3ThreadJoin(pAhead->pThread, &pOut);
+  }else
+#endif
+  if( bKeep ){
+    cevfsReadAheadTask(pAhead);
+  }
+  cevfsStatsAdd(&p->stats, &pAhead->stats);
+  for(u32 i=0; bKeep && i<pAhead->nPage && pAhead->nPgSz==p->cevfsHeader.uppPgSz; i++){
+    Pgno pgno = pAhead->aPgno[i];
+    CevfsCachedPage *pCached;
+    if( pAhead->aRc[i]!=SQLITE_OK || cevfsStagedFind(p, pgno) || cevfsCacheFind(p, pgno) ) continue;
+    if( (pCached = cevfsCacheInsert(p, pgno))!=NULL ){
+      memcpy(pCached->aData, pAhead->aOut+(size_t)i*pAhead->nPgSz, pAhead->nPgSz);
+    }
+  }
+  cevfsReadAheadFree(pAhead);
+}
+
+/*
+** Copy the encoded slots of up to p->nReadAhead upper pages from first on,
+** skipping pages already cached, and start decoding them in the background.
+** Read-ahead is only an optimization, so any failure just drops the batch.
+*/
+static void cevfsReadAheadStart(cevfs_file *p, Pgno first){
+  cevfs_header *header = &p->cevfsHeader;
+  u32 uppPgSz = header->uppPgSz;
+  CevfsReadAhead *pAhead;
+  Pgno last = first+p->nReadAhead-1;
+  size_t nSlot = 0;
+  int rc = SQLITE_OK;
+
+  // The caller unlocks the lower pager once the page being read is done
+  if( cevfsPagerLock(p)!=SQLITE_OK ) return;
+  if( last>header->uppPageFile ) last = header->uppPageFile;
+  p->iAheadEnd = last;
+  if( first>last ) return;
+  if( (pAhead = sqlite3_malloc64(sizeof(CevfsReadAhead)))==NULL ) return;
+  memset(pAhead, 0, sizeof(CevfsReadAhead));
+  pAhead->p = p;
+  pAhead->nPgSz = uppPgSz;
+  pAhead->aPgno = sqlite3_malloc64(p->nReadAhead*sizeof(Pgno));
+  pAhead->aSlotOfst = sqlite3_malloc64(p->nReadAhead*sizeof(u32));
+  pAhead->aSlotSz = sqlite3_malloc64(p->nReadAhead*sizeof(u32));
+  pAhead->aRc = sqlite3_malloc64(p->nReadAhead*sizeof(int));
+  if( !pAhead->aPgno || !pAhead->aSlotOfst || !pAhead->aSlotSz || !pAhead->aRc ){
+    cevfsReadAheadFree(pAhead);
+    return;
+  }
+
+  // Pick the pages worth decoding
+  for(Pgno pgno=first; pgno<=last; pgno++){
+    CevfsCmpSize cmprSz = 0;
+    if( cevfsStagedFind(p, pgno) || cevfsCacheFind(p, pgno) ) continue;
+    if( cevfsPageMapGet(p, (sqlite_uint64)(pgno-1)*uppPgSz, NULL, NULL, NULL, &cmprSz, NULL)!=SQLITE_OK
+     || cmprSz==0
+    ){
+      continue;
+    }
+    pAhead->aPgno[pAhead->nPage] = pgno;
+    pAhead->aSlotOfst[pAhead->nPage] = (u32)nSlot;
+    pAhead->aSlotSz[pAhead->nPage] = cmprSz;
+    pAhead->nPage++;
+    nSlot += cmprSz;
+  }
+  if( pAhead->nPage==0
+   || (pAhead->aSlot = sqlite3_malloc64(nSlot))==NULL
+   || (pAhead->aOut = sqlite3_malloc64((size_t)pAhead->nPage*uppPgSz))==NULL
+  ){
+    cevfsReadAheadFree(pAhead);
+    return;
+  }
+
+  // Copy the slots while on this thread; the lower pager is not thread safe
+  for(u32 i=0; i<pAhead->nPage && rc==SQLITE_OK; i++){
+    Pgno lwrPgno;
+    CevfsCmpOfst cmprOfst;
+    DbPage *pPage;
+    cevfsPageMapGet(p, (sqlite_uint64)(pAhead->aPgno[i]-1)*uppPgSz, NULL, &lwrPgno, &cmprOfst, NULL, NULL);
+    if( (rc = sqlite3PagerGet(p->pPager, lwrPgno, &pPage, 0))==SQLITE_OK ){
+      CevfsMemPage *pMemPage = memPageFromDbPage(pPage, lwrPgno);
+      memcpy(pAhead->aSlot+pAhead->aSlotOfst[i],
+             pMemPage->aData+pMemPage->dbHdrOffset+pMemPage->pgHdrOffset+cmprOfst,
+             pAhead->aSlotSz[i]);
+      p->stats.nCmprBytesRead += pAhead->aSlotSz[i];
+      sqlite3PagerUnref(pPage);
+    }
+  }
+  if( rc!=SQLITE_OK ){
+    cevfsReadAheadFree(pAhead);
+    return;
+  }
+
+#if SQLITE_MAX_WORKER_THREADS>0
+  if( sqlite3ThreadCreate(&pAhead->pThread, cevfsReadAheadTask, pAhead)!=SQLITE_OK ){
+    pAhead->pThread = NULL;
+  }
+#endif
+  p->pAhead = pAhead;
+}
+
+/*
+** Track sequential access to upper pages. Once a scan is detected the
+** pages ahead of it are decoded in batches, the next batch starting when
+** the scan is halfway through the last one.
+*/
+static void cevfsReadAhead(cevfs_file *p, Pgno uppPgno){
+  CevfsReadAhead *pAhead = p->pAhead;
+  if( uppPgno==p->iSeqNext ){
+    p->nSeqRun++;
+  }else{
+    p->nSeqRun = 0;
+    p->iAheadEnd = 0;
+  }
+  p->iSeqNext = uppPgno+1;
+  if( pAhead && uppPgno>=pAhead->aPgno[0] && uppPgno<=pAhead->aPgno[pAhead->nPage-1] ){
+    cevfsReadAheadEnd(p, 1);
+  }
+  if( p->nSeqRun>=CEVFS_READ_AHEAD_TRIGGER && uppPgno+p->nReadAhead/2>=p->iAheadEnd ){
+    cevfsReadAheadEnd(p, 1);
+    cevfsReadAheadStart(p, p->iAheadEnd>uppPgno ? p->iAheadEnd+1 : uppPgno+1);
+  }
+}
+
+/*
+** Decode the frame holding upper page uppPgno and copy iAmt bytes of that
+** page, starting at iPgOfst, to zBuf. The other pages of the frame go into
+** the page cache so reading them does not inflate the frame again.
+** A frame that decodes to a single page holds just uppPgno.
+*/
+static int cevfsReadFrame(
+  cevfs_file *p,
+  Pgno uppPgno,
+  const u8 *pSrcData,
+  u32 nSrcAmt,
+  void *zBuf,
+  u32 iPgOfst,
+  int iAmt
+){
+  u32 uppPgSz = p->cevfsHeader.uppPgSz;
+  size_t nFrameSz = (size_t)cevfsFramePages(p)*uppPgSz;
+  size_t nDecoded = 0;
+  u8 *aFrame = cevfsScratchGet(&p->scratch, nFrameSz);
+  int rc;
+
+  if( !aFrame ) return SQLITE_NOMEM;
+  if( (rc = cevfsDecode(p, &p->scratch, &p->stats, pSrcData, nSrcAmt, aFrame, nFrameSz, &nDecoded))==SQLITE_OK ){
+    u32 nPage = (u32)(nDecoded/uppPgSz);
+    Pgno first = nPage>1 ? (uppPgno-1)/cevfsFramePages(p)*cevfsFramePages(p)+1 : uppPgno;
+    if( nPage==0 || uppPgno-first>=nPage ){
+      rc = SQLITE_CORRUPT;
+    }else{
+      memcpy(zBuf, aFrame+(size_t)(uppPgno-first)*uppPgSz+iPgOfst, iAmt);
+      for(u32 i=0; i<nPage; i++){
+        CevfsCachedPage *pCached;
+        // Staged and cached images are never older than the frame
+        if( cevfsStagedFind(p, first+i) || cevfsCacheFind(p, first+i) ) continue;
+        if( (pCached = cevfsCacheInsert(p, first+i))!=NULL ){
+          memcpy(pCached->aData, aFrame+(size_t)i*uppPgSz, uppPgSz);
+        }
+      }
+    }
+  }
+  cevfsScratchPut(&p->scratch, aFrame);
+  return rc;
+}
+
 /*
 ** Read data from a cevfs-file.
 */
@@ -968,84 +2977,75 @@ static int cevfsRead(
   u32 uppPgSz = p->cevfsHeader.uppPgSz;
   int rc;
 
-  if( p->pPager && p->pPage1 ){
+  if( p->pPager ){
+    // Only let go of the lower pager if this read locked it
+    int bHeld = p->pPage1!=NULL;
     DbPage *pPage;
     Pgno uppPgno, mappedPgno;
     CevfsCmpOfst cmprPgOfst;
     CevfsCmpSize uCmpPgSz;
+    CevfsStagedPage *pStaged;
+    CevfsCachedPage *pCached;
+
+    p->stats.nUppBytesRead += iAmt;
+    // Frames already bring their neighbours into the cache
+    if( p->nReadAhead && cevfsFramePages(p)==1 && (p->bCompressionEnabled || p->bEncryptionEnabled) ){
+      cevfsReadAhead(p, (Pgno)(iOfst/uppPgSz+1));
+    }
+    pStaged = cevfsStagedFind(p, (Pgno)(iOfst/uppPgSz+1));
+    pCached = pStaged ? NULL : cevfsCacheFind(p, (Pgno)(iOfst/uppPgSz+1));
 
-    if( (rc = cevfsPageMapGet(p, iOfst, &uppPgno, &mappedPgno, &cmprPgOfst, &uCmpPgSz, NULL)) == SQLITE_OK ){
+    if( pStaged ){
+      CEVFS_PRINTF(pInfo, "%s.xRead(%s,ofst=%08lld,amt=%d) STAGED", pInfo->zVfsName, p->zFName, iOfst, iAmt);
+      memcpy(zBuf, pStaged->aData+iOfst%uppPgSz, iAmt);
+      rc = SQLITE_OK;
+    }else if( pCached ){
+      CEVFS_PRINTF(pInfo, "%s.xRead(%s,ofst=%08lld,amt=%d) CACHED", pInfo->zVfsName, p->zFName, iOfst, iAmt);
+      p->stats.nCacheHits++;
+      memcpy(zBuf, pCached->aData+iOfst%uppPgSz, iAmt);
+      rc = SQLITE_OK;
+    }else if( (rc = cevfsPagerLock(p))!=SQLITE_OK ){
+      CEVFS_PRINTF(pInfo, "%s.xRead(%s,ofst=%08lld,amt=%d) LOCK", pInfo->zVfsName, p->zFName, iOfst, iAmt);
+    }else if( (rc = cevfsPageMapGet(p, iOfst, &uppPgno, &mappedPgno, &cmprPgOfst, &uCmpPgSz, NULL)) == SQLITE_OK
+           && uCmpPgSz>0 ){ // placeholder entries have no data yet
       if( rc==SQLITE_OK &&
          (rc = sqlite3PagerGet(p->pPager, mappedPgno, &pPage, 0))==SQLITE_OK
       ){
-        void *pDecBuf = NULL;
-        void *pUncBuf = NULL;
-        void *pDstData = NULL;
-
         CevfsMemPage *pMemPage = memPageFromDbPage(pPage, mappedPgno);
         CEVFS_PRINTF(
           pInfo, "%s.xRead(%s,pgno=%u->%u,ofst=%08lld->%u,amt=%d->%u)",
           pInfo->zVfsName, p->zFName, uppPgno, mappedPgno, iOfst, cmprPgOfst, iAmt, uCmpPgSz
         );
         assert( uCmpPgSz > 0 );
+        p->stats.nCmprBytesRead += uCmpPgSz;
+        if( p->nCacheMax ) p->stats.nCacheMisses++;
 
-        size_t iDstAmt = uppPgSz;
-        int bSuccess = 1;
-
-        void *pSrcData =
-          (char *)pMemPage->aData
+        u8 *pSrcData =
+          pMemPage->aData
           +pMemPage->dbHdrOffset
           +pMemPage->pgHdrOffset
           +cmprPgOfst;
-
-        // src = dst, assuming no encryption or compression
-        pDstData = pSrcData;
-
-        if( p->bEncryptionEnabled ){
-          // The IV is stored first followed by the enctypted data
-          void *iv = pSrcData;
-
-          pDecBuf = sqlite3_malloc(uCmpPgSz);
-          if( pDecBuf ){
-            void *srcData = iv+p->nEncIvSz;
-            size_t nDataInSize = uCmpPgSz-p->nEncIvSz;
-            size_t nFinalSz;
-
-            bSuccess = p->vfsMethods.xDecrypt(
-              pInfo->pCtx,
-              srcData,                  // dataIn
-              nDataInSize,              // data-in length
-              iv,                       // IvIn
-              pDecBuf,                  // dataOut; result is written here.
-              uCmpPgSz,                 // The size of the dataOut buffer in bytes
-              &nFinalSz                 // On successful return, the number of bytes written to dataOut.
-            );
-
-            if( bSuccess ){
-              uCmpPgSz = nFinalSz;
-              pSrcData = pDstData = pDecBuf;
-            }else rc=CEVFS_ERROR_DECRYPTION_FAILED;
-          }else rc=SQLITE_NOMEM;
-        } // encryption
-
-        if( p->bCompressionEnabled && bSuccess && bSuccess && rc==SQLITE_OK ){
-          pUncBuf = sqlite3_malloc((int)iDstAmt);
-          if( pUncBuf ){
-            bSuccess = p->vfsMethods.xUncompress(pInfo->pCtx, pUncBuf, &iDstAmt, pSrcData, (int)uCmpPgSz);
-            if( bSuccess ){
-              assert( iDstAmt==uppPgSz );
-              pDstData = pUncBuf;
-            }else rc=CEVFS_ERROR_DECOMPRESSION_FAILED;
+        u16 uBufOfst = iOfst % uppPgSz;
+
+        if( cevfsFramePages(p)>1 ){
+          rc = cevfsReadFrame(p, uppPgno, pSrcData, uCmpPgSz, zBuf, uBufOfst, iAmt);
+        }else if( p->bEncryptionEnabled || p->bCompressionEnabled ){
+          // Decode straight into the page cache if enabled, else into a scratch buffer
+          pCached = cevfsCacheInsert(p, uppPgno);
+          u8 *pPgBuf = pCached ? pCached->aData : cevfsScratchGet(&p->scratch, uppPgSz);
+          if( pPgBuf ){
+            if( (rc = cevfsDecode(p, &p->scratch, &p->stats, pSrcData, uCmpPgSz, pPgBuf, uppPgSz, NULL))==SQLITE_OK ){
+              memcpy(zBuf, pPgBuf+uBufOfst, iAmt);
+            }else if( pCached ){
+              cevfsCacheDrop(p, pCached);
+            }
+            if( !pCached ) cevfsScratchPut(&p->scratch, pPgBuf);
           }else rc=SQLITE_NOMEM;
+        }else{
+          // src = dst as there is no encryption or compression
+          memcpy(zBuf, pSrcData+uBufOfst, iAmt);
         }
 
-        if( bSuccess && rc==SQLITE_OK ){
-          u16 uBufOfst = iOfst % uppPgSz;
-          memcpy(zBuf, pDstData+uBufOfst, iAmt);
-        }
-
-        if( pDecBuf ) sqlite3_free( pDecBuf );
-        if( pUncBuf ) sqlite3_free( pUncBuf );
         sqlite3PagerUnref(pPage);
       }
     }else{
@@ -1053,6 +3053,10 @@ static int cevfsRead(
       memset(zBuf, 0, iAmt);
       rc = SQLITE_OK;
     }
+    if( !bHeld ) cevfsPagerUnlock(p);
+  }else if( p->bWal ){
+    CEVFS_PRINTF(pInfo, "%s.xRead(%s,ofst=%08lld,amt=%d) WAL", pInfo->zVfsName, p->zFName, iOfst, iAmt);
+    rc = cevfsWalRead(p, zBuf, iAmt, iOfst);
   }else{
     CEVFS_PRINTF(pInfo, "%s.xRead(%s,ofst=%08lld,amt=%d)", pInfo->zVfsName, p->zFName, iOfst, iAmt);
     rc = p->pReal->pMethods->xRead(p->pReal, zBuf, iAmt, iOfst);
@@ -1076,94 +3080,57 @@ static int cevfsWrite(
 
   if( p->pPager ){
     if( p->bReadOnly ) rc = SQLITE_READONLY;
-    else{
-      void *pCmpBuf = NULL;
-      void *pEncBuf = NULL;
-      void *pSrcData = (void *)zBuf;
-      size_t nSrcAmt = iAmt;
-      int bSuccess = 1;
-
-      if( p->bCompressionEnabled ){
-        size_t nDest = p->vfsMethods.xCompressBound(pInfo->pCtx, nSrcAmt);
-        pCmpBuf = sqlite3_malloc((int)nDest);
-        if( pCmpBuf ){
-          bSuccess = p->vfsMethods.xCompress(pInfo->pCtx, pCmpBuf, &nDest, pSrcData, nSrcAmt);
-          if( bSuccess ){
-            pSrcData = pCmpBuf;
-            nSrcAmt = nDest;
-          }
-        }else rc=SQLITE_NOMEM;
+    else if( (rc = cevfsPagerLock(p))==SQLITE_OK ){
+      u32 uppPgSz = p->cevfsHeader.uppPgSz;
+      cevfsReadAheadEnd(p, 0);
+      Pgno uppPgno = (Pgno)(iOfst/uppPgSz+1);
+      CevfsStagedPage *pStaged = cevfsStagedFind(p, uppPgno);
+
+      int bFullPage = iAmt==(int)uppPgSz && iOfst%uppPgSz==0;
+      if( !pStaged && ((p->nThreads>1 && bFullPage) || cevfsFramePages(p)>1) ){
+        // Hold full pages back so the whole commit can be encoded in parallel.
+        // In frame mode every page is held back so each frame is encoded once.
+        u8 *aOld = NULL;
+        if( p->nStaged==CEVFS_MAX_STAGED ) rc = cevfsStagedFlush(p);
+        if( rc==SQLITE_OK && !bFullPage ){
+          // A partial write starts from the current page image
+          if( (aOld = cevfsScratchGet(&p->scratch, uppPgSz))==NULL ) rc = SQLITE_NOMEM;
+          else rc = cevfsRead(pFile, aOld, (int)uppPgSz, iOfst-iOfst%uppPgSz);
+        }
+        if( rc==SQLITE_OK && (pStaged = cevfsStagedInsert(p, uppPgno))==NULL ) rc = SQLITE_NOMEM;
+        if( pStaged && aOld ) memcpy(pStaged->aData, aOld, uppPgSz);
+        cevfsScratchPut(&p->scratch, aOld);
       }
 
-      if( p->bEncryptionEnabled && bSuccess ){
-        size_t tmp_csz = 0;
-        void *iv = sqlite3_malloc((int)p->nEncIvSz);
-        if( iv ){
-          bSuccess = p->vfsMethods.xEncrypt(
-            pInfo->pCtx,
-            pSrcData,      // dataIn
-            nSrcAmt,       // data-in length
-            iv,            // IV out
-            &pEncBuf,      // dataOut; result is written here.
-            &tmp_csz,      // On successful return, the number of bytes written to dataOut.
-            sqlite3_malloc
-          );
-          if( bSuccess && pEncBuf ){
-            // Join IV and pEncBuf. If IV is greater than pInfo->nEncIvSz, it will be truncated.
-            void *pIvEncBuf = NULL;
-            CevfsCmpSize uIvEncSz = p->nEncIvSz+tmp_csz;
-            pIvEncBuf = sqlite3_realloc(iv, (int)(uIvEncSz));
-            memcpy(pIvEncBuf+p->nEncIvSz, pEncBuf, tmp_csz);
-            sqlite3_free(pEncBuf);
-            pSrcData = pEncBuf = pIvEncBuf;
-            nSrcAmt = uIvEncSz;
-          }else rc=CEVFS_ERROR_ENCRYPTION_FAILED;
-        }else rc=SQLITE_NOMEM;
+      if( pStaged ){
+        if( rc==SQLITE_OK ){
+          CEVFS_PRINTF(pInfo, "%s.xWrite(%s, offset=%08lld, amt=%06d) STAGED", pInfo->zVfsName, p->zFName, iOfst, iAmt);
+          memcpy(pStaged->aData+iOfst%uppPgSz, zBuf, iAmt);
+          if( p->cevfsHeader.uppPageFile<uppPgno ) p->cevfsHeader.uppPageFile = uppPgno;
+        }
+      }else if( rc==SQLITE_OK ){
+        void *pSrcData = NULL;
+        size_t nSrcAmt = 0;
+
+        rc = cevfsEncode(p, &p->scratch, &p->stats, zBuf, iAmt, &pSrcData, &nSrcAmt);
+        if( rc==SQLITE_OK ) rc = cevfsWriteEncoded(p, iOfst, iAmt, pSrcData, nSrcAmt);
+        if( pSrcData && pSrcData!=zBuf ) cevfsScratchPut(&p->scratch, pSrcData);
       }
 
-      // Make sure dest/lwr page size is large enough for incoming page of data
-      assert( nSrcAmt <= p->pageSize );
+      // Keep the cached image in step with what was just written
       if( rc==SQLITE_OK ){
-        if( nSrcAmt <= p->pageSize ){
-          DbPage *pPage;
-          Pgno uppPgno, mappedPgno;
-          CevfsCmpOfst cmprPgOfst;
-
-          cevfsPageMapSet(p, iOfst, nSrcAmt, &uppPgno, &mappedPgno, &cmprPgOfst);
-
-          // write
-          if( rc==SQLITE_OK && (rc = sqlite3PagerGet(p->pPager, mappedPgno, &pPage, 0))==SQLITE_OK ){
-            CevfsMemPage *pMemPage = memPageFromDbPage(pPage, mappedPgno);
-            if( rc==SQLITE_OK && (rc = cevfsPagerWrite(p, pPage))==SQLITE_OK ){
-              CEVFS_PRINTF(
-                pInfo,
-                "%s.xWrite(%s, pgno=%u->%u, offset=%08lld->%06lu, amt=%06d->%06d)",
-                pInfo->zVfsName, p->zFName,
-                uppPgno, mappedPgno,
-                iOfst, (unsigned long)(pMemPage->dbHdrOffset+pMemPage->pgHdrOffset+cmprPgOfst),
-                iAmt, nSrcAmt
-              );
-              memcpy(
-                pMemPage->aData
-                +pMemPage->dbHdrOffset
-                +pMemPage->pgHdrOffset
-                +cmprPgOfst,
-                pSrcData,
-                nSrcAmt
-              );
-
-              // Keep track of sizes of upper and lower pagers
-              if( p->cevfsHeader.uppPageFile<uppPgno ) p->cevfsHeader.uppPageFile = uppPgno;
-              if( p->lwrPageFile<mappedPgno ) p->lwrPageFile = mappedPgno;
-            }
-            sqlite3PagerUnref(pPage);
-          }
-        }else rc=CEVFS_ERROR_PAGE_SIZE_TOO_SMALL;
+        p->stats.nUppBytesWritten += iAmt;
+        CevfsCachedPage *pCached = cevfsCacheFind(p, uppPgno);
+        if( pCached ){
+          if( iAmt==(int)uppPgSz ) memcpy(pCached->aData, zBuf, iAmt);
+          else cevfsCacheDrop(p, pCached);
+        }
       }
-
-      if( pEncBuf ) sqlite3_free( pEncBuf );
-      if( pCmpBuf ) sqlite3_free( pCmpBuf );
+      cevfsPagerUnlock(p);
     }
+  }else if( p->bWal ){
+    CEVFS_PRINTF(pInfo, "%s.xWrite(%s, offset=%08lld, amt=%06d) WAL", pInfo->zVfsName, p->zFName, iOfst, iAmt);
+    rc = cevfsWalWrite(p, zBuf, iAmt, iOfst);
   }else{
     CEVFS_PRINTF(pInfo, "%s.xWrite(%s, offset=%08lld, amt=%06d)", pInfo->zVfsName, p->zFName, iOfst, iAmt);
     rc = p->pReal->pMethods->xWrite(p->pReal, zBuf, iAmt, iOfst);
@@ -1180,7 +3147,28 @@ static int cevfsTruncate(sqlite3_file *pFile, sqlite_int64 size){
   cevfs_info *pInfo = p->pInfo;
   int rc;
   CEVFS_PRINTF(pInfo, "%s.xTruncate(%s,%lld)", pInfo->zVfsName, p->zFName, size);
-  rc = p->pReal->pMethods->xTruncate(p->pReal, size);
+  if( p->bWal ){
+    rc = cevfsWalTruncate(p, size);
+  }else if( p->pPager ){
+    // The real file holds the lower pager, so only the upper size changes.
+    // It is saved with the next lower commit.
+    if( p->bReadOnly ) rc = SQLITE_READONLY;
+    else if( (rc = cevfsPagerLock(p))==SQLITE_OK ){
+      if( p->cevfsHeader.uppPgSz ){
+        Pgno nPage = (Pgno)((size+p->cevfsHeader.uppPgSz-1)/p->cevfsHeader.uppPgSz);
+        cevfsReadAheadEnd(p, 0);
+        cevfsCacheTruncate(p, nPage+1);
+        cevfsStagedTruncate(p, nPage+1);
+        if( nPage<p->cevfsHeader.uppPageFile && (rc = cevfsPagerBegin(p))==SQLITE_OK ){
+          p->cevfsHeader.uppPageFile = nPage;
+          p->bLwrDirty = 1;
+        }
+      }
+      cevfsPagerUnlock(p);
+    }
+  }else{
+    rc = p->pReal->pMethods->xTruncate(p->pReal, size);
+  }
   CEVFS_PRINTF(pInfo, " -> %d\n", rc);
   return rc;
 }
@@ -1203,7 +3191,17 @@ static int cevfsSync(sqlite3_file *pFile, int flags){
     sqlite3_snprintf(sizeof(zBuf)-i, &zBuf[i], "|0x%x", flags);
   }
   CEVFS_PRINTF(pInfo, "%s.xSync(%s,%s)", pInfo->zVfsName, p->zFName, &zBuf[1]);
-  rc = p->pReal->pMethods->xSync(p->pReal, flags);
+  if( p->pPager ){
+    // Upper pager is committing (or checkpointing): make the lower pager durable too.
+    rc = (!p->bReadOnly && (p->nTransactions>0 || p->nStaged>0)) ? cevfsCommit(p) : SQLITE_OK;
+    if( rc!=SQLITE_OK ) cevfsPagerRollback(p);
+    cevfsPagerUnlock(p);
+  }else if( p->bWal ){
+    rc = cevfsWalFlush(p);
+  }else{
+    rc = SQLITE_OK;
+  }
+  if( rc==SQLITE_OK ) rc = p->pReal->pMethods->xSync(p->pReal, flags);
   CEVFS_PRINTF(pInfo, " -> %d\n", rc);
   return rc;
 }
@@ -1219,8 +3217,12 @@ static int cevfsFileSize(sqlite3_file *pFile, sqlite_int64 *pSize){
   int rc;
   CEVFS_PRINTF(pInfo, "%s.xFileSize(%s)", pInfo->zVfsName, p->zFName);
   if( p->pPager ){
-    *pSize = header->uppPageFile * header->uppPgSz;
+    // Between transactions another connection may have changed the size
+    if( !p->pPage1 && cevfsPagerLock(p)==SQLITE_OK ) cevfsPagerUnlock(p);
+    *pSize = (sqlite_int64)header->uppPageFile * header->uppPgSz;
     rc = SQLITE_OK;
+  }else if( p->bWal ){
+    rc = cevfsWalFileSize(p, pSize);
   }else{
     rc = p->pReal->pMethods->xFileSize(p->pReal, pSize);
   }
@@ -1245,51 +3247,100 @@ static const char *lockName(int eLock){
 
 /*
 ** Lock a cevfs-file.
-** Never lock database file for upper pager as it doesn't directly control database file anymore.
+** The upper pager doesn't directly control the database file anymore, so in
+** rollback mode its locks are taken on the lower pager: SHARED holds page 1,
+** RESERVED begins a lower transaction and EXCLUSIVE locks the lower pager
+** for the commit. Once the upper pager has opened its WAL the lock is kept
+** on the real -wal file instead, so that connections that are not reading
+** don't block checkpoints while still keeping the WAL from being deleted
+** under them.
 */
 static int cevfsLock(sqlite3_file *pFile, int eLock){
   cevfs_file *p = (cevfs_file *)pFile;
   cevfs_info *pInfo = p->pInfo;
   int rc = SQLITE_OK;
-  CEVFS_PRINTF(pInfo, "%s.xLock(%s,%s) BYPASS", pInfo->zVfsName, p->zFName, lockName(eLock));
+  CEVFS_PRINTF(pInfo, "%s.xLock(%s,%s)", pInfo->zVfsName, p->zFName, lockName(eLock));
+  if( p->pWalFile ){
+    sqlite3_file *pWalReal = p->pWalFile->pReal;
+    rc = pWalReal->pMethods->xLock(pWalReal, eLock);
+  }else if( p->pPager ){
+    rc = cevfsPagerLockUpper(p, eLock);
+  }
+  if( rc==SQLITE_OK ) p->eUppLock = (u8)eLock;
+  else if( p->pPager ) cevfsPagerUnlock(p);
   cevfs_print_errcode(pInfo, " -> %s\n", rc);
   return rc;
 }
 
 /*
 ** Unlock a cevfs-file.
-** Never unlock database file for upper pager as it doesn't directly control database file anymore.
+** In rollback mode the end of an upper transaction commits whatever it
+** left in the lower pager, even if the database file was never synced.
 */
 static int cevfsUnlock(sqlite3_file *pFile, int eLock){
   cevfs_file *p = (cevfs_file *)pFile;
   cevfs_info *pInfo = p->pInfo;
   int rc = SQLITE_OK;
-  CEVFS_PRINTF(pInfo, "%s.xUnlock(%s,%s) BYPASS", pInfo->zVfsName, p->zFName, lockName(eLock));
+  CEVFS_PRINTF(pInfo, "%s.xUnlock(%s,%s)", pInfo->zVfsName, p->zFName, lockName(eLock));
+  if( p->pWalFile ){
+    sqlite3_file *pWalReal = p->pWalFile->pReal;
+    rc = pWalReal->pMethods->xUnlock(pWalReal, eLock);
+  }else if( p->pPager && eLock<SQLITE_LOCK_RESERVED
+         && !p->bReadOnly && (p->nTransactions>0 || p->nStaged>0)
+  ){
+    if( (rc = cevfsCommit(p))!=SQLITE_OK ) cevfsPagerRollback(p);
+  }
+  p->eUppLock = (u8)eLock;
+  if( p->pPager ) cevfsPagerUnlock(p);
   cevfs_print_errcode(pInfo, " -> %s\n", rc);
   return rc;
 }
 
 /*
 ** Check if another file-handle holds a RESERVED lock on a cevfs-file.
-** Bypass checks here since upper pager doesn't directly control database file anymore.
+** In rollback mode that is a lower pager transaction; the real file shares
+** its locks with the lower pager.
 */
 static int cevfsCheckReservedLock(sqlite3_file *pFile, int *pResOut){
   cevfs_file *p = (cevfs_file *)pFile;
   cevfs_info *pInfo = p->pInfo;
   int rc = SQLITE_OK;
   *pResOut = 0; // not locked
-  CEVFS_PRINTF(pInfo, "%s.xCheckReservedLock(%s,%d) BYPASS", pInfo->zVfsName, p->zFName);
+  CEVFS_PRINTF(pInfo, "%s.xCheckReservedLock(%s)", pInfo->zVfsName, p->zFName);
+  if( p->pPager && !p->pWalFile ){
+    rc = p->pReal->pMethods->xCheckReservedLock(p->pReal, pResOut);
+  }
   cevfs_print_errcode(pInfo, " -> %s", rc);
   CEVFS_PRINTF(pInfo, ", out=%d\n", *pResOut);
   CEVFS_PRINTF(pInfo, "\n");
   return rc;
 }
 
-static int cevfsPragma(sqlite3_file *pFile, const char *op, const char *arg){
+/*
+** Handle PRAGMAs aimed at cevfs. Returns SQLITE_NOTFOUND for pragmas that
+** should also be passed on to the underlying file.
+*/
+static int cevfsPragma(sqlite3_file *pFile, char **azArg){
   cevfs_file *p = (cevfs_file *)pFile;
-  int rc = SQLITE_OK;
+  const char *op = azArg[1];
+  const char *arg = azArg[2];
+  int rc = SQLITE_NOTFOUND;
   if( strcmp(op, "page_size")==0 ){
+    // Staged pages were written with the old page size
+    int rc2;
+    if( (rc2 = cevfsStagedFlush(p))!=SQLITE_OK ) return rc2;
+    cevfsReadAheadEnd(p, 0);
     p->cevfsHeader.uppPgSz = (u32)sqlite3Atoi(arg);
+    cevfsStagedFree(p);
+    cevfsCacheFree(p);
+  }else if( sqlite3StrICmp(op, "cevfs_compact")==0 ){
+    // PRAGMA cevfs_compact[=N]: move up to N compressed pages, 1000 by default
+    int nMax = arg ? sqlite3Atoi(arg) : 0;
+    int nMoved = 0;
+    if( nMax<=0 ) nMax = CEVFS_COMPACT_STEP;
+    if( (rc = cevfsCompact(p, nMax, &nMoved))==SQLITE_OK ){
+      azArg[0] = sqlite3_mprintf("%d", nMoved);
+    }
   }
   return rc;
 }
@@ -1334,12 +3385,28 @@ static int cevfsFileControl(sqlite3_file *pFile, int op, void *pArg){
     }
 #endif
     case SQLITE_FCNTL_PRAGMA: {
-      const char *const* a = (const char*const*)pArg;
+      char **a = (char**)pArg;
       sqlite3_snprintf(sizeof(zBuf), zBuf, "PRAGMA,[%s,%s]",a[1],a[2]);
       zOp = zBuf;
-      cevfsPragma(pFile, a[1], a[2]);
+      if( (rc = cevfsPragma(pFile, a))!=SQLITE_NOTFOUND ) return rc;
       break;
     }
+    case CEVFS_FCNTL_STATS: {
+      *(CevfsStats *)pArg = p->stats;
+      return SQLITE_OK;
+    }
+    case CEVFS_FCNTL_STATS_RESET: {
+      memset(&p->stats, 0, sizeof(CevfsStats));
+      return SQLITE_OK;
+    }
+    case CEVFS_FCNTL_COMPACT: {
+      int nMoved = 0;
+      int nMax = *(int*)pArg;
+      if( (rc = cevfsCompact(p, nMax>0 ? nMax : CEVFS_COMPACT_STEP, &nMoved))==SQLITE_OK ){
+        *(int*)pArg = nMoved;
+      }
+      return rc;
+    }
     default: {
 #ifdef SQLITE_DEBUG
       sqlite3_snprintf(sizeof(zBuf), zBuf, "%d", op);
@@ -1409,6 +3476,30 @@ static int cevfsShmLock(sqlite3_file *pFile, int ofst, int n, int flags){
   CEVFS_PRINTF(pInfo, "%s.xShmLock(%s,ofst=%d,n=%d,%s)", pInfo->zVfsName, p->zFName, ofst, n, &zLck[1]);
   rc = p->pReal->pMethods->xShmLock(p->pReal, ofst, n, flags);
   cevfs_print_errcode(pInfo, " -> %s\n", rc);
+
+  if( rc==SQLITE_OK && p->pPager ){
+    if( flags==(SQLITE_SHM_LOCK|SQLITE_SHM_SHARED) && ofst>=CEVFS_WAL_READ_LOCK0 ){
+      // A read transaction starts. Pick up the page maps of checkpoints run
+      // by other connections; if the lower pager is busy, make the next
+      // read do it instead of trusting decoded pages.
+      if( cevfsPagerLock(p)==SQLITE_OK ){
+        cevfsPagerUnlock(p);
+      }else{
+        cevfsReadAheadEnd(p, 0);
+        cevfsCacheFree(p);
+        p->bLwrStale = 1;
+      }
+    }else if( flags==(SQLITE_SHM_UNLOCK|SQLITE_SHM_EXCLUSIVE)
+           && ofst<=CEVFS_WAL_CKPT_LOCK && ofst+n>CEVFS_WAL_CKPT_LOCK
+    ){
+      // A checkpoint is over. Commit what it wrote even if the database
+      // file was not synced, so other connections see it.
+      if( !p->bReadOnly && (p->nTransactions>0 || p->nStaged>0) && cevfsCommit(p)!=SQLITE_OK ){
+        cevfsPagerRollback(p);
+      }
+      cevfsPagerUnlock(p);
+    }
+  }
   return rc;
 }
 static int cevfsShmMap(
@@ -1447,6 +3538,45 @@ static void cevfsPageReinit(DbPage *pData){
 
 }
 
+/*
+** Install the built-in codecs recorded in the cevfs header. For a new
+** database they are first chosen with the compression and cipher URI
+** parameters; an existing database always uses the ones it was built with.
+** The frame_pages parameter is recorded the same way.
+*/
+static int cevfsSetupCodecs(cevfs_file *p, const char *zName, int bUri){
+  cevfs_header *header = &p->cevfsHeader;
+  int rc = SQLITE_OK;
+
+  if( bUri && p->lwrPageFile==0 ){
+    const char *zCmpr = sqlite3_uri_parameter(zName, "compression");
+    const char *zCipher = sqlite3_uri_parameter(zName, "cipher");
+    sqlite3_int64 nFramePages = sqlite3_uri_int64(zName, "frame_pages", 0);
+    int iCodec;
+    if( zCmpr ){
+      if( (iCodec = cevfsCodecFind(zCmpr, 0))<0 ) return CEVFS_ERROR_UNKNOWN_CODEC;
+      header->cmprCodec = (u8)iCodec;
+    }
+    if( zCipher ){
+      if( (iCodec = cevfsCodecFind(zCipher, 1))<0 ) return CEVFS_ERROR_UNKNOWN_CODEC;
+      header->encCodec = (u8)iCodec;
+    }
+    if( nFramePages>CEVFS_MAX_FRAME_PAGES ) nFramePages = CEVFS_MAX_FRAME_PAGES;
+    header->framePages = nFramePages>1 ? (u8)nFramePages : 0;
+  }
+
+  if( header->cmprCodec ){
+    if( (rc = cevfsCodecInstallCompression(header->cmprCodec, &p->vfsMethods))!=SQLITE_OK ) return rc;
+    p->pCmprCtx = NULL;
+  }
+  if( header->encCodec ){
+    const char *zKey = bUri ? sqlite3_uri_parameter(zName, "key") : NULL;
+    rc = cevfsCodecInstallCipher(header->encCodec, zKey, &p->vfsMethods, &p->nEncIvSz, &p->pCipher);
+    if( rc==SQLITE_OK ) p->pEncCtx = p->pCipher;
+  }
+  return rc;
+}
+
 /*
 ** Open a cevfs file handle.
 */
@@ -1498,7 +3628,19 @@ static int cevfsOpen(
     // block_size
     const char *zParamBlockSize = sqlite3_uri_parameter(_zName, "block_size");
     if( zParamBlockSize ) nParamBlockSz = (u32)sqlite3Atoi(zParamBlockSize);
+    // page_cache
+    p->nCacheMax = (u32)sqlite3_uri_int64(_zName, "page_cache", CEVFS_DEFAULT_PAGE_CACHE);
+    // threads
+    p->nThreads = (int)sqlite3_uri_int64(_zName, "threads", CEVFS_DEFAULT_THREADS);
+    // read_ahead
+    p->nReadAhead = (u32)sqlite3_uri_int64(_zName, "read_ahead", CEVFS_DEFAULT_READ_AHEAD);
+  }else{
+    p->nCacheMax = CEVFS_DEFAULT_PAGE_CACHE;
+    p->nThreads = CEVFS_DEFAULT_THREADS;
+    p->nReadAhead = CEVFS_DEFAULT_READ_AHEAD;
   }
+  if( p->nThreads>CEVFS_MAX_THREADS ) p->nThreads = CEVFS_MAX_THREADS;
+  if( p->nReadAhead>p->nCacheMax/2 ) p->nReadAhead = p->nCacheMax/2;
 
   // open file
   rc = pRoot->xOpen(pRoot, zName, p->pReal, flags, pOutFlags);
@@ -1532,11 +3674,41 @@ static int cevfsOpen(
       pFile->pMethods = pNew;
     }
 
+    // The upper pager's WAL shares the codec of the database it belongs to.
+    if( flags & SQLITE_OPEN_WAL ){
+      p->pDbFile = (cevfs_file *)sqlite3_database_file_object(_zName);
+      if( p->pDbFile && p->pDbFile->pPager ){
+        p->bWal = 1;
+        p->vfsMethods = p->pDbFile->vfsMethods;
+        p->nEncIvSz = p->pDbFile->nEncIvSz;
+        p->pCmprCtx = p->pDbFile->pCmprCtx;
+        p->pEncCtx = p->pDbFile->pEncCtx;
+        p->bCompressionEnabled = p->pDbFile->bCompressionEnabled;
+        p->bEncryptionEnabled = p->pDbFile->bEncryptionEnabled;
+        p->walPgSz = p->pDbFile->cevfsHeader.uppPgSz;
+        cevfsWalReset(p);
+        // From now on the upper lock on the database is kept on this file
+        if( p->pDbFile->eUppLock>=SQLITE_LOCK_SHARED ){
+          rc = p->pReal->pMethods->xLock(p->pReal, SQLITE_LOCK_SHARED);
+        }
+        if( rc==SQLITE_OK && p->pDbFile->eUppLock>SQLITE_LOCK_SHARED ){
+          rc = p->pReal->pMethods->xLock(p->pReal, p->pDbFile->eUppLock);
+        }
+        if( rc==SQLITE_OK ){
+          p->pDbFile->pWalFile = p;
+          cevfsPagerUnlock(p->pDbFile);
+        }
+      }else{
+        p->pDbFile = NULL;
+      }
+    }
+
     // create pager to handle I/O to compressed/encrypted underlying db
     if( flags & (SQLITE_OPEN_MAIN_DB | SQLITE_OPEN_TEMP_DB | SQLITE_OPEN_TRANSIENT_DB) ){
       if( (rc = sqlite3PagerOpen(pInfo->pRootVfs, &p->pPager, zName, EXTRA_SIZE, 0, flags, cevfsPageReinit))==SQLITE_OK){
         if( rc==SQLITE_OK ){
           sqlite3PagerSetJournalMode(p->pPager, PAGER_JOURNALMODE_DELETE);
+          sqlite3PagerSetBusyHandler(p->pPager, cevfsPagerBusy, p);
 //          sqlite3PagerJournalSizeLimit(p->pPager, -1);
 //          rc = sqlite3PagerLockingMode(p->pPager, PAGER_LOCKINGMODE_NORMAL);
 //          sqlite3PagerSetMmapLimit(pBt->pPager, db->szMmap); /* advisory, except if 0 */
@@ -1554,17 +3726,22 @@ static int cevfsOpen(
             if( (rc = sqlite3PagerSetPagesize(p->pPager, &p->pageSize, nReserve)) == SQLITE_OK ){
               p->usableSize = p->pageSize - nReserve;
               sqlite3PagerSetCachesize(p->pPager, SQLITE_DEFAULT_CACHE_SIZE);
+              // Loads the page maps; the lock itself is dropped once the codecs are set up
               rc = cevfsPagerLock(p);
             }
 
             // Call user xAutoDetect to set up VFS methods
+            p->pCmprCtx = p->pEncCtx = pInfo->pCtx;
             if (pInfo->xAutoDetect) {
               pInfo->xAutoDetect(pInfo->pCtx, _zName, (const char *)p->zDbHeader+6, &p->nEncIvSz, &p->vfsMethods);
-              if (p->vfsMethods.xCompressBound && p->vfsMethods.xCompress && p->vfsMethods.xUncompress)
-                p->bCompressionEnabled = true;
-              if (p->vfsMethods.xEncrypt && p->vfsMethods.xDecrypt)
-                p->bEncryptionEnabled = true;
             }
+            // Built-in codecs replace whatever xAutoDetect set up
+            if( rc==SQLITE_OK ) rc = cevfsSetupCodecs(p, _zName, flags & SQLITE_OPEN_URI);
+            if (p->vfsMethods.xCompressBound && p->vfsMethods.xCompress && p->vfsMethods.xUncompress)
+              p->bCompressionEnabled = true;
+            if (p->vfsMethods.xEncrypt && p->vfsMethods.xDecrypt)
+              p->bEncryptionEnabled = true;
+            cevfsPagerUnlock(p);
           }
         }else{
           cevfsClose(pFile);
@@ -1734,6 +3911,184 @@ static int cevfsGetLastError(sqlite3_vfs *pVfs, int iErr, char *zErr){
   return pRoot->xGetLastError(pRoot, iErr, zErr);
 }
 
+/*
+** The eponymous cevfs_stats virtual table lists the counters of one CEVFS
+** database, 'main' unless another schema is passed as its argument:
+**   SELECT name, value FROM cevfs_stats('aux');
+** It is empty for databases that don't use CEVFS.
+*/
+static const char *const azCevfsStatName[] = {
+  "upper_bytes_read",
+  "upper_bytes_written",
+  "compressed_bytes_read",
+  "compressed_bytes_written",
+  "compress_calls",
+  "compress_ns",
+  "decompress_calls",
+  "decompress_ns",
+  "encrypt_calls",
+  "encrypt_ns",
+  "decrypt_calls",
+  "decrypt_ns",
+  "page_map_writes",
+  "slot_reallocs",
+  "abandoned_bytes",
+  "cache_hits",
+  "cache_misses",
+};
+
+#define CEVFS_STATS_COLUMN_NAME    0
+#define CEVFS_STATS_COLUMN_VALUE   1
+#define CEVFS_STATS_COLUMN_SCHEMA  2
+
+typedef struct cevfs_stats_vtab cevfs_stats_vtab;
+struct cevfs_stats_vtab {
+  sqlite3_vtab base;                   // Base class.  Must be first
+  sqlite3 *db;                         // Connection the table belongs to
+};
+
+typedef struct cevfs_stats_cursor cevfs_stats_cursor;
+struct cevfs_stats_cursor {
+  sqlite3_vtab_cursor base;            // Base class.  Must be first
+  CevfsStats stats;                    // Counters read by xFilter
+  char *zSchema;                       // Schema the counters belong to
+  int iRow;                            // Current row, an index into azCevfsStatName
+  int nRow;                            // Number of rows, 0 if the schema isn't a CEVFS database
+};
+
+static int cevfsStatsConnect(
+  sqlite3 *db,
+  void *pAux,
+  int argc,
+  const char *const*argv,
+  sqlite3_vtab **ppVtab,
+  char **pzErr
+){
+  cevfs_stats_vtab *pTab;
+  int rc;
+  assert( sizeof(azCevfsStatName)/sizeof(azCevfsStatName[0])==sizeof(CevfsStats)/sizeof(unsigned long long) );
+  rc = sqlite3_declare_vtab(db, "CREATE TABLE x(name TEXT, value INTEGER, schema HIDDEN)");
+  if( rc!=SQLITE_OK ) return rc;
+  if( (pTab = sqlite3_malloc(sizeof(*pTab)))==NULL ) return SQLITE_NOMEM;
+  memset(pTab, 0, sizeof(*pTab));
+  pTab->db = db;
+  *ppVtab = &pTab->base;
+  return SQLITE_OK;
+}
+
+static int cevfsStatsDisconnect(sqlite3_vtab *pVtab){
+  sqlite3_free(pVtab);
+  return SQLITE_OK;
+}
+
+static int cevfsStatsOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor){
+  cevfs_stats_cursor *pCur = sqlite3_malloc(sizeof(*pCur));
+  if( pCur==NULL ) return SQLITE_NOMEM;
+  memset(pCur, 0, sizeof(*pCur));
+  *ppCursor = &pCur->base;
+  return SQLITE_OK;
+}
+
+static int cevfsStatsClose(sqlite3_vtab_cursor *cur){
+  cevfs_stats_cursor *pCur = (cevfs_stats_cursor *)cur;
+  sqlite3_free(pCur->zSchema);
+  sqlite3_free(pCur);
+  return SQLITE_OK;
+}
+
+/*
+** Use the schema argument if given: idxNum is 1 and it is argv[0] of xFilter.
+*/
+static int cevfsStatsBestIndex(sqlite3_vtab *pVtab, sqlite3_index_info *pInfo){
+  for(int i=0; i<pInfo->nConstraint; i++){
+    const struct sqlite3_index_constraint *pCons = &pInfo->aConstraint[i];
+    if( pCons->iColumn==CEVFS_STATS_COLUMN_SCHEMA && pCons->op==SQLITE_INDEX_CONSTRAINT_EQ ){
+      if( !pCons->usable ) return SQLITE_CONSTRAINT;
+      pInfo->aConstraintUsage[i].argvIndex = 1;
+      pInfo->aConstraintUsage[i].omit = 1;
+      pInfo->idxNum = 1;
+      break;
+    }
+  }
+  pInfo->estimatedCost = (double)(sizeof(azCevfsStatName)/sizeof(azCevfsStatName[0]));
+  return SQLITE_OK;
+}
+
+static int cevfsStatsFilter(
+  sqlite3_vtab_cursor *cur,
+  int idxNum,
+  const char *idxStr,
+  int argc,
+  sqlite3_value **argv
+){
+  cevfs_stats_cursor *pCur = (cevfs_stats_cursor *)cur;
+  cevfs_stats_vtab *pTab = (cevfs_stats_vtab *)cur->pVtab;
+  const char *zSchema = idxNum ? (const char *)sqlite3_value_text(argv[0]) : "main";
+  sqlite3_free(pCur->zSchema);
+  if( (pCur->zSchema = sqlite3_mprintf("%s", zSchema ? zSchema : "main"))==NULL ) return SQLITE_NOMEM;
+  pCur->iRow = 0;
+  pCur->nRow = 0;
+  if( sqlite3_file_control(pTab->db, pCur->zSchema, CEVFS_FCNTL_STATS, &pCur->stats)==SQLITE_OK ){
+    pCur->nRow = (int)(sizeof(azCevfsStatName)/sizeof(azCevfsStatName[0]));
+  }
+  return SQLITE_OK;
+}
+
+static int cevfsStatsNext(sqlite3_vtab_cursor *cur){
+  ((cevfs_stats_cursor *)cur)->iRow++;
+  return SQLITE_OK;
+}
+
+static int cevfsStatsEof(sqlite3_vtab_cursor *cur){
+  cevfs_stats_cursor *pCur = (cevfs_stats_cursor *)cur;
+  return pCur->iRow>=pCur->nRow;
+}
+
+static int cevfsStatsColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int i){
+  cevfs_stats_cursor *pCur = (cevfs_stats_cursor *)cur;
+  switch( i ){
+    case CEVFS_STATS_COLUMN_NAME:
+      sqlite3_result_text(ctx, azCevfsStatName[pCur->iRow], -1, SQLITE_STATIC);
+      break;
+    case CEVFS_STATS_COLUMN_VALUE:
+      sqlite3_result_int64(ctx, (sqlite3_int64)((unsigned long long *)&pCur->stats)[pCur->iRow]);
+      break;
+    default:
+      sqlite3_result_text(ctx, pCur->zSchema, -1, SQLITE_TRANSIENT);
+      break;
+  }
+  return SQLITE_OK;
+}
+
+static int cevfsStatsRowid(sqlite3_vtab_cursor *cur, sqlite_int64 *pRowid){
+  *pRowid = ((cevfs_stats_cursor *)cur)->iRow;
+  return SQLITE_OK;
+}
+
+static sqlite3_module cevfsStatsModule = {
+  0,                        // iVersion
+  0,                        // xCreate: eponymous only
+  cevfsStatsConnect,        // xConnect
+  cevfsStatsBestIndex,      // xBestIndex
+  cevfsStatsDisconnect,     // xDisconnect
+  0,                        // xDestroy
+  cevfsStatsOpen,           // xOpen
+  cevfsStatsClose,          // xClose
+  cevfsStatsFilter,         // xFilter
+  cevfsStatsNext,           // xNext
+  cevfsStatsEof,            // xEof
+  cevfsStatsColumn,         // xColumn
+  cevfsStatsRowid,          // xRowid
+};
+
+int cevfs_register_stats(sqlite3 *db){
+  return sqlite3_create_module(db, "cevfs_stats", &cevfsStatsModule, 0);
+}
+
+static int cevfsStatsAutoInit(sqlite3 *db, char **pzErrMsg, const sqlite3_api_routines *pApi){
+  return cevfs_register_stats(db);
+}
+
 /*
 ** Clients invoke cevfs_create_vfs to construct a new cevfs.
 **
@@ -1758,6 +4113,9 @@ int cevfs_create_vfs(
   // Allow parameters to be passed with database filename in URI form.
   sqlite3_config(SQLITE_CONFIG_URI, 1);
 
+  // Make cevfs_stats available on every new connection
+  sqlite3_auto_extension((void(*)(void))cevfsStatsAutoInit);
+
   // Don't register VFS with same name more than once
   if( sqlite3_vfs_find(zName) )
     return CEVFS_ERROR_VFS_ALREADY_EXISTS;
@@ -1832,10 +4190,32 @@ int cevfs_build(
   const char *vfsName,
   void *pCtx,
   t_xAutoDetect xAutoDetect
+){
+  return cevfs_build_v2(zSrcFilename, zDestFilename, vfsName, pCtx, xAutoDetect, NULL);
+}
+
+/*
+** Like cevfs_build() with options. Pages are written with the staged,
+** multi-threaded encoder and the lower pager is committed every
+** nCheckpoint pages, so an interrupted build can be resumed from the last
+** checkpoint as long as the source is unchanged.
+*/
+int cevfs_build_v2(
+  const char *zSrcFilename,
+  const char *zDestFilename,
+  const char *vfsName,
+  void *pCtx,
+  t_xAutoDetect xAutoDetect,
+  const CevfsBuildOptions *pOpts
 ){
   int rc = SQLITE_OK;
   unsigned char zDbHeader[100];
   sqlite3_vfs *pDestVfs = NULL;
+  CevfsBuildOptions opts;
+
+  memset(&opts, 0, sizeof(opts));
+  if( pOpts ) opts = *pOpts;
+  if( opts.nCheckpoint==0 ) opts.nCheckpoint = CEVFS_BUILD_CHECKPOINT;
 
   // cevfs_create_vfs must be done early enough to avoid SQLITE_MISUSE error
   rc = cevfs_create_vfs(vfsName, NULL, pCtx, xAutoDetect, 0);
@@ -1879,35 +4259,62 @@ int cevfs_build(
                 cevfs_info *pInfo = (cevfs_info *)pDestVfs->pAppData;
                 pInfo->upperPgSize = pageSize;
 
-                if( (rc = sqlite3_open_v2(zDestFilename, &pDb, SQLITE_OPEN_READWRITE|SQLITE_OPEN_CREATE, vfsName))==SQLITE_OK ){
-                 // Needed for sqlite3 API shims
-                 pInfo->pDb = pDb;
+                if( (rc = sqlite3_open_v2(zDestFilename, &pDb, SQLITE_OPEN_READWRITE|SQLITE_OPEN_CREATE|SQLITE_OPEN_URI, vfsName))==SQLITE_OK ){
+                  // Needed for sqlite3 API shims
+                  pInfo->pDb = pDb;
 
+                  cevfs_file *pFile = pInfo->pFile;
                   DbPage *pPage1 = NULL;
+                  Pgno nDone = 0;
+
+                  if( opts.nThreads>0 ){
+                    pFile->nThreads = opts.nThreads>CEVFS_MAX_THREADS ? CEVFS_MAX_THREADS : opts.nThreads;
+                  }
+
+                  // Page 1 stays referenced until the end
+                  rc = sqlite3PagerGet(pPager, 1, &pPage1, 0);
+
+                  // Pick up after the last checkpoint if the destination was built from this source
+                  if( rc==SQLITE_OK && opts.bResume && pFile->cevfsHeader.uppPageFile>0 ){
+                    u8 *aPage = sqlite3_malloc(pageSize);
+                    if( aPage==NULL ){
+                      rc = SQLITE_NOMEM;
+                    }else if( (rc = cevfsRead((sqlite3_file *)pFile, aPage, pageSize, 0))==SQLITE_OK ){
+                      if( memcmp(aPage, sqlite3PagerGetData(pPage1), pageSize)==0 ){
+                        nDone = pFile->cevfsHeader.uppPageFile;
+                      }else{
+                        rc = CEVFS_ERROR_BUILD_MISMATCH;
+                      }
+                    }
+                    sqlite3_free(aPage);
+                  }
+                  if( rc==SQLITE_OK && opts.xProgress && opts.xProgress(opts.pProgressArg, nDone, pageCount) ){
+                    rc = SQLITE_ABORT;
+                  }
+
                   // import all pages
-                  for(Pgno pgno=0; pgno<pageCount; pgno++){
+                  for(Pgno pgno=nDone; pgno<pageCount && rc==SQLITE_OK; pgno++){
                     // read source page
-                    DbPage *pPage;
-                    rc = sqlite3PagerGet(pPager, pgno+1, &pPage, /* flags */ 0);
+                    DbPage *pPage = pPage1;
+                    if( pgno>0 ) rc = sqlite3PagerGet(pPager, pgno+1, &pPage, /* flags */ 0);
                     if( rc==SQLITE_OK ){
-                      // read source page
-                      void *pData = sqlite3PagerGetData(pPage);
                       // write destination page
-                      rc = cevfsWrite((sqlite3_file *)pInfo->pFile, pData, pageSize, pageSize*pgno);
-                      if( pgno==0 ){
-                        // To be deallocated later
-                        pPage1 = pPage;
-                      }else{
-                        sqlite3PagerUnref(pPage);
+                      void *pData = sqlite3PagerGetData(pPage);
+                      rc = cevfsWrite((sqlite3_file *)pFile, pData, pageSize, (sqlite3_int64)pageSize*pgno);
+                      if( pPage!=pPage1 ) sqlite3PagerUnref(pPage);
+                    }
+                    // checkpoint
+                    if( rc==SQLITE_OK && ((pgno+1)%opts.nCheckpoint==0 || pgno+1==pageCount) ){
+                      rc = cevfsCommit(pFile);
+                      if( rc==SQLITE_OK && opts.xProgress && opts.xProgress(opts.pProgressArg, pgno+1, pageCount) ){
+                        rc = SQLITE_ABORT;
                       }
-                      if( rc != SQLITE_OK ) break;
-                    }else{
-                      break;
                     }
                   }
                   if (pPage1) sqlite3PagerUnref(pPage1);
                   sqlite3PagerCloseShim(pPager, pDb);
-                  rc = sqlite3_close(pDb);
+                  if( rc==SQLITE_OK ) rc = sqlite3_close(pDb);
+                  else sqlite3_close(pDb);
                 }
               }
             }
@@ -40,6 +40,56 @@ SOFTWARE.
 #define CEVFS_ERROR_DECOMPRESSION_FAILED         (CEVFS_ERROR | (7<<8))
 #define CEVFS_ERROR_ENCRYPTION_FAILED            (CEVFS_ERROR | (8<<8))
 #define CEVFS_ERROR_DECRYPTION_FAILED            (CEVFS_ERROR | (9<<8))
+#define CEVFS_ERROR_UNKNOWN_CODEC                (CEVFS_ERROR | (10<<8))
+#define CEVFS_ERROR_BUILD_MISMATCH               (CEVFS_ERROR | (11<<8))
+
+// Built-in codec ids, recorded in the database header.
+// 0 means the methods come from the xAutoDetect function.
+#define CEVFS_CODEC_ZLIB                         1
+#define CEVFS_CODEC_LZ4                          2
+#define CEVFS_CODEC_ZSTD                         3
+#define CEVFS_CIPHER_AES256_CTR                  1
+
+/*
+** File control to reclaim free space in the lower pager, one bounded step at a time.
+** pArg points to an int holding the max number of compressed pages to move (0 for
+** the default). On return it holds the number actually moved; repeat until it is 0.
+** The same is available as PRAGMA cevfs_compact[=N].
+*/
+#define CEVFS_FCNTL_COMPACT                      0x43450001
+
+/*
+** File controls to read (pArg is a CevfsStats* to fill in) and reset (pArg unused)
+** the counters of a CEVFS database. They are also shown by the cevfs_stats table.
+*/
+#define CEVFS_FCNTL_STATS                        0x43450002
+#define CEVFS_FCNTL_STATS_RESET                  0x43450003
+
+/*
+** Counters kept by each open CEVFS database, including its WAL. Upper bytes are
+** as seen by SQLite, compressed bytes as stored in the lower pager. Times are in
+** nanoseconds. All fields are unsigned long long.
+*/
+struct CevfsStats {
+  unsigned long long nUppBytesRead;      // Bytes read by SQLite
+  unsigned long long nUppBytesWritten;   // Bytes written by SQLite
+  unsigned long long nCmprBytesRead;     // Compressed/encrypted bytes read from the lower pager
+  unsigned long long nCmprBytesWritten;  // Compressed/encrypted bytes written to the lower pager
+  unsigned long long nCompress;          // Calls to xCompress
+  unsigned long long nsCompress;         // Time spent in xCompress
+  unsigned long long nDecompress;        // Calls to xUncompress
+  unsigned long long nsDecompress;       // Time spent in xUncompress
+  unsigned long long nEncrypt;           // Calls to xEncrypt
+  unsigned long long nsEncrypt;          // Time spent in xEncrypt
+  unsigned long long nDecrypt;           // Calls to xDecrypt
+  unsigned long long nsDecrypt;          // Time spent in xDecrypt
+  unsigned long long nPageMapWrites;     // Page map pages written to the lower pager
+  unsigned long long nSlotReallocs;      // Pages moved to a new slot because they grew
+  unsigned long long nAbandonedBytes;    // Slot bytes given up by pages that grew, shrank or moved
+  unsigned long long nCacheHits;         // Reads served from the decompressed page cache
+  unsigned long long nCacheMisses;       // Reads that had to decode a page while the cache is on
+};
+typedef struct CevfsStats CevfsStats;
 
 struct CevfsMethods {
   void *pCtx;
@@ -87,6 +137,14 @@ int cevfs_create_vfs(
 
 int cevfs_destroy_vfs(const char *zName);
 
+/*!
+ \brief Register the eponymous cevfs_stats virtual table with a connection.
+ \details Connections opened after cevfs_create_vfs get it automatically.
+ SELECT name, value FROM cevfs_stats('main') lists the counters of a CEVFS database.
+ */
+struct sqlite3;
+int cevfs_register_stats(struct sqlite3 *db);
+
 /*!
  \brief Create new compresses/encrypted database from existing database.
  \param zSrcFilename Standard path to existing uncompressed, unencrypted SQLite database file.
@@ -100,4 +158,34 @@ int cevfs_build(
   t_xAutoDetect              // xAutoDetect method to set up xMethods.
 );
 
+/*
+** Options for cevfs_build_v2(). Zero-initialize and set what you need.
+*/
+struct CevfsBuildOptions {
+  int nThreads;              // Compression/encryption threads, 0 for the threads URI parameter
+  int bResume;               // Continue an interrupted build of the same source into the same destination
+  unsigned int nCheckpoint;  // Pages written between checkpoints, 0 for the default (16384)
+
+  // Called at the start and after each checkpoint with the number of pages done so far.
+  // Return non-zero to stop the build; cevfs_build_v2 then returns SQLITE_ABORT.
+  int (*xProgress)(void *pArg, unsigned int nDone, unsigned int nTotal);
+  void *pProgressArg;
+};
+typedef struct CevfsBuildOptions CevfsBuildOptions;
+
+/*!
+ \brief Like cevfs_build, with options for threading, progress reporting and resuming.
+ \details The destination is committed every nCheckpoint pages. If a build is interrupted,
+ calling again with bResume set continues after the last checkpoint. If the destination was
+ built from a different source, CEVFS_ERROR_BUILD_MISMATCH is returned.
+ */
+int cevfs_build_v2(
+  const char *zSrcFilename,  // Source SQLite DB filename, including path. Can be a URI.
+  const char *zDestFilename, // Destination SQLite DB filename, including path. Can be a URI.
+  const char *vfsName,       // This will be embedded into the header of the database file.
+  void *pCtx,                // Context pointer to be passed to CEVFS xMethods.
+  t_xAutoDetect,             // xAutoDetect method to set up xMethods.
+  const CevfsBuildOptions *pOpts  // Options, NULL for defaults.
+);
+
 #endif /* __CEVFS_H__ */
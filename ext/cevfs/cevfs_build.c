@@ -26,10 +26,15 @@ SOFTWARE.
 */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 #include "cevfs.h"
+#ifdef __APPLE__
 #include "xMethods.c"
+#endif
 
 extern const char *fileTail(const char *z);
 typedef unsigned char u8;
@@ -45,6 +50,7 @@ typedef unsigned char u8;
 # define SQLITE_ASCII 1
 #endif
 
+#ifdef __APPLE__
 /*
 ** Taken from SQLite source code.
 ** Translate a single byte of Hex into an integer.
@@ -86,23 +92,90 @@ static void *hexToBlob(const char *z, int n){
 
 // This context will be passed to xAutoDetect and the functions defined within.
 struct context ctx;
+#endif
+
+static double now(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+/*
+** Progress state for the build. Throughput is measured from the first
+** report, so a resumed build does not count the pages it skipped.
+*/
+struct progress {
+  double tStart;
+  unsigned int nStart;
+};
+
+static int showProgress(void *pArg, unsigned int nDone, unsigned int nTotal){
+  struct progress *p = (struct progress *)pArg;
+  double t = now();
+  if( p->tStart==0 ){
+    p->tStart = t;
+    p->nStart = nDone;
+  }
+  double secs = t - p->tStart;
+  double rate = secs>0 ? (nDone - p->nStart)/secs : 0;
+  unsigned int eta = rate>0 ? (unsigned int)((nTotal - nDone)/rate) : 0;
+  fprintf(stderr, "\r%u/%u pages (%.1f%%), %.0f pages/s, ETA %02u:%02u:%02u ",
+          nDone, nTotal, nTotal ? 100.0*nDone/nTotal : 100.0, rate, eta/3600, eta/60%60, eta%60);
+  if( nDone==nTotal ) fprintf(stderr, "\n");
+  return 0;
+}
+
+static void usage(const char *zProg){
+  printf("Usage: %s [OPTIONS] UNCOMPRESSED COMPRESSED VFS_NAME KEY\n", zProg);
+  printf("  UNCOMPRESSED: URI of uncompressed SQLite DB file.\n");
+  printf("  COMPRESSED:   URI of new compressed DB with optional ?block_size=<block_size>\n");
+  printf("  VFS_NAME:     Name of VFS to embed in database file.\n");
+  printf("  KEY:          Encryption key in the form: x'<hex1><hex2>...<hex32>'\n");
+  printf("Options:\n");
+  printf("  -j N          Compress and encrypt on N threads (default: number of CPUs).\n");
+  printf("  -r            Resume an interrupted build into COMPRESSED.\n");
+  printf("  -q            Don't report progress.\n");
+}
 
 int main(int argc, const char * argv[]) {
-  if( argc != 5 ){
-    printf("Usage: %s UNCOMPRESSED COMPRESSED KEY\n", fileTail(argv[0]));
-    printf("  UNCOMPRESSED: URI of uncompressed SQLite DB file.\n");
-    printf("  COMPRESSED:   URI of new compressed DB with optional ?block_size=<block_size>\n");
-    printf("  VFS_NAME:     Name of VFS to embed in database file.\n");
-    printf("  KEY:          Encryption key in the form: x'<hex1><hex2>...<hex32>'\n");
+  const char *azArg[4];
+  int nArg = 0;
+  int bQuiet = 0;
+  CevfsBuildOptions opts;
+  struct progress prog = {0, 0};
+
+  memset(&opts, 0, sizeof(opts));
+  opts.nThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  for(int i=1; i<argc; i++){
+    if( strcmp(argv[i], "-j")==0 && i+1<argc ){
+      opts.nThreads = atoi(argv[++i]);
+    }else if( strcmp(argv[i], "-r")==0 ){
+      opts.bResume = 1;
+    }else if( strcmp(argv[i], "-q")==0 ){
+      bQuiet = 1;
+    }else if( nArg<4 && argv[i][0]!='-' ){
+      azArg[nArg++] = argv[i];
+    }else{
+      nArg = -1;
+      break;
+    }
+  }
+  if( nArg != 4 ){
+    usage(fileTail(argv[0]));
     return EXIT_FAILURE;
   }
+  if( !bQuiet ){
+    opts.xProgress = showProgress;
+    opts.pProgressArg = &prog;
+  }
 
   int rc;
 
+#ifdef __APPLE__
   // Convert encryption key string to hex blob.
   // This assumes that the key is in the form of x'<hex-string>'
   // You should, of course, implement proper error checking.
-  const char *key = argv[4]+2;
+  const char *key = azArg[3]+2;
   char *keyBytes = hexToBlob(key, (int)strlen(key)-1);
 
   ctx.pKey   = keyBytes;           // 32-bit encryption hex key
@@ -111,6 +184,21 @@ int main(int argc, const char * argv[]) {
 
   // You can use the VFS name to determine how you set up your xMethods,
   // so we pass the VFS name as a command line parameter as well.
-  rc = cevfs_build(argv[1], argv[2], argv[3], &ctx, cevfsAutoDetect);
+  rc = cevfs_build_v2(azArg[0], azArg[1], azArg[2], &ctx, cevfsAutoDetect, &opts);
+#else
+  // Use the built-in zlib and AES-256-CTR codecs. They are selected with URI
+  // parameters and recorded in the database, so only the key is needed to reopen it.
+  const char *zPrefix = strncmp(azArg[1], "file:", 5)==0 ? "" : "file:";
+  const char *zSep = strchr(azArg[1], '?') ? "&" : "?";
+  size_t nDest = strlen(azArg[1]) + strlen(azArg[3]) + 64;
+  char *zDest = malloc(nDest);
+  if( zDest==NULL ) return EXIT_FAILURE;
+  snprintf(zDest, nDest, "%s%s%scompression=zlib&cipher=aes256-ctr&key=%s", zPrefix, azArg[1], zSep, azArg[3]);
+  rc = cevfs_build_v2(azArg[0], zDest, azArg[2], NULL, NULL, &opts);
+  free(zDest);
+#endif
+  if( rc!=0 ) fprintf(stderr, "cevfs_build failed with error %d%s\n", rc,
+                      rc==CEVFS_ERROR_BUILD_MISMATCH ? ": COMPRESSED was built from another source"
+                                                     : "; run again with -r to resume");
   return rc;
 }
@@ -0,0 +1,416 @@
+/**
+CEVFS
+Compression & Encryption VFS
+Built-in codecs
+
+Copyright (c) 2016 Ryan Homer, Murage Inc.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+** Compression and encryption methods that ship with CEVFS, so that a
+** database can be created and reopened without an xAutoDetect function.
+** They are selected with the compression and cipher URI parameters and
+** the choice is recorded in the cevfs header. This file is included by
+** cevfs.c.
+**
+**   zlib        always available unless CEVFS_OMIT_ZLIB is defined (-lz)
+**   lz4         needs CEVFS_ENABLE_LZ4 (-llz4)
+**   zstd        needs CEVFS_ENABLE_ZSTD (-lzstd)
+**   aes256-ctr  AES-256 in CTR mode with a random IV per page; uses AES-NI
+**               when the CPU has it. Needs a key=<64 hex digits> parameter.
+*/
+
+#ifndef CEVFS_OMIT_ZLIB
+#include <zlib.h>
+#endif
+#ifdef CEVFS_ENABLE_LZ4
+#include <lz4.h>
+#endif
+#ifdef CEVFS_ENABLE_ZSTD
+#include <zstd.h>
+#ifndef CEVFS_ZSTD_LEVEL
+#define CEVFS_ZSTD_LEVEL 3
+#endif
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CEVFS_HAVE_AESNI 1
+#include <wmmintrin.h>
+#endif
+
+#define CEVFS_AES_KEY_SZ       32
+#define CEVFS_AES_BLOCK_SZ     16
+#define CEVFS_AES_ROUNDS       14
+
+#ifndef CEVFS_OMIT_ZLIB
+static int cevfsZlibCompressBound(void *pCtx, size_t nByte){
+  return (int)compressBound((uLong)nByte);
+}
+
+static int cevfsZlibCompress(void *pCtx, char *aDest, size_t *pnDest, char *aSrc, size_t nSrc){
+  uLongf n = (uLongf)*pnDest;
+  int rc = compress((Bytef*)aDest, &n, (Bytef*)aSrc, (uLong)nSrc);
+  *pnDest = (size_t)n;
+  return rc==Z_OK;
+}
+
+static int cevfsZlibUncompress(void *pCtx, char *aDest, size_t *pnDest, char *aSrc, size_t nSrc){
+  uLongf n = (uLongf)*pnDest;
+  int rc = uncompress((Bytef*)aDest, &n, (Bytef*)aSrc, (uLong)nSrc);
+  *pnDest = (size_t)n;
+  return rc==Z_OK;
+}
+#endif
+
+#ifdef CEVFS_ENABLE_LZ4
+static int cevfsLz4CompressBound(void *pCtx, size_t nByte){
+  return LZ4_compressBound((int)nByte);
+}
+
+static int cevfsLz4Compress(void *pCtx, char *aDest, size_t *pnDest, char *aSrc, size_t nSrc){
+  int n = LZ4_compress_default(aSrc, aDest, (int)nSrc, (int)*pnDest);
+  if( n<=0 ) return 0;
+  *pnDest = (size_t)n;
+  return 1;
+}
+
+static int cevfsLz4Uncompress(void *pCtx, char *aDest, size_t *pnDest, char *aSrc, size_t nSrc){
+  int n = LZ4_decompress_safe(aSrc, aDest, (int)nSrc, (int)*pnDest);
+  if( n<0 ) return 0;
+  *pnDest = (size_t)n;
+  return 1;
+}
+#endif
+
+#ifdef CEVFS_ENABLE_ZSTD
+static int cevfsZstdCompressBound(void *pCtx, size_t nByte){
+  return (int)ZSTD_compressBound(nByte);
+}
+
+static int cevfsZstdCompress(void *pCtx, char *aDest, size_t *pnDest, char *aSrc, size_t nSrc){
+  size_t n = ZSTD_compress(aDest, *pnDest, aSrc, nSrc, CEVFS_ZSTD_LEVEL);
+  if( ZSTD_isError(n) ) return 0;
+  *pnDest = n;
+  return 1;
+}
+
+static int cevfsZstdUncompress(void *pCtx, char *aDest, size_t *pnDest, char *aSrc, size_t nSrc){
+  size_t n = ZSTD_decompress(aDest, *pnDest, aSrc, nSrc);
+  if( ZSTD_isError(n) ) return 0;
+  *pnDest = n;
+  return 1;
+}
+#endif
+
+/*
+** Expanded AES-256 encryption key. The round keys are laid out as in
+** FIPS-197, which is also the layout the AES-NI instructions expect.
+*/
+typedef struct CevfsAesCtx CevfsAesCtx;
+struct CevfsAesCtx {
+  u8 aRk[(CEVFS_AES_ROUNDS+1)*CEVFS_AES_BLOCK_SZ];
+  int bAesNi;                          // True to use the AES-NI code path
+};
+
+static const u8 cevfsAesSbox[256] = {
+  0x63,0x7c,0x77,0x7b,0xf2,0x6b,0x6f,0xc5,0x30,0x01,0x67,0x2b,0xfe,0xd7,0xab,0x76,
+  0xca,0x82,0xc9,0x7d,0xfa,0x59,0x47,0xf0,0xad,0xd4,0xa2,0xaf,0x9c,0xa4,0x72,0xc0,
+  0xb7,0xfd,0x93,0x26,0x36,0x3f,0xf7,0xcc,0x34,0xa5,0xe5,0xf1,0x71,0xd8,0x31,0x15,
+  0x04,0xc7,0x23,0xc3,0x18,0x96,0x05,0x9a,0x07,0x12,0x80,0xe2,0xeb,0x27,0xb2,0x75,
+  0x09,0x83,0x2c,0x1a,0x1b,0x6e,0x5a,0xa0,0x52,0x3b,0xd6,0xb3,0x29,0xe3,0x2f,0x84,
+  0x53,0xd1,0x00,0xed,0x20,0xfc,0xb1,0x5b,0x6a,0xcb,0xbe,0x39,0x4a,0x4c,0x58,0xcf,
+  0xd0,0xef,0xaa,0xfb,0x43,0x4d,0x33,0x85,0x45,0xf9,0x02,0x7f,0x50,0x3c,0x9f,0xa8,
+  0x51,0xa3,0x40,0x8f,0x92,0x9d,0x38,0xf5,0xbc,0xb6,0xda,0x21,0x10,0xff,0xf3,0xd2,
+  0xcd,0x0c,0x13,0xec,0x5f,0x97,0x44,0x17,0xc4,0xa7,0x7e,0x3d,0x64,0x5d,0x19,0x73,
+  0x60,0x81,0x4f,0xdc,0x22,0x2a,0x90,0x88,0x46,0xee,0xb8,0x14,0xde,0x5e,0x0b,0xdb,
+  0xe0,0x32,0x3a,0x0a,0x49,0x06,0x24,0x5c,0xc2,0xd3,0xac,0x62,0x91,0x95,0xe4,0x79,
+  0xe7,0xc8,0x37,0x6d,0x8d,0xd5,0x4e,0xa9,0x6c,0x56,0xf4,0xea,0x65,0x7a,0xae,0x08,
+  0xba,0x78,0x25,0x2e,0x1c,0xa6,0xb4,0xc6,0xe8,0xdd,0x74,0x1f,0x4b,0xbd,0x8b,0x8a,
+  0x70,0x3e,0xb5,0x66,0x48,0x03,0xf6,0x0e,0x61,0x35,0x57,0xb9,0x86,0xc1,0x1d,0x9e,
+  0xe1,0xf8,0x98,0x11,0x69,0xd9,0x8e,0x94,0x9b,0x1e,0x87,0xe9,0xce,0x55,0x28,0xdf,
+  0x8c,0xa1,0x89,0x0d,0xbf,0xe6,0x42,0x68,0x41,0x99,0x2d,0x0f,0xb0,0x54,0xbb,0x16
+};
+
+#define CEVFS_AES_XTIME(x) ((u8)(((x)<<1) ^ (((x)>>7)*0x1b)))
+
+static void cevfsAesExpandKey(const u8 *aKey, u8 *aRk){
+  static const u8 aRcon[7] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40 };
+  memcpy(aRk, aKey, CEVFS_AES_KEY_SZ);
+  for(int i=8; i<4*(CEVFS_AES_ROUNDS+1); i++){
+    u8 t[4];
+    memcpy(t, aRk+4*(i-1), 4);
+    if( i%8==0 ){
+      u8 t0 = t[0];
+      t[0] = cevfsAesSbox[t[1]] ^ aRcon[i/8-1];
+      t[1] = cevfsAesSbox[t[2]];
+      t[2] = cevfsAesSbox[t[3]];
+      t[3] = cevfsAesSbox[t0];
+    }else if( i%8==4 ){
+      for(int j=0; j<4; j++) t[j] = cevfsAesSbox[t[j]];
+    }
+    for(int j=0; j<4; j++) aRk[4*i+j] = aRk[4*(i-8)+j] ^ t[j];
+  }
+}
+
+/*
+** Portable single block encryption, used when AES-NI is not available.
+** The state is kept column by column, as in FIPS-197.
+*/
+static void cevfsAesEncryptBlock(const u8 *aRk, const u8 *aIn, u8 *aOut){
+  u8 s[16], t[16];
+  for(int i=0; i<16; i++) s[i] = aIn[i] ^ aRk[i];
+  for(int r=1; r<=CEVFS_AES_ROUNDS; r++){
+    // SubBytes and ShiftRows
+    for(int c=0; c<4; c++){
+      for(int row=0; row<4; row++) t[4*c+row] = cevfsAesSbox[s[4*((c+row)&3)+row]];
+    }
+    // MixColumns, skipped in the final round
+    if( r<CEVFS_AES_ROUNDS ){
+      for(int c=0; c<4; c++){
+        u8 a0 = t[4*c], a1 = t[4*c+1], a2 = t[4*c+2], a3 = t[4*c+3];
+        u8 all = a0^a1^a2^a3;
+        t[4*c]   = a0 ^ all ^ CEVFS_AES_XTIME(a0^a1);
+        t[4*c+1] = a1 ^ all ^ CEVFS_AES_XTIME(a1^a2);
+        t[4*c+2] = a2 ^ all ^ CEVFS_AES_XTIME(a2^a3);
+        t[4*c+3] = a3 ^ all ^ CEVFS_AES_XTIME(a3^a0);
+      }
+    }
+    for(int i=0; i<16; i++) s[i] = t[i] ^ aRk[16*r+i];
+  }
+  memcpy(aOut, s, 16);
+}
+
+// Increment a 128-bit big-endian counter block
+static void cevfsAesCtrInc(u8 *aCtr){
+  for(int i=15; i>=0 && ++aCtr[i]==0; i--);
+}
+
+#ifdef CEVFS_HAVE_AESNI
+/*
+** CTR mode with AES-NI, four blocks at a time to keep the AES unit busy.
+*/
+__attribute__((target("aes,sse2")))
+static void cevfsAesNiCtr(const u8 *aRk, u8 *aCtr, const u8 *aIn, u8 *aOut, size_t n){
+  __m128i k[CEVFS_AES_ROUNDS+1];
+  for(int i=0; i<=CEVFS_AES_ROUNDS; i++) k[i] = _mm_loadu_si128((const __m128i *)(aRk+16*i));
+
+  while( n>=64 ){
+    __m128i b[4];
+    for(int j=0; j<4; j++){
+      b[j] = _mm_xor_si128(_mm_loadu_si128((const __m128i *)aCtr), k[0]);
+      cevfsAesCtrInc(aCtr);
+    }
+    for(int r=1; r<CEVFS_AES_ROUNDS; r++){
+      for(int j=0; j<4; j++) b[j] = _mm_aesenc_si128(b[j], k[r]);
+    }
+    for(int j=0; j<4; j++){
+      b[j] = _mm_aesenclast_si128(b[j], k[CEVFS_AES_ROUNDS]);
+      b[j] = _mm_xor_si128(b[j], _mm_loadu_si128((const __m128i *)(aIn+16*j)));
+      _mm_storeu_si128((__m128i *)(aOut+16*j), b[j]);
+    }
+    aIn += 64;
+    aOut += 64;
+    n -= 64;
+  }
+  while( n>0 ){
+    u8 aKs[16];
+    size_t m = n<16 ? n : 16;
+    __m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i *)aCtr), k[0]);
+    for(int r=1; r<CEVFS_AES_ROUNDS; r++) b = _mm_aesenc_si128(b, k[r]);
+    _mm_storeu_si128((__m128i *)aKs, _mm_aesenclast_si128(b, k[CEVFS_AES_ROUNDS]));
+    for(size_t j=0; j<m; j++) aOut[j] = aIn[j] ^ aKs[j];
+    cevfsAesCtrInc(aCtr);
+    aIn += m;
+    aOut += m;
+    n -= m;
+  }
+}
+#endif
+
+/*
+** XOR n bytes of aIn with the key stream starting at counter block aIv.
+** Encryption and decryption are the same operation in CTR mode.
+*/
+static void cevfsAesCtr(const CevfsAesCtx *pAes, const u8 *aIv, const u8 *aIn, u8 *aOut, size_t n){
+  u8 aCtr[CEVFS_AES_BLOCK_SZ];
+  memcpy(aCtr, aIv, CEVFS_AES_BLOCK_SZ);
+#ifdef CEVFS_HAVE_AESNI
+  if( pAes->bAesNi ){
+    cevfsAesNiCtr(pAes->aRk, aCtr, aIn, aOut, n);
+    return;
+  }
+#endif
+  while( n>0 ){
+    u8 aKs[16];
+    size_t m = n<16 ? n : 16;
+    cevfsAesEncryptBlock(pAes->aRk, aCtr, aKs);
+    for(size_t j=0; j<m; j++) aOut[j] = aIn[j] ^ aKs[j];
+    cevfsAesCtrInc(aCtr);
+    aIn += m;
+    aOut += m;
+    n -= m;
+  }
+}
+
+static int cevfsAesEncrypt(
+  void *pCtx,
+  const void *pDataIn,
+  size_t nDataInSize,
+  void *pIvOut,
+  void **ppDataOut,
+  size_t *nDataSizeOut,
+  void *xMalloc(int n)
+){
+  u8 *aOut = xMalloc(nDataInSize>0 ? (int)nDataInSize : 1);
+  if( aOut==NULL ) return 0;
+  sqlite3_randomness(CEVFS_AES_BLOCK_SZ, pIvOut);
+  cevfsAesCtr((CevfsAesCtx *)pCtx, pIvOut, pDataIn, aOut, nDataInSize);
+  *ppDataOut = aOut;
+  *nDataSizeOut = nDataInSize;
+  return 1;
+}
+
+static int cevfsAesDecrypt(
+  void *pCtx,
+  const void *pDataIn,
+  size_t nDataInSize,
+  const void *pIvIn,
+  void *pDataOut,
+  size_t nDataBufferSizeOut,
+  size_t *nDataSizeOut
+){
+  if( nDataBufferSizeOut<nDataInSize ) return 0;
+  cevfsAesCtr((CevfsAesCtx *)pCtx, pIvIn, pDataIn, pDataOut, nDataInSize);
+  *nDataSizeOut = nDataInSize;
+  return 1;
+}
+
+/*
+** Parse a 256-bit key given as 64 hex digits, optionally as a blob
+** literal: x'<hex>'. Returns 0 if the key is malformed.
+*/
+static int cevfsParseKey(const char *zKey, u8 *aKey){
+  size_t n;
+  if( zKey==NULL ) return 0;
+  if( (zKey[0]=='x' || zKey[0]=='X') && zKey[1]=='\'' ) zKey += 2;
+  n = strlen(zKey);
+  if( n>0 && zKey[n-1]=='\'' ) n--;
+  if( n!=2*CEVFS_AES_KEY_SZ ) return 0;
+  for(size_t i=0; i<n; i++){
+    if( !sqlite3Isxdigit(zKey[i]) ) return 0;
+  }
+  for(int i=0; i<CEVFS_AES_KEY_SZ; i++){
+    aKey[i] = (sqlite3HexToInt(zKey[2*i])<<4) | sqlite3HexToInt(zKey[2*i+1]);
+  }
+  return 1;
+}
+
+/*
+** Map a compression or cipher URI parameter value to its codec id.
+** Returns -1 if the name is unknown or the codec was not compiled in.
+*/
+static int cevfsCodecFind(const char *zName, int bCipher){
+  if( bCipher ){
+    if( sqlite3StrICmp(zName, "aes256-ctr")==0 ) return CEVFS_CIPHER_AES256_CTR;
+  }else{
+#ifndef CEVFS_OMIT_ZLIB
+    if( sqlite3StrICmp(zName, "zlib")==0 ) return CEVFS_CODEC_ZLIB;
+#endif
+#ifdef CEVFS_ENABLE_LZ4
+    if( sqlite3StrICmp(zName, "lz4")==0 ) return CEVFS_CODEC_LZ4;
+#endif
+#ifdef CEVFS_ENABLE_ZSTD
+    if( sqlite3StrICmp(zName, "zstd")==0 ) return CEVFS_CODEC_ZSTD;
+#endif
+  }
+  return -1;
+}
+
+/*
+** Install the built-in compression methods for codec id cmprCodec.
+*/
+static int cevfsCodecInstallCompression(u8 cmprCodec, CevfsMethods *pMethods){
+  switch( cmprCodec ){
+#ifndef CEVFS_OMIT_ZLIB
+    case CEVFS_CODEC_ZLIB:
+      pMethods->xCompressBound = cevfsZlibCompressBound;
+      pMethods->xCompress = cevfsZlibCompress;
+      pMethods->xUncompress = cevfsZlibUncompress;
+      return SQLITE_OK;
+#endif
+#ifdef CEVFS_ENABLE_LZ4
+    case CEVFS_CODEC_LZ4:
+      pMethods->xCompressBound = cevfsLz4CompressBound;
+      pMethods->xCompress = cevfsLz4Compress;
+      pMethods->xUncompress = cevfsLz4Uncompress;
+      return SQLITE_OK;
+#endif
+#ifdef CEVFS_ENABLE_ZSTD
+    case CEVFS_CODEC_ZSTD:
+      pMethods->xCompressBound = cevfsZstdCompressBound;
+      pMethods->xCompress = cevfsZstdCompress;
+      pMethods->xUncompress = cevfsZstdUncompress;
+      return SQLITE_OK;
+#endif
+  }
+  return CEVFS_ERROR_UNKNOWN_CODEC;
+}
+
+/*
+** Install the built-in cipher encCodec keyed with zKey.
+** On success *ppCtx is the cipher context, to be freed with cevfsCodecFree().
+*/
+static int cevfsCodecInstallCipher(
+  u8 encCodec,
+  const char *zKey,
+  CevfsMethods *pMethods,
+  size_t *pEncIvSz,
+  void **ppCtx
+){
+  if( encCodec==CEVFS_CIPHER_AES256_CTR ){
+    u8 aKey[CEVFS_AES_KEY_SZ];
+    CevfsAesCtx *pAes;
+    if( !cevfsParseKey(zKey, aKey) ) return CEVFS_ERROR_MALFORMED_KEY;
+    if( (pAes = sqlite3_malloc(sizeof(CevfsAesCtx)))==NULL ) return SQLITE_NOMEM;
+    cevfsAesExpandKey(aKey, pAes->aRk);
+    memset(aKey, 0, sizeof(aKey));
+#ifdef CEVFS_HAVE_AESNI
+    pAes->bAesNi = __builtin_cpu_supports("aes")!=0;
+#else
+    pAes->bAesNi = 0;
+#endif
+    pMethods->xEncrypt = cevfsAesEncrypt;
+    pMethods->xDecrypt = cevfsAesDecrypt;
+    *pEncIvSz = CEVFS_AES_BLOCK_SZ;
+    *ppCtx = pAes;
+    return SQLITE_OK;
+  }
+  return CEVFS_ERROR_UNKNOWN_CODEC;
+}
+
+static void cevfsCodecFree(void *pCtx){
+  if( pCtx ){
+    memset(pCtx, 0, sizeof(CevfsAesCtx));
+    sqlite3_free(pCtx);
+  }
+}
@@ -0,0 +1,244 @@
+/**
+CEVFS - Compression & Encryption VFS
+cevfs_wal_test
+
+Copyright (c) 2016 Ryan Homer, Murage Inc.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+** Two connections sharing one CEVFS database.
+**
+** Usage: cevfs_wal_test [path]
+**
+** An idle connection must not block the other one's checkpoints, and each
+** connection must see the pages the other one checkpointed into the lower
+** file. Both are checked in WAL mode and then in rollback mode.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sqlite3.h"
+#include "cevfs.h"
+
+#define VFS_NAME "cevfs-test"
+#define ROWS 500
+
+static int nFail = 0;
+
+#define CHECK(cond, ...) do { \
+  if( !(cond) ){ \
+    fprintf(stderr, "FAIL line %d: ", __LINE__); \
+    fprintf(stderr, __VA_ARGS__); \
+    fputc('\n', stderr); \
+    nFail++; \
+  } \
+} while(0)
+
+static void removeFiles(const char *zPath){
+  char zBuf[1024];
+  unlink(zPath);
+  snprintf(zBuf, sizeof(zBuf), "%s-wal", zPath);
+  unlink(zBuf);
+  snprintf(zBuf, sizeof(zBuf), "%s-shm", zPath);
+  unlink(zBuf);
+  snprintf(zBuf, sizeof(zBuf), "%s-journal", zPath);
+  unlink(zBuf);
+}
+
+static sqlite3 *openDb(const char *zPath){
+  sqlite3 *db = NULL;
+  char *zUri = sqlite3_mprintf("file:%s?compression=zlib", zPath);
+  int rc = sqlite3_open_v2(zUri, &db,
+                           SQLITE_OPEN_READWRITE|SQLITE_OPEN_CREATE|SQLITE_OPEN_URI, VFS_NAME);
+  sqlite3_free(zUri);
+  CHECK(rc==SQLITE_OK, "open %s: %s", zPath, db ? sqlite3_errmsg(db) : "out of memory");
+  if( rc!=SQLITE_OK ){
+    sqlite3_close(db);
+    return NULL;
+  }
+  sqlite3_busy_timeout(db, 2000);
+  return db;
+}
+
+static int exec(sqlite3 *db, const char *zSql){
+  char *zErr = NULL;
+  int rc = sqlite3_exec(db, zSql, NULL, NULL, &zErr);
+  CHECK(rc==SQLITE_OK, "%s: %s", zSql, zErr ? zErr : sqlite3_errstr(rc));
+  sqlite3_free(zErr);
+  return rc;
+}
+
+/* First column of the first row as an integer, -1 on error */
+static sqlite3_int64 scalar(sqlite3 *db, const char *zSql){
+  sqlite3_stmt *pStmt = NULL;
+  sqlite3_int64 v = -1;
+  int rc = sqlite3_prepare_v2(db, zSql, -1, &pStmt, NULL);
+  if( rc==SQLITE_OK && (rc = sqlite3_step(pStmt))==SQLITE_ROW ){
+    v = sqlite3_column_int64(pStmt, 0);
+    rc = SQLITE_OK;
+  }
+  CHECK(rc==SQLITE_OK || rc==SQLITE_DONE, "%s: %s", zSql, sqlite3_errmsg(db));
+  sqlite3_finalize(pStmt);
+  return v;
+}
+
+static void checkIntegrity(sqlite3 *db, const char *zWho){
+  sqlite3_stmt *pStmt = NULL;
+  const char *zRes = NULL;
+  if( sqlite3_prepare_v2(db, "PRAGMA integrity_check", -1, &pStmt, NULL)==SQLITE_OK
+   && sqlite3_step(pStmt)==SQLITE_ROW ){
+    zRes = (const char *)sqlite3_column_text(pStmt, 0);
+  }
+  CHECK(zRes && strcmp(zRes, "ok")==0, "%s integrity_check: %s", zWho, zRes ? zRes : sqlite3_errmsg(db));
+  sqlite3_finalize(pStmt);
+}
+
+/* Connections agree on the row count and the total payload */
+static void checkSame(sqlite3 *pA, sqlite3 *pB, sqlite3_int64 nRows){
+  sqlite3_int64 nA = scalar(pA, "SELECT count(*) FROM t");
+  sqlite3_int64 nB = scalar(pB, "SELECT count(*) FROM t");
+  sqlite3_int64 szA = scalar(pA, "SELECT sum(length(x)) FROM t");
+  sqlite3_int64 szB = scalar(pB, "SELECT sum(length(x)) FROM t");
+  CHECK(nA==nRows, "A sees %lld rows, expected %lld", nA, nRows);
+  CHECK(nB==nRows, "B sees %lld rows, expected %lld", nB, nRows);
+  CHECK(szA==szB, "A sees %lld bytes, B sees %lld", szA, szB);
+}
+
+static void insertRows(sqlite3 *db, int nFrom){
+  char zSql[256];
+  snprintf(zSql, sizeof(zSql),
+           "WITH RECURSIVE n(i) AS (SELECT %d UNION ALL SELECT i+1 FROM n WHERE i<%d) "
+           "INSERT INTO t SELECT i, printf('%%.*c', 100 + i %% 300, 'x') FROM n",
+           nFrom, nFrom + ROWS - 1);
+  exec(db, zSql);
+}
+
+/* wal_checkpoint returns (busy, log, checkpointed); busy must be 0 */
+static void checkpoint(sqlite3 *db, const char *zWho){
+  sqlite3_int64 busy = scalar(db, "PRAGMA wal_checkpoint(TRUNCATE)");
+  CHECK(busy==0, "%s checkpoint was blocked (busy=%lld)", zWho, busy);
+}
+
+static void testWal(const char *zPath){
+  sqlite3 *pA, *pB;
+  removeFiles(zPath);
+
+  if( (pA = openDb(zPath))==NULL ) return;
+  CHECK(scalar(pA, "SELECT journal_mode='wal' FROM pragma_journal_mode('wal')")==1,
+        "journal_mode=WAL was not set");
+  exec(pA, "CREATE TABLE t(id INTEGER PRIMARY KEY, x TEXT)");
+  insertRows(pA, 1);
+
+  if( (pB = openDb(zPath))==NULL ){
+    sqlite3_close(pA);
+    return;
+  }
+  checkSame(pA, pB, ROWS);
+
+  // B is idle: A's checkpoint must get through, and B must read what it wrote
+  insertRows(pA, ROWS + 1);
+  checkpoint(pA, "A");
+  checkSame(pA, pB, 2 * ROWS);
+
+  // Same the other way round, with pages rewritten rather than appended
+  exec(pB, "UPDATE t SET x = x || 'yy' WHERE id % 3 = 0");
+  exec(pB, "DELETE FROM t WHERE id % 7 = 0");
+  checkpoint(pB, "B");
+  CHECK(scalar(pA, "SELECT count(*) FROM t WHERE id % 7 = 0")==0, "A still sees deleted rows");
+  checkSame(pA, pB, 2 * ROWS - (2 * ROWS) / 7);
+  checkIntegrity(pA, "A");
+  checkIntegrity(pB, "B");
+
+  // Closing B must leave the WAL to A
+  sqlite3_close(pB);
+  insertRows(pA, 2 * ROWS + 1);
+  CHECK(scalar(pA, "SELECT count(*) FROM t")==3 * ROWS - (2 * ROWS) / 7, "A lost rows after B closed");
+  sqlite3_close(pA);
+
+  if( (pA = openDb(zPath))==NULL ) return;
+  CHECK(scalar(pA, "SELECT count(*) FROM t")==3 * ROWS - (2 * ROWS) / 7, "rows lost on reopen");
+  checkIntegrity(pA, "reopened");
+  sqlite3_close(pA);
+  removeFiles(zPath);
+}
+
+static void testRollback(const char *zPath){
+  sqlite3 *pA, *pB;
+  removeFiles(zPath);
+
+  if( (pA = openDb(zPath))==NULL ) return;
+  exec(pA, "CREATE TABLE t(id INTEGER PRIMARY KEY, x TEXT)");
+  insertRows(pA, 1);
+
+  if( (pB = openDb(zPath))==NULL ){
+    sqlite3_close(pA);
+    return;
+  }
+  checkSame(pA, pB, ROWS);
+
+  // Each commit must be visible to the other connection's next read
+  insertRows(pB, ROWS + 1);
+  checkSame(pA, pB, 2 * ROWS);
+  exec(pA, "UPDATE t SET x = substr(x, 1, 50) WHERE id % 2 = 0");
+  checkSame(pA, pB, 2 * ROWS);
+
+  // A reader inside a transaction keeps the writer out until it is done
+  exec(pB, "BEGIN");
+  CHECK(scalar(pB, "SELECT count(*) FROM t")==2 * ROWS, "B read failed");
+  sqlite3_busy_timeout(pA, 0);
+  CHECK(sqlite3_exec(pA, "DELETE FROM t WHERE id > 10", NULL, NULL, NULL)==SQLITE_BUSY,
+        "A wrote under B's read transaction");
+  exec(pB, "COMMIT");
+  sqlite3_busy_timeout(pA, 2000);
+  exec(pA, "DELETE FROM t WHERE id > 10");
+  checkSame(pA, pB, 10);
+  checkIntegrity(pA, "A");
+  checkIntegrity(pB, "B");
+
+  sqlite3_close(pB);
+  sqlite3_close(pA);
+  removeFiles(zPath);
+}
+
+int main(int argc, const char *argv[]){
+  const char *zPath = argc>1 ? argv[1] : "cevfs_wal_test.db";
+  int rc;
+
+  if( (rc = cevfs_create_vfs(VFS_NAME, NULL, NULL, NULL, 0))!=SQLITE_OK ){
+    fprintf(stderr, "cevfs_create_vfs: %d\n", rc);
+    return 1;
+  }
+
+  testWal(zPath);
+  testRollback(zPath);
+
+  cevfs_destroy_vfs(VFS_NAME);
+  if( nFail ){
+    fprintf(stderr, "%d check(s) failed\n", nFail);
+    return 1;
+  }
+  fputs("Done\n", stdout);
+  return 0;
+}
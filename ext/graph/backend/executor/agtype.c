@@ -5,7 +5,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <stdarg.h>
 #include "executor/agtype.h"
 #include "parser/cypher_debug.h"
 
@@ -13,86 +12,6 @@
 static int load_node_properties(sqlite3 *db, int64_t node_id, agtype_pair **pairs, int *num_pairs);
 static int load_edge_properties(sqlite3 *db, int64_t edge_id, agtype_pair **pairs, int *num_pairs);
 
-/* Dynamic string buffer for safe JSON building */
-typedef struct {
-    char *data;
-    size_t len;
-    size_t capacity;
-} strbuf;
-
-static void strbuf_init(strbuf *sb, size_t initial_capacity)
-{
-    sb->capacity = initial_capacity > 64 ? initial_capacity : 64;
-    sb->data = malloc(sb->capacity);
-    sb->len = 0;
-    if (sb->data) sb->data[0] = '\0';
-}
-
-static void strbuf_free(strbuf *sb)
-{
-    free(sb->data);
-    sb->data = NULL;
-    sb->len = 0;
-    sb->capacity = 0;
-}
-
-static int strbuf_ensure(strbuf *sb, size_t additional)
-{
-    if (!sb->data) return -1;
-    size_t needed = sb->len + additional + 1;
-    if (needed <= sb->capacity) return 0;
-
-    size_t new_cap = sb->capacity * 2;
-    while (new_cap < needed) new_cap *= 2;
-
-    char *new_data = realloc(sb->data, new_cap);
-    if (!new_data) return -1;
-
-    sb->data = new_data;
-    sb->capacity = new_cap;
-    return 0;
-}
-
-static int strbuf_append(strbuf *sb, const char *str)
-{
-    if (!str) return 0;
-    size_t slen = strlen(str);
-    if (strbuf_ensure(sb, slen) != 0) return -1;
-    memcpy(sb->data + sb->len, str, slen + 1);
-    sb->len += slen;
-    return 0;
-}
-
-static int strbuf_appendf(strbuf *sb, const char *fmt, ...)
-{
-    va_list args, args_copy;
-    va_start(args, fmt);
-    va_copy(args_copy, args);
-
-    int needed = vsnprintf(NULL, 0, fmt, args);
-    va_end(args);
-
-    if (needed < 0 || strbuf_ensure(sb, needed) != 0) {
-        va_end(args_copy);
-        return -1;
-    }
-
-    vsnprintf(sb->data + sb->len, needed + 1, fmt, args_copy);
-    sb->len += needed;
-    va_end(args_copy);
-    return 0;
-}
-
-/* Take ownership of the buffer data (caller must free) */
-static char* strbuf_take(strbuf *sb)
-{
-    char *data = sb->data;
-    sb->data = NULL;
-    sb->len = 0;
-    sb->capacity = 0;
-    return data;
-}
-
 /* Create a NULL agtype value */
 agtype_value* agtype_value_create_null(void)
 {
@@ -265,197 +184,6 @@ agtype_value* agtype_value_create_edge_with_properties(sqlite3 *db, int64_t id,
     return val;
 }
 
-/* Parse a JSON string like {"id":1,"labels":["L"],"properties":{"k":"v"}} into a vertex agtype */
-agtype_value* agtype_value_from_vertex_json(sqlite3 *db, const char *json)
-{
-    if (!json || json[0] != '{') return NULL;
-
-    /* Use SQLite's JSON functions to extract values */
-    sqlite3_stmt *stmt;
-    int64_t id = 0;
-    char *label = NULL;
-    agtype_pair *pairs = NULL;
-    int num_pairs = 0;
-
-    /* Extract id */
-    const char *id_sql = "SELECT json_extract(?, '$.id')";
-    if (sqlite3_prepare_v2(db, id_sql, -1, &stmt, NULL) == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, json, -1, SQLITE_STATIC);
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            id = sqlite3_column_int64(stmt, 0);
-        }
-        sqlite3_finalize(stmt);
-    }
-
-    /* Extract labels array as JSON string (e.g., '["A","B","C"]') */
-    const char *label_sql = "SELECT json_extract(?, '$.labels')";
-    if (sqlite3_prepare_v2(db, label_sql, -1, &stmt, NULL) == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, json, -1, SQLITE_STATIC);
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            const char *label_text = (const char*)sqlite3_column_text(stmt, 0);
-            if (label_text) {
-                label = strdup(label_text);
-            }
-        }
-        sqlite3_finalize(stmt);
-    }
-
-    /* Extract properties as key/value pairs — use json_each type column to detect arrays/objects */
-    const char *props_sql = "SELECT key, value, type FROM json_each(json_extract(?, '$.properties'))";
-    if (sqlite3_prepare_v2(db, props_sql, -1, &stmt, NULL) == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, json, -1, SQLITE_STATIC);
-
-        /* Count pairs first */
-        int count = 0;
-        while (sqlite3_step(stmt) == SQLITE_ROW) count++;
-        sqlite3_reset(stmt);
-
-        if (count > 0) {
-            pairs = malloc(count * sizeof(agtype_pair));
-            num_pairs = 0;
-
-            while (sqlite3_step(stmt) == SQLITE_ROW) {
-                const char *key = (const char*)sqlite3_column_text(stmt, 0);
-                const char *val_text = (const char*)sqlite3_column_text(stmt, 1);
-                const char *json_type = (const char*)sqlite3_column_text(stmt, 2);
-
-                pairs[num_pairs].key = agtype_value_create_string(key);
-
-                if (json_type && (strcmp(json_type, "array") == 0 || strcmp(json_type, "object") == 0)) {
-                    pairs[num_pairs].value = agtype_value_create_json(val_text);
-                } else if (json_type && strcmp(json_type, "true") == 0) {
-                    pairs[num_pairs].value = agtype_value_create_bool(true);
-                } else if (json_type && strcmp(json_type, "false") == 0) {
-                    pairs[num_pairs].value = agtype_value_create_bool(false);
-                } else if (json_type && strcmp(json_type, "integer") == 0) {
-                    pairs[num_pairs].value = agtype_value_create_integer(sqlite3_column_int64(stmt, 1));
-                } else if (json_type && strcmp(json_type, "real") == 0) {
-                    pairs[num_pairs].value = agtype_value_create_float(sqlite3_column_double(stmt, 1));
-                } else if (json_type && strcmp(json_type, "null") == 0) {
-                    pairs[num_pairs].value = agtype_value_create_null();
-                } else {
-                    pairs[num_pairs].value = agtype_value_create_string(val_text ? val_text : "");
-                }
-                num_pairs++;
-            }
-        }
-        sqlite3_finalize(stmt);
-    }
-
-    /* Create the vertex value — label is already a JSON array string */
-    agtype_value *val = malloc(sizeof(agtype_value));
-    if (!val) {
-        for (int i = 0; i < num_pairs; i++) {
-            agtype_value_free(pairs[i].key);
-            agtype_value_free(pairs[i].value);
-        }
-        free(pairs);
-        free(label);
-        return NULL;
-    }
-    val->type = AGTV_VERTEX;
-    val->val.entity.id = id;
-    val->val.entity.label = label ? label : strdup("[]");
-    val->val.entity.num_pairs = 0;
-    val->val.entity.pairs = NULL;
-
-    if (num_pairs > 0) {
-        val->val.entity.pairs = pairs;
-        val->val.entity.num_pairs = num_pairs;
-    } else if (pairs) {
-        free(pairs);
-    }
-
-    /* label ownership transferred to val, don't free */
-    return val;
-}
-
-/* Parse a JSON string like {"id":1,"type":"T","startNodeId":1,"endNodeId":2,"properties":{}} into an edge agtype */
-agtype_value* agtype_value_from_edge_json(sqlite3 *db, const char *json)
-{
-    if (!json || json[0] != '{') return NULL;
-
-    sqlite3_stmt *stmt;
-    int64_t id = 0, start_id = 0, end_id = 0;
-    char *type = NULL;
-    agtype_pair *pairs = NULL;
-    int num_pairs = 0;
-
-    /* Extract id, type, startNodeId, endNodeId */
-    const char *edge_sql = "SELECT json_extract(?, '$.id'), json_extract(?, '$.type'), "
-                          "json_extract(?, '$.startNodeId'), json_extract(?, '$.endNodeId')";
-    if (sqlite3_prepare_v2(db, edge_sql, -1, &stmt, NULL) == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, json, -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 2, json, -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 3, json, -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 4, json, -1, SQLITE_STATIC);
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            id = sqlite3_column_int64(stmt, 0);
-            const char *type_text = (const char*)sqlite3_column_text(stmt, 1);
-            if (type_text) type = strdup(type_text);
-            start_id = sqlite3_column_int64(stmt, 2);
-            end_id = sqlite3_column_int64(stmt, 3);
-        }
-        sqlite3_finalize(stmt);
-    }
-
-    /* Extract properties — use json_each type column to detect arrays/objects */
-    const char *props_sql = "SELECT key, value, type FROM json_each(json_extract(?, '$.properties'))";
-    if (sqlite3_prepare_v2(db, props_sql, -1, &stmt, NULL) == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, json, -1, SQLITE_STATIC);
-
-        int count = 0;
-        while (sqlite3_step(stmt) == SQLITE_ROW) count++;
-        sqlite3_reset(stmt);
-
-        if (count > 0) {
-            pairs = malloc(count * sizeof(agtype_pair));
-            num_pairs = 0;
-
-            while (sqlite3_step(stmt) == SQLITE_ROW) {
-                const char *key = (const char*)sqlite3_column_text(stmt, 0);
-                const char *val_text = (const char*)sqlite3_column_text(stmt, 1);
-                const char *json_type = (const char*)sqlite3_column_text(stmt, 2);
-
-                pairs[num_pairs].key = agtype_value_create_string(key);
-
-                if (json_type && (strcmp(json_type, "array") == 0 || strcmp(json_type, "object") == 0)) {
-                    pairs[num_pairs].value = agtype_value_create_json(val_text);
-                } else if (json_type && strcmp(json_type, "true") == 0) {
-                    pairs[num_pairs].value = agtype_value_create_bool(true);
-                } else if (json_type && strcmp(json_type, "false") == 0) {
-                    pairs[num_pairs].value = agtype_value_create_bool(false);
-                } else if (json_type && strcmp(json_type, "integer") == 0) {
-                    pairs[num_pairs].value = agtype_value_create_integer(sqlite3_column_int64(stmt, 1));
-                } else if (json_type && strcmp(json_type, "real") == 0) {
-                    pairs[num_pairs].value = agtype_value_create_float(sqlite3_column_double(stmt, 1));
-                } else if (json_type && strcmp(json_type, "null") == 0) {
-                    pairs[num_pairs].value = agtype_value_create_null();
-                } else {
-                    pairs[num_pairs].value = agtype_value_create_string(val_text ? val_text : "");
-                }
-                num_pairs++;
-            }
-        }
-        sqlite3_finalize(stmt);
-    }
-
-    agtype_value *val = agtype_value_create_edge(id, type, start_id, end_id);
-    if (val && num_pairs > 0) {
-        val->val.edge.pairs = pairs;
-        val->val.edge.num_pairs = num_pairs;
-    } else if (pairs) {
-        for (int i = 0; i < num_pairs; i++) {
-            agtype_value_free(pairs[i].key);
-            agtype_value_free(pairs[i].value);
-        }
-        free(pairs);
-    }
-
-    free(type);
-    return val;
-}
-
 /* Deep copy an agtype value */
 agtype_value* agtype_value_copy(agtype_value *src)
 {
@@ -904,184 +632,130 @@ static int load_edge_properties(sqlite3 *db, int64_t edge_id, agtype_pair **pair
     return 0;
 }
 
-/* Convert agtype value to AGE-compatible string representation */
-char* agtype_value_to_string(agtype_value *val)
+/* Append a quoted string; control characters other than \n, \r and \t become spaces */
+static void agtype_write_string(json_builder *jb, const char *src, int src_len)
 {
-    if (!val) return strdup("null");
-    
-    char *result = NULL;
-    
+    jbuf_append_char(jb, '"');
+    int run = 0;
+    for (int i = 0; i < src_len; i++) {
+        unsigned char c = (unsigned char)src[i];
+        if (c != '"' && c != '\\' && c >= 32) {
+            continue;
+        }
+
+        /* Copy the unescaped run before this character in one go */
+        jbuf_append_len(jb, src + run, i - run);
+        run = i + 1;
+        switch (c) {
+            case '"':  jbuf_append(jb, "\\\""); break;
+            case '\\': jbuf_append(jb, "\\\\"); break;
+            case '\n': jbuf_append(jb, "\\n"); break;
+            case '\r': jbuf_append(jb, "\\r"); break;
+            case '\t': jbuf_append(jb, "\\t"); break;
+            default:   jbuf_append_char(jb, ' '); break;
+        }
+    }
+    jbuf_append_len(jb, src + run, src_len - run);
+    jbuf_append_char(jb, '"');
+}
+
+/* Append "key": value pairs of a vertex or edge */
+static void agtype_write_pairs(json_builder *jb, agtype_pair *pairs, int num_pairs)
+{
+    for (int i = 0; i < num_pairs; i++) {
+        if (pairs[i].key && pairs[i].value) {
+            if (i > 0) jbuf_append(jb, ", ");
+            agtype_value_write(jb, pairs[i].key);
+            jbuf_append(jb, ": ");
+            agtype_value_write(jb, pairs[i].value);
+        }
+    }
+}
+
+/* Serialize an agtype value in AGE-compatible form straight into a builder */
+void agtype_value_write(json_builder *jb, agtype_value *val)
+{
+    if (!val) {
+        jbuf_append(jb, "null");
+        return;
+    }
+
+    char num[32];
+
     switch (val->type) {
         case AGTV_NULL:
-            result = strdup("null");
+            jbuf_append(jb, "null");
             break;
-            
-        case AGTV_STRING: {
-            /* Quote the string with proper JSON escaping */
-            const char *src = val->val.string.val;
-            int src_len = val->val.string.len;
-
-            /* Count how many characters need escaping */
-            int escape_count = 0;
-            for (int i = 0; i < src_len; i++) {
-                unsigned char c = (unsigned char)src[i];
-                if (c == '"' || c == '\\' || c < 32) {
-                    escape_count++;
-                }
-            }
 
-            /* Allocate: original + escapes + quotes + null */
-            result = malloc(src_len + escape_count + 3);
-            if (result) {
-                char *dst = result;
-                *dst++ = '"';
-                for (int i = 0; i < src_len; i++) {
-                    unsigned char c = (unsigned char)src[i];
-                    if (c == '"') {
-                        *dst++ = '\\';
-                        *dst++ = '"';
-                    } else if (c == '\\') {
-                        *dst++ = '\\';
-                        *dst++ = '\\';
-                    } else if (c == '\n') {
-                        *dst++ = '\\';
-                        *dst++ = 'n';
-                    } else if (c == '\r') {
-                        *dst++ = '\\';
-                        *dst++ = 'r';
-                    } else if (c == '\t') {
-                        *dst++ = '\\';
-                        *dst++ = 't';
-                    } else if (c < 32) {
-                        /* Skip other control characters */
-                        *dst++ = ' ';
-                    } else {
-                        *dst++ = c;
-                    }
-                }
-                *dst++ = '"';
-                *dst = '\0';
-            }
+        case AGTV_STRING:
+            agtype_write_string(jb, val->val.string.val, val->val.string.len);
             break;
-        }
-            
-        case AGTV_INTEGER: {
-            result = malloc(32);
-            if (result) {
-                snprintf(result, 32, "%lld", (long long)val->val.int_value);
-            }
+
+        case AGTV_INTEGER:
+            snprintf(num, sizeof(num), "%lld", (long long)val->val.int_value);
+            jbuf_append(jb, num);
             break;
-        }
-        
-        case AGTV_FLOAT: {
-            result = malloc(32);
-            if (result) {
-                snprintf(result, 32, "%.10g", val->val.float_value);
-            }
+
+        case AGTV_FLOAT:
+            snprintf(num, sizeof(num), "%.10g", val->val.float_value);
+            jbuf_append(jb, num);
             break;
-        }
-        
+
         case AGTV_BOOL:
-            result = strdup(val->val.boolean ? "true" : "false");
+            jbuf_append(jb, val->val.boolean ? "true" : "false");
             break;
 
         case AGTV_JSON:
             /* Raw JSON — output without quoting */
-            result = strdup(val->val.string.val);
+            jbuf_append(jb, val->val.string.val);
             break;
 
-        case AGTV_VERTEX: {
+        case AGTV_VERTEX:
             /* OpenCypher format: {"id": 123, "labels": ["Person"], "properties": {"name": "Alice"}} */
-            strbuf sb;
-            strbuf_init(&sb, 256);
-
             /* Use "labels" as array per OpenCypher spec — entity.label stores JSON array string */
-            strbuf_appendf(&sb, "{\"id\": %lld, \"labels\": %s, \"properties\": {",
+            jbuf_appendf(jb, "{\"id\": %lld, \"labels\": %s, \"properties\": {",
                 (long long)val->val.entity.id,
-                (val->val.entity.label && strlen(val->val.entity.label) > 0) ? val->val.entity.label : "[]");
-
-            /* Add properties with safe dynamic appending */
-            for (int i = 0; i < val->val.entity.num_pairs; i++) {
-                if (val->val.entity.pairs[i].key && val->val.entity.pairs[i].value) {
-                    if (i > 0) strbuf_append(&sb, ", ");
-
-                    char *key_str = agtype_value_to_string(val->val.entity.pairs[i].key);
-                    char *value_str = agtype_value_to_string(val->val.entity.pairs[i].value);
-                    if (key_str && value_str) {
-                        strbuf_append(&sb, key_str);
-                        strbuf_append(&sb, ": ");
-                        strbuf_append(&sb, value_str);
-                    }
-                    free(key_str);
-                    free(value_str);
-                }
-            }
-
-            strbuf_append(&sb, "}}");
-            result = strbuf_take(&sb);
+                (val->val.entity.label && val->val.entity.label[0]) ? val->val.entity.label : "[]");
+            agtype_write_pairs(jb, val->val.entity.pairs, val->val.entity.num_pairs);
+            jbuf_append(jb, "}}");
             break;
-        }
-        
-        case AGTV_EDGE: {
-            /* OpenCypher format: {"id": 123, "type": "KNOWS", "startNode": 456, "endNode": 789, "properties": {...}} */
-            strbuf sb;
-            strbuf_init(&sb, 256);
 
-            /* Use "type" instead of "label", and "startNode"/"endNode" per OpenCypher */
-            strbuf_appendf(&sb,
+        case AGTV_EDGE:
+            /* OpenCypher format: {"id": 123, "type": "KNOWS", "startNode": 456, "endNode": 789, "properties": {...}} */
+            jbuf_appendf(jb,
                 "{\"id\": %lld, \"type\": \"%s\", \"startNode\": %lld, \"endNode\": %lld, \"properties\": {",
                 (long long)val->val.edge.id,
                 val->val.edge.label ? val->val.edge.label : "",
                 (long long)val->val.edge.start_id,
                 (long long)val->val.edge.end_id);
-
-            /* Add properties with safe dynamic appending */
-            for (int i = 0; i < val->val.edge.num_pairs; i++) {
-                if (val->val.edge.pairs[i].key && val->val.edge.pairs[i].value) {
-                    if (i > 0) strbuf_append(&sb, ", ");
-
-                    char *key_str = agtype_value_to_string(val->val.edge.pairs[i].key);
-                    char *value_str = agtype_value_to_string(val->val.edge.pairs[i].value);
-                    if (key_str && value_str) {
-                        strbuf_append(&sb, key_str);
-                        strbuf_append(&sb, ": ");
-                        strbuf_append(&sb, value_str);
-                    }
-                    free(key_str);
-                    free(value_str);
-                }
-            }
-
-            strbuf_append(&sb, "}}");
-            result = strbuf_take(&sb);
+            agtype_write_pairs(jb, val->val.edge.pairs, val->val.edge.num_pairs);
+            jbuf_append(jb, "}}");
             break;
-        }
-        
-        case AGTV_PATH: {
-            /* Path as JSON array of alternating vertices and edges */
-            strbuf sb;
-            strbuf_init(&sb, 256);
-            strbuf_append(&sb, "[");
 
+        case AGTV_PATH:
+            /* Path as JSON array of alternating vertices and edges */
+            jbuf_append_char(jb, '[');
             for (int i = 0; i < val->val.array.num_elems; i++) {
-                if (i > 0) strbuf_append(&sb, ", ");
-
-                char *elem_str = agtype_value_to_string(&val->val.array.elems[i]);
-                if (elem_str) {
-                    strbuf_append(&sb, elem_str);
-                    free(elem_str);
-                }
+                if (i > 0) jbuf_append(jb, ", ");
+                agtype_value_write(jb, &val->val.array.elems[i]);
             }
-
-            strbuf_append(&sb, "]");
-            result = strbuf_take(&sb);
+            jbuf_append_char(jb, ']');
             break;
-        }
-        
+
         default:
-            result = strdup("undefined");
+            jbuf_append(jb, "undefined");
             break;
     }
-    
-    return result ? result : strdup("null");
-}
\ No newline at end of file
+}
+
+/* Convert agtype value to AGE-compatible string representation */
+char* agtype_value_to_string(agtype_value *val)
+{
+    json_builder jb;
+    jbuf_init(&jb, 256);
+    agtype_value_write(&jb, val);
+    if (!jbuf_ok(&jb)) {
+        return strdup("null");
+    }
+    return jbuf_take(&jb);
+}
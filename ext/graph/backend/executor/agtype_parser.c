@@ -0,0 +1,480 @@
+/*
+ * AGType JSON parser - builds vertex and edge values from the JSON objects
+ * generated SQL returns for RETURN n / RETURN r
+ *
+ * The scanner walks the text in place: strings, numbers and nested
+ * arrays/objects are slices of the input, and only the final agtype values
+ * are allocated (one block per value, strings decoded straight into it).
+ * Property values match what json_each() reports: arrays and objects are
+ * kept as raw JSON, integers that do not fit in 64 bits become floats.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "executor/agtype.h"
+#include "parser/cypher_debug.h"
+
+typedef enum {
+    JSON_NULL,
+    JSON_TRUE,
+    JSON_FALSE,
+    JSON_INTEGER,
+    JSON_REAL,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT
+} json_type;
+
+/* A value in the input text; strings exclude their quotes */
+typedef struct {
+    json_type type;
+    const char *start;
+    size_t len;
+    bool escaped;  /* string contains backslash escapes */
+} json_slice;
+
+typedef struct {
+    const char *p;
+    const char *end;
+} json_scanner;
+
+static void json_skip_ws(json_scanner *sc)
+{
+    while (sc->p < sc->end && (*sc->p == ' ' || *sc->p == '\t' || *sc->p == '\n' || *sc->p == '\r')) {
+        sc->p++;
+    }
+}
+
+/* Scan a string body after its opening quote */
+static bool json_scan_string(json_scanner *sc, json_slice *out)
+{
+    out->type = JSON_STRING;
+    out->start = sc->p;
+    out->escaped = false;
+    while (sc->p < sc->end) {
+        char c = *sc->p;
+        if (c == '"') {
+            out->len = sc->p - out->start;
+            sc->p++;
+            return true;
+        }
+        if (c == '\\') {
+            out->escaped = true;
+            sc->p++;
+        }
+        sc->p++;
+    }
+    return false;
+}
+
+/* Skip a whole array or object, tracking strings so brackets inside them don't count */
+static bool json_skip_container(json_scanner *sc)
+{
+    int depth = 0;
+    while (sc->p < sc->end) {
+        char c = *sc->p++;
+        if (c == '[' || c == '{') {
+            depth++;
+        } else if (c == ']' || c == '}') {
+            if (--depth == 0) {
+                return true;
+            }
+        } else if (c == '"') {
+            json_slice ignored;
+            if (!json_scan_string(sc, &ignored)) {
+                return false;
+            }
+        }
+    }
+    return false;
+}
+
+static bool json_scan_literal(json_scanner *sc, const char *word, json_type type, json_slice *out)
+{
+    size_t len = strlen(word);
+    if ((size_t)(sc->end - sc->p) < len || memcmp(sc->p, word, len) != 0) {
+        return false;
+    }
+    out->type = type;
+    out->start = sc->p;
+    out->len = len;
+    sc->p += len;
+    return true;
+}
+
+/* Scan the next value */
+static bool json_scan_value(json_scanner *sc, json_slice *out)
+{
+    json_skip_ws(sc);
+    if (sc->p >= sc->end) {
+        return false;
+    }
+
+    char c = *sc->p;
+    switch (c) {
+        case '"':
+            sc->p++;
+            return json_scan_string(sc, out);
+        case '[':
+        case '{':
+            out->type = c == '[' ? JSON_ARRAY : JSON_OBJECT;
+            out->start = sc->p;
+            if (!json_skip_container(sc)) {
+                return false;
+            }
+            out->len = sc->p - out->start;
+            return true;
+        case 'n':
+            return json_scan_literal(sc, "null", JSON_NULL, out);
+        case 't':
+            return json_scan_literal(sc, "true", JSON_TRUE, out);
+        case 'f':
+            return json_scan_literal(sc, "false", JSON_FALSE, out);
+        default:
+            break;
+    }
+
+    if (c != '-' && (c < '0' || c > '9')) {
+        return false;
+    }
+    out->type = JSON_INTEGER;
+    out->start = sc->p++;
+    while (sc->p < sc->end) {
+        c = *sc->p;
+        if (c == '.' || c == 'e' || c == 'E') {
+            out->type = JSON_REAL;
+        } else if ((c < '0' || c > '9') && c != '-' && c != '+') {
+            break;
+        }
+        sc->p++;
+    }
+    out->len = sc->p - out->start;
+    return true;
+}
+
+/* Start iterating the members of the object slice */
+static bool json_object_open(json_scanner *sc, const json_slice *object)
+{
+    if (object->type != JSON_OBJECT) {
+        return false;
+    }
+    sc->p = object->start + 1;
+    sc->end = object->start + object->len - 1;
+    return true;
+}
+
+/* Next "key": value member; returns 1 for a member, 0 at the end, -1 on malformed input */
+static int json_object_next(json_scanner *sc, json_slice *key, json_slice *value)
+{
+    json_skip_ws(sc);
+    if (sc->p < sc->end && *sc->p == ',') {
+        sc->p++;
+        json_skip_ws(sc);
+    }
+    if (sc->p >= sc->end) {
+        return 0;
+    }
+    if (*sc->p != '"') {
+        return -1;
+    }
+    sc->p++;
+    if (!json_scan_string(sc, key)) {
+        return -1;
+    }
+    json_skip_ws(sc);
+    if (sc->p >= sc->end || *sc->p != ':') {
+        return -1;
+    }
+    sc->p++;
+    return json_scan_value(sc, value) ? 1 : -1;
+}
+
+static int json_hex4(const char *p)
+{
+    int v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= c - '0';
+        else if (c >= 'a' && c <= 'f') v |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v |= c - 'A' + 10;
+        else return -1;
+    }
+    return v;
+}
+
+/* Decode a string slice into dst (room for s->len + 1 bytes); returns the decoded length */
+static int json_decode_string(const json_slice *s, char *dst)
+{
+    if (!s->escaped) {
+        memcpy(dst, s->start, s->len);
+        dst[s->len] = '\0';
+        return (int)s->len;
+    }
+
+    const char *p = s->start;
+    const char *end = s->start + s->len;
+    char *out = dst;
+    while (p < end) {
+        if (*p != '\\' || p + 1 >= end) {
+            *out++ = *p++;
+            continue;
+        }
+        p++;
+        char c = *p++;
+        switch (c) {
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                int cp = end - p >= 4 ? json_hex4(p) : -1;
+                if (cp < 0) {
+                    *out++ = 'u';
+                    break;
+                }
+                p += 4;
+                /* Surrogate pair */
+                if (cp >= 0xD800 && cp <= 0xDBFF && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                    int lo = json_hex4(p + 2);
+                    if (lo >= 0xDC00 && lo <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                        p += 6;
+                    }
+                }
+                /* \uXXXX takes 6 input bytes; its UTF-8 form at most 4 */
+                if (cp < 0x80) {
+                    *out++ = (char)cp;
+                } else if (cp < 0x800) {
+                    *out++ = (char)(0xC0 | (cp >> 6));
+                    *out++ = (char)(0x80 | (cp & 0x3F));
+                } else if (cp < 0x10000) {
+                    *out++ = (char)(0xE0 | (cp >> 12));
+                    *out++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    *out++ = (char)(0x80 | (cp & 0x3F));
+                } else {
+                    *out++ = (char)(0xF0 | (cp >> 18));
+                    *out++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+                    *out++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    *out++ = (char)(0x80 | (cp & 0x3F));
+                }
+                break;
+            }
+            default:
+                /* \" \\ \/ */
+                *out++ = c;
+                break;
+        }
+    }
+    *out = '\0';
+    return (int)(out - dst);
+}
+
+/* Decoded copy of a string slice */
+static char* json_slice_strdup(const json_slice *s)
+{
+    char *str = malloc(s->len + 1);
+    if (str) {
+        json_decode_string(s, str);
+    }
+    return str;
+}
+
+static bool json_key_is(const json_slice *key, const char *name)
+{
+    return !key->escaped && key->len == strlen(name) && memcmp(key->start, name, key->len) == 0;
+}
+
+static int64_t json_slice_int(const json_slice *s)
+{
+    return s->type == JSON_INTEGER || s->type == JSON_REAL ? strtoll(s->start, NULL, 10) : 0;
+}
+
+/* agtype value of a property slice */
+static agtype_value* agtype_from_slice(const json_slice *s)
+{
+    agtype_value *val;
+
+    switch (s->type) {
+        case JSON_NULL:
+            return agtype_value_create_null();
+        case JSON_TRUE:
+        case JSON_FALSE:
+            return agtype_value_create_bool(s->type == JSON_TRUE);
+        case JSON_INTEGER: {
+            errno = 0;
+            long long v = strtoll(s->start, NULL, 10);
+            if (errno != ERANGE) {
+                return agtype_value_create_integer((int64_t)v);
+            }
+            return agtype_value_create_float(strtod(s->start, NULL));
+        }
+        case JSON_REAL:
+            return agtype_value_create_float(strtod(s->start, NULL));
+        case JSON_STRING:
+        case JSON_ARRAY:
+        case JSON_OBJECT:
+            val = malloc(sizeof(agtype_value));
+            if (!val) return NULL;
+            val->val.string.val = malloc(s->len + 1);
+            if (!val->val.string.val) {
+                free(val);
+                return NULL;
+            }
+            if (s->type == JSON_STRING) {
+                val->type = AGTV_STRING;
+                val->val.string.len = json_decode_string(s, val->val.string.val);
+            } else {
+                /* Nested arrays and objects stay raw JSON */
+                val->type = AGTV_JSON;
+                memcpy(val->val.string.val, s->start, s->len);
+                val->val.string.val[s->len] = '\0';
+                val->val.string.len = (int)s->len;
+            }
+            return val;
+    }
+    return NULL;
+}
+
+/* Key/value pairs of a properties object; *pairs is NULL when there are none */
+static int parse_property_pairs(const json_slice *object, agtype_pair **pairs, int *num_pairs)
+{
+    json_scanner sc;
+    json_slice key, value;
+    int count = 0, rc;
+
+    *pairs = NULL;
+    *num_pairs = 0;
+    if (!json_object_open(&sc, object)) {
+        return 0;
+    }
+
+    /* Count first so the pairs are a single allocation */
+    while ((rc = json_object_next(&sc, &key, &value)) > 0) {
+        count++;
+    }
+    if (rc < 0) {
+        return -1;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    *pairs = malloc(count * sizeof(agtype_pair));
+    if (!*pairs) {
+        return -1;
+    }
+
+    json_object_open(&sc, object);
+    while (json_object_next(&sc, &key, &value) > 0) {
+        agtype_pair *pair = &(*pairs)[*num_pairs];
+        pair->key = malloc(sizeof(agtype_value));
+        if (pair->key) {
+            pair->key->type = AGTV_STRING;
+            pair->key->val.string.val = malloc(key.len + 1);
+            if (pair->key->val.string.val) {
+                pair->key->val.string.len = json_decode_string(&key, pair->key->val.string.val);
+            } else {
+                free(pair->key);
+                pair->key = NULL;
+            }
+        }
+        pair->value = agtype_from_slice(&value);
+        (*num_pairs)++;
+    }
+    return 0;
+}
+
+/* Parse a JSON string like {"id":1,"labels":["L"],"properties":{"k":"v"}} into a vertex agtype */
+agtype_value* agtype_value_from_vertex_json(sqlite3 *db, const char *json)
+{
+    (void)db;
+    if (!json || json[0] != '{') return NULL;
+
+    json_slice top = { JSON_OBJECT, json, strlen(json), false };
+    json_slice key, value, labels = { JSON_NULL, NULL, 0, false }, props = { JSON_NULL, NULL, 0, false };
+    json_scanner sc;
+    int64_t id = 0;
+    int rc;
+
+    json_object_open(&sc, &top);
+    while ((rc = json_object_next(&sc, &key, &value)) > 0) {
+        if (json_key_is(&key, "id")) {
+            id = json_slice_int(&value);
+        } else if (json_key_is(&key, "labels")) {
+            labels = value;
+        } else if (json_key_is(&key, "properties")) {
+            props = value;
+        }
+    }
+    if (rc < 0) {
+        CYPHER_DEBUG("agtype_value_from_vertex_json: malformed JSON: %s", json);
+        return NULL;
+    }
+
+    agtype_value *val = malloc(sizeof(agtype_value));
+    if (!val) return NULL;
+    val->type = AGTV_VERTEX;
+    val->val.entity.id = id;
+
+    /* Labels stay a JSON array string */
+    if (labels.type == JSON_ARRAY) {
+        val->val.entity.label = malloc(labels.len + 1);
+        if (val->val.entity.label) {
+            memcpy(val->val.entity.label, labels.start, labels.len);
+            val->val.entity.label[labels.len] = '\0';
+        }
+    } else {
+        val->val.entity.label = strdup("[]");
+    }
+
+    parse_property_pairs(&props, &val->val.entity.pairs, &val->val.entity.num_pairs);
+    return val;
+}
+
+/* Parse a JSON string like {"id":1,"type":"T","startNodeId":1,"endNodeId":2,"properties":{}} into an edge agtype */
+agtype_value* agtype_value_from_edge_json(sqlite3 *db, const char *json)
+{
+    (void)db;
+    if (!json || json[0] != '{') return NULL;
+
+    json_slice top = { JSON_OBJECT, json, strlen(json), false };
+    json_slice key, value, type = { JSON_NULL, NULL, 0, false }, props = { JSON_NULL, NULL, 0, false };
+    json_scanner sc;
+    int64_t id = 0, start_id = 0, end_id = 0;
+    int rc;
+
+    json_object_open(&sc, &top);
+    while ((rc = json_object_next(&sc, &key, &value)) > 0) {
+        if (json_key_is(&key, "id")) {
+            id = json_slice_int(&value);
+        } else if (json_key_is(&key, "type")) {
+            type = value;
+        } else if (json_key_is(&key, "startNodeId")) {
+            start_id = json_slice_int(&value);
+        } else if (json_key_is(&key, "endNodeId")) {
+            end_id = json_slice_int(&value);
+        } else if (json_key_is(&key, "properties")) {
+            props = value;
+        }
+    }
+    if (rc < 0) {
+        CYPHER_DEBUG("agtype_value_from_edge_json: malformed JSON: %s", json);
+        return NULL;
+    }
+
+    agtype_value *val = malloc(sizeof(agtype_value));
+    if (!val) return NULL;
+    val->type = AGTV_EDGE;
+    val->val.edge.id = id;
+    val->val.edge.label = type.type == JSON_STRING ? json_slice_strdup(&type) : NULL;
+    val->val.edge.start_id = start_id;
+    val->val.edge.end_id = end_id;
+
+    parse_property_pairs(&props, &val->val.edge.pairs, &val->val.edge.num_pairs);
+    return val;
+}
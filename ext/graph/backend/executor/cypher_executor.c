@@ -14,7 +14,9 @@
 #include "executor/cypher_executor.h"
 #include "executor/executor_internal.h"
 #include "executor/query_patterns.h"
+#include "executor/plan_cache.h"
 #include "executor/graph_algorithms.h"
+#include "executor/varlen_paths.h"
 #include "parser/cypher_debug.h"
 
 /* SQLite custom function: REVERSE(string) - reverses a string */
@@ -60,6 +62,11 @@ static int register_custom_functions(sqlite3 *db)
     if (rc != SQLITE_OK) {
         return -1;
     }
+
+    /* Variable-length relationship traversal used by generated SQL */
+    if (varlen_paths_register(db) != SQLITE_OK) {
+        return -1;
+    }
     return 0;
 }
 
@@ -109,6 +116,9 @@ cypher_executor* cypher_executor_create(sqlite3 *db)
     }
     
     executor->schema_initialized = true;
+
+    /* Plan cache is optional - queries run uncached if it can't be created */
+    executor->plan_cache = plan_cache_create(db, GRAPHQLITE_PLAN_CACHE_SIZE);
     
     CYPHER_DEBUG("Created cypher executor with initialized schema");
     
@@ -121,6 +131,7 @@ void cypher_executor_free(cypher_executor *executor)
         return;
     }
     
+    plan_cache_free(executor->plan_cache);
     cypher_schema_free_manager(executor->schema_mgr);
     free(executor);
     
@@ -366,51 +377,69 @@ cypher_result* cypher_executor_execute(cypher_executor *executor, const char *qu
     clock_gettime(CLOCK_MONOTONIC, &t_start);
 #endif
 
-    /* Parse query to AST with extended error handling */
-    CYPHER_DEBUG("Parsing query: '%s'", query);
-    cypher_parse_result *parse_result = parse_cypher_query_ext(query);
-    if (!parse_result) {
-        CYPHER_DEBUG("Parser returned NULL");
-        cypher_result *result = create_empty_result();
-        if (result) {
-            set_result_error(result, "Internal parser error");
+    /* Repeated query text skips parsing (and, for reads, SQL generation) */
+    cypher_plan *plan = plan_cache_lookup(executor->plan_cache, query, executor->params_json);
+    cypher_parse_result *parse_result = NULL;
+
+    if (!plan) {
+        /* Parse query to AST with extended error handling */
+        CYPHER_DEBUG("Parsing query: '%s'", query);
+        parse_result = parse_cypher_query_ext(query);
+        if (!parse_result) {
+            CYPHER_DEBUG("Parser returned NULL");
+            cypher_result *result = create_empty_result();
+            if (result) {
+                set_result_error(result, "Internal parser error");
+            }
+            return result;
         }
-        return result;
-    }
 
-    /* Check for parse errors */
-    if (!parse_result->ast) {
-        CYPHER_DEBUG("Parser error: %s", parse_result->error_message ? parse_result->error_message : "Unknown error");
-        cypher_result *result = create_empty_result();
-        if (result) {
-            /* Use the detailed parser error message */
-            set_result_error(result, parse_result->error_message ? parse_result->error_message : "Failed to parse query");
+        /* Check for parse errors */
+        if (!parse_result->ast) {
+            CYPHER_DEBUG("Parser error: %s", parse_result->error_message ? parse_result->error_message : "Unknown error");
+            cypher_result *result = create_empty_result();
+            if (result) {
+                /* Use the detailed parser error message */
+                set_result_error(result, parse_result->error_message ? parse_result->error_message : "Failed to parse query");
+            }
+            cypher_parse_result_free(parse_result);
+            return result;
+        }
+
+        /* Cache takes ownership of the parse result on success */
+        plan = plan_cache_insert(executor->plan_cache, query, parse_result);
+        if (plan) {
+            parse_result = NULL;
         }
-        cypher_parse_result_free(parse_result);
-        return result;
     }
 
 #ifdef GRAPHQLITE_PERF_TIMING
     clock_gettime(CLOCK_MONOTONIC, &t_parse);
 #endif
 
-    ast_node *ast = parse_result->ast;
+    ast_node *ast = plan ? plan->parse->ast : parse_result->ast;
 
     CYPHER_DEBUG("Parser returned AST with type=%d, data=%p", ast->type, ast->data);
 
-    /* Execute AST */
+    /* Execute AST (nested cypher() calls save and restore the active plan) */
+    struct cypher_plan *outer_plan = executor->active_plan;
+    executor->active_plan = plan;
     cypher_result *result = cypher_executor_execute_ast(executor, ast);
+    executor->active_plan = outer_plan;
 
 #ifdef GRAPHQLITE_PERF_TIMING
     clock_gettime(CLOCK_MONOTONIC, &t_exec);
 #endif
 
-    /* Clean up parse result (includes AST) - note: don't free AST separately */
-    parse_result->ast = NULL;  /* Prevent double-free since execute_ast may have taken ownership */
-    cypher_parse_result_free(parse_result);
+    if (plan) {
+        plan_cache_release(executor->plan_cache, plan);
+    } else {
+        /* Clean up parse result (includes AST) */
+        cypher_parse_result_free(parse_result);
+    }
 
-    /* Clean up AST */
-    cypher_parser_free_result(ast);
+    /* Write statements are reused within a query, not held across calls */
+    cypher_schema_end_query(executor->schema_mgr);
 
 #ifdef GRAPHQLITE_PERF_TIMING
     clock_gettime(CLOCK_MONOTONIC, &t_cleanup);
@@ -462,6 +491,7 @@ cypher_result* cypher_executor_execute_ast_params(cypher_executor *executor, ast
 
     /* Execute the AST */
     cypher_result *result = cypher_executor_execute_ast(executor, ast);
+    cypher_schema_end_query(executor->schema_mgr);
 
     /* Clear params */
     executor->params_json = NULL;
@@ -469,6 +499,204 @@ cypher_result* cypher_executor_execute_ast_params(cypher_executor *executor, ast
     return result;
 }
 
+/* Open a row cursor; read-only results are left in the statement rather than collected */
+cypher_cursor* cypher_executor_open_cursor(cypher_executor *executor, const char *query, const char *params_json)
+{
+    cypher_cursor *cursor = calloc(1, sizeof(cypher_cursor));
+    if (!cursor) {
+        return NULL;
+    }
+    cursor->executor = executor;
+    cursor->row = -1;
+
+    cypher_cursor *outer = executor ? executor->stream : NULL;
+    if (executor) {
+        executor->stream = cursor;
+    }
+    cursor->result = cypher_executor_execute_params(executor, query, params_json);
+    if (executor) {
+        executor->stream = outer;
+    }
+
+    if (!cursor->result) {
+        cypher_cursor_close(cursor);
+        return NULL;
+    }
+    if (!cursor->result->success && cursor->stmt) {
+        sqlite3_finalize(cursor->stmt);
+        cursor->stmt = NULL;
+    }
+    return cursor;
+}
+
+int cypher_cursor_next(cypher_cursor *cursor)
+{
+    if (!cursor || !cursor->result || !cursor->result->success) {
+        return -1;
+    }
+
+    if (cursor->stmt) {
+        int rc = sqlite3_step(cursor->stmt);
+        if (rc == SQLITE_ROW) {
+            cursor->row++;
+            return 1;
+        }
+        if (rc != SQLITE_DONE) {
+            set_result_error(cursor->result, sqlite3_errmsg(cursor->executor->db));
+        }
+        /* Finished statements would restart on the next step */
+        sqlite3_finalize(cursor->stmt);
+        cursor->stmt = NULL;
+        return rc == SQLITE_DONE ? 0 : -1;
+    }
+
+    if (cursor->kinds || cursor->row + 1 >= cursor->result->row_count) {
+        return 0;
+    }
+    cursor->row++;
+    return 1;
+}
+
+/* SQL value of a scalar agtype value; entities give their id */
+static void result_agtype_scalar(sqlite3_context *context, agtype_value *value)
+{
+    switch (value->type) {
+        case AGTV_INTEGER:
+            sqlite3_result_int64(context, value->val.int_value);
+            break;
+        case AGTV_FLOAT:
+            sqlite3_result_double(context, value->val.float_value);
+            break;
+        case AGTV_BOOL:
+            sqlite3_result_int(context, value->val.boolean ? 1 : 0);
+            break;
+        case AGTV_STRING:
+        case AGTV_JSON:
+            sqlite3_result_text(context, value->val.string.val, value->val.string.len, SQLITE_TRANSIENT);
+            break;
+        case AGTV_VERTEX:
+            sqlite3_result_int64(context, value->val.entity.id);
+            break;
+        case AGTV_EDGE:
+            sqlite3_result_int64(context, value->val.edge.id);
+            break;
+        default:
+            sqlite3_result_null(context);
+            break;
+    }
+}
+
+/* Id of a streamed node or edge column: the leading "id" of its JSON object, or the bare id */
+static void result_stream_entity_id(sqlite3_context *context, sqlite3_stmt *stmt, int col)
+{
+    if (sqlite3_column_type(stmt, col) != SQLITE_TEXT) {
+        sqlite3_result_value(context, sqlite3_column_value(stmt, col));
+        return;
+    }
+    const char *text = (const char*)sqlite3_column_text(stmt, col);
+    const char *id = text[0] == '{' ? strstr(text, "\"id\":") : NULL;
+    sqlite3_result_int64(context, id ? strtoll(id + 5, NULL, 10) : strtoll(text, NULL, 10));
+}
+
+/* Typed SQL value of a column of the current row */
+void cypher_cursor_column_value(cypher_cursor *cursor, int col, sqlite3_context *context)
+{
+    cypher_result *result = cursor->result;
+
+    if (cursor->stmt) {
+        sqlite3_stmt *stmt = cursor->stmt;
+        switch (cursor->kinds[col]) {
+            case CYPHER_COLUMN_NODE:
+            case CYPHER_COLUMN_EDGE:
+                result_stream_entity_id(context, stmt, col);
+                return;
+            case CYPHER_COLUMN_PROPERTY:
+                if (sqlite3_column_type(stmt, col) == SQLITE_TEXT) {
+                    /* Property access yields text; type it as cypher() does */
+                    agtype_value *value = create_property_agtype_value((const char*)sqlite3_column_text(stmt, col));
+                    if (value) {
+                        result_agtype_scalar(context, value);
+                        agtype_value_free(value);
+                    } else {
+                        sqlite3_result_error_nomem(context);
+                    }
+                    return;
+                }
+                break;
+            default:
+                break;
+        }
+        sqlite3_result_value(context, sqlite3_column_value(stmt, col));
+        return;
+    }
+
+    if (cursor->row < 0 || cursor->row >= result->row_count) {
+        sqlite3_result_null(context);
+        return;
+    }
+
+    /* Non-entity agtype columns are plain strings; the SQL type is more precise */
+    agtype_value *value = result->agtype_data ? result->agtype_data[cursor->row][col] : NULL;
+    if (value && value->type != AGTV_STRING) {
+        result_agtype_scalar(context, value);
+        return;
+    }
+
+    const char *text = result->data ? result->data[cursor->row][col] : NULL;
+    int type = result->data_types && result->data_types[cursor->row] ?
+               result->data_types[cursor->row][col] : SQLITE_TEXT;
+    if (!text) {
+        sqlite3_result_null(context);
+    } else if (type == SQLITE_INTEGER) {
+        sqlite3_result_int64(context, strtoll(text, NULL, 10));
+    } else if (type == SQLITE_FLOAT) {
+        sqlite3_result_double(context, strtod(text, NULL));
+    } else {
+        sqlite3_result_text(context, text, -1, SQLITE_TRANSIENT);
+    }
+}
+
+/* agtype JSON of a node, edge or path column of the current row; NULL for other values */
+char* cypher_cursor_column_json(cypher_cursor *cursor, int col)
+{
+    cypher_result *result = cursor->result;
+
+    if (cursor->stmt) {
+        cypher_column_kind kind = cursor->kinds[col];
+        const char *text = (const char*)sqlite3_column_text(cursor->stmt, col);
+        if (!text || (kind != CYPHER_COLUMN_NODE && kind != CYPHER_COLUMN_EDGE)) {
+            return NULL;
+        }
+        agtype_value *entity = kind == CYPHER_COLUMN_NODE ? result_vertex_value(cursor->executor, text)
+                                                          : result_edge_value(cursor->executor, text);
+        char *json = entity ? agtype_value_to_string(entity) : NULL;
+        agtype_value_free(entity);
+        return json;
+    }
+
+    if (cursor->row < 0 || cursor->row >= result->row_count || !result->agtype_data) {
+        return NULL;
+    }
+    agtype_value *value = result->agtype_data[cursor->row][col];
+    if (!value || (value->type != AGTV_VERTEX && value->type != AGTV_EDGE && value->type != AGTV_PATH)) {
+        return NULL;
+    }
+    return agtype_value_to_string(value);
+}
+
+void cypher_cursor_close(cypher_cursor *cursor)
+{
+    if (!cursor) {
+        return;
+    }
+    if (cursor->stmt) {
+        sqlite3_finalize(cursor->stmt);
+    }
+    free(cursor->kinds);
+    cypher_result_free(cursor->result);
+    free(cursor);
+}
+
 /* Free result */
 void cypher_result_free(cypher_result *result)
 {
@@ -178,6 +178,129 @@ const char* CYPHER_SCHEMA_INDEX_NODE_PROPS_JSON =
 const char* CYPHER_SCHEMA_INDEX_EDGE_PROPS_JSON =
     "CREATE INDEX IF NOT EXISTS idx_edge_props_json_key_value ON edge_props_json(key_id, edge_id)";
 
+/* Property type catalog */
+
+static const char *CYPHER_SCHEMA_DDL_PROPERTY_KEY_TYPES =
+    "CREATE TABLE property_key_types ("
+    "  key_id INTEGER NOT NULL,"
+    "  owner TEXT NOT NULL,"              /* 'node' or 'edge' */
+    "  type TEXT NOT NULL,"               /* typed table suffix: int, text, ... */
+    "  PRIMARY KEY (key_id, owner, type)"
+    ") WITHOUT ROWID";
+
+static const char *CYPHER_SCHEMA_DDL_PROPERTY_CATALOG =
+    "CREATE TABLE property_catalog ("
+    "  id INTEGER PRIMARY KEY CHECK (id = 1),"
+    "  version INTEGER NOT NULL"
+    ");"
+    "INSERT INTO property_catalog (id, version) VALUES (1, random());"
+    "CREATE TRIGGER property_keys_catalog AFTER INSERT ON property_keys "
+    "BEGIN UPDATE property_catalog SET version = random(); END";
+
+/* Typed table suffixes, indexed by property_type */
+static const char *const prop_table_suffix[] = {
+    [PROP_TYPE_INTEGER] = "int",
+    [PROP_TYPE_TEXT]    = "text",
+    [PROP_TYPE_REAL]    = "real",
+    [PROP_TYPE_BOOLEAN] = "bool",
+    [PROP_TYPE_JSON]    = "json",
+};
+
+/* Cached write statements */
+
+#define PROP_TABLE_SQL(base, owner, head, tail) \
+    [base + PROP_TYPE_INTEGER] = head owner "_props_int" tail, \
+    [base + PROP_TYPE_TEXT]    = head owner "_props_text" tail, \
+    [base + PROP_TYPE_REAL]    = head owner "_props_real" tail, \
+    [base + PROP_TYPE_BOOLEAN] = head owner "_props_bool" tail, \
+    [base + PROP_TYPE_JSON]    = head owner "_props_json" tail
+
+/* Type probe: one row per typed table holding the key, tagged with its property_type */
+#define PROP_TYPES_SQL(owner) \
+    "SELECT 0 FROM " owner "_props_int WHERE " owner "_id = ?1 AND key_id = ?2 " \
+    "UNION ALL SELECT 1 FROM " owner "_props_text WHERE " owner "_id = ?1 AND key_id = ?2 " \
+    "UNION ALL SELECT 2 FROM " owner "_props_real WHERE " owner "_id = ?1 AND key_id = ?2 " \
+    "UNION ALL SELECT 3 FROM " owner "_props_bool WHERE " owner "_id = ?1 AND key_id = ?2 " \
+    "UNION ALL SELECT 4 FROM " owner "_props_json WHERE " owner "_id = ?1 AND key_id = ?2"
+
+static const char *const schema_stmt_sql[SCHEMA_STMT_COUNT] = {
+    [SCHEMA_STMT_KEY_LOOKUP]   = "SELECT id FROM property_keys WHERE key = ?",
+    [SCHEMA_STMT_KEY_INSERT]   = "INSERT INTO property_keys (key) VALUES (?)",
+    [SCHEMA_STMT_NODE_INSERT]  = "INSERT INTO nodes DEFAULT VALUES",
+    [SCHEMA_STMT_NODE_DELETE]  = "DELETE FROM nodes WHERE id = ?",
+    [SCHEMA_STMT_LABEL_INSERT] = "INSERT OR IGNORE INTO node_labels (node_id, label) VALUES (?, ?)",
+    [SCHEMA_STMT_LABEL_DELETE] = "DELETE FROM node_labels WHERE node_id = ? AND label = ?",
+    [SCHEMA_STMT_LABEL_EXISTS] = "SELECT 1 FROM node_labels WHERE node_id = ? AND label = ? LIMIT 1",
+    [SCHEMA_STMT_EDGE_INSERT]  = "INSERT INTO edges (source_id, target_id, type) VALUES (?, ?, ?)",
+    [SCHEMA_STMT_EDGE_DELETE]  = "DELETE FROM edges WHERE id = ?",
+    [SCHEMA_STMT_CATALOG_VERSION] = "SELECT version FROM property_catalog",
+
+    [SCHEMA_STMT_NODE_PROP_TYPES] = PROP_TYPES_SQL("node"),
+    [SCHEMA_STMT_EDGE_PROP_TYPES] = PROP_TYPES_SQL("edge"),
+
+    PROP_TABLE_SQL(SCHEMA_STMT_NODE_PROP_SET, "node",
+                   "INSERT OR REPLACE INTO ", " (node_id, key_id, value) VALUES (?, ?, ?)"),
+    PROP_TABLE_SQL(SCHEMA_STMT_NODE_PROP_DELETE, "node",
+                   "DELETE FROM ", " WHERE node_id = ? AND key_id = ?"),
+    PROP_TABLE_SQL(SCHEMA_STMT_NODE_PROP_CLEAR, "node",
+                   "DELETE FROM ", " WHERE node_id = ?"),
+    PROP_TABLE_SQL(SCHEMA_STMT_EDGE_PROP_SET, "edge",
+                   "INSERT OR REPLACE INTO ", " (edge_id, key_id, value) VALUES (?, ?, ?)"),
+    PROP_TABLE_SQL(SCHEMA_STMT_EDGE_PROP_DELETE, "edge",
+                   "DELETE FROM ", " WHERE edge_id = ? AND key_id = ?"),
+    PROP_TABLE_SQL(SCHEMA_STMT_EDGE_PROP_CLEAR, "edge",
+                   "DELETE FROM ", " WHERE edge_id = ?"),
+};
+
+/* Get a cached statement, preparing it on first use */
+static sqlite3_stmt* schema_stmt(cypher_schema_manager *manager, schema_stmt_kind kind)
+{
+    sqlite3_stmt *stmt = manager->stmts[kind];
+    if (stmt) {
+        manager->stmt_reuses++;
+        return stmt;
+    }
+
+    int rc = sqlite3_prepare_v2(manager->db, schema_stmt_sql[kind], -1, &stmt, NULL);
+    if (rc != SQLITE_OK) {
+        CYPHER_DEBUG("Failed to prepare schema statement %d: %s", kind, sqlite3_errmsg(manager->db));
+        return NULL;
+    }
+
+    manager->stmts[kind] = stmt;
+    manager->stmt_prepares++;
+    return stmt;
+}
+
+/* Reset a cached statement so it holds no locks or borrowed bindings */
+static void schema_stmt_done(sqlite3_stmt *stmt)
+{
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+}
+
+/* Step a write statement once and reset it; returns the step result */
+static int schema_stmt_run(sqlite3_stmt *stmt)
+{
+    int rc = sqlite3_step(stmt);
+    schema_stmt_done(stmt);
+    return rc;
+}
+
+void cypher_schema_release_statements(cypher_schema_manager *manager)
+{
+    if (!manager) {
+        return;
+    }
+
+    for (int i = 0; i < SCHEMA_STMT_COUNT; i++) {
+        if (manager->stmts[i]) {
+            sqlite3_finalize(manager->stmts[i]);
+            manager->stmts[i] = NULL;
+        }
+    }
+}
+
 /* Property key cache implementation */
 
 property_key_cache* create_property_key_cache(sqlite3 *db, int slot_count)
@@ -206,9 +329,10 @@ property_key_cache* create_property_key_cache(sqlite3 *db, int slot_count)
 }
 
 /* Prepare cache statements after schema initialization */
-/* Note: Statements are now prepared locally in each function to avoid
- * keeping prepared statements open, which prevents sqlite3_close() from
- * succeeding when the connection is closed. */
+/* Note: Statements live on the schema manager (schema_stmt) and are
+ * finalized by cypher_schema_release_statements() after each query;
+ * keeping them open would prevent sqlite3_close() from succeeding when
+ * the connection is closed. */
 int prepare_property_key_cache_statements(property_key_cache *cache, sqlite3 *db)
 {
     UNUSED_PARAMETER(cache);
@@ -217,22 +341,27 @@ int prepare_property_key_cache_statements(property_key_cache *cache, sqlite3 *db
     return 0;
 }
 
-void free_property_key_cache(property_key_cache *cache)
+/* Drop every cached key (ids may have been rolled back) */
+static void clear_property_key_cache(property_key_cache *cache)
 {
-    if (!cache) {
-        return;
-    }
-    
-    /* Free all cached entries - for now just free individual entries */
-    /* TODO: Implement proper linked list structure */
     for (int i = 0; i < cache->slot_count; i++) {
         property_key_entry *entry = cache->slots[i];
         if (entry) {
             free(entry->key_string);
             free(entry);
+            cache->slots[i] = NULL;
         }
     }
+}
+
+void free_property_key_cache(property_key_cache *cache)
+{
+    if (!cache) {
+        return;
+    }
     
+    clear_property_key_cache(cache);
+
     if (cache->lookup_stmt) {
         sqlite3_finalize(cache->lookup_stmt);
     }
@@ -275,9 +404,12 @@ void cypher_schema_free_manager(cypher_schema_manager *manager)
         return;
     }
     
-    CYPHER_DEBUG("Freeing schema manager %p", (void*)manager);
+    CYPHER_DEBUG("Freeing schema manager %p (%ld statement prepares, %ld reuses)",
+                 (void*)manager, manager->stmt_prepares, manager->stmt_reuses);
     
+    cypher_schema_release_statements(manager);
     free_property_key_cache(manager->key_cache);
+    free(manager->key_types);
     free(manager);
 }
 
@@ -365,6 +497,340 @@ int cypher_schema_create_indexes(cypher_schema_manager *manager)
     return 0;
 }
 
+int cypher_schema_drop_indexes(cypher_schema_manager *manager)
+{
+    /* idx_property_keys_key stays: key lookups run throughout a load */
+    static const char *indexes[] = {
+        "idx_edges_source", "idx_edges_target", "idx_edges_type",
+        "idx_node_labels_label",
+        "idx_node_props_int_key_value", "idx_node_props_text_key_value",
+        "idx_node_props_real_key_value", "idx_node_props_bool_key_value",
+        "idx_edge_props_int_key_value", "idx_edge_props_text_key_value",
+        "idx_edge_props_real_key_value", "idx_edge_props_bool_key_value",
+        "idx_node_props_json_key_value", "idx_edge_props_json_key_value",
+    };
+
+    if (!manager || !manager->db) {
+        return -1;
+    }
+
+    CYPHER_DEBUG("Dropping database indexes");
+
+    for (size_t i = 0; i < sizeof(indexes) / sizeof(indexes[0]); i++) {
+        char sql[96];
+        snprintf(sql, sizeof(sql), "DROP INDEX IF EXISTS %s", indexes[i]);
+        if (execute_ddl(manager->db, sql, indexes[i]) < 0) return -1;
+    }
+    return 0;
+}
+
+static bool table_exists(sqlite3 *db, const char *name)
+{
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ?",
+                           -1, &stmt, NULL) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+    bool exists = (sqlite3_step(stmt) == SQLITE_ROW);
+    sqlite3_finalize(stmt);
+    return exists;
+}
+
+static bool property_catalog_exists(sqlite3 *db)
+{
+    return table_exists(db, "property_catalog");
+}
+
+/*
+ * Create the per-table catalog triggers, first adding every (key, type)
+ * already in the tables, or drop them.
+ */
+static int property_catalog_triggers(sqlite3 *db, bool create)
+{
+    for (int o = 0; o < 2; o++) {
+        const char *owner = o ? "edge" : "node";
+        for (int t = PROP_TYPE_INTEGER; t <= PROP_TYPE_JSON; t++) {
+            const char *type = prop_table_suffix[t];
+            char sql[768];
+            if (create) {
+                snprintf(sql, sizeof(sql),
+                         "INSERT OR IGNORE INTO property_key_types (key_id, owner, type) "
+                         "SELECT DISTINCT key_id, '%s', '%s' FROM %s_props_%s;"
+                         "CREATE TRIGGER IF NOT EXISTS %s_props_%s_catalog AFTER INSERT ON %s_props_%s "
+                         "WHEN NOT EXISTS (SELECT 1 FROM property_key_types "
+                         "WHERE key_id = NEW.key_id AND owner = '%s' AND type = '%s') "
+                         "BEGIN "
+                         "INSERT INTO property_key_types (key_id, owner, type) VALUES (NEW.key_id, '%s', '%s'); "
+                         "UPDATE property_catalog SET version = random(); "
+                         "END",
+                         owner, type, owner, type,
+                         owner, type, owner, type,
+                         owner, type,
+                         owner, type);
+            } else {
+                snprintf(sql, sizeof(sql), "DROP TRIGGER IF EXISTS %s_props_%s_catalog", owner, type);
+            }
+            if (execute_ddl(db, sql, "property catalog trigger") < 0) return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Create the property type catalog on first open, filled from the existing
+ * property tables. All or nothing: a catalog table without its triggers
+ * would under-report types.
+ */
+static int create_property_catalog(cypher_schema_manager *manager)
+{
+    sqlite3 *db = manager->db;
+
+    if (property_catalog_exists(db)) {
+        return 0;
+    }
+
+    CYPHER_DEBUG("Creating property type catalog");
+
+    if (execute_ddl(db, "SAVEPOINT graphqlite_catalog", "catalog savepoint") < 0) {
+        return -1;
+    }
+
+    int rc = execute_ddl(db, CYPHER_SCHEMA_DDL_PROPERTY_CATALOG, "property_catalog table");
+    if (rc == 0) {
+        rc = execute_ddl(db, CYPHER_SCHEMA_DDL_PROPERTY_KEY_TYPES, "property_key_types table");
+    }
+    if (rc == 0) {
+        rc = property_catalog_triggers(db, true);
+    }
+
+    if (rc == 0) {
+        return execute_ddl(db, "RELEASE graphqlite_catalog", "catalog release");
+    }
+    sqlite3_exec(db, "ROLLBACK TO graphqlite_catalog; RELEASE graphqlite_catalog", NULL, NULL, NULL);
+    return -1;
+}
+
+/* Packed property records */
+
+static const char *CYPHER_SCHEMA_DDL_PROPS_PACKED =
+    "CREATE TABLE IF NOT EXISTS node_props_packed ("
+    "  node_id INTEGER PRIMARY KEY,"
+    "  props TEXT NOT NULL"
+    ");"
+    "CREATE TABLE IF NOT EXISTS edge_props_packed ("
+    "  edge_id INTEGER PRIMARY KEY,"
+    "  props TEXT NOT NULL"
+    ")";
+
+static bool packed_records_exist(sqlite3 *db)
+{
+    return table_exists(db, "node_props_packed");
+}
+
+/* Patch one value into NEW's record, creating the record with its first value */
+static void packed_set_sql(char *buf, size_t size, const char *owner, property_type type)
+{
+    snprintf(buf, size,
+             "INSERT OR REPLACE INTO %s_props_packed (%s_id, props) VALUES (NEW.%s_id, "
+             "json_set(COALESCE((SELECT props FROM %s_props_packed WHERE %s_id = NEW.%s_id), '{}'), "
+             "'$.' || json_quote((SELECT key FROM property_keys WHERE id = NEW.key_id)), %s)); ",
+             owner, owner, owner, owner, owner, owner,
+             type == PROP_TYPE_JSON ? "json(NEW.value)" : "NEW.value");
+}
+
+/* Take OLD's value out of its record, dropping the record with its last value */
+static void packed_remove_sql(char *buf, size_t size, const char *owner)
+{
+    snprintf(buf, size,
+             "UPDATE %s_props_packed SET props = json_remove(props, "
+             "'$.' || json_quote((SELECT key FROM property_keys WHERE id = OLD.key_id))) "
+             "WHERE %s_id = OLD.%s_id; "
+             "DELETE FROM %s_props_packed WHERE %s_id = OLD.%s_id AND props = '{}'; ",
+             owner, owner, owner, owner, owner, owner);
+}
+
+/* Create or drop the triggers keeping the packed records in step with the typed tables */
+static int packed_record_triggers(sqlite3 *db, bool create)
+{
+    static const char *const events[] = { "insert", "update", "delete" };
+    char sql[2048];
+
+    for (int o = 0; o < 2; o++) {
+        const char *owner = o ? "edge" : "node";
+
+        for (int t = PROP_TYPE_INTEGER; t <= PROP_TYPE_JSON; t++) {
+            const char *type = prop_table_suffix[t];
+            for (int e = 0; e < 3; e++) {
+                if (create) {
+                    char body[1536] = "";
+                    if (e > 0) {
+                        packed_remove_sql(body, sizeof(body), owner);
+                    }
+                    if (e < 2) {
+                        size_t len = strlen(body);
+                        packed_set_sql(body + len, sizeof(body) - len, owner, (property_type)t);
+                    }
+                    snprintf(sql, sizeof(sql),
+                             "CREATE TRIGGER IF NOT EXISTS %s_props_%s_packed_%s AFTER %s ON %s_props_%s "
+                             "BEGIN %sEND",
+                             owner, type, events[e], events[e], owner, type, body);
+                } else {
+                    snprintf(sql, sizeof(sql), "DROP TRIGGER IF EXISTS %s_props_%s_packed_%s",
+                             owner, type, events[e]);
+                }
+                if (execute_ddl(db, sql, "packed record trigger") < 0) return -1;
+            }
+        }
+
+        if (create) {
+            snprintf(sql, sizeof(sql),
+                     "CREATE TRIGGER IF NOT EXISTS %ss_packed_delete AFTER DELETE ON %ss "
+                     "BEGIN DELETE FROM %s_props_packed WHERE %s_id = OLD.id; END",
+                     owner, owner, owner, owner);
+        } else {
+            snprintf(sql, sizeof(sql), "DROP TRIGGER IF EXISTS %ss_packed_delete", owner);
+        }
+        if (execute_ddl(db, sql, "packed record trigger") < 0) return -1;
+    }
+    return 0;
+}
+
+/*
+ * Recompute every record from the typed tables, in one pass over each. A
+ * key held by several tables takes the value property lookups would
+ * (text, int, real, bool, json). Each branch yields JSON text, since the
+ * grouped value column takes the affinity of the first branch and older
+ * SQLite versions would turn every number into a string.
+ */
+static int packed_records_rebuild(sqlite3 *db)
+{
+    for (int o = 0; o < 2; o++) {
+        const char *owner = o ? "edge" : "node";
+        char sql[2048];
+        snprintf(sql, sizeof(sql),
+                 "DELETE FROM %s_props_packed; "
+                 "INSERT INTO %s_props_packed (%s_id, props) "
+                 "SELECT owner_id, json_group_object(key, json(value)) FROM ("
+                 "SELECT p.owner_id, pk.key, p.value FROM ("
+                 "SELECT owner_id, key_id, value, min(t) AS t FROM ("
+                 "SELECT %s_id AS owner_id, key_id, json_quote(value) AS value, 0 AS t FROM %s_props_text "
+                 "UNION ALL SELECT %s_id, key_id, json_quote(value), 1 FROM %s_props_int "
+                 "UNION ALL SELECT %s_id, key_id, json_quote(value), 2 FROM %s_props_real "
+                 "UNION ALL SELECT %s_id, key_id, json_quote(value), 3 FROM %s_props_bool "
+                 "UNION ALL SELECT %s_id, key_id, json(value), 4 FROM %s_props_json"
+                 ") GROUP BY owner_id, key_id) p "
+                 "JOIN property_keys pk ON pk.id = p.key_id ORDER BY p.owner_id, p.key_id"
+                 ") GROUP BY owner_id",
+                 owner, owner, owner,
+                 owner, owner, owner, owner, owner, owner, owner, owner, owner, owner);
+        if (execute_ddl(db, sql, "packed records") < 0) return -1;
+    }
+    return 0;
+}
+
+int cypher_schema_suspend_catalog(cypher_schema_manager *manager)
+{
+    if (!manager || !manager->db) {
+        return -1;
+    }
+    if (!property_catalog_exists(manager->db)) {
+        return 0;
+    }
+    if (packed_records_exist(manager->db) && packed_record_triggers(manager->db, false) < 0) {
+        return -1;
+    }
+    return property_catalog_triggers(manager->db, false);
+}
+
+int cypher_schema_resume_catalog(cypher_schema_manager *manager)
+{
+    if (!manager || !manager->db) {
+        return -1;
+    }
+    if (!property_catalog_exists(manager->db)) {
+        return 0;
+    }
+    if (property_catalog_triggers(manager->db, true) < 0) {
+        return -1;
+    }
+    if (packed_records_exist(manager->db) &&
+        (packed_records_rebuild(manager->db) < 0 || packed_record_triggers(manager->db, true) < 0)) {
+        return -1;
+    }
+    return execute_ddl(manager->db, "UPDATE property_catalog SET version = random()", "catalog version");
+}
+
+/*
+ * True when some catalog or packed record trigger is gone: a deferred import
+ * that commits in chunks runs with them dropped, and a crash before it
+ * resumes the catalog leaves them that way.
+ */
+static bool catalog_triggers_missing(sqlite3 *db)
+{
+    int types = PROP_TYPE_JSON - PROP_TYPE_INTEGER + 1;
+    int catalog = 0, packed = 0;
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(db,
+            "SELECT sum(name GLOB '*_props_*_catalog'), "
+            "       sum(name GLOB '*_props_*_packed_*' OR name GLOB '*s_packed_delete') "
+            "FROM sqlite_master WHERE type = 'trigger'", -1, &stmt, NULL) != SQLITE_OK) {
+        return false;
+    }
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        catalog = sqlite3_column_int(stmt, 0);
+        packed = sqlite3_column_int(stmt, 1);
+    }
+    sqlite3_finalize(stmt);
+
+    return catalog < 2 * types || (packed_records_exist(db) && packed < 2 * (3 * types + 1));
+}
+
+int cypher_schema_set_packed_properties(cypher_schema_manager *manager, bool enable)
+{
+    if (!manager || !manager->db) {
+        return -1;
+    }
+
+    /* Readers learn about the switch through the catalog version */
+    sqlite3 *db = manager->db;
+    if (!property_catalog_exists(db)) {
+        return -1;
+    }
+    if (execute_ddl(db, "SAVEPOINT graphqlite_packed", "packed savepoint") < 0) {
+        return -1;
+    }
+
+    int rc = 0;
+    if (enable) {
+        if (!packed_records_exist(db)) {
+            rc = execute_ddl(db, CYPHER_SCHEMA_DDL_PROPS_PACKED, "packed record tables");
+            if (rc == 0) {
+                rc = packed_records_rebuild(db);
+            }
+        }
+        if (rc == 0) {
+            rc = packed_record_triggers(db, true);
+        }
+    } else {
+        rc = packed_record_triggers(db, false);
+        if (rc == 0) {
+            rc = execute_ddl(db, "DROP TABLE IF EXISTS node_props_packed; DROP TABLE IF EXISTS edge_props_packed",
+                             "packed record tables");
+        }
+    }
+    if (rc == 0) {
+        rc = execute_ddl(db, "UPDATE property_catalog SET version = random()", "catalog version");
+    }
+
+    if (rc == 0) {
+        return execute_ddl(db, "RELEASE graphqlite_packed", "packed release");
+    }
+    sqlite3_exec(db, "ROLLBACK TO graphqlite_packed; RELEASE graphqlite_packed", NULL, NULL, NULL);
+    return -1;
+}
+
 int cypher_schema_initialize(cypher_schema_manager *manager)
 {
     if (!manager) {
@@ -407,6 +873,13 @@ int cypher_schema_initialize(cypher_schema_manager *manager)
         return -1;
     }
 
+    /* Optional: without it property access falls back to lookups by key name */
+    manager->catalog_available = (create_property_catalog(manager) == 0);
+    if (manager->catalog_available && catalog_triggers_missing(manager->db)) {
+        CYPHER_DEBUG("Restoring property catalog triggers left dropped by an import");
+        manager->catalog_available = (cypher_schema_resume_catalog(manager) == 0);
+    }
+
     /* Run ANALYZE to update query planner statistics if needed */
     /* Check if statistics already exist to avoid expensive re-analysis */
     sqlite3_stmt *check_stmt;
@@ -505,6 +978,11 @@ int cypher_schema_get_property_key_id(cypher_schema_manager *manager, const char
     }
     
     property_key_cache *cache = manager->key_cache;
+
+    /* Ids cached before a rollback may be gone or reused */
+    if (!manager->catalog_checked) {
+        cypher_schema_catalog_generation(manager);
+    }
     
     /* Calculate hash slot */
     unsigned long hash = hash_string(key);
@@ -524,12 +1002,8 @@ int cypher_schema_get_property_key_id(cypher_schema_manager *manager, const char
     /* Cache miss - query database */
     cache->cache_misses++;
 
-    /* Prepare statement locally to avoid caching issues with sqlite3_close */
-    sqlite3_stmt *lookup_stmt = NULL;
-    const char *lookup_sql = "SELECT id FROM property_keys WHERE key = ?";
-    int rc = sqlite3_prepare_v2(manager->db, lookup_sql, -1, &lookup_stmt, NULL);
-    if (rc != SQLITE_OK) {
-        CYPHER_DEBUG("Failed to prepare property key lookup");
+    sqlite3_stmt *lookup_stmt = schema_stmt(manager, SCHEMA_STMT_KEY_LOOKUP);
+    if (!lookup_stmt) {
         return -1;
     }
 
@@ -538,7 +1012,10 @@ int cypher_schema_get_property_key_id(cypher_schema_manager *manager, const char
     int key_id = -1;
     if (sqlite3_step(lookup_stmt) == SQLITE_ROW) {
         key_id = sqlite3_column_int(lookup_stmt, 0);
+    }
+    schema_stmt_done(lookup_stmt);
 
+    if (key_id >= 0) {
         /* Add to cache */
         if (entry) {
             /* Replace existing entry */
@@ -547,7 +1024,6 @@ int cypher_schema_get_property_key_id(cypher_schema_manager *manager, const char
             /* Create new entry */
             entry = malloc(sizeof(property_key_entry));
             if (!entry) {
-                sqlite3_finalize(lookup_stmt);
                 return key_id;
             }
             cache->slots[slot] = entry;
@@ -561,7 +1037,6 @@ int cypher_schema_get_property_key_id(cypher_schema_manager *manager, const char
         CYPHER_DEBUG("Property key '%s' found in DB -> id %d", key, key_id);
     }
 
-    sqlite3_finalize(lookup_stmt);
     return key_id;
 }
 
@@ -580,20 +1055,14 @@ int cypher_schema_ensure_property_key(cypher_schema_manager *manager, const char
     /* Key doesn't exist - create it */
     property_key_cache *cache = manager->key_cache;
 
-    /* Prepare statement locally to avoid caching issues with sqlite3_close */
-    sqlite3_stmt *insert_stmt = NULL;
-    const char *insert_sql = "INSERT INTO property_keys (key) VALUES (?)";
-    int rc = sqlite3_prepare_v2(manager->db, insert_sql, -1, &insert_stmt, NULL);
-    if (rc != SQLITE_OK) {
-        CYPHER_DEBUG("Failed to prepare property key insert");
+    sqlite3_stmt *insert_stmt = schema_stmt(manager, SCHEMA_STMT_KEY_INSERT);
+    if (!insert_stmt) {
         return -1;
     }
 
     sqlite3_bind_text(insert_stmt, 1, key, -1, SQLITE_STATIC);
 
-    rc = sqlite3_step(insert_stmt);
-    sqlite3_finalize(insert_stmt);
-
+    int rc = schema_stmt_run(insert_stmt);
     if (rc != SQLITE_DONE) {
         CYPHER_DEBUG("Failed to insert property key '%s': %s", key, sqlite3_errmsg(manager->db));
         return -1;
@@ -658,6 +1127,157 @@ const char* cypher_schema_get_property_key_name(cypher_schema_manager *manager,
     return NULL;
 }
 
+/* Property type catalog */
+
+/* Compare property_catalog's version with the last one seen */
+static void catalog_sync(cypher_schema_manager *manager)
+{
+    sqlite3_stmt *stmt = schema_stmt(manager, SCHEMA_STMT_CATALOG_VERSION);
+    if (!stmt) {
+        manager->catalog_available = false;
+        return;
+    }
+
+    sqlite3_int64 version = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        version = sqlite3_column_int64(stmt, 0);
+    }
+    schema_stmt_done(stmt);
+
+    if (version == manager->catalog_version) {
+        return;
+    }
+
+    CYPHER_DEBUG("Property catalog changed, dropping cached keys and types");
+    manager->catalog_version = version;
+    manager->catalog_loaded = false;
+    manager->packed_checked = false;
+    manager->catalog_generation++;
+    clear_property_key_cache(manager->key_cache);
+}
+
+static int catalog_load(cypher_schema_manager *manager)
+{
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(manager->db, "SELECT key_id, owner, type FROM property_key_types",
+                           -1, &stmt, NULL) != SQLITE_OK) {
+        return -1;
+    }
+
+    if (manager->key_types) {
+        memset(manager->key_types, 0, manager->key_types_size * sizeof(uint16_t));
+    }
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        int key_id = sqlite3_column_int(stmt, 0);
+        const char *owner = (const char*)sqlite3_column_text(stmt, 1);
+        const char *type = (const char*)sqlite3_column_text(stmt, 2);
+        if (key_id < 0 || !owner || !type) {
+            continue;
+        }
+
+        int t = PROP_TYPE_INTEGER;
+        while (t <= PROP_TYPE_JSON && strcmp(prop_table_suffix[t], type) != 0) {
+            t++;
+        }
+        if (t > PROP_TYPE_JSON) {
+            continue;
+        }
+
+        if (key_id >= manager->key_types_size) {
+            int size = manager->key_types_size ? manager->key_types_size : 64;
+            while (size <= key_id) {
+                size *= 2;
+            }
+            uint16_t *types = realloc(manager->key_types, size * sizeof(uint16_t));
+            if (!types) {
+                sqlite3_finalize(stmt);
+                return -1;
+            }
+            memset(types + manager->key_types_size, 0,
+                   (size - manager->key_types_size) * sizeof(uint16_t));
+            manager->key_types = types;
+            manager->key_types_size = size;
+        }
+        manager->key_types[key_id] |= (uint16_t)((1 << t) << (strcmp(owner, "edge") == 0 ? 8 : 0));
+    }
+
+    sqlite3_finalize(stmt);
+    manager->catalog_loaded = true;
+    return 0;
+}
+
+long cypher_schema_catalog_generation(cypher_schema_manager *manager)
+{
+    if (!manager || !manager->catalog_available) {
+        return 0;
+    }
+    catalog_sync(manager);
+    manager->catalog_checked = true;
+    return manager->catalog_generation;
+}
+
+int cypher_schema_property_types(cypher_schema_manager *manager, int key_id, bool is_edge)
+{
+    if (!manager || !manager->catalog_available || key_id < 0) {
+        return -1;
+    }
+    if (!manager->catalog_checked) {
+        cypher_schema_catalog_generation(manager);
+    }
+    if (!manager->catalog_loaded && catalog_load(manager) < 0) {
+        return -1;
+    }
+    if (key_id >= manager->key_types_size) {
+        return 0;
+    }
+    return (manager->key_types[key_id] >> (is_edge ? 8 : 0)) & 0xff;
+}
+
+void cypher_schema_discard_cached(cypher_schema_manager *manager)
+{
+    if (!manager) {
+        return;
+    }
+
+    CYPHER_DEBUG("Savepoint rolled back, dropping cached keys and types");
+    manager->catalog_loaded = false;
+    manager->catalog_checked = false;
+    manager->packed_checked = false;
+    manager->catalog_generation++;
+    clear_property_key_cache(manager->key_cache);
+}
+
+bool cypher_schema_packed_properties(cypher_schema_manager *manager)
+{
+    if (!manager || !manager->catalog_available) {
+        return false;
+    }
+    if (!manager->catalog_checked) {
+        cypher_schema_catalog_generation(manager);
+    }
+    if (!manager->packed_checked) {
+        manager->packed_enabled = packed_records_exist(manager->db);
+        manager->packed_checked = true;
+    }
+    return manager->packed_enabled;
+}
+
+void cypher_schema_end_query(cypher_schema_manager *manager)
+{
+    if (!manager) {
+        return;
+    }
+
+    /* Keys this query cached must not survive a later rollback of its writes */
+    if (manager->catalog_checked && manager->catalog_available) {
+        catalog_sync(manager);
+    }
+    manager->catalog_checked = false;
+
+    cypher_schema_release_statements(manager);
+}
+
 int cypher_schema_create_node(cypher_schema_manager *manager)
 {
     if (!manager || !manager->db) {
@@ -665,13 +1285,14 @@ int cypher_schema_create_node(cypher_schema_manager *manager)
     }
     
     /* Insert into nodes table */
-    const char *sql = "INSERT INTO nodes DEFAULT VALUES";
-    char *error_message;
-    int rc = sqlite3_exec(manager->db, sql, NULL, NULL, &error_message);
-    
-    if (rc != SQLITE_OK) {
-        CYPHER_DEBUG("Failed to create node: %s", error_message);
-        sqlite3_free(error_message);
+    sqlite3_stmt *stmt = schema_stmt(manager, SCHEMA_STMT_NODE_INSERT);
+    if (!stmt) {
+        return -1;
+    }
+
+    int rc = schema_stmt_run(stmt);
+    if (rc != SQLITE_DONE) {
+        CYPHER_DEBUG("Failed to create node: %s", sqlite3_errmsg(manager->db));
         return -1;
     }
     
@@ -689,21 +1310,15 @@ int cypher_schema_add_node_label(cypher_schema_manager *manager, int node_id, co
     }
     
     /* Insert into node_labels table */
-    const char *sql = "INSERT OR IGNORE INTO node_labels (node_id, label) VALUES (?, ?)";
-    sqlite3_stmt *stmt;
-    
-    int rc = sqlite3_prepare_v2(manager->db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        CYPHER_DEBUG("Failed to prepare label insert statement: %s", sqlite3_errmsg(manager->db));
+    sqlite3_stmt *stmt = schema_stmt(manager, SCHEMA_STMT_LABEL_INSERT);
+    if (!stmt) {
         return -1;
     }
     
     sqlite3_bind_int(stmt, 1, node_id);
     sqlite3_bind_text(stmt, 2, label, -1, SQLITE_STATIC);
     
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    
+    int rc = schema_stmt_run(stmt);
     if (rc != SQLITE_DONE) {
         CYPHER_DEBUG("Failed to add label '%s' to node %d: %s", label, node_id, sqlite3_errmsg(manager->db));
         return -1;
@@ -713,73 +1328,96 @@ int cypher_schema_add_node_label(cypher_schema_manager *manager, int node_id, co
     return 0;
 }
 
-int cypher_schema_set_node_property(cypher_schema_manager *manager, 
-                                   int node_id, const char *key, 
-                                   property_type type, const void *value)
+/*
+ * Bitmask (1 << property_type) of the typed tables holding a value for
+ * (owner_id, key_id), or -1 on error. types_kind selects node or edge.
+ */
+static int stored_property_types(cypher_schema_manager *manager, schema_stmt_kind types_kind,
+                                 int owner_id, int key_id)
 {
-    if (!manager || !manager->db || !key || !value || node_id < 0) {
+    sqlite3_stmt *stmt = schema_stmt(manager, types_kind);
+    if (!stmt) {
         return -1;
     }
-    
+
+    sqlite3_bind_int(stmt, 1, owner_id);
+    sqlite3_bind_int(stmt, 2, key_id);
+
+    int mask = 0;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        mask |= 1 << sqlite3_column_int(stmt, 0);
+    }
+    schema_stmt_done(stmt);
+
+    return rc == SQLITE_DONE ? mask : -1;
+}
+
+/* Delete (owner_id, key_id) from each typed table in mask */
+static int delete_property_types(cypher_schema_manager *manager, schema_stmt_kind delete_base,
+                                 int owner_id, int key_id, int mask)
+{
+    for (int t = PROP_TYPE_INTEGER; t <= PROP_TYPE_JSON; t++) {
+        if (!(mask & (1 << t))) {
+            continue;
+        }
+
+        sqlite3_stmt *stmt = schema_stmt(manager, delete_base + t);
+        if (!stmt) {
+            return -1;
+        }
+
+        sqlite3_bind_int(stmt, 1, owner_id);
+        sqlite3_bind_int(stmt, 2, key_id);
+        if (schema_stmt_run(stmt) != SQLITE_DONE) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Shared node/edge property write. A key lives in exactly one typed table
+ * (readers COALESCE across them), so a value previously stored under a
+ * different type is removed first. The probe makes this one indexed
+ * lookup instead of a DELETE against every table; the common cases - new
+ * key, or same type - then need only the INSERT OR REPLACE.
+ */
+static int set_property(cypher_schema_manager *manager, bool is_edge,
+                        int owner_id, const char *key,
+                        property_type type, const void *value)
+{
+    if (type < PROP_TYPE_INTEGER || type > PROP_TYPE_JSON) {
+        return -1;
+    }
+
     /* Get or create property key ID */
     int key_id = cypher_schema_ensure_property_key(manager, key);
     if (key_id < 0) {
         return -1;
     }
-    
-    /* Clean up the property from all other type tables to avoid COALESCE conflicts */
-    const char *cleanup_tables[] = {"node_props_text", "node_props_int", "node_props_real", "node_props_bool", "node_props_json"};
-    const char *cleanup_sql = "DELETE FROM %s WHERE node_id = ? AND key_id = ?";
-
-    for (int i = 0; i < 5; i++) {
-        char cleanup_query[256];
-        snprintf(cleanup_query, sizeof(cleanup_query), cleanup_sql, cleanup_tables[i]);
-        
-        sqlite3_stmt *cleanup_stmt;
-        int rc = sqlite3_prepare_v2(manager->db, cleanup_query, -1, &cleanup_stmt, NULL);
-        if (rc == SQLITE_OK) {
-            sqlite3_bind_int(cleanup_stmt, 1, node_id);
-            sqlite3_bind_int(cleanup_stmt, 2, key_id);
-            sqlite3_step(cleanup_stmt);
-            sqlite3_finalize(cleanup_stmt);
-        }
-    }
-    
-    /* Determine the appropriate table and SQL based on type */
-    const char *table_name;
-    const char *sql_template = "INSERT INTO %s (node_id, key_id, value) VALUES (?, ?, ?)";
-    char sql[256];
-    
-    switch (type) {
-        case PROP_TYPE_INTEGER:
-            table_name = "node_props_int";
-            break;
-        case PROP_TYPE_TEXT:
-            table_name = "node_props_text";
-            break;
-        case PROP_TYPE_REAL:
-            table_name = "node_props_real";
-            break;
-        case PROP_TYPE_BOOLEAN:
-            table_name = "node_props_bool";
-            break;
-        case PROP_TYPE_JSON:
-            table_name = "node_props_json";
-            break;
-        default:
-            return -1;
+
+    int stored = stored_property_types(manager,
+                                       is_edge ? SCHEMA_STMT_EDGE_PROP_TYPES : SCHEMA_STMT_NODE_PROP_TYPES,
+                                       owner_id, key_id);
+    if (stored < 0) {
+        return -1;
     }
 
-    snprintf(sql, sizeof(sql), sql_template, table_name);
+    int stale = stored & ~(1 << type);
+    if (stale && delete_property_types(manager,
+                                       is_edge ? SCHEMA_STMT_EDGE_PROP_DELETE : SCHEMA_STMT_NODE_PROP_DELETE,
+                                       owner_id, key_id, stale) < 0) {
+        return -1;
+    }
 
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(manager->db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        CYPHER_DEBUG("Failed to prepare property insert statement: %s", sqlite3_errmsg(manager->db));
+    sqlite3_stmt *stmt = schema_stmt(manager,
+                                     (is_edge ? SCHEMA_STMT_EDGE_PROP_SET : SCHEMA_STMT_NODE_PROP_SET) + type);
+    if (!stmt) {
         return -1;
     }
 
-    sqlite3_bind_int(stmt, 1, node_id);
+    sqlite3_bind_int(stmt, 1, owner_id);
     sqlite3_bind_int(stmt, 2, key_id);
 
     /* Bind value based on type */
@@ -800,11 +1438,19 @@ int cypher_schema_set_node_property(cypher_schema_manager *manager,
             sqlite3_bind_text(stmt, 3, (const char*)value, -1, SQLITE_STATIC);
             break;
     }
+
+    return schema_stmt_run(stmt) == SQLITE_DONE ? 0 : -1;
+}
+
+int cypher_schema_set_node_property(cypher_schema_manager *manager, 
+                                   int node_id, const char *key, 
+                                   property_type type, const void *value)
+{
+    if (!manager || !manager->db || !key || !value || node_id < 0) {
+        return -1;
+    }
     
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    
-    if (rc != SQLITE_DONE) {
+    if (set_property(manager, false, node_id, key, type, value) < 0) {
         CYPHER_DEBUG("Failed to set property '%s' on node %d: %s", key, node_id, sqlite3_errmsg(manager->db));
         return -1;
     }
@@ -827,12 +1473,8 @@ int cypher_schema_create_edge(cypher_schema_manager *manager,
         return -1;
     }
     
-    const char *sql = "INSERT INTO edges (source_id, target_id, type) VALUES (?, ?, ?)";
-    sqlite3_stmt *stmt;
-    
-    int rc = sqlite3_prepare_v2(manager->db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        CYPHER_DEBUG("Failed to prepare edge insert statement: %s", sqlite3_errmsg(manager->db));
+    sqlite3_stmt *stmt = schema_stmt(manager, SCHEMA_STMT_EDGE_INSERT);
+    if (!stmt) {
         return -1;
     }
     
@@ -840,9 +1482,7 @@ int cypher_schema_create_edge(cypher_schema_manager *manager,
     sqlite3_bind_int(stmt, 2, target_id);
     sqlite3_bind_text(stmt, 3, type, -1, SQLITE_STATIC);
     
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    
+    int rc = schema_stmt_run(stmt);
     if (rc != SQLITE_DONE) {
         CYPHER_DEBUG("Failed to insert edge: %s", sqlite3_errmsg(manager->db));
         return -1;
@@ -860,20 +1500,14 @@ int cypher_schema_delete_edge(cypher_schema_manager *manager, int edge_id)
         return -1;
     }
     
-    const char *sql = "DELETE FROM edges WHERE id = ?";
-    sqlite3_stmt *stmt;
-    
-    int rc = sqlite3_prepare_v2(manager->db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        CYPHER_DEBUG("Failed to prepare edge delete statement: %s", sqlite3_errmsg(manager->db));
+    sqlite3_stmt *stmt = schema_stmt(manager, SCHEMA_STMT_EDGE_DELETE);
+    if (!stmt) {
         return -1;
     }
     
     sqlite3_bind_int(stmt, 1, edge_id);
     
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    
+    int rc = schema_stmt_run(stmt);
     if (rc != SQLITE_DONE) {
         CYPHER_DEBUG("Failed to delete edge %d: %s", edge_id, sqlite3_errmsg(manager->db));
         return -1;
@@ -891,72 +1525,7 @@ int cypher_schema_set_edge_property(cypher_schema_manager *manager,
         return -1;
     }
     
-    /* Get or create property key ID */
-    int key_id = cypher_schema_ensure_property_key(manager, key);
-    if (key_id < 0) {
-        return -1;
-    }
-    
-    /* Determine the appropriate table and SQL based on type */
-    const char *table_name;
-    const char *sql_template = "INSERT OR REPLACE INTO %s (edge_id, key_id, value) VALUES (?, ?, ?)";
-    char sql[256];
-    
-    switch (type) {
-        case PROP_TYPE_INTEGER:
-            table_name = "edge_props_int";
-            break;
-        case PROP_TYPE_TEXT:
-            table_name = "edge_props_text";
-            break;
-        case PROP_TYPE_REAL:
-            table_name = "edge_props_real";
-            break;
-        case PROP_TYPE_BOOLEAN:
-            table_name = "edge_props_bool";
-            break;
-        case PROP_TYPE_JSON:
-            table_name = "edge_props_json";
-            break;
-        default:
-            return -1;
-    }
-
-    snprintf(sql, sizeof(sql), sql_template, table_name);
-
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(manager->db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        CYPHER_DEBUG("Failed to prepare edge property insert statement: %s", sqlite3_errmsg(manager->db));
-        return -1;
-    }
-
-    sqlite3_bind_int(stmt, 1, edge_id);
-    sqlite3_bind_int(stmt, 2, key_id);
-
-    /* Bind value based on type */
-    switch (type) {
-        case PROP_TYPE_INTEGER:
-            sqlite3_bind_int64(stmt, 3, *(const int64_t*)value);
-            break;
-        case PROP_TYPE_TEXT:
-            sqlite3_bind_text(stmt, 3, (const char*)value, -1, SQLITE_STATIC);
-            break;
-        case PROP_TYPE_REAL:
-            sqlite3_bind_double(stmt, 3, *(const double*)value);
-            break;
-        case PROP_TYPE_BOOLEAN:
-            sqlite3_bind_int(stmt, 3, *(const int*)value ? 1 : 0);
-            break;
-        case PROP_TYPE_JSON:
-            sqlite3_bind_text(stmt, 3, (const char*)value, -1, SQLITE_STATIC);
-            break;
-    }
-    
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    
-    if (rc != SQLITE_DONE) {
+    if (set_property(manager, true, edge_id, key, type, value) < 0) {
         CYPHER_DEBUG("Failed to set property '%s' on edge %d: %s", key, edge_id, sqlite3_errmsg(manager->db));
         return -1;
     }
@@ -981,32 +1550,18 @@ int cypher_schema_delete_node_property(cypher_schema_manager *manager,
         return 0;
     }
 
-    /* Delete from all property tables - we don't know which type it is */
-    const char *tables[] = {"node_props_text", "node_props_int", "node_props_real", "node_props_bool", "node_props_json"};
-    int deleted = 0;
-
-    for (int i = 0; i < 5; i++) {
-        char sql[256];
-        snprintf(sql, sizeof(sql), "DELETE FROM %s WHERE node_id = ? AND key_id = ?", tables[i]);
-
-        sqlite3_stmt *stmt;
-        int rc = sqlite3_prepare_v2(manager->db, sql, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            continue;
-        }
-
-        sqlite3_bind_int(stmt, 1, node_id);
-        sqlite3_bind_int(stmt, 2, key_id);
+    /* Only touch the typed table(s) actually holding the key */
+    int stored = stored_property_types(manager, SCHEMA_STMT_NODE_PROP_TYPES, node_id, key_id);
+    if (stored <= 0) {
+        return -1;
+    }
 
-        rc = sqlite3_step(stmt);
-        if (rc == SQLITE_DONE && sqlite3_changes(manager->db) > 0) {
-            deleted++;
-            CYPHER_DEBUG("Deleted property '%s' from node %d (table %s)", property_name, node_id, tables[i]);
-        }
-        sqlite3_finalize(stmt);
+    if (delete_property_types(manager, SCHEMA_STMT_NODE_PROP_DELETE, node_id, key_id, stored) < 0) {
+        return -1;
     }
 
-    return deleted > 0 ? 0 : -1;
+    CYPHER_DEBUG("Deleted property '%s' from node %d", property_name, node_id);
+    return 0;
 }
 
 /* Delete a property from an edge */
@@ -1025,32 +1580,18 @@ int cypher_schema_delete_edge_property(cypher_schema_manager *manager,
         return 0;
     }
 
-    /* Delete from all property tables - we don't know which type it is */
-    const char *tables[] = {"edge_props_text", "edge_props_int", "edge_props_real", "edge_props_bool", "edge_props_json"};
-    int deleted = 0;
-
-    for (int i = 0; i < 5; i++) {
-        char sql[256];
-        snprintf(sql, sizeof(sql), "DELETE FROM %s WHERE edge_id = ? AND key_id = ?", tables[i]);
-
-        sqlite3_stmt *stmt;
-        int rc = sqlite3_prepare_v2(manager->db, sql, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
-            continue;
-        }
-
-        sqlite3_bind_int(stmt, 1, edge_id);
-        sqlite3_bind_int(stmt, 2, key_id);
+    /* Only touch the typed table(s) actually holding the key */
+    int stored = stored_property_types(manager, SCHEMA_STMT_EDGE_PROP_TYPES, edge_id, key_id);
+    if (stored <= 0) {
+        return -1;
+    }
 
-        rc = sqlite3_step(stmt);
-        if (rc == SQLITE_DONE && sqlite3_changes(manager->db) > 0) {
-            deleted++;
-            CYPHER_DEBUG("Deleted property '%s' from edge %d (table %s)", property_name, edge_id, tables[i]);
-        }
-        sqlite3_finalize(stmt);
+    if (delete_property_types(manager, SCHEMA_STMT_EDGE_PROP_DELETE, edge_id, key_id, stored) < 0) {
+        return -1;
     }
 
-    return deleted > 0 ? 0 : -1;
+    CYPHER_DEBUG("Deleted property '%s' from edge %d", property_name, edge_id);
+    return 0;
 }
 
 /* Delete all properties from a node (all 5 typed tables) */
@@ -1060,21 +1601,14 @@ int cypher_schema_delete_all_node_properties(cypher_schema_manager *manager, int
         return -1;
     }
 
-    const char *tables[] = {"node_props_text", "node_props_int", "node_props_real", "node_props_bool", "node_props_json"};
-
-    for (int i = 0; i < 5; i++) {
-        char sql[256];
-        snprintf(sql, sizeof(sql), "DELETE FROM %s WHERE node_id = ?", tables[i]);
-
-        sqlite3_stmt *stmt;
-        int rc = sqlite3_prepare_v2(manager->db, sql, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
+    for (int t = PROP_TYPE_INTEGER; t <= PROP_TYPE_JSON; t++) {
+        sqlite3_stmt *stmt = schema_stmt(manager, SCHEMA_STMT_NODE_PROP_CLEAR + t);
+        if (!stmt) {
             continue;
         }
 
         sqlite3_bind_int(stmt, 1, node_id);
-        sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+        schema_stmt_run(stmt);
     }
 
     CYPHER_DEBUG("Deleted all properties from node %d", node_id);
@@ -1088,21 +1622,14 @@ int cypher_schema_delete_all_edge_properties(cypher_schema_manager *manager, int
         return -1;
     }
 
-    const char *tables[] = {"edge_props_text", "edge_props_int", "edge_props_real", "edge_props_bool", "edge_props_json"};
-
-    for (int i = 0; i < 5; i++) {
-        char sql[256];
-        snprintf(sql, sizeof(sql), "DELETE FROM %s WHERE edge_id = ?", tables[i]);
-
-        sqlite3_stmt *stmt;
-        int rc = sqlite3_prepare_v2(manager->db, sql, -1, &stmt, NULL);
-        if (rc != SQLITE_OK) {
+    for (int t = PROP_TYPE_INTEGER; t <= PROP_TYPE_JSON; t++) {
+        sqlite3_stmt *stmt = schema_stmt(manager, SCHEMA_STMT_EDGE_PROP_CLEAR + t);
+        if (!stmt) {
             continue;
         }
 
         sqlite3_bind_int(stmt, 1, edge_id);
-        sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+        schema_stmt_run(stmt);
     }
 
     CYPHER_DEBUG("Deleted all properties from edge %d", edge_id);
@@ -1116,21 +1643,16 @@ int cypher_schema_remove_node_label(cypher_schema_manager *manager, int node_id,
         return -1;
     }
 
-    const char *sql = "DELETE FROM node_labels WHERE node_id = ? AND label = ?";
-    sqlite3_stmt *stmt;
-
-    int rc = sqlite3_prepare_v2(manager->db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        CYPHER_DEBUG("Failed to prepare label delete statement: %s", sqlite3_errmsg(manager->db));
+    sqlite3_stmt *stmt = schema_stmt(manager, SCHEMA_STMT_LABEL_DELETE);
+    if (!stmt) {
         return -1;
     }
 
     sqlite3_bind_int(stmt, 1, node_id);
     sqlite3_bind_text(stmt, 2, label, -1, SQLITE_STATIC);
 
-    rc = sqlite3_step(stmt);
+    int rc = schema_stmt_run(stmt);
     int changes = sqlite3_changes(manager->db);
-    sqlite3_finalize(stmt);
 
     if (rc != SQLITE_DONE) {
         CYPHER_DEBUG("Failed to remove label '%s' from node %d: %s", label, node_id, sqlite3_errmsg(manager->db));
@@ -1153,11 +1675,8 @@ bool cypher_schema_node_has_label(cypher_schema_manager *manager, int node_id, c
         return false;
     }
 
-    const char *sql = "SELECT 1 FROM node_labels WHERE node_id = ? AND label = ? LIMIT 1";
-    sqlite3_stmt *stmt;
-
-    int rc = sqlite3_prepare_v2(manager->db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
+    sqlite3_stmt *stmt = schema_stmt(manager, SCHEMA_STMT_LABEL_EXISTS);
+    if (!stmt) {
         return false;
     }
 
@@ -1165,7 +1684,7 @@ bool cypher_schema_node_has_label(cypher_schema_manager *manager, int node_id, c
     sqlite3_bind_text(stmt, 2, label, -1, SQLITE_STATIC);
 
     bool has_label = (sqlite3_step(stmt) == SQLITE_ROW);
-    sqlite3_finalize(stmt);
+    schema_stmt_done(stmt);
 
     return has_label;
 }
@@ -1177,20 +1696,14 @@ int cypher_schema_delete_node(cypher_schema_manager *manager, int node_id)
         return -1;
     }
 
-    const char *sql = "DELETE FROM nodes WHERE id = ?";
-    sqlite3_stmt *stmt;
-
-    int rc = sqlite3_prepare_v2(manager->db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        CYPHER_DEBUG("Failed to prepare node delete statement: %s", sqlite3_errmsg(manager->db));
+    sqlite3_stmt *stmt = schema_stmt(manager, SCHEMA_STMT_NODE_DELETE);
+    if (!stmt) {
         return -1;
     }
 
     sqlite3_bind_int(stmt, 1, node_id);
 
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-
+    int rc = schema_stmt_run(stmt);
     if (rc != SQLITE_DONE) {
         CYPHER_DEBUG("Failed to delete node %d: %s", node_id, sqlite3_errmsg(manager->db));
         return -1;
@@ -1199,16 +1712,3 @@ int cypher_schema_delete_node(cypher_schema_manager *manager, int node_id)
     CYPHER_DEBUG("Deleted node %d", node_id);
     return 0;
 }
-
-/* Statistics */
-void property_key_cache_stats(property_key_cache *cache,
-                             long *hits, long *misses, long *insertions)
-{
-    if (!cache) {
-        return;
-    }
-    
-    if (hits) *hits = cache->cache_hits;
-    if (misses) *misses = cache->cache_misses;
-    if (insertions) *insertions = cache->key_insertions;
-}
\ No newline at end of file
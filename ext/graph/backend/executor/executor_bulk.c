@@ -0,0 +1,1189 @@
+/*
+ * Bulk UNWIND Execution
+ * Batched fast path for UNWIND ... CREATE / MERGE of standalone nodes
+ *
+ * The generic UNWIND handlers run the full CREATE/MERGE machinery once per
+ * element: one INSERT per node, label and property, each going through the
+ * schema manager. For the common import shape
+ *
+ *   UNWIND $rows AS r CREATE (:Person {name: r.name, age: r.age})
+ *   UNWIND $rows AS r MERGE (:Person {id: r.id})
+ *
+ * this path instead:
+ *   - resolves every property key id once up front
+ *   - reads the rows with a single json_each() query that also extracts
+ *     each referenced r.key with its JSON type
+ *   - reserves node ids from one MAX(id) probe and assigns them in memory
+ *   - buffers rows per target table and writes them as multi-row INSERTs
+ *     of BULK_BATCH_ROWS rows
+ *   - runs inside one savepoint, so a failed import leaves nothing behind
+ *
+ * Values keep their JSON types (integer, real, text, boolean; nested maps
+ * and lists as JSON). Queries outside this shape - relationships, SET,
+ * function calls, repeated variables - use the per-element handlers.
+ *
+ * The buffered writer (bulk_writer_*) is shared with the file importer in
+ * graph_import.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef GRAPHQLITE_PERF_TIMING
+#include <time.h>
+#endif
+
+#include "executor/executor_internal.h"
+#include "executor/cypher_executor.h"
+#include "executor/json_builder.h"
+#include "parser/cypher_debug.h"
+
+/* Rows per multi-row INSERT (4 columns x 128 rows stays under 999 variables) */
+#define BULK_BATCH_ROWS 128
+#define BULK_MAX_COLS 4
+
+#define BULK_SAVEPOINT "graphqlite_bulk"
+
+/* Where a node property gets its value from */
+typedef struct {
+    const char *key;
+    int key_id;
+    int column;             /* Row column, or -1 for a constant */
+    bulk_value constant;
+    char *owned;            /* Storage behind constant.text */
+} bulk_prop;
+
+typedef struct {
+    cypher_node_pattern *pattern;
+    bulk_prop *props;
+    int prop_count;
+} bulk_node;
+
+/*
+ * Row layout: column 0 is the unwound element itself, column c > 0 is
+ * element.column_keys[c] (NULL unless the element is a map).
+ */
+typedef struct {
+    bulk_node *nodes;
+    int node_count;
+    const char **column_keys;
+    int column_count;
+} bulk_plan;
+
+/* Buffered cell - text is an offset into the table's string arena */
+typedef struct {
+    int kind;               /* SQLITE_INTEGER, SQLITE_FLOAT or SQLITE_TEXT */
+    int64_t integer;
+    double real;
+    size_t text_off;
+} bulk_cell;
+
+/* Pending rows for one target table */
+typedef struct {
+    int ncols;
+    bulk_cell cells[BULK_BATCH_ROWS * BULK_MAX_COLS];
+    int pending;
+    char *strings;
+    size_t strings_len;
+    size_t strings_cap;
+    sqlite3_stmt *batch_stmt;       /* Full BULK_BATCH_ROWS statement */
+} bulk_table;
+
+/* Tables in flush order: every row is written after the rows it references */
+enum {
+    BULK_TABLE_NODES,
+    BULK_TABLE_LABELS,
+    BULK_TABLE_EDGES,
+    BULK_TABLE_NODE_PROPS,          /* + property_type */
+    BULK_TABLE_EDGE_PROPS = BULK_TABLE_NODE_PROPS + 5,
+    BULK_TABLE_COUNT = BULK_TABLE_EDGE_PROPS + 5
+};
+
+static const char *bulk_insert_heads[BULK_TABLE_COUNT] = {
+    [BULK_TABLE_NODES] = "INSERT INTO nodes (id) VALUES",
+    [BULK_TABLE_LABELS] = "INSERT INTO node_labels (node_id, label) VALUES",
+    [BULK_TABLE_EDGES] = "INSERT INTO edges (id, source_id, target_id, type) VALUES",
+    [BULK_TABLE_NODE_PROPS + PROP_TYPE_INTEGER] = "INSERT INTO node_props_int (node_id, key_id, value) VALUES",
+    [BULK_TABLE_NODE_PROPS + PROP_TYPE_TEXT] = "INSERT INTO node_props_text (node_id, key_id, value) VALUES",
+    [BULK_TABLE_NODE_PROPS + PROP_TYPE_REAL] = "INSERT INTO node_props_real (node_id, key_id, value) VALUES",
+    [BULK_TABLE_NODE_PROPS + PROP_TYPE_BOOLEAN] = "INSERT INTO node_props_bool (node_id, key_id, value) VALUES",
+    [BULK_TABLE_NODE_PROPS + PROP_TYPE_JSON] = "INSERT INTO node_props_json (node_id, key_id, value) VALUES",
+    [BULK_TABLE_EDGE_PROPS + PROP_TYPE_INTEGER] = "INSERT INTO edge_props_int (edge_id, key_id, value) VALUES",
+    [BULK_TABLE_EDGE_PROPS + PROP_TYPE_TEXT] = "INSERT INTO edge_props_text (edge_id, key_id, value) VALUES",
+    [BULK_TABLE_EDGE_PROPS + PROP_TYPE_REAL] = "INSERT INTO edge_props_real (edge_id, key_id, value) VALUES",
+    [BULK_TABLE_EDGE_PROPS + PROP_TYPE_BOOLEAN] = "INSERT INTO edge_props_bool (edge_id, key_id, value) VALUES",
+    [BULK_TABLE_EDGE_PROPS + PROP_TYPE_JSON] = "INSERT INTO edge_props_json (edge_id, key_id, value) VALUES",
+};
+
+static int bulk_table_ncols(int table)
+{
+    switch (table) {
+        case BULK_TABLE_NODES: return 1;
+        case BULK_TABLE_LABELS: return 2;
+        case BULK_TABLE_EDGES: return 4;
+        default: return 3;
+    }
+}
+
+static const char *bulk_prop_tables[] = {
+    [PROP_TYPE_INTEGER] = "node_props_int",
+    [PROP_TYPE_TEXT] = "node_props_text",
+    [PROP_TYPE_REAL] = "node_props_real",
+    [PROP_TYPE_BOOLEAN] = "node_props_bool",
+    [PROP_TYPE_JSON] = "node_props_json",
+};
+
+struct bulk_writer {
+    sqlite3 *db;
+    bulk_table tables[BULK_TABLE_COUNT];
+};
+
+/* Dedupe map for MERGE: property signature -> node created in this batch */
+typedef struct {
+    char *key;
+    int node_id;
+} bulk_merge_entry;
+
+typedef struct {
+    bulk_merge_entry *slots;
+    int capacity;
+    int count;
+} bulk_merge_set;
+
+/* Everything one bulk execution owns */
+typedef struct {
+    cypher_executor *executor;
+    cypher_result *result;
+    bulk_plan plan;
+    bulk_writer *writer;
+    int next_node_id;
+
+    /* MERGE only */
+    sqlite3_stmt *merge_find;
+    bulk_merge_set merged;
+    char *sig;
+    size_t sig_len;
+    size_t sig_cap;
+} bulk_state;
+
+/* ------------------------------------------------------------------------
+ * Shape analysis
+ * ------------------------------------------------------------------------ */
+
+/* Property value expressions that do not depend on per-row evaluation */
+static bool bulk_value_expr_supported(ast_node *value, const char *alias)
+{
+    switch (value->type) {
+        case AST_NODE_LITERAL:
+        case AST_NODE_MAP:
+        case AST_NODE_LIST:
+        case AST_NODE_PARAMETER:
+            return true;
+        case AST_NODE_IDENTIFIER:
+            return strcmp(((cypher_identifier*)value)->name, alias) == 0;
+        case AST_NODE_PROPERTY: {
+            cypher_property *prop = (cypher_property*)value;
+            return prop->expr && prop->expr->type == AST_NODE_IDENTIFIER &&
+                   strcmp(((cypher_identifier*)prop->expr)->name, alias) == 0 &&
+                   prop->property_name && !strchr(prop->property_name, '"');
+        }
+        default:
+            return false;
+    }
+}
+
+/* A path of exactly one node pattern with supported property values */
+static cypher_node_pattern *bulk_single_node(ast_node *pattern, const char *alias)
+{
+    if (pattern->type != AST_NODE_PATH) {
+        return NULL;
+    }
+    cypher_path *path = (cypher_path*)pattern;
+    if (!path->elements || path->elements->count != 1 ||
+        path->elements->items[0]->type != AST_NODE_NODE_PATTERN) {
+        return NULL;
+    }
+
+    cypher_node_pattern *node = (cypher_node_pattern*)path->elements->items[0];
+    if (node->variable && strcmp(node->variable, alias) == 0) {
+        return NULL;
+    }
+    if (node->properties) {
+        if (node->properties->type != AST_NODE_MAP) {
+            return NULL;
+        }
+        cypher_map *map = (cypher_map*)node->properties;
+        for (int i = 0; map->pairs && i < map->pairs->count; i++) {
+            cypher_map_pair *pair = (cypher_map_pair*)map->pairs->items[i];
+            if (!pair->key || !pair->value || !bulk_value_expr_supported(pair->value, alias)) {
+                return NULL;
+            }
+        }
+    }
+    return node;
+}
+
+bool bulk_unwind_supported(cypher_query *query, cypher_unwind *unwind, ast_node *clause)
+{
+    if (!query || !query->clauses || query->clauses->count != 2 ||
+        query->clauses->items[0] != (ast_node*)unwind ||
+        query->clauses->items[1] != clause || !unwind->alias || !unwind->expr) {
+        return false;
+    }
+
+    /* Row source: a parameter, or a list of literals / map literals */
+    if (unwind->expr->type == AST_NODE_LIST) {
+        cypher_list *list = (cypher_list*)unwind->expr;
+        for (int i = 0; list->items && i < list->items->count; i++) {
+            ast_node_type t = list->items->items[i]->type;
+            if (t != AST_NODE_LITERAL && t != AST_NODE_MAP && t != AST_NODE_LIST) {
+                return false;
+            }
+        }
+    } else if (unwind->expr->type != AST_NODE_PARAMETER) {
+        return false;
+    }
+
+    if (clause->type == AST_NODE_CREATE) {
+        cypher_create *create = (cypher_create*)clause;
+        if (!create->pattern || create->pattern->count == 0) {
+            return false;
+        }
+        for (int i = 0; i < create->pattern->count; i++) {
+            cypher_node_pattern *node = bulk_single_node(create->pattern->items[i], unwind->alias);
+            if (!node) {
+                return false;
+            }
+            /* CREATE (a), (a) refers back to the first node */
+            for (int j = 0; node->variable && j < i; j++) {
+                cypher_path *prev = (cypher_path*)create->pattern->items[j];
+                cypher_node_pattern *other = (cypher_node_pattern*)prev->elements->items[0];
+                if (other->variable && strcmp(other->variable, node->variable) == 0) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    if (clause->type == AST_NODE_MERGE) {
+        cypher_merge *merge = (cypher_merge*)clause;
+        if (!merge->pattern || merge->pattern->count != 1 || merge->on_create || merge->on_match) {
+            return false;
+        }
+        cypher_node_pattern *node = bulk_single_node(merge->pattern->items[0], unwind->alias);
+        return node && node->properties &&
+               ((cypher_map*)node->properties)->pairs &&
+               ((cypher_map*)node->properties)->pairs->count > 0;
+    }
+
+    return false;
+}
+
+/* ------------------------------------------------------------------------
+ * Values
+ * ------------------------------------------------------------------------ */
+
+/* Value of a literal, map or list AST node; JSON text goes to *owned */
+static void bulk_value_from_ast(ast_node *expr, bulk_value *out, char **owned)
+{
+    memset(out, 0, sizeof(*out));
+    out->is_null = true;
+
+    if (expr->type == AST_NODE_MAP || expr->type == AST_NODE_LIST) {
+        *owned = serialize_ast_to_json(expr);
+        if (*owned) {
+            out->is_null = false;
+            out->type = PROP_TYPE_JSON;
+            out->text = *owned;
+        }
+        return;
+    }
+    if (expr->type != AST_NODE_LITERAL) {
+        return;
+    }
+
+    cypher_literal *lit = (cypher_literal*)expr;
+    out->is_null = false;
+    switch (lit->literal_type) {
+        case LITERAL_INTEGER:
+            out->type = PROP_TYPE_INTEGER;
+            out->integer = lit->value.integer;
+            break;
+        case LITERAL_DECIMAL:
+            out->type = PROP_TYPE_REAL;
+            out->real = lit->value.decimal;
+            break;
+        case LITERAL_STRING:
+            out->type = PROP_TYPE_TEXT;
+            out->text = lit->value.string;
+            break;
+        case LITERAL_BOOLEAN:
+            out->type = PROP_TYPE_BOOLEAN;
+            out->integer = lit->value.boolean ? 1 : 0;
+            break;
+        default:
+            out->is_null = true;
+            break;
+    }
+}
+
+/* Value of an SQL result column given its json_type() name */
+void bulk_value_from_json(sqlite3_stmt *stmt, int col, const char *json_type, bulk_value *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->is_null = true;
+
+    if (!json_type || sqlite3_column_type(stmt, col) == SQLITE_NULL) {
+        return;
+    }
+
+    out->is_null = false;
+    if (strcmp(json_type, "integer") == 0) {
+        out->type = PROP_TYPE_INTEGER;
+        out->integer = sqlite3_column_int64(stmt, col);
+    } else if (strcmp(json_type, "real") == 0) {
+        out->type = PROP_TYPE_REAL;
+        out->real = sqlite3_column_double(stmt, col);
+    } else if (strcmp(json_type, "true") == 0 || strcmp(json_type, "false") == 0) {
+        out->type = PROP_TYPE_BOOLEAN;
+        out->integer = json_type[0] == 't' ? 1 : 0;
+    } else if (strcmp(json_type, "text") == 0) {
+        out->type = PROP_TYPE_TEXT;
+        out->text = (const char*)sqlite3_column_text(stmt, col);
+    } else if (strcmp(json_type, "object") == 0 || strcmp(json_type, "array") == 0) {
+        out->type = PROP_TYPE_JSON;
+        out->text = (const char*)sqlite3_column_text(stmt, col);
+    } else {
+        out->is_null = true;
+    }
+}
+
+/* ------------------------------------------------------------------------
+ * Plan
+ * ------------------------------------------------------------------------ */
+
+static int bulk_column_for_key(bulk_plan *plan, const char *key)
+{
+    for (int c = 1; c < plan->column_count; c++) {
+        if (strcmp(plan->column_keys[c], key) == 0) {
+            return c;
+        }
+    }
+    plan->column_keys[plan->column_count] = key;
+    return plan->column_count++;
+}
+
+static void bulk_plan_free(bulk_plan *plan)
+{
+    for (int n = 0; n < plan->node_count; n++) {
+        for (int p = 0; p < plan->nodes[n].prop_count; p++) {
+            free(plan->nodes[n].props[p].owned);
+        }
+        free(plan->nodes[n].props);
+    }
+    free(plan->nodes);
+    free(plan->column_keys);
+}
+
+/* Resolve property keys, constants and row columns for each node pattern */
+static int bulk_plan_build(bulk_state *st, ast_list *patterns)
+{
+    cypher_executor *executor = st->executor;
+    bulk_plan *plan = &st->plan;
+
+    int total_props = 0;
+    for (int i = 0; i < patterns->count; i++) {
+        cypher_path *path = (cypher_path*)patterns->items[i];
+        cypher_node_pattern *node = (cypher_node_pattern*)path->elements->items[0];
+        if (node->properties && ((cypher_map*)node->properties)->pairs) {
+            total_props += ((cypher_map*)node->properties)->pairs->count;
+        }
+    }
+
+    plan->nodes = calloc(patterns->count, sizeof(bulk_node));
+    plan->column_keys = calloc(total_props + 1, sizeof(char*));
+    if (!plan->nodes || !plan->column_keys) {
+        return -1;
+    }
+    plan->node_count = patterns->count;
+    plan->column_count = 1;
+
+    for (int i = 0; i < patterns->count; i++) {
+        cypher_path *path = (cypher_path*)patterns->items[i];
+        bulk_node *bn = &plan->nodes[i];
+        bn->pattern = (cypher_node_pattern*)path->elements->items[0];
+
+        cypher_map *map = (cypher_map*)bn->pattern->properties;
+        if (!map || !map->pairs || map->pairs->count == 0) {
+            continue;
+        }
+
+        bn->props = calloc(map->pairs->count, sizeof(bulk_prop));
+        if (!bn->props) {
+            return -1;
+        }
+
+        for (int j = 0; j < map->pairs->count; j++) {
+            cypher_map_pair *pair = (cypher_map_pair*)map->pairs->items[j];
+            bulk_prop *bp = &bn->props[bn->prop_count++];
+            bp->key = pair->key;
+            bp->column = -1;
+            bp->constant.is_null = true;
+
+            bp->key_id = cypher_schema_ensure_property_key(executor->schema_mgr, pair->key);
+            if (bp->key_id < 0) {
+                return -1;
+            }
+
+            switch (pair->value->type) {
+                case AST_NODE_IDENTIFIER:
+                    bp->column = 0;
+                    break;
+                case AST_NODE_PROPERTY:
+                    bp->column = bulk_column_for_key(plan, ((cypher_property*)pair->value)->property_name);
+                    break;
+                case AST_NODE_PARAMETER: {
+                    cypher_parameter *param = (cypher_parameter*)pair->value;
+                    property_value pv;
+                    property_value_init(&pv);
+                    property_type type;
+                    if (executor->params_json &&
+                        get_param_value(executor->params_json, param->name, &type, &pv) == 0) {
+                        bp->constant.is_null = false;
+                        bp->constant.type = type;
+                        bp->constant.integer = type == PROP_TYPE_BOOLEAN ? pv.as_bool : pv.as_int;
+                        bp->constant.real = pv.as_real;
+                        bp->owned = pv.as_str;
+                        bp->constant.text = pv.as_str;
+                    } else {
+                        property_value_free(&pv);
+                    }
+                    break;
+                }
+                default:
+                    bulk_value_from_ast(pair->value, &bp->constant, &bp->owned);
+                    break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* ------------------------------------------------------------------------
+ * Buffered multi-row inserts
+ * ------------------------------------------------------------------------ */
+
+static char *bulk_insert_sql(int table, int rows)
+{
+    int ncols = bulk_table_ncols(table);
+    const char *head = bulk_insert_heads[table];
+    size_t tuple_len = 2 + ncols * 2;       /* "(?,?,?)," */
+    size_t len = strlen(head) + rows * tuple_len + 1;
+
+    char *sql = malloc(len);
+    if (!sql) {
+        return NULL;
+    }
+
+    char *p = sql + sprintf(sql, "%s", head);
+    for (int r = 0; r < rows; r++) {
+        *p++ = r ? ',' : ' ';
+        *p++ = '(';
+        for (int c = 0; c < ncols; c++) {
+            if (c) *p++ = ',';
+            *p++ = '?';
+        }
+        *p++ = ')';
+    }
+    *p = '\0';
+    return sql;
+}
+
+static int bulk_flush_table(bulk_writer *bw, int table)
+{
+    bulk_table *bt = &bw->tables[table];
+    if (bt->pending == 0) {
+        return 0;
+    }
+
+    sqlite3_stmt *stmt = NULL;
+    bool full = (bt->pending == BULK_BATCH_ROWS);
+
+    if (full && bt->batch_stmt) {
+        stmt = bt->batch_stmt;
+    } else {
+        char *sql = bulk_insert_sql(table, bt->pending);
+        if (!sql) {
+            return -1;
+        }
+        int rc = sqlite3_prepare_v2(bw->db, sql, -1, &stmt, NULL);
+        free(sql);
+        if (rc != SQLITE_OK) {
+            CYPHER_DEBUG("Bulk insert prepare failed: %s", sqlite3_errmsg(bw->db));
+            return -1;
+        }
+        if (full) {
+            bt->batch_stmt = stmt;
+        }
+    }
+
+    int ncells = bt->pending * bt->ncols;
+    for (int i = 0; i < ncells; i++) {
+        bulk_cell *cell = &bt->cells[i];
+        switch (cell->kind) {
+            case SQLITE_INTEGER:
+                sqlite3_bind_int64(stmt, i + 1, cell->integer);
+                break;
+            case SQLITE_FLOAT:
+                sqlite3_bind_double(stmt, i + 1, cell->real);
+                break;
+            default:
+                sqlite3_bind_text(stmt, i + 1, bt->strings + cell->text_off, -1, SQLITE_STATIC);
+                break;
+        }
+    }
+
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    if (stmt != bt->batch_stmt) {
+        sqlite3_finalize(stmt);
+    }
+
+    if (rc != SQLITE_DONE) {
+        CYPHER_DEBUG("Bulk insert failed: %s", sqlite3_errmsg(bw->db));
+        return -1;
+    }
+
+    bt->pending = 0;
+    bt->strings_len = 0;
+    return 0;
+}
+
+/* Flush in dependency order: nodes before the rows referencing them */
+int bulk_writer_flush(bulk_writer *bw)
+{
+    for (int t = 0; t < BULK_TABLE_COUNT; t++) {
+        if (bulk_flush_table(bw, t) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+bulk_writer *bulk_writer_create(sqlite3 *db)
+{
+    bulk_writer *bw = calloc(1, sizeof(bulk_writer));
+    if (!bw) {
+        return NULL;
+    }
+    bw->db = db;
+    for (int t = 0; t < BULK_TABLE_COUNT; t++) {
+        bw->tables[t].ncols = bulk_table_ncols(t);
+    }
+    return bw;
+}
+
+void bulk_writer_free(bulk_writer *bw)
+{
+    if (!bw) {
+        return;
+    }
+    for (int t = 0; t < BULK_TABLE_COUNT; t++) {
+        sqlite3_finalize(bw->tables[t].batch_stmt);
+        free(bw->tables[t].strings);
+    }
+    free(bw);
+}
+
+static int bulk_cell_text(bulk_table *bt, bulk_cell *cell, const char *text)
+{
+    size_t len = strlen(text) + 1;
+    if (bt->strings_len + len > bt->strings_cap) {
+        size_t cap = bt->strings_cap ? bt->strings_cap * 2 : 4096;
+        while (cap < bt->strings_len + len) {
+            cap *= 2;
+        }
+        char *grown = realloc(bt->strings, cap);
+        if (!grown) {
+            return -1;
+        }
+        bt->strings = grown;
+        bt->strings_cap = cap;
+    }
+    memcpy(bt->strings + bt->strings_len, text, len);
+    cell->kind = SQLITE_TEXT;
+    cell->text_off = bt->strings_len;
+    bt->strings_len += len;
+    return 0;
+}
+
+/* Start a new row in a table, flushing everything first if it is full */
+static bulk_cell *bulk_row(bulk_writer *bw, int table)
+{
+    bulk_table *bt = &bw->tables[table];
+    if (bt->pending == BULK_BATCH_ROWS && bulk_writer_flush(bw) < 0) {
+        return NULL;
+    }
+    return &bt->cells[bt->pending++ * bt->ncols];
+}
+
+int bulk_write_node(bulk_writer *bw, int node_id)
+{
+    bulk_cell *row = bulk_row(bw, BULK_TABLE_NODES);
+    if (!row) {
+        return -1;
+    }
+    row[0].kind = SQLITE_INTEGER;
+    row[0].integer = node_id;
+    return 0;
+}
+
+int bulk_write_label(bulk_writer *bw, int node_id, const char *label)
+{
+    bulk_cell *row = bulk_row(bw, BULK_TABLE_LABELS);
+    if (!row) {
+        return -1;
+    }
+    row[0].kind = SQLITE_INTEGER;
+    row[0].integer = node_id;
+    return bulk_cell_text(&bw->tables[BULK_TABLE_LABELS], &row[1], label);
+}
+
+int bulk_write_edge(bulk_writer *bw, int edge_id, int source_id, int target_id, const char *type)
+{
+    bulk_cell *row = bulk_row(bw, BULK_TABLE_EDGES);
+    if (!row) {
+        return -1;
+    }
+    row[0].kind = SQLITE_INTEGER;
+    row[0].integer = edge_id;
+    row[1].kind = SQLITE_INTEGER;
+    row[1].integer = source_id;
+    row[2].kind = SQLITE_INTEGER;
+    row[2].integer = target_id;
+    return bulk_cell_text(&bw->tables[BULK_TABLE_EDGES], &row[3], type);
+}
+
+int bulk_write_property(bulk_writer *bw, bool is_edge, int owner_id, int key_id, const bulk_value *v)
+{
+    int table = (is_edge ? BULK_TABLE_EDGE_PROPS : BULK_TABLE_NODE_PROPS) + v->type;
+    bulk_cell *row = bulk_row(bw, table);
+    if (!row) {
+        return -1;
+    }
+    row[0].kind = SQLITE_INTEGER;
+    row[0].integer = owner_id;
+    row[1].kind = SQLITE_INTEGER;
+    row[1].integer = key_id;
+
+    switch (v->type) {
+        case PROP_TYPE_INTEGER:
+        case PROP_TYPE_BOOLEAN:
+            row[2].kind = SQLITE_INTEGER;
+            row[2].integer = v->integer;
+            return 0;
+        case PROP_TYPE_REAL:
+            row[2].kind = SQLITE_FLOAT;
+            row[2].real = v->real;
+            return 0;
+        default:
+            return bulk_cell_text(&bw->tables[table], &row[2], v->text ? v->text : "");
+    }
+}
+
+/* First free id of nodes or edges; explicit ids above it keep sqlite_sequence in step */
+int bulk_reserve_ids(sqlite3 *db, bool edges, int *next_id)
+{
+    sqlite3_stmt *stmt;
+    const char *sql = edges
+        ? "SELECT max(COALESCE((SELECT seq FROM sqlite_sequence WHERE name = 'edges'), 0),"
+          "           COALESCE((SELECT max(id) FROM edges), 0))"
+        : "SELECT max(COALESCE((SELECT seq FROM sqlite_sequence WHERE name = 'nodes'), 0),"
+          "           COALESCE((SELECT max(id) FROM nodes), 0))";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+        return -1;
+    }
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        *next_id = sqlite3_column_int(stmt, 0) + 1;
+    }
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_ROW ? 0 : -1;
+}
+
+/* ------------------------------------------------------------------------
+ * Node creation and MERGE lookup
+ * ------------------------------------------------------------------------ */
+
+static const bulk_value *bulk_prop_value(const bulk_prop *bp, const bulk_value *row)
+{
+    return bp->column < 0 ? &bp->constant : &row[bp->column];
+}
+
+static int bulk_create_node(bulk_state *st, bulk_node *bn, const bulk_value *row)
+{
+    int node_id = st->next_node_id++;
+    if (bulk_write_node(st->writer, node_id) < 0) {
+        return -1;
+    }
+    st->result->nodes_created++;
+
+    if (has_labels(bn->pattern)) {
+        for (int li = 0; li < bn->pattern->labels->count; li++) {
+            const char *label = get_label_string(bn->pattern->labels->items[li]);
+            if (label && bulk_write_label(st->writer, node_id, label) < 0) {
+                return -1;
+            }
+        }
+    }
+
+    for (int p = 0; p < bn->prop_count; p++) {
+        const bulk_value *v = bulk_prop_value(&bn->props[p], row);
+        if (v->is_null) {
+            continue;
+        }
+        if (bulk_write_property(st->writer, false, node_id, bn->props[p].key_id, v) < 0) {
+            return -1;
+        }
+        st->result->properties_set++;
+    }
+
+    return node_id;
+}
+
+/*
+ * One statement finds a node with the MERGE labels and properties whatever
+ * the value types: each property is a UNION ALL over the typed tables
+ * where only the branch matching the bound type (?3i+3) is live.
+ */
+static char *bulk_merge_find_sql(bulk_node *bn)
+{
+    json_builder jb;
+    jbuf_init(&jb, 1024);
+    if (!jbuf_ok(&jb)) {
+        return NULL;
+    }
+
+    jbuf_append(&jb, "SELECT p0.node_id FROM (");
+    for (int p = 0; p < bn->prop_count; p++) {
+        if (p > 0) {
+            jbuf_append(&jb, " AND EXISTS (");
+        }
+        for (int t = PROP_TYPE_INTEGER; t <= PROP_TYPE_JSON; t++) {
+            jbuf_appendf(&jb, "%sSELECT node_id FROM %s WHERE ?%d = %d AND ",
+                         t ? " UNION ALL " : "", bulk_prop_tables[t], 3 * p + 3, t);
+            if (p > 0) {
+                jbuf_append(&jb, "node_id = p0.node_id AND ");
+            }
+            jbuf_appendf(&jb, "key_id = ?%d AND value = ?%d", 3 * p + 1, 3 * p + 2);
+        }
+        jbuf_append(&jb, p == 0 ? ") p0 WHERE 1" : ")");
+    }
+
+    int param = 3 * bn->prop_count + 1;
+    if (has_labels(bn->pattern)) {
+        for (int li = 0; li < bn->pattern->labels->count; li++) {
+            jbuf_appendf(&jb, " AND EXISTS (SELECT 1 FROM node_labels"
+                              " WHERE node_id = p0.node_id AND label = ?%d)", param++);
+        }
+    }
+    jbuf_append(&jb, " LIMIT 1");
+
+    return jbuf_take(&jb);
+}
+
+static void bulk_sig_append(bulk_state *st, const void *data, size_t len)
+{
+    if (st->sig_len + len > st->sig_cap) {
+        size_t cap = st->sig_cap ? st->sig_cap * 2 : 256;
+        while (cap < st->sig_len + len) {
+            cap *= 2;
+        }
+        char *grown = realloc(st->sig, cap);
+        if (!grown) {
+            return;
+        }
+        st->sig = grown;
+        st->sig_cap = cap;
+    }
+    memcpy(st->sig + st->sig_len, data, len);
+    st->sig_len += len;
+}
+
+/* Typed signature of a row's MERGE properties (NUL-terminated in st->sig) */
+static const char *bulk_merge_signature(bulk_state *st, bulk_node *bn, const bulk_value *row)
+{
+    st->sig_len = 0;
+    for (int p = 0; p < bn->prop_count; p++) {
+        const bulk_value *v = bulk_prop_value(&bn->props[p], row);
+        char buf[48];
+        int n;
+        switch (v->type) {
+            case PROP_TYPE_INTEGER:
+            case PROP_TYPE_BOOLEAN:
+                n = snprintf(buf, sizeof(buf), "%d:%lld", v->type, (long long)v->integer);
+                bulk_sig_append(st, buf, n);
+                break;
+            case PROP_TYPE_REAL:
+                n = snprintf(buf, sizeof(buf), "%d:%.17g", v->type, v->real);
+                bulk_sig_append(st, buf, n);
+                break;
+            default:
+                n = snprintf(buf, sizeof(buf), "%d:", v->type);
+                bulk_sig_append(st, buf, n);
+                bulk_sig_append(st, v->text, strlen(v->text));
+                break;
+        }
+        bulk_sig_append(st, "\x1f", 1);
+    }
+    bulk_sig_append(st, "", 1);
+    return st->sig_len ? st->sig : "";
+}
+
+static unsigned long bulk_hash(const char *str)
+{
+    unsigned long hash = 5381;
+    int c;
+    while ((c = *str++)) {
+        hash = ((hash << 5) + hash) + c;
+    }
+    return hash;
+}
+
+static bulk_merge_entry *bulk_merge_slot(bulk_merge_set *set, const char *key)
+{
+    unsigned long i = bulk_hash(key) & (set->capacity - 1);
+    while (set->slots[i].key && strcmp(set->slots[i].key, key) != 0) {
+        i = (i + 1) & (set->capacity - 1);
+    }
+    return &set->slots[i];
+}
+
+static int bulk_merge_remember(bulk_merge_set *set, const char *key, int node_id)
+{
+    if ((set->count + 1) * 2 > set->capacity) {
+        int cap = set->capacity ? set->capacity * 2 : 1024;
+        bulk_merge_entry *old = set->slots;
+        int old_cap = set->capacity;
+
+        set->slots = calloc(cap, sizeof(bulk_merge_entry));
+        if (!set->slots) {
+            set->slots = old;
+            return -1;
+        }
+        set->capacity = cap;
+        for (int i = 0; i < old_cap; i++) {
+            if (old[i].key) {
+                *bulk_merge_slot(set, old[i].key) = old[i];
+            }
+        }
+        free(old);
+    }
+
+    bulk_merge_entry *slot = bulk_merge_slot(set, key);
+    slot->key = strdup(key);
+    if (!slot->key) {
+        return -1;
+    }
+    slot->node_id = node_id;
+    set->count++;
+    return 0;
+}
+
+static int bulk_merge_node(bulk_state *st, bulk_node *bn, const bulk_value *row)
+{
+    for (int p = 0; p < bn->prop_count; p++) {
+        if (bulk_prop_value(&bn->props[p], row)->is_null) {
+            char msg[256];
+            snprintf(msg, sizeof(msg), "Cannot merge node using null property value for '%s'",
+                     bn->props[p].key);
+            set_result_error(st->result, msg);
+            return -1;
+        }
+    }
+
+    /* Created earlier in this batch (not yet flushed) */
+    const char *sig = bulk_merge_signature(st, bn, row);
+    if (st->merged.capacity && bulk_merge_slot(&st->merged, sig)->key) {
+        return 0;
+    }
+
+    sqlite3_stmt *find = st->merge_find;
+    for (int p = 0; p < bn->prop_count; p++) {
+        const bulk_value *v = bulk_prop_value(&bn->props[p], row);
+        sqlite3_bind_int(find, 3 * p + 1, bn->props[p].key_id);
+        switch (v->type) {
+            case PROP_TYPE_INTEGER:
+            case PROP_TYPE_BOOLEAN:
+                sqlite3_bind_int64(find, 3 * p + 2, v->integer);
+                break;
+            case PROP_TYPE_REAL:
+                sqlite3_bind_double(find, 3 * p + 2, v->real);
+                break;
+            default:
+                sqlite3_bind_text(find, 3 * p + 2, v->text, -1, SQLITE_STATIC);
+                break;
+        }
+        sqlite3_bind_int(find, 3 * p + 3, v->type);
+    }
+    if (has_labels(bn->pattern)) {
+        int param = 3 * bn->prop_count + 1;
+        for (int li = 0; li < bn->pattern->labels->count; li++) {
+            sqlite3_bind_text(find, param++, get_label_string(bn->pattern->labels->items[li]),
+                              -1, SQLITE_STATIC);
+        }
+    }
+
+    int rc = sqlite3_step(find);
+    sqlite3_reset(find);
+    if (rc == SQLITE_ROW) {
+        return 0;
+    }
+    if (rc != SQLITE_DONE) {
+        set_result_error(st->result, "Bulk MERGE lookup failed");
+        return -1;
+    }
+
+    int node_id = bulk_create_node(st, bn, row);
+    if (node_id < 0 || bulk_merge_remember(&st->merged, sig, node_id) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+/* ------------------------------------------------------------------------
+ * Rows
+ * ------------------------------------------------------------------------ */
+
+static int bulk_process_row(bulk_state *st, bool merge, const bulk_value *row)
+{
+    for (int n = 0; n < st->plan.node_count; n++) {
+        int rc = merge ? bulk_merge_node(st, &st->plan.nodes[n], row)
+                       : bulk_create_node(st, &st->plan.nodes[n], row);
+        if (rc < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Rows from a list literal: items are literals, lists or map literals */
+static int bulk_rows_from_list(bulk_state *st, cypher_list *list, bool merge, long *rows)
+{
+    int ncols = st->plan.column_count;
+    bulk_value *row = calloc(ncols, sizeof(bulk_value));
+    char **owned = calloc(ncols, sizeof(char*));     /* JSON text behind row[c] */
+    if (!row || !owned) {
+        free(row);
+        free(owned);
+        return -1;
+    }
+
+    int rc = 0;
+    for (int i = 0; list->items && i < list->items->count && rc == 0; i++) {
+        ast_node *item = list->items->items[i];
+
+        bulk_value_from_ast(item, &row[0], &owned[0]);
+        for (int c = 1; c < ncols; c++) {
+            row[c].is_null = true;
+            if (item->type != AST_NODE_MAP) {
+                continue;
+            }
+            cypher_map *map = (cypher_map*)item;
+            for (int j = 0; map->pairs && j < map->pairs->count; j++) {
+                cypher_map_pair *pair = (cypher_map_pair*)map->pairs->items[j];
+                if (pair->key && strcmp(pair->key, st->plan.column_keys[c]) == 0) {
+                    bulk_value_from_ast(pair->value, &row[c], &owned[c]);
+                    break;
+                }
+            }
+        }
+
+        rc = bulk_process_row(st, merge, row);
+        (*rows)++;
+
+        for (int c = 0; c < ncols; c++) {
+            free(owned[c]);
+            owned[c] = NULL;
+        }
+    }
+
+    free(row);
+    free(owned);
+    return rc;
+}
+
+/*
+ * Rows from a JSON parameter. Selects the element and its json type, then
+ * a value/type pair per referenced key:
+ *
+ *   SELECT value, type,
+ *          CASE WHEN type = 'object' THEN json_extract(value, ?3) END,
+ *          CASE WHEN type = 'object' THEN json_type(value, ?3) END, ...
+ *   FROM json_each(json_extract(?1, ?2))
+ */
+static int bulk_rows_from_param(bulk_state *st, cypher_parameter *param, bool merge, long *rows)
+{
+    cypher_executor *executor = st->executor;
+    if (!executor->params_json) {
+        set_result_error(st->result, "UNWIND $param requires parameters");
+        return -1;
+    }
+
+    json_builder jb;
+    jbuf_init(&jb, 256);
+    if (!jbuf_ok(&jb)) {
+        return -1;
+    }
+    jbuf_append(&jb, "SELECT value, type");
+    for (int c = 1; c < st->plan.column_count; c++) {
+        jbuf_appendf(&jb, ", CASE WHEN type = 'object' THEN json_extract(value, ?%d) END"
+                          ", CASE WHEN type = 'object' THEN json_type(value, ?%d) END",
+                     c + 2, c + 2);
+    }
+    jbuf_append(&jb, " FROM json_each(json_extract(?1, ?2))");
+    char *sql = jbuf_take(&jb);
+    if (!sql) {
+        return -1;
+    }
+
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(executor->db, sql, -1, &stmt, NULL);
+    free(sql);
+    if (rc != SQLITE_OK) {
+        set_result_error(st->result, "Failed to prepare UNWIND parameter query");
+        return -1;
+    }
+
+    char path[512];
+    sqlite3_bind_text(stmt, 1, executor->params_json, -1, SQLITE_STATIC);
+    snprintf(path, sizeof(path), "$.%s", param->name);
+    sqlite3_bind_text(stmt, 2, path, -1, SQLITE_TRANSIENT);
+    for (int c = 1; c < st->plan.column_count; c++) {
+        snprintf(path, sizeof(path), "$.\"%s\"", st->plan.column_keys[c]);
+        sqlite3_bind_text(stmt, c + 2, path, -1, SQLITE_TRANSIENT);
+    }
+
+    bulk_value *row = calloc(st->plan.column_count, sizeof(bulk_value));
+    if (!row) {
+        sqlite3_finalize(stmt);
+        return -1;
+    }
+
+    int result_rc = 0;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        bulk_value_from_json(stmt, 0, (const char*)sqlite3_column_text(stmt, 1), &row[0]);
+        for (int c = 1; c < st->plan.column_count; c++) {
+            bulk_value_from_json(stmt, 2 * c, (const char*)sqlite3_column_text(stmt, 2 * c + 1), &row[c]);
+        }
+        if (bulk_process_row(st, merge, row) < 0) {
+            result_rc = -1;
+            break;
+        }
+        (*rows)++;
+    }
+    if (result_rc == 0 && rc != SQLITE_DONE) {
+        set_result_error(st->result, "Failed to read UNWIND parameter rows");
+        result_rc = -1;
+    }
+
+    free(row);
+    sqlite3_finalize(stmt);
+    return result_rc;
+}
+
+/* ------------------------------------------------------------------------
+ * Entry point
+ * ------------------------------------------------------------------------ */
+
+static void bulk_state_free(bulk_state *st)
+{
+    bulk_writer_free(st->writer);
+    sqlite3_finalize(st->merge_find);
+    for (int i = 0; i < st->merged.capacity; i++) {
+        free(st->merged.slots[i].key);
+    }
+    free(st->merged.slots);
+    free(st->sig);
+    bulk_plan_free(&st->plan);
+}
+
+int execute_unwind_bulk(cypher_executor *executor, cypher_unwind *unwind,
+                        ast_node *clause, cypher_result *result)
+{
+    bool merge = (clause->type == AST_NODE_MERGE);
+    ast_list *patterns = merge ? ((cypher_merge*)clause)->pattern : ((cypher_create*)clause)->pattern;
+
+#ifdef GRAPHQLITE_PERF_TIMING
+    struct timespec t_start, t_end;
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+#endif
+
+    bulk_state st;
+    memset(&st, 0, sizeof(st));
+    st.executor = executor;
+    st.result = result;
+    st.writer = bulk_writer_create(executor->db);
+
+    if (!st.writer || sqlite3_exec(executor->db, "SAVEPOINT " BULK_SAVEPOINT, NULL, NULL, NULL) != SQLITE_OK) {
+        bulk_writer_free(st.writer);
+        set_result_error(result, "Failed to start bulk import");
+        return -1;
+    }
+
+    int rc = bulk_plan_build(&st, patterns);
+    if (rc == 0) {
+        rc = bulk_reserve_ids(executor->db, false, &st.next_node_id);
+    }
+    if (rc == 0 && merge) {
+        char *sql = bulk_merge_find_sql(&st.plan.nodes[0]);
+        rc = (sql && sqlite3_prepare_v2(executor->db, sql, -1, &st.merge_find, NULL) == SQLITE_OK) ? 0 : -1;
+        free(sql);
+    }
+
+    long rows = 0;
+    if (rc == 0) {
+        if (unwind->expr->type == AST_NODE_PARAMETER) {
+            rc = bulk_rows_from_param(&st, (cypher_parameter*)unwind->expr, merge, &rows);
+        } else {
+            rc = bulk_rows_from_list(&st, (cypher_list*)unwind->expr, merge, &rows);
+        }
+    }
+    if (rc == 0) {
+        rc = bulk_writer_flush(st.writer);
+    }
+
+    if (rc == 0) {
+        sqlite3_exec(executor->db, "RELEASE " BULK_SAVEPOINT, NULL, NULL, NULL);
+    } else {
+        sqlite3_exec(executor->db, "ROLLBACK TO " BULK_SAVEPOINT, NULL, NULL, NULL);
+        sqlite3_exec(executor->db, "RELEASE " BULK_SAVEPOINT, NULL, NULL, NULL);
+        cypher_schema_discard_cached(executor->schema_mgr);
+        if (!result->error_message) {
+            set_result_error(result, "Bulk UNWIND import failed");
+        }
+        result->nodes_created = 0;
+        result->properties_set = 0;
+    }
+
+#ifdef GRAPHQLITE_PERF_TIMING
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
+    double secs = (t_end.tv_sec - t_start.tv_sec) + (t_end.tv_nsec - t_start.tv_nsec) / 1e9;
+    fprintf(stderr, "[graphqlite] bulk UNWIND %s: %ld rows, %d nodes in %.3fs (%.0f nodes/sec)\n",
+            merge ? "MERGE" : "CREATE", rows, result->nodes_created, secs,
+            secs > 0 ? result->nodes_created / secs : 0.0);
+#else
+    CYPHER_DEBUG("Bulk UNWIND %s: %ld rows, %d nodes created",
+                 merge ? "MERGE" : "CREATE", rows, result->nodes_created);
+#endif
+
+    bulk_state_free(&st);
+
+    if (rc < 0) {
+        return -1;
+    }
+    result->success = true;
+    return 0;
+}
@@ -11,6 +11,7 @@
 
 #include "executor/executor_internal.h"
 #include "executor/cypher_executor.h"
+#include "executor/plan_cache.h"
 #include "parser/cypher_debug.h"
 #include "transform/transform_variables.h"
 
@@ -55,6 +56,13 @@ int execute_match_clause(cypher_executor *executor, cypher_match *match, cypher_
 
 /* Execute MATCH+RETURN query combination */
 int execute_match_return_query(cypher_executor *executor, cypher_match *match, cypher_return *return_clause, cypher_result *result)
+{
+    return execute_match_return_query_plan(executor, match, return_clause, result, NULL);
+}
+
+/* MATCH+RETURN, reusing (or filling in) the plan cache's generated SQL when a plan is given */
+int execute_match_return_query_plan(cypher_executor *executor, cypher_match *match, cypher_return *return_clause,
+                                    cypher_result *result, cypher_plan *plan)
 {
     if (!executor || !match || !return_clause || !result) {
         return -1;
@@ -67,6 +75,14 @@ int execute_match_return_query(cypher_executor *executor, cypher_match *match, c
 
     CYPHER_DEBUG("Executing MATCH+RETURN query");
 
+    /* Cached SQL skips the transform entirely */
+    sqlite3_stmt *cached_stmt = plan_take_stmt(plan);
+    if (cached_stmt) {
+        int cached_rc = build_query_results(executor, cached_stmt, return_clause, result, plan->ctx);
+        release_result_statement(executor, cached_stmt);
+        return cached_rc < 0 ? -1 : 0;
+    }
+
     /* Build SQL query from MATCH and RETURN clauses */
     cypher_transform_context *ctx = cypher_transform_create_context(executor->db);
     if (!ctx) {
@@ -74,6 +90,9 @@ int execute_match_return_query(cypher_executor *executor, cypher_match *match, c
         return -1;
     }
 
+    /* Runs after any writes of the query, so key ids and types are settled */
+    plan_use_catalog(ctx, executor->schema_mgr);
+
     /* Transform MATCH clause to generate FROM/WHERE */
     if (transform_match_clause(ctx, match) < 0) {
         set_result_error(result, "Failed to transform MATCH clause");
@@ -166,11 +185,134 @@ int execute_match_return_query(cypher_executor *executor, cypher_match *match, c
     CYPHER_DEBUG("MATCH+RETURN TIMING: transform=%.2fms, prepare=%.2fms, build_results=%.2fms", transform_ms, prepare_ms, execute_ms);
 #endif
 
-    sqlite3_finalize(stmt);
-    cypher_transform_free_context(ctx);
+    if (!plan_store_sql(plan, sqlite3_sql(stmt), ctx)) {
+        cypher_transform_free_context(ctx);
+    }
+    release_result_statement(executor, stmt);
     return 0;
 }
 
+/* Edge agtype value from a RETURN column: the edge JSON object, or a bare edge id */
+agtype_value* result_edge_value(cypher_executor *executor, const char *value)
+{
+    /* Check if value is already a JSON object (from new RETURN format) */
+    if (value[0] == '{') {
+        return agtype_value_from_edge_json(executor->db, value);
+    }
+
+    /* Legacy path: value is just an edge ID */
+    int64_t edge_id = atoll(value);
+    char *type = NULL;
+    int64_t source_id = 0, target_id = 0;
+
+    if (executor->schema_mgr) {
+        /* Get edge details from edges table */
+        sqlite3_stmt *edge_stmt;
+        const char *edge_sql = "SELECT source_id, target_id, type FROM edges WHERE id = ?";
+        if (sqlite3_prepare_v2(executor->db, edge_sql, -1, &edge_stmt, NULL) == SQLITE_OK) {
+            sqlite3_bind_int64(edge_stmt, 1, edge_id);
+            if (sqlite3_step(edge_stmt) == SQLITE_ROW) {
+                source_id = sqlite3_column_int64(edge_stmt, 0);
+                target_id = sqlite3_column_int64(edge_stmt, 1);
+                const char *type_text = (const char*)sqlite3_column_text(edge_stmt, 2);
+                if (type_text) {
+                    type = strdup(type_text);
+                }
+            }
+            sqlite3_finalize(edge_stmt);
+        }
+    }
+
+    agtype_value *edge = agtype_value_create_edge_with_properties(executor->db, edge_id, type, source_id, target_id);
+    free(type);
+    return edge;
+}
+
+/* Vertex agtype value from a RETURN column: the node JSON object, or a bare node id */
+agtype_value* result_vertex_value(cypher_executor *executor, const char *value)
+{
+    if (value[0] == '{') {
+        return agtype_value_from_vertex_json(executor->db, value);
+    }
+
+    /* Legacy path: value is just a node ID */
+    int64_t node_id = atoll(value);
+    char *label = NULL;
+
+    if (executor->schema_mgr) {
+        sqlite3_stmt *label_stmt;
+        const char *label_sql = "SELECT label FROM node_labels WHERE node_id = ? LIMIT 1";
+        if (sqlite3_prepare_v2(executor->db, label_sql, -1, &label_stmt, NULL) == SQLITE_OK) {
+            sqlite3_bind_int64(label_stmt, 1, node_id);
+            if (sqlite3_step(label_stmt) == SQLITE_ROW) {
+                const char *label_text = (const char*)sqlite3_column_text(label_stmt, 0);
+                if (label_text) {
+                    label = strdup(label_text);
+                }
+            }
+            sqlite3_finalize(label_stmt);
+        }
+    }
+
+    agtype_value *vertex = agtype_value_create_vertex_with_properties(executor->db, node_id, label);
+    free(label);
+    return vertex;
+}
+
+/*
+ * Hand a read-only result statement to the streaming cursor being opened,
+ * instead of reading it into the result. Path columns are assembled from
+ * several lookups per row and are not streamed. Returns true if the cursor
+ * took the statement; the caller must then not finalize it.
+ */
+static bool stream_result_statement(cypher_executor *executor, sqlite3_stmt *stmt,
+                                    cypher_return *return_clause, cypher_transform_context *ctx)
+{
+    cypher_cursor *cursor = executor ? executor->stream : NULL;
+    if (!cursor || cursor->stmt || !sqlite3_stmt_readonly(stmt)) {
+        return false;
+    }
+
+    int column_count = return_clause->items->count;
+    cypher_column_kind *kinds = malloc((column_count > 0 ? column_count : 1) * sizeof(cypher_column_kind));
+    if (!kinds) {
+        return false;
+    }
+
+    for (int i = 0; i < column_count; i++) {
+        cypher_return_item *item = (cypher_return_item*)return_clause->items->items[i];
+        kinds[i] = CYPHER_COLUMN_VALUE;
+        if (item->expr && item->expr->type == AST_NODE_IDENTIFIER) {
+            const char *name = ((cypher_identifier*)item->expr)->name;
+            if (ctx && transform_var_is_path(ctx->var_ctx, name)) {
+                free(kinds);
+                return false;
+            } else if (ctx && transform_var_is_edge(ctx->var_ctx, name)) {
+                kinds[i] = CYPHER_COLUMN_EDGE;
+            } else if (ctx && transform_var_lookup_node(ctx->var_ctx, name)) {
+                kinds[i] = CYPHER_COLUMN_NODE;
+            } else {
+                kinds[i] = CYPHER_COLUMN_PROPERTY;
+            }
+        } else if (item->expr && item->expr->type == AST_NODE_PROPERTY) {
+            kinds[i] = CYPHER_COLUMN_PROPERTY;
+        }
+    }
+
+    cursor->stmt = stmt;
+    cursor->kinds = kinds;
+    return true;
+}
+
+/* Finalize a statement passed to build_query_results unless a cursor took it over */
+void release_result_statement(cypher_executor *executor, sqlite3_stmt *stmt)
+{
+    if (executor && executor->stream && executor->stream->stmt == stmt) {
+        return;
+    }
+    sqlite3_finalize(stmt);
+}
+
 /* Build query results from executed SQL statement */
 int build_query_results(cypher_executor *executor, sqlite3_stmt *stmt, cypher_return *return_clause, cypher_result *result, cypher_transform_context *ctx)
 {
@@ -289,6 +431,12 @@ int build_query_results(cypher_executor *executor, sqlite3_stmt *stmt, cypher_re
     }
     result->column_count = column_count;
 
+    /* A streaming cursor reads the rows itself */
+    if (stream_result_statement(executor, stmt, return_clause, ctx)) {
+        result->success = true;
+        return 0;
+    }
+
     /* Single-pass result reading with incremental realloc.
      * Eliminates the double SQLite execution pass (count then read). */
     int allocated = 64;
@@ -379,72 +527,9 @@ int build_query_results(cypher_executor *executor, sqlite3_stmt *stmt, cypher_re
                             /* Parse the JSON array of element IDs and build path object */
                             result->agtype_data[current_row][col] = build_path_from_ids(executor, ctx, ident->name, value);
                         } else if (ctx && transform_var_is_edge(ctx->var_ctx, ident->name)) {
-                            /* Check if value is already a JSON object (from new RETURN format) */
-                            if (value[0] == '{') {
-                                /* Parse the JSON object directly */
-                                result->agtype_data[current_row][col] = agtype_value_from_edge_json(executor->db, value);
-                            } else {
-                                /* Legacy path: value is just an edge ID */
-                                int64_t edge_id = atoll(value);
-
-                                /* Query the schema to get edge details */
-                                char *type = NULL;
-                                int64_t source_id = 0, target_id = 0;
-
-                                if (executor && executor->schema_mgr) {
-                                    /* Get edge details from edges table */
-                                    sqlite3_stmt *edge_stmt;
-                                    const char *edge_sql = "SELECT source_id, target_id, type FROM edges WHERE id = ?";
-                                    if (sqlite3_prepare_v2(executor->db, edge_sql, -1, &edge_stmt, NULL) == SQLITE_OK) {
-                                        sqlite3_bind_int64(edge_stmt, 1, edge_id);
-                                        if (sqlite3_step(edge_stmt) == SQLITE_ROW) {
-                                            source_id = sqlite3_column_int64(edge_stmt, 0);
-                                            target_id = sqlite3_column_int64(edge_stmt, 1);
-                                            const char *type_text = (const char*)sqlite3_column_text(edge_stmt, 2);
-                                            if (type_text) {
-                                                type = strdup(type_text);
-                                            }
-                                        }
-                                        sqlite3_finalize(edge_stmt);
-                                    }
-                                }
-
-                                /* Create edge agtype value with properties */
-                                result->agtype_data[current_row][col] = agtype_value_create_edge_with_properties(executor->db, edge_id, type, source_id, target_id);
-                                free(type);
-                            }
+                            result->agtype_data[current_row][col] = result_edge_value(executor, value);
                         } else if (ctx && transform_var_lookup_node(ctx->var_ctx, ident->name)) {
-                            /* This is a node variable */
-                            /* Check if value is already a JSON object (from new RETURN format) */
-                            if (value[0] == '{') {
-                                /* Parse the JSON object directly */
-                                result->agtype_data[current_row][col] = agtype_value_from_vertex_json(executor->db, value);
-                            } else {
-                                /* Legacy path: value is just a node ID */
-                                int64_t node_id = atoll(value);
-
-                                /* Query the schema to get node details */
-                                char *label = NULL;
-                                if (executor && executor->schema_mgr) {
-                                    /* Get node label from node_labels table */
-                                    sqlite3_stmt *label_stmt;
-                                    const char *label_sql = "SELECT label FROM node_labels WHERE node_id = ? LIMIT 1";
-                                    if (sqlite3_prepare_v2(executor->db, label_sql, -1, &label_stmt, NULL) == SQLITE_OK) {
-                                        sqlite3_bind_int64(label_stmt, 1, node_id);
-                                        if (sqlite3_step(label_stmt) == SQLITE_ROW) {
-                                            const char *label_text = (const char*)sqlite3_column_text(label_stmt, 0);
-                                            if (label_text) {
-                                                label = strdup(label_text);
-                                            }
-                                        }
-                                        sqlite3_finalize(label_stmt);
-                                    }
-                                }
-
-                                /* Create vertex agtype value with properties */
-                                result->agtype_data[current_row][col] = agtype_value_create_vertex_with_properties(executor->db, node_id, label);
-                                free(label);
-                            }
+                            result->agtype_data[current_row][col] = result_vertex_value(executor, value);
                         } else {
                             /* Not a graph entity - treat as scalar value */
                             result->agtype_data[current_row][col] = create_property_agtype_value(value);
@@ -469,6 +554,13 @@ int build_query_results(cypher_executor *executor, sqlite3_stmt *stmt, cypher_re
         first_step_rc = sqlite3_step(stmt);
     }
 
+    /* A failed step (out of memory in a table-valued function, say) is an error, not the last row */
+    if (first_step_rc != SQLITE_DONE) {
+        result->row_count = current_row;
+        set_result_error(result, sqlite3_errmsg(executor->db));
+        return -1;
+    }
+
     if (current_row == 0) {
         /* No rows — free allocated arrays and return empty */
         free(result->data); result->data = NULL;
@@ -22,6 +22,7 @@
 #include <math.h>
 #include <float.h>
 #include "executor/graph_algorithms.h"
+#include "executor/graph_algo_internal.h"
 
 #define EARTH_RADIUS_KM 6371.0
 #define PI 3.14159265358979323846
@@ -211,6 +212,10 @@ static double* load_edge_weights(sqlite3 *db, csr_graph *graph, const char *weig
         weights[i] = 1.0;
     }
 
+    /* A weighted projection carries its own weights */
+    if (!weight_prop && graph->weights) {
+        memcpy(weights, graph->weights, edge_count * sizeof(double));
+    }
     if (!weight_prop) return weights;
 
     /* Query edge weights */
@@ -271,15 +276,8 @@ graph_algo_result* execute_astar(sqlite3 *db, csr_graph *cached, const char *sou
     int n = graph->node_count;
 
     /* Find source and target nodes */
-    int source = -1, target = -1;
-    for (int i = 0; i < n; i++) {
-        if (graph->user_ids[i] && strcmp(graph->user_ids[i], source_id) == 0) {
-            source = i;
-        }
-        if (graph->user_ids[i] && strcmp(graph->user_ids[i], target_id) == 0) {
-            target = i;
-        }
-    }
+    int source = find_node_by_user_id(graph, source_id);
+    int target = find_node_by_user_id(graph, target_id);
 
     if (source == -1 || target == -1) {
         if (should_free_graph) csr_graph_free(graph);
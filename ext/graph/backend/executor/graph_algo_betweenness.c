@@ -4,6 +4,10 @@
  * Betweenness Centrality using Brandes' algorithm.
  * Measures how often a node lies on shortest paths between other nodes.
  * O(VE) complexity for unweighted graphs.
+ *
+ * Sources are swept in parallel on the connection's worker pool. With a
+ * sample count, only that many pivot sources are run and the scores are
+ * scaled up to estimates, each reported with its estimated standard error.
  */
 
 #include <stddef.h>
@@ -20,46 +24,128 @@
  * For each source node s:
  * 1. BFS to find shortest path counts (sigma) and distances (d)
  * 2. Track predecessors on shortest paths
- * 3. Backtrack to accumulate dependencies (delta)
+ * 3. Backtrack in reverse BFS order to accumulate dependencies (delta)
  * 4. Add delta to betweenness scores
+ *
+ * Predecessors of w are a subset of its in-edges, so they are kept in one
+ * array laid out like the in-edge CSR: w's slice starts at in_row_ptr[w].
  */
 
-/* Dynamic array for predecessors */
+/* Scratch space for one part; kept clean between sources */
 typedef struct {
-    int *data;
-    int count;
-    int capacity;
-} pred_list;
-
-static void pred_list_init(pred_list *p) {
-    p->data = NULL;
-    p->count = 0;
-    p->capacity = 0;
-}
+    int *d;           /* Distance from source, -1 when unvisited */
+    double *sigma;    /* Number of shortest paths */
+    double *delta;    /* Dependency */
+    int *order;       /* Nodes in BFS order */
+    int *pred;        /* Predecessors, sliced by in_row_ptr */
+    int *pred_count;  /* Predecessors recorded per node */
+} brandes_work;
+
+typedef struct {
+    const csr_graph *graph;
+    brandes_work *work;
+} brandes_job;
+
+static void brandes_source(void *data, int part, int s, double *acc, double *acc_sq)
+{
+    brandes_job *job = data;
+    const csr_graph *graph = job->graph;
+    int *d = job->work[part].d;
+    double *sigma = job->work[part].sigma;
+    double *delta = job->work[part].delta;
+    int *order = job->work[part].order;
+    int *pred = job->work[part].pred;
+    int *pred_count = job->work[part].pred_count;
+
+    int front = 0, back = 0;
+    sigma[s] = 1.0;
+    d[s] = 0;
+    order[back++] = s;
+
+    /* BFS phase - find shortest paths */
+    while (front < back) {
+        int v = order[front++];
+
+        for (int j = graph->row_ptr[v]; j < graph->row_ptr[v + 1]; j++) {
+            int w = graph->col_idx[j];
+
+            /* First visit to w? */
+            if (d[w] < 0) {
+                d[w] = d[v] + 1;
+                order[back++] = w;
+            }
 
-static void pred_list_add(pred_list *p, int val) {
-    if (p->count >= p->capacity) {
-        int new_cap = p->capacity == 0 ? 4 : p->capacity * 2;
-        int *new_data = realloc(p->data, new_cap * sizeof(int));
-        if (!new_data) return;
-        p->data = new_data;
-        p->capacity = new_cap;
+            /* Shortest path to w via v? */
+            if (d[w] == d[v] + 1) {
+                sigma[w] += sigma[v];
+                pred[graph->in_row_ptr[w] + pred_count[w]++] = v;
+            }
+        }
+    }
+
+    /* Backtrack phase - accumulate dependencies; order[0] is the source */
+    for (int i = back - 1; i > 0; i--) {
+        int w = order[i];
+
+        const int *p = pred + graph->in_row_ptr[w];
+        for (int j = 0; j < pred_count[w]; j++) {
+            int v = p[j];
+            delta[v] += (sigma[v] / sigma[w]) * (1.0 + delta[w]);
+        }
+
+        acc[w] += delta[w];
+        if (acc_sq) acc_sq[w] += delta[w] * delta[w];
+    }
+
+    for (int i = 0; i < back; i++) {
+        int v = order[i];
+        d[v] = -1;
+        sigma[v] = 0.0;
+        delta[v] = 0.0;
+        pred_count[v] = 0;
     }
-    p->data[p->count++] = val;
 }
 
-static void pred_list_clear(pred_list *p) {
-    p->count = 0;
+static void brandes_work_free(brandes_work *work, int parts)
+{
+    if (!work) return;
+    for (int p = 0; p < parts; p++) {
+        free(work[p].d);
+        free(work[p].sigma);
+        free(work[p].delta);
+        free(work[p].order);
+        free(work[p].pred);
+        free(work[p].pred_count);
+    }
+    free(work);
 }
 
-static void pred_list_free(pred_list *p) {
-    free(p->data);
-    p->data = NULL;
-    p->count = 0;
-    p->capacity = 0;
+static brandes_work* brandes_work_create(int n, int edges, int parts)
+{
+    brandes_work *work = calloc(parts, sizeof(brandes_work));
+    if (!work) return NULL;
+
+    for (int p = 0; p < parts; p++) {
+        work[p].d = malloc(n * sizeof(int));
+        work[p].sigma = calloc(n, sizeof(double));
+        work[p].delta = calloc(n, sizeof(double));
+        work[p].order = malloc(n * sizeof(int));
+        work[p].pred = malloc((edges + 1) * sizeof(int));
+        work[p].pred_count = calloc(n, sizeof(int));
+        if (!work[p].d || !work[p].sigma || !work[p].delta || !work[p].order ||
+            !work[p].pred || !work[p].pred_count) {
+            brandes_work_free(work, parts);
+            return NULL;
+        }
+        for (int i = 0; i < n; i++) {
+            work[p].d[i] = -1;
+        }
+    }
+    return work;
 }
 
-graph_algo_result* execute_betweenness_centrality(sqlite3 *db, csr_graph *cached)
+graph_algo_result* execute_betweenness_centrality(sqlite3 *db, csr_graph *cached, graph_pool *pool,
+                                                  int samples, int seed)
 {
     graph_algo_result *result = malloc(sizeof(graph_algo_result));
     if (!result) return NULL;
@@ -87,121 +173,54 @@ graph_algo_result* execute_betweenness_centrality(sqlite3 *db, csr_graph *cached
     }
 
     int n = graph->node_count;
+    bool sampled = samples > 0;
+    int count = sampled && samples < n ? samples : n;
 
-    /* Allocate betweenness scores (initialized to 0) */
+    /* Betweenness scores (initialized to 0), and squared dependencies for the standard error */
     double *betweenness = calloc(n, sizeof(double));
-    if (!betweenness) {
-        result->error_message = strdup("Failed to allocate betweenness array");
+    double *std_err = sampled ? calloc(n, sizeof(double)) : NULL;
+    int *sources = sampled ? graph_sample_sources(n, count, (unsigned int)seed) : NULL;
+    int parts = graph_pool_source_parts(pool, graph, count);
+    brandes_work *work = brandes_work_create(n, graph->edge_count, parts);
+
+    if (!betweenness || (sampled && (!std_err || !sources)) || !work) {
+        free(betweenness);
+        free(std_err);
+        free(sources);
+        brandes_work_free(work, parts);
         if (should_free_graph) csr_graph_free(graph);
+        result->error_message = strdup("Failed to allocate working arrays");
         return result;
     }
 
-    /* Allocate working arrays */
-    int *sigma = malloc(n * sizeof(int));       /* Number of shortest paths */
-    int *d = malloc(n * sizeof(int));           /* Distance from source */
-    double *delta = malloc(n * sizeof(double)); /* Dependency */
-    pred_list *P = malloc(n * sizeof(pred_list)); /* Predecessors */
-    int *queue = malloc(n * sizeof(int));       /* BFS queue */
-    int *stack = malloc(n * sizeof(int));       /* Stack for backtracking */
+    /* Run Brandes' algorithm from each source node */
+    brandes_job job = {graph, work};
+    int rc = graph_pool_sum_sources(pool, parts, n, sources, count, brandes_source, &job,
+                                    betweenness, std_err);
+    brandes_work_free(work, parts);
+    free(sources);
 
-    if (!sigma || !d || !delta || !P || !queue || !stack) {
+    if (rc < 0) {
         free(betweenness);
-        free(sigma);
-        free(d);
-        free(delta);
-        free(P);
-        free(queue);
-        free(stack);
+        free(std_err);
         if (should_free_graph) csr_graph_free(graph);
         result->error_message = strdup("Failed to allocate working arrays");
         return result;
     }
 
-    /* Initialize predecessor lists */
-    for (int i = 0; i < n; i++) {
-        pred_list_init(&P[i]);
+    if (sampled) {
+        CYPHER_DEBUG("Betweenness estimated from %d of %d sources", count, n);
+        graph_sample_scale(n, count, betweenness, std_err);
     }
 
-    /* Run Brandes' algorithm from each source node */
-    for (int s = 0; s < n; s++) {
-        /* Initialize for this source */
-        for (int i = 0; i < n; i++) {
-            sigma[i] = 0;
-            d[i] = -1;
-            delta[i] = 0.0;
-            pred_list_clear(&P[i]);
-        }
-
-        sigma[s] = 1;
-        d[s] = 0;
-
-        int queue_front = 0, queue_back = 0;
-        int stack_top = 0;
-
-        queue[queue_back++] = s;
-
-        /* BFS phase - find shortest paths */
-        while (queue_front < queue_back) {
-            int v = queue[queue_front++];
-            stack[stack_top++] = v;
-
-            /* Iterate over neighbors of v */
-            for (int j = graph->row_ptr[v]; j < graph->row_ptr[v + 1]; j++) {
-                int w = graph->col_idx[j];
-
-                /* First visit to w? */
-                if (d[w] < 0) {
-                    d[w] = d[v] + 1;
-                    queue[queue_back++] = w;
-                }
-
-                /* Shortest path to w via v? */
-                if (d[w] == d[v] + 1) {
-                    sigma[w] += sigma[v];
-                    pred_list_add(&P[w], v);
-                }
-            }
-        }
-
-        /* Backtrack phase - accumulate dependencies */
-        while (stack_top > 0) {
-            int w = stack[--stack_top];
-
-            for (int i = 0; i < P[w].count; i++) {
-                int v = P[w].data[i];
-                double contribution = ((double)sigma[v] / (double)sigma[w]) * (1.0 + delta[w]);
-                delta[v] += contribution;
-            }
-
-            /* Add to betweenness (skip source node) */
-            if (w != s) {
-                betweenness[w] += delta[w];
-            }
-        }
-    }
-
-    /* For undirected interpretation, divide by 2 */
-    /* We treat the graph as directed, so no division needed */
-
-    /* Normalize by (n-1)(n-2) for comparison across graphs of different sizes */
-    /* This is optional - we'll return raw scores for now */
-
-    /* Free predecessor lists */
-    for (int i = 0; i < n; i++) {
-        pred_list_free(&P[i]);
-    }
+    /* We treat the graph as directed, so no division by 2 */
 
     /* Build JSON result */
-    size_t buf_size = 256 + n * 128;
+    size_t buf_size = 256 + n * 160;
     char *json = malloc(buf_size);
     if (!json) {
         free(betweenness);
-        free(sigma);
-        free(d);
-        free(delta);
-        free(P);
-        free(queue);
-        free(stack);
+        free(std_err);
         if (should_free_graph) csr_graph_free(graph);
         result->error_message = strdup("Failed to allocate result buffer");
         return result;
@@ -215,12 +234,16 @@ graph_algo_result* execute_betweenness_centrality(sqlite3 *db, csr_graph *cached
 
         const char *user_id = graph->user_ids ? graph->user_ids[i] : NULL;
         if (user_id) {
-            ptr += sprintf(ptr, "{\"node_id\":%d,\"user_id\":\"%s\",\"score\":%.6f}",
+            ptr += sprintf(ptr, "{\"node_id\":%d,\"user_id\":\"%s\",\"score\":%.6f",
                           graph->node_ids[i], user_id, betweenness[i]);
         } else {
-            ptr += sprintf(ptr, "{\"node_id\":%d,\"user_id\":null,\"score\":%.6f}",
+            ptr += sprintf(ptr, "{\"node_id\":%d,\"user_id\":null,\"score\":%.6f",
                           graph->node_ids[i], betweenness[i]);
         }
+        if (sampled) {
+            ptr += sprintf(ptr, ",\"stderr\":%.6f", std_err[i]);
+        }
+        ptr += sprintf(ptr, "}");
     }
 
     ptr += sprintf(ptr, "]");
@@ -230,12 +253,7 @@ graph_algo_result* execute_betweenness_centrality(sqlite3 *db, csr_graph *cached
 
     /* Cleanup */
     free(betweenness);
-    free(sigma);
-    free(d);
-    free(delta);
-    free(P);
-    free(queue);
-    free(stack);
+    free(std_err);
     if (should_free_graph) csr_graph_free(graph);
 
     return result;
@@ -8,6 +8,12 @@
  * Uses harmonic centrality to handle disconnected graphs:
  * H(v) = sum of 1/d(v,u) for all reachable nodes u
  * Normalized by (n-1) to produce values in [0,1]
+ *
+ * The BFS runs from every node in parallel on the connection's worker
+ * pool. With a sample count, only that many pivots are searched: edges
+ * count both ways, so d(v,u) = d(u,v) and a BFS from pivot u adds
+ * 1/d(u,v) to every v it reaches, and the sums are scaled up to estimates
+ * reported with their estimated standard error.
  */
 
 #include <stddef.h>
@@ -16,7 +22,132 @@
 #include <stdio.h>
 #include "executor/graph_algo_internal.h"
 
-graph_algo_result* execute_closeness_centrality(sqlite3 *db, csr_graph *cached)
+/* Scratch space for one part; dist is kept at -1 between sources */
+typedef struct {
+    int *dist;
+    int *queue;
+} closeness_work;
+
+typedef struct {
+    const csr_graph *graph;
+    closeness_work *work;
+    int parts;
+    double *closeness;    /* Exact mode: one score per source */
+} closeness_job;
+
+/* BFS from s treating edges as undirected; returns the number of nodes reached */
+static int closeness_bfs(const csr_graph *graph, closeness_work *work, int s)
+{
+    int *dist = work->dist;
+    int *queue = work->queue;
+
+    dist[s] = 0;
+    int queue_front = 0, queue_back = 0;
+    queue[queue_back++] = s;
+
+    while (queue_front < queue_back) {
+        int u = queue[queue_front++];
+
+        /* Explore outgoing edges */
+        for (int j = graph->row_ptr[u]; j < graph->row_ptr[u + 1]; j++) {
+            int v = graph->col_idx[j];
+            if (dist[v] < 0) {
+                dist[v] = dist[u] + 1;
+                queue[queue_back++] = v;
+            }
+        }
+
+        /* Also explore incoming edges (treat as undirected for closeness) */
+        for (int j = graph->in_row_ptr[u]; j < graph->in_row_ptr[u + 1]; j++) {
+            int v = graph->in_col_idx[j];
+            if (dist[v] < 0) {
+                dist[v] = dist[u] + 1;
+                queue[queue_back++] = v;
+            }
+        }
+    }
+    return queue_back;
+}
+
+static void closeness_reset(closeness_work *work, int reached)
+{
+    for (int i = 0; i < reached; i++) {
+        work->dist[work->queue[i]] = -1;
+    }
+}
+
+/* Exact mode: part p scores its own contiguous range of sources */
+static void closeness_part(void *data, int part)
+{
+    closeness_job *job = data;
+    const csr_graph *graph = job->graph;
+    closeness_work *work = &job->work[part];
+    int n = graph->node_count;
+    int first = (int)((long long)n * part / job->parts);
+    int last = (int)((long long)n * (part + 1) / job->parts);
+
+    for (int s = first; s < last; s++) {
+        int reached = closeness_bfs(graph, work, s);
+
+        /* Queue order is discovery order, as the sum was always taken */
+        double harmonic_sum = 0.0;
+        for (int i = 1; i < reached; i++) {
+            harmonic_sum += 1.0 / (double)work->dist[work->queue[i]];
+        }
+
+        /* Normalize by (n-1) to get value in [0,1] */
+        job->closeness[s] = n > 1 ? harmonic_sum / (double)(n - 1) : 0.0;
+        closeness_reset(work, reached);
+    }
+}
+
+/* Sampled mode: pivot s adds 1/d(s,v) to every node v it reaches */
+static void closeness_source(void *data, int part, int s, double *acc, double *acc_sq)
+{
+    closeness_job *job = data;
+    closeness_work *work = &job->work[part];
+    int reached = closeness_bfs(job->graph, work, s);
+
+    for (int i = 1; i < reached; i++) {
+        int v = work->queue[i];
+        double x = 1.0 / (double)work->dist[v];
+        acc[v] += x;
+        acc_sq[v] += x * x;
+    }
+    closeness_reset(work, reached);
+}
+
+static void closeness_work_free(closeness_work *work, int parts)
+{
+    if (!work) return;
+    for (int p = 0; p < parts; p++) {
+        free(work[p].dist);
+        free(work[p].queue);
+    }
+    free(work);
+}
+
+static closeness_work* closeness_work_create(int n, int parts)
+{
+    closeness_work *work = calloc(parts, sizeof(closeness_work));
+    if (!work) return NULL;
+
+    for (int p = 0; p < parts; p++) {
+        work[p].dist = malloc(n * sizeof(int));
+        work[p].queue = malloc(n * sizeof(int));
+        if (!work[p].dist || !work[p].queue) {
+            closeness_work_free(work, parts);
+            return NULL;
+        }
+        for (int i = 0; i < n; i++) {
+            work[p].dist[i] = -1;
+        }
+    }
+    return work;
+}
+
+graph_algo_result* execute_closeness_centrality(sqlite3 *db, csr_graph *cached, graph_pool *pool,
+                                                int samples, int seed)
 {
     graph_algo_result *result = malloc(sizeof(graph_algo_result));
     if (!result) return NULL;
@@ -44,87 +175,62 @@ graph_algo_result* execute_closeness_centrality(sqlite3 *db, csr_graph *cached)
     }
 
     int n = graph->node_count;
+    bool sampled = samples > 0;
+    int count = sampled && samples < n ? samples : n;
 
-    /* Allocate closeness scores (initialized to 0) */
+    /* Closeness scores (initialized to 0), and squared contributions for the standard error */
     double *closeness = calloc(n, sizeof(double));
-    if (!closeness) {
-        result->error_message = strdup("Failed to allocate closeness array");
-        if (should_free_graph) csr_graph_free(graph);
-        return result;
-    }
+    double *std_err = sampled ? calloc(n, sizeof(double)) : NULL;
+    int *sources = sampled ? graph_sample_sources(n, count, (unsigned int)seed) : NULL;
+    int parts = graph_pool_source_parts(pool, graph, count);
+    closeness_work *work = closeness_work_create(n, parts);
 
-    /* Allocate working arrays for BFS */
-    int *dist = malloc(n * sizeof(int));
-    int *queue = malloc(n * sizeof(int));
-
-    if (!dist || !queue) {
+    if (!closeness || (sampled && (!std_err || !sources)) || !work) {
         free(closeness);
-        free(dist);
-        free(queue);
+        free(std_err);
+        free(sources);
+        closeness_work_free(work, parts);
         if (should_free_graph) csr_graph_free(graph);
         result->error_message = strdup("Failed to allocate working arrays");
         return result;
     }
 
-    /* Calculate harmonic closeness for each node */
-    for (int s = 0; s < n; s++) {
-        /* Initialize distances to -1 (unvisited) */
-        for (int i = 0; i < n; i++) {
-            dist[i] = -1;
-        }
-
-        dist[s] = 0;
-        int queue_front = 0, queue_back = 0;
-        queue[queue_back++] = s;
-
-        double harmonic_sum = 0.0;
+    closeness_job job = {graph, work, parts, closeness};
+    int rc = 0;
 
-        /* BFS from source node s */
-        while (queue_front < queue_back) {
-            int u = queue[queue_front++];
-
-            /* Explore outgoing edges */
-            for (int j = graph->row_ptr[u]; j < graph->row_ptr[u + 1]; j++) {
-                int v = graph->col_idx[j];
-
-                if (dist[v] < 0) {
-                    dist[v] = dist[u] + 1;
-                    queue[queue_back++] = v;
-
-                    /* Add contribution to harmonic sum */
-                    harmonic_sum += 1.0 / (double)dist[v];
-                }
-            }
-
-            /* Also explore incoming edges (treat as undirected for closeness) */
-            for (int j = graph->in_row_ptr[u]; j < graph->in_row_ptr[u + 1]; j++) {
-                int v = graph->in_col_idx[j];
-
-                if (dist[v] < 0) {
-                    dist[v] = dist[u] + 1;
-                    queue[queue_back++] = v;
-
-                    /* Add contribution to harmonic sum */
-                    harmonic_sum += 1.0 / (double)dist[v];
-                }
+    if (sampled) {
+        rc = graph_pool_sum_sources(pool, parts, n, sources, count, closeness_source, &job,
+                                    closeness, std_err);
+        if (rc == 0) {
+            CYPHER_DEBUG("Closeness estimated from %d of %d sources", count, n);
+            graph_sample_scale(n, count, closeness, std_err);
+            for (int i = 0; i < n; i++) {
+                closeness[i] = n > 1 ? closeness[i] / (double)(n - 1) : 0.0;
+                std_err[i] = n > 1 ? std_err[i] / (double)(n - 1) : 0.0;
             }
         }
+    } else {
+        /* Calculate harmonic closeness for each node */
+        graph_pool_run(pool, parts, closeness_part, &job);
+    }
 
-        /* Normalize by (n-1) to get value in [0,1] */
-        if (n > 1) {
-            closeness[s] = harmonic_sum / (double)(n - 1);
-        } else {
-            closeness[s] = 0.0;
-        }
+    closeness_work_free(work, parts);
+    free(sources);
+
+    if (rc < 0) {
+        free(closeness);
+        free(std_err);
+        if (should_free_graph) csr_graph_free(graph);
+        result->error_message = strdup("Failed to allocate working arrays");
+        return result;
     }
 
     /* Build JSON result */
-    size_t buf_size = 256 + n * 128;
+    size_t buf_size = 256 + n * 160;
     char *json = malloc(buf_size);
     if (!json) {
         free(closeness);
-        free(dist);
-        free(queue);
+        free(std_err);
         if (should_free_graph) csr_graph_free(graph);
         result->error_message = strdup("Failed to allocate result buffer");
         return result;
@@ -138,12 +244,16 @@ graph_algo_result* execute_closeness_centrality(sqlite3 *db, csr_graph *cached)
 
         const char *user_id = graph->user_ids ? graph->user_ids[i] : NULL;
         if (user_id) {
-            ptr += sprintf(ptr, "{\"node_id\":%d,\"user_id\":\"%s\",\"score\":%.6f}",
+            ptr += sprintf(ptr, "{\"node_id\":%d,\"user_id\":\"%s\",\"score\":%.6f",
                           graph->node_ids[i], user_id, closeness[i]);
         } else {
-            ptr += sprintf(ptr, "{\"node_id\":%d,\"user_id\":null,\"score\":%.6f}",
+            ptr += sprintf(ptr, "{\"node_id\":%d,\"user_id\":null,\"score\":%.6f",
                           graph->node_ids[i], closeness[i]);
         }
+        if (sampled) {
+            ptr += sprintf(ptr, ",\"stderr\":%.6f", std_err[i]);
+        }
+        ptr += sprintf(ptr, "}");
     }
 
     ptr += sprintf(ptr, "]");
@@ -153,8 +263,7 @@ graph_algo_result* execute_closeness_centrality(sqlite3 *db, csr_graph *cached)
 
     /* Cleanup */
     free(closeness);
-    free(dist);
-    free(queue);
+    free(std_err);
     if (should_free_graph) csr_graph_free(graph);
 
     return result;
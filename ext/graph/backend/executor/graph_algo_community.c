@@ -11,13 +11,97 @@
 #include "executor/graph_algorithms.h"
 #include "executor/graph_algo_internal.h"
 
+/*
+ * Label counts for one part: a small open-addressing table sized for the
+ * highest-degree node, so parts need no O(N) scratch of their own.
+ */
+typedef struct {
+    int *keys;            /* Label in each slot, -1 when empty */
+    int *counts;
+    int *touched;         /* Slots in use for the current node */
+    unsigned int mask;
+} lpa_counts;
+
+typedef struct {
+    const csr_graph *graph;
+    const int *labels;
+    int *new_labels;
+    const int *bounds;
+    lpa_counts *counts;   /* One per part */
+    int *part_changes;
+} lpa_job;
+
+static inline void lpa_count(lpa_counts *c, int label, int *touched_count)
+{
+    unsigned int h = ((unsigned int)label * 2654435761u) & c->mask;
+    while (c->keys[h] != -1 && c->keys[h] != label) {
+        h = (h + 1) & c->mask;
+    }
+    if (c->keys[h] == -1) {
+        c->keys[h] = label;
+        c->counts[h] = 0;
+        c->touched[(*touched_count)++] = (int)h;
+    }
+    c->counts[h]++;
+}
+
+static void label_propagation_part(void *data, int part)
+{
+    lpa_job *job = data;
+    const csr_graph *graph = job->graph;
+    const int *labels = job->labels;
+    lpa_counts *c = &job->counts[part];
+    int changes = 0;
+
+    for (int i = job->bounds[part]; i < job->bounds[part + 1]; i++) {
+        int in_start = graph->in_row_ptr[i];
+        int in_end = graph->in_row_ptr[i + 1];
+        int out_start = graph->row_ptr[i];
+        int out_end = graph->row_ptr[i + 1];
+
+        if (in_start == in_end && out_start == out_end) {
+            job->new_labels[i] = labels[i];
+            continue;
+        }
+
+        /* Count incoming and outgoing neighbor labels */
+        int touched_count = 0;
+        for (int j = in_start; j < in_end; j++) {
+            lpa_count(c, labels[graph->in_col_idx[j]], &touched_count);
+        }
+        for (int j = out_start; j < out_end; j++) {
+            lpa_count(c, labels[graph->col_idx[j]], &touched_count);
+        }
+
+        /* Find best label: most common, smallest on ties */
+        int best_label = labels[i];
+        int best_count = 0;
+
+        for (int t = 0; t < touched_count; t++) {
+            int slot = c->touched[t];
+            int label = c->keys[slot];
+            int count = c->counts[slot];
+            if (count > best_count || (count == best_count && label < best_label)) {
+                best_count = count;
+                best_label = label;
+            }
+            c->keys[slot] = -1;
+        }
+
+        job->new_labels[i] = best_label;
+        if (best_label != labels[i]) changes++;
+    }
+    job->part_changes[part] = changes;
+}
+
 /*
  * Execute Label Propagation community detection
  *
  * Each node adopts the most common label among its neighbors.
- * Optimized with sparse label counting for O(E) per iteration.
+ * Optimized with sparse label counting for O(E) per iteration. Labels are
+ * updated synchronously, so parts of the node range run independently.
  */
-graph_algo_result* execute_label_propagation(sqlite3 *db, csr_graph *cached, int iterations)
+graph_algo_result* execute_label_propagation(sqlite3 *db, csr_graph *cached, graph_pool *pool, int iterations)
 {
     graph_algo_result *result = calloc(1, sizeof(graph_algo_result));
     if (!result) return NULL;
@@ -61,78 +145,72 @@ graph_algo_result* execute_label_propagation(sqlite3 *db, csr_graph *cached, int
         labels[i] = i;
     }
 
-    /* Sparse label counting arrays */
-    int *label_counts = calloc(n, sizeof(int));
-    int *touched_labels = malloc(n * sizeof(int));
+    /* Per-part label counting tables, sized for the highest degree */
+    int parts = graph_pool_parts(pool, graph);
+    int max_degree = 0;
+    for (int i = 0; i < n; i++) {
+        int degree = (graph->in_row_ptr[i + 1] - graph->in_row_ptr[i]) +
+                     (graph->row_ptr[i + 1] - graph->row_ptr[i]);
+        if (degree > max_degree) max_degree = degree;
+    }
+    unsigned int slots = 16;
+    while (slots < (unsigned int)max_degree * 2) slots *= 2;
+
+    int *bounds = malloc((parts + 1) * sizeof(int));
+    int *part_changes = malloc(parts * sizeof(int));
+    lpa_counts *counts = calloc(parts, sizeof(lpa_counts));
+    bool scratch_ok = bounds && part_changes && counts;
+    for (int p = 0; scratch_ok && p < parts; p++) {
+        counts[p].keys = malloc(slots * sizeof(int));
+        counts[p].counts = malloc(slots * sizeof(int));
+        counts[p].touched = malloc((max_degree + 1) * sizeof(int));
+        counts[p].mask = slots - 1;
+        scratch_ok = counts[p].keys && counts[p].counts && counts[p].touched;
+        if (counts[p].keys) memset(counts[p].keys, 0xff, slots * sizeof(int));
+    }
 
-    if (!label_counts || !touched_labels) {
+    if (!scratch_ok) {
+        for (int p = 0; counts && p < parts; p++) {
+            free(counts[p].keys);
+            free(counts[p].counts);
+            free(counts[p].touched);
+        }
+        free(counts);
+        free(bounds);
+        free(part_changes);
         free(labels);
         free(new_labels);
-        free(label_counts);
-        free(touched_labels);
         if (should_free_graph) csr_graph_free(graph);
         result->success = false;
         result->error_message = strdup("Memory allocation failed");
         return result;
     }
 
-    /* Label propagation iterations */
-    for (int iter = 0; iter < iterations; iter++) {
-        int changes = 0;
-
-        for (int i = 0; i < n; i++) {
-            int in_start = graph->in_row_ptr[i];
-            int in_end = graph->in_row_ptr[i + 1];
-            int out_start = graph->row_ptr[i];
-            int out_end = graph->row_ptr[i + 1];
-
-            int neighbor_count = (in_end - in_start) + (out_end - out_start);
-
-            if (neighbor_count == 0) {
-                new_labels[i] = labels[i];
-                continue;
-            }
-
-            int touched_count = 0;
-
-            /* Count incoming neighbor labels */
-            for (int j = in_start; j < in_end; j++) {
-                int label = labels[graph->in_col_idx[j]];
-                if (label_counts[label] == 0) {
-                    touched_labels[touched_count++] = label;
-                }
-                label_counts[label]++;
-            }
-
-            /* Count outgoing neighbor labels */
-            for (int j = out_start; j < out_end; j++) {
-                int label = labels[graph->col_idx[j]];
-                if (label_counts[label] == 0) {
-                    touched_labels[touched_count++] = label;
-                }
-                label_counts[label]++;
-            }
-
-            /* Find best label */
-            int best_label = labels[i];
-            int best_count = 0;
-
-            for (int t = 0; t < touched_count; t++) {
-                int label = touched_labels[t];
-                int count = label_counts[label];
-                if (count > best_count || (count == best_count && label < best_label)) {
-                    best_count = count;
-                    best_label = label;
-                }
+    /* Balance parts on in- plus out-degree */
+    if (parts > 1) {
+        int *work = malloc((n + 1) * sizeof(int));
+        if (work) {
+            for (int i = 0; i <= n; i++) {
+                work[i] = graph->in_row_ptr[i] + graph->row_ptr[i];
             }
+            graph_partition_rows(work, n, parts, bounds);
+            free(work);
+        } else {
+            graph_partition_rows(graph->row_ptr, n, parts, bounds);
+        }
+    } else {
+        bounds[0] = 0;
+        bounds[1] = n;
+    }
 
-            /* Reset touched labels */
-            for (int t = 0; t < touched_count; t++) {
-                label_counts[touched_labels[t]] = 0;
-            }
+    /* Label propagation iterations */
+    for (int iter = 0; iter < iterations; iter++) {
+        lpa_job job = {graph, labels, new_labels, bounds, counts, part_changes};
+        graph_pool_run(pool, parts, label_propagation_part, &job);
 
-            new_labels[i] = best_label;
-            if (new_labels[i] != labels[i]) changes++;
+        int changes = 0;
+        for (int p = 0; p < parts; p++) {
+            changes += part_changes[p];
         }
 
         int *tmp = labels;
@@ -144,8 +222,14 @@ graph_algo_result* execute_label_propagation(sqlite3 *db, csr_graph *cached, int
         if (changes == 0) break;
     }
 
-    free(label_counts);
-    free(touched_labels);
+    for (int p = 0; p < parts; p++) {
+        free(counts[p].keys);
+        free(counts[p].counts);
+        free(counts[p].touched);
+    }
+    free(counts);
+    free(bounds);
+    free(part_changes);
 
     /* Map labels to community IDs */
     int *label_to_community = malloc(n * sizeof(int));
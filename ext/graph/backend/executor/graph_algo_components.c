@@ -83,6 +83,100 @@ static void uf_union(union_find *uf, int x, int y)
     }
 }
 
+#if GRAPH_POOL_THREADS
+/*
+ * Lock-free variant for parallel WCC: a root is only ever linked under a
+ * smaller root with a CAS, so the forest stays acyclic while parts union
+ * concurrently, and finds halve paths as they go.
+ */
+static int cuf_find(int *parent, int x)
+{
+    for (;;) {
+        int p = __atomic_load_n(&parent[x], __ATOMIC_RELAXED);
+        if (p == x) return x;
+        int gp = __atomic_load_n(&parent[p], __ATOMIC_RELAXED);
+        if (gp != p) {
+            __atomic_compare_exchange_n(&parent[x], &p, gp, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        }
+        x = gp;
+    }
+}
+
+static void cuf_union(int *parent, int x, int y)
+{
+    for (;;) {
+        x = cuf_find(parent, x);
+        y = cuf_find(parent, y);
+        if (x == y) return;
+        if (x < y) {
+            int tmp = x;
+            x = y;
+            y = tmp;
+        }
+        int expected = x;
+        if (__atomic_compare_exchange_n(&parent[x], &expected, y, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            return;
+        }
+    }
+}
+
+typedef struct {
+    const csr_graph *graph;
+    int *parent;
+    const int *bounds;
+} wcc_job;
+
+static void wcc_part(void *data, int part)
+{
+    wcc_job *job = data;
+    const csr_graph *graph = job->graph;
+
+    for (int u = job->bounds[part]; u < job->bounds[part + 1]; u++) {
+        for (int j = graph->row_ptr[u]; j < graph->row_ptr[u + 1]; j++) {
+            cuf_union(job->parent, u, graph->col_idx[j]);
+        }
+    }
+}
+#endif
+
+/* Union all edges (treating them as undirected); true if parts ran concurrently */
+static bool wcc_union_edges(const csr_graph *graph, graph_pool *pool, union_find *uf)
+{
+#if GRAPH_POOL_THREADS
+    int parts = graph_pool_parts(pool, graph);
+    if (parts > 1) {
+        int *bounds = malloc((parts + 1) * sizeof(int));
+        if (bounds) {
+            graph_partition_rows(graph->row_ptr, graph->node_count, parts, bounds);
+            wcc_job job = {graph, uf->parent, bounds};
+            graph_pool_run(pool, parts, wcc_part, &job);
+            free(bounds);
+            return true;
+        }
+    }
+#else
+    (void)pool;
+#endif
+
+    for (int u = 0; u < graph->node_count; u++) {
+        for (int j = graph->row_ptr[u]; j < graph->row_ptr[u + 1]; j++) {
+            uf_union(uf, u, graph->col_idx[j]);
+        }
+    }
+    return false;
+}
+
+/* Root of x; forests built concurrently are not rank-balanced, so walk them iteratively */
+static int wcc_root(union_find *uf, int x, bool concurrent)
+{
+#if GRAPH_POOL_THREADS
+    if (concurrent) return cuf_find(uf->parent, x);
+#else
+    (void)concurrent;
+#endif
+    return uf_find(uf, x);
+}
+
 /*
  * =============================================================================
  * Weakly Connected Components (WCC)
@@ -90,8 +184,10 @@ static void uf_union(union_find *uf, int x, int y)
  *
  * Treats directed graph as undirected and finds connected components.
  * Uses Union-Find for O(V + E * α(V)) complexity where α is inverse Ackermann.
+ * Component ids are numbered by first node, so they do not depend on the
+ * union order or the number of threads.
  */
-graph_algo_result* execute_wcc(sqlite3 *db, csr_graph *cached)
+graph_algo_result* execute_wcc(sqlite3 *db, csr_graph *cached, graph_pool *pool)
 {
     graph_algo_result *result = malloc(sizeof(graph_algo_result));
     if (!result) return NULL;
@@ -111,15 +207,18 @@ graph_algo_result* execute_wcc(sqlite3 *db, csr_graph *cached)
         should_free_graph = true;
     }
 
-    if (!graph) {
+    if (!graph || graph->node_count <= 0) {
         /* Empty graph - no nodes exist */
+        if (graph && should_free_graph) csr_graph_free(graph);
         result->success = true;
         result->json_result = strdup("[]");
         return result;
     }
 
+    int n = graph->node_count;
+
     /* Create Union-Find structure */
-    union_find *uf = uf_create(graph->node_count);
+    union_find *uf = uf_create(n);
     if (!uf) {
         result->error_message = strdup("Failed to allocate Union-Find structure");
         if (should_free_graph) csr_graph_free(graph);
@@ -127,16 +226,11 @@ graph_algo_result* execute_wcc(sqlite3 *db, csr_graph *cached)
     }
 
     /* Process all edges (treating as undirected) */
-    for (int u = 0; u < graph->node_count; u++) {
-        for (int j = graph->row_ptr[u]; j < graph->row_ptr[u + 1]; j++) {
-            int v = graph->col_idx[j];
-            uf_union(uf, u, v);
-        }
-    }
+    bool concurrent = wcc_union_edges(graph, pool, uf);
 
     /* Normalize component IDs to be contiguous starting from 0 */
-    int *component_map = calloc(graph->node_count, sizeof(int));
-    int *component = malloc(graph->node_count * sizeof(int));
+    int *component_map = calloc((size_t)n, sizeof(int));
+    int *component = malloc((size_t)n * sizeof(int));
     int next_component = 0;
 
     if (!component_map || !component) {
@@ -149,13 +243,13 @@ graph_algo_result* execute_wcc(sqlite3 *db, csr_graph *cached)
     }
 
     /* Initialize component_map to -1 */
-    for (int i = 0; i < graph->node_count; i++) {
+    for (int i = 0; i < n; i++) {
         component_map[i] = -1;
     }
 
     /* Assign contiguous component IDs */
-    for (int i = 0; i < graph->node_count; i++) {
-        int root = uf_find(uf, i);
+    for (int i = 0; i < n; i++) {
+        int root = wcc_root(uf, i, concurrent);
         if (component_map[root] == -1) {
             component_map[root] = next_component++;
         }
@@ -163,7 +257,7 @@ graph_algo_result* execute_wcc(sqlite3 *db, csr_graph *cached)
     }
 
     /* Build JSON result */
-    size_t buf_size = 256 + graph->node_count * 128;
+    size_t buf_size = 256 + n * 128;
     char *json = malloc(buf_size);
     if (!json) {
         free(component_map);
@@ -177,7 +271,7 @@ graph_algo_result* execute_wcc(sqlite3 *db, csr_graph *cached)
     char *ptr = json;
     ptr += sprintf(ptr, "[");
 
-    for (int i = 0; i < graph->node_count; i++) {
+    for (int i = 0; i < n; i++) {
         if (i > 0) ptr += sprintf(ptr, ",");
 
         const char *user_id = graph->user_ids ? graph->user_ids[i] : NULL;
@@ -31,6 +31,44 @@ static int compare_ev_desc(const void *a, const void *b)
     return 0;
 }
 
+/* One power iteration step over a range of nodes; pass 0 multiplies, pass 1 normalizes */
+typedef struct {
+    const csr_graph *graph;
+    const double *ev;
+    double *ev_new;
+    double norm;
+    const int *bounds;
+    double *part_diff;
+} ev_job;
+
+static void eigenvector_multiply_part(void *data, int part)
+{
+    ev_job *job = data;
+    const csr_graph *graph = job->graph;
+
+    /* For each node, sum the eigenvector values of nodes pointing to it */
+    for (int i = job->bounds[part]; i < job->bounds[part + 1]; i++) {
+        double sum = 0.0;
+        for (int j = graph->in_row_ptr[i]; j < graph->in_row_ptr[i + 1]; j++) {
+            sum += job->ev[graph->in_col_idx[j]];
+        }
+        job->ev_new[i] = sum;
+    }
+}
+
+static void eigenvector_normalize_part(void *data, int part)
+{
+    ev_job *job = data;
+    double max_diff = 0.0;
+
+    for (int i = job->bounds[part]; i < job->bounds[part + 1]; i++) {
+        job->ev_new[i] /= job->norm;
+        double diff = fabs(job->ev_new[i] - job->ev[i]);
+        if (diff > max_diff) max_diff = diff;
+    }
+    job->part_diff[part] = max_diff;
+}
+
 /*
  * Execute Eigenvector Centrality algorithm
  *
@@ -38,7 +76,7 @@ static int compare_ev_desc(const void *a, const void *b)
  * The centrality score for each node is proportional to the sum of centrality
  * scores of its neighbors.
  */
-graph_algo_result* execute_eigenvector_centrality(sqlite3 *db, csr_graph *cached, int iterations)
+graph_algo_result* execute_eigenvector_centrality(sqlite3 *db, csr_graph *cached, graph_pool *pool, int iterations)
 {
     graph_algo_result *result = calloc(1, sizeof(graph_algo_result));
     if (!result) return NULL;
@@ -65,13 +103,18 @@ graph_algo_result* execute_eigenvector_centrality(sqlite3 *db, csr_graph *cached
 
     int n = graph->node_count;
 
-    /* Allocate eigenvector arrays */
+    /* Allocate eigenvector arrays and the per-part ranges */
+    int parts = graph_pool_parts(pool, graph);
     double *ev = malloc(n * sizeof(double));
     double *ev_new = malloc(n * sizeof(double));
+    int *bounds = malloc((parts + 1) * sizeof(int));
+    double *part_diff = malloc(parts * sizeof(double));
 
-    if (!ev || !ev_new) {
+    if (!ev || !ev_new || !bounds || !part_diff) {
         free(ev);
         free(ev_new);
+        free(bounds);
+        free(part_diff);
         if (should_free_graph) csr_graph_free(graph);
         result->success = false;
         result->error_message = strdup("Memory allocation failed");
@@ -87,54 +130,39 @@ graph_algo_result* execute_eigenvector_centrality(sqlite3 *db, csr_graph *cached
     /* Power iteration */
     double convergence_threshold = 1e-10;
     int actual_iters = 0;
+    graph_partition_rows(graph->in_row_ptr, n, parts, bounds);
 
     for (int iter = 0; iter < iterations; iter++) {
         actual_iters++;
 
-        /* Initialize new eigenvector to zero */
-        for (int i = 0; i < n; i++) {
-            ev_new[i] = 0.0;
-        }
-
         /* Multiply by adjacency matrix (using incoming edges) */
-        /* For each node, sum the eigenvector values of nodes pointing to it */
-        for (int i = 0; i < n; i++) {
-            int in_start = graph->in_row_ptr[i];
-            int in_end = graph->in_row_ptr[i + 1];
-
-            for (int j = in_start; j < in_end; j++) {
-                int source = graph->in_col_idx[j];
-                ev_new[i] += ev[source];
-            }
-        }
+        ev_job job = {graph, ev, ev_new, 1.0, bounds, part_diff};
+        graph_pool_run(pool, parts, eigenvector_multiply_part, &job);
 
-        /* L2 normalize the new eigenvector */
+        /* L2 norm, summed in node order so it does not depend on the parts */
         double norm = 0.0;
         for (int i = 0; i < n; i++) {
             norm += ev_new[i] * ev_new[i];
         }
         norm = sqrt(norm);
 
-        /* Handle zero norm (disconnected graph) */
+        /* Normalize and check convergence */
+        double max_diff = 0.0;
         if (norm < 1e-15) {
-            /* Fall back to uniform distribution */
+            /* Zero norm (disconnected graph): fall back to uniform distribution */
             for (int i = 0; i < n; i++) {
                 ev_new[i] = init_val;
+                double diff = fabs(ev_new[i] - ev[i]);
+                if (diff > max_diff) max_diff = diff;
             }
-            norm = 1.0;
         } else {
-            for (int i = 0; i < n; i++) {
-                ev_new[i] /= norm;
+            job.norm = norm;
+            graph_pool_run(pool, parts, eigenvector_normalize_part, &job);
+            for (int p = 0; p < parts; p++) {
+                if (part_diff[p] > max_diff) max_diff = part_diff[p];
             }
         }
 
-        /* Check convergence */
-        double max_diff = 0.0;
-        for (int i = 0; i < n; i++) {
-            double diff = fabs(ev_new[i] - ev[i]);
-            if (diff > max_diff) max_diff = diff;
-        }
-
         /* Swap arrays */
         double *tmp = ev;
         ev = ev_new;
@@ -147,6 +175,8 @@ graph_algo_result* execute_eigenvector_centrality(sqlite3 *db, csr_graph *cached
     }
 
     CYPHER_DEBUG("Eigenvector Centrality completed in %d iterations", actual_iters);
+    free(bounds);
+    free(part_diff);
 
     /* Build results array for sorting */
     ev_result *results = malloc(n * sizeof(ev_result));
@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "executor/graph_algorithms.h"
+#include "executor/graph_algo_internal.h"
 
 /* Helper to get neighbors as a sorted array for efficient intersection */
 static int* get_neighbors_sorted(csr_graph *graph, int node_idx, int *count) {
@@ -134,13 +135,7 @@ graph_algo_result* execute_knn(sqlite3 *db, csr_graph *cached, const char *node_
     }
 
     /* Find the source node index */
-    int source_idx = -1;
-    for (int i = 0; i < graph->node_count; i++) {
-        if (graph->user_ids[i] && strcmp(graph->user_ids[i], node_id) == 0) {
-            source_idx = i;
-            break;
-        }
-    }
+    int source_idx = find_node_by_user_id(graph, node_id);
 
     if (source_idx < 0) {
         result->success = true;
@@ -27,6 +27,122 @@ static int compare_pr_desc(const void *a, const void *b)
     return 0;
 }
 
+/*
+ * Parallel iteration. Each part owns a range of target nodes and pulls
+ * the contributions of their sources in ascending source order, which is
+ * the order the push loop adds them in, so every thread count produces
+ * the same floats as the serial loop.
+ */
+typedef struct {
+    const int *in_row_ptr;
+    const int *pull_src;      /* Sources of each target's in-edges, ascending */
+    const float *inv_out_degree;
+    const float *contrib;     /* damping * pr / out_degree, this iteration */
+    float *contrib_next;
+    float *pr;
+    float *pr_new;
+    float dampf;
+    float teleport;
+    const int *bounds;
+    float *part_diff;
+} pr_job;
+
+static void pagerank_part(void *data, int part)
+{
+    pr_job *job = data;
+    float max_diff = 0.0f;
+
+    for (int t = job->bounds[part]; t < job->bounds[part + 1]; t++) {
+        float acc = job->teleport;
+        for (int j = job->in_row_ptr[t]; j < job->in_row_ptr[t + 1]; j++) {
+            acc += job->contrib[job->pull_src[j]];
+        }
+        job->pr_new[t] = acc;
+        job->contrib_next[t] = job->dampf * acc * job->inv_out_degree[t];
+
+        float diff = acc - job->pr[t];
+        if (diff < 0) diff = -diff;
+        if (diff > max_diff) max_diff = diff;
+    }
+    job->part_diff[part] = max_diff;
+}
+
+/* Sources of every in-edge, grouped by target and ascending within each group */
+static int* pagerank_pull_sources(const csr_graph *graph)
+{
+    int n = graph->node_count;
+    int *pull_src = malloc((graph->edge_count + 1) * sizeof(int));
+    int *fill = malloc((n + 1) * sizeof(int));
+    if (!pull_src || !fill) {
+        free(pull_src);
+        free(fill);
+        return NULL;
+    }
+
+    memcpy(fill, graph->in_row_ptr, n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        for (int j = graph->row_ptr[i]; j < graph->row_ptr[i + 1]; j++) {
+            pull_src[fill[graph->col_idx[j]]++] = i;
+        }
+    }
+    free(fill);
+    return pull_src;
+}
+
+/* Run the iterations over parts; returns the iteration count, -1 on allocation failure */
+static int pagerank_parallel(const csr_graph *graph, graph_pool *pool, int parts,
+                             float *pr, float *pr_new, const float *inv_out_degree,
+                             float dampf, float teleport, int iterations, float **out)
+{
+    int n = graph->node_count;
+    int *pull_src = pagerank_pull_sources(graph);
+    float *contrib = malloc(n * sizeof(float));
+    float *contrib_next = malloc(n * sizeof(float));
+    int *bounds = malloc((parts + 1) * sizeof(int));
+    float *part_diff = malloc(parts * sizeof(float));
+    int actual_iters = -1;
+
+    if (pull_src && contrib && contrib_next && bounds && part_diff) {
+        graph_partition_rows(graph->in_row_ptr, n, parts, bounds);
+        for (int i = 0; i < n; i++) {
+            contrib[i] = dampf * pr[i] * inv_out_degree[i];
+        }
+
+        pr_job job = {graph->in_row_ptr, pull_src, inv_out_degree, contrib, contrib_next,
+                      pr, pr_new, dampf, teleport, bounds, part_diff};
+        actual_iters = 0;
+        for (int iter = 0; iter < iterations; iter++) {
+            actual_iters++;
+            graph_pool_run(pool, parts, pagerank_part, &job);
+
+            float max_diff = 0.0f;
+            for (int p = 0; p < parts; p++) {
+                if (part_diff[p] > max_diff) max_diff = part_diff[p];
+            }
+
+            float *tmp = job.pr;
+            job.pr = job.pr_new;
+            job.pr_new = tmp;
+            tmp = (float *)job.contrib;
+            job.contrib = job.contrib_next;
+            job.contrib_next = tmp;
+
+            if (max_diff < 1e-6f) {
+                CYPHER_DEBUG("PageRank converged at iteration %d (max_diff=%.2e)", iter, max_diff);
+                break;
+            }
+        }
+        *out = job.pr;
+    }
+
+    free(pull_src);
+    free(contrib);
+    free(contrib_next);
+    free(bounds);
+    free(part_diff);
+    return actual_iters;
+}
+
 /*
  * Execute PageRank algorithm (optimized)
  *
@@ -37,11 +153,12 @@ static int compare_pr_desc(const void *a, const void *b)
  * - Pre-computes 1/out_degree to avoid division in inner loop
  * - Early convergence detection (stops if max change < 1e-6)
  * - Push-based approach for better cache locality on outgoing edges
+ * - With a worker pool, pull-based over degree-balanced target ranges
  *
  * If cached is non-NULL, uses it directly (fast path).
  * If cached is NULL, loads graph from SQLite (original behavior).
  */
-graph_algo_result* execute_pagerank(sqlite3 *db, csr_graph *cached, double damping, int iterations, int top_k)
+graph_algo_result* execute_pagerank(sqlite3 *db, csr_graph *cached, graph_pool *pool, double damping, int iterations, int top_k)
 {
     graph_algo_result *result = calloc(1, sizeof(graph_algo_result));
     if (!result) return NULL;
@@ -100,8 +217,28 @@ graph_algo_result* execute_pagerank(sqlite3 *db, csr_graph *cached, double dampi
     float teleport = (1.0f - dampf) / n;
     float convergence_threshold = 1e-6f;
     int actual_iters = 0;
+    int parts = graph_pool_parts(pool, graph);
+
+    if (parts > 1) {
+        float *final_pr = pr;
+        actual_iters = pagerank_parallel(graph, pool, parts, pr, pr_new, inv_out_degree,
+                                         dampf, teleport, iterations, &final_pr);
+        if (actual_iters < 0) {
+            free(pr);
+            free(pr_new);
+            free(inv_out_degree);
+            if (should_free_graph) csr_graph_free(graph);
+            result->success = false;
+            result->error_message = strdup("Memory allocation failed");
+            return result;
+        }
+        if (final_pr != pr) {
+            pr_new = pr;
+            pr = final_pr;
+        }
+    }
 
-    for (int iter = 0; iter < iterations; iter++) {
+    for (int iter = 0; parts == 1 && iter < iterations; iter++) {
         actual_iters++;
 
         /* Initialize new PR with teleport probability */
@@ -17,7 +17,8 @@
  * Returns the shortest path from source to target as JSON:
  * {"path": ["node1", "node2", ...], "distance": 3.5, "found": true}
  *
- * If weight_prop is NULL, uses unweighted edges (distance = hop count)
+ * If weight_prop is NULL, uses the weights of a weighted projection, or
+ * unweighted edges (distance = hop count)
  */
 graph_algo_result* execute_dijkstra(sqlite3 *db, csr_graph *cached, const char *source_id, const char *target_id, const char *weight_prop)
 {
@@ -113,6 +114,11 @@ graph_algo_result* execute_dijkstra(sqlite3 *db, csr_graph *cached, const char *
                 sqlite3_finalize(stmt);
             }
         }
+    } else if (graph->weights) {
+        weights = malloc(graph->edge_count * sizeof(double));
+        if (weights) {
+            memcpy(weights, graph->weights, graph->edge_count * sizeof(double));
+        }
     }
 
     /* Dijkstra's algorithm */
@@ -15,6 +15,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "executor/graph_algorithms.h"
+#include "executor/graph_algo_internal.h"
 
 /* Queue for BFS */
 typedef struct {
@@ -151,13 +152,7 @@ graph_algo_result* execute_bfs(sqlite3 *db, csr_graph *cached, const char *start
     int n = graph->node_count;
 
     /* Find start node */
-    int start = -1;
-    for (int i = 0; i < n; i++) {
-        if (graph->user_ids[i] && strcmp(graph->user_ids[i], start_id) == 0) {
-            start = i;
-            break;
-        }
-    }
+    int start = find_node_by_user_id(graph, start_id);
 
     if (start == -1) {
         if (should_free_graph) csr_graph_free(graph);
@@ -315,13 +310,7 @@ graph_algo_result* execute_dfs(sqlite3 *db, csr_graph *cached, const char *start
     int n = graph->node_count;
 
     /* Find start node */
-    int start = -1;
-    for (int i = 0; i < n; i++) {
-        if (graph->user_ids[i] && strcmp(graph->user_ids[i], start_id) == 0) {
-            start = i;
-            break;
-        }
-    }
+    int start = find_node_by_user_id(graph, start_id);
 
     if (start == -1) {
         if (should_free_graph) csr_graph_free(graph);
@@ -24,6 +24,11 @@ void csr_graph_free(csr_graph *graph)
 {
     if (!graph) return;
 
+    if (graph->snapshot) {
+        csr_snapshot_release(graph->snapshot);
+        return;
+    }
+
     free(graph->row_ptr);
     free(graph->col_idx);
     free(graph->node_ids);
@@ -34,16 +39,152 @@ void csr_graph_free(csr_graph *graph)
         free(graph->user_ids);
     }
     free(graph->node_idx);
+    free(graph->user_idx);
     free(graph->in_row_ptr);
     free(graph->in_col_idx);
+    free(graph->edge_ids);
+    free(graph->edge_types);
+    free(graph->weights);
+    for (int i = 0; i < graph->type_count; i++) {
+        free(graph->type_names[i]);
+    }
+    free(graph->type_names);
+    csr_delta_free(graph->delta);
     free(graph);
 }
 
-/* Load graph from SQLite into CSR format */
-csr_graph* csr_graph_load(sqlite3 *db)
+/* Build node ID -> index hash table.
+ * Size dynamically to maintain < 50% load factor. */
+int csr_index_nodes(csr_graph *graph)
+{
+    int target_size = graph->node_count * 2 + 1;
+    /* Find next odd number >= target_size (simple prime approximation) */
+    if (target_size < HASH_TABLE_SIZE) target_size = HASH_TABLE_SIZE;
+    if (target_size % 2 == 0) target_size++;
+
+    int *node_idx = malloc(target_size * sizeof(int));
+    if (!node_idx) return -1;
+
+    for (int i = 0; i < target_size; i++) {
+        node_idx[i] = -1;
+    }
+
+    for (int i = 0; i < graph->node_count; i++) {
+        int h = hash_int(graph->node_ids[i], target_size);
+        int probe_count = 0;
+        while (node_idx[h] != -1) {
+            h = (h + 1) % target_size;
+            if (++probe_count >= target_size) {
+                /* Table is full — should not happen with dynamic sizing */
+                CYPHER_DEBUG("Hash table full during CSR graph load (%d nodes, table size %d)",
+                             graph->node_count, target_size);
+                free(node_idx);
+                return -1;
+            }
+        }
+        node_idx[h] = i;
+    }
+
+    free(graph->node_idx);
+    graph->node_idx = node_idx;
+    graph->node_idx_size = target_size;
+    return 0;
+}
+
+/*
+ * Build user id -> index hash table over user_ids, so path queries resolve
+ * their endpoints without scanning every node. On allocation failure the
+ * index is dropped and find_node_by_user_id() falls back to a scan.
+ */
+int csr_index_user_ids(csr_graph *graph)
+{
+    free(graph->user_idx);
+    graph->user_idx = NULL;
+    graph->user_idx_size = 0;
+    if (!graph->user_ids) return -1;
+
+    int size = 16;
+    while (size < graph->node_count * 2) size *= 2;
+
+    int *user_idx = malloc(size * sizeof(int));
+    if (!user_idx) return -1;
+    memset(user_idx, 0xff, size * sizeof(int));
+
+    unsigned int mask = (unsigned int)size - 1;
+    for (int i = 0; i < graph->node_count; i++) {
+        const char *id = graph->user_ids[i];
+        if (!id) continue;
+
+        unsigned int h = hash_string(id) & mask;
+        while (user_idx[h] != -1 && strcmp(graph->user_ids[user_idx[h]], id) != 0) {
+            h = (h + 1) & mask;
+        }
+        if (user_idx[h] == -1) {
+            user_idx[h] = i;
+        }
+    }
+
+    graph->user_idx = user_idx;
+    graph->user_idx_size = size;
+    return 0;
+}
+
+/* Load user-defined 'id' property for each node */
+void csr_load_user_ids(sqlite3 *db, csr_graph *graph)
+{
+    sqlite3_stmt *stmt = NULL;
+
+    if (!graph->user_ids) return;
+
+    int rc = sqlite3_prepare_v2(db,
+        "SELECT np.node_id, np.value FROM node_props_text np "
+        "JOIN property_keys pk ON pk.id = np.key_id AND pk.key = 'id'",
+        -1, &stmt, NULL);
+    if (rc != SQLITE_OK) return;
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        int idx = csr_find_node(graph, sqlite3_column_int(stmt, 0));
+        const char *user_id = (const char*)sqlite3_column_text(stmt, 1);
+        if (idx >= 0) {
+            free(graph->user_ids[idx]);
+            graph->user_ids[idx] = user_id ? strdup(user_id) : NULL;
+        }
+    }
+    sqlite3_finalize(stmt);
+}
+
+/* Intern an edge type name, returning its id or -1 on allocation failure.
+ * *last is the previous result, which consecutive edges usually repeat. */
+static int csr_type_id(csr_graph *graph, const char *type, int *last)
+{
+    if (!type) type = "";
+    if (*last >= 0 && strcmp(graph->type_names[*last], type) == 0) {
+        return *last;
+    }
+    for (int i = 0; i < graph->type_count; i++) {
+        if (strcmp(graph->type_names[i], type) == 0) {
+            return *last = i;
+        }
+    }
+
+    char **names = realloc(graph->type_names, (graph->type_count + 1) * sizeof(char*));
+    if (!names) return -1;
+    graph->type_names = names;
+    if (!(names[graph->type_count] = strdup(type))) return -1;
+    return *last = graph->type_count++;
+}
+
+/*
+ * Load graph from SQLite into CSR format, from the rows of src. Incremental
+ * graphs also keep the edge rowid of every CSR entry and may be empty,
+ * since nodes can arrive later through csr_graph_sync(). Projections keep
+ * the type and weight of every entry.
+ */
+csr_graph* csr_graph_build(sqlite3 *db, const csr_source *src)
 {
     if (!db) return NULL;
 
+    bool incremental = src->incremental;
     csr_graph *graph = calloc(1, sizeof(csr_graph));
     if (!graph) return NULL;
 
@@ -51,12 +192,13 @@ csr_graph* csr_graph_load(sqlite3 *db)
     int rc;
 
     /* Step 1: Count nodes and get node IDs */
-    rc = sqlite3_prepare_v2(db, "SELECT id FROM nodes ORDER BY id", -1, &stmt, NULL);
+    rc = sqlite3_prepare_v2(db, src->node_sql, -1, &stmt, NULL);
     if (rc != SQLITE_OK) {
         CYPHER_DEBUG("Failed to prepare node query: %s", sqlite3_errmsg(db));
         free(graph);
         return NULL;
     }
+    if (src->bind) sqlite3_bind_text(stmt, 1, src->bind, -1, SQLITE_STATIC);
 
     int node_capacity = 1024;
     graph->node_ids = malloc(node_capacity * sizeof(int));
@@ -81,7 +223,7 @@ csr_graph* csr_graph_load(sqlite3 *db)
     }
     sqlite3_finalize(stmt);
 
-    if (graph->node_count == 0) {
+    if (graph->node_count == 0 && !incremental) {
         CYPHER_DEBUG("No nodes found in graph");
         csr_graph_free(graph);
         return NULL;
@@ -89,67 +231,15 @@ csr_graph* csr_graph_load(sqlite3 *db)
 
     CYPHER_DEBUG("Loaded %d nodes", graph->node_count);
 
-    /* Build node ID -> index hash table.
-     * Size dynamically to maintain < 50% load factor. */
-    {
-        int target_size = graph->node_count * 2 + 1;
-        /* Find next odd number >= target_size (simple prime approximation) */
-        if (target_size < HASH_TABLE_SIZE) target_size = HASH_TABLE_SIZE;
-        if (target_size % 2 == 0) target_size++;
-        graph->node_idx_size = target_size;
-    }
-    graph->node_idx = malloc(graph->node_idx_size * sizeof(int));
-    if (!graph->node_idx) {
+    if (csr_index_nodes(graph) < 0) {
         csr_graph_free(graph);
         return NULL;
     }
 
-    for (int i = 0; i < graph->node_idx_size; i++) {
-        graph->node_idx[i] = -1;
-    }
-
-    for (int i = 0; i < graph->node_count; i++) {
-        int node_id = graph->node_ids[i];
-        int h = hash_int(node_id, graph->node_idx_size);
-        int probe_count = 0;
-        while (graph->node_idx[h] != -1) {
-            h = (h + 1) % graph->node_idx_size;
-            if (++probe_count >= graph->node_idx_size) {
-                /* Table is full — should not happen with dynamic sizing */
-                CYPHER_DEBUG("Hash table full during CSR graph load (%d nodes, table size %d)",
-                             graph->node_count, graph->node_idx_size);
-                csr_graph_free(graph);
-                return NULL;
-            }
-        }
-        graph->node_idx[h] = i;
-    }
-
     /* Step 1b: Load user-defined 'id' property for each node */
-    graph->user_ids = calloc(graph->node_count, sizeof(char*));
-    if (graph->user_ids) {
-        rc = sqlite3_prepare_v2(db,
-            "SELECT np.node_id, np.value FROM node_props_text np "
-            "JOIN property_keys pk ON pk.id = np.key_id AND pk.key = 'id'",
-            -1, &stmt, NULL);
-        if (rc == SQLITE_OK) {
-            while (sqlite3_step(stmt) == SQLITE_ROW) {
-                int node_id = sqlite3_column_int(stmt, 0);
-                const char *user_id = (const char*)sqlite3_column_text(stmt, 1);
-
-                int h = hash_int(node_id, graph->node_idx_size);
-                while (graph->node_idx[h] != -1) {
-                    int idx = graph->node_idx[h];
-                    if (graph->node_ids[idx] == node_id) {
-                        graph->user_ids[idx] = user_id ? strdup(user_id) : NULL;
-                        break;
-                    }
-                    h = (h + 1) % graph->node_idx_size;
-                }
-            }
-            sqlite3_finalize(stmt);
-        }
-    }
+    graph->user_ids = calloc(graph->node_count + 1, sizeof(char*));
+    csr_load_user_ids(db, graph);
+    csr_index_user_ids(graph);
 
     /* Step 2: Count edges per node */
     graph->row_ptr = calloc(graph->node_count + 1, sizeof(int));
@@ -159,28 +249,17 @@ csr_graph* csr_graph_load(sqlite3 *db)
         return NULL;
     }
 
-    rc = sqlite3_prepare_v2(db, "SELECT source_id, target_id FROM edges", -1, &stmt, NULL);
+    rc = sqlite3_prepare_v2(db, src->count_sql, -1, &stmt, NULL);
     if (rc != SQLITE_OK) {
         csr_graph_free(graph);
         return NULL;
     }
+    if (src->bind) sqlite3_bind_text(stmt, 1, src->bind, -1, SQLITE_STATIC);
 
     graph->edge_count = 0;
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int source_id = sqlite3_column_int(stmt, 0);
-        int target_id = sqlite3_column_int(stmt, 1);
-
-        int h = hash_int(source_id, graph->node_idx_size);
-        while (graph->node_idx[h] != -1 && graph->node_ids[graph->node_idx[h]] != source_id) {
-            h = (h + 1) % graph->node_idx_size;
-        }
-        int source_idx = (graph->node_idx[h] != -1) ? graph->node_idx[h] : -1;
-
-        h = hash_int(target_id, graph->node_idx_size);
-        while (graph->node_idx[h] != -1 && graph->node_ids[graph->node_idx[h]] != target_id) {
-            h = (h + 1) % graph->node_idx_size;
-        }
-        int target_idx = (graph->node_idx[h] != -1) ? graph->node_idx[h] : -1;
+        int source_idx = csr_find_node(graph, sqlite3_column_int(stmt, 0));
+        int target_idx = csr_find_node(graph, sqlite3_column_int(stmt, 1));
 
         if (source_idx >= 0 && target_idx >= 0) {
             graph->row_ptr[source_idx + 1]++;
@@ -199,49 +278,51 @@ csr_graph* csr_graph_load(sqlite3 *db)
     }
 
     /* Step 3: Fill col_idx arrays */
-    graph->col_idx = malloc(graph->edge_count * sizeof(int));
-    graph->in_col_idx = malloc(graph->edge_count * sizeof(int));
-    if (!graph->col_idx || !graph->in_col_idx) {
-        csr_graph_free(graph);
-        return NULL;
+    graph->col_idx = malloc((graph->edge_count + 1) * sizeof(int));
+    graph->in_col_idx = malloc((graph->edge_count + 1) * sizeof(int));
+    if (incremental) {
+        graph->edge_ids = malloc((graph->edge_count + 1) * sizeof(int));
     }
-
-    int *out_count = calloc(graph->node_count, sizeof(int));
-    int *in_count = calloc(graph->node_count, sizeof(int));
-    if (!out_count || !in_count) {
-        free(out_count);
-        free(in_count);
+    if (src->projection) {
+        graph->edge_types = malloc((graph->edge_count + 1) * sizeof(int));
+    }
+    if (src->weighted) {
+        graph->weights = malloc((graph->edge_count + 1) * sizeof(double));
+    }
+    if (!graph->col_idx || !graph->in_col_idx || (incremental && !graph->edge_ids) ||
+        (src->projection && !graph->edge_types) || (src->weighted && !graph->weights)) {
         csr_graph_free(graph);
         return NULL;
     }
 
-    rc = sqlite3_prepare_v2(db, "SELECT source_id, target_id FROM edges", -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
+    int *out_count = calloc(graph->node_count + 1, sizeof(int));
+    int *in_count = calloc(graph->node_count + 1, sizeof(int));
+    if (!out_count || !in_count ||
+        sqlite3_prepare_v2(db, src->edge_sql, -1, &stmt, NULL) != SQLITE_OK) {
         free(out_count);
         free(in_count);
         csr_graph_free(graph);
         return NULL;
     }
+    if (src->bind) sqlite3_bind_text(stmt, 1, src->bind, -1, SQLITE_STATIC);
 
+    int type_hint = -1;
     while (sqlite3_step(stmt) == SQLITE_ROW) {
-        int source_id = sqlite3_column_int(stmt, 0);
-        int target_id = sqlite3_column_int(stmt, 1);
-
-        int h = hash_int(source_id, graph->node_idx_size);
-        while (graph->node_idx[h] != -1 && graph->node_ids[graph->node_idx[h]] != source_id) {
-            h = (h + 1) % graph->node_idx_size;
-        }
-        int source_idx = (graph->node_idx[h] != -1) ? graph->node_idx[h] : -1;
-
-        h = hash_int(target_id, graph->node_idx_size);
-        while (graph->node_idx[h] != -1 && graph->node_ids[graph->node_idx[h]] != target_id) {
-            h = (h + 1) % graph->node_idx_size;
-        }
-        int target_idx = (graph->node_idx[h] != -1) ? graph->node_idx[h] : -1;
+        int source_idx = csr_find_node(graph, sqlite3_column_int(stmt, 0));
+        int target_idx = csr_find_node(graph, sqlite3_column_int(stmt, 1));
 
         if (source_idx >= 0 && target_idx >= 0) {
             int out_pos = graph->row_ptr[source_idx] + out_count[source_idx]++;
             graph->col_idx[out_pos] = target_idx;
+            if (graph->edge_ids) {
+                graph->edge_ids[out_pos] = sqlite3_column_int(stmt, 2);
+            }
+            if (graph->edge_types) {
+                graph->edge_types[out_pos] = csr_type_id(graph, (const char*)sqlite3_column_text(stmt, 3), &type_hint);
+            }
+            if (graph->weights) {
+                graph->weights[out_pos] = sqlite3_column_double(stmt, 4);
+            }
 
             int in_pos = graph->in_row_ptr[target_idx] + in_count[target_idx]++;
             graph->in_col_idx[in_pos] = source_idx;
@@ -257,6 +338,37 @@ csr_graph* csr_graph_load(sqlite3 *db)
     return graph;
 }
 
+/* Every node and edge */
+static const csr_source whole_graph = {
+    "SELECT id FROM nodes ORDER BY id",
+    "SELECT source_id, target_id FROM edges",
+    "SELECT source_id, target_id, id FROM edges",
+    NULL, false, false, false
+};
+
+csr_graph* csr_graph_load(sqlite3 *db)
+{
+    return csr_graph_build(db, &whole_graph);
+}
+
+csr_graph* csr_graph_load_incremental(sqlite3 *db)
+{
+    csr_source src = whole_graph;
+    src.incremental = true;
+
+    /* Created first, so a commit made during the build reads as a change */
+    struct csr_delta *delta = csr_delta_create(db);
+    if (!delta) return NULL;
+
+    csr_graph *graph = csr_graph_build(db, &src);
+    if (!graph) {
+        csr_delta_free(delta);
+        return NULL;
+    }
+    graph->delta = delta;
+    return graph;
+}
+
 /*
  * Resolve a function argument to a string value.
  * Handles AST_NODE_LITERAL (string) and AST_NODE_PARAMETER (via params_json).
@@ -385,6 +497,49 @@ static double resolve_double_arg(ast_node *node, const char *params_json, double
     return default_value;
 }
 
+/*
+ * Algorithm options map, passed as the last argument: {graph: 'name'} runs
+ * the algorithm on a named projection. Returns the number of positional
+ * arguments before it.
+ */
+static int resolve_algo_options(ast_list *args, const char *params_json, char **graph_name)
+{
+    int argc = args ? args->count : 0;
+    if (argc == 0) return 0;
+
+    ast_node *last = (ast_node *)args->items[argc - 1];
+    if (!last || last->type != AST_NODE_MAP) return argc;
+
+    cypher_map *map = (cypher_map *)last;
+    for (int i = 0; map->pairs && i < map->pairs->count; i++) {
+        cypher_map_pair *pair = (cypher_map_pair *)map->pairs->items[i];
+        if (pair && pair->key && strcmp(pair->key, "graph") == 0) {
+            free(*graph_name);
+            *graph_name = resolve_string_arg(pair->value, params_json);
+            if (!*graph_name) *graph_name = strdup("");  /* reported as unknown */
+        }
+    }
+    return argc - 1;
+}
+
+/*
+ * Optional (samples, seed) arguments of the all-pairs centralities: run
+ * only that many pivot sources, chosen by seed, and report estimates.
+ * Fewer than 2 samples would leave no standard error, so 1 counts as 2.
+ */
+static void resolve_sampling_args(ast_list *args, int argc, const char *params_json,
+                                  graph_algo_params *params)
+{
+    if (argc >= 1) {
+        params->samples = resolve_int_arg((ast_node *)args->items[0], params_json, 0);
+        if (params->samples < 0) params->samples = 0;
+        if (params->samples == 1) params->samples = 2;
+    }
+    if (argc >= 2) {
+        params->seed = resolve_int_arg((ast_node *)args->items[1], params_json, 0);
+    }
+}
+
 /* Detect graph algorithm in RETURN clause */
 graph_algo_params detect_graph_algorithm(cypher_return *return_clause, const char *params_json)
 {
@@ -412,14 +567,16 @@ graph_algo_params detect_graph_algorithm(cypher_return *return_clause, const cha
         return params;
     }
 
+    int argc = resolve_algo_options(func->args, params_json, &params.graph_name);
+
     /* PageRank */
     if (strcasecmp(func->function_name, "pageRank") == 0) {
         params.type = GRAPH_ALGO_PAGERANK;
 
-        if (func->args && func->args->count >= 1) {
+        if (argc >= 1) {
             params.damping = resolve_double_arg((ast_node *)func->args->items[0], params_json, params.damping);
         }
-        if (func->args && func->args->count >= 2) {
+        if (argc >= 2) {
             params.iterations = resolve_int_arg((ast_node *)func->args->items[1], params_json, params.iterations);
             if (params.iterations < 1) params.iterations = 1;
             if (params.iterations > 100) params.iterations = 100;
@@ -432,15 +589,15 @@ graph_algo_params detect_graph_algorithm(cypher_return *return_clause, const cha
         params.type = GRAPH_ALGO_PAGERANK;
         params.top_k = 10;
 
-        if (func->args && func->args->count >= 1) {
+        if (argc >= 1) {
             params.top_k = resolve_int_arg((ast_node *)func->args->items[0], params_json, params.top_k);
             if (params.top_k < 1) params.top_k = 1;
             if (params.top_k > 1000) params.top_k = 1000;
         }
-        if (func->args && func->args->count >= 2) {
+        if (argc >= 2) {
             params.damping = resolve_double_arg((ast_node *)func->args->items[1], params_json, params.damping);
         }
-        if (func->args && func->args->count >= 3) {
+        if (argc >= 3) {
             params.iterations = resolve_int_arg((ast_node *)func->args->items[2], params_json, params.iterations);
             if (params.iterations < 1) params.iterations = 1;
             if (params.iterations > 100) params.iterations = 100;
@@ -453,7 +610,7 @@ graph_algo_params detect_graph_algorithm(cypher_return *return_clause, const cha
         params.type = GRAPH_ALGO_LABEL_PROPAGATION;
         params.iterations = 10;
 
-        if (func->args && func->args->count >= 1) {
+        if (argc >= 1) {
             params.iterations = resolve_int_arg((ast_node *)func->args->items[0], params_json, params.iterations);
             if (params.iterations < 1) params.iterations = 1;
             if (params.iterations > 100) params.iterations = 100;
@@ -465,11 +622,11 @@ graph_algo_params detect_graph_algorithm(cypher_return *return_clause, const cha
     if (strcasecmp(func->function_name, "dijkstra") == 0) {
         params.type = GRAPH_ALGO_DIJKSTRA;
 
-        if (func->args && func->args->count >= 2) {
+        if (argc >= 2) {
             params.source_id = resolve_string_arg((ast_node *)func->args->items[0], params_json);
             params.target_id = resolve_string_arg((ast_node *)func->args->items[1], params_json);
         }
-        if (func->args && func->args->count >= 3) {
+        if (argc >= 3) {
             params.weight_prop = resolve_string_arg((ast_node *)func->args->items[2], params_json);
         }
         return params;
@@ -500,6 +657,7 @@ graph_algo_params detect_graph_algorithm(cypher_return *return_clause, const cha
     if (strcasecmp(func->function_name, "betweennessCentrality") == 0 ||
         strcasecmp(func->function_name, "betweenness") == 0) {
         params.type = GRAPH_ALGO_BETWEENNESS_CENTRALITY;
+        resolve_sampling_args(func->args, argc, params_json, &params);
         return params;
     }
 
@@ -507,6 +665,7 @@ graph_algo_params detect_graph_algorithm(cypher_return *return_clause, const cha
     if (strcasecmp(func->function_name, "closenessCentrality") == 0 ||
         strcasecmp(func->function_name, "closeness") == 0) {
         params.type = GRAPH_ALGO_CLOSENESS_CENTRALITY;
+        resolve_sampling_args(func->args, argc, params_json, &params);
         return params;
     }
 
@@ -516,7 +675,7 @@ graph_algo_params detect_graph_algorithm(cypher_return *return_clause, const cha
         params.resolution = 1.0;
 
         /* Optional resolution parameter */
-        if (func->args && func->args->count >= 1) {
+        if (argc >= 1) {
             params.resolution = resolve_double_arg((ast_node *)func->args->items[0], params_json, params.resolution);
         }
         return params;
@@ -535,12 +694,12 @@ graph_algo_params detect_graph_algorithm(cypher_return *return_clause, const cha
         params.type = GRAPH_ALGO_ASTAR;
 
         /* astar(source, target) or astar(source, target, lat_prop, lon_prop) */
-        if (func->args && func->args->count >= 2) {
+        if (argc >= 2) {
             params.source_id = resolve_string_arg((ast_node *)func->args->items[0], params_json);
             params.target_id = resolve_string_arg((ast_node *)func->args->items[1], params_json);
         }
         /* Optional: lat and lon property names for heuristic */
-        if (func->args && func->args->count >= 4) {
+        if (argc >= 4) {
             params.lat_prop = resolve_string_arg((ast_node *)func->args->items[2], params_json);
             params.lon_prop = resolve_string_arg((ast_node *)func->args->items[3], params_json);
         }
@@ -553,10 +712,10 @@ graph_algo_params detect_graph_algorithm(cypher_return *return_clause, const cha
         params.type = GRAPH_ALGO_BFS;
         params.max_depth = -1;  /* Unlimited by default */
 
-        if (func->args && func->args->count >= 1) {
+        if (argc >= 1) {
             params.source_id = resolve_string_arg((ast_node *)func->args->items[0], params_json);
         }
-        if (func->args && func->args->count >= 2) {
+        if (argc >= 2) {
             params.max_depth = resolve_int_arg((ast_node *)func->args->items[1], params_json, -1);
         }
         return params;
@@ -568,10 +727,10 @@ graph_algo_params detect_graph_algorithm(cypher_return *return_clause, const cha
         params.type = GRAPH_ALGO_DFS;
         params.max_depth = -1;  /* Unlimited by default */
 
-        if (func->args && func->args->count >= 1) {
+        if (argc >= 1) {
             params.source_id = resolve_string_arg((ast_node *)func->args->items[0], params_json);
         }
-        if (func->args && func->args->count >= 2) {
+        if (argc >= 2) {
             params.max_depth = resolve_int_arg((ast_node *)func->args->items[1], params_json, -1);
         }
         return params;
@@ -586,7 +745,7 @@ graph_algo_params detect_graph_algorithm(cypher_return *return_clause, const cha
         params.target_id = NULL;
 
         /* Check for specific pair: nodeSimilarity('node1', 'node2') or with params */
-        if (func->args && func->args->count >= 2) {
+        if (argc >= 2) {
             ast_node *arg0 = (ast_node *)func->args->items[0];
             ast_node *arg1 = (ast_node *)func->args->items[1];
 
@@ -605,12 +764,12 @@ graph_algo_params detect_graph_algorithm(cypher_return *return_clause, const cha
             }
         }
         /* Check for threshold: nodeSimilarity(0.5) */
-        else if (func->args && func->args->count >= 1) {
+        else if (argc >= 1) {
             params.threshold = resolve_double_arg((ast_node *)func->args->items[0], params_json, params.threshold);
         }
 
         /* Check for top_k as last argument */
-        if (func->args && func->args->count >= 2 && !params.source_id) {
+        if (argc >= 2 && !params.source_id) {
             /* nodeSimilarity(threshold, top_k) */
             params.top_k = resolve_int_arg((ast_node *)func->args->items[1], params_json, params.top_k);
         }
@@ -625,10 +784,10 @@ graph_algo_params detect_graph_algorithm(cypher_return *return_clause, const cha
         params.k = 10;  /* Default k */
 
         /* knn(node_id, k) */
-        if (func->args && func->args->count >= 1) {
+        if (argc >= 1) {
             params.source_id = resolve_string_arg((ast_node *)func->args->items[0], params_json);
         }
-        if (func->args && func->args->count >= 2) {
+        if (argc >= 2) {
             params.k = resolve_int_arg((ast_node *)func->args->items[1], params_json, params.k);
         }
 
@@ -641,7 +800,7 @@ graph_algo_params detect_graph_algorithm(cypher_return *return_clause, const cha
         params.iterations = 100;  /* Default iterations */
 
         /* Optional iterations parameter */
-        if (func->args && func->args->count >= 1) {
+        if (argc >= 1) {
             params.iterations = resolve_int_arg((ast_node *)func->args->items[0], params_json, params.iterations);
             if (params.iterations < 1) params.iterations = 1;
             if (params.iterations > 1000) params.iterations = 1000;
@@ -656,6 +815,8 @@ graph_algo_params detect_graph_algorithm(cypher_return *return_clause, const cha
         return params;
     }
 
+    free(params.graph_name);
+    params.graph_name = NULL;
     return params;
 }
 
@@ -0,0 +1,525 @@
+/*
+ * Graph Delta - Incremental CSR maintenance
+ *
+ * An incremental csr_graph keeps a log of the node, edge and text
+ * property rowids written since it was last brought up to date. The log
+ * only holds rowids because it is fed from triggers, one row at a time,
+ * in the middle of the writing statement. csr_graph_sync() resolves each
+ * logged rowid against the tables and folds the result into fresh CSR
+ * arrays in memory, which costs one pass over the arrays plus a point lookup per
+ * changed row instead of the full table scans of csr_graph_load().
+ *
+ * Triggers only see this connection's writes. Commits by other
+ * connections move PRAGMA data_version, and the graph is rebuilt when it
+ * no longer matches the value recorded at load.
+ *
+ * Rowids are re-read rather than replayed, so rows written by a statement
+ * or transaction that later rolled back resolve to no-ops.
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "executor/graph_algorithms.h"
+#include "executor/graph_algo_internal.h"
+
+/* Logs smaller than this are always merged; larger ones rebuild once they
+ * exceed a quarter of the graph, where point lookups lose to a scan. */
+#define CSR_DELTA_MIN_REBUILD 4096
+
+typedef struct {
+    int *ids;
+    int count;
+    int capacity;
+} delta_ids;
+
+typedef struct csr_delta {
+    delta_ids nodes;      /* nodes rowids inserted or deleted */
+    delta_ids edges;      /* edges rowids inserted, updated or deleted */
+    delta_ids props;      /* node_props_text rowids inserted or updated */
+    int recorded;         /* Changes seen since the last sync */
+    bool ids_dirty;       /* A text property row was deleted: reload user ids */
+    bool rebuild;         /* Log outgrew the graph: rebuild from scratch */
+    sqlite3_int64 data_version;  /* PRAGMA data_version when the graph was loaded */
+} csr_delta;
+
+/* A logged edge resolved against the edges table */
+typedef struct {
+    int id;
+    int source_id;
+    int target_id;
+    bool exists;
+    bool seen;            /* Still present, unchanged, in the old CSR */
+} delta_edge;
+
+/* Bumped by commits from other connections only; -1 if it cannot be read */
+static sqlite3_int64 delta_data_version(sqlite3 *db)
+{
+    sqlite3_stmt *stmt = NULL;
+    sqlite3_int64 version = -1;
+    if (sqlite3_prepare_v2(db, "PRAGMA main.data_version", -1, &stmt, NULL) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        version = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return version;
+}
+
+struct csr_delta* csr_delta_create(sqlite3 *db)
+{
+    csr_delta *delta = calloc(1, sizeof(csr_delta));
+    if (delta) {
+        delta->data_version = delta_data_version(db);
+    }
+    return delta;
+}
+
+static void delta_ids_clear(delta_ids *set)
+{
+    free(set->ids);
+    set->ids = NULL;
+    set->count = 0;
+    set->capacity = 0;
+}
+
+static void csr_delta_reset(csr_delta *delta)
+{
+    delta_ids_clear(&delta->nodes);
+    delta_ids_clear(&delta->edges);
+    delta_ids_clear(&delta->props);
+    delta->recorded = 0;
+    delta->ids_dirty = false;
+    delta->rebuild = false;
+}
+
+void csr_delta_free(struct csr_delta *delta)
+{
+    if (!delta) return;
+    csr_delta_reset(delta);
+    free(delta);
+}
+
+static int delta_ids_push(delta_ids *set, int id)
+{
+    if (set->count >= set->capacity) {
+        int capacity = set->capacity ? set->capacity * 2 : 64;
+        int *ids = realloc(set->ids, capacity * sizeof(int));
+        if (!ids) return -1;
+        set->ids = ids;
+        set->capacity = capacity;
+    }
+    set->ids[set->count++] = id;
+    return 0;
+}
+
+static int compare_ints(const void *a, const void *b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/* Sort and drop duplicates in place */
+static void delta_ids_normalize(delta_ids *set)
+{
+    if (set->count < 2) return;
+
+    qsort(set->ids, set->count, sizeof(int), compare_ints);
+    int n = 1;
+    for (int i = 1; i < set->count; i++) {
+        if (set->ids[i] != set->ids[n - 1]) {
+            set->ids[n++] = set->ids[i];
+        }
+    }
+    set->count = n;
+}
+
+void csr_graph_record_change(csr_graph *graph, int op, const char *table, sqlite3_int64 rowid)
+{
+    if (!graph || !graph->delta || !table) return;
+    csr_delta *delta = graph->delta;
+
+    int rc = 0;
+    if (strcmp(table, "nodes") == 0) {
+        if (op == SQLITE_UPDATE) return;
+        delta->recorded++;
+        if (!delta->rebuild) rc = delta_ids_push(&delta->nodes, (int)rowid);
+    } else if (strcmp(table, "edges") == 0) {
+        delta->recorded++;
+        if (!delta->rebuild) rc = delta_ids_push(&delta->edges, (int)rowid);
+    } else if (strcmp(table, "node_props_text") == 0) {
+        delta->recorded++;
+        if (op == SQLITE_DELETE) {
+            delta->ids_dirty = true;
+        } else if (!delta->rebuild) {
+            rc = delta_ids_push(&delta->props, (int)rowid);
+        }
+    } else {
+        return;
+    }
+
+    if (delta->rebuild) return;
+
+    int limit = (graph->node_count + graph->edge_count) / 4;
+    if (rc < 0 || (delta->recorded > CSR_DELTA_MIN_REBUILD && delta->recorded > limit)) {
+        CYPHER_DEBUG("Graph delta outgrew the CSR (%d changes), scheduling rebuild", delta->recorded);
+        delta_ids_clear(&delta->nodes);
+        delta_ids_clear(&delta->edges);
+        delta_ids_clear(&delta->props);
+        delta->rebuild = true;
+    }
+}
+
+int csr_graph_pending_changes(const csr_graph *graph)
+{
+    return graph && graph->delta ? graph->delta->recorded : 0;
+}
+
+static delta_edge* find_delta_edge(delta_edge *edges, int count, int id)
+{
+    int lo = 0, hi = count - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (edges[mid].id == id) return &edges[mid];
+        if (edges[mid].id < id) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return NULL;
+}
+
+/* Re-read the 'id' property for each logged node_props_text row */
+static void apply_user_id_changes(sqlite3 *db, csr_graph *graph, delta_ids *props)
+{
+    sqlite3_stmt *stmt = NULL;
+
+    if (props->count == 0 || !graph->user_ids) return;
+    if (sqlite3_prepare_v2(db,
+            "SELECT np.node_id, np.value FROM node_props_text np "
+            "JOIN property_keys pk ON pk.id = np.key_id AND pk.key = 'id' "
+            "WHERE np.rowid = ?", -1, &stmt, NULL) != SQLITE_OK) {
+        return;
+    }
+
+    for (int i = 0; i < props->count; i++) {
+        sqlite3_bind_int(stmt, 1, props->ids[i]);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            int idx = csr_find_node(graph, sqlite3_column_int(stmt, 0));
+            const char *user_id = (const char*)sqlite3_column_text(stmt, 1);
+            if (idx >= 0) {
+                free(graph->user_ids[idx]);
+                graph->user_ids[idx] = user_id ? strdup(user_id) : NULL;
+            }
+        }
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+}
+
+/*
+ * Fold the logged changes into new CSR arrays. The old arrays are only
+ * read until everything has been allocated, so on failure the graph is
+ * left untouched and the caller rebuilds it instead.
+ *
+ * Node order stays ascending by id and each adjacency list stays in edge
+ * id order with new edges appended, which is the order a full reload
+ * produces, so algorithm results match gql_reload_graph().
+ */
+static int csr_delta_merge(sqlite3 *db, csr_graph *graph)
+{
+    csr_delta *delta = graph->delta;
+    int n = graph->node_count;
+    int m = graph->edge_count;
+    int rc = -1;
+
+    sqlite3_stmt *stmt = NULL;
+    delta_edge *logged = NULL;
+    int *added = NULL;
+    int added_count = 0;
+    char *removed = calloc(n + 1, 1);
+    char *out_drop = calloc(m + 1, 1);
+    char *in_drop = calloc(m + 1, 1);
+    int *remap = malloc((n + 1) * sizeof(int));
+    csr_graph next = {0};
+    int *fill = NULL;
+
+    if (!removed || !out_drop || !in_drop || !remap) goto cleanup;
+
+    delta_ids_normalize(&delta->nodes);
+    delta_ids_normalize(&delta->edges);
+    delta_ids_normalize(&delta->props);
+
+    /* Nodes: logged ids either appeared, disappeared or are unchanged */
+    if (delta->nodes.count > 0) {
+        added = malloc(delta->nodes.count * sizeof(int));
+        if (!added) goto cleanup;
+        if (sqlite3_prepare_v2(db, "SELECT 1 FROM nodes WHERE id = ?", -1, &stmt, NULL) != SQLITE_OK) {
+            goto cleanup;
+        }
+        for (int i = 0; i < delta->nodes.count; i++) {
+            int id = delta->nodes.ids[i];
+            sqlite3_bind_int(stmt, 1, id);
+            bool exists = sqlite3_step(stmt) == SQLITE_ROW;
+            sqlite3_reset(stmt);
+
+            int idx = csr_find_node(graph, id);
+            if (idx >= 0 && !exists) {
+                removed[idx] = 1;
+            } else if (idx < 0 && exists) {
+                added[added_count++] = id;
+            }
+        }
+        sqlite3_finalize(stmt);
+        stmt = NULL;
+    }
+
+    /* Edges: resolve the current endpoints of every logged id */
+    if (delta->edges.count > 0) {
+        logged = calloc(delta->edges.count, sizeof(delta_edge));
+        if (!logged) goto cleanup;
+        if (sqlite3_prepare_v2(db, "SELECT source_id, target_id FROM edges WHERE id = ?",
+                               -1, &stmt, NULL) != SQLITE_OK) {
+            goto cleanup;
+        }
+        for (int i = 0; i < delta->edges.count; i++) {
+            logged[i].id = delta->edges.ids[i];
+            sqlite3_bind_int(stmt, 1, logged[i].id);
+            if (sqlite3_step(stmt) == SQLITE_ROW) {
+                logged[i].exists = true;
+                logged[i].source_id = sqlite3_column_int(stmt, 0);
+                logged[i].target_id = sqlite3_column_int(stmt, 1);
+            }
+            sqlite3_reset(stmt);
+        }
+        sqlite3_finalize(stmt);
+        stmt = NULL;
+    }
+
+    /*
+     * Mark old entries that go away. An out entry s->t dropped on its own
+     * takes the matching in entry of t with it: both lists hold the
+     * parallel s->t edges in id order, so the k-th t in s's list is the
+     * k-th s in t's list. Entries touching a removed node are filtered
+     * by node below.
+     */
+    for (int s = 0; s < n; s++) {
+        for (int p = graph->row_ptr[s]; p < graph->row_ptr[s + 1]; p++) {
+            int t = graph->col_idx[p];
+            if (removed[s] || removed[t]) {
+                out_drop[p] = 1;
+                continue;
+            }
+
+            delta_edge *e = logged ? find_delta_edge(logged, delta->edges.count, graph->edge_ids[p]) : NULL;
+            if (!e) continue;
+            if (e->exists && e->source_id == graph->node_ids[s] && e->target_id == graph->node_ids[t]) {
+                e->seen = true;
+                continue;
+            }
+
+            out_drop[p] = 1;
+            int rank = 0;
+            for (int q = graph->row_ptr[s]; q < p; q++) {
+                if (graph->col_idx[q] == t) rank++;
+            }
+            for (int q = graph->in_row_ptr[t]; q < graph->in_row_ptr[t + 1]; q++) {
+                if (graph->in_col_idx[q] == s && rank-- == 0) {
+                    in_drop[q] = 1;
+                    break;
+                }
+            }
+        }
+    }
+
+    /* New node order: surviving ids merged with the added ids, ascending */
+    next.node_count = 0;
+    next.node_ids = malloc((n + added_count + 1) * sizeof(int));
+    next.user_ids = calloc(n + added_count + 1, sizeof(char*));
+    if (!next.node_ids || !next.user_ids) goto cleanup;
+
+    for (int i = 0, a = 0; i < n || a < added_count; ) {
+        if (i < n && removed[i]) {
+            remap[i++] = -1;
+        } else if (a < added_count && (i >= n || added[a] < graph->node_ids[i])) {
+            next.node_ids[next.node_count++] = added[a++];
+        } else {
+            remap[i] = next.node_count;
+            next.node_ids[next.node_count++] = graph->node_ids[i++];
+        }
+    }
+    if (csr_index_nodes(&next) < 0) goto cleanup;
+
+    /* Edges to add: logged rows that exist but were not kept in place */
+    int new_edges = 0;
+    for (int i = 0; i < delta->edges.count; i++) {
+        delta_edge *e = &logged[i];
+        if (!e->exists || e->seen) continue;
+        e->source_id = csr_find_node(&next, e->source_id);
+        e->target_id = csr_find_node(&next, e->target_id);
+        if (e->source_id >= 0 && e->target_id >= 0) {
+            new_edges++;
+        } else {
+            e->exists = false;
+        }
+    }
+
+    int nn = next.node_count;
+    next.row_ptr = calloc(nn + 1, sizeof(int));
+    next.in_row_ptr = calloc(nn + 1, sizeof(int));
+    next.col_idx = malloc((m + new_edges + 1) * sizeof(int));
+    next.edge_ids = malloc((m + new_edges + 1) * sizeof(int));
+    next.in_col_idx = malloc((m + new_edges + 1) * sizeof(int));
+    fill = calloc(nn + 1, sizeof(int));
+    if (!next.row_ptr || !next.in_row_ptr || !next.col_idx || !next.edge_ids ||
+        !next.in_col_idx || !fill) {
+        goto cleanup;
+    }
+
+    /* Count degrees */
+    for (int s = 0; s < n; s++) {
+        if (remap[s] < 0) continue;
+        for (int p = graph->row_ptr[s]; p < graph->row_ptr[s + 1]; p++) {
+            if (!out_drop[p]) next.row_ptr[remap[s] + 1]++;
+        }
+        for (int q = graph->in_row_ptr[s]; q < graph->in_row_ptr[s + 1]; q++) {
+            if (!in_drop[q] && remap[graph->in_col_idx[q]] >= 0) next.in_row_ptr[remap[s] + 1]++;
+        }
+    }
+    for (int i = 0; i < delta->edges.count; i++) {
+        if (!logged[i].exists || logged[i].seen) continue;
+        next.row_ptr[logged[i].source_id + 1]++;
+        next.in_row_ptr[logged[i].target_id + 1]++;
+    }
+    for (int i = 1; i <= nn; i++) {
+        next.row_ptr[i] += next.row_ptr[i - 1];
+        next.in_row_ptr[i] += next.in_row_ptr[i - 1];
+    }
+    next.edge_count = next.row_ptr[nn];
+
+    /* Outgoing lists: surviving entries first, then new edges in id order */
+    for (int s = 0; s < n; s++) {
+        int ns = remap[s];
+        if (ns < 0) continue;
+        for (int p = graph->row_ptr[s]; p < graph->row_ptr[s + 1]; p++) {
+            if (out_drop[p]) continue;
+            int pos = next.row_ptr[ns] + fill[ns]++;
+            next.col_idx[pos] = remap[graph->col_idx[p]];
+            next.edge_ids[pos] = graph->edge_ids[p];
+        }
+    }
+    for (int i = 0; i < delta->edges.count; i++) {
+        delta_edge *e = &logged[i];
+        if (!e->exists || e->seen) continue;
+        int pos = next.row_ptr[e->source_id] + fill[e->source_id]++;
+        next.col_idx[pos] = e->target_id;
+        next.edge_ids[pos] = e->id;
+    }
+
+    /* Incoming lists, same order */
+    memset(fill, 0, (nn + 1) * sizeof(int));
+    for (int t = 0; t < n; t++) {
+        int nt = remap[t];
+        if (nt < 0) continue;
+        for (int q = graph->in_row_ptr[t]; q < graph->in_row_ptr[t + 1]; q++) {
+            int src = remap[graph->in_col_idx[q]];
+            if (in_drop[q] || src < 0) continue;
+            next.in_col_idx[next.in_row_ptr[nt] + fill[nt]++] = src;
+        }
+    }
+    for (int i = 0; i < delta->edges.count; i++) {
+        delta_edge *e = &logged[i];
+        if (!e->exists || e->seen) continue;
+        next.in_col_idx[next.in_row_ptr[e->target_id] + fill[e->target_id]++] = e->source_id;
+    }
+
+    /* Carry user ids over to the new numbering */
+    for (int i = 0; i < n; i++) {
+        if (remap[i] >= 0) {
+            next.user_ids[remap[i]] = graph->user_ids ? graph->user_ids[i] : NULL;
+        } else if (graph->user_ids) {
+            free(graph->user_ids[i]);
+        }
+        if (graph->user_ids) graph->user_ids[i] = NULL;
+    }
+
+    /* Swap the new arrays in; the old ones are released below */
+    {
+        csr_graph old = *graph;
+        graph->node_count = next.node_count;
+        graph->edge_count = next.edge_count;
+        graph->row_ptr = next.row_ptr;
+        graph->col_idx = next.col_idx;
+        graph->node_ids = next.node_ids;
+        graph->user_ids = next.user_ids;
+        graph->node_idx = next.node_idx;
+        graph->node_idx_size = next.node_idx_size;
+        graph->in_row_ptr = next.in_row_ptr;
+        graph->in_col_idx = next.in_col_idx;
+        graph->edge_ids = next.edge_ids;
+        next = old;
+        next.delta = NULL;
+    }
+
+    if (delta->ids_dirty) {
+        for (int i = 0; i < graph->node_count; i++) {
+            free(graph->user_ids[i]);
+            graph->user_ids[i] = NULL;
+        }
+        csr_load_user_ids(db, graph);
+    } else {
+        apply_user_id_changes(db, graph, &delta->props);
+    }
+    csr_index_user_ids(graph);
+
+    CYPHER_DEBUG("Merged graph delta: %d -> %d nodes, %d -> %d edges",
+                 n, graph->node_count, m, graph->edge_count);
+    rc = 0;
+
+cleanup:
+    if (stmt) sqlite3_finalize(stmt);
+    free(next.row_ptr);
+    free(next.col_idx);
+    free(next.node_ids);
+    free(next.user_ids);
+    free(next.node_idx);
+    free(next.in_row_ptr);
+    free(next.in_col_idx);
+    free(next.edge_ids);
+    free(fill);
+    free(logged);
+    free(added);
+    free(removed);
+    free(out_drop);
+    free(in_drop);
+    free(remap);
+    return rc;
+}
+
+/* Bring an incremental graph up to date; 0 on success, -1 if it is unusable */
+int csr_graph_sync(sqlite3 *db, csr_graph *graph)
+{
+    if (!graph || !graph->delta) return 0;
+
+    if (delta_data_version(db) != graph->delta->data_version) {
+        CYPHER_DEBUG("Another connection changed the database, rebuilding the graph");
+        graph->delta->rebuild = true;
+    } else if (graph->delta->recorded == 0) {
+        return 0;
+    }
+
+    if (!graph->delta->rebuild && csr_delta_merge(db, graph) == 0) {
+        csr_delta_reset(graph->delta);
+        return 0;
+    }
+
+    /* Rebuild from scratch and take over the fresh arrays and log */
+    csr_graph *fresh = csr_graph_load_incremental(db);
+    if (!fresh) return -1;
+
+    csr_graph old = *graph;
+    *graph = *fresh;
+    *fresh = old;
+    csr_graph_free(fresh);
+    return 0;
+}
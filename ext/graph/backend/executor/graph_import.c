@@ -0,0 +1,1292 @@
+/*
+ * Graph Import
+ * Streaming CSV / JSONL loader behind gql_import() and the CLI --import option
+ *
+ * Files are read in IMPORT_BLOCK_SIZE chunks into one growable buffer and
+ * split in place: record and field boundaries are found with memchr() /
+ * strchr() (vectorized in common libcs) and only quoted fields are copied
+ * while unescaping. Rows go straight to the bulk writer from
+ * executor_bulk.c with ids assigned in memory, and edge endpoints are
+ * resolved through a hash map from external id to node id.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <math.h>
+#include <time.h>
+
+#include "executor/graph_import.h"
+#include "executor/executor_internal.h"
+#include "parser/cypher_debug.h"
+
+/* Bytes read per fread(); records longer than this grow the buffer */
+#define IMPORT_BLOCK_SIZE (1 << 20)
+
+#define IMPORT_SAVEPOINT "graphqlite_import"
+
+/* Declared column type that is guessed from each value instead */
+#define IMPORT_TYPE_INFER -1
+
+typedef struct {
+    char *format;
+    char delimiter;                 /* 0 = from the file extension */
+    char *id_column;
+    char *label_column;
+    char *source_column;
+    char *target_column;
+    char *type_column;
+    char *label;
+    char *type;
+    bool infer_types;
+    int defer_indexes;              /* -1 = when the graph starts empty */
+    long commit_rows;
+} import_options;
+
+/* Buffered file reader; the current record is split in place */
+typedef struct {
+    FILE *fp;
+    const char *path;
+    bool csv;
+    char delimiter;
+    char *buf;
+    size_t cap;
+    size_t start;                   /* First unread byte */
+    size_t end;                     /* End of buffered data */
+    bool eof;
+    long row;                       /* Records read, header included */
+    char *record;
+    char **fields;
+    int nfields;
+    int fields_cap;
+} import_reader;
+
+typedef enum {
+    IMPORT_COL_PROPERTY,
+    IMPORT_COL_ID,                  /* Also stored as a property */
+    IMPORT_COL_LABEL,
+    IMPORT_COL_SOURCE,
+    IMPORT_COL_TARGET,
+    IMPORT_COL_TYPE,
+    IMPORT_COL_IGNORE
+} import_role;
+
+typedef struct {
+    import_role role;
+    char *name;
+    int key_id;
+    int declared;                   /* property_type or IMPORT_TYPE_INFER */
+} import_column;
+
+/* External id -> node id; keys live in a block arena */
+typedef struct {
+    const char *key;
+    unsigned long hash;
+    int node_id;
+} import_id_slot;
+
+typedef struct import_arena_block {
+    struct import_arena_block *next;
+    size_t used;
+    size_t size;
+    char data[];
+} import_arena_block;
+
+typedef struct {
+    import_id_slot *slots;
+    size_t capacity;
+    size_t count;
+    import_arena_block *arena;
+} import_id_map;
+
+typedef struct {
+    sqlite3 *db;
+    import_options opts;
+    cypher_schema_manager *schema;
+    bulk_writer *writer;
+    graph_import_stats *stats;
+    char *error;
+
+    int next_node_id;
+    int next_edge_id;
+    import_id_map ids;
+    char *id_key;                   /* Property holding external ids */
+    bool graph_had_nodes;
+    sqlite3_stmt *find_existing;
+
+    bool own_txn;
+    long since_commit;
+
+    /* JSONL */
+    sqlite3_stmt *json_fields;
+    sqlite3_stmt *json_nested;
+} import_ctx;
+
+static void import_error(import_ctx *ctx, const char *fmt, ...)
+{
+    if (ctx->error) {
+        return;
+    }
+    char buf[512];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    ctx->error = strdup(buf);
+}
+
+/* ------------------------------------------------------------------------
+ * Options
+ * ------------------------------------------------------------------------ */
+
+static char *import_option_text(sqlite3_stmt *stmt, int col, const char *fallback)
+{
+    const char *text = (const char*)sqlite3_column_text(stmt, col);
+    if (text) {
+        return strdup(text);
+    }
+    return fallback ? strdup(fallback) : NULL;
+}
+
+static int import_parse_options(import_ctx *ctx, const char *options_json)
+{
+    import_options *o = &ctx->opts;
+    sqlite3_stmt *stmt;
+    const char *sql =
+        "SELECT json_extract(?1, '$.format'), json_extract(?1, '$.delimiter'),"
+        "       json_extract(?1, '$.id_column'), json_extract(?1, '$.label_column'),"
+        "       json_extract(?1, '$.source_column'), json_extract(?1, '$.target_column'),"
+        "       json_extract(?1, '$.type_column'), json_extract(?1, '$.label'),"
+        "       json_extract(?1, '$.type'), json_extract(?1, '$.infer_types'),"
+        "       json_extract(?1, '$.defer_indexes'), json_extract(?1, '$.commit_rows')";
+
+    if (sqlite3_prepare_v2(ctx->db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+        import_error(ctx, "Failed to read import options: %s", sqlite3_errmsg(ctx->db));
+        return -1;
+    }
+    sqlite3_bind_text(stmt, 1, options_json ? options_json : "{}", -1, SQLITE_STATIC);
+
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        import_error(ctx, "Import options must be a JSON object");
+        sqlite3_finalize(stmt);
+        return -1;
+    }
+
+    o->format = import_option_text(stmt, 0, NULL);
+    const char *delimiter = (const char*)sqlite3_column_text(stmt, 1);
+    o->delimiter = (delimiter && delimiter[0]) ? delimiter[0] : 0;
+    o->id_column = import_option_text(stmt, 2, "id");
+    o->label_column = import_option_text(stmt, 3, "label");
+    o->source_column = import_option_text(stmt, 4, "source");
+    o->target_column = import_option_text(stmt, 5, "target");
+    o->type_column = import_option_text(stmt, 6, "type");
+    o->label = import_option_text(stmt, 7, NULL);
+    o->type = import_option_text(stmt, 8, NULL);
+    o->infer_types = sqlite3_column_type(stmt, 9) == SQLITE_NULL || sqlite3_column_int(stmt, 9);
+    o->defer_indexes = sqlite3_column_type(stmt, 10) == SQLITE_NULL ? -1 : sqlite3_column_int(stmt, 10) != 0;
+    o->commit_rows = sqlite3_column_int64(stmt, 11);
+    sqlite3_finalize(stmt);
+
+    if (!o->id_column || !o->label_column || !o->source_column ||
+        !o->target_column || !o->type_column) {
+        import_error(ctx, "Out of memory");
+        return -1;
+    }
+    if (o->format && strcmp(o->format, "csv") != 0 && strcmp(o->format, "jsonl") != 0) {
+        import_error(ctx, "Unknown import format '%s' (expected csv or jsonl)", o->format);
+        return -1;
+    }
+    return 0;
+}
+
+static void import_free_options(import_options *o)
+{
+    free(o->format);
+    free(o->id_column);
+    free(o->label_column);
+    free(o->source_column);
+    free(o->target_column);
+    free(o->type_column);
+    free(o->label);
+    free(o->type);
+}
+
+/* ------------------------------------------------------------------------
+ * Reader
+ * ------------------------------------------------------------------------ */
+
+static bool import_has_suffix(const char *path, const char *suffix)
+{
+    size_t n = strlen(path), m = strlen(suffix);
+    return n >= m && strcasecmp(path + n - m, suffix) == 0;
+}
+
+static int reader_open(import_ctx *ctx, import_reader *r, const char *path)
+{
+    memset(r, 0, sizeof(*r));
+    r->path = path;
+
+    if (ctx->opts.format) {
+        r->csv = strcmp(ctx->opts.format, "csv") == 0;
+    } else {
+        r->csv = !(import_has_suffix(path, ".jsonl") || import_has_suffix(path, ".ndjson") ||
+                   import_has_suffix(path, ".json"));
+    }
+    r->delimiter = ctx->opts.delimiter ? ctx->opts.delimiter
+                 : import_has_suffix(path, ".tsv") ? '\t' : ',';
+
+    r->fp = fopen(path, "rb");
+    if (!r->fp) {
+        import_error(ctx, "Cannot open '%s'", path);
+        return -1;
+    }
+    r->cap = IMPORT_BLOCK_SIZE + 1;
+    r->buf = malloc(r->cap);
+    if (!r->buf) {
+        import_error(ctx, "Out of memory");
+        return -1;
+    }
+    return 0;
+}
+
+static void reader_close(import_reader *r)
+{
+    if (r->fp) {
+        fclose(r->fp);
+    }
+    free(r->buf);
+    free(r->fields);
+}
+
+/* Move unread data to the front and read another block (one byte stays free) */
+static int reader_fill(import_reader *r)
+{
+    if (r->start > 0) {
+        memmove(r->buf, r->buf + r->start, r->end - r->start);
+        r->end -= r->start;
+        r->start = 0;
+    }
+    if (r->cap - r->end < IMPORT_BLOCK_SIZE / 2 + 1) {
+        char *grown = realloc(r->buf, r->cap * 2);
+        if (!grown) {
+            return -1;
+        }
+        r->buf = grown;
+        r->cap *= 2;
+    }
+
+    size_t n = fread(r->buf + r->end, 1, r->cap - r->end - 1, r->fp);
+    r->end += n;
+    if (n == 0) {
+        if (ferror(r->fp)) {
+            return -1;
+        }
+        r->eof = true;
+    }
+    return 0;
+}
+
+/*
+ * Offset of the newline ending the record at r->start, or -1 if it is not
+ * fully buffered. Newlines inside CSV quotes do not end a record; a doubled
+ * quote simply closes and reopens the quoted section.
+ */
+static long reader_record_end(import_reader *r)
+{
+    const char *p = r->buf + r->start;
+    const char *end = r->buf + r->end;
+
+    while (p < end) {
+        const char *nl = memchr(p, '\n', end - p);
+        const char *limit = nl ? nl : end;
+        const char *quote = r->csv ? memchr(p, '"', limit - p) : NULL;
+        if (!quote) {
+            return nl ? nl - r->buf : -1;
+        }
+        const char *close = memchr(quote + 1, '"', end - quote - 1);
+        if (!close) {
+            return -1;
+        }
+        p = close + 1;
+    }
+    return -1;
+}
+
+/* Split a NUL-terminated CSV record into fields, unquoting in place */
+static int reader_split(import_reader *r, char *p)
+{
+    r->nfields = 0;
+    while (p) {
+        if (r->nfields == r->fields_cap) {
+            int cap = r->fields_cap ? r->fields_cap * 2 : 16;
+            char **grown = realloc(r->fields, cap * sizeof(char*));
+            if (!grown) {
+                return -1;
+            }
+            r->fields = grown;
+            r->fields_cap = cap;
+        }
+
+        char *field = p;
+        char *next;
+        if (*p == '"') {
+            char *w = p++;
+            for (;;) {
+                char *quote = strchr(p, '"');
+                if (!quote) {
+                    size_t n = strlen(p);
+                    memmove(w, p, n);
+                    w += n;
+                    p += n;
+                    break;
+                }
+                memmove(w, p, quote - p);
+                w += quote - p;
+                if (quote[1] == '"') {
+                    *w++ = '"';
+                    p = quote + 2;
+                    continue;
+                }
+                p = quote + 1;
+                break;
+            }
+            /* Text between the closing quote and the delimiter is dropped */
+            next = strchr(p, r->delimiter);
+            *w = '\0';
+        } else {
+            next = strchr(p, r->delimiter);
+            if (next) {
+                *next = '\0';
+            }
+        }
+        r->fields[r->nfields++] = field;
+        p = next ? next + 1 : NULL;
+    }
+    return 0;
+}
+
+/* Advance to the next non-blank record: 1 when one is ready, 0 at EOF, -1 on error */
+static int reader_next(import_reader *r)
+{
+    for (;;) {
+        long nl = reader_record_end(r);
+        size_t rec_end, next_start;
+
+        if (nl >= 0) {
+            rec_end = (size_t)nl;
+            next_start = rec_end + 1;
+        } else if (r->eof) {
+            if (r->start >= r->end) {
+                return 0;
+            }
+            rec_end = next_start = r->end;
+        } else {
+            if (reader_fill(r) < 0) {
+                return -1;
+            }
+            continue;
+        }
+
+        char *rec = r->buf + r->start;
+        r->buf[rec_end] = '\0';
+        if (rec_end > r->start && r->buf[rec_end - 1] == '\r') {
+            r->buf[rec_end - 1] = '\0';
+        }
+        r->start = next_start;
+        r->row++;
+
+        /* Editors that save as "UTF-8 with BOM" put one before the header */
+        if (r->row == 1 && strncmp(rec, "\xEF\xBB\xBF", 3) == 0) {
+            rec += 3;
+        }
+        if (*rec == '\0') {
+            continue;
+        }
+        r->record = rec;
+        if (r->csv && reader_split(r, rec) < 0) {
+            return -1;
+        }
+        return 1;
+    }
+}
+
+/* ------------------------------------------------------------------------
+ * External id map
+ * ------------------------------------------------------------------------ */
+
+/* Hash function - djb2 algorithm */
+static unsigned long import_hash(const char *str)
+{
+    unsigned long hash = 5381;
+    int c;
+    while ((c = (unsigned char)*str++)) {
+        hash = ((hash << 5) + hash) + c;
+    }
+    return hash;
+}
+
+static const char *import_arena_copy(import_id_map *map, const char *text)
+{
+    size_t len = strlen(text) + 1;
+    import_arena_block *block = map->arena;
+    if (!block || block->size - block->used < len) {
+        size_t size = len > IMPORT_BLOCK_SIZE ? len : IMPORT_BLOCK_SIZE;
+        block = malloc(sizeof(import_arena_block) + size);
+        if (!block) {
+            return NULL;
+        }
+        block->next = map->arena;
+        block->used = 0;
+        block->size = size;
+        map->arena = block;
+    }
+    char *copy = block->data + block->used;
+    memcpy(copy, text, len);
+    block->used += len;
+    return copy;
+}
+
+static import_id_slot *import_id_slot_for(import_id_map *map, const char *key, unsigned long hash)
+{
+    size_t mask = map->capacity - 1;
+    size_t i = hash & mask;
+    while (map->slots[i].key &&
+           (map->slots[i].hash != hash || strcmp(map->slots[i].key, key) != 0)) {
+        i = (i + 1) & mask;
+    }
+    return &map->slots[i];
+}
+
+static int import_id_lookup(import_id_map *map, const char *key)
+{
+    if (map->count == 0) {
+        return -1;
+    }
+    import_id_slot *slot = import_id_slot_for(map, key, import_hash(key));
+    return slot->key ? slot->node_id : -1;
+}
+
+/* Returns 1 if added, 0 if the key already exists, -1 on allocation failure */
+static int import_id_add(import_id_map *map, const char *key, int node_id)
+{
+    if ((map->count + 1) * 10 > map->capacity * 7) {
+        size_t capacity = map->capacity ? map->capacity * 2 : 1024;
+        import_id_slot *slots = calloc(capacity, sizeof(import_id_slot));
+        if (!slots) {
+            return -1;
+        }
+        for (size_t i = 0; i < map->capacity; i++) {
+            if (map->slots[i].key) {
+                size_t j = map->slots[i].hash & (capacity - 1);
+                while (slots[j].key) {
+                    j = (j + 1) & (capacity - 1);
+                }
+                slots[j] = map->slots[i];
+            }
+        }
+        free(map->slots);
+        map->slots = slots;
+        map->capacity = capacity;
+    }
+
+    unsigned long hash = import_hash(key);
+    import_id_slot *slot = import_id_slot_for(map, key, hash);
+    if (slot->key) {
+        return 0;
+    }
+    slot->key = import_arena_copy(map, key);
+    if (!slot->key) {
+        return -1;
+    }
+    slot->hash = hash;
+    slot->node_id = node_id;
+    map->count++;
+    return 1;
+}
+
+static void import_id_map_free(import_id_map *map)
+{
+    while (map->arena) {
+        import_arena_block *next = map->arena->next;
+        free(map->arena);
+        map->arena = next;
+    }
+    free(map->slots);
+}
+
+/* ------------------------------------------------------------------------
+ * Values
+ * ------------------------------------------------------------------------ */
+
+static bool import_parse_integer(const char *text, int64_t *out)
+{
+    const char *p = text;
+    if (*p == '-' || *p == '+') p++;
+    /* Leading zeros (zip codes, phone numbers) stay text */
+    if (!*p || (p[0] == '0' && p[1]) || strlen(p) > 18) {
+        return false;
+    }
+    for (const char *d = p; *d; d++) {
+        if (*d < '0' || *d > '9') {
+            return false;
+        }
+    }
+    *out = strtoll(text, NULL, 10);
+    return true;
+}
+
+static bool import_parse_real(const char *text, double *out)
+{
+    if (!strpbrk(text, "0123456789") || strpbrk(text, "xXnN")) {
+        return false;
+    }
+    char *end;
+    *out = strtod(text, &end);
+    return *end == '\0' && isfinite(*out);
+}
+
+/* Convert one CSV field; -1 if it does not parse as the declared type */
+static int import_parse_value(const char *text, int declared, bool infer, bulk_value *out)
+{
+    memset(out, 0, sizeof(*out));
+
+    switch (declared) {
+        case PROP_TYPE_INTEGER: {
+            char *end;
+            out->type = PROP_TYPE_INTEGER;
+            out->integer = strtoll(text, &end, 10);
+            return *end == '\0' ? 0 : -1;
+        }
+        case PROP_TYPE_REAL:
+            out->type = PROP_TYPE_REAL;
+            return import_parse_real(text, &out->real) ? 0 : -1;
+        case PROP_TYPE_BOOLEAN:
+            out->type = PROP_TYPE_BOOLEAN;
+            if (strcasecmp(text, "true") == 0 || strcmp(text, "1") == 0) {
+                out->integer = 1;
+                return 0;
+            }
+            if (strcasecmp(text, "false") == 0 || strcmp(text, "0") == 0) {
+                out->integer = 0;
+                return 0;
+            }
+            return -1;
+        case PROP_TYPE_TEXT:
+        case PROP_TYPE_JSON:
+            out->type = declared;
+            out->text = text;
+            return 0;
+        default:
+            break;
+    }
+
+    if (infer) {
+        if (import_parse_integer(text, &out->integer)) {
+            out->type = PROP_TYPE_INTEGER;
+            return 0;
+        }
+        const char *digits = text + (text[0] == '-' || text[0] == '+');
+        bool leading_zero = digits[0] == '0' && digits[1] >= '0' && digits[1] <= '9';
+        if (!leading_zero && import_parse_real(text, &out->real)) {
+            out->type = PROP_TYPE_REAL;
+            return 0;
+        }
+        if (strcmp(text, "true") == 0 || strcmp(text, "false") == 0) {
+            out->type = PROP_TYPE_BOOLEAN;
+            out->integer = text[0] == 't';
+            return 0;
+        }
+    }
+    out->type = PROP_TYPE_TEXT;
+    out->text = text;
+    return 0;
+}
+
+/* ------------------------------------------------------------------------
+ * Shared row handling
+ * ------------------------------------------------------------------------ */
+
+/* Commit every opts.commit_rows rows when the import owns the transaction */
+static int import_row_done(import_ctx *ctx)
+{
+    if (!ctx->own_txn || ctx->opts.commit_rows <= 0 || ++ctx->since_commit < ctx->opts.commit_rows) {
+        return 0;
+    }
+    ctx->since_commit = 0;
+    if (bulk_writer_flush(ctx->writer) < 0 ||
+        sqlite3_exec(ctx->db, "COMMIT", NULL, NULL, NULL) != SQLITE_OK ||
+        sqlite3_exec(ctx->db, "BEGIN IMMEDIATE", NULL, NULL, NULL) != SQLITE_OK) {
+        import_error(ctx, "Import commit failed: %s", sqlite3_errmsg(ctx->db));
+        return -1;
+    }
+    return 0;
+}
+
+static int import_add_node_id(import_ctx *ctx, import_reader *r, const char *ext_id, int node_id)
+{
+    int rc = import_id_add(&ctx->ids, ext_id, node_id);
+    if (rc < 0) {
+        import_error(ctx, "Out of memory");
+        return -1;
+    }
+    if (rc == 0) {
+        import_error(ctx, "%s: row %ld: duplicate node id '%s'", r->path, r->row, ext_id);
+        return -1;
+    }
+    return 0;
+}
+
+/* Labels are ';'-separated, neo4j-admin style */
+static int import_write_labels(import_ctx *ctx, int node_id, char *labels, bool *labeled)
+{
+    char *save = NULL;
+    for (char *label = strtok_r(labels, ";", &save); label; label = strtok_r(NULL, ";", &save)) {
+        if (bulk_write_label(ctx->writer, node_id, label) < 0) {
+            return -1;
+        }
+        *labeled = true;
+    }
+    return 0;
+}
+
+static int import_write_property(import_ctx *ctx, bool is_edge, int owner_id, int key_id, const bulk_value *v)
+{
+    if (v->is_null) {
+        return 0;
+    }
+    if (bulk_write_property(ctx->writer, is_edge, owner_id, key_id, v) < 0) {
+        return -1;
+    }
+    ctx->stats->properties++;
+    return 0;
+}
+
+/* Node id for an edge endpoint: this import first, then existing nodes */
+static int import_resolve(import_ctx *ctx, const char *ext_id)
+{
+    int node_id = import_id_lookup(&ctx->ids, ext_id);
+    if (node_id >= 0 || !ctx->graph_had_nodes) {
+        return node_id;
+    }
+
+    if (!ctx->find_existing) {
+        const char *sql =
+            "SELECT node_id FROM node_props_text WHERE key_id = ?1 AND value = ?2 "
+            "UNION ALL SELECT node_id FROM node_props_int WHERE key_id = ?1 AND value = ?3 "
+            "LIMIT 1";
+        int key_id = cypher_schema_get_property_key_id(ctx->schema, ctx->id_key);
+        if (key_id < 0 || sqlite3_prepare_v2(ctx->db, sql, -1, &ctx->find_existing, NULL) != SQLITE_OK) {
+            ctx->graph_had_nodes = false;
+            return -1;
+        }
+        sqlite3_bind_int(ctx->find_existing, 1, key_id);
+    }
+
+    int64_t as_int;
+    sqlite3_bind_text(ctx->find_existing, 2, ext_id, -1, SQLITE_STATIC);
+    if (import_parse_integer(ext_id, &as_int)) {
+        sqlite3_bind_int64(ctx->find_existing, 3, as_int);
+    } else {
+        sqlite3_bind_null(ctx->find_existing, 3);
+    }
+    if (sqlite3_step(ctx->find_existing) == SQLITE_ROW) {
+        node_id = sqlite3_column_int(ctx->find_existing, 0);
+    }
+    sqlite3_reset(ctx->find_existing);
+
+    if (node_id >= 0 && import_id_add(&ctx->ids, ext_id, node_id) < 0) {
+        return -1;
+    }
+    return node_id;
+}
+
+static int import_write_edge(import_ctx *ctx, const char *source, const char *target,
+                             const char *type, int *edge_id)
+{
+    int source_id = (source && *source) ? import_resolve(ctx, source) : -1;
+    int target_id = (target && *target) ? import_resolve(ctx, target) : -1;
+    if (!type || !*type) {
+        type = ctx->opts.type;
+    }
+    if (source_id < 0 || target_id < 0 || !type) {
+        ctx->stats->skipped++;
+        *edge_id = -1;
+        return 0;
+    }
+
+    *edge_id = ctx->next_edge_id++;
+    if (bulk_write_edge(ctx->writer, *edge_id, source_id, target_id, type) < 0) {
+        return -1;
+    }
+    ctx->stats->edges++;
+    return 0;
+}
+
+/* ------------------------------------------------------------------------
+ * CSV
+ * ------------------------------------------------------------------------ */
+
+static int import_declared_type(const char *name)
+{
+    static const struct { const char *name; int type; } types[] = {
+        { "int", PROP_TYPE_INTEGER }, { "long", PROP_TYPE_INTEGER },
+        { "integer", PROP_TYPE_INTEGER }, { "short", PROP_TYPE_INTEGER },
+        { "float", PROP_TYPE_REAL }, { "double", PROP_TYPE_REAL }, { "real", PROP_TYPE_REAL },
+        { "boolean", PROP_TYPE_BOOLEAN }, { "bool", PROP_TYPE_BOOLEAN },
+        { "string", PROP_TYPE_TEXT }, { "text", PROP_TYPE_TEXT },
+        { "json", PROP_TYPE_JSON },
+    };
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        if (strcasecmp(name, types[i].name) == 0) {
+            return types[i].type;
+        }
+    }
+    return -2;
+}
+
+static void import_free_columns(import_column *cols, int count)
+{
+    for (int i = 0; i < count; i++) {
+        free(cols[i].name);
+    }
+    free(cols);
+}
+
+/* Map header fields to roles, property keys and declared types */
+static import_column *import_parse_header(import_ctx *ctx, import_reader *r, bool edges)
+{
+    import_column *cols = calloc(r->nfields, sizeof(import_column));
+    if (!cols) {
+        import_error(ctx, "Out of memory");
+        return NULL;
+    }
+
+    for (int i = 0; i < r->nfields; i++) {
+        import_column *col = &cols[i];
+        char *name = r->fields[i];
+        char *suffix = strrchr(name, ':');
+        if (suffix) {
+            *suffix++ = '\0';
+            char *group = strchr(suffix, '(');      /* :ID(Person) id spaces */
+            if (group) {
+                *group = '\0';
+            }
+        }
+
+        col->role = IMPORT_COL_PROPERTY;
+        col->declared = IMPORT_TYPE_INFER;
+        if (suffix) {
+            if (strcasecmp(suffix, "ID") == 0) {
+                col->role = edges ? IMPORT_COL_IGNORE : IMPORT_COL_ID;
+            } else if (strcasecmp(suffix, "LABEL") == 0) {
+                col->role = IMPORT_COL_LABEL;
+            } else if (strcasecmp(suffix, "START_ID") == 0) {
+                col->role = IMPORT_COL_SOURCE;
+            } else if (strcasecmp(suffix, "END_ID") == 0) {
+                col->role = IMPORT_COL_TARGET;
+            } else if (strcasecmp(suffix, "TYPE") == 0) {
+                col->role = IMPORT_COL_TYPE;
+            } else if (strcasecmp(suffix, "IGNORE") == 0) {
+                col->role = IMPORT_COL_IGNORE;
+            } else if ((col->declared = import_declared_type(suffix)) == -2) {
+                import_error(ctx, "%s: unknown column type '%s' for '%s'", r->path, suffix, name);
+                import_free_columns(cols, r->nfields);
+                return NULL;
+            }
+        } else if (!edges && strcmp(name, ctx->opts.id_column) == 0) {
+            col->role = IMPORT_COL_ID;
+        } else if (!edges && (strcmp(name, ctx->opts.label_column) == 0 || strcmp(name, "labels") == 0)) {
+            col->role = IMPORT_COL_LABEL;
+        } else if (edges && strcmp(name, ctx->opts.source_column) == 0) {
+            col->role = IMPORT_COL_SOURCE;
+        } else if (edges && strcmp(name, ctx->opts.target_column) == 0) {
+            col->role = IMPORT_COL_TARGET;
+        } else if (edges && strcmp(name, ctx->opts.type_column) == 0) {
+            col->role = IMPORT_COL_TYPE;
+        }
+
+        if (col->role != IMPORT_COL_PROPERTY && col->role != IMPORT_COL_ID) {
+            continue;
+        }
+        if (col->role == IMPORT_COL_ID && !*name) {
+            name = ctx->opts.id_column;
+        }
+        if (!*name) {
+            import_error(ctx, "%s: column %d has no name", r->path, i + 1);
+            import_free_columns(cols, r->nfields);
+            return NULL;
+        }
+        for (int j = 0; j < i; j++) {
+            if (cols[j].name && strcmp(cols[j].name, name) == 0) {
+                import_error(ctx, "%s: duplicate column '%s'", r->path, name);
+                import_free_columns(cols, r->nfields);
+                return NULL;
+            }
+        }
+        col->name = strdup(name);
+        col->key_id = col->name ? cypher_schema_ensure_property_key(ctx->schema, name) : -1;
+        if (col->key_id < 0) {
+            import_error(ctx, "%s: failed to register property key '%s'", r->path, name);
+            import_free_columns(cols, r->nfields);
+            return NULL;
+        }
+    }
+    return cols;
+}
+
+static int import_csv_properties(import_ctx *ctx, import_reader *r, import_column *cols,
+                                 bool is_edge, int owner_id)
+{
+    for (int i = 0; i < r->nfields; i++) {
+        const char *text = r->fields[i];
+        if (!*text || (cols[i].role != IMPORT_COL_PROPERTY && cols[i].role != IMPORT_COL_ID)) {
+            continue;
+        }
+        bulk_value v;
+        if (import_parse_value(text, cols[i].declared, ctx->opts.infer_types, &v) < 0) {
+            import_error(ctx, "%s: row %ld: invalid value '%s' for column '%s'",
+                         r->path, r->row, text, cols[i].name);
+            return -1;
+        }
+        if (import_write_property(ctx, is_edge, owner_id, cols[i].key_id, &v) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int import_csv(import_ctx *ctx, import_reader *r, bool edges)
+{
+    int rc = reader_next(r);
+    if (rc <= 0) {
+        if (rc < 0) {
+            import_error(ctx, "%s: read failed", r->path);
+        }
+        return rc;
+    }
+
+    int ncols = r->nfields;
+    import_column *cols = import_parse_header(ctx, r, edges);
+    if (!cols) {
+        return -1;
+    }
+
+    int source_col = -1, target_col = -1, type_col = -1;
+    for (int i = 0; i < ncols; i++) {
+        if (cols[i].role == IMPORT_COL_SOURCE) source_col = i;
+        if (cols[i].role == IMPORT_COL_TARGET) target_col = i;
+        if (cols[i].role == IMPORT_COL_TYPE) type_col = i;
+        if (cols[i].role == IMPORT_COL_ID && strcmp(cols[i].name, ctx->id_key) != 0) {
+            free(ctx->id_key);
+            ctx->id_key = strdup(cols[i].name);
+        }
+    }
+    if (edges && (source_col < 0 || target_col < 0 || (type_col < 0 && !ctx->opts.type))) {
+        import_error(ctx, "%s: edge files need source, target and type columns "
+                     "(or the type option)", r->path);
+        import_free_columns(cols, ncols);
+        return -1;
+    }
+
+    while ((rc = reader_next(r)) > 0) {
+        if (r->nfields > ncols) {
+            r->nfields = ncols;     /* Extra trailing fields are ignored */
+        }
+
+        if (edges) {
+            const char *source = source_col < r->nfields ? r->fields[source_col] : NULL;
+            const char *target = target_col < r->nfields ? r->fields[target_col] : NULL;
+            const char *type = (type_col >= 0 && type_col < r->nfields) ? r->fields[type_col] : NULL;
+            int edge_id;
+            if (import_write_edge(ctx, source, target, type, &edge_id) < 0 ||
+                (edge_id >= 0 && import_csv_properties(ctx, r, cols, true, edge_id) < 0)) {
+                rc = -1;
+                break;
+            }
+        } else {
+            int node_id = ctx->next_node_id++;
+            bool labeled = false;
+            if (bulk_write_node(ctx->writer, node_id) < 0) {
+                rc = -1;
+                break;
+            }
+            ctx->stats->nodes++;
+
+            for (int i = 0; i < r->nfields && rc > 0; i++) {
+                if (!*r->fields[i]) {
+                    continue;
+                }
+                if (cols[i].role == IMPORT_COL_ID) {
+                    rc = import_add_node_id(ctx, r, r->fields[i], node_id) < 0 ? -1 : 1;
+                } else if (cols[i].role == IMPORT_COL_LABEL) {
+                    rc = import_write_labels(ctx, node_id, r->fields[i], &labeled) < 0 ? -1 : 1;
+                }
+            }
+            if (rc < 0 ||
+                (!labeled && ctx->opts.label && bulk_write_label(ctx->writer, node_id, ctx->opts.label) < 0) ||
+                import_csv_properties(ctx, r, cols, false, node_id) < 0) {
+                rc = -1;
+                break;
+            }
+        }
+
+        if (import_row_done(ctx) < 0) {
+            rc = -1;
+            break;
+        }
+    }
+
+    if (rc < 0) {
+        import_error(ctx, "%s: import failed at row %ld: %s", r->path, r->row, sqlite3_errmsg(ctx->db));
+    }
+    import_free_columns(cols, ncols);
+    return rc < 0 ? -1 : 0;
+}
+
+/* ------------------------------------------------------------------------
+ * JSONL
+ * ------------------------------------------------------------------------ */
+
+static bool import_json_key_is(sqlite3_stmt *stmt, const char *name)
+{
+    const char *key = (const char*)sqlite3_column_text(stmt, 0);
+    return key && strcmp(key, name) == 0;
+}
+
+/* Write the members of a JSON object as properties */
+static int import_json_properties(import_ctx *ctx, const char *object, bool is_edge, int owner_id)
+{
+    sqlite3_stmt *stmt = ctx->json_nested;
+    sqlite3_bind_text(stmt, 1, object, -1, SQLITE_TRANSIENT);
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const char *key = (const char*)sqlite3_column_text(stmt, 0);
+        int key_id = key ? cypher_schema_ensure_property_key(ctx->schema, key) : -1;
+        if (key_id < 0) {
+            continue;
+        }
+        bulk_value v;
+        bulk_value_from_json(stmt, 1, (const char*)sqlite3_column_text(stmt, 2), &v);
+        if (import_write_property(ctx, is_edge, owner_id, key_id, &v) < 0) {
+            rc = SQLITE_ERROR;
+            break;
+        }
+    }
+    sqlite3_reset(stmt);
+    return rc == SQLITE_DONE ? 0 : -1;
+}
+
+static bool import_json_structural(import_ctx *ctx, sqlite3_stmt *stmt, bool edges)
+{
+    if (import_json_key_is(stmt, "properties")) {
+        return true;
+    }
+    if (edges) {
+        return import_json_key_is(stmt, ctx->opts.source_column) ||
+               import_json_key_is(stmt, ctx->opts.target_column) ||
+               import_json_key_is(stmt, ctx->opts.type_column);
+    }
+    return import_json_key_is(stmt, ctx->opts.label_column) || import_json_key_is(stmt, "labels");
+}
+
+/* Top-level members that are not structural become properties */
+static int import_json_row_properties(import_ctx *ctx, bool edges, int owner_id)
+{
+    sqlite3_stmt *stmt = ctx->json_fields;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const char *type = (const char*)sqlite3_column_text(stmt, 2);
+        if (import_json_key_is(stmt, "properties")) {
+            if (type && strcmp(type, "object") == 0 &&
+                import_json_properties(ctx, (const char*)sqlite3_column_text(stmt, 1), edges, owner_id) < 0) {
+                return -1;
+            }
+            continue;
+        }
+        if (import_json_structural(ctx, stmt, edges)) {
+            continue;
+        }
+        const char *key = (const char*)sqlite3_column_text(stmt, 0);
+        int key_id = key ? cypher_schema_ensure_property_key(ctx->schema, key) : -1;
+        if (key_id < 0) {
+            continue;
+        }
+        bulk_value v;
+        bulk_value_from_json(stmt, 1, type, &v);
+        if (import_write_property(ctx, edges, owner_id, key_id, &v) < 0) {
+            return -1;
+        }
+    }
+    return rc == SQLITE_DONE ? 0 : -1;
+}
+
+static int import_jsonl_node(import_ctx *ctx, import_reader *r)
+{
+    sqlite3_stmt *stmt = ctx->json_fields;
+    int node_id = ctx->next_node_id++;
+    bool labeled = false;
+
+    if (bulk_write_node(ctx->writer, node_id) < 0) {
+        return -1;
+    }
+    ctx->stats->nodes++;
+
+    /* Pass 1: id and labels */
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const char *value = (const char*)sqlite3_column_text(stmt, 1);
+        const char *type = (const char*)sqlite3_column_text(stmt, 2);
+        if (!value || !type) {
+            continue;
+        }
+        if (import_json_key_is(stmt, ctx->opts.id_column)) {
+            if (import_add_node_id(ctx, r, value, node_id) < 0) {
+                return -1;
+            }
+        } else if (import_json_key_is(stmt, ctx->opts.label_column) && strcmp(type, "text") == 0) {
+            if (bulk_write_label(ctx->writer, node_id, value) < 0) {
+                return -1;
+            }
+            labeled = true;
+        } else if (import_json_key_is(stmt, "labels") && strcmp(type, "array") == 0) {
+            sqlite3_stmt *labels = ctx->json_nested;
+            sqlite3_bind_text(labels, 1, value, -1, SQLITE_TRANSIENT);
+            while (sqlite3_step(labels) == SQLITE_ROW) {
+                const char *label = (const char*)sqlite3_column_text(labels, 1);
+                if (label && bulk_write_label(ctx->writer, node_id, label) < 0) {
+                    sqlite3_reset(labels);
+                    return -1;
+                }
+                labeled = true;
+            }
+            sqlite3_reset(labels);
+        }
+    }
+    if (rc != SQLITE_DONE) {
+        import_error(ctx, "%s: row %ld: invalid JSON", r->path, r->row);
+        return -1;
+    }
+    if (!labeled && ctx->opts.label && bulk_write_label(ctx->writer, node_id, ctx->opts.label) < 0) {
+        return -1;
+    }
+
+    /* Pass 2: properties (the id is kept as one) */
+    sqlite3_reset(stmt);
+    return import_json_row_properties(ctx, false, node_id);
+}
+
+static int import_jsonl_edge(import_ctx *ctx, import_reader *r)
+{
+    sqlite3_stmt *stmt = ctx->json_fields;
+    char *source = NULL, *target = NULL, *type = NULL;
+
+    /* Pass 1: endpoints and type */
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const char *value = (const char*)sqlite3_column_text(stmt, 1);
+        if (!value) {
+            continue;
+        }
+        if (import_json_key_is(stmt, ctx->opts.source_column) && !source) {
+            source = strdup(value);
+        } else if (import_json_key_is(stmt, ctx->opts.target_column) && !target) {
+            target = strdup(value);
+        } else if (import_json_key_is(stmt, ctx->opts.type_column) && !type) {
+            type = strdup(value);
+        }
+    }
+
+    int edge_id = -1;
+    if (rc != SQLITE_DONE) {
+        import_error(ctx, "%s: row %ld: invalid JSON", r->path, r->row);
+        rc = -1;
+    } else {
+        rc = import_write_edge(ctx, source, target, type, &edge_id);
+    }
+    free(source);
+    free(target);
+    free(type);
+    if (rc < 0 || edge_id < 0) {
+        return rc;
+    }
+
+    /* Pass 2: properties */
+    sqlite3_reset(stmt);
+    return import_json_row_properties(ctx, true, edge_id);
+}
+
+static int import_jsonl(import_ctx *ctx, import_reader *r, bool edges)
+{
+    if (!ctx->json_fields) {
+        const char *sql = "SELECT key, value, type FROM json_each(?1)";
+        if (sqlite3_prepare_v2(ctx->db, sql, -1, &ctx->json_fields, NULL) != SQLITE_OK ||
+            sqlite3_prepare_v2(ctx->db, sql, -1, &ctx->json_nested, NULL) != SQLITE_OK) {
+            import_error(ctx, "Failed to prepare JSON reader: %s", sqlite3_errmsg(ctx->db));
+            return -1;
+        }
+    }
+    int rc;
+    while ((rc = reader_next(r)) > 0) {
+        const char *p = r->record + strspn(r->record, " \t");
+        if (*p != '{') {
+            import_error(ctx, "%s: row %ld: expected a JSON object", r->path, r->row);
+            return -1;
+        }
+
+        sqlite3_bind_text(ctx->json_fields, 1, p, -1, SQLITE_STATIC);
+        rc = edges ? import_jsonl_edge(ctx, r) : import_jsonl_node(ctx, r);
+        sqlite3_reset(ctx->json_fields);
+        if (rc < 0 || import_row_done(ctx) < 0) {
+            import_error(ctx, "%s: import failed at row %ld: %s", r->path, r->row, sqlite3_errmsg(ctx->db));
+            return -1;
+        }
+    }
+    if (rc < 0) {
+        import_error(ctx, "%s: read failed", r->path);
+        return -1;
+    }
+    return 0;
+}
+
+/* ------------------------------------------------------------------------
+ * Entry point
+ * ------------------------------------------------------------------------ */
+
+static int import_file(import_ctx *ctx, const char *path, bool edges)
+{
+    import_reader r;
+    int rc = reader_open(ctx, &r, path);
+    if (rc == 0) {
+        rc = r.csv ? import_csv(ctx, &r, edges) : import_jsonl(ctx, &r, edges);
+    }
+    reader_close(&r);
+    return rc;
+}
+
+static bool import_graph_has_nodes(sqlite3 *db)
+{
+    sqlite3_stmt *stmt;
+    bool found = false;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM nodes LIMIT 1", -1, &stmt, NULL) == SQLITE_OK) {
+        found = sqlite3_step(stmt) == SQLITE_ROW;
+        sqlite3_finalize(stmt);
+    }
+    return found;
+}
+
+int graph_import(sqlite3 *db, const char *nodes_path, const char *edges_path,
+                 const char *options_json, graph_import_stats *stats, char **error)
+{
+    struct timespec t_start, t_end;
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+
+    import_ctx ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    memset(stats, 0, sizeof(*stats));
+    ctx.db = db;
+    ctx.stats = stats;
+    *error = NULL;
+
+    if (nodes_path && !*nodes_path) nodes_path = NULL;
+    if (edges_path && !*edges_path) edges_path = NULL;
+
+    if (import_parse_options(&ctx, options_json) < 0) {
+        import_free_options(&ctx.opts);
+        *error = ctx.error;
+        return -1;
+    }
+
+    ctx.schema = cypher_schema_create_manager(db);
+    ctx.writer = bulk_writer_create(db);
+    ctx.own_txn = sqlite3_get_autocommit(db);
+
+    bool defer = false;
+    bool began = false;
+    int rc = (ctx.schema && ctx.writer) ? 0 : -1;
+    if (rc == 0) {
+        rc = cypher_schema_create_tables(ctx.schema);
+    }
+    if (rc == 0) {
+        rc = sqlite3_exec(db, ctx.own_txn ? "BEGIN IMMEDIATE" : "SAVEPOINT " IMPORT_SAVEPOINT,
+                          NULL, NULL, NULL) == SQLITE_OK ? 0 : -1;
+        began = (rc == 0);
+    }
+    if (rc == 0) {
+        ctx.graph_had_nodes = import_graph_has_nodes(db);
+        defer = ctx.opts.defer_indexes < 0 ? !ctx.graph_had_nodes : ctx.opts.defer_indexes;
+        ctx.id_key = strdup(ctx.opts.id_column);
+        rc = ctx.id_key ? 0 : -1;
+    }
+    if (rc == 0) {
+        rc = bulk_reserve_ids(db, false, &ctx.next_node_id);
+    }
+    if (rc == 0) {
+        rc = bulk_reserve_ids(db, true, &ctx.next_edge_id);
+    }
+    if (rc == 0 && defer) {
+        rc = cypher_schema_drop_indexes(ctx.schema);
+    }
+    if (rc == 0 && defer) {
+        rc = cypher_schema_suspend_catalog(ctx.schema);
+    }
+    if (rc == 0 && nodes_path) {
+        rc = import_file(&ctx, nodes_path, false);
+    }
+    if (rc == 0 && edges_path) {
+        rc = import_file(&ctx, edges_path, true);
+    }
+    if (rc == 0) {
+        rc = bulk_writer_flush(ctx.writer);
+    }
+    if (rc == 0 && defer) {
+        rc = cypher_schema_create_indexes(ctx.schema);
+    }
+    if (rc == 0 && defer) {
+        rc = cypher_schema_resume_catalog(ctx.schema);
+    }
+
+    sqlite3_finalize(ctx.find_existing);
+    sqlite3_finalize(ctx.json_fields);
+    sqlite3_finalize(ctx.json_nested);
+    bulk_writer_free(ctx.writer);
+
+    if (rc == 0) {
+        rc = sqlite3_exec(db, ctx.own_txn ? "COMMIT" : "RELEASE " IMPORT_SAVEPOINT,
+                          NULL, NULL, NULL) == SQLITE_OK ? 0 : -1;
+    }
+    if (rc < 0) {
+        import_error(&ctx, "Import failed: %s", sqlite3_errmsg(db));
+        if (began && ctx.own_txn) {
+            sqlite3_exec(db, "ROLLBACK", NULL, NULL, NULL);
+        } else if (began) {
+            sqlite3_exec(db, "ROLLBACK TO " IMPORT_SAVEPOINT, NULL, NULL, NULL);
+            sqlite3_exec(db, "RELEASE " IMPORT_SAVEPOINT, NULL, NULL, NULL);
+        }
+        /* Chunks committed before the failure may have been loaded without indexes or catalog */
+        if (defer && ctx.schema) {
+            cypher_schema_create_indexes(ctx.schema);
+            cypher_schema_resume_catalog(ctx.schema);
+        }
+    }
+
+    cypher_schema_free_manager(ctx.schema);
+    import_id_map_free(&ctx.ids);
+    free(ctx.id_key);
+    import_free_options(&ctx.opts);
+
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
+    stats->seconds = (t_end.tv_sec - t_start.tv_sec) + (t_end.tv_nsec - t_start.tv_nsec) / 1e9;
+
+    CYPHER_DEBUG("Import: %ld nodes, %ld edges, %ld properties, %ld skipped in %.3fs",
+                 stats->nodes, stats->edges, stats->properties, stats->skipped, stats->seconds);
+
+    if (rc < 0) {
+        *error = ctx.error;
+        return -1;
+    }
+    free(ctx.error);
+    return 0;
+}
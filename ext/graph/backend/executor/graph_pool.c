@@ -0,0 +1,378 @@
+/*
+ * Graph Worker Pool
+ *
+ * A small per-connection thread pool for the whole-graph kernels. A job is
+ * a function and a number of parts; the calling thread and the workers
+ * claim parts until all are done. Kernels split the CSR rows into
+ * degree-balanced parts and give each part its own accumulators, so the
+ * result never depends on how many threads ran it.
+ *
+ * Without pthreads (Windows builds) the pool always has one thread and
+ * every job runs inline.
+ *
+ * Also here: the per-source sweep behind betweenness and closeness, and
+ * the pivot sampling for their approximate modes.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "executor/graph_algorithms.h"
+#include "executor/graph_algo_internal.h"
+
+#if GRAPH_POOL_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#define GRAPH_POOL_MAX_THREADS 64
+
+struct graph_pool {
+    int size;                 /* Threads running a job, the caller included */
+#if GRAPH_POOL_THREADS
+    pthread_t *threads;       /* size - 1 workers */
+    int started;
+    pthread_mutex_t lock;
+    pthread_cond_t work;      /* A new job was posted, or stop */
+    pthread_cond_t done;      /* The last part of the job finished */
+    unsigned long generation;
+    bool stop;
+
+    /* Current job, guarded by lock */
+    graph_pool_fn fn;
+    void *arg;
+    int parts;
+    int next_part;
+    int finished;
+#endif
+};
+
+#if GRAPH_POOL_THREADS
+/* Claim and run parts of the current job; called and returns with lock held */
+static void pool_drain(graph_pool *pool)
+{
+    while (pool->next_part < pool->parts) {
+        int part = pool->next_part++;
+        graph_pool_fn fn = pool->fn;
+        void *arg = pool->arg;
+
+        pthread_mutex_unlock(&pool->lock);
+        fn(arg, part);
+        pthread_mutex_lock(&pool->lock);
+
+        if (++pool->finished == pool->parts) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+}
+
+static void* pool_worker(void *data)
+{
+    graph_pool *pool = data;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stop && seen == pool->generation) {
+            pthread_cond_wait(&pool->work, &pool->lock);
+        }
+        if (pool->stop) break;
+        seen = pool->generation;
+        pool_drain(pool);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+#endif
+
+/* Pool of the given size; threads <= 0 means one per CPU */
+graph_pool* graph_pool_create(int threads)
+{
+    graph_pool *pool = calloc(1, sizeof(graph_pool));
+    if (!pool) return NULL;
+
+#if GRAPH_POOL_THREADS
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threads > GRAPH_POOL_MAX_THREADS) threads = GRAPH_POOL_MAX_THREADS;
+
+    pool->size = 1;
+    if (threads > 1) {
+        pool->threads = malloc((threads - 1) * sizeof(pthread_t));
+        if (!pool->threads) {
+            free(pool);
+            return NULL;
+        }
+        pthread_mutex_init(&pool->lock, NULL);
+        pthread_cond_init(&pool->work, NULL);
+        pthread_cond_init(&pool->done, NULL);
+
+        /* Run with however many workers could be started */
+        while (pool->started < threads - 1 &&
+               pthread_create(&pool->threads[pool->started], NULL, pool_worker, pool) == 0) {
+            pool->started++;
+        }
+        pool->size = pool->started + 1;
+    }
+#else
+    (void)threads;
+    pool->size = 1;
+#endif
+
+    CYPHER_DEBUG("Graph worker pool with %d threads", pool->size);
+    return pool;
+}
+
+void graph_pool_free(graph_pool *pool)
+{
+    if (!pool) return;
+
+#if GRAPH_POOL_THREADS
+    if (pool->threads) {
+        pthread_mutex_lock(&pool->lock);
+        pool->stop = true;
+        pthread_cond_broadcast(&pool->work);
+        pthread_mutex_unlock(&pool->lock);
+
+        for (int i = 0; i < pool->started; i++) {
+            pthread_join(pool->threads[i], NULL);
+        }
+        pthread_cond_destroy(&pool->done);
+        pthread_cond_destroy(&pool->work);
+        pthread_mutex_destroy(&pool->lock);
+        free(pool->threads);
+    }
+#endif
+    free(pool);
+}
+
+int graph_pool_size(const graph_pool *pool)
+{
+    return pool ? pool->size : 1;
+}
+
+/* Run fn(arg, part) for every part in [0, parts) and wait for all of them */
+void graph_pool_run(graph_pool *pool, int parts, graph_pool_fn fn, void *arg)
+{
+#if GRAPH_POOL_THREADS
+    if (pool && pool->size > 1 && parts > 1) {
+        pthread_mutex_lock(&pool->lock);
+        pool->fn = fn;
+        pool->arg = arg;
+        pool->parts = parts;
+        pool->next_part = 0;
+        pool->finished = 0;
+        pool->generation++;
+        pthread_cond_broadcast(&pool->work);
+
+        pool_drain(pool);
+        while (pool->finished < pool->parts) {
+            pthread_cond_wait(&pool->done, &pool->lock);
+        }
+        pthread_mutex_unlock(&pool->lock);
+        return;
+    }
+#else
+    (void)pool;
+#endif
+
+    for (int part = 0; part < parts; part++) {
+        fn(arg, part);
+    }
+}
+
+/*
+ * Number of parts to split a graph of this size into: one per thread, or
+ * one when the graph is too small for threads to pay off.
+ */
+int graph_pool_parts(const graph_pool *pool, const csr_graph *graph)
+{
+    int size = graph_pool_size(pool);
+    if (size <= 1 || (long long)graph->node_count + graph->edge_count < GRAPH_POOL_MIN_WORK) {
+        return 1;
+    }
+    return size < graph->node_count ? size : (graph->node_count > 0 ? graph->node_count : 1);
+}
+
+/*
+ * Split rows [0, n) into parts of about equal work, counting one unit per
+ * row plus one per entry of offsets (a row_ptr style array of n + 1).
+ * bounds receives parts + 1 row indices; part p is [bounds[p], bounds[p + 1]).
+ */
+void graph_partition_rows(const int *offsets, int n, int parts, int *bounds)
+{
+    long long total = (long long)offsets[n] + n;
+
+    bounds[0] = 0;
+    for (int p = 1; p < parts; p++) {
+        long long goal = total * p / parts;
+        int lo = bounds[p - 1], hi = n;
+
+        /* First row whose cumulative work reaches goal */
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if ((long long)offsets[mid] + mid < goal) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        bounds[p] = lo;
+    }
+    bounds[parts] = n;
+}
+
+/*
+ * Parts for a sweep over count sources, each costing about one pass over
+ * the graph: one per thread, no more than there are chunks of sources.
+ */
+int graph_pool_source_parts(const graph_pool *pool, const csr_graph *graph, int count)
+{
+    int size = graph_pool_size(pool);
+    long long work = (long long)count * ((long long)graph->node_count + graph->edge_count);
+    int chunks = (count + GRAPH_SOURCE_CHUNK - 1) / GRAPH_SOURCE_CHUNK;
+
+    if (size <= 1 || work < GRAPH_POOL_MIN_WORK || chunks <= 1) {
+        return 1;
+    }
+    return size < chunks ? size : chunks;
+}
+
+typedef struct {
+    const int *sources;
+    int count;
+    int n;
+    int first_chunk;
+    graph_source_fn fn;
+    void *arg;
+    double *acc;
+    double *acc_sq;
+} source_job;
+
+static void source_chunk_part(void *data, int part)
+{
+    source_job *job = data;
+    double *acc = job->acc + (size_t)part * job->n;
+    double *acc_sq = job->acc_sq ? job->acc_sq + (size_t)part * job->n : NULL;
+    int first = (job->first_chunk + part) * GRAPH_SOURCE_CHUNK;
+    int last = first + GRAPH_SOURCE_CHUNK < job->count ? first + GRAPH_SOURCE_CHUNK : job->count;
+
+    memset(acc, 0, job->n * sizeof(double));
+    if (acc_sq) memset(acc_sq, 0, job->n * sizeof(double));
+
+    for (int i = first; i < last; i++) {
+        job->fn(job->arg, part, job->sources ? job->sources[i] : i, acc, acc_sq);
+    }
+}
+
+/*
+ * Add the contributions of count sources (sources[i], or i when sources is
+ * NULL) into sum, and their squares into sum_sq when it is not NULL. The
+ * sources go in fixed chunks of GRAPH_SOURCE_CHUNK; each part sums one
+ * chunk into its own buffer and the buffers are added to the totals in
+ * chunk order, so the floats are the same for any number of parts.
+ * fn gets the part so it can use per-part scratch space.
+ * Returns -1 on allocation failure.
+ */
+int graph_pool_sum_sources(graph_pool *pool, int parts, int n, const int *sources, int count,
+                           graph_source_fn fn, void *arg, double *sum, double *sum_sq)
+{
+    double *acc = malloc((size_t)parts * n * sizeof(double));
+    double *acc_sq = sum_sq ? malloc((size_t)parts * n * sizeof(double)) : NULL;
+    if (!acc || (sum_sq && !acc_sq)) {
+        free(acc);
+        free(acc_sq);
+        return -1;
+    }
+
+    source_job job = {sources, count, n, 0, fn, arg, acc, acc_sq};
+    int chunks = (count + GRAPH_SOURCE_CHUNK - 1) / GRAPH_SOURCE_CHUNK;
+
+    while (job.first_chunk < chunks) {
+        int round = chunks - job.first_chunk < parts ? chunks - job.first_chunk : parts;
+        graph_pool_run(pool, round, source_chunk_part, &job);
+
+        for (int p = 0; p < round; p++) {
+            const double *part_acc = acc + (size_t)p * n;
+            for (int i = 0; i < n; i++) {
+                sum[i] += part_acc[i];
+            }
+            if (sum_sq) {
+                const double *part_sq = acc_sq + (size_t)p * n;
+                for (int i = 0; i < n; i++) {
+                    sum_sq[i] += part_sq[i];
+                }
+            }
+        }
+        job.first_chunk += round;
+    }
+
+    free(acc);
+    free(acc_sq);
+    return 0;
+}
+
+static int compare_int_asc(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Pick k distinct nodes out of n, uniformly and reproducibly for a given
+ * seed, and return them ascending. Returns NULL on allocation failure.
+ */
+int* graph_sample_sources(int n, int k, unsigned int seed)
+{
+    int *pool_idx = malloc((n > 0 ? n : 1) * sizeof(int));
+    if (!pool_idx) return NULL;
+
+    for (int i = 0; i < n; i++) {
+        pool_idx[i] = i;
+    }
+
+    /* Partial Fisher-Yates shuffle driven by splitmix64 */
+    unsigned long long state = seed;
+    for (int i = 0; i < k && i < n; i++) {
+        unsigned long long z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+
+        int j = i + (int)((z >> 32) * (unsigned long long)(n - i) >> 32);
+        int tmp = pool_idx[i];
+        pool_idx[i] = pool_idx[j];
+        pool_idx[j] = tmp;
+    }
+
+    qsort(pool_idx, k < n ? k : n, sizeof(int), compare_int_asc);
+    return pool_idx;
+}
+
+/*
+ * Turn sums over k pivots sampled from n sources into estimates of the sums
+ * over all n, in place: sum becomes the estimate and sum_sq its estimated
+ * standard error, with the finite population correction so sampling every
+ * source gives 0. This is not a confidence bound: contributions are
+ * heavy-tailed, so nodes that few pivots reach get a standard error that
+ * understates the actual error.
+ */
+void graph_sample_scale(int n, int k, double *sum, double *sum_sq)
+{
+    double scale = (double)n / (double)k;
+    double fpc = k < n ? 1.0 - (double)k / (double)n : 0.0;
+
+    for (int i = 0; i < n; i++) {
+        double variance = 0.0;
+        if (k > 1 && fpc > 0.0) {
+            double mean = sum[i] / k;
+            variance = (sum_sq[i] - mean * sum[i]) / (k - 1);
+            if (variance < 0.0) variance = 0.0;
+        }
+        sum[i] *= scale;
+        sum_sq[i] = n * sqrt(variance * fpc / k);
+    }
+}
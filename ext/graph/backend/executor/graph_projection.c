@@ -0,0 +1,179 @@
+/*
+ * Graph Projections
+ *
+ * Named subgraphs for the algorithm engine. gql_project(name, options)
+ * builds a CSR over the nodes carrying any of the given labels and the
+ * edges of any of the given types between them, keeping each edge's type
+ * and, when a weight property is named, its weight. Algorithms pick a
+ * projection with a trailing {graph: 'name'} argument.
+ *
+ *   gql_project('social', '{"labels": ["User"], "types": ["FOLLOWS"], "weight": "w"}')
+ *   RETURN pageRank({graph: 'social'})
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "executor/graph_algorithms.h"
+#include "executor/graph_algo_internal.h"
+
+static char* projection_error(const char *fmt, const char *arg)
+{
+    char buf[256];
+    snprintf(buf, sizeof(buf), fmt, arg ? arg : "");
+    return strdup(buf);
+}
+
+/* Check the options object; fills the weight key id (-1 when unweighted or unknown) */
+static int projection_options(sqlite3 *db, const char *options_json, bool *has_labels,
+                              bool *has_types, bool *weighted, int *weight_key, char **error)
+{
+    sqlite3_stmt *stmt = NULL;
+    int rc = -1;
+
+    if (sqlite3_prepare_v2(db,
+            "SELECT json_type(?1), json_type(?1, '$.labels'), json_type(?1, '$.types'), "
+            "json_type(?1, '$.weight'), "
+            "(SELECT id FROM property_keys WHERE key = json_extract(?1, '$.weight')), "
+            "(SELECT key FROM json_each(?1) WHERE key NOT IN ('labels', 'types', 'weight'))",
+            -1, &stmt, NULL) != SQLITE_OK) {
+        *error = projection_error("Failed to read projection options: %s", sqlite3_errmsg(db));
+        return -1;
+    }
+    sqlite3_bind_text(stmt, 1, options_json, -1, SQLITE_STATIC);
+
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        *error = strdup("Projection options must be a JSON object");
+    } else {
+        const char *type = (const char *)sqlite3_column_text(stmt, 0);
+        const char *labels = (const char *)sqlite3_column_text(stmt, 1);
+        const char *types = (const char *)sqlite3_column_text(stmt, 2);
+        const char *weight = (const char *)sqlite3_column_text(stmt, 3);
+        const char *unknown = (const char *)sqlite3_column_text(stmt, 5);
+
+        if (!type || strcmp(type, "object") != 0) {
+            *error = strdup("Projection options must be a JSON object");
+        } else if (unknown) {
+            *error = projection_error("Unknown projection option '%s'", unknown);
+        } else if (labels && strcmp(labels, "array") != 0 && strcmp(labels, "text") != 0) {
+            *error = strdup("Projection labels must be a string or a list of strings");
+        } else if (types && strcmp(types, "array") != 0 && strcmp(types, "text") != 0) {
+            *error = strdup("Projection types must be a string or a list of strings");
+        } else if (weight && strcmp(weight, "text") != 0) {
+            *error = strdup("Projection weight must be a property name");
+        } else {
+            *has_labels = labels != NULL;
+            *has_types = types != NULL;
+            *weighted = weight != NULL;
+            *weight_key = sqlite3_column_type(stmt, 4) == SQLITE_NULL ? -1 : sqlite3_column_int(stmt, 4);
+            rc = 0;
+        }
+    }
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+/*
+ * Build the CSR for one projection. Edges are kept only when both ends are
+ * projected; a weight property missing on an edge counts as 1.0.
+ */
+csr_graph* csr_graph_load_projection(sqlite3 *db, const char *options_json, char **error)
+{
+    bool has_labels = false, has_types = false, weighted = false;
+    int weight_key = -1;
+
+    *error = NULL;
+    if (projection_options(db, options_json ? options_json : "{}", &has_labels, &has_types,
+                           &weighted, &weight_key, error) < 0) {
+        return NULL;
+    }
+
+    const char *filter = has_types ?
+        " WHERE e.type IN (SELECT value FROM json_each(?1, '$.types'))" : "";
+
+    char weight_expr[320] = "1.0";
+    if (weight_key >= 0) {
+        snprintf(weight_expr, sizeof(weight_expr),
+                 "COALESCE((SELECT value FROM edge_props_real WHERE edge_id = e.id AND key_id = %d), "
+                 "(SELECT value FROM edge_props_int WHERE edge_id = e.id AND key_id = %d), 1.0)",
+                 weight_key, weight_key);
+    }
+
+    char count_sql[256];
+    char edge_sql[640];
+    snprintf(count_sql, sizeof(count_sql), "SELECT e.source_id, e.target_id FROM edges e%s", filter);
+    snprintf(edge_sql, sizeof(edge_sql),
+             "SELECT e.source_id, e.target_id, e.id, e.type, %s FROM edges e%s", weight_expr, filter);
+
+    csr_source src = {
+        has_labels ?
+            "SELECT DISTINCT node_id FROM node_labels "
+            "WHERE label IN (SELECT value FROM json_each(?1, '$.labels')) ORDER BY node_id" :
+            "SELECT id FROM nodes WHERE ?1 IS NOT NULL ORDER BY id",
+        count_sql, edge_sql, options_json ? options_json : "{}", false, true, weighted
+    };
+
+    csr_graph *graph = csr_graph_build(db, &src);
+    if (!graph) {
+        *error = strdup("Projection matches no nodes");
+    }
+    return graph;
+}
+
+graph_projection* graph_projection_find(graph_projection *list, const char *name)
+{
+    for (; list && name; list = list->next) {
+        if (strcmp(list->name, name) == 0) {
+            return list;
+        }
+    }
+    return NULL;
+}
+
+/* Add a projection under name, replacing one of the same name; takes graph */
+int graph_projection_put(graph_projection **list, const char *name, csr_graph *graph)
+{
+    graph_projection *existing = graph_projection_find(*list, name);
+    if (existing) {
+        csr_graph_free(existing->graph);
+        existing->graph = graph;
+        return 0;
+    }
+
+    graph_projection *p = calloc(1, sizeof(graph_projection));
+    if (!p || !(p->name = strdup(name))) {
+        free(p);
+        return -1;
+    }
+    p->graph = graph;
+    p->next = *list;
+    *list = p;
+    return 0;
+}
+
+bool graph_projection_drop(graph_projection **list, const char *name)
+{
+    for (graph_projection **link = list; *link; link = &(*link)->next) {
+        if (strcmp((*link)->name, name) == 0) {
+            graph_projection *p = *link;
+            *link = p->next;
+            csr_graph_free(p->graph);
+            free(p->name);
+            free(p);
+            return true;
+        }
+    }
+    return false;
+}
+
+void graph_projections_free(graph_projection *list)
+{
+    while (list) {
+        graph_projection *next = list->next;
+        csr_graph_free(list->graph);
+        free(list->name);
+        free(list);
+        list = next;
+    }
+}
@@ -0,0 +1,493 @@
+/*
+ * Graph Snapshot - Persisted CSR for warm starts
+ *
+ * gql_load_graph('{"snapshot": true}') writes the CSR arrays, the node
+ * and user id index hashes and an interned table of user ids to a sidecar
+ * file next to the database ("<db>-graph"). Later loads map that file
+ * read-only, so the arrays are neither rebuilt from SQL nor copied, and
+ * connections in the same process share one mapping.
+ *
+ * The file carries a random tag that is also stored in the graph_snapshot
+ * table. Triggers on nodes, edges and 'id' properties empty that table on
+ * the first write, which invalidates the file for every connection and
+ * process at once; a missing or mismatched tag means rebuild.
+ *
+ * The file uses native byte order and int sizes; it is a cache and is
+ * simply rebuilt when it does not match.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "executor/graph_algorithms.h"
+#include "executor/graph_algo_internal.h"
+
+#define SNAPSHOT_MAGIC "GQLCSR2\n"
+#define SNAPSHOT_SUFFIX "-graph"
+#define SNAPSHOT_NO_ID UINT32_MAX
+
+typedef struct {
+    char magic[8];
+    int64_t tag;
+    int32_t node_count;
+    int32_t edge_count;
+    int32_t node_idx_size;
+    int32_t user_idx_size;
+    int64_t strings_size;
+} snapshot_header;
+
+/* One mapped file, shared by every connection that loaded it */
+typedef struct csr_snapshot {
+    char *path;
+    int64_t tag;
+    void *base;
+    size_t size;
+    csr_graph graph;      /* Arrays point into base; only user_ids is allocated */
+    int refs;
+    struct csr_snapshot *next;
+} csr_snapshot;
+
+static csr_snapshot *snapshot_list = NULL;
+
+static const char *const SNAPSHOT_DDL =
+    "CREATE TABLE IF NOT EXISTS graph_snapshot (version INTEGER NOT NULL);"
+    "CREATE TRIGGER IF NOT EXISTS graph_snapshot_nodes_insert AFTER INSERT ON nodes "
+    "WHEN EXISTS (SELECT 1 FROM graph_snapshot) BEGIN DELETE FROM graph_snapshot; END;"
+    "CREATE TRIGGER IF NOT EXISTS graph_snapshot_nodes_delete AFTER DELETE ON nodes "
+    "WHEN EXISTS (SELECT 1 FROM graph_snapshot) BEGIN DELETE FROM graph_snapshot; END;"
+    "CREATE TRIGGER IF NOT EXISTS graph_snapshot_edges_insert AFTER INSERT ON edges "
+    "WHEN EXISTS (SELECT 1 FROM graph_snapshot) BEGIN DELETE FROM graph_snapshot; END;"
+    "CREATE TRIGGER IF NOT EXISTS graph_snapshot_edges_delete AFTER DELETE ON edges "
+    "WHEN EXISTS (SELECT 1 FROM graph_snapshot) BEGIN DELETE FROM graph_snapshot; END;"
+    "CREATE TRIGGER IF NOT EXISTS graph_snapshot_edges_update AFTER UPDATE OF source_id, target_id ON edges "
+    "WHEN EXISTS (SELECT 1 FROM graph_snapshot) BEGIN DELETE FROM graph_snapshot; END;"
+    "CREATE TRIGGER IF NOT EXISTS graph_snapshot_ids_insert AFTER INSERT ON node_props_text "
+    "WHEN EXISTS (SELECT 1 FROM graph_snapshot) "
+    "AND NEW.key_id = (SELECT id FROM property_keys WHERE key = 'id') "
+    "BEGIN DELETE FROM graph_snapshot; END;"
+    "CREATE TRIGGER IF NOT EXISTS graph_snapshot_ids_update AFTER UPDATE ON node_props_text "
+    "WHEN EXISTS (SELECT 1 FROM graph_snapshot) "
+    "AND NEW.key_id = (SELECT id FROM property_keys WHERE key = 'id') "
+    "BEGIN DELETE FROM graph_snapshot; END;"
+    "CREATE TRIGGER IF NOT EXISTS graph_snapshot_ids_delete AFTER DELETE ON node_props_text "
+    "WHEN EXISTS (SELECT 1 FROM graph_snapshot) "
+    "AND OLD.key_id = (SELECT id FROM property_keys WHERE key = 'id') "
+    "BEGIN DELETE FROM graph_snapshot; END";
+
+/* Sidecar path for the main database, NULL for in-memory and temp databases */
+static char* snapshot_path(sqlite3 *db)
+{
+    const char *db_path = sqlite3_db_filename(db, "main");
+    if (!db_path || !*db_path) return NULL;
+
+    size_t len = strlen(db_path);
+    char *path = malloc(len + sizeof(SNAPSHOT_SUFFIX));
+    if (!path) return NULL;
+    memcpy(path, db_path, len);
+    memcpy(path + len, SNAPSHOT_SUFFIX, sizeof(SNAPSHOT_SUFFIX));
+    return path;
+}
+
+/* Tag of the snapshot that matches the current data; 0 if there is none */
+static int64_t snapshot_current_tag(sqlite3 *db)
+{
+    sqlite3_stmt *stmt = NULL;
+    int64_t tag = 0;
+
+    if (sqlite3_prepare_v2(db, "SELECT version FROM graph_snapshot", -1, &stmt, NULL) != SQLITE_OK) {
+        return 0;
+    }
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        tag = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return tag;
+}
+
+/* Byte offsets of each section, in file order */
+typedef struct {
+    size_t row_ptr, col_idx, in_row_ptr, in_col_idx, node_ids, node_idx, user_idx, id_offsets, strings, end;
+} snapshot_layout;
+
+static snapshot_layout snapshot_layout_of(const snapshot_header *h)
+{
+    snapshot_layout l;
+    size_t n = (size_t)h->node_count;
+    size_t m = (size_t)h->edge_count;
+
+    l.row_ptr = sizeof(snapshot_header);
+    l.col_idx = l.row_ptr + (n + 1) * sizeof(int32_t);
+    l.in_row_ptr = l.col_idx + m * sizeof(int32_t);
+    l.in_col_idx = l.in_row_ptr + (n + 1) * sizeof(int32_t);
+    l.node_ids = l.in_col_idx + m * sizeof(int32_t);
+    l.node_idx = l.node_ids + n * sizeof(int32_t);
+    l.user_idx = l.node_idx + (size_t)h->node_idx_size * sizeof(int32_t);
+    l.id_offsets = l.user_idx + (size_t)h->user_idx_size * sizeof(int32_t);
+    l.strings = l.id_offsets + n * sizeof(uint32_t);
+    l.end = l.strings + (size_t)h->strings_size;
+    return l;
+}
+
+static void snapshot_unmap(void *base, size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    free(base);
+#else
+    munmap(base, size);
+#endif
+}
+
+/* Map the whole file read-only; without mmap it is read into memory */
+static void* snapshot_map(const char *path, size_t *size)
+{
+#ifdef _WIN32
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    void *base = NULL;
+    if (fseek(f, 0, SEEK_END) == 0) {
+        long len = ftell(f);
+        if (len > 0 && fseek(f, 0, SEEK_SET) == 0 && (base = malloc((size_t)len))) {
+            if (fread(base, 1, (size_t)len, f) != (size_t)len) {
+                free(base);
+                base = NULL;
+            }
+            *size = (size_t)len;
+        }
+    }
+    fclose(f);
+    return base;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    void *base = NULL;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(snapshot_header)) {
+        base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            base = NULL;
+        } else {
+            *size = (size_t)st.st_size;
+        }
+    }
+    close(fd);
+    return base;
+#endif
+}
+
+/* Point a graph at the mapped sections; NULL if the file is not a valid snapshot for tag */
+static csr_snapshot* snapshot_attach(const char *path, int64_t tag)
+{
+    size_t size = 0;
+    void *base = snapshot_map(path, &size);
+    if (!base) return NULL;
+
+    const snapshot_header *h = base;
+    if (size < sizeof(snapshot_header) || memcmp(h->magic, SNAPSHOT_MAGIC, 8) != 0 ||
+        h->tag != tag || h->node_count < 0 || h->edge_count < 0 ||
+        h->node_idx_size <= h->node_count || h->strings_size < 0 ||
+        h->user_idx_size < 0 || (h->user_idx_size & (h->user_idx_size - 1)) != 0 ||
+        snapshot_layout_of(h).end != size) {
+        CYPHER_DEBUG("Graph snapshot %s is stale or invalid", path);
+        snapshot_unmap(base, size);
+        return NULL;
+    }
+
+    snapshot_layout l = snapshot_layout_of(h);
+    csr_snapshot *snap = calloc(1, sizeof(csr_snapshot));
+    char **user_ids = calloc((size_t)h->node_count + 1, sizeof(char*));
+    char *path_copy = strdup(path);
+    if (!snap || !user_ids || !path_copy) {
+        free(snap);
+        free(user_ids);
+        free(path_copy);
+        snapshot_unmap(base, size);
+        return NULL;
+    }
+
+    const char *bytes = base;
+    const uint32_t *id_offsets = (const uint32_t *)(bytes + l.id_offsets);
+    for (int i = 0; i < h->node_count; i++) {
+        if (id_offsets[i] != SNAPSHOT_NO_ID && id_offsets[i] < (uint64_t)h->strings_size) {
+            user_ids[i] = (char *)(bytes + l.strings + id_offsets[i]);
+        }
+    }
+
+    /* The arrays are read-only; algorithms only ever read a cached graph */
+    csr_graph *g = &snap->graph;
+    g->node_count = h->node_count;
+    g->edge_count = h->edge_count;
+    g->row_ptr = (int *)(bytes + l.row_ptr);
+    g->col_idx = (int *)(bytes + l.col_idx);
+    g->in_row_ptr = (int *)(bytes + l.in_row_ptr);
+    g->in_col_idx = (int *)(bytes + l.in_col_idx);
+    g->node_ids = (int *)(bytes + l.node_ids);
+    g->node_idx = (int *)(bytes + l.node_idx);
+    g->node_idx_size = h->node_idx_size;
+    g->user_idx = h->user_idx_size ? (int *)(bytes + l.user_idx) : NULL;
+    g->user_idx_size = h->user_idx_size;
+    g->user_ids = user_ids;
+    g->snapshot = snap;
+
+    snap->path = path_copy;
+    snap->tag = tag;
+    snap->base = base;
+    snap->size = size;
+    return snap;
+}
+
+/* Shared graph for the current snapshot of this database, NULL if there is none */
+csr_graph* csr_graph_open_snapshot(sqlite3 *db)
+{
+    int64_t tag = snapshot_current_tag(db);
+    if (tag == 0) return NULL;
+
+    char *path = snapshot_path(db);
+    if (!path) return NULL;
+
+    sqlite3_mutex *mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_APP1);
+    sqlite3_mutex_enter(mutex);
+
+    csr_snapshot *snap = snapshot_list;
+    while (snap && (snap->tag != tag || strcmp(snap->path, path) != 0)) {
+        snap = snap->next;
+    }
+    if (snap) {
+        snap->refs++;
+    } else if ((snap = snapshot_attach(path, tag))) {
+        snap->refs = 1;
+        snap->next = snapshot_list;
+        snapshot_list = snap;
+        CYPHER_DEBUG("Mapped graph snapshot %s: %d nodes, %d edges",
+                     path, snap->graph.node_count, snap->graph.edge_count);
+    }
+
+    sqlite3_mutex_leave(mutex);
+    free(path);
+    return snap ? &snap->graph : NULL;
+}
+
+/* Drop one connection's reference, unmapping the file after the last */
+void csr_snapshot_release(struct csr_snapshot *snap)
+{
+    sqlite3_mutex *mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_APP1);
+    sqlite3_mutex_enter(mutex);
+
+    if (--snap->refs > 0) {
+        sqlite3_mutex_leave(mutex);
+        return;
+    }
+
+    csr_snapshot **link = &snapshot_list;
+    while (*link && *link != snap) {
+        link = &(*link)->next;
+    }
+    if (*link) {
+        *link = snap->next;
+    }
+    sqlite3_mutex_leave(mutex);
+
+    snapshot_unmap(snap->base, snap->size);
+    free(snap->graph.user_ids);
+    free(snap->path);
+    free(snap);
+}
+
+/*
+ * Intern user ids: each distinct string is stored once and nodes refer to
+ * it by offset. Fills offsets and returns the table, or NULL on failure.
+ */
+static char* intern_user_ids(const csr_graph *graph, uint32_t *offsets, int64_t *size)
+{
+    int n = graph->node_count;
+    int slots = 16;
+    while (slots < n * 2) slots *= 2;
+
+    uint32_t *table = malloc((size_t)slots * sizeof(uint32_t));
+    size_t capacity = 4096, used = 0;
+    char *strings = malloc(capacity);
+    if (!table || !strings) {
+        free(table);
+        free(strings);
+        return NULL;
+    }
+    memset(table, 0xff, (size_t)slots * sizeof(uint32_t));
+
+    for (int i = 0; i < n; i++) {
+        const char *id = graph->user_ids ? graph->user_ids[i] : NULL;
+        offsets[i] = SNAPSHOT_NO_ID;
+        if (!id) continue;
+
+        uint32_t slot = hash_string(id) & (uint32_t)(slots - 1);
+        while (table[slot] != SNAPSHOT_NO_ID && strcmp(strings + table[slot], id) != 0) {
+            slot = (slot + 1) & (uint32_t)(slots - 1);
+        }
+
+        if (table[slot] == SNAPSHOT_NO_ID) {
+            size_t len = strlen(id) + 1;
+            if (used + len >= SNAPSHOT_NO_ID) {
+                free(table);
+                free(strings);
+                return NULL;
+            }
+            if (used + len > capacity) {
+                while (used + len > capacity) capacity *= 2;
+                char *grown = realloc(strings, capacity);
+                if (!grown) {
+                    free(table);
+                    free(strings);
+                    return NULL;
+                }
+                strings = grown;
+            }
+            memcpy(strings + used, id, len);
+            table[slot] = (uint32_t)used;
+            used += len;
+        }
+        offsets[i] = table[slot];
+    }
+
+    free(table);
+    *size = (int64_t)used;
+    return strings;
+}
+
+static int write_section(FILE *f, const void *data, size_t size)
+{
+    return size == 0 || fwrite(data, 1, size, f) == size ? 0 : -1;
+}
+
+/* Write the file under a temporary name and move it into place */
+static int snapshot_write(const char *path, const csr_graph *graph, int64_t tag)
+{
+    size_t n = (size_t)graph->node_count;
+    size_t m = (size_t)graph->edge_count;
+
+    snapshot_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SNAPSHOT_MAGIC, 8);
+    h.tag = tag;
+    h.node_count = graph->node_count;
+    h.edge_count = graph->edge_count;
+    h.node_idx_size = graph->node_idx_size;
+    h.user_idx_size = graph->user_idx ? graph->user_idx_size : 0;
+
+    uint32_t *offsets = malloc((n + 1) * sizeof(uint32_t));
+    char *strings = offsets ? intern_user_ids(graph, offsets, &h.strings_size) : NULL;
+    if (!strings) {
+        free(offsets);
+        return -1;
+    }
+
+    size_t len = strlen(path);
+    char *tmp = malloc(len + 5);
+    FILE *f = NULL;
+    int rc = -1;
+    if (tmp) {
+        memcpy(tmp, path, len);
+        memcpy(tmp + len, ".tmp", 5);
+        f = fopen(tmp, "wb");
+    }
+
+    if (f &&
+        write_section(f, &h, sizeof(h)) == 0 &&
+        write_section(f, graph->row_ptr, (n + 1) * sizeof(int)) == 0 &&
+        write_section(f, graph->col_idx, m * sizeof(int)) == 0 &&
+        write_section(f, graph->in_row_ptr, (n + 1) * sizeof(int)) == 0 &&
+        write_section(f, graph->in_col_idx, m * sizeof(int)) == 0 &&
+        write_section(f, graph->node_ids, n * sizeof(int)) == 0 &&
+        write_section(f, graph->node_idx, (size_t)graph->node_idx_size * sizeof(int)) == 0 &&
+        write_section(f, graph->user_idx, (size_t)h.user_idx_size * sizeof(int)) == 0 &&
+        write_section(f, offsets, n * sizeof(uint32_t)) == 0 &&
+        write_section(f, strings, (size_t)h.strings_size) == 0) {
+        rc = 0;
+    }
+    if (f && fclose(f) != 0) {
+        rc = -1;
+    }
+
+#ifdef _WIN32
+    if (rc == 0) remove(path);
+#endif
+    if (rc == 0 && rename(tmp, path) != 0) {
+        rc = -1;
+    }
+    if (rc < 0 && f) {
+        remove(tmp);
+    }
+
+    free(tmp);
+    free(offsets);
+    free(strings);
+    return rc;
+}
+
+/* Record tag as the current snapshot, creating the invalidation triggers on first use */
+static int snapshot_tag(sqlite3 *db, int64_t tag)
+{
+    if (sqlite3_exec(db, SNAPSHOT_DDL, NULL, NULL, NULL) != SQLITE_OK) {
+        CYPHER_DEBUG("Failed to create graph_snapshot: %s", sqlite3_errmsg(db));
+        return -1;
+    }
+
+    char sql[96];
+    snprintf(sql, sizeof(sql),
+             "DELETE FROM graph_snapshot; INSERT INTO graph_snapshot (version) VALUES (%lld)",
+             (long long)tag);
+    return sqlite3_exec(db, sql, NULL, NULL, NULL) == SQLITE_OK ? 0 : -1;
+}
+
+/*
+ * Build the graph from SQL and persist it, then hand back the shared
+ * mapping of what was written. The build and the tag are one transaction,
+ * so a concurrent writer cannot slip in between. If the snapshot cannot
+ * be written (in-memory or read-only database) the built graph is
+ * returned as is and *saved is false.
+ */
+csr_graph* csr_graph_save_snapshot(sqlite3 *db, bool *saved)
+{
+    *saved = false;
+
+    char *path = snapshot_path(db);
+    if (!path) {
+        return csr_graph_load(db);
+    }
+
+    if (sqlite3_exec(db, "SAVEPOINT graphqlite_snapshot", NULL, NULL, NULL) != SQLITE_OK) {
+        free(path);
+        return csr_graph_load(db);
+    }
+
+    csr_graph *graph = csr_graph_load(db);
+    int64_t tag = 0;
+    while (tag == 0) {
+        sqlite3_randomness(sizeof(tag), &tag);
+    }
+
+    if (graph && snapshot_write(path, graph, tag) == 0 && snapshot_tag(db, tag) == 0 &&
+        sqlite3_exec(db, "RELEASE graphqlite_snapshot", NULL, NULL, NULL) == SQLITE_OK) {
+        *saved = true;
+    } else {
+        sqlite3_exec(db, "ROLLBACK TO graphqlite_snapshot; RELEASE graphqlite_snapshot", NULL, NULL, NULL);
+    }
+    free(path);
+
+    if (*saved) {
+        csr_graph *mapped = csr_graph_open_snapshot(db);
+        if (mapped) {
+            csr_graph_free(graph);
+            return mapped;
+        }
+    }
+    return graph;
+}
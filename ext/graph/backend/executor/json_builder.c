@@ -100,6 +100,23 @@ void jbuf_append(json_builder *jb, const char *str)
     jb->len += slen;
 }
 
+void jbuf_append_len(json_builder *jb, const char *str, size_t len)
+{
+    if (!jb || !str || !jbuf_ensure(jb, len)) return;
+
+    memcpy(jb->data + jb->len, str, len);
+    jb->len += len;
+    jb->data[jb->len] = '\0';
+}
+
+void jbuf_append_char(json_builder *jb, char c)
+{
+    if (!jb || !jbuf_ensure(jb, 1)) return;
+
+    jb->data[jb->len++] = c;
+    jb->data[jb->len] = '\0';
+}
+
 void jbuf_appendf(json_builder *jb, const char *fmt, ...)
 {
     if (!jb || !fmt) return;
@@ -0,0 +1,402 @@
+/*
+ * Cypher Plan Cache
+ * LRU cache of parsed queries and generated SQL keyed by normalized query text
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "executor/plan_cache.h"
+#include "executor/executor_internal.h"
+#include "parser/cypher_debug.h"
+
+/* Hash function - djb2 algorithm */
+static unsigned long hash_string(const char *str)
+{
+    unsigned long hash = 5381;
+    int c;
+    while ((c = *str++)) {
+        hash = ((hash << 5) + hash) + c;
+    }
+    return hash;
+}
+
+/*
+ * Normalize query text: trim, and collapse whitespace runs outside string
+ * literals and backquoted identifiers to a single space.
+ */
+static char *normalize_query(const char *query)
+{
+    size_t len = strlen(query);
+    char *out = malloc(len + 1);
+    if (!out) {
+        return NULL;
+    }
+
+    size_t n = 0;
+    char quote = 0;
+    bool pending_space = false;
+
+    for (const char *p = query; *p; p++) {
+        char c = *p;
+
+        if (quote) {
+            out[n++] = c;
+            if (c == '\\' && p[1] && quote != '`') {
+                out[n++] = *++p;
+            } else if (c == quote) {
+                quote = 0;
+            }
+            continue;
+        }
+
+        if (isspace((unsigned char)c)) {
+            pending_space = (n > 0);
+            continue;
+        }
+
+        if (pending_space) {
+            out[n++] = ' ';
+            pending_space = false;
+        }
+        if (c == '\'' || c == '"' || c == '`') {
+            quote = c;
+        }
+        out[n++] = c;
+    }
+    out[n] = '\0';
+    return out;
+}
+
+static void plan_free(cypher_plan *plan)
+{
+    if (!plan) {
+        return;
+    }
+    free(plan->key);
+    free(plan->sql);
+    sqlite3_finalize(plan->stmt);
+    if (plan->ctx) {
+        cypher_transform_free_context(plan->ctx);
+    }
+    if (plan->parse) {
+        cypher_parse_result_free(plan->parse);
+    }
+    free(plan);
+}
+
+static void lru_unlink(cypher_plan_cache *cache, cypher_plan *plan)
+{
+    if (plan->lru_prev) {
+        plan->lru_prev->lru_next = plan->lru_next;
+    } else {
+        cache->lru_head = plan->lru_next;
+    }
+    if (plan->lru_next) {
+        plan->lru_next->lru_prev = plan->lru_prev;
+    } else {
+        cache->lru_tail = plan->lru_prev;
+    }
+    plan->lru_prev = plan->lru_next = NULL;
+}
+
+static void lru_push_front(cypher_plan_cache *cache, cypher_plan *plan)
+{
+    plan->lru_prev = NULL;
+    plan->lru_next = cache->lru_head;
+    if (cache->lru_head) {
+        cache->lru_head->lru_prev = plan;
+    }
+    cache->lru_head = plan;
+    if (!cache->lru_tail) {
+        cache->lru_tail = plan;
+    }
+}
+
+/* Remove a plan from the hash table and LRU list; free it unless pinned */
+static void plan_remove(cypher_plan_cache *cache, cypher_plan *plan)
+{
+    cypher_plan **pp = &cache->slots[plan->hash % cache->slot_count];
+    while (*pp && *pp != plan) {
+        pp = &(*pp)->hash_next;
+    }
+    if (*pp) {
+        *pp = plan->hash_next;
+    }
+    plan->hash_next = NULL;
+    lru_unlink(cache, plan);
+    cache->count--;
+
+    if (plan->in_use > 0) {
+        plan->stale = true;
+    } else {
+        plan_free(plan);
+    }
+}
+
+cypher_plan_cache* plan_cache_create(sqlite3 *db, int capacity)
+{
+    if (capacity <= 0) {
+        return NULL;
+    }
+
+    cypher_plan_cache *cache = calloc(1, sizeof(cypher_plan_cache));
+    if (!cache) {
+        return NULL;
+    }
+
+    cache->db = db;
+    cache->capacity = capacity;
+    cache->slot_count = capacity * 2;
+    cache->slots = calloc(cache->slot_count, sizeof(cypher_plan*));
+    if (!cache->slots) {
+        free(cache);
+        return NULL;
+    }
+
+    CYPHER_DEBUG("Created plan cache with %d entries", capacity);
+
+    return cache;
+}
+
+void plan_cache_clear(cypher_plan_cache *cache)
+{
+    if (!cache) {
+        return;
+    }
+
+    while (cache->lru_head) {
+        plan_remove(cache, cache->lru_head);
+    }
+    cache->invalidations++;
+}
+
+void plan_cache_free(cypher_plan_cache *cache)
+{
+    if (!cache) {
+        return;
+    }
+
+    CYPHER_DEBUG("Plan cache: %ld hits, %ld misses, %ld evictions",
+                 cache->hits, cache->misses, cache->evictions);
+
+    plan_cache_clear(cache);
+    free(cache->slots);
+    free(cache);
+}
+
+/* Prepare and bind the plan's SQL; false when it must be generated again */
+static bool plan_prepare_stmt(cypher_plan *plan, sqlite3 *db, const char *params_json)
+{
+    if (!plan->sql || !plan->ctx || plan->stmt) {
+        return false;
+    }
+
+    /* Embedded property key ids / types no longer match the catalog */
+    if (plan->ctx->schema &&
+        plan->ctx->catalog_generation != cypher_schema_catalog_generation(plan->ctx->schema)) {
+        CYPHER_DEBUG("Property catalog changed, regenerating SQL");
+        return false;
+    }
+
+    sqlite3_stmt *stmt = NULL;
+    if (sqlite3_prepare_v2(db, plan->sql, -1, &stmt, NULL) != SQLITE_OK) {
+        /* Schema no longer matches - re-parse and re-transform */
+        CYPHER_DEBUG("Cached SQL failed to prepare: %s", sqlite3_errmsg(db));
+        sqlite3_finalize(stmt);
+        return false;
+    }
+
+    if (params_json && bind_params_from_json(stmt, params_json) < 0) {
+        sqlite3_finalize(stmt);
+        return false;
+    }
+
+    plan->stmt = stmt;
+    return true;
+}
+
+cypher_plan* plan_cache_lookup(cypher_plan_cache *cache, const char *query,
+                               const char *params_json)
+{
+    if (!cache || !query) {
+        return NULL;
+    }
+
+    char *key = normalize_query(query);
+    if (!key) {
+        return NULL;
+    }
+
+    unsigned long hash = hash_string(key);
+    cypher_plan *plan = cache->slots[hash % cache->slot_count];
+    while (plan && (plan->hash != hash || strcmp(plan->key, key) != 0)) {
+        plan = plan->hash_next;
+    }
+    free(key);
+
+    if (!plan || !plan_prepare_stmt(plan, cache->db, params_json)) {
+        cache->misses++;
+        return NULL;
+    }
+
+    cache->hits++;
+    plan->hits++;
+    plan->in_use++;
+    if (plan != cache->lru_head) {
+        lru_unlink(cache, plan);
+        lru_push_front(cache, plan);
+    }
+
+    CYPHER_DEBUG("Plan cache hit (%ld): %s", plan->hits, plan->key);
+
+    return plan;
+}
+
+cypher_plan* plan_cache_insert(cypher_plan_cache *cache, const char *query,
+                               cypher_parse_result *parse)
+{
+    if (!cache || !query || !parse || !parse->ast) {
+        return NULL;
+    }
+
+    cypher_plan *plan = calloc(1, sizeof(cypher_plan));
+    if (!plan) {
+        return NULL;
+    }
+
+    plan->key = normalize_query(query);
+    if (!plan->key) {
+        free(plan);
+        return NULL;
+    }
+    plan->hash = hash_string(plan->key);
+
+    /* Record the dispatch decision for plain queries */
+    ast_node *ast = parse->ast;
+    if (ast->type == AST_NODE_QUERY || ast->type == AST_NODE_SINGLE_QUERY) {
+        cypher_query *q = (cypher_query*)ast;
+        plan->clauses = q->clauses;
+        plan->flags = analyze_query_clauses(q);
+        plan->pattern = find_matching_pattern(plan->flags);
+    }
+
+    /* Handlers that transform on every run would transform the cached AST twice */
+    if (!query_pattern_reuses_sql(plan->pattern, plan->flags)) {
+        free(plan->key);
+        free(plan);
+        return NULL;
+    }
+    plan->parse = parse;
+
+    /* Replace an entry whose SQL could not be reused */
+    cypher_plan *old = cache->slots[plan->hash % cache->slot_count];
+    while (old && (old->hash != plan->hash || strcmp(old->key, plan->key) != 0)) {
+        old = old->hash_next;
+    }
+    if (old) {
+        plan_remove(cache, old);
+    }
+
+    /* Evict least recently used entries that are not running */
+    cypher_plan *victim = cache->lru_tail;
+    while (cache->count >= cache->capacity && victim) {
+        cypher_plan *prev = victim->lru_prev;
+        if (victim->in_use == 0) {
+            CYPHER_DEBUG("Plan cache evict: %s", victim->key);
+            plan_remove(cache, victim);
+            cache->evictions++;
+        }
+        victim = prev;
+    }
+
+    int slot = plan->hash % cache->slot_count;
+    plan->hash_next = cache->slots[slot];
+    cache->slots[slot] = plan;
+    lru_push_front(cache, plan);
+    cache->count++;
+
+    plan->in_use = 1;
+    return plan;
+}
+
+void plan_cache_release(cypher_plan_cache *cache, cypher_plan *plan)
+{
+    (void)cache;
+
+    if (!plan) {
+        return;
+    }
+
+    /* Not taken when the run failed before reaching its handler */
+    if (plan->stmt) {
+        sqlite3_finalize(plan->stmt);
+        plan->stmt = NULL;
+    }
+
+    plan->in_use--;
+    if (plan->in_use == 0 && plan->stale) {
+        plan_free(plan);
+    }
+}
+
+cypher_plan* plan_for_query(cypher_executor *executor, cypher_query *query)
+{
+    cypher_plan *plan = executor ? executor->active_plan : NULL;
+
+    /* Only the exact top-level query, with its original clause list */
+    if (!plan || !query || plan->parse->ast != (ast_node*)query ||
+        plan->clauses != query->clauses) {
+        return NULL;
+    }
+    return plan;
+}
+
+sqlite3_stmt* plan_take_stmt(cypher_plan *plan)
+{
+    if (!plan) {
+        return NULL;
+    }
+
+    sqlite3_stmt *stmt = plan->stmt;
+    plan->stmt = NULL;
+    return stmt;
+}
+
+bool plan_store_sql(cypher_plan *plan, const char *sql, cypher_transform_context *ctx)
+{
+    if (!plan || !sql || !ctx || plan->sql || plan->ctx) {
+        return false;
+    }
+
+    plan->sql = strdup(sql);
+    if (!plan->sql) {
+        return false;
+    }
+    plan->ctx = ctx;
+    return true;
+}
+
+void plan_use_catalog(cypher_transform_context *ctx, cypher_schema_manager *schema)
+{
+    if (!ctx || !schema || !schema->catalog_available) {
+        return;
+    }
+    ctx->schema = schema;
+    ctx->catalog_generation = cypher_schema_catalog_generation(schema);
+}
+
+void plan_cache_stats(cypher_plan_cache *cache, long *hits, long *misses,
+                      long *evictions, long *invalidations)
+{
+    if (!cache) {
+        return;
+    }
+
+    if (hits) *hits = cache->hits;
+    if (misses) *misses = cache->misses;
+    if (evictions) *evictions = cache->evictions;
+    if (invalidations) *invalidations = cache->invalidations;
+}
@@ -8,6 +8,7 @@
 #include <string.h>
 
 #include "executor/query_patterns.h"
+#include "executor/plan_cache.h"
 #include "executor/executor_internal.h"
 #include "executor/graph_algorithms.h"
 #include "parser/cypher_debug.h"
@@ -492,6 +493,20 @@ const query_pattern *find_matching_pattern(clause_flags present)
     return best;
 }
 
+/*
+ * Handlers that take plan_take_stmt() and store their SQL in the plan.
+ */
+bool query_pattern_reuses_sql(const query_pattern *pattern, clause_flags flags)
+{
+    if (!pattern || (flags & (CLAUSE_CREATE | CLAUSE_MERGE | CLAUSE_SET | CLAUSE_DELETE |
+                              CLAUSE_REMOVE | CLAUSE_FOREACH | CLAUSE_CALL |
+                              CLAUSE_LOAD_CSV | CLAUSE_EXPLAIN))) {
+        return false;
+    }
+    return pattern->handler == handle_match_return ||
+           pattern->handler == handle_generic_transform;
+}
+
 /*
  * Get the pattern registry (for testing/debugging).
  */
@@ -550,13 +565,23 @@ const char *clause_flags_to_string(clause_flags flags)
 int dispatch_query_pattern(cypher_executor *executor, cypher_query *query,
                            cypher_result *result)
 {
-    /* Analyze query clauses */
-    clause_flags flags = analyze_query_clauses(query);
+    clause_flags flags;
+    const query_pattern *pattern;
+
+    /* Reuse the dispatch decision recorded by the plan cache */
+    cypher_plan *plan = plan_for_query(executor, query);
+    if (plan && plan->pattern) {
+        flags = plan->flags;
+        pattern = plan->pattern;
+    } else {
+        /* Analyze query clauses */
+        flags = analyze_query_clauses(query);
 
-    CYPHER_DEBUG("Query clauses: %s", clause_flags_to_string(flags));
+        /* Find matching pattern */
+        pattern = find_matching_pattern(flags);
+    }
 
-    /* Find matching pattern */
-    const query_pattern *pattern = find_matching_pattern(flags);
+    CYPHER_DEBUG("Query clauses: %s", clause_flags_to_string(flags));
 
     if (!pattern) {
         set_result_error(result, "No matching execution pattern for query");
@@ -576,79 +601,95 @@ int dispatch_query_pattern(cypher_executor *executor, cypher_query *query,
 static int handle_generic_transform(cypher_executor *executor, cypher_query *query,
                                     cypher_result *result, clause_flags flags)
 {
-    (void)flags;  /* Unused in generic handler */
+    cypher_transform_context *ctx = NULL;
+    cypher_query_result *transform_result = NULL;
+    sqlite3_stmt *stmt = NULL;
+
+    /* Reuse SQL generated by an earlier execution of the same query */
+    cypher_plan *plan = plan_for_query(executor, query);
+    sqlite3_stmt *cached_stmt = plan_take_stmt(plan);
+
+    if (cached_stmt) {
+        CYPHER_DEBUG("Using cached SQL from plan cache");
+        stmt = cached_stmt;
+        ctx = plan->ctx;
+    } else {
+        CYPHER_DEBUG("Using generic transform pipeline");
 
-    CYPHER_DEBUG("Using generic transform pipeline");
+        ctx = cypher_transform_create_context(executor->db);
+        if (!ctx) {
+            set_result_error(result, "Failed to create transform context");
+            return -1;
+        }
 
-    cypher_transform_context *ctx = cypher_transform_create_context(executor->db);
-    if (!ctx) {
-        set_result_error(result, "Failed to create transform context");
-        return -1;
-    }
+        /* Write clauses change property types while the SQL runs */
+        if (!(flags & (CLAUSE_CREATE | CLAUSE_MERGE | CLAUSE_SET | CLAUSE_DELETE |
+                       CLAUSE_REMOVE | CLAUSE_FOREACH | CLAUSE_CALL))) {
+            plan_use_catalog(ctx, executor->schema_mgr);
+        }
 
-    cypher_query_result *transform_result = cypher_transform_query(ctx, query);
-    if (!transform_result) {
-        set_result_error(result, "Failed to transform query");
-        cypher_transform_free_context(ctx);
-        return -1;
-    }
+        transform_result = cypher_transform_query(ctx, query);
+        if (!transform_result) {
+            set_result_error(result, "Failed to transform query");
+            cypher_transform_free_context(ctx);
+            return -1;
+        }
 
-    if (transform_result->has_error) {
-        set_result_error(result, transform_result->error_message ?
-                        transform_result->error_message : "Transform error");
-        cypher_free_result(transform_result);
-        cypher_transform_free_context(ctx);
-        return -1;
-    }
+        if (transform_result->has_error) {
+            set_result_error(result, transform_result->error_message ?
+                            transform_result->error_message : "Transform error");
+            cypher_free_result(transform_result);
+            cypher_transform_free_context(ctx);
+            return -1;
+        }
+
+        stmt = transform_result->stmt;
 
-    /* Build results from statement */
-    if (transform_result->stmt) {
         /* Bind parameters if provided */
-        if (executor->params_json) {
-            if (bind_params_from_json(transform_result->stmt, executor->params_json) < 0) {
+        if (stmt && executor->params_json) {
+            if (bind_params_from_json(stmt, executor->params_json) < 0) {
                 set_result_error(result, "Failed to bind query parameters");
                 cypher_free_result(transform_result);
                 cypher_transform_free_context(ctx);
                 return -1;
             }
         }
+    }
 
+    int rc = 0;
+
+    /* Build results from statement */
+    if (stmt) {
         cypher_return *ret = find_return_clause(query);
 
         if (ret) {
             /* Use build_query_results if we have a return clause */
-            int rc = build_query_results(executor, transform_result->stmt,
-                                         ret, result, ctx);
-            if (rc < 0) {
-                cypher_free_result(transform_result);
-                cypher_transform_free_context(ctx);
-                return -1;
-            }
+            rc = build_query_results(executor, stmt, ret, result, ctx);
         } else {
             /* No return clause - manually collect results from SQL columns */
             result->data = NULL;
             result->row_count = 0;
-            result->column_count = sqlite3_column_count(transform_result->stmt);
+            result->column_count = sqlite3_column_count(stmt);
 
             /* Get column names from the SQL result */
             if (result->column_count > 0) {
                 result->column_names = malloc(result->column_count * sizeof(char*));
                 if (result->column_names) {
                     for (int c = 0; c < result->column_count; c++) {
-                        const char *name = sqlite3_column_name(transform_result->stmt, c);
+                        const char *name = sqlite3_column_name(stmt, c);
                         result->column_names[c] = name ? strdup(name) : NULL;
                     }
                 }
             }
 
             /* Collect results */
-            while (sqlite3_step(transform_result->stmt) == SQLITE_ROW) {
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
                 /* Allocate/resize data array */
                 result->data = realloc(result->data, (result->row_count + 1) * sizeof(char**));
                 result->data[result->row_count] = calloc(result->column_count, sizeof(char*));
 
                 for (int c = 0; c < result->column_count; c++) {
-                    const char *val = (const char*)sqlite3_column_text(transform_result->stmt, c);
+                    const char *val = (const char*)sqlite3_column_text(stmt, c);
                     result->data[result->row_count][c] = val ? strdup(val) : NULL;
                 }
                 result->row_count++;
@@ -656,9 +697,26 @@ static int handle_generic_transform(cypher_executor *executor, cypher_query *que
         }
     }
 
+    if (cached_stmt) {
+        release_result_statement(executor, cached_stmt);
+    } else {
+        /* Hand the generated SQL and variable context to the plan cache */
+        if (rc == 0 && stmt && plan_store_sql(plan, sqlite3_sql(stmt), ctx)) {
+            ctx = NULL;
+        }
+        if (executor->stream && executor->stream->stmt == stmt) {
+            transform_result->stmt = NULL;
+        }
+        cypher_free_result(transform_result);
+        if (ctx) {
+            cypher_transform_free_context(ctx);
+        }
+    }
+
+    if (rc < 0) {
+        return -1;
+    }
     result->success = true;
-    cypher_free_result(transform_result);
-    cypher_transform_free_context(ctx);
     return 0;
 }
 
@@ -897,7 +955,8 @@ static int handle_match_return(cypher_executor *executor, cypher_query *query,
     cypher_return *ret = find_return_clause(query);
 
     CYPHER_DEBUG("Executing MATCH+RETURN via pattern dispatch");
-    int rc = execute_match_return_query(executor, match, ret, result);
+    int rc = execute_match_return_query_plan(executor, match, ret, result,
+                                             plan_for_query(executor, query));
     if (rc >= 0) {
         result->success = true;
     }
@@ -1074,7 +1133,7 @@ static int merge_with_execute_return(cypher_executor *executor,
     }
 
     result->success = true;
-    sqlite3_finalize(stmt);
+    release_result_statement(executor, stmt);
     cypher_transform_free_context(ctx);
     return 0;
 }
@@ -1510,6 +1569,11 @@ static int handle_unwind_create(cypher_executor *executor, cypher_query *query,
 
     CYPHER_DEBUG("Executing UNWIND+CREATE via pattern dispatch");
 
+    /* Plain node imports go through the batched path */
+    if (bulk_unwind_supported(query, unwind, (ast_node*)create)) {
+        return execute_unwind_bulk(executor, unwind, (ast_node*)create, result);
+    }
+
     /* Find optional SET clause */
     cypher_set *set = find_set_clause(query);
 
@@ -1681,6 +1745,10 @@ static int handle_unwind_merge(cypher_executor *executor, cypher_query *query,
 
     CYPHER_DEBUG("Executing UNWIND+MERGE via pattern dispatch");
 
+    if (bulk_unwind_supported(query, unwind, (ast_node*)merge)) {
+        return execute_unwind_bulk(executor, unwind, (ast_node*)merge, result);
+    }
+
     /* Handle parameterized UNWIND */
     if (unwind->expr->type == AST_NODE_PARAMETER) {
         cypher_parameter *param = (cypher_parameter*)unwind->expr;
@@ -1787,22 +1855,47 @@ static int handle_return_only(cypher_executor *executor, cypher_query *query,
     if (algo_params.type != GRAPH_ALGO_NONE) {
         graph_algo_result *algo_result = NULL;
 
+        /* Fold pending writes into an incremental cache; an empty or
+         * unusable cache makes the algorithm load from SQL instead */
+        csr_graph *cached = executor->cached_graph;
+        if (cached && (csr_graph_sync(executor->db, cached) < 0 || cached->node_count == 0)) {
+            cached = NULL;
+        }
+
+        /* A {graph: 'name'} argument runs on a projection from gql_project() */
+        if (algo_params.graph_name) {
+            graph_projection *projection = graph_projection_find(executor->projections,
+                                                                 algo_params.graph_name);
+            if (!projection) {
+                char error[256];
+                snprintf(error, sizeof(error), "Unknown graph projection '%s'", algo_params.graph_name);
+                set_result_error(result, error);
+                free(algo_params.graph_name);
+                free(algo_params.source_id);
+                free(algo_params.target_id);
+                free(algo_params.weight_prop);
+                return -1;
+            }
+            cached = projection->graph;
+            free(algo_params.graph_name);
+        }
+
         switch (algo_params.type) {
             case GRAPH_ALGO_PAGERANK:
                 CYPHER_DEBUG("Executing C-based PageRank");
-                algo_result = execute_pagerank(executor->db, executor->cached_graph,
+                algo_result = execute_pagerank(executor->db, cached, executor->pool,
                                                algo_params.damping,
                                                algo_params.iterations,
                                                algo_params.top_k);
                 break;
             case GRAPH_ALGO_LABEL_PROPAGATION:
                 CYPHER_DEBUG("Executing C-based Label Propagation");
-                algo_result = execute_label_propagation(executor->db, executor->cached_graph,
+                algo_result = execute_label_propagation(executor->db, cached, executor->pool,
                                                         algo_params.iterations);
                 break;
             case GRAPH_ALGO_DIJKSTRA:
                 CYPHER_DEBUG("Executing C-based Dijkstra");
-                algo_result = execute_dijkstra(executor->db, executor->cached_graph,
+                algo_result = execute_dijkstra(executor->db, cached,
                                                algo_params.source_id,
                                                algo_params.target_id,
                                                algo_params.weight_prop);
@@ -1812,51 +1905,53 @@ static int handle_return_only(cypher_executor *executor, cypher_query *query,
                 break;
             case GRAPH_ALGO_DEGREE_CENTRALITY:
                 CYPHER_DEBUG("Executing C-based Degree Centrality");
-                algo_result = execute_degree_centrality(executor->db, executor->cached_graph);
+                algo_result = execute_degree_centrality(executor->db, cached);
                 break;
             case GRAPH_ALGO_WCC:
                 CYPHER_DEBUG("Executing C-based Weakly Connected Components");
-                algo_result = execute_wcc(executor->db, executor->cached_graph);
+                algo_result = execute_wcc(executor->db, cached, executor->pool);
                 break;
             case GRAPH_ALGO_SCC:
                 CYPHER_DEBUG("Executing C-based Strongly Connected Components");
-                algo_result = execute_scc(executor->db, executor->cached_graph);
+                algo_result = execute_scc(executor->db, cached);
                 break;
             case GRAPH_ALGO_BETWEENNESS_CENTRALITY:
                 CYPHER_DEBUG("Executing C-based Betweenness Centrality");
-                algo_result = execute_betweenness_centrality(executor->db, executor->cached_graph);
+                algo_result = execute_betweenness_centrality(executor->db, cached, executor->pool,
+                                                             algo_params.samples, algo_params.seed);
                 break;
             case GRAPH_ALGO_CLOSENESS_CENTRALITY:
                 CYPHER_DEBUG("Executing C-based Closeness Centrality");
-                algo_result = execute_closeness_centrality(executor->db, executor->cached_graph);
+                algo_result = execute_closeness_centrality(executor->db, cached, executor->pool,
+                                                           algo_params.samples, algo_params.seed);
                 break;
             case GRAPH_ALGO_LOUVAIN:
                 CYPHER_DEBUG("Executing C-based Louvain Community Detection");
-                algo_result = execute_louvain(executor->db, executor->cached_graph, algo_params.resolution);
+                algo_result = execute_louvain(executor->db, cached, algo_params.resolution);
                 break;
             case GRAPH_ALGO_TRIANGLE_COUNT:
                 CYPHER_DEBUG("Executing C-based Triangle Count");
-                algo_result = execute_triangle_count(executor->db, executor->cached_graph);
+                algo_result = execute_triangle_count(executor->db, cached);
                 break;
             case GRAPH_ALGO_ASTAR:
                 CYPHER_DEBUG("Executing C-based A* Shortest Path");
-                algo_result = execute_astar(executor->db, executor->cached_graph, algo_params.source_id,
+                algo_result = execute_astar(executor->db, cached, algo_params.source_id,
                                             algo_params.target_id, algo_params.weight_prop,
                                             algo_params.lat_prop, algo_params.lon_prop);
                 break;
             case GRAPH_ALGO_BFS:
                 CYPHER_DEBUG("Executing C-based BFS Traversal");
-                algo_result = execute_bfs(executor->db, executor->cached_graph, algo_params.source_id,
+                algo_result = execute_bfs(executor->db, cached, algo_params.source_id,
                                           algo_params.max_depth);
                 break;
             case GRAPH_ALGO_DFS:
                 CYPHER_DEBUG("Executing C-based DFS Traversal");
-                algo_result = execute_dfs(executor->db, executor->cached_graph, algo_params.source_id,
+                algo_result = execute_dfs(executor->db, cached, algo_params.source_id,
                                           algo_params.max_depth);
                 break;
             case GRAPH_ALGO_NODE_SIMILARITY:
                 CYPHER_DEBUG("Executing C-based Node Similarity (Jaccard)");
-                algo_result = execute_node_similarity(executor->db, executor->cached_graph,
+                algo_result = execute_node_similarity(executor->db, cached,
                                                       algo_params.source_id,
                                                       algo_params.target_id,
                                                       algo_params.threshold,
@@ -1864,18 +1959,18 @@ static int handle_return_only(cypher_executor *executor, cypher_query *query,
                 break;
             case GRAPH_ALGO_KNN:
                 CYPHER_DEBUG("Executing C-based K-Nearest Neighbors");
-                algo_result = execute_knn(executor->db, executor->cached_graph,
+                algo_result = execute_knn(executor->db, cached,
                                           algo_params.source_id,
                                           algo_params.k);
                 break;
             case GRAPH_ALGO_EIGENVECTOR_CENTRALITY:
                 CYPHER_DEBUG("Executing C-based Eigenvector Centrality");
-                algo_result = execute_eigenvector_centrality(executor->db, executor->cached_graph,
+                algo_result = execute_eigenvector_centrality(executor->db, cached, executor->pool,
                                                               algo_params.iterations);
                 break;
             case GRAPH_ALGO_APSP:
                 CYPHER_DEBUG("Executing C-based All Pairs Shortest Path");
-                algo_result = execute_apsp(executor->db, executor->cached_graph);
+                algo_result = execute_apsp(executor->db, cached);
                 break;
             default:
                 break;
@@ -0,0 +1,574 @@
+/*
+ * varlen_paths.c
+ *
+ * Native variable-length path traversal (gql_varlen_paths table-valued function)
+ *
+ * Replaces the recursive CTE previously generated for [*min..max] patterns.
+ * The CTE seeded itself from every edge in the graph, carried paths as TEXT
+ * and rejected cycles with a LIKE scan of the visited string at every step.
+ * Here each start node is walked with an iterative DFS: neighbor lists come
+ * from the edge indexes one node at a time, cycles are rejected by
+ * checking the (at most max_hops + 1) nodes on the current path, and rows
+ * are produced lazily from xNext so LIMIT and joins stop the walk early.
+ *
+ * Complexity: O(number of paths reported * average degree)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "executor/varlen_paths.h"
+#include "parser/cypher_debug.h"
+
+/* Column numbers - must match the CREATE TABLE in varlen_connect */
+#define VARLEN_COL_START_ID   0
+#define VARLEN_COL_END_ID     1
+#define VARLEN_COL_DEPTH      2
+#define VARLEN_COL_PATH_IDS   3
+#define VARLEN_COL_TYPES      4
+#define VARLEN_COL_DIRECTION  5
+#define VARLEN_COL_MIN_HOPS   6
+#define VARLEN_COL_MAX_HOPS   7
+
+/* idxNum bits for the constraints consumed by xBestIndex (argv in this order) */
+#define VARLEN_HAS_START      0x01
+#define VARLEN_HAS_TYPES      0x02
+#define VARLEN_HAS_DIRECTION  0x04
+#define VARLEN_HAS_MIN        0x08
+#define VARLEN_HAS_MAX        0x10
+
+typedef struct {
+    sqlite3_vtab base;
+    sqlite3 *db;
+} varlen_vtab;
+
+/* One level of the DFS stack */
+typedef struct {
+    sqlite3_int64 node;
+    sqlite3_int64 *nbrs;    /* Neighbor ids, loaded when the node is pushed */
+    int count;
+    int capacity;
+    int pos;                /* Next neighbor to try */
+} varlen_frame;
+
+typedef struct {
+    sqlite3_vtab_cursor base;
+    sqlite3 *db;
+
+    /* Arguments from xFilter */
+    int direction;
+    int min_hops;
+    int max_hops;
+    char *types;            /* JSON array or NULL */
+
+    /* Neighbor lookup, re-prepared only when direction or typing changes */
+    sqlite3_stmt *nbr_stmt;
+    int nbr_direction;
+    bool nbr_typed;
+
+    /* Start node scan when start_id is not constrained */
+    sqlite3_stmt *start_stmt;
+
+    /* DFS state - frames[0..depth] is the current path */
+    varlen_frame *frames;
+    int frame_count;
+    int depth;
+
+    sqlite3_int64 rowid;
+    bool eof;
+} varlen_cursor;
+
+/* Is id already on the current path (frames[0..depth])? */
+static bool on_path_test(varlen_cursor *cur, sqlite3_int64 id)
+{
+    for (int i = 0; i <= cur->depth; i++) {
+        if (cur->frames[i].node == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Prepare the neighbor query for the current direction and type filter */
+static int prepare_neighbor_stmt(varlen_cursor *cur)
+{
+    bool typed = cur->types != NULL;
+
+    if (cur->nbr_stmt && cur->nbr_direction == cur->direction && cur->nbr_typed == typed) {
+        return SQLITE_OK;
+    }
+    sqlite3_finalize(cur->nbr_stmt);
+    cur->nbr_stmt = NULL;
+
+    const char *type_filter = typed ? " AND type IN (SELECT value FROM json_each(?2))" : "";
+    char *sql;
+    if (cur->direction > 0) {
+        sql = sqlite3_mprintf("SELECT target_id FROM edges WHERE source_id = ?1%s", type_filter);
+    } else if (cur->direction < 0) {
+        sql = sqlite3_mprintf("SELECT source_id FROM edges WHERE target_id = ?1%s", type_filter);
+    } else {
+        sql = sqlite3_mprintf("SELECT target_id FROM edges WHERE source_id = ?1%s "
+                              "UNION ALL "
+                              "SELECT source_id FROM edges WHERE target_id = ?1%s",
+                              type_filter, type_filter);
+    }
+    if (!sql) {
+        return SQLITE_NOMEM;
+    }
+
+    int rc = sqlite3_prepare_v2(cur->db, sql, -1, &cur->nbr_stmt, NULL);
+    sqlite3_free(sql);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    cur->nbr_direction = cur->direction;
+    cur->nbr_typed = typed;
+    return SQLITE_OK;
+}
+
+/* Load the neighbors of frame->node */
+static int load_neighbors(varlen_cursor *cur, varlen_frame *frame)
+{
+    frame->count = 0;
+    frame->pos = 0;
+
+    sqlite3_stmt *stmt = cur->nbr_stmt;
+    sqlite3_reset(stmt);
+    sqlite3_bind_int64(stmt, 1, frame->node);
+    if (cur->types) {
+        sqlite3_bind_text(stmt, 2, cur->types, -1, SQLITE_STATIC);
+    }
+
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (frame->count == frame->capacity) {
+            int capacity = frame->capacity ? frame->capacity * 2 : 8;
+            sqlite3_int64 *grown = realloc(frame->nbrs, capacity * sizeof(sqlite3_int64));
+            if (!grown) {
+                sqlite3_reset(stmt);
+                return SQLITE_NOMEM;
+            }
+            frame->nbrs = grown;
+            frame->capacity = capacity;
+        }
+        frame->nbrs[frame->count++] = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_reset(stmt);
+    return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+/* Push a node onto the current path */
+static int push_node(varlen_cursor *cur, sqlite3_int64 node)
+{
+    varlen_frame *frame = &cur->frames[cur->depth];
+    frame->node = node;
+    frame->count = 0;
+    frame->pos = 0;
+
+    /* Nodes at max depth are never expanded */
+    if (cur->depth < cur->max_hops) {
+        return load_neighbors(cur, frame);
+    }
+    return SQLITE_OK;
+}
+
+/* Begin a walk from a new start node; *row_ready if the start itself is reported (min_hops 0) */
+static int begin_start(varlen_cursor *cur, sqlite3_int64 start, bool *row_ready)
+{
+    cur->depth = 0;
+    int rc = push_node(cur, start);
+    *row_ready = (cur->min_hops == 0);
+    return rc;
+}
+
+/* Fetch the next start node when scanning all nodes */
+static int next_start(varlen_cursor *cur, bool *found, bool *row_ready)
+{
+    *found = false;
+    *row_ready = false;
+    if (!cur->start_stmt) {
+        return SQLITE_OK;
+    }
+
+    int rc = sqlite3_step(cur->start_stmt);
+    if (rc == SQLITE_DONE) {
+        return SQLITE_OK;
+    }
+    if (rc != SQLITE_ROW) {
+        return rc;
+    }
+    *found = true;
+    return begin_start(cur, sqlite3_column_int64(cur->start_stmt, 0), row_ready);
+}
+
+/* Advance the DFS to the next reportable path */
+static int advance(varlen_cursor *cur)
+{
+    for (;;) {
+        varlen_frame *top = &cur->frames[cur->depth];
+
+        if (cur->depth < cur->max_hops && top->pos < top->count) {
+            sqlite3_int64 next = top->nbrs[top->pos++];
+            if (on_path_test(cur, next)) {
+                continue;  /* Would revisit a node - not a simple path */
+            }
+
+            cur->depth++;
+            int rc = push_node(cur, next);
+            if (rc != SQLITE_OK) {
+                return rc;
+            }
+            if (cur->depth >= cur->min_hops) {
+                cur->rowid++;
+                return SQLITE_OK;
+            }
+            continue;
+        }
+
+        /* Node exhausted - backtrack */
+        if (cur->depth > 0) {
+            cur->depth--;
+            continue;
+        }
+
+        /* Start node exhausted - move to the next one, if scanning */
+        bool found, row_ready;
+        int rc = next_start(cur, &found, &row_ready);
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+        if (!found) {
+            cur->eof = true;
+            return SQLITE_OK;
+        }
+        if (row_ready) {
+            cur->rowid++;
+            return SQLITE_OK;
+        }
+    }
+}
+
+/* Virtual table methods */
+
+static int varlen_connect(sqlite3 *db, void *aux, int argc, const char *const *argv,
+                          sqlite3_vtab **ppVtab, char **pzErr)
+{
+    (void)aux;
+    (void)argc;
+    (void)argv;
+    (void)pzErr;
+
+    int rc = sqlite3_declare_vtab(db,
+        "CREATE TABLE x(start_id INTEGER, end_id INTEGER, depth INTEGER, path_ids TEXT, "
+        "types HIDDEN, direction HIDDEN, min_hops HIDDEN, max_hops HIDDEN)");
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    varlen_vtab *vtab = sqlite3_malloc(sizeof(varlen_vtab));
+    if (!vtab) {
+        return SQLITE_NOMEM;
+    }
+    memset(vtab, 0, sizeof(*vtab));
+    vtab->db = db;
+    *ppVtab = &vtab->base;
+    return SQLITE_OK;
+}
+
+static int varlen_disconnect(sqlite3_vtab *vtab)
+{
+    sqlite3_free(vtab);
+    return SQLITE_OK;
+}
+
+static int varlen_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+    (void)vtab;
+
+    /* Constraint index per consumed column, in argv order */
+    static const int columns[] = {
+        VARLEN_COL_START_ID, VARLEN_COL_TYPES, VARLEN_COL_DIRECTION,
+        VARLEN_COL_MIN_HOPS, VARLEN_COL_MAX_HOPS
+    };
+    int which[5] = { -1, -1, -1, -1, -1 };
+
+    for (int i = 0; i < info->nConstraint; i++) {
+        const struct sqlite3_index_constraint *c = &info->aConstraint[i];
+        for (int k = 0; k < 5; k++) {
+            if (c->iColumn != columns[k] || c->op != SQLITE_INDEX_CONSTRAINT_EQ) {
+                continue;
+            }
+            if (!c->usable) {
+                /* Arguments must be available, start_id is optional */
+                if (k > 0) {
+                    return SQLITE_CONSTRAINT;
+                }
+                continue;
+            }
+            which[k] = i;
+        }
+    }
+
+    int idx_num = 0;
+    int argv_index = 1;
+    for (int k = 0; k < 5; k++) {
+        if (which[k] >= 0) {
+            idx_num |= (1 << k);
+            info->aConstraintUsage[which[k]].argvIndex = argv_index++;
+            info->aConstraintUsage[which[k]].omit = 1;
+        }
+    }
+    info->idxNum = idx_num;
+
+    /* A bound start node is far cheaper than walking from every node */
+    if (idx_num & VARLEN_HAS_START) {
+        info->estimatedCost = 100.0;
+        info->estimatedRows = 100;
+    } else {
+        info->estimatedCost = 1000000.0;
+        info->estimatedRows = 1000000;
+    }
+    return SQLITE_OK;
+}
+
+static int varlen_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **ppCursor)
+{
+    (void)vtab;
+
+    varlen_cursor *cur = sqlite3_malloc(sizeof(varlen_cursor));
+    if (!cur) {
+        return SQLITE_NOMEM;
+    }
+    memset(cur, 0, sizeof(*cur));
+    *ppCursor = &cur->base;
+    return SQLITE_OK;
+}
+
+static int varlen_close(sqlite3_vtab_cursor *cursor)
+{
+    varlen_cursor *cur = (varlen_cursor*)cursor;
+
+    sqlite3_finalize(cur->nbr_stmt);
+    sqlite3_finalize(cur->start_stmt);
+    for (int i = 0; i < cur->frame_count; i++) {
+        free(cur->frames[i].nbrs);
+    }
+    free(cur->frames);
+    free(cur->types);
+    sqlite3_free(cur);
+    return SQLITE_OK;
+}
+
+static int varlen_filter(sqlite3_vtab_cursor *cursor, int idx_num, const char *idx_str,
+                         int argc, sqlite3_value **argv)
+{
+    (void)idx_str;
+    (void)argc;
+
+    varlen_cursor *cur = (varlen_cursor*)cursor;
+    cur->db = ((varlen_vtab*)cursor->pVtab)->db;
+
+    cur->depth = 0;
+    cur->eof = false;
+    cur->rowid = 0;
+    sqlite3_finalize(cur->start_stmt);
+    cur->start_stmt = NULL;
+
+    /* Decode arguments in the order xBestIndex assigned them */
+    int arg = 0;
+    bool has_start = false;
+    sqlite3_int64 start = 0;
+    if (idx_num & VARLEN_HAS_START) {
+        if (sqlite3_value_type(argv[arg]) == SQLITE_NULL) {
+            cur->eof = true;  /* start_id = NULL matches nothing */
+            return SQLITE_OK;
+        }
+        start = sqlite3_value_int64(argv[arg++]);
+        has_start = true;
+    }
+
+    free(cur->types);
+    cur->types = NULL;
+    if (idx_num & VARLEN_HAS_TYPES) {
+        const char *types = (const char*)sqlite3_value_text(argv[arg++]);
+        if (types) {
+            cur->types = strdup(types);
+            if (!cur->types) {
+                return SQLITE_NOMEM;
+            }
+        }
+    }
+
+    cur->direction = 1;
+    if (idx_num & VARLEN_HAS_DIRECTION) {
+        int dir = sqlite3_value_int(argv[arg++]);
+        cur->direction = dir > 0 ? 1 : (dir < 0 ? -1 : 0);
+    }
+
+    cur->min_hops = 1;
+    if (idx_num & VARLEN_HAS_MIN) {
+        cur->min_hops = sqlite3_value_int(argv[arg++]);
+        if (cur->min_hops < 0) {
+            cur->min_hops = 0;
+        }
+    }
+
+    cur->max_hops = VARLEN_DEFAULT_MAX_HOPS;
+    if (idx_num & VARLEN_HAS_MAX) {
+        if (sqlite3_value_type(argv[arg]) != SQLITE_NULL) {
+            cur->max_hops = sqlite3_value_int(argv[arg]);
+        }
+        arg++;
+    }
+
+    if (cur->max_hops < cur->min_hops) {
+        cur->eof = true;
+        return SQLITE_OK;
+    }
+
+    /* Path stack holds max_hops + 1 nodes */
+    if (cur->frame_count < cur->max_hops + 1) {
+        int count = cur->max_hops + 1;
+        varlen_frame *grown = realloc(cur->frames, count * sizeof(varlen_frame));
+        if (!grown) {
+            return SQLITE_NOMEM;
+        }
+        memset(grown + cur->frame_count, 0, (count - cur->frame_count) * sizeof(varlen_frame));
+        cur->frames = grown;
+        cur->frame_count = count;
+    }
+
+    int rc = prepare_neighbor_stmt(cur);
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    bool row_ready = false;
+    if (has_start) {
+        rc = begin_start(cur, start, &row_ready);
+    } else {
+        rc = sqlite3_prepare_v2(cur->db, "SELECT id FROM nodes ORDER BY id", -1,
+                                &cur->start_stmt, NULL);
+        if (rc != SQLITE_OK) {
+            return rc;
+        }
+        bool found;
+        rc = next_start(cur, &found, &row_ready);
+        if (rc == SQLITE_OK && !found) {
+            cur->eof = true;
+            return SQLITE_OK;
+        }
+    }
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    if (row_ready) {
+        cur->rowid++;
+        return SQLITE_OK;
+    }
+    return advance(cur);
+}
+
+static int varlen_next(sqlite3_vtab_cursor *cursor)
+{
+    return advance((varlen_cursor*)cursor);
+}
+
+static int varlen_eof(sqlite3_vtab_cursor *cursor)
+{
+    return ((varlen_cursor*)cursor)->eof;
+}
+
+static int varlen_column(sqlite3_vtab_cursor *cursor, sqlite3_context *ctx, int col)
+{
+    varlen_cursor *cur = (varlen_cursor*)cursor;
+
+    switch (col) {
+        case VARLEN_COL_START_ID:
+            sqlite3_result_int64(ctx, cur->frames[0].node);
+            break;
+        case VARLEN_COL_END_ID:
+            sqlite3_result_int64(ctx, cur->frames[cur->depth].node);
+            break;
+        case VARLEN_COL_DEPTH:
+            sqlite3_result_int(ctx, cur->depth);
+            break;
+        case VARLEN_COL_PATH_IDS: {
+            /* 20 digits + separator per node */
+            size_t cap = (size_t)(cur->depth + 1) * 21 + 1;
+            char *buf = sqlite3_malloc64(cap);
+            if (!buf) {
+                sqlite3_result_error_nomem(ctx);
+                break;
+            }
+            size_t len = 0;
+            for (int i = 0; i <= cur->depth; i++) {
+                len += snprintf(buf + len, cap - len, i ? ",%lld" : "%lld",
+                                (long long)cur->frames[i].node);
+            }
+            sqlite3_result_text(ctx, buf, (int)len, sqlite3_free);
+            break;
+        }
+        case VARLEN_COL_TYPES:
+            if (cur->types) {
+                sqlite3_result_text(ctx, cur->types, -1, SQLITE_TRANSIENT);
+            } else {
+                sqlite3_result_null(ctx);
+            }
+            break;
+        case VARLEN_COL_DIRECTION:
+            sqlite3_result_int(ctx, cur->direction);
+            break;
+        case VARLEN_COL_MIN_HOPS:
+            sqlite3_result_int(ctx, cur->min_hops);
+            break;
+        case VARLEN_COL_MAX_HOPS:
+            sqlite3_result_int(ctx, cur->max_hops);
+            break;
+    }
+    return SQLITE_OK;
+}
+
+static int varlen_rowid(sqlite3_vtab_cursor *cursor, sqlite3_int64 *rowid)
+{
+    *rowid = ((varlen_cursor*)cursor)->rowid;
+    return SQLITE_OK;
+}
+
+static sqlite3_module varlen_module = {
+    0,                  /* iVersion */
+    NULL,               /* xCreate - eponymous only */
+    varlen_connect,     /* xConnect */
+    varlen_best_index,  /* xBestIndex */
+    varlen_disconnect,  /* xDisconnect */
+    NULL,               /* xDestroy */
+    varlen_open,        /* xOpen */
+    varlen_close,       /* xClose */
+    varlen_filter,      /* xFilter */
+    varlen_next,        /* xNext */
+    varlen_eof,         /* xEof */
+    varlen_column,      /* xColumn */
+    varlen_rowid,       /* xRowid */
+    NULL,               /* xUpdate */
+    NULL,               /* xBegin */
+    NULL,               /* xSync */
+    NULL,               /* xCommit */
+    NULL,               /* xRollback */
+    NULL,               /* xFindFunction */
+    NULL,               /* xRename */
+    NULL,               /* xSavepoint */
+    NULL,               /* xRelease */
+    NULL,               /* xRollbackTo */
+    NULL,               /* xShadowName */
+    NULL                /* xIntegrity */
+};
+
+int varlen_paths_register(sqlite3 *db)
+{
+    CYPHER_DEBUG("Registering gql_varlen_paths module");
+    return sqlite3_create_module(db, "gql_varlen_paths", &varlen_module, NULL);
+}
@@ -713,146 +713,84 @@ int cypher_transform_generate_sql(cypher_transform_context *ctx, cypher_query *q
     return 0;
 }
 
-/* Variable-length relationship CTE generation */
+/* Variable-length relationship traversal */
+
+/* Append a JSON string literal (type names are identifiers, but be safe) */
+static void append_json_string(dynamic_buffer *buf, const char *value)
+{
+    dbuf_append_char(buf, '"');
+    for (const char *p = value; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            dbuf_append_char(buf, '\\');
+        }
+        dbuf_append_char(buf, *p);
+    }
+    dbuf_append_char(buf, '"');
+}
 
 /**
- * Generate a recursive CTE for variable-length relationship traversal.
+ * Build the gql_varlen_paths() table-valued function call for a
+ * variable-length relationship.
  *
- * For a query like MATCH (a)-[*1..5]->(b), generates:
+ * For a query like MATCH (a)-[:KNOWS*1..5]->(b), generates:
  *
- * WITH RECURSIVE varlen_cte_N(start_id, end_id, depth, path_ids, visited) AS (
- *     -- Base case: direct edges
- *     SELECT e.source_id, e.target_id, 1,
- *            CAST(e.source_id || ',' || e.target_id AS TEXT),
- *            ',' || e.source_id || ',' || e.target_id || ','
- *     FROM edges e
- *     WHERE e.type = 'TYPE'  -- if type specified
+ *   gql_varlen_paths('["KNOWS"]', 1, 1, 5)
  *
- *     UNION ALL
+ * The caller cross-joins it after the source node and constrains
+ * start_id = <source id>, so the traversal starts from the bound source
+ * rather than from every edge. Columns match the recursive CTE this
+ * replaces: start_id, end_id, depth, path_ids (see varlen_paths.h).
  *
- *     -- Recursive case: extend paths
- *     SELECT cte.start_id, e.target_id, cte.depth + 1,
- *            cte.path_ids || ',' || e.target_id,
- *            cte.visited || e.target_id || ','
- *     FROM varlen_cte_N cte
- *     JOIN edges e ON e.source_id = cte.end_id
- *     WHERE cte.depth < max_hops
- *       AND cte.visited NOT LIKE '%,' || e.target_id || ',%'  -- cycle prevention
- *       AND e.type = 'TYPE'  -- if type specified
- * )
+ * Returns a newly allocated string, or NULL on error.
  */
-int generate_varlen_cte(cypher_transform_context *ctx, cypher_rel_pattern *rel,
-                       const char *source_alias, const char *target_alias,
-                       const char *cte_name)
+char *generate_varlen_source(cypher_transform_context *ctx, cypher_rel_pattern *rel)
 {
-    (void)source_alias; /* Mark as intentionally unused for now */
-    (void)target_alias; /* Mark as intentionally unused for now */
-
-    if (!ctx || !rel || !rel->varlen || !cte_name) {
-        return -1;
+    if (!ctx || !rel || !rel->varlen) {
+        return NULL;
     }
 
     cypher_varlen_range *range = (cypher_varlen_range*)rel->varlen;
     int min_hops = range->min_hops > 0 ? range->min_hops : 1;
     int max_hops = range->max_hops > 0 ? range->max_hops : 100; /* Default max for unbounded */
 
-    CYPHER_DEBUG("Generating varlen CTE %s: min=%d, max=%d, type=%s",
-                 cte_name, min_hops, max_hops, rel->type ? rel->type : "<any>");
-
-    /* Build CTE query in a local buffer */
-    dynamic_buffer cte_query;
-    dbuf_init(&cte_query);
-
-    /* Handle relationship direction */
-    const char *src_col = "source_id";
-    const char *tgt_col = "target_id";
-    if (rel->left_arrow && !rel->right_arrow) {
-        /* <-[*]- reversed direction */
-        src_col = "target_id";
-        tgt_col = "source_id";
-    }
-
-    /* Base case: direct edges (depth = 1) */
-    dbuf_appendf(&cte_query,
-        "SELECT e.%s, e.%s, 1, "
-        "CAST(e.%s || ',' || e.%s AS TEXT), "
-        "','|| e.%s || ',' || e.%s || ','  "
-        "FROM edges e",
-        src_col, tgt_col,
-        src_col, tgt_col,
-        src_col, tgt_col);
-
-    /* Add type constraint if specified */
+    CYPHER_DEBUG("Generating varlen traversal: min=%d, max=%d, type=%s",
+                 min_hops, max_hops, rel->type ? rel->type : "<any>");
+
+    /* Relationship types as a JSON array, or NULL for any type */
+    dynamic_buffer types;
+    dbuf_init(&types);
     if (rel->type) {
-        { char *esc = escape_sql_string(rel->type);
-          dbuf_appendf(&cte_query, " WHERE e.type = '%s'", esc ? esc : rel->type);
-          free(esc); }
+        dbuf_append_char(&types, '[');
+        append_json_string(&types, rel->type);
+        dbuf_append_char(&types, ']');
     } else if (rel->types && rel->types->count > 0) {
-        dbuf_append(&cte_query, " WHERE (");
+        dbuf_append_char(&types, '[');
         for (int t = 0; t < rel->types->count; t++) {
-            if (t > 0) {
-                dbuf_append(&cte_query, " OR ");
-            }
             cypher_literal *type_lit = (cypher_literal*)rel->types->items[t];
-            { char *esc = escape_sql_string(type_lit->value.string);
-              dbuf_appendf(&cte_query, "e.type = '%s'", esc ? esc : type_lit->value.string);
-              free(esc); }
-        }
-        dbuf_append(&cte_query, ")");
-    }
-
-    /* Recursive case */
-    dbuf_append(&cte_query, " UNION ALL ");
-    dbuf_appendf(&cte_query,
-        "SELECT cte.start_id, e.%s, cte.depth + 1, "
-        "cte.path_ids || ',' || e.%s, "
-        "cte.visited || e.%s || ',' "
-        "FROM %s cte "
-        "JOIN edges e ON e.%s = cte.end_id "
-        "WHERE cte.depth < %d",
-        tgt_col, tgt_col, tgt_col,
-        cte_name,
-        src_col,
-        max_hops);
-
-    /* Add cycle detection */
-    dbuf_appendf(&cte_query,
-        " AND cte.visited NOT LIKE '%%,' || CAST(e.%s AS TEXT) || ',%%'",
-        tgt_col);
-
-    /* Add type constraint to recursive case */
-    if (rel->type) {
-        { char *esc = escape_sql_string(rel->type);
-          dbuf_appendf(&cte_query, " AND e.type = '%s'", esc ? esc : rel->type);
-          free(esc); }
-    } else if (rel->types && rel->types->count > 0) {
-        dbuf_append(&cte_query, " AND (");
-        for (int t = 0; t < rel->types->count; t++) {
             if (t > 0) {
-                dbuf_append(&cte_query, " OR ");
+                dbuf_append_char(&types, ',');
             }
-            cypher_literal *type_lit = (cypher_literal*)rel->types->items[t];
-            { char *esc = escape_sql_string(type_lit->value.string);
-              dbuf_appendf(&cte_query, "e.type = '%s'", esc ? esc : type_lit->value.string);
-              free(esc); }
+            append_json_string(&types, type_lit->value.string);
         }
-        dbuf_append(&cte_query, ")");
+        dbuf_append_char(&types, ']');
     }
 
-    /* Build CTE name with column definitions */
-    char cte_full_name[256];
-    snprintf(cte_full_name, sizeof(cte_full_name),
-             "%s(start_id, end_id, depth, path_ids, visited)", cte_name);
+    /* <-[*]- walks incoming edges; -[*]-> and -[*]- walk outgoing edges */
+    int direction = (rel->left_arrow && !rel->right_arrow) ? -1 : 1;
 
-    /* Add CTE to unified builder - recursive CTE */
-    sql_cte(ctx->unified_builder, cte_full_name, dbuf_get(&cte_query), true);
-    dbuf_free(&cte_query);
-
-    ctx->cte_count++;
-
-    CYPHER_DEBUG("Generated varlen CTE via unified builder: %s", cte_full_name);
+    dynamic_buffer call;
+    dbuf_init(&call);
+    if (dbuf_is_empty(&types)) {
+        dbuf_append(&call, "gql_varlen_paths(NULL");
+    } else {
+        char *esc = escape_sql_string(dbuf_get(&types));
+        dbuf_appendf(&call, "gql_varlen_paths('%s'", esc ? esc : "");
+        free(esc);
+    }
+    dbuf_appendf(&call, ", %d, %d, %d)", direction, min_hops, max_hops);
+    dbuf_free(&types);
 
-    return 0;
+    return dbuf_finish(&call);
 }
 
 /* Result management */
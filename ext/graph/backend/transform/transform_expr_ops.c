@@ -12,6 +12,7 @@
 #include "transform/transform_internal.h"
 #include "transform/transform_functions.h"
 #include "transform/transform_func_dispatch.h"
+#include "executor/cypher_schema.h"
 #include "parser/cypher_debug.h"
 
 /* Transform label expression (e.g., n:Person) */
@@ -427,102 +428,151 @@ int transform_property_access(cypher_transform_context *ctx, cypher_property *pr
         gprefix = gprefix_buf;
     }
 
-    /* Generate property access query using our actual schema */
-    /* We need to check multiple property tables based on type */
+    append_property_lookup(ctx, is_edge, gprefix, alias, skip_id_suffix ? "" : ".id",
+                           prop->property_name,
+                           ctx->in_comparison ? PROP_VALUE_NATIVE : PROP_VALUE_TEXT);
+    return 0;
+}
 
-    if (is_edge) {
-        /* Edge property access - use edge_props_* tables */
-        const char *id_suffix = skip_id_suffix ? "" : ".id";
-        if (ctx->in_comparison) {
-            append_sql(ctx, "(SELECT COALESCE(");
-            append_sql(ctx, "(SELECT ept.value FROM %sedge_props_text ept JOIN %sproperty_keys pk ON ept.key_id = pk.id WHERE ept.edge_id = %s%s AND pk.key = ", gprefix, gprefix, alias, id_suffix);
-            append_string_literal(ctx, prop->property_name);
-            append_sql(ctx, "), ");
-            append_sql(ctx, "(SELECT epi.value FROM %sedge_props_int epi JOIN %sproperty_keys pk ON epi.key_id = pk.id WHERE epi.edge_id = %s%s AND pk.key = ", gprefix, gprefix, alias, id_suffix);
-            append_string_literal(ctx, prop->property_name);
-            append_sql(ctx, "), ");
-            append_sql(ctx, "(SELECT epr.value FROM %sedge_props_real epr JOIN %sproperty_keys pk ON epr.key_id = pk.id WHERE epr.edge_id = %s%s AND pk.key = ", gprefix, gprefix, alias, id_suffix);
-            append_string_literal(ctx, prop->property_name);
-            append_sql(ctx, "), ");
-            append_sql(ctx, "(SELECT CAST(epb.value AS INTEGER) FROM %sedge_props_bool epb JOIN %sproperty_keys pk ON epb.key_id = pk.id WHERE epb.edge_id = %s%s AND pk.key = ", gprefix, gprefix, alias, id_suffix);
-            append_string_literal(ctx, prop->property_name);
-            append_sql(ctx, "), ");
-            append_sql(ctx, "(SELECT epj.value FROM %sedge_props_json epj JOIN %sproperty_keys pk ON epj.key_id = pk.id WHERE epj.edge_id = %s%s AND pk.key = ", gprefix, gprefix, alias, id_suffix);
-            append_string_literal(ctx, prop->property_name);
-            append_sql(ctx, ")))");
-        } else {
-            append_sql(ctx, "(SELECT COALESCE(");
-            append_sql(ctx, "(SELECT ept.value FROM %sedge_props_text ept JOIN %sproperty_keys pk ON ept.key_id = pk.id WHERE ept.edge_id = %s%s AND pk.key = ", gprefix, gprefix, alias, id_suffix);
-            append_string_literal(ctx, prop->property_name);
-            append_sql(ctx, "), ");
-            append_sql(ctx, "(SELECT CAST(epi.value AS TEXT) FROM %sedge_props_int epi JOIN %sproperty_keys pk ON epi.key_id = pk.id WHERE epi.edge_id = %s%s AND pk.key = ", gprefix, gprefix, alias, id_suffix);
-            append_string_literal(ctx, prop->property_name);
-            append_sql(ctx, "), ");
-            append_sql(ctx, "(SELECT CAST(epr.value AS TEXT) FROM %sedge_props_real epr JOIN %sproperty_keys pk ON epr.key_id = pk.id WHERE epr.edge_id = %s%s AND pk.key = ", gprefix, gprefix, alias, id_suffix);
-            append_string_literal(ctx, prop->property_name);
-            append_sql(ctx, "), ");
-            append_sql(ctx, "(SELECT CASE WHEN epb.value THEN 'true' ELSE 'false' END FROM %sedge_props_bool epb JOIN %sproperty_keys pk ON epb.key_id = pk.id WHERE epb.edge_id = %s%s AND pk.key = ", gprefix, gprefix, alias, id_suffix);
-            append_string_literal(ctx, prop->property_name);
-            append_sql(ctx, "), ");
-            append_sql(ctx, "(SELECT epj.value FROM %sedge_props_json epj JOIN %sproperty_keys pk ON epj.key_id = pk.id WHERE epj.edge_id = %s%s AND pk.key = ", gprefix, gprefix, alias, id_suffix);
-            append_string_literal(ctx, prop->property_name);
-            append_sql(ctx, ")))");
+/* Typed property tables in COALESCE order, with per-mode value expressions */
+static const struct {
+    const char *table;          /* After node_ / edge_ */
+    char alias;                 /* npt, epi, ... */
+    property_type type;
+    const char *native[2];      /* Prefix / suffix around <alias>.value */
+    const char *text[2];
+} prop_tables[] = {
+    { "props_text", 't', PROP_TYPE_TEXT,    { "", "" },             { "", "" } },
+    { "props_int",  'i', PROP_TYPE_INTEGER, { "", "" },             { "CAST(", " AS TEXT)" } },
+    { "props_real", 'r', PROP_TYPE_REAL,    { "", "" },             { "CAST(", " AS TEXT)" } },
+    { "props_bool", 'b', PROP_TYPE_BOOLEAN, { "CAST(", " AS INTEGER)" },
+                                            { "CASE WHEN ", " THEN 'true' ELSE 'false' END" } },
+    { "props_json", 'j', PROP_TYPE_JSON,    { "", "" },             { "", "" } },
+};
+
+/*
+ * Property value lookup: a COALESCE over the typed property tables.
+ *
+ * With a schema manager attached (read queries, see plan_use_catalog) the
+ * key id is resolved now and only the tables the type catalog lists for
+ * the key are probed, straight off their (owner_id, key_id) primary keys.
+ * Otherwise, and for attached graphs with their own property_keys, every
+ * table joins property_keys by name at run time.
+ */
+void append_property_lookup(cypher_transform_context *ctx, bool is_edge, const char *gprefix,
+                            const char *alias, const char *id_suffix, const char *key,
+                            prop_value_mode mode)
+{
+    const char *owner = is_edge ? "edge" : "node";
+    int key_id = -1;
+    int types = -1;
+
+    if (ctx->schema && gprefix[0] == '\0') {
+        key_id = cypher_schema_get_property_key_id(ctx->schema, key);
+        types = cypher_schema_property_types(ctx->schema, key_id, is_edge);
+        if (types < 0) {
+            key_id = -1;
         }
-    } else if (ctx->in_comparison) {
-        /* Node property access for comparisons - preserve proper types */
-        append_sql(ctx, "(SELECT COALESCE(");
-        /* Text properties (both numeric and non-numeric strings) */
-        append_sql(ctx, "(SELECT npt.value FROM %snode_props_text npt JOIN %sproperty_keys pk ON npt.key_id = pk.id WHERE npt.node_id = %s%s AND pk.key = ",
-                   gprefix, gprefix, alias, skip_id_suffix ? "" : ".id");
-        append_string_literal(ctx, prop->property_name);
-        append_sql(ctx, "), ");
-        /* Integer properties */
-        append_sql(ctx, "(SELECT npi.value FROM %snode_props_int npi JOIN %sproperty_keys pk ON npi.key_id = pk.id WHERE npi.node_id = %s%s AND pk.key = ",
-                   gprefix, gprefix, alias, skip_id_suffix ? "" : ".id");
-        append_string_literal(ctx, prop->property_name);
-        append_sql(ctx, "), ");
-        /* Real properties */
-        append_sql(ctx, "(SELECT npr.value FROM %snode_props_real npr JOIN %sproperty_keys pk ON npr.key_id = pk.id WHERE npr.node_id = %s%s AND pk.key = ",
-                   gprefix, gprefix, alias, skip_id_suffix ? "" : ".id");
-        append_string_literal(ctx, prop->property_name);
-        append_sql(ctx, "), ");
-        /* Boolean properties (cast to integer for comparison) */
-        append_sql(ctx, "(SELECT CAST(npb.value AS INTEGER) FROM %snode_props_bool npb JOIN %sproperty_keys pk ON npb.key_id = pk.id WHERE npb.node_id = %s%s AND pk.key = ",
-                   gprefix, gprefix, alias, skip_id_suffix ? "" : ".id");
-        append_string_literal(ctx, prop->property_name);
-        append_sql(ctx, "), ");
-        /* JSON properties */
-        append_sql(ctx, "(SELECT npj.value FROM %snode_props_json npj JOIN %sproperty_keys pk ON npj.key_id = pk.id WHERE npj.node_id = %s%s AND pk.key = ",
-                   gprefix, gprefix, alias, skip_id_suffix ? "" : ".id");
-        append_string_literal(ctx, prop->property_name);
-        append_sql(ctx, ")))");
-    } else {
-        /* Node property access for RETURN clauses - convert everything to text */
+    }
+
+    /* Known key that never held a value of this kind */
+    if (key_id >= 0 && types == 0) {
+        append_sql(ctx, "NULL");
+        return;
+    }
+
+    int count = 0;
+    for (size_t i = 0; i < sizeof(prop_tables) / sizeof(prop_tables[0]); i++) {
+        if (types & (1 << prop_tables[i].type)) count++;
+    }
+
+    /* COALESCE needs two arguments */
+    if (count > 1) {
         append_sql(ctx, "(SELECT COALESCE(");
-        append_sql(ctx, "(SELECT npt.value FROM %snode_props_text npt JOIN %sproperty_keys pk ON npt.key_id = pk.id WHERE npt.node_id = %s%s AND pk.key = ",
-                   gprefix, gprefix, alias, skip_id_suffix ? "" : ".id");
-        append_string_literal(ctx, prop->property_name);
-        append_sql(ctx, "), ");
-        append_sql(ctx, "(SELECT CAST(npi.value AS TEXT) FROM %snode_props_int npi JOIN %sproperty_keys pk ON npi.key_id = pk.id WHERE npi.node_id = %s%s AND pk.key = ",
-                   gprefix, gprefix, alias, skip_id_suffix ? "" : ".id");
-        append_string_literal(ctx, prop->property_name);
-        append_sql(ctx, "), ");
-        append_sql(ctx, "(SELECT CAST(npr.value AS TEXT) FROM %snode_props_real npr JOIN %sproperty_keys pk ON npr.key_id = pk.id WHERE npr.node_id = %s%s AND pk.key = ",
-                   gprefix, gprefix, alias, skip_id_suffix ? "" : ".id");
-        append_string_literal(ctx, prop->property_name);
-        append_sql(ctx, "), ");
-        append_sql(ctx, "(SELECT CASE WHEN npb.value THEN 'true' ELSE 'false' END FROM %snode_props_bool npb JOIN %sproperty_keys pk ON npb.key_id = pk.id WHERE npb.node_id = %s%s AND pk.key = ",
-                   gprefix, gprefix, alias, skip_id_suffix ? "" : ".id");
-        append_string_literal(ctx, prop->property_name);
-        append_sql(ctx, "), ");
-        /* JSON properties (already TEXT) */
-        append_sql(ctx, "(SELECT npj.value FROM %snode_props_json npj JOIN %sproperty_keys pk ON npj.key_id = pk.id WHERE npj.node_id = %s%s AND pk.key = ",
-                   gprefix, gprefix, alias, skip_id_suffix ? "" : ".id");
-        append_string_literal(ctx, prop->property_name);
-        append_sql(ctx, ")))");
     }
 
-    return 0;
+    bool first = true;
+    for (size_t i = 0; i < sizeof(prop_tables) / sizeof(prop_tables[0]); i++) {
+        if (!(types & (1 << prop_tables[i].type))) continue;
+
+        char table_alias[4] = { owner[0], 'p', prop_tables[i].alias, '\0' };
+        const char *const *value = mode == PROP_VALUE_NATIVE ? prop_tables[i].native : prop_tables[i].text;
+        const char *value_pre = value[0];
+        const char *value_post = value[1];
+        if (mode == PROP_VALUE_JSON && prop_tables[i].type == PROP_TYPE_JSON) {
+            value_pre = "json(";
+            value_post = ")";
+        }
+
+        if (!first) {
+            append_sql(ctx, ", ");
+        }
+        first = false;
+
+        append_sql(ctx, "(SELECT %s%s.value%s FROM %s%s_%s %s ",
+                   value_pre, table_alias, value_post, gprefix, owner, prop_tables[i].table, table_alias);
+        if (key_id >= 0) {
+            append_sql(ctx, "WHERE %s.%s_id = %s%s AND %s.key_id = %d)",
+                       table_alias, owner, alias, id_suffix, table_alias, key_id);
+        } else {
+            append_sql(ctx, "JOIN %sproperty_keys pk ON %s.key_id = pk.id WHERE %s.%s_id = %s%s AND pk.key = ",
+                       gprefix, table_alias, table_alias, owner, alias, id_suffix);
+            append_string_literal(ctx, key);
+            append_sql(ctx, ")");
+        }
+    }
+
+    if (count > 1) {
+        append_sql(ctx, "))");
+    }
+}
+
+/*
+ * Whole-entity property map as a JSON object ('{}' when empty), for
+ * RETURN n and properties(n). Read queries on a database that keeps packed
+ * records (cypher_schema_packed_properties) fetch the entity's record;
+ * otherwise each property key is probed against the typed tables.
+ * Returns a malloc'd expression.
+ */
+char *entity_properties_sql(cypher_transform_context *ctx, bool is_edge, const char *gprefix,
+                            const char *id_expr)
+{
+    const char *owner = is_edge ? "edge" : "node";
+    char a = owner[0];
+    dynamic_buffer buf;
+    dbuf_init(&buf);
+
+    if (ctx->schema && gprefix[0] == '\0' && cypher_schema_packed_properties(ctx->schema)) {
+        dbuf_appendf(&buf, "COALESCE((SELECT json(%cpp.props) FROM %s_props_packed %cpp WHERE %cpp.%s_id = %s), "
+                     "json('{}'))", a, owner, a, a, owner, id_expr);
+        return dbuf_finish(&buf);
+    }
+
+    dbuf_appendf(&buf, "COALESCE((SELECT json_group_object(pk.key, COALESCE("
+        "(SELECT %cpt.value FROM %s%s_props_text %cpt WHERE %cpt.%s_id = %s AND %cpt.key_id = pk.id), "
+        "(SELECT %cpi.value FROM %s%s_props_int %cpi WHERE %cpi.%s_id = %s AND %cpi.key_id = pk.id), "
+        "(SELECT %cpr.value FROM %s%s_props_real %cpr WHERE %cpr.%s_id = %s AND %cpr.key_id = pk.id), "
+        "(SELECT %cpb.value FROM %s%s_props_bool %cpb WHERE %cpb.%s_id = %s AND %cpb.key_id = pk.id), "
+        "(SELECT json(%cpj.value) FROM %s%s_props_json %cpj WHERE %cpj.%s_id = %s AND %cpj.key_id = pk.id))) ",
+        a, gprefix, owner, a, a, owner, id_expr, a,
+        a, gprefix, owner, a, a, owner, id_expr, a,
+        a, gprefix, owner, a, a, owner, id_expr, a,
+        a, gprefix, owner, a, a, owner, id_expr, a,
+        a, gprefix, owner, a, a, owner, id_expr, a);
+    dbuf_appendf(&buf, "FROM %sproperty_keys pk WHERE "
+        "EXISTS (SELECT 1 FROM %s%s_props_text WHERE %s_id = %s AND key_id = pk.id) OR "
+        "EXISTS (SELECT 1 FROM %s%s_props_int WHERE %s_id = %s AND key_id = pk.id) OR "
+        "EXISTS (SELECT 1 FROM %s%s_props_real WHERE %s_id = %s AND key_id = pk.id) OR "
+        "EXISTS (SELECT 1 FROM %s%s_props_bool WHERE %s_id = %s AND key_id = pk.id) OR "
+        "EXISTS (SELECT 1 FROM %s%s_props_json WHERE %s_id = %s AND key_id = pk.id)"
+        "), json('{}'))",
+        gprefix,
+        gprefix, owner, owner, id_expr,
+        gprefix, owner, owner, id_expr,
+        gprefix, owner, owner, id_expr,
+        gprefix, owner, owner, id_expr,
+        gprefix, owner, owner, id_expr);
+    return dbuf_finish(&buf);
 }
 
 /* Transform function call (e.g., count(n), count(*)) */
@@ -930,18 +930,15 @@ static int generate_relationship_match(cypher_transform_context *ctx, cypher_rel
         if (!edge_alias) return -1;
     }
     
-    /* Handle variable-length relationships differently - use recursive CTE */
+    /* Handle variable-length relationships differently - native traversal function */
     if (rel->varlen) {
         CYPHER_DEBUG("Handling variable-length relationship");
 
-        /* Generate unique CTE name */
-        char cte_name[64];
-        snprintf(cte_name, sizeof(cte_name), "_varlen_path_%d", rel_index);
-
-        /* Generate the recursive CTE (added to unified builder) */
-        if (generate_varlen_cte(ctx, rel, source_alias, target_alias, cte_name) < 0) {
+        /* gql_varlen_paths(...) call, joined after the source node */
+        char *varlen_source = generate_varlen_source(ctx, rel);
+        if (!varlen_source) {
             ctx->has_error = true;
-            ctx->error_message = strdup("Failed to generate variable-length CTE");
+            ctx->error_message = strdup("Failed to generate variable-length traversal");
             return -1;
         }
 
@@ -949,8 +946,10 @@ static int generate_relationship_match(cypher_transform_context *ctx, cypher_rel
         cypher_varlen_range *range = (cypher_varlen_range*)rel->varlen;
         int min_hops = range->min_hops > 0 ? range->min_hops : 1;
 
-        /* Join the main query with the CTE result using unified builder */
-        sql_join(ctx->unified_builder, SQL_JOIN_CROSS, cte_name, edge_alias, NULL);
+        /* Join the main query with the traversal using unified builder.
+         * CROSS JOIN keeps the source node ahead of it in the join order so
+         * start_id = <source id> reaches xBestIndex as the traversal root. */
+        sql_join(ctx->unified_builder, SQL_JOIN_CROSS, varlen_source, edge_alias, NULL);
 
         /* Add target node to FROM clause - needed for the CTE join */
         bool target_has_properties = (target_node->properties && target_node->properties->type == AST_NODE_MAP);
@@ -1039,8 +1038,8 @@ static int generate_relationship_match(cypher_transform_context *ctx, cypher_rel
             }
         }
 
-        CYPHER_DEBUG("Added varlen CTE join: %s for relationship between %s and %s",
-                     cte_name, source_alias, target_alias);
+        CYPHER_DEBUG("Added varlen traversal join: %s for relationship between %s and %s",
+                     varlen_source, source_alias, target_alias);
 
         /* Add WHERE constraints for the CTE join using unified builder */
         char src_id_ref[256], tgt_id_ref[256];
@@ -1062,11 +1061,12 @@ static int generate_relationship_match(cypher_transform_context *ctx, cypher_rel
         if (ptype == PATH_TYPE_SHORTEST || ptype == PATH_TYPE_ALL_SHORTEST) {
             CYPHER_DEBUG("Adding shortest path filtering (type=%d)", ptype);
             dbuf_appendf(&on_cond, " AND %s.depth = (SELECT MIN(sp.depth) FROM %s sp WHERE sp.start_id = %s AND sp.end_id = %s)",
-                         edge_alias, cte_name, src_id_ref, tgt_id_ref);
+                         edge_alias, varlen_source, src_id_ref, tgt_id_ref);
         }
 
         sql_where(ctx->unified_builder, dbuf_get(&on_cond));
         dbuf_free(&on_cond);
+        free(varlen_source);
 
         return 0; /* Skip the rest of the relationship handling */
     }
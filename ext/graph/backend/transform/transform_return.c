@@ -163,38 +163,18 @@ int transform_return_clause(cypher_transform_context *ctx, cypher_return *ret)
                 if (var->kind == VAR_KIND_NODE) {
                     /* Return full node object using json_object */
                     char expr_buf[2048];
+                    char id_expr[256];
                     const char *alias = var->table_alias;
-                    bool skip_id = var->alias_is_id;
+                    snprintf(id_expr, sizeof(id_expr), "%s%s", alias, var->alias_is_id ? "" : ".id");
+                    char *props = entity_properties_sql(ctx, false, "", id_expr);
                     snprintf(expr_buf, sizeof(expr_buf),
                         "(SELECT json_object("
-                        "'id', %s%s, "
-                        "'labels', COALESCE((SELECT json_group_array(label) FROM node_labels WHERE node_id = %s%s), json('[]')), "
-                        "'properties', COALESCE((SELECT json_group_object(pk.key, COALESCE("
-                            "(SELECT npt.value FROM node_props_text npt WHERE npt.node_id = %s%s AND npt.key_id = pk.id), "
-                            "(SELECT npi.value FROM node_props_int npi WHERE npi.node_id = %s%s AND npi.key_id = pk.id), "
-                            "(SELECT npr.value FROM node_props_real npr WHERE npr.node_id = %s%s AND npr.key_id = pk.id), "
-                            "(SELECT npb.value FROM node_props_bool npb WHERE npb.node_id = %s%s AND npb.key_id = pk.id), "
-                            "(SELECT json(npj.value) FROM node_props_json npj WHERE npj.node_id = %s%s AND npj.key_id = pk.id))) "
-                        "FROM property_keys pk WHERE "
-                            "EXISTS (SELECT 1 FROM node_props_text WHERE node_id = %s%s AND key_id = pk.id) OR "
-                            "EXISTS (SELECT 1 FROM node_props_int WHERE node_id = %s%s AND key_id = pk.id) OR "
-                            "EXISTS (SELECT 1 FROM node_props_real WHERE node_id = %s%s AND key_id = pk.id) OR "
-                            "EXISTS (SELECT 1 FROM node_props_bool WHERE node_id = %s%s AND key_id = pk.id) OR "
-                            "EXISTS (SELECT 1 FROM node_props_json WHERE node_id = %s%s AND key_id = pk.id)"
-                        "), json('{}'))"
+                        "'id', %s, "
+                        "'labels', COALESCE((SELECT json_group_array(label) FROM node_labels WHERE node_id = %s), json('[]')), "
+                        "'properties', %s"
                         "))",
-                        alias, skip_id ? "" : ".id",
-                        alias, skip_id ? "" : ".id",
-                        alias, skip_id ? "" : ".id",
-                        alias, skip_id ? "" : ".id",
-                        alias, skip_id ? "" : ".id",
-                        alias, skip_id ? "" : ".id",
-                        alias, skip_id ? "" : ".id",
-                        alias, skip_id ? "" : ".id",
-                        alias, skip_id ? "" : ".id",
-                        alias, skip_id ? "" : ".id",
-                        alias, skip_id ? "" : ".id",
-                        alias, skip_id ? "" : ".id");
+                        id_expr, id_expr, props ? props : "json('{}')");
+                    free(props);
                     sql_select(ctx->unified_builder, expr_buf, var->name);
                 } else if (var->kind == VAR_KIND_EDGE) {
                     /* Return edge as its type */
@@ -610,9 +590,20 @@ int transform_expression(cypher_transform_context *ctx, ast_node *expr)
                         if (transform_var_is_projected(ctx->var_ctx, id->name)) {
                             /* This is a projected variable from WITH - alias is the full column reference */
                             append_sql(ctx, "%s", alias);
-                        } else if (transform_var_alias_is_id(ctx->var_ctx, id->name)) {
-                            /* Post-WITH node/edge - alias IS the id value */
-                            if (transform_var_is_edge(ctx->var_ctx, id->name)) {
+                        } else {
+                            /* Node or edge; after WITH the alias IS the id value */
+                            bool alias_is_id = transform_var_alias_is_id(ctx->var_ctx, id->name);
+                            bool is_edge = transform_var_is_edge(ctx->var_ctx, id->name);
+                            char id_expr[256];
+                            snprintf(id_expr, sizeof(id_expr), "%s%s", alias, alias_is_id ? "" : ".id");
+                            char *props = entity_properties_sql(ctx, is_edge, "", id_expr);
+                            if (!props) {
+                                ctx->has_error = true;
+                                ctx->error_message = strdup("Out of memory during SQL generation");
+                                return -1;
+                            }
+
+                            if (alias_is_id && is_edge) {
                                 /* Edge that passed through WITH - build relationship object */
                                 /* Note: After WITH, we only have the id, not type/source/target */
                                 append_sql(ctx, "json_object("
@@ -620,92 +611,29 @@ int transform_expression(cypher_transform_context *ctx, ast_node *expr)
                                     "'type', (SELECT type FROM edges WHERE id = %s), "
                                     "'startNodeId', (SELECT source_id FROM edges WHERE id = %s), "
                                     "'endNodeId', (SELECT target_id FROM edges WHERE id = %s), "
-                                    "'properties', COALESCE((SELECT json_group_object(pk.key, COALESCE("
-                                        "(SELECT ept.value FROM edge_props_text ept WHERE ept.edge_id = %s AND ept.key_id = pk.id), "
-                                        "(SELECT epi.value FROM edge_props_int epi WHERE epi.edge_id = %s AND epi.key_id = pk.id), "
-                                        "(SELECT epr.value FROM edge_props_real epr WHERE epr.edge_id = %s AND epr.key_id = pk.id), "
-                                        "(SELECT epb.value FROM edge_props_bool epb WHERE epb.edge_id = %s AND epb.key_id = pk.id), "
-                                        "(SELECT json(epj.value) FROM edge_props_json epj WHERE epj.edge_id = %s AND epj.key_id = pk.id))) "
-                                    "FROM property_keys pk WHERE "
-                                        "EXISTS (SELECT 1 FROM edge_props_text WHERE edge_id = %s AND key_id = pk.id) OR "
-                                        "EXISTS (SELECT 1 FROM edge_props_int WHERE edge_id = %s AND key_id = pk.id) OR "
-                                        "EXISTS (SELECT 1 FROM edge_props_real WHERE edge_id = %s AND key_id = pk.id) OR "
-                                        "EXISTS (SELECT 1 FROM edge_props_bool WHERE edge_id = %s AND key_id = pk.id) OR "
-                                        "EXISTS (SELECT 1 FROM edge_props_json WHERE edge_id = %s AND key_id = pk.id)"
-                                    "), json('{}'))"
+                                    "'properties', %s"
                                 ")",
-                                alias, alias, alias, alias,
-                                alias, alias, alias, alias, alias,
-                                alias, alias, alias, alias, alias);
+                                alias, alias, alias, alias, props);
+                            } else if (is_edge) {
+                                /* This is an edge variable - return full relationship object */
+                                append_sql(ctx, "json_object("
+                                    "'id', %s.id, "
+                                    "'type', %s.type, "
+                                    "'startNodeId', %s.source_id, "
+                                    "'endNodeId', %s.target_id, "
+                                    "'properties', %s"
+                                ")",
+                                alias, alias, alias, alias, props);
                             } else {
-                                /* Node that passed through WITH - build node object using id directly */
+                                /* Node, post-WITH or bound by MATCH - return full node object */
                                 append_sql(ctx, "json_object("
                                     "'id', %s, "
                                     "'labels', COALESCE((SELECT json_group_array(label) FROM node_labels WHERE node_id = %s), json('[]')), "
-                                    "'properties', COALESCE((SELECT json_group_object(pk.key, COALESCE("
-                                        "(SELECT npt.value FROM node_props_text npt WHERE npt.node_id = %s AND npt.key_id = pk.id), "
-                                        "(SELECT npi.value FROM node_props_int npi WHERE npi.node_id = %s AND npi.key_id = pk.id), "
-                                        "(SELECT npr.value FROM node_props_real npr WHERE npr.node_id = %s AND npr.key_id = pk.id), "
-                                        "(SELECT npb.value FROM node_props_bool npb WHERE npb.node_id = %s AND npb.key_id = pk.id), "
-                                        "(SELECT json(npj.value) FROM node_props_json npj WHERE npj.node_id = %s AND npj.key_id = pk.id))) "
-                                    "FROM property_keys pk WHERE "
-                                        "EXISTS (SELECT 1 FROM node_props_text WHERE node_id = %s AND key_id = pk.id) OR "
-                                        "EXISTS (SELECT 1 FROM node_props_int WHERE node_id = %s AND key_id = pk.id) OR "
-                                        "EXISTS (SELECT 1 FROM node_props_real WHERE node_id = %s AND key_id = pk.id) OR "
-                                        "EXISTS (SELECT 1 FROM node_props_bool WHERE node_id = %s AND key_id = pk.id) OR "
-                                        "EXISTS (SELECT 1 FROM node_props_json WHERE node_id = %s AND key_id = pk.id)"
-                                    "), json('{}'))"
+                                    "'properties', %s"
                                 ")",
-                                alias, alias,
-                                alias, alias, alias, alias, alias,
-                                alias, alias, alias, alias, alias);
+                                id_expr, id_expr, props);
                             }
-                        } else if (transform_var_is_edge(ctx->var_ctx, id->name)) {
-                            /* This is an edge variable - return full relationship object */
-                            append_sql(ctx, "json_object("
-                                "'id', %s.id, "
-                                "'type', %s.type, "
-                                "'startNodeId', %s.source_id, "
-                                "'endNodeId', %s.target_id, "
-                                "'properties', COALESCE((SELECT json_group_object(pk.key, COALESCE("
-                                    "(SELECT ept.value FROM edge_props_text ept WHERE ept.edge_id = %s.id AND ept.key_id = pk.id), "
-                                    "(SELECT epi.value FROM edge_props_int epi WHERE epi.edge_id = %s.id AND epi.key_id = pk.id), "
-                                    "(SELECT epr.value FROM edge_props_real epr WHERE epr.edge_id = %s.id AND epr.key_id = pk.id), "
-                                    "(SELECT epb.value FROM edge_props_bool epb WHERE epb.edge_id = %s.id AND epb.key_id = pk.id), "
-                                    "(SELECT json(epj.value) FROM edge_props_json epj WHERE epj.edge_id = %s.id AND epj.key_id = pk.id))) "
-                                "FROM property_keys pk WHERE "
-                                    "EXISTS (SELECT 1 FROM edge_props_text WHERE edge_id = %s.id AND key_id = pk.id) OR "
-                                    "EXISTS (SELECT 1 FROM edge_props_int WHERE edge_id = %s.id AND key_id = pk.id) OR "
-                                    "EXISTS (SELECT 1 FROM edge_props_real WHERE edge_id = %s.id AND key_id = pk.id) OR "
-                                    "EXISTS (SELECT 1 FROM edge_props_bool WHERE edge_id = %s.id AND key_id = pk.id) OR "
-                                    "EXISTS (SELECT 1 FROM edge_props_json WHERE edge_id = %s.id AND key_id = pk.id)"
-                                "), json('{}'))"
-                            ")",
-                            alias, alias, alias, alias,
-                            alias, alias, alias, alias, alias,
-                            alias, alias, alias, alias, alias);
-                        } else {
-                            /* This is a node variable - return full node object */
-                            append_sql(ctx, "json_object("
-                                "'id', %s.id, "
-                                "'labels', COALESCE((SELECT json_group_array(label) FROM node_labels WHERE node_id = %s.id), json('[]')), "
-                                "'properties', COALESCE((SELECT json_group_object(pk.key, COALESCE("
-                                    "(SELECT npt.value FROM node_props_text npt WHERE npt.node_id = %s.id AND npt.key_id = pk.id), "
-                                    "(SELECT npi.value FROM node_props_int npi WHERE npi.node_id = %s.id AND npi.key_id = pk.id), "
-                                    "(SELECT npr.value FROM node_props_real npr WHERE npr.node_id = %s.id AND npr.key_id = pk.id), "
-                                    "(SELECT npb.value FROM node_props_bool npb WHERE npb.node_id = %s.id AND npb.key_id = pk.id), "
-                                    "(SELECT json(npj.value) FROM node_props_json npj WHERE npj.node_id = %s.id AND npj.key_id = pk.id))) "
-                                "FROM property_keys pk WHERE "
-                                    "EXISTS (SELECT 1 FROM node_props_text WHERE node_id = %s.id AND key_id = pk.id) OR "
-                                    "EXISTS (SELECT 1 FROM node_props_int WHERE node_id = %s.id AND key_id = pk.id) OR "
-                                    "EXISTS (SELECT 1 FROM node_props_real WHERE node_id = %s.id AND key_id = pk.id) OR "
-                                    "EXISTS (SELECT 1 FROM node_props_bool WHERE node_id = %s.id AND key_id = pk.id) OR "
-                                    "EXISTS (SELECT 1 FROM node_props_json WHERE node_id = %s.id AND key_id = pk.id)"
-                                "), json('{}'))"
-                            ")",
-                            alias, alias,
-                            alias, alias, alias, alias, alias,
-                            alias, alias, alias, alias, alias);
+                            free(props);
                         }
                     } else {
                         /* Unknown identifier */
@@ -1030,28 +958,8 @@ int transform_expression(cypher_transform_context *ctx, ast_node *expr)
 
                         /* Output value */
                         if (item->property && base_alias) {
-                            /* Property access using same logic as transform_property_access */
-                            append_sql(ctx, "(SELECT COALESCE(");
-                            append_sql(ctx, "(SELECT npt.value FROM node_props_text npt JOIN property_keys pk ON npt.key_id = pk.id WHERE npt.node_id = %s%s AND pk.key = ",
-                                       base_alias, is_projected ? "" : ".id");
-                            append_string_literal(ctx, item->property);
-                            append_sql(ctx, "), ");
-                            append_sql(ctx, "(SELECT CAST(npi.value AS TEXT) FROM node_props_int npi JOIN property_keys pk ON npi.key_id = pk.id WHERE npi.node_id = %s%s AND pk.key = ",
-                                       base_alias, is_projected ? "" : ".id");
-                            append_string_literal(ctx, item->property);
-                            append_sql(ctx, "), ");
-                            append_sql(ctx, "(SELECT CAST(npr.value AS TEXT) FROM node_props_real npr JOIN property_keys pk ON npr.key_id = pk.id WHERE npr.node_id = %s%s AND pk.key = ",
-                                       base_alias, is_projected ? "" : ".id");
-                            append_string_literal(ctx, item->property);
-                            append_sql(ctx, "), ");
-                            append_sql(ctx, "(SELECT CASE WHEN npb.value THEN 'true' ELSE 'false' END FROM node_props_bool npb JOIN property_keys pk ON npb.key_id = pk.id WHERE npb.node_id = %s%s AND pk.key = ",
-                                       base_alias, is_projected ? "" : ".id");
-                            append_string_literal(ctx, item->property);
-                            append_sql(ctx, "), ");
-                            append_sql(ctx, "(SELECT json(npj.value) FROM node_props_json npj JOIN property_keys pk ON npj.key_id = pk.id WHERE npj.node_id = %s%s AND pk.key = ",
-                                       base_alias, is_projected ? "" : ".id");
-                            append_string_literal(ctx, item->property);
-                            append_sql(ctx, ")))");
+                            append_property_lookup(ctx, false, "", base_alias, is_projected ? "" : ".id",
+                                                   item->property, PROP_VALUE_JSON);
                         } else if (item->expr) {
                             /* Computed expression */
                             if (transform_expression(ctx, item->expr) < 0) {
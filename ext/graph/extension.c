@@ -12,6 +12,8 @@
 #include "executor/cypher_executor.h"
 #include "executor/agtype.h"
 #include "executor/graph_algorithms.h"
+#include "executor/graph_import.h"
+#include "executor/json_builder.h"
 #include "parser/cypher_parser.h"
 #include "parser/cypher_debug.h"
 
@@ -40,11 +42,33 @@ static void graphqlite_result_error(sqlite3_context *context, const char *messag
     sqlite3_result_error(context, buf, -1);
 }
 
+/* Copy a dynamic message so it can go inside the JSON error: double quotes
+ * become single quotes, backslashes are escaped and control characters dropped */
+static void graphqlite_sanitize_error(char *buf, size_t size, const char *message) {
+    char *dst = buf;
+    char *end = buf + size - 1;
+    for (const char *src = message; *src && dst < end; src++) {
+        if (*src == '"') {
+            *dst++ = '\'';
+        } else if (*src == '\\') {
+            if (end - dst < 2) break;
+            *dst++ = '\\';
+            *dst++ = '\\';
+        } else if ((unsigned char)*src >= 0x20) {
+            *dst++ = *src;
+        }
+    }
+    *dst = '\0';
+}
+
 /* Per-connection executor cache structure */
 typedef struct {
     sqlite3 *db;
     cypher_executor *executor;
     csr_graph *cached_graph;  /* Cached CSR graph for algorithm acceleration */
+    bool graph_triggers;      /* Delta triggers created for an incremental graph */
+    graph_projection *projections;  /* Named projections from gql_project() */
+    graph_pool *pool;               /* Worker threads from gql_graph_threads(), NULL = serial */
 } connection_cache;
 
 /* Destructor called when database connection closes */
@@ -55,6 +79,8 @@ static void connection_cache_destroy(void *data) {
             CYPHER_DEBUG("Connection closing - freeing cached graph %p", (void*)cache->cached_graph);
             csr_graph_free(cache->cached_graph);
         }
+        graph_projections_free(cache->projections);
+        graph_pool_free(cache->pool);
         if (cache->executor) {
             CYPHER_DEBUG("Connection closing - freeing executor %p", (void*)cache->executor);
             cypher_executor_free(cache->executor);
@@ -63,6 +89,34 @@ static void connection_cache_destroy(void *data) {
     }
 }
 
+/* Executor cached for this connection, created on first use */
+static cypher_executor *connection_executor(connection_cache *cache, sqlite3 *db) {
+    cypher_executor *executor = cache ? cache->executor : NULL;
+
+    if (executor) {
+        CYPHER_DEBUG("Reusing cached executor %p", (void*)executor);
+    } else {
+        CYPHER_DEBUG("Creating new executor for db=%p", (void*)db);
+        executor = cypher_executor_create(db);
+        if (!executor) {
+            return NULL;
+        }
+
+        /* Cache for reuse */
+        if (cache) {
+            cache->executor = executor;
+        }
+    }
+
+    /* Ensure executor has current cached graph and projection references */
+    if (cache) {
+        executor->cached_graph = cache->cached_graph;
+        executor->projections = cache->projections;
+        executor->pool = cache->pool;
+    }
+    return executor;
+}
+
 /* Simple test function */
 static void simple_test_func(sqlite3_context *context, int argc, sqlite3_value **argv) {
     (void)argc;
@@ -101,35 +155,12 @@ static void graphqlite_cypher_func(sqlite3_context *context, int argc, sqlite3_v
         }
     }
 
-    /* Get database connection from SQLite context */
-    sqlite3 *db = sqlite3_context_db_handle(context);
-
-    /* Get per-connection cache from user data */
+    /* Reuse the connection's executor (created on first use) */
     connection_cache *cache = (connection_cache *)sqlite3_user_data(context);
-    cypher_executor *executor = NULL;
-
-    if (cache && cache->executor) {
-        /* Reuse cached executor for this connection */
-        executor = cache->executor;
-        CYPHER_DEBUG("Reusing cached executor %p", (void*)executor);
-    } else {
-        /* First call - create new executor */
-        CYPHER_DEBUG("Creating new executor for db=%p", (void*)db);
-        executor = cypher_executor_create(db);
-        if (!executor) {
-            graphqlite_result_error(context, "Failed to create cypher executor", GQL_ERR_INTERNAL);
-            return;
-        }
-
-        /* Cache for reuse */
-        if (cache) {
-            cache->executor = executor;
-        }
-    }
-
-    /* Ensure executor has current cached graph reference */
-    if (cache) {
-        executor->cached_graph = cache->cached_graph;
+    cypher_executor *executor = connection_executor(cache, sqlite3_context_db_handle(context));
+    if (!executor) {
+        graphqlite_result_error(context, "Failed to create cypher executor", GQL_ERR_INTERNAL);
+        return;
     }
 
     /* Execute query (with or without parameters) */
@@ -149,108 +180,49 @@ static void graphqlite_cypher_func(sqlite3_context *context, int argc, sqlite3_v
     if (result->success) {
         if (result->row_count > 0 && result->use_agtype && result->agtype_data) {
             /* Use AGE-compatible format */
+            json_builder jb;
+            jbuf_init(&jb, 1024);
+
             if (result->row_count == 1 && result->column_count == 1) {
                 /* Single result - wrap with column name for consistent format */
-                char *agtype_str = agtype_value_to_string(result->agtype_data[0][0]);
-                if (agtype_str) {
-                    const char *col_name = (result->column_names && result->column_names[0])
-                        ? result->column_names[0] : "result";
-                    int json_size = strlen(agtype_str) + strlen(col_name) + 32;
-                    char *json_result = malloc(json_size);
-                    if (json_result) {
-                        snprintf(json_result, json_size, "[{\"%s\": %s}]", col_name, agtype_str);
-                        sqlite3_result_text(context, json_result, -1, SQLITE_TRANSIENT);
-                        free(json_result);
-                    } else {
-                        sqlite3_result_text(context, agtype_str, -1, SQLITE_TRANSIENT);
-                    }
-                    free(agtype_str);
-                } else {
-                    sqlite3_result_text(context, "[{\"result\": null}]", -1, SQLITE_STATIC);
-                }
+                const char *col_name = (result->column_names && result->column_names[0])
+                    ? result->column_names[0] : "result";
+                jbuf_appendf(&jb, "[{\"%s\": ", col_name);
+                agtype_value_write(&jb, result->agtype_data[0][0]);
+                jbuf_append(&jb, "}]");
             } else {
-                /* Multiple results - return as JSON array */
-                size_t buffer_size = 1024;
+                /* Multiple results - values are serialized straight into the array */
+                jbuf_append(&jb, "[");
+
                 for (int row = 0; row < result->row_count; row++) {
+                    if (row > 0) jbuf_append(&jb, ",");
+                    jbuf_append(&jb, "{");
                     for (int col = 0; col < result->column_count; col++) {
-                        if (result->agtype_data[row][col]) {
-                            char *temp_str = agtype_value_to_string(result->agtype_data[row][col]);
-                            if (temp_str) {
-                                buffer_size += strlen(temp_str) + 20;
-                                free(temp_str);
-                            }
-                        }
-                    }
-                }
-
-                char *json_result = malloc(buffer_size);
-                if (!json_result) {
-                    graphqlite_result_error(context, "Memory allocation failed for agtype result formatting", GQL_ERR_MEMORY);
-                    cypher_result_free(result);
-                    return;
-                }
-                size_t offset = 0;
-
-                offset += snprintf(json_result + offset, buffer_size - offset, "[");
+                        if (col > 0) jbuf_append(&jb, ",");
 
-                for (int row = 0; row < result->row_count; row++) {
-                    if (row > 0) offset += snprintf(json_result + offset, buffer_size - offset, ",");
-
-                    if (result->column_count == 1) {
-                        /* Single column - wrap with column name for consistent format */
-                        offset += snprintf(json_result + offset, buffer_size - offset, "{\"");
-                        if (result->column_names && result->column_names[0]) {
-                            size_t slen = strlen(result->column_names[0]);
-                            if (offset + slen < buffer_size) { memcpy(json_result + offset, result->column_names[0], slen); offset += slen; }
-                        } else {
-                            offset += snprintf(json_result + offset, buffer_size - offset, "result");
-                        }
-                        offset += snprintf(json_result + offset, buffer_size - offset, "\":");
-                        char *agtype_str = agtype_value_to_string(result->agtype_data[row][0]);
-                        if (agtype_str) {
-                            size_t slen = strlen(agtype_str);
-                            if (offset + slen < buffer_size) { memcpy(json_result + offset, agtype_str, slen); offset += slen; }
-                            free(agtype_str);
+                        /* Single column falls back to "result" for consistent format */
+                        if (result->column_names && result->column_names[col]) {
+                            jbuf_appendf(&jb, "\"%s\":", result->column_names[col]);
+                        } else if (result->column_count == 1) {
+                            jbuf_append(&jb, "\"result\":");
                         } else {
-                            offset += snprintf(json_result + offset, buffer_size - offset, "null");
+                            jbuf_appendf(&jb, "\"column_%d\":", col);
                         }
-                        offset += snprintf(json_result + offset, buffer_size - offset, "}");
-                    } else {
-                        /* Multiple columns - create object */
-                        offset += snprintf(json_result + offset, buffer_size - offset, "{");
-                        for (int col = 0; col < result->column_count; col++) {
-                            if (col > 0) offset += snprintf(json_result + offset, buffer_size - offset, ",");
 
-                            offset += snprintf(json_result + offset, buffer_size - offset, "\"");
-                            if (result->column_names && result->column_names[col]) {
-                                size_t slen = strlen(result->column_names[col]);
-                                if (offset + slen < buffer_size) { memcpy(json_result + offset, result->column_names[col], slen); offset += slen; }
-                            } else {
-                                char col_name[32];
-                                snprintf(col_name, sizeof(col_name), "column_%d", col);
-                                size_t slen = strlen(col_name);
-                                if (offset + slen < buffer_size) { memcpy(json_result + offset, col_name, slen); offset += slen; }
-                            }
-                            offset += snprintf(json_result + offset, buffer_size - offset, "\":");
-
-                            char *agtype_str = agtype_value_to_string(result->agtype_data[row][col]);
-                            if (agtype_str) {
-                                size_t slen = strlen(agtype_str);
-                                if (offset + slen < buffer_size) { memcpy(json_result + offset, agtype_str, slen); offset += slen; }
-                                free(agtype_str);
-                            } else {
-                                offset += snprintf(json_result + offset, buffer_size - offset, "null");
-                            }
-                        }
-                        offset += snprintf(json_result + offset, buffer_size - offset, "}");
+                        agtype_value_write(&jb, result->agtype_data[row][col]);
                     }
+                    jbuf_append(&jb, "}");
                 }
-                offset += snprintf(json_result + offset, buffer_size - offset, "]");
-                json_result[offset] = '\0';
+                jbuf_append(&jb, "]");
+            }
 
-                sqlite3_result_text(context, json_result, -1, SQLITE_TRANSIENT);
-                free(json_result);
+            if (!jbuf_ok(&jb)) {
+                jbuf_free(&jb);
+                graphqlite_result_error(context, "Memory allocation failed for agtype result formatting", GQL_ERR_MEMORY);
+                cypher_result_free(result);
+                return;
             }
+            sqlite3_result_text(context, jbuf_take(&jb), -1, free);
         } else if (result->row_count > 0 && result->data) {
             /* Format results as JSON with column names */
             size_t buffer_size = 1024;
@@ -366,6 +338,320 @@ static void graphqlite_cypher_func(sqlite3_context *context, int argc, sqlite3_v
     cypher_result_free(result);
 }
 
+/*
+ * cypher_rows(query [, params]) - table-valued form of cypher()
+ *
+ *   SELECT name, value FROM cypher_rows('MATCH (n:Person) RETURN n.name, n.age')
+ *   WHERE row < 10;
+ *
+ * One row per result cell: row and col number it, name is the column name,
+ * value is the typed SQL value (the id for nodes and edges) and json the
+ * agtype JSON of node, edge and path values (NULL for anything else).
+ * Read-only queries are streamed from their prepared statement, so LIMIT
+ * stops the query early and no result is buffered; other queries run when
+ * the table is first read. An upper bound on row (row < N, row <= N,
+ * row = N) also ends the scan once it is passed.
+ */
+
+#define CYPHER_ROWS_ROW     0
+#define CYPHER_ROWS_COL     1
+#define CYPHER_ROWS_NAME    2
+#define CYPHER_ROWS_VALUE   3
+#define CYPHER_ROWS_JSON    4
+#define CYPHER_ROWS_QUERY   5
+#define CYPHER_ROWS_PARAMS  6
+
+typedef struct {
+    sqlite3_vtab base;
+    sqlite3 *db;
+    connection_cache *cache;
+} cypher_rows_vtab;
+
+typedef struct {
+    sqlite3_vtab_cursor base;
+    cypher_cursor *rows;
+    char *query;
+    char *params;
+    int col;               /* column of the current cell */
+    sqlite3_int64 last_row; /* highest row to produce, -1 for all */
+    sqlite3_int64 rowid;
+    bool eof;
+} cypher_rows_cursor;
+
+static int cypher_rows_connect(sqlite3 *db, void *aux, int argc, const char *const *argv,
+                               sqlite3_vtab **vtab, char **err) {
+    (void)argc;
+    (void)argv;
+    (void)err;
+
+    int rc = sqlite3_declare_vtab(db,
+        "CREATE TABLE x(row INTEGER, col INTEGER, name TEXT, value ANY, json TEXT, "
+        "query HIDDEN, params HIDDEN)");
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+
+    cypher_rows_vtab *table = sqlite3_malloc(sizeof(cypher_rows_vtab));
+    if (!table) {
+        return SQLITE_NOMEM;
+    }
+    memset(table, 0, sizeof(*table));
+    table->db = db;
+    table->cache = (connection_cache *)aux;
+    *vtab = &table->base;
+    return SQLITE_OK;
+}
+
+static int cypher_rows_disconnect(sqlite3_vtab *vtab) {
+    sqlite3_free(vtab);
+    return SQLITE_OK;
+}
+
+/* idxNum bit 1: a params argument follows the query; bit 2: then a row bound
+ * (idxStr gives its operator) */
+static int cypher_rows_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info) {
+    int query_idx = -1, params_idx = -1, bound_idx = -1;
+    bool query_unusable = false;
+
+    for (int i = 0; i < info->nConstraint; i++) {
+        const struct sqlite3_index_constraint *c = &info->aConstraint[i];
+        if (c->iColumn == CYPHER_ROWS_ROW && c->usable && bound_idx < 0 &&
+            (c->op == SQLITE_INDEX_CONSTRAINT_LT || c->op == SQLITE_INDEX_CONSTRAINT_LE ||
+             c->op == SQLITE_INDEX_CONSTRAINT_EQ)) {
+            bound_idx = i;
+            continue;
+        }
+        if (c->iColumn != CYPHER_ROWS_QUERY && c->iColumn != CYPHER_ROWS_PARAMS) {
+            continue;
+        }
+        if (!c->usable || c->op != SQLITE_INDEX_CONSTRAINT_EQ) {
+            query_unusable |= (c->iColumn == CYPHER_ROWS_QUERY);
+            continue;
+        }
+        if (c->iColumn == CYPHER_ROWS_QUERY) {
+            query_idx = i;
+        } else {
+            params_idx = i;
+        }
+    }
+
+    if (query_idx < 0) {
+        if (query_unusable) {
+            return SQLITE_CONSTRAINT;
+        }
+        sqlite3_free(vtab->zErrMsg);
+        vtab->zErrMsg = sqlite3_mprintf("cypher_rows() requires a query argument");
+        return SQLITE_ERROR;
+    }
+
+    info->aConstraintUsage[query_idx].argvIndex = 1;
+    info->aConstraintUsage[query_idx].omit = 1;
+    info->idxNum = 0;
+    if (params_idx >= 0) {
+        info->aConstraintUsage[params_idx].argvIndex = 2;
+        info->aConstraintUsage[params_idx].omit = 1;
+        info->idxNum = 1;
+    }
+    if (bound_idx >= 0) {
+        /* Still checked by SQLite: the bound only ends the scan early */
+        info->aConstraintUsage[bound_idx].argvIndex = params_idx >= 0 ? 3 : 2;
+        info->idxNum |= 2;
+        info->idxStr = info->aConstraint[bound_idx].op == SQLITE_INDEX_CONSTRAINT_LT ? "<" : "<=";
+    }
+
+    /* Cells come out in (row, col) order */
+    if (info->nOrderBy >= 1 && info->nOrderBy <= 2 &&
+        info->aOrderBy[0].iColumn == CYPHER_ROWS_ROW && !info->aOrderBy[0].desc &&
+        (info->nOrderBy == 1 ||
+         (info->aOrderBy[1].iColumn == CYPHER_ROWS_COL && !info->aOrderBy[1].desc))) {
+        info->orderByConsumed = 1;
+    }
+
+    info->estimatedCost = 1000.0;
+    info->estimatedRows = 1000;
+    return SQLITE_OK;
+}
+
+static int cypher_rows_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **cursor) {
+    (void)vtab;
+    cypher_rows_cursor *cur = sqlite3_malloc(sizeof(cypher_rows_cursor));
+    if (!cur) {
+        return SQLITE_NOMEM;
+    }
+    memset(cur, 0, sizeof(*cur));
+    cur->last_row = -1;
+    cur->eof = true;
+    *cursor = &cur->base;
+    return SQLITE_OK;
+}
+
+static void cypher_rows_reset(cypher_rows_cursor *cur) {
+    cypher_cursor_close(cur->rows);
+    cur->rows = NULL;
+    free(cur->query);
+    free(cur->params);
+    cur->query = NULL;
+    cur->params = NULL;
+    cur->col = 0;
+    cur->rowid = 0;
+    cur->last_row = -1;
+    cur->eof = true;
+}
+
+static int cypher_rows_close(sqlite3_vtab_cursor *cursor) {
+    cypher_rows_reset((cypher_rows_cursor *)cursor);
+    sqlite3_free(cursor);
+    return SQLITE_OK;
+}
+
+/* Step to the next result row; sets eof at the end */
+static int cypher_rows_step(cypher_rows_cursor *cur) {
+    int rc = cypher_cursor_next(cur->rows);
+    if (rc < 0) {
+        sqlite3_vtab *vtab = cur->base.pVtab;
+        sqlite3_free(vtab->zErrMsg);
+        vtab->zErrMsg = sqlite3_mprintf("%s", cur->rows->result->error_message ?
+                                        cur->rows->result->error_message : "Query execution failed");
+        cur->eof = true;
+        return SQLITE_ERROR;
+    }
+    cur->col = 0;
+    cur->eof = (rc == 0) || (cur->last_row >= 0 && cur->rows->row > cur->last_row);
+    return SQLITE_OK;
+}
+
+static int cypher_rows_filter(sqlite3_vtab_cursor *cursor, int idx_num, const char *idx_str,
+                              int argc, sqlite3_value **argv) {
+    cypher_rows_cursor *cur = (cypher_rows_cursor *)cursor;
+    cypher_rows_vtab *table = (cypher_rows_vtab *)cursor->pVtab;
+    cypher_rows_reset(cur);
+
+    if (idx_num & 2) {
+        sqlite3_value *bound = argv[(idx_num & 1) ? 2 : 1];
+        int bound_type = sqlite3_value_numeric_type(bound);
+        if (bound_type == SQLITE_INTEGER || bound_type == SQLITE_FLOAT || bound_type == SQLITE_NULL) {
+            double limit = bound_type == SQLITE_NULL ? -1 : sqlite3_value_double(bound);
+            sqlite3_int64 last = limit < 0 ? -1 : (sqlite3_int64)limit;
+            if (idx_str[1] == '\0' && (double)last == limit) {
+                last--;  /* row < N */
+            }
+            if (last < 0) {
+                /* No row can match */
+                return SQLITE_OK;
+            }
+            cur->last_row = last;
+        }
+    }
+
+    if (argc < 1 || sqlite3_value_type(argv[0]) != SQLITE_TEXT) {
+        sqlite3_free(table->base.zErrMsg);
+        table->base.zErrMsg = sqlite3_mprintf("cypher_rows() query must be text");
+        return SQLITE_ERROR;
+    }
+    cur->query = strdup((const char *)sqlite3_value_text(argv[0]));
+    if ((idx_num & 1) && argc > 1 && sqlite3_value_type(argv[1]) != SQLITE_NULL) {
+        if (sqlite3_value_type(argv[1]) != SQLITE_TEXT) {
+            sqlite3_free(table->base.zErrMsg);
+        table->base.zErrMsg = sqlite3_mprintf("cypher_rows() params must be JSON text or NULL");
+            return SQLITE_ERROR;
+        }
+        cur->params = strdup((const char *)sqlite3_value_text(argv[1]));
+    }
+    if (!cur->query) {
+        return SQLITE_NOMEM;
+    }
+
+    cypher_executor *executor = connection_executor(table->cache, table->db);
+    if (!executor) {
+        sqlite3_free(table->base.zErrMsg);
+        table->base.zErrMsg = sqlite3_mprintf("Failed to create cypher executor");
+        return SQLITE_ERROR;
+    }
+
+    cur->rows = cypher_executor_open_cursor(executor, cur->query, cur->params);
+    if (!cur->rows) {
+        return SQLITE_NOMEM;
+    }
+    /* A write without RETURN has run already and yields no cells */
+    if (cur->rows->result->success && cur->rows->result->column_count == 0) {
+        return SQLITE_OK;
+    }
+    return cypher_rows_step(cur);
+}
+
+static int cypher_rows_next(sqlite3_vtab_cursor *cursor) {
+    cypher_rows_cursor *cur = (cypher_rows_cursor *)cursor;
+    cur->rowid++;
+    if (++cur->col < cur->rows->result->column_count) {
+        return SQLITE_OK;
+    }
+    return cypher_rows_step(cur);
+}
+
+static int cypher_rows_eof(sqlite3_vtab_cursor *cursor) {
+    return ((cypher_rows_cursor *)cursor)->eof;
+}
+
+static int cypher_rows_column(sqlite3_vtab_cursor *cursor, sqlite3_context *context, int column) {
+    cypher_rows_cursor *cur = (cypher_rows_cursor *)cursor;
+    cypher_result *result = cur->rows->result;
+
+    switch (column) {
+        case CYPHER_ROWS_ROW:
+            sqlite3_result_int(context, cur->rows->row);
+            break;
+        case CYPHER_ROWS_COL:
+            sqlite3_result_int(context, cur->col);
+            break;
+        case CYPHER_ROWS_NAME:
+            if (result->column_names && result->column_names[cur->col]) {
+                sqlite3_result_text(context, result->column_names[cur->col], -1, SQLITE_TRANSIENT);
+            }
+            break;
+        case CYPHER_ROWS_VALUE:
+            cypher_cursor_column_value(cur->rows, cur->col, context);
+            break;
+        case CYPHER_ROWS_JSON: {
+            char *json = cypher_cursor_column_json(cur->rows, cur->col);
+            if (json) {
+                sqlite3_result_text(context, json, -1, free);
+            }
+            break;
+        }
+        case CYPHER_ROWS_QUERY:
+            sqlite3_result_text(context, cur->query, -1, SQLITE_TRANSIENT);
+            break;
+        case CYPHER_ROWS_PARAMS:
+            if (cur->params) {
+                sqlite3_result_text(context, cur->params, -1, SQLITE_TRANSIENT);
+            }
+            break;
+    }
+    return SQLITE_OK;
+}
+
+static int cypher_rows_rowid(sqlite3_vtab_cursor *cursor, sqlite3_int64 *rowid) {
+    *rowid = ((cypher_rows_cursor *)cursor)->rowid;
+    return SQLITE_OK;
+}
+
+static sqlite3_module cypher_rows_module = {
+    0,                       /* iVersion */
+    0,                       /* xCreate: eponymous only */
+    cypher_rows_connect,
+    cypher_rows_best_index,
+    cypher_rows_disconnect,
+    0,                       /* xDestroy */
+    cypher_rows_open,
+    cypher_rows_close,
+    cypher_rows_filter,
+    cypher_rows_next,
+    cypher_rows_eof,
+    cypher_rows_column,
+    cypher_rows_rowid,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
 /* Create schema function matching old architecture */
 static int create_schema(sqlite3 *db) {
     cypher_schema_manager *schema_manager = cypher_schema_create_manager(db);
@@ -384,11 +670,131 @@ static int create_schema(sqlite3 *db) {
  * Provide per-connection CSR graph caching for algorithm acceleration.
  */
 
-/* gql_load_graph() - Build CSR from SQLite and cache in connection memory */
-static void gql_load_graph_func(sqlite3_context *context, int argc, sqlite3_value **argv) {
+/*
+ * gql_record_change(op, table, rowid) - Called by the temp triggers below to
+ * log a changed rowid for the incremental graph's next sync.
+ */
+static void gql_record_change_func(sqlite3_context *context, int argc, sqlite3_value **argv) {
     (void)argc;
-    (void)argv;
+    connection_cache *cache = (connection_cache *)sqlite3_user_data(context);
+    if (cache && cache->cached_graph) {
+        csr_graph_record_change(cache->cached_graph, sqlite3_value_int(argv[0]),
+                                (const char *)sqlite3_value_text(argv[1]),
+                                sqlite3_value_int64(argv[2]));
+    }
+}
+
+/*
+ * Temp triggers feeding an incremental graph's change log. An update hook
+ * would replace any hook the application installed, and DELETE without a
+ * WHERE clause bypasses it; a table with triggers is never truncated.
+ */
+static const struct {
+    const char *name;
+    const char *event;
+    const char *table;
+    int op;
+    const char *row;
+} graph_delta_triggers[] = {
+    {"graphqlite_delta_nodes_insert", "INSERT", "nodes", SQLITE_INSERT, "NEW"},
+    {"graphqlite_delta_nodes_delete", "DELETE", "nodes", SQLITE_DELETE, "OLD"},
+    {"graphqlite_delta_edges_insert", "INSERT", "edges", SQLITE_INSERT, "NEW"},
+    {"graphqlite_delta_edges_update", "UPDATE", "edges", SQLITE_UPDATE, "NEW"},
+    {"graphqlite_delta_edges_delete", "DELETE", "edges", SQLITE_DELETE, "OLD"},
+    {"graphqlite_delta_props_insert", "INSERT", "node_props_text", SQLITE_INSERT, "NEW"},
+    {"graphqlite_delta_props_update", "UPDATE", "node_props_text", SQLITE_UPDATE, "NEW"},
+    {"graphqlite_delta_props_delete", "DELETE", "node_props_text", SQLITE_DELETE, "OLD"},
+};
+
+#define GRAPH_DELTA_TRIGGER_COUNT (int)(sizeof(graph_delta_triggers) / sizeof(graph_delta_triggers[0]))
+
+static int graph_delta_triggers_set(sqlite3 *db, bool install) {
+    int rc = SQLITE_OK;
+    for (int i = 0; i < GRAPH_DELTA_TRIGGER_COUNT && rc == SQLITE_OK; i++) {
+        char *sql = install ?
+            sqlite3_mprintf("CREATE TEMP TRIGGER IF NOT EXISTS %s AFTER %s ON main.%s "
+                            "BEGIN SELECT gql_record_change(%d, '%s', %s.rowid); END",
+                            graph_delta_triggers[i].name, graph_delta_triggers[i].event,
+                            graph_delta_triggers[i].table, graph_delta_triggers[i].op,
+                            graph_delta_triggers[i].table, graph_delta_triggers[i].row) :
+            sqlite3_mprintf("DROP TRIGGER IF EXISTS temp.%s", graph_delta_triggers[i].name);
+        rc = sql ? sqlite3_exec(db, sql, NULL, NULL, NULL) : SQLITE_NOMEM;
+        sqlite3_free(sql);
+    }
+    return rc;
+}
+
+/*
+ * Install the cached graph, logging writes when it is maintained
+ * incrementally. Fails if the triggers cannot be created, leaving no graph.
+ */
+static int connection_set_graph(connection_cache *cache, sqlite3 *db, csr_graph *graph) {
+    int rc = 0;
+    if (graph && graph->delta && graph_delta_triggers_set(db, true) != SQLITE_OK) {
+        CYPHER_DEBUG("Failed to create graph delta triggers: %s", sqlite3_errmsg(db));
+        csr_graph_free(graph);
+        graph = NULL;
+        rc = -1;
+    }
+
+    cache->cached_graph = graph;
+    if (cache->executor) {
+        cache->executor->cached_graph = graph;
+    }
+    if (graph && graph->delta) {
+        cache->graph_triggers = true;
+    } else if (cache->graph_triggers) {
+        graph_delta_triggers_set(db, false);
+        cache->graph_triggers = false;
+    }
+    return rc;
+}
+
+/* Read the "incremental" and "snapshot" flags from gql_load_graph() options */
+static int graph_load_options(sqlite3 *db, const char *options_json, int *incremental, int *snapshot) {
+    sqlite3_stmt *stmt = NULL;
+    int rc = sqlite3_prepare_v2(db,
+        "SELECT json_type(?1), json_extract(?1, '$.incremental'), json_extract(?1, '$.snapshot')",
+        -1, &stmt, NULL);
+    if (rc != SQLITE_OK) return -1;
+
+    sqlite3_bind_text(stmt, 1, options_json, -1, SQLITE_STATIC);
+    rc = -1;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char *type = (const char *)sqlite3_column_text(stmt, 0);
+        if (type && strcmp(type, "object") == 0) {
+            *incremental = sqlite3_column_int(stmt, 1) != 0;
+            *snapshot = sqlite3_column_int(stmt, 2) != 0;
+            rc = 0;
+        }
+    }
+    sqlite3_finalize(stmt);
+    return rc;
+}
 
+/* Map the current snapshot, or build the graph and save one; *how says which happened */
+static csr_graph *load_snapshot_graph(sqlite3 *db, const char **how) {
+    csr_graph *graph = csr_graph_open_snapshot(db);
+    if (graph) {
+        *how = "mapped";
+        return graph;
+    }
+
+    bool saved = false;
+    graph = csr_graph_save_snapshot(db, &saved);
+    *how = saved ? "saved" : "unsaved";
+    return graph;
+}
+
+/*
+ * gql_load_graph([options_json]) - Build CSR from SQLite and cache in connection memory.
+ * With {"incremental": true} the cache follows writes made on this connection
+ * through temp triggers instead of going stale until gql_reload_graph(), and
+ * is rebuilt when another connection commits.
+ * With {"snapshot": true} it is persisted next to the database and later
+ * loads map it, until a write to the graph invalidates it.
+ */
+static void gql_load_graph_func(sqlite3_context *context, int argc, sqlite3_value **argv) {
     connection_cache *cache = (connection_cache *)sqlite3_user_data(context);
     if (!cache) {
         graphqlite_result_error(context, "No connection cache available", GQL_ERR_INTERNAL);
@@ -397,6 +803,19 @@ static void gql_load_graph_func(sqlite3_context *context, int argc, sqlite3_valu
 
     sqlite3 *db = sqlite3_context_db_handle(context);
 
+    int incremental = 0, snapshot = 0;
+    if (argc == 1 && sqlite3_value_type(argv[0]) != SQLITE_NULL) {
+        if (sqlite3_value_type(argv[0]) != SQLITE_TEXT ||
+            graph_load_options(db, (const char *)sqlite3_value_text(argv[0]), &incremental, &snapshot) < 0) {
+            graphqlite_result_error(context, "gql_load_graph() options must be a JSON object", GQL_ERR_VALIDATION);
+            return;
+        }
+    }
+    if (incremental && snapshot) {
+        graphqlite_result_error(context, "gql_load_graph() snapshot graphs are read-only and cannot be incremental", GQL_ERR_VALIDATION);
+        return;
+    }
+
     /* If already loaded, return current stats */
     if (cache->cached_graph) {
         char response[256];
@@ -409,24 +828,31 @@ static void gql_load_graph_func(sqlite3_context *context, int argc, sqlite3_valu
     }
 
     /* Load graph from SQLite */
-    csr_graph *graph = csr_graph_load(db);
+    const char *how = NULL;
+    csr_graph *graph = snapshot ? load_snapshot_graph(db, &how) :
+                       incremental ? csr_graph_load_incremental(db) : csr_graph_load(db);
     if (!graph) {
         sqlite3_result_text(context, "{\"status\":\"loaded\",\"nodes\":0,\"edges\":0}", -1, SQLITE_STATIC);
         return;
     }
 
     /* Cache the graph */
-    cache->cached_graph = graph;
+    if (connection_set_graph(cache, db, graph) < 0) {
+        graphqlite_result_error(context, "Failed to track changes for the incremental graph", GQL_ERR_EXECUTION);
+        return;
+    }
 
-    /* Also update executor if it exists */
-    if (cache->executor) {
-        cache->executor->cached_graph = graph;
+    char mode[64] = "";
+    if (graph->delta) {
+        snprintf(mode, sizeof(mode), ",\"incremental\":true");
+    } else if (how) {
+        snprintf(mode, sizeof(mode), ",\"snapshot\":\"%s\"", how);
     }
 
     char response[256];
     snprintf(response, sizeof(response),
-             "{\"status\":\"loaded\",\"nodes\":%d,\"edges\":%d}",
-             graph->node_count, graph->edge_count);
+             "{\"status\":\"loaded\",\"nodes\":%d,\"edges\":%d%s}",
+             graph->node_count, graph->edge_count, mode);
     sqlite3_result_text(context, response, -1, SQLITE_TRANSIENT);
 }
 
@@ -443,12 +869,9 @@ static void gql_unload_graph_func(sqlite3_context *context, int argc, sqlite3_va
 
     if (cache->cached_graph) {
         csr_graph_free(cache->cached_graph);
-        cache->cached_graph = NULL;
 
-        /* Also clear executor reference */
-        if (cache->executor) {
-            cache->executor->cached_graph = NULL;
-        }
+        /* Also clear executor reference and the delta triggers */
+        connection_set_graph(cache, sqlite3_context_db_handle(context), NULL);
 
         sqlite3_result_text(context, "{\"status\":\"unloaded\"}", -1, SQLITE_STATIC);
     } else {
@@ -470,22 +893,26 @@ static void gql_reload_graph_func(sqlite3_context *context, int argc, sqlite3_va
     sqlite3 *db = sqlite3_context_db_handle(context);
 
     int prev_nodes = 0, prev_edges = 0;
+    bool incremental = false, snapshot = false;
 
     /* Free existing cache if present */
     if (cache->cached_graph) {
         prev_nodes = cache->cached_graph->node_count;
         prev_edges = cache->cached_graph->edge_count;
+        incremental = cache->cached_graph->delta != NULL;
+        snapshot = cache->cached_graph->snapshot != NULL;
         csr_graph_free(cache->cached_graph);
         cache->cached_graph = NULL;
     }
 
-    /* Load fresh graph from SQLite */
-    csr_graph *graph = csr_graph_load(db);
-    cache->cached_graph = graph;
-
-    /* Also update executor if it exists */
-    if (cache->executor) {
-        cache->executor->cached_graph = graph;
+    /* Load fresh graph from SQLite, keeping the incremental or snapshot mode.
+     * A snapshot whose tag still matches is current, so it is only remapped. */
+    const char *how = NULL;
+    csr_graph *graph = snapshot ? load_snapshot_graph(db, &how) :
+                       incremental ? csr_graph_load_incremental(db) : csr_graph_load(db);
+    if (connection_set_graph(cache, db, graph) < 0) {
+        graphqlite_result_error(context, "Failed to track changes for the incremental graph", GQL_ERR_EXECUTION);
+        return;
     }
 
     int new_nodes = graph ? graph->node_count : 0;
@@ -509,7 +936,22 @@ static void gql_graph_loaded_func(sqlite3_context *context, int argc, sqlite3_va
         return;
     }
 
-    if (cache->cached_graph) {
+    if (cache->cached_graph && cache->cached_graph->delta) {
+        char response[256];
+        snprintf(response, sizeof(response),
+                 "{\"loaded\":true,\"nodes\":%d,\"edges\":%d,\"incremental\":true,\"pending_changes\":%d}",
+                 cache->cached_graph->node_count,
+                 cache->cached_graph->edge_count,
+                 csr_graph_pending_changes(cache->cached_graph));
+        sqlite3_result_text(context, response, -1, SQLITE_TRANSIENT);
+    } else if (cache->cached_graph && cache->cached_graph->snapshot) {
+        char response[256];
+        snprintf(response, sizeof(response),
+                 "{\"loaded\":true,\"nodes\":%d,\"edges\":%d,\"snapshot\":true}",
+                 cache->cached_graph->node_count,
+                 cache->cached_graph->edge_count);
+        sqlite3_result_text(context, response, -1, SQLITE_TRANSIENT);
+    } else if (cache->cached_graph) {
         char response[256];
         snprintf(response, sizeof(response),
                  "{\"loaded\":true,\"nodes\":%d,\"edges\":%d}",
@@ -521,6 +963,188 @@ static void gql_graph_loaded_func(sqlite3_context *context, int argc, sqlite3_va
     }
 }
 
+/*
+ * gql_project(name, options_json) - Build a named projection for algorithms.
+ * Options: "labels" and "types" (a string or list) restrict the nodes and
+ * edges, "weight" names an edge property used as the edge weight. Projecting
+ * an existing name rebuilds it from the current database state.
+ */
+static void gql_project_func(sqlite3_context *context, int argc, sqlite3_value **argv) {
+    (void)argc;
+
+    connection_cache *cache = (connection_cache *)sqlite3_user_data(context);
+    if (!cache) {
+        graphqlite_result_error(context, "No connection cache available", GQL_ERR_INTERNAL);
+        return;
+    }
+
+    const char *name = (const char *)sqlite3_value_text(argv[0]);
+    if (!name || !*name) {
+        graphqlite_result_error(context, "gql_project() requires a projection name", GQL_ERR_VALIDATION);
+        return;
+    }
+    if (sqlite3_value_type(argv[1]) != SQLITE_TEXT) {
+        graphqlite_result_error(context, "gql_project() options must be a JSON object", GQL_ERR_VALIDATION);
+        return;
+    }
+
+    char *error = NULL;
+    csr_graph *graph = csr_graph_load_projection(sqlite3_context_db_handle(context),
+                                                 (const char *)sqlite3_value_text(argv[1]), &error);
+    if (!graph) {
+        graphqlite_result_error(context, error ? error : "Failed to build projection", GQL_ERR_VALIDATION);
+        free(error);
+        return;
+    }
+
+    if (graph_projection_put(&cache->projections, name, graph) < 0) {
+        csr_graph_free(graph);
+        graphqlite_result_error(context, "Out of memory", GQL_ERR_INTERNAL);
+        return;
+    }
+    if (cache->executor) {
+        cache->executor->projections = cache->projections;
+    }
+
+    char response[256];
+    snprintf(response, sizeof(response),
+             "{\"status\":\"projected\",\"nodes\":%d,\"edges\":%d,\"types\":%d,\"weighted\":%s}",
+             graph->node_count, graph->edge_count, graph->type_count,
+             graph->weights ? "true" : "false");
+    sqlite3_result_text(context, response, -1, SQLITE_TRANSIENT);
+}
+
+/* gql_drop_projection(name) - Free a named projection */
+static void gql_drop_projection_func(sqlite3_context *context, int argc, sqlite3_value **argv) {
+    (void)argc;
+
+    connection_cache *cache = (connection_cache *)sqlite3_user_data(context);
+    if (!cache) {
+        graphqlite_result_error(context, "No connection cache available", GQL_ERR_INTERNAL);
+        return;
+    }
+
+    const char *name = (const char *)sqlite3_value_text(argv[0]);
+    if (name && graph_projection_drop(&cache->projections, name)) {
+        if (cache->executor) {
+            cache->executor->projections = cache->projections;
+        }
+        sqlite3_result_text(context, "{\"status\":\"dropped\"}", -1, SQLITE_STATIC);
+    } else {
+        sqlite3_result_text(context, "{\"status\":\"not_found\"}", -1, SQLITE_STATIC);
+    }
+}
+
+/*
+ * gql_graph_threads([n]) - Threads used by PageRank, label propagation, WCC
+ * and eigenvector centrality on this connection. 1 (the default) runs them
+ * on the calling thread, 0 uses one thread per CPU. Results do not depend
+ * on the setting.
+ */
+static void gql_graph_threads_func(sqlite3_context *context, int argc, sqlite3_value **argv) {
+    connection_cache *cache = (connection_cache *)sqlite3_user_data(context);
+    if (!cache) {
+        graphqlite_result_error(context, "No connection cache available", GQL_ERR_INTERNAL);
+        return;
+    }
+
+    if (argc == 1) {
+        if (sqlite3_value_type(argv[0]) != SQLITE_INTEGER || sqlite3_value_int(argv[0]) < 0) {
+            graphqlite_result_error(context, "gql_graph_threads() expects 0 (one per CPU) or a positive thread count", GQL_ERR_VALIDATION);
+            return;
+        }
+
+        int threads = sqlite3_value_int(argv[0]);
+        graph_pool *pool = NULL;
+        if (threads != 1) {
+            pool = graph_pool_create(threads);
+            if (!pool) {
+                graphqlite_result_error(context, "Out of memory", GQL_ERR_INTERNAL);
+                return;
+            }
+            if (graph_pool_size(pool) == 1) {
+                graph_pool_free(pool);
+                pool = NULL;
+            }
+        }
+
+        graph_pool_free(cache->pool);
+        cache->pool = pool;
+        if (cache->executor) {
+            cache->executor->pool = pool;
+        }
+    }
+
+    char response[64];
+    snprintf(response, sizeof(response), "{\"threads\":%d}", graph_pool_size(cache->pool));
+    sqlite3_result_text(context, response, -1, SQLITE_TRANSIENT);
+}
+
+/* gql_import(nodes_file, edges_file [, options_json]) - Bulk load CSV / JSONL files */
+static void gql_import_func(sqlite3_context *context, int argc, sqlite3_value **argv) {
+    if (argc < 2 || argc > 3) {
+        graphqlite_result_error(context, "gql_import() requires 2 or 3 arguments: (nodes_file, edges_file [, options_json])", GQL_ERR_VALIDATION);
+        return;
+    }
+
+    const char *nodes_path = (const char*)sqlite3_value_text(argv[0]);
+    const char *edges_path = (const char*)sqlite3_value_text(argv[1]);
+    const char *options = argc == 3 ? (const char*)sqlite3_value_text(argv[2]) : NULL;
+    if (!nodes_path && !edges_path) {
+        graphqlite_result_error(context, "gql_import() needs a nodes or edges file", GQL_ERR_VALIDATION);
+        return;
+    }
+
+    graph_import_stats stats;
+    char *error = NULL;
+    if (graph_import(sqlite3_context_db_handle(context), nodes_path, edges_path, options, &stats, &error) < 0) {
+        /* Paths and values in import errors may hold quotes or backslashes */
+        char message[512];
+        graphqlite_sanitize_error(message, sizeof(message), error ? error : "Import failed");
+        graphqlite_result_error(context, message, GQL_ERR_EXECUTION);
+        free(error);
+        return;
+    }
+
+    char response[256];
+    double rows = (double)(stats.nodes + stats.edges);
+    snprintf(response, sizeof(response),
+             "{\"status\":\"ok\",\"nodes\":%ld,\"edges\":%ld,\"properties\":%ld,"
+             "\"skipped\":%ld,\"seconds\":%.3f,\"rows_per_sec\":%.0f}",
+             stats.nodes, stats.edges, stats.properties, stats.skipped, stats.seconds,
+             stats.seconds > 0 ? rows / stats.seconds : rows);
+    sqlite3_result_text(context, response, -1, SQLITE_TRANSIENT);
+}
+
+/*
+ * gql_packed_properties(enable) - Keep (1) or drop (0) the packed per-entity
+ * property records that let RETURN n read a node's properties in one row
+ */
+static void gql_packed_properties_func(sqlite3_context *context, int argc, sqlite3_value **argv) {
+    (void)argc;
+
+    if (sqlite3_value_type(argv[0]) == SQLITE_NULL) {
+        graphqlite_result_error(context, "gql_packed_properties() requires 0 or 1", GQL_ERR_VALIDATION);
+        return;
+    }
+    bool enable = sqlite3_value_int(argv[0]) != 0;
+
+    cypher_schema_manager *schema = cypher_schema_create_manager(sqlite3_context_db_handle(context));
+    if (!schema) {
+        graphqlite_result_error(context, "Out of memory", GQL_ERR_INTERNAL);
+        return;
+    }
+    int rc = cypher_schema_set_packed_properties(schema, enable);
+    cypher_schema_free_manager(schema);
+
+    if (rc < 0) {
+        graphqlite_result_error(context, "Failed to update packed property records", GQL_ERR_EXECUTION);
+        return;
+    }
+    sqlite3_result_text(context, enable ? "{\"status\":\"enabled\"}" : "{\"status\":\"disabled\"}",
+                        -1, SQLITE_STATIC);
+}
+
 /*
  * REGEXP function for SQLite
  * Implements the =~ operator from Cypher
@@ -679,6 +1303,10 @@ int sqlite3_graphqlite_init(
                          gql_load_graph_func, 0, 0);
   if (rc != SQLITE_OK) { free(cache); return rc; }
 
+  rc = sqlite3_create_function(db, "gql_load_graph", 1, SQLITE_UTF8, cache,
+                         gql_load_graph_func, 0, 0);
+  if (rc != SQLITE_OK) { free(cache); return rc; }
+
   rc = sqlite3_create_function(db, "gql_unload_graph", 0, SQLITE_UTF8, cache,
                          gql_unload_graph_func, 0, 0);
   if (rc != SQLITE_OK) { free(cache); return rc; }
@@ -687,10 +1315,41 @@ int sqlite3_graphqlite_init(
                          gql_reload_graph_func, 0, 0);
   if (rc != SQLITE_OK) { free(cache); return rc; }
 
+  rc = sqlite3_create_function(db, "gql_record_change", 3, SQLITE_UTF8, cache,
+                         gql_record_change_func, 0, 0);
+  if (rc != SQLITE_OK) { free(cache); return rc; }
+
   rc = sqlite3_create_function(db, "gql_graph_loaded", 0, SQLITE_UTF8, cache,
                          gql_graph_loaded_func, 0, 0);
   if (rc != SQLITE_OK) { free(cache); return rc; }
 
+  rc = sqlite3_create_function(db, "gql_project", 2, SQLITE_UTF8, cache,
+                         gql_project_func, 0, 0);
+  if (rc != SQLITE_OK) { free(cache); return rc; }
+
+  rc = sqlite3_create_function(db, "gql_drop_projection", 1, SQLITE_UTF8, cache,
+                         gql_drop_projection_func, 0, 0);
+  if (rc != SQLITE_OK) { free(cache); return rc; }
+
+  rc = sqlite3_create_function(db, "gql_graph_threads", 0, SQLITE_UTF8, cache,
+                         gql_graph_threads_func, 0, 0);
+  if (rc != SQLITE_OK) { free(cache); return rc; }
+
+  rc = sqlite3_create_function(db, "gql_graph_threads", 1, SQLITE_UTF8, cache,
+                         gql_graph_threads_func, 0, 0);
+  if (rc != SQLITE_OK) { free(cache); return rc; }
+
+  rc = sqlite3_create_function(db, "gql_import", -1, SQLITE_UTF8, 0,
+                         gql_import_func, 0, 0);
+  if (rc != SQLITE_OK) { free(cache); return rc; }
+
+  rc = sqlite3_create_function(db, "gql_packed_properties", 1, SQLITE_UTF8, 0,
+                         gql_packed_properties_func, 0, 0);
+  if (rc != SQLITE_OK) { free(cache); return rc; }
+
+  rc = sqlite3_create_module(db, "cypher_rows", &cypher_rows_module, cache);
+  if (rc != SQLITE_OK) { free(cache); return rc; }
+
   /* Create schema during initialization */
   create_schema(db);
 
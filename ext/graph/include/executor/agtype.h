@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "graphqlite_sqlite.h"
+#include "executor/json_builder.h"
 
 /* AGType value types - simplified from Apache AGE */
 typedef enum agtype_value_type
@@ -113,5 +114,6 @@ agtype_value* agtype_build_path(agtype_value **path_elements, int num_elements);
 
 void agtype_value_free(agtype_value *val);
 char* agtype_value_to_string(agtype_value *val);
+void agtype_value_write(json_builder *jb, agtype_value *val);
 
 #endif /* AGTYPE_H */
\ No newline at end of file
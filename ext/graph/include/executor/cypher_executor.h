@@ -36,8 +36,37 @@ typedef struct cypher_result {
     int properties_set;
 } cypher_result;
 
-/* Forward declaration for CSR graph (defined in graph_algorithms.h) */
+/* Forward declarations for CSR graphs (defined in graph_algorithms.h) */
 struct csr_graph;
+struct graph_projection;
+struct graph_pool;
+
+/* Forward declarations for the query plan cache (defined in plan_cache.h) */
+struct cypher_plan_cache;
+struct cypher_plan;
+
+/* How a streamed column's SQL value maps back to a Cypher value */
+typedef enum {
+    CYPHER_COLUMN_VALUE,     /* plain SQL value */
+    CYPHER_COLUMN_PROPERTY,  /* property text, typed the way agtype results are */
+    CYPHER_COLUMN_NODE,      /* node JSON object (or node id) */
+    CYPHER_COLUMN_EDGE       /* edge JSON object (or edge id) */
+} cypher_column_kind;
+
+/*
+ * Row cursor over a query result. A read-only query whose rows come from
+ * one generated statement is streamed: the cursor owns the live statement
+ * and steps it on demand. Any other query (writes, procedure calls, path
+ * results) runs to completion when opened and the cursor walks the
+ * materialized result.
+ */
+typedef struct cypher_cursor {
+    cypher_executor *executor;
+    cypher_result *result;       /* column names and errors; the rows unless streaming */
+    sqlite3_stmt *stmt;          /* live result statement when streaming */
+    cypher_column_kind *kinds;   /* per-column kinds when streaming */
+    int row;                     /* current row, -1 before the first */
+} cypher_cursor;
 
 /* Execution engine - coordinates parser, transformer, and schema manager */
 struct cypher_executor {
@@ -46,6 +75,11 @@ struct cypher_executor {
     bool schema_initialized;
     const char *params_json;  /* Current query parameters (NULL if no params) */
     struct csr_graph *cached_graph;  /* Cached graph for algorithm acceleration (managed by connection) */
+    struct graph_projection *projections;  /* Named graph projections (managed by connection) */
+    struct graph_pool *pool;               /* Worker threads for graph kernels, NULL = serial (managed by connection) */
+    struct cypher_plan_cache *plan_cache;  /* Parsed queries and generated SQL by query text (NULL if disabled) */
+    struct cypher_plan *active_plan;       /* Plan of the query currently executing (NULL if uncached) */
+    cypher_cursor *stream;                 /* Cursor being opened; takes over the result statement */
 };
 
 /* Executor lifecycle */
@@ -58,6 +92,15 @@ cypher_result* cypher_executor_execute_params(cypher_executor *executor, const c
 cypher_result* cypher_executor_execute_ast(cypher_executor *executor, ast_node *ast);
 cypher_result* cypher_executor_execute_ast_params(cypher_executor *executor, ast_node *ast, const char *params_json);
 
+/* Cursor execution: open returns NULL only when out of memory; check
+ * cursor->result->success. next returns 1 for a row, 0 at the end and -1
+ * on error (message in cursor->result->error_message). */
+cypher_cursor* cypher_executor_open_cursor(cypher_executor *executor, const char *query, const char *params_json);
+int cypher_cursor_next(cypher_cursor *cursor);
+void cypher_cursor_column_value(cypher_cursor *cursor, int col, sqlite3_context *context);
+char* cypher_cursor_column_json(cypher_cursor *cursor, int col);
+void cypher_cursor_close(cypher_cursor *cursor);
+
 /* Result management */
 void cypher_result_free(cypher_result *result);
 void cypher_result_print(cypher_result *result);
@@ -52,11 +52,62 @@ static inline void property_value_free(property_value *pv) {
     }
 }
 
-/* Schema manager - handles DDL and property key caching */
+/*
+ * Cached write statements.
+ *
+ * Per-type statements are laid out PROP_TYPE_* apart so the statement for
+ * a value is base + type.
+ */
+typedef enum schema_stmt_kind {
+    SCHEMA_STMT_KEY_LOOKUP,
+    SCHEMA_STMT_KEY_INSERT,
+    SCHEMA_STMT_NODE_INSERT,
+    SCHEMA_STMT_NODE_DELETE,
+    SCHEMA_STMT_LABEL_INSERT,
+    SCHEMA_STMT_LABEL_DELETE,
+    SCHEMA_STMT_LABEL_EXISTS,
+    SCHEMA_STMT_EDGE_INSERT,
+    SCHEMA_STMT_EDGE_DELETE,
+    SCHEMA_STMT_CATALOG_VERSION,
+
+    /* Which typed tables hold a (node, key) / (edge, key) */
+    SCHEMA_STMT_NODE_PROP_TYPES,
+    SCHEMA_STMT_EDGE_PROP_TYPES,
+
+    /* Indexed by property_type */
+    SCHEMA_STMT_NODE_PROP_SET,
+    SCHEMA_STMT_NODE_PROP_DELETE = SCHEMA_STMT_NODE_PROP_SET + 5,
+    SCHEMA_STMT_NODE_PROP_CLEAR = SCHEMA_STMT_NODE_PROP_DELETE + 5,
+    SCHEMA_STMT_EDGE_PROP_SET = SCHEMA_STMT_NODE_PROP_CLEAR + 5,
+    SCHEMA_STMT_EDGE_PROP_DELETE = SCHEMA_STMT_EDGE_PROP_SET + 5,
+    SCHEMA_STMT_EDGE_PROP_CLEAR = SCHEMA_STMT_EDGE_PROP_DELETE + 5,
+
+    SCHEMA_STMT_COUNT = SCHEMA_STMT_EDGE_PROP_CLEAR + 5
+} schema_stmt_kind;
+
+/* Schema manager - handles DDL, property key caching and write statements */
 typedef struct cypher_schema_manager {
     sqlite3 *db;
     property_key_cache *key_cache;
     bool schema_initialized;
+
+    /* Prepared on first use, finalized by cypher_schema_release_statements */
+    sqlite3_stmt *stmts[SCHEMA_STMT_COUNT];
+    long stmt_prepares;
+    long stmt_reuses;
+
+    /* Property type catalog (see cypher_schema_catalog_generation) */
+    bool catalog_available;         /* property_key_types and its triggers exist */
+    bool catalog_checked;           /* Version compared during the current query */
+    bool catalog_loaded;            /* key_types reflects catalog_version */
+    sqlite3_int64 catalog_version;
+    long catalog_generation;
+    uint16_t *key_types;            /* By key_id: node type mask | edge type mask << 8 */
+    int key_types_size;
+
+    /* Packed property records (see cypher_schema_packed_properties) */
+    bool packed_checked;            /* packed_enabled reflects catalog_version */
+    bool packed_enabled;
 } cypher_schema_manager;
 
 /* Property key cache entry */
@@ -85,10 +136,26 @@ struct property_key_cache {
 cypher_schema_manager* cypher_schema_create_manager(sqlite3 *db);
 void cypher_schema_free_manager(cypher_schema_manager *manager);
 
+/*
+ * Finalize cached write statements. Open statements make sqlite3_close()
+ * fail with SQLITE_BUSY, so the executor calls this at the end of every
+ * top-level query; statements are reused within one query (UNWIND, bulk
+ * CREATE/SET) and re-prepared by the next.
+ */
+void cypher_schema_release_statements(cypher_schema_manager *manager);
+
+/*
+ * End of a top-level query: record the catalog version the query left
+ * behind, then release statements.
+ */
+void cypher_schema_end_query(cypher_schema_manager *manager);
+
 /* Schema operations */
 int cypher_schema_initialize(cypher_schema_manager *manager);
 int cypher_schema_create_tables(cypher_schema_manager *manager);
 int cypher_schema_create_indexes(cypher_schema_manager *manager);
+/* Drop the secondary indexes create_indexes() builds (bulk loads rebuild them afterwards) */
+int cypher_schema_drop_indexes(cypher_schema_manager *manager);
 bool cypher_schema_is_initialized(cypher_schema_manager *manager);
 
 /* Property key management */
@@ -96,6 +163,58 @@ int cypher_schema_get_property_key_id(cypher_schema_manager *manager, const char
 int cypher_schema_ensure_property_key(cypher_schema_manager *manager, const char *key);
 const char* cypher_schema_get_property_key_name(cypher_schema_manager *manager, int key_id);
 
+/*
+ * Property type catalog.
+ *
+ * property_key_types lists the typed tables each key has values in, for
+ * nodes and edges separately. Triggers on the property tables keep it
+ * current for every writer (schema manager, generated SET SQL, bulk
+ * loads); a new entry or a new property key stamps property_catalog with a
+ * random version, so ROLLBACK and ROLLBACK TO read as changes as well.
+ * Types are only added, never removed, so the catalog may over-report.
+ *
+ * cypher_schema_catalog_generation() re-reads the version and returns a
+ * counter that moves whenever cached key ids or types may be stale; SQL
+ * built from them stays valid while it is unchanged.
+ * cypher_schema_property_types() returns a mask of (1 << property_type),
+ * or -1 if the catalog is unavailable.
+ */
+long cypher_schema_catalog_generation(cypher_schema_manager *manager);
+int cypher_schema_property_types(cypher_schema_manager *manager, int key_id, bool is_edge);
+
+/*
+ * Call after a ROLLBACK TO within a query. Keys created since the last
+ * version check are gone although the version reads as unchanged, so
+ * cached keys and types are dropped and the generation moves on.
+ */
+void cypher_schema_discard_cached(cypher_schema_manager *manager);
+
+/*
+ * Packed property records (opt-in).
+ *
+ * node_props_packed / edge_props_packed hold each entity's whole property
+ * map as one JSON object, so returning a node or edge reads one row
+ * instead of probing every typed table per key. The typed tables remain
+ * the source of truth and keep serving filters and indexes; triggers on
+ * them patch an entity's record on every write, so its keys follow write
+ * order (key id order after a bulk load). Entities without properties
+ * have no record.
+ *
+ * Turning records on or off stamps the catalog version, so cached SQL in
+ * every connection is regenerated. cypher_schema_packed_properties()
+ * tells whether the database currently keeps them.
+ */
+int cypher_schema_set_packed_properties(cypher_schema_manager *manager, bool enable);
+bool cypher_schema_packed_properties(cypher_schema_manager *manager);
+
+/*
+ * Bulk loads: drop the per-row catalog and packed record triggers, and
+ * afterwards restore them, adding the loaded tables' types and records in
+ * one pass. No-ops on databases without a catalog.
+ */
+int cypher_schema_suspend_catalog(cypher_schema_manager *manager);
+int cypher_schema_resume_catalog(cypher_schema_manager *manager);
+
 /* Property operations */
 int cypher_schema_set_node_property(cypher_schema_manager *manager, 
                                    int node_id, const char *key, 
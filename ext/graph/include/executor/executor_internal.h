@@ -112,6 +112,8 @@ int execute_set_items(cypher_executor *executor, ast_list *items, variable_map *
 
 /* MATCH-based query execution functions */
 int execute_match_return_query(cypher_executor *executor, cypher_match *match, cypher_return *return_clause, cypher_result *result);
+int execute_match_return_query_plan(cypher_executor *executor, cypher_match *match, cypher_return *return_clause,
+                                    cypher_result *result, struct cypher_plan *plan);
 int execute_match_create_query(cypher_executor *executor, cypher_match *match, cypher_create *create, cypher_result *result);
 int execute_multi_match_create_query(cypher_executor *executor, cypher_query *query, cypher_create *create, cypher_result *result);
 int execute_multi_match_create_query_with_varmap(cypher_executor *executor, cypher_query *query, cypher_create *create, cypher_result *result, variable_map **out_var_map);
@@ -137,6 +139,37 @@ int find_edge_by_pattern(cypher_executor *executor, int source_id, int target_id
 int delete_edge_by_id(cypher_executor *executor, int64_t edge_id);
 int delete_node_by_id(cypher_executor *executor, int64_t node_id, bool detach);
 
+/* Batched UNWIND ... CREATE / MERGE of standalone nodes (executor_bulk.c) */
+bool bulk_unwind_supported(cypher_query *query, cypher_unwind *unwind, ast_node *clause);
+int execute_unwind_bulk(cypher_executor *executor, cypher_unwind *unwind,
+                        ast_node *clause, cypher_result *result);
+
+/* One property value; text is borrowed, not owned */
+typedef struct {
+    bool is_null;
+    property_type type;
+    int64_t integer;        /* INTEGER, BOOLEAN */
+    double real;            /* REAL */
+    const char *text;       /* TEXT, JSON */
+} bulk_value;
+
+/*
+ * Buffered multi-row writer for nodes, labels, edges and typed properties
+ * (executor_bulk.c). Callers assign ids themselves, starting from
+ * bulk_reserve_ids(); rows are flushed in dependency order.
+ */
+typedef struct bulk_writer bulk_writer;
+
+bulk_writer *bulk_writer_create(sqlite3 *db);
+void bulk_writer_free(bulk_writer *bw);
+int bulk_writer_flush(bulk_writer *bw);
+int bulk_reserve_ids(sqlite3 *db, bool edges, int *next_id);
+int bulk_write_node(bulk_writer *bw, int node_id);
+int bulk_write_label(bulk_writer *bw, int node_id, const char *label);
+int bulk_write_edge(bulk_writer *bw, int edge_id, int source_id, int target_id, const char *type);
+int bulk_write_property(bulk_writer *bw, bool is_edge, int owner_id, int key_id, const bulk_value *v);
+void bulk_value_from_json(sqlite3_stmt *stmt, int col, const char *json_type, bulk_value *out);
+
 /* Path and CREATE functions */
 int execute_path_pattern_with_variables(cypher_executor *executor, cypher_path *path,
                                        cypher_result *result, variable_map *var_map);
@@ -148,6 +181,9 @@ char* serialize_ast_to_json(ast_node *expr);
 int build_query_results(cypher_executor *executor, sqlite3_stmt *stmt, cypher_return *return_clause,
                         cypher_result *result, cypher_transform_context *ctx);
 agtype_value* create_property_agtype_value(const char* value);
+agtype_value* result_vertex_value(cypher_executor *executor, const char *value);
+agtype_value* result_edge_value(cypher_executor *executor, const char *value);
+void release_result_statement(cypher_executor *executor, sqlite3_stmt *stmt);
 agtype_value* build_path_from_ids(cypher_executor *executor, cypher_transform_context *ctx,
                                   const char *path_name, const char *json_ids);
 
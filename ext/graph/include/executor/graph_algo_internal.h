@@ -26,11 +26,106 @@ static inline int hash_int(int key, int size)
     return (int)(h % (unsigned int)size);
 }
 
-/* Find internal node index by user-defined ID property */
-static inline int find_node_by_user_id(csr_graph *graph, const char *user_id)
+/* FNV-1a hash for user id strings */
+static inline unsigned int hash_string(const char *key)
+{
+    unsigned int h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)key; *p; p++) {
+        h = (h ^ *p) * 16777619u;
+    }
+    return h;
+}
+
+/* Find internal node index by original node ID (rowid), -1 if absent */
+static inline int csr_find_node(const csr_graph *graph, int node_id)
+{
+    int h = hash_int(node_id, graph->node_idx_size);
+    while (graph->node_idx[h] != -1) {
+        int idx = graph->node_idx[h];
+        if (graph->node_ids[idx] == node_id) {
+            return idx;
+        }
+        h = (h + 1) % graph->node_idx_size;
+    }
+    return -1;
+}
+
+/* Row sources for csr_graph_build(); each query binds src->bind as ?1 */
+typedef struct {
+    const char *node_sql;     /* Node ids, ascending */
+    const char *count_sql;    /* source_id, target_id of every edge */
+    const char *edge_sql;     /* Same rows: source_id, target_id, id[, type, weight] */
+    const char *bind;
+    bool incremental;         /* Keep edge ids; an empty graph is still returned */
+    bool projection;          /* Keep edge types */
+    bool weighted;            /* Keep edge weights (projections only) */
+} csr_source;
+
+csr_graph* csr_graph_build(sqlite3 *db, const csr_source *src);
+
+/* CSR construction helpers shared by the loader and incremental sync */
+int csr_index_nodes(csr_graph *graph);
+void csr_load_user_ids(sqlite3 *db, csr_graph *graph);
+int csr_index_user_ids(csr_graph *graph);
+
+/* Parallel kernels (graph_pool.c). Threads need pthreads and the GCC
+ * __atomic builtins used by the lock-free union-find. */
+#ifndef GRAPH_POOL_THREADS
+#ifdef _WIN32
+#define GRAPH_POOL_THREADS 0
+#else
+#define GRAPH_POOL_THREADS 1
+#endif
+#endif
+
+/* Nodes plus edges below which a kernel runs as a single part */
+#define GRAPH_POOL_MIN_WORK 65536
+
+typedef void (*graph_pool_fn)(void *arg, int part);
+
+void graph_pool_run(graph_pool *pool, int parts, graph_pool_fn fn, void *arg);
+int graph_pool_parts(const graph_pool *pool, const csr_graph *graph);
+void graph_partition_rows(const int *offsets, int n, int parts, int *bounds);
+
+/* Sources per accumulation chunk in graph_pool_sum_sources() */
+#define GRAPH_SOURCE_CHUNK 32
+
+/* Adds the contribution of one source to acc (and its square to acc_sq when not NULL) */
+typedef void (*graph_source_fn)(void *arg, int part, int source, double *acc, double *acc_sq);
+
+int graph_pool_source_parts(const graph_pool *pool, const csr_graph *graph, int count);
+int graph_pool_sum_sources(graph_pool *pool, int parts, int n, const int *sources, int count,
+                           graph_source_fn fn, void *arg, double *sum, double *sum_sq);
+int* graph_sample_sources(int n, int k, unsigned int seed);
+/* Scale pivot sums to estimates; sum_sq becomes each estimate's standard error */
+void graph_sample_scale(int n, int k, double *sum, double *sum_sq);
+
+/* Change log for incremental graphs (graph_delta.c) */
+struct csr_delta* csr_delta_create(sqlite3 *db);
+void csr_delta_free(struct csr_delta *delta);
+
+/* Reference drop for snapshot graphs (graph_snapshot.c) */
+void csr_snapshot_release(struct csr_snapshot *snap);
+
+/* Find internal node index by user-defined ID property; the first node wins on duplicates */
+static inline int find_node_by_user_id(const csr_graph *graph, const char *user_id)
 {
     if (!graph->user_ids || !user_id) return -1;
 
+    if (graph->user_idx) {
+        unsigned int mask = (unsigned int)graph->user_idx_size - 1;
+        unsigned int h = hash_string(user_id) & mask;
+        while (graph->user_idx[h] != -1) {
+            int idx = graph->user_idx[h];
+            if (strcmp(graph->user_ids[idx], user_id) == 0) {
+                return idx;
+            }
+            h = (h + 1) & mask;
+        }
+        return -1;
+    }
+
+    /* No index (allocation failed): scan */
     for (int i = 0; i < graph->node_count; i++) {
         if (graph->user_ids[i] && strcmp(graph->user_ids[i], user_id) == 0) {
             return i;
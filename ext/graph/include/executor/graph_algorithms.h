@@ -26,10 +26,25 @@ typedef struct csr_graph {
     char **user_ids;      /* Size: node_count. Maps internal index -> user-defined 'id' property */
     int *node_idx;        /* Hash table: original node ID -> internal index (for reverse lookup) */
     int node_idx_size;    /* Size of node_idx hash table */
+    int *user_idx;        /* Hash table: user 'id' property -> internal index (-1 = empty slot) */
+    int user_idx_size;    /* Size of user_idx (power of two, 0 = no index) */
 
     /* For algorithms needing incoming edges (like PageRank) */
     int *in_row_ptr;      /* Size: node_count + 1. Incoming edge offsets */
     int *in_col_idx;      /* Size: edge_count. Source node IDs for incoming edges */
+
+    /* Projections (only set by csr_graph_load_projection) */
+    int *edge_types;      /* Size: edge_count. Index into type_names for each col_idx entry */
+    double *weights;      /* Size: edge_count. Weight of each col_idx entry */
+    char **type_names;    /* Size: type_count. Relationship types seen in the projection */
+    int type_count;
+
+    /* Incremental maintenance (only set by csr_graph_load_incremental) */
+    int *edge_ids;        /* Size: edge_count. Edge rowid for each col_idx entry */
+    struct csr_delta *delta;  /* Rowids touched since the last sync */
+
+    /* Set when the arrays live in a mapped snapshot shared across connections */
+    struct csr_snapshot *snapshot;
 } csr_graph;
 
 /* Graph algorithm result */
@@ -43,6 +58,56 @@ typedef struct {
 csr_graph* csr_graph_load(sqlite3 *db);
 void csr_graph_free(csr_graph *graph);
 
+/*
+ * Incremental maintenance. The graph records which node, edge and 'id'
+ * property rows changed (fed from temp triggers) and csr_graph_sync()
+ * folds them into the CSR arrays in place before an algorithm runs,
+ * falling back to a full rebuild when the log outgrows the graph or
+ * another connection has committed since the last sync.
+ */
+csr_graph* csr_graph_load_incremental(sqlite3 *db);
+void csr_graph_record_change(csr_graph *graph, int op, const char *table, sqlite3_int64 rowid);
+int csr_graph_sync(sqlite3 *db, csr_graph *graph);
+int csr_graph_pending_changes(const csr_graph *graph);
+
+/*
+ * Persisted snapshots. csr_graph_save_snapshot() builds the graph and
+ * writes it to a sidecar file tagged in the graph_snapshot table;
+ * csr_graph_open_snapshot() maps that file while the tag still matches.
+ * Snapshot graphs are read-only and shared: csr_graph_free() drops one
+ * reference.
+ */
+csr_graph* csr_graph_open_snapshot(sqlite3 *db);
+csr_graph* csr_graph_save_snapshot(sqlite3 *db, bool *saved);
+
+/*
+ * Named projections: subgraphs restricted to some node labels and edge
+ * types, optionally carrying an edge weight property, that algorithms
+ * select with a trailing {graph: 'name'} argument.
+ */
+typedef struct graph_projection {
+    char *name;
+    csr_graph *graph;
+    struct graph_projection *next;
+} graph_projection;
+
+csr_graph* csr_graph_load_projection(sqlite3 *db, const char *options_json, char **error);
+graph_projection* graph_projection_find(graph_projection *list, const char *name);
+int graph_projection_put(graph_projection **list, const char *name, csr_graph *graph);
+bool graph_projection_drop(graph_projection **list, const char *name);
+void graph_projections_free(graph_projection *list);
+
+/*
+ * Worker pool for the whole-graph kernels (PageRank, label propagation,
+ * WCC, eigenvector centrality). One per connection, sized with
+ * gql_graph_threads(); a NULL pool runs everything on the calling thread.
+ */
+typedef struct graph_pool graph_pool;
+
+graph_pool* graph_pool_create(int threads);
+void graph_pool_free(graph_pool *pool);
+int graph_pool_size(const graph_pool *pool);
+
 /* Algorithm detection - check if a RETURN clause contains a graph algorithm function */
 typedef enum {
     GRAPH_ALGO_NONE = 0,
@@ -79,6 +144,9 @@ typedef struct {
     int max_depth;        /* For BFS/DFS - max traversal depth (-1 = unlimited) */
     double threshold;     /* For Node Similarity - minimum similarity threshold (default 0.0) */
     int k;                /* For KNN - number of neighbors to return */
+    int samples;          /* For betweenness/closeness - pivot sources to sample (0 = exact) */
+    int seed;             /* For betweenness/closeness - pivot sampling seed */
+    char *graph_name;     /* Named projection to run on (NULL = whole graph) */
 } graph_algo_params;
 
 /* Check if RETURN clause contains a graph algorithm call and extract parameters */
@@ -88,15 +156,17 @@ graph_algo_params detect_graph_algorithm(cypher_return *return_clause, const cha
  * All algorithms accept an optional cached CSR graph parameter.
  * If cached is non-NULL, uses it directly (fast path).
  * If cached is NULL, loads graph from SQLite (original behavior).
+ * Kernels that take a pool split their loops across its threads; results
+ * are the same for any pool size.
  */
-graph_algo_result* execute_pagerank(sqlite3 *db, csr_graph *cached, double damping, int iterations, int top_k);
-graph_algo_result* execute_label_propagation(sqlite3 *db, csr_graph *cached, int iterations);
+graph_algo_result* execute_pagerank(sqlite3 *db, csr_graph *cached, graph_pool *pool, double damping, int iterations, int top_k);
+graph_algo_result* execute_label_propagation(sqlite3 *db, csr_graph *cached, graph_pool *pool, int iterations);
 graph_algo_result* execute_dijkstra(sqlite3 *db, csr_graph *cached, const char *source_id, const char *target_id, const char *weight_prop);
 graph_algo_result* execute_degree_centrality(sqlite3 *db, csr_graph *cached);
-graph_algo_result* execute_wcc(sqlite3 *db, csr_graph *cached);
+graph_algo_result* execute_wcc(sqlite3 *db, csr_graph *cached, graph_pool *pool);
 graph_algo_result* execute_scc(sqlite3 *db, csr_graph *cached);
-graph_algo_result* execute_betweenness_centrality(sqlite3 *db, csr_graph *cached);
-graph_algo_result* execute_closeness_centrality(sqlite3 *db, csr_graph *cached);
+graph_algo_result* execute_betweenness_centrality(sqlite3 *db, csr_graph *cached, graph_pool *pool, int samples, int seed);
+graph_algo_result* execute_closeness_centrality(sqlite3 *db, csr_graph *cached, graph_pool *pool, int samples, int seed);
 graph_algo_result* execute_louvain(sqlite3 *db, csr_graph *cached, double resolution);
 graph_algo_result* execute_triangle_count(sqlite3 *db, csr_graph *cached);
 graph_algo_result* execute_astar(sqlite3 *db, csr_graph *cached, const char *source_id, const char *target_id,
@@ -105,7 +175,7 @@ graph_algo_result* execute_bfs(sqlite3 *db, csr_graph *cached, const char *start
 graph_algo_result* execute_dfs(sqlite3 *db, csr_graph *cached, const char *start_id, int max_depth);
 graph_algo_result* execute_node_similarity(sqlite3 *db, csr_graph *cached, const char *node1_id, const char *node2_id, double threshold, int top_k);
 graph_algo_result* execute_knn(sqlite3 *db, csr_graph *cached, const char *node_id, int k);
-graph_algo_result* execute_eigenvector_centrality(sqlite3 *db, csr_graph *cached, int iterations);
+graph_algo_result* execute_eigenvector_centrality(sqlite3 *db, csr_graph *cached, graph_pool *pool, int iterations);
 graph_algo_result* execute_apsp(sqlite3 *db, csr_graph *cached);
 
 /* Result management */
@@ -0,0 +1,67 @@
+#ifndef GRAPH_IMPORT_H
+#define GRAPH_IMPORT_H
+
+#include "graphqlite_sqlite.h"
+
+/*
+ * Bulk graph import from CSV / JSONL files
+ *
+ *   SELECT gql_import('people.csv', 'knows.csv');
+ *   SELECT gql_import('people.jsonl', NULL, '{"label": "Person"}');
+ *
+ * Files are streamed in large blocks and written straight to the graph
+ * tables as multi-row INSERTs (the executor_bulk.c writer), bypassing the
+ * Cypher layer. Either path may be NULL to load only nodes or only edges.
+ *
+ * CSV files need a header row. Columns are matched by name or by
+ * neo4j-admin style suffixes:
+ *
+ *   nodes   id / :ID          external id, used by edges and kept as a property
+ *           label(s) / :LABEL labels, ';'-separated
+ *   edges   source / :START_ID, target / :END_ID, type / :TYPE
+ *   both    name:int|float|boolean|string|json   typed property
+ *           name:IGNORE                          skipped column
+ *
+ * Other columns become properties. Untyped values are inferred (integer,
+ * real, true/false, else text); empty fields are skipped.
+ *
+ * JSONL files hold one object per line. Nodes use "id", "label" (string)
+ * or "labels" (array) and edges "source", "target", "type"; properties go
+ * in a nested "properties" object or as the remaining top-level keys.
+ *
+ * Options (JSON object, all optional):
+ *   format          "csv" or "jsonl" (default: from the file extension)
+ *   delimiter       CSV field separator (default ",", tab for .tsv)
+ *   id_column, label_column, source_column, target_column, type_column
+ *   label           label for nodes without one
+ *   type            relationship type for edges without one
+ *   infer_types     false to load untyped CSV values as text
+ *   defer_indexes   drop secondary indexes and property catalog triggers
+ *                   during the load and rebuild them afterwards (default:
+ *                   true when the graph starts empty)
+ *   commit_rows     commit every N rows (default 0: one transaction);
+ *                   ignored inside an open transaction
+ *
+ * Edge endpoints resolve against the ids loaded from the nodes file, then
+ * against existing nodes' id property. Edges with unknown endpoints are
+ * counted as skipped. A loaded CSR graph (gql_load_graph) is not updated;
+ * reload it after importing.
+ */
+
+typedef struct {
+    long nodes;
+    long edges;
+    long properties;
+    long skipped;
+    double seconds;
+} graph_import_stats;
+
+/*
+ * Import nodes and/or edges. Returns 0 on success; on failure returns -1
+ * and sets *error to a malloc'd message. Within one transaction (the
+ * default) a failed import leaves the database unchanged.
+ */
+int graph_import(sqlite3 *db, const char *nodes_path, const char *edges_path,
+                 const char *options_json, graph_import_stats *stats, char **error);
+
+#endif /* GRAPH_IMPORT_H */
@@ -36,6 +36,10 @@ void jbuf_end_object(json_builder *jb);
 /* Add a raw string (no quoting) */
 void jbuf_append(json_builder *jb, const char *str);
 
+/* Add len bytes / a single character (no quoting) */
+void jbuf_append_len(json_builder *jb, const char *str, size_t len);
+void jbuf_append_char(json_builder *jb, char c);
+
 /* Add formatted content */
 void jbuf_appendf(json_builder *jb, const char *fmt, ...);
 
@@ -0,0 +1,160 @@
+/*
+ * plan_cache.h
+ *    Per-executor cache of parsed and prepared Cypher queries
+ *
+ * OVERVIEW
+ * --------
+ * Services tend to send the same parameterized query text over and over.
+ * The plan cache maps normalized query text to everything that does not
+ * depend on parameter values:
+ *
+ *   - the parsed AST (skips the scanner and bison parser)
+ *   - the clause flags and matched dispatch pattern
+ *   - the generated SQL and the transform context needed to build results
+ *
+ * Only queries whose handler runs generated SQL as-is are cached
+ * (MATCH+RETURN and the generic transform; see query_pattern_reuses_sql).
+ * Transforming mutates the AST (GQLITE-T-0092: inline property filters
+ * are consumed), so a cached AST is never transformed twice. A lookup
+ * only hits when the cached SQL prepares and binds; the run then uses
+ * that statement and leaves the AST alone. Anything else - a first run,
+ * SQL that was dropped, a write query - parses afresh.
+ *
+ * Statements are not kept across calls: an open statement makes
+ * sqlite3_close() fail with SQLITE_BUSY before the connection destructor
+ * can finalize it (see prepare_property_key_cache_statements).
+ *
+ * NORMALIZATION
+ * -------------
+ * Leading/trailing whitespace is dropped and runs of whitespace outside
+ * string literals and backquoted identifiers collapse to a single space.
+ * Case is preserved - labels, property keys and identifiers are case
+ * sensitive.
+ *
+ * INVALIDATION
+ * ------------
+ * Generated SQL depends only on the AST, and sqlite3_prepare_v2() resolves
+ * it against the current schema, so index and table changes are picked up
+ * automatically. If the cached SQL no longer prepares (a table it uses was
+ * dropped) the lookup misses and the entry is replaced by a fresh parse.
+ * SQL that embeds property key ids and types (plan_use_catalog) is
+ * regenerated the same way when the property type catalog changes.
+ * plan_cache_clear() drops everything; entries in use by a running query
+ * are unlinked and freed on release.
+ *
+ * SIZING
+ * ------
+ * GRAPHQLITE_PLAN_CACHE_SIZE sets the number of entries (default 128).
+ * Define it to 0 to disable the cache entirely.
+ */
+
+#ifndef PLAN_CACHE_H
+#define PLAN_CACHE_H
+
+#include "graphqlite_sqlite.h"
+#include <stdbool.h>
+
+#include "parser/cypher_parser.h"
+#include "transform/cypher_transform.h"
+#include "executor/query_patterns.h"
+#include "executor/cypher_schema.h"
+
+#ifndef GRAPHQLITE_PLAN_CACHE_SIZE
+#define GRAPHQLITE_PLAN_CACHE_SIZE 128
+#endif
+
+/* Cached plan for one normalized query text */
+typedef struct cypher_plan {
+    char *key;                      /* Normalized query text */
+    unsigned long hash;
+
+    cypher_parse_result *parse;     /* Owns the AST */
+    ast_list *clauses;              /* Top-level clause list at parse time */
+    clause_flags flags;             /* Dispatch decision */
+    const query_pattern *pattern;
+
+    /* Generated SQL for read patterns (NULL until first execution) */
+    char *sql;
+    cypher_transform_context *ctx;  /* Variable context for build_query_results */
+    sqlite3_stmt *stmt;             /* Prepared by lookup for the run that pinned it */
+
+    int in_use;                     /* Pinned by running queries */
+    bool stale;                     /* Unlinked - free when in_use drops to 0 */
+    long hits;
+
+    struct cypher_plan *lru_prev;   /* Most recently used at head */
+    struct cypher_plan *lru_next;
+    struct cypher_plan *hash_next;
+} cypher_plan;
+
+typedef struct cypher_plan_cache {
+    sqlite3 *db;
+    cypher_plan **slots;            /* Hash table slots */
+    int slot_count;
+    int capacity;                   /* Maximum entries */
+    int count;
+
+    cypher_plan *lru_head;
+    cypher_plan *lru_tail;
+
+    /* Statistics */
+    long hits;
+    long misses;
+    long evictions;
+    long invalidations;
+} cypher_plan_cache;
+
+/* Cache lifecycle */
+cypher_plan_cache* plan_cache_create(sqlite3 *db, int capacity);
+void plan_cache_free(cypher_plan_cache *cache);
+void plan_cache_clear(cypher_plan_cache *cache);
+
+/*
+ * Look up a query. Returns a pinned plan whose SQL is prepared with
+ * params_json bound (plan_take_stmt), or NULL on a miss.
+ */
+cypher_plan* plan_cache_lookup(cypher_plan_cache *cache, const char *query,
+                               const char *params_json);
+
+/*
+ * Take ownership of a successful parse result and cache it, replacing
+ * any plan for the same text. Returns a pinned plan, or NULL (parse
+ * result untouched) on failure or when the query's handler would not
+ * reuse generated SQL.
+ */
+cypher_plan* plan_cache_insert(cypher_plan_cache *cache, const char *query,
+                               cypher_parse_result *parse);
+
+/* Unpin a plan returned by lookup/insert */
+void plan_cache_release(cypher_plan_cache *cache, cypher_plan *plan);
+
+/*
+ * Plan for the query a pattern handler is running, or NULL if the handler
+ * was reached some other way (CALL rewrites, EXPLAIN, execute_ast callers).
+ */
+cypher_plan* plan_for_query(cypher_executor *executor, cypher_query *query);
+
+/*
+ * Cached SQL support for pattern handlers.
+ *
+ * plan_take_stmt() hands over the statement prepared by the lookup, or
+ * NULL if the plan was just inserted and the handler must transform.
+ * plan_store_sql() copies the generated SQL and takes ownership of the
+ * transform context; returns false if the plan already has one, in which
+ * case the caller keeps (and frees) the context.
+ */
+sqlite3_stmt* plan_take_stmt(cypher_plan *plan);
+bool plan_store_sql(cypher_plan *plan, const char *sql, cypher_transform_context *ctx);
+
+/*
+ * Let a transform resolve property keys and types up front instead of by
+ * name at run time (append_property_lookup). Only for SQL that runs
+ * without writing properties itself: the catalog is read once, here.
+ */
+void plan_use_catalog(cypher_transform_context *ctx, cypher_schema_manager *schema);
+
+/* Statistics */
+void plan_cache_stats(cypher_plan_cache *cache, long *hits, long *misses,
+                      long *evictions, long *invalidations);
+
+#endif /* PLAN_CACHE_H */
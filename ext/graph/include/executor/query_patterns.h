@@ -120,6 +120,13 @@ clause_flags analyze_query_clauses(cypher_query *query);
  */
 const query_pattern *find_matching_pattern(clause_flags present);
 
+/*
+ * True if the pattern's handler runs the SQL it generated on a later call
+ * without transforming the query again (plan cache). Read-only queries
+ * only: writes run in handlers that re-transform every time.
+ */
+bool query_pattern_reuses_sql(const query_pattern *pattern, clause_flags flags);
+
 /*
  * Get the pattern registry (for testing/debugging).
  * Returns pointer to static pattern array, terminated by NULL handler.
@@ -0,0 +1,39 @@
+#ifndef VARLEN_PATHS_H
+#define VARLEN_PATHS_H
+
+#include "graphqlite_sqlite.h"
+
+/*
+ * Variable-length path traversal
+ *
+ * gql_varlen_paths is an eponymous table-valued function that walks
+ * simple paths (no repeated nodes) out of each start node with an
+ * iterative DFS over the idx_edges_source / idx_edges_target indexes,
+ * streaming one row per path instead of materializing a recursive CTE.
+ *
+ *   SELECT * FROM gql_varlen_paths(types, direction, min_hops, max_hops)
+ *   WHERE start_id = ?
+ *
+ * Columns:
+ *   start_id   first node of the path
+ *   end_id     last node of the path
+ *   depth      number of relationships
+ *   path_ids   comma-separated node ids, start to end
+ *
+ * Arguments (hidden columns, all optional):
+ *   types      JSON array of relationship types, NULL for any
+ *   direction  1 = outgoing (default), -1 = incoming, 0 = both
+ *   min_hops   minimum depth to report (default 1)
+ *   max_hops   maximum depth to walk (default VARLEN_DEFAULT_MAX_HOPS)
+ *
+ * An equality constraint on start_id (typically the bound source node of
+ * a MATCH pattern) is used as the traversal root; without one every node
+ * is a start node.
+ */
+
+#define VARLEN_DEFAULT_MAX_HOPS 100
+
+/* Register the gql_varlen_paths module on a connection */
+int varlen_paths_register(sqlite3 *db);
+
+#endif /* VARLEN_PATHS_H */
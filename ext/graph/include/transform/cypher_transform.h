@@ -8,6 +8,7 @@
 
 /* Forward declarations */
 typedef struct cypher_transform_context cypher_transform_context;
+struct cypher_schema_manager;
 typedef struct cypher_query_result cypher_query_result;
 
 /* Path types for shortest path support */
@@ -70,6 +71,10 @@ struct cypher_transform_context {
 
     /* Unified SQL builder for clause-based SQL generation */
     sql_builder *unified_builder;
+
+    /* Property keys and types resolved at transform time (NULL: by name at run time) */
+    struct cypher_schema_manager *schema;
+    long catalog_generation;        /* Catalog state the SQL was generated against */
 };
 
 /* Result structure for executed queries */
@@ -147,10 +152,8 @@ int register_parameter(cypher_transform_context *ctx, const char *name);
 /* SQL builder finalization - assembles unified_builder into sql_buffer */
 int finalize_sql_generation(cypher_transform_context *ctx);
 
-/* Variable-length relationship SQL generation */
-int generate_varlen_cte(cypher_transform_context *ctx, cypher_rel_pattern *rel,
-                       const char *source_alias, const char *target_alias,
-                       const char *cte_name);
+/* Variable-length relationship traversal - returns gql_varlen_paths(...) call (caller frees) */
+char *generate_varlen_source(cypher_transform_context *ctx, cypher_rel_pattern *rel);
 void prepend_cte_to_sql(cypher_transform_context *ctx);
 
 /* Result management */
@@ -22,6 +22,21 @@ int transform_return_clause(cypher_transform_context *ctx, cypher_return *ret);
 int transform_with_clause(cypher_transform_context *ctx, cypher_with *with);
 int transform_unwind_clause(cypher_transform_context *ctx, cypher_unwind *unwind);
 
+/* Property value lookup for an entity id expression (alias + id_suffix) */
+typedef enum {
+    PROP_VALUE_NATIVE,      /* Comparisons: native types, booleans as 0/1 */
+    PROP_VALUE_TEXT,        /* RETURN: numbers as text, booleans as 'true'/'false' */
+    PROP_VALUE_JSON         /* Map projections: as TEXT, JSON values through json() */
+} prop_value_mode;
+
+void append_property_lookup(cypher_transform_context *ctx, bool is_edge, const char *gprefix,
+                            const char *alias, const char *id_suffix, const char *key,
+                            prop_value_mode mode);
+
+/* Whole-entity property map as a JSON object; returns a malloc'd expression */
+char *entity_properties_sql(cypher_transform_context *ctx, bool is_edge, const char *gprefix,
+                            const char *id_expr);
+
 /* Pending property joins for aggregation optimization */
 void add_pending_prop_join(cypher_transform_context *ctx, const char *join_sql);
 const char* get_pending_prop_joins(cypher_transform_context *ctx);
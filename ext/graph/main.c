@@ -10,6 +10,7 @@
 #include <sqlite3.h>
 
 #include "executor/cypher_executor.h"
+#include "executor/graph_import.h"
 #include "parser/cypher_debug.h"
 
 #define MAX_QUERY_LENGTH 65536
@@ -24,6 +25,11 @@ static void print_usage(const char *program_name)
     printf("  -h, --help     Show this help message\n");
     printf("  -v, --verbose  Enable verbose debug output\n");
     printf("  -i, --init     Initialize new database (will overwrite existing)\n");
+    printf("  --import NODES EDGES\n");
+    printf("                 Bulk load CSV/JSONL node and edge files, then exit\n");
+    printf("                 (use - to skip either file)\n");
+    printf("  --import-options JSON\n");
+    printf("                 Options for --import, see gql_import()\n");
     printf("\nArguments:\n");
     printf("  database_file  SQLite database file (default: %s)\n", DEFAULT_DB_PATH);
     printf("\nInteractive Commands:\n");
@@ -363,6 +369,9 @@ int main(int argc, char *argv[])
     const char *db_path = DEFAULT_DB_PATH;
     bool verbose = false;
     bool init_db = false;
+    const char *import_nodes = NULL;
+    const char *import_edges = NULL;
+    const char *import_options = NULL;
     
     /* Parse command line arguments */
     for (int i = 1; i < argc; i++) {
@@ -373,6 +382,11 @@ int main(int argc, char *argv[])
             verbose = true;
         } else if (strcmp(argv[i], "-i") == 0 || strcmp(argv[i], "--init") == 0) {
             init_db = true;
+        } else if (strcmp(argv[i], "--import") == 0 && i + 2 < argc) {
+            import_nodes = argv[++i];
+            import_edges = argv[++i];
+        } else if (strcmp(argv[i], "--import-options") == 0 && i + 1 < argc) {
+            import_options = argv[++i];
         } else if (argv[i][0] != '-') {
             /* Database file path */
             db_path = argv[i];
@@ -415,6 +429,25 @@ int main(int argc, char *argv[])
     
     printf("GraphQLite executor initialized\n");
 
+    if (import_nodes) {
+        graph_import_stats stats;
+        char *error = NULL;
+        rc = graph_import(db,
+                          strcmp(import_nodes, "-") == 0 ? NULL : import_nodes,
+                          strcmp(import_edges, "-") == 0 ? NULL : import_edges,
+                          import_options, &stats, &error);
+        if (rc == 0) {
+            printf("Imported %ld nodes, %ld edges, %ld properties (%ld edges skipped) in %.3fs\n",
+                   stats.nodes, stats.edges, stats.properties, stats.skipped, stats.seconds);
+        } else {
+            printf("Import failed: %s\n", error ? error : "unknown error");
+            free(error);
+        }
+        cypher_executor_free(executor);
+        sqlite3_close(db);
+        return rc == 0 ? 0 : 1;
+    }
+
     if (verbose) {
         printf("Debug mode enabled\n");
     }
@@ -76,13 +76,22 @@ EXECUTOR_SRCS = \
 	$(EXECUTOR_DIR)/executor_set.c \
 	$(EXECUTOR_DIR)/executor_remove.c \
 	$(EXECUTOR_DIR)/executor_create.c \
+	$(EXECUTOR_DIR)/executor_bulk.c \
+	$(EXECUTOR_DIR)/graph_import.c \
 	$(EXECUTOR_DIR)/executor_foreach.c \
 	$(EXECUTOR_DIR)/executor_merge.c \
 	$(EXECUTOR_DIR)/executor_match.c \
 	$(EXECUTOR_DIR)/query_dispatch.c \
+	$(EXECUTOR_DIR)/plan_cache.c \
+	$(EXECUTOR_DIR)/varlen_paths.c \
 	$(EXECUTOR_DIR)/agtype.c \
+	$(EXECUTOR_DIR)/agtype_parser.c \
 	$(EXECUTOR_DIR)/json_builder.c \
 	$(EXECUTOR_DIR)/graph_algorithms.c \
+	$(EXECUTOR_DIR)/graph_delta.c \
+	$(EXECUTOR_DIR)/graph_snapshot.c \
+	$(EXECUTOR_DIR)/graph_projection.c \
+	$(EXECUTOR_DIR)/graph_pool.c \
 	$(EXECUTOR_DIR)/graph_algo_pagerank.c \
 	$(EXECUTOR_DIR)/graph_algo_community.c \
 	$(EXECUTOR_DIR)/graph_algo_paths.c \
@@ -140,7 +149,7 @@ else ifneq (,$(findstring MINGW,$(UNAME_S)))
 else ifneq (,$(findstring MSYS,$(UNAME_S)))
 	$(CC) -shared -static $(EXTENSION_OBJ) $(GENERATED_OBJS_PIC) $(PARSER_OBJS_PIC) $(TRANSFORM_OBJS_PIC) $(EXECUTOR_OBJS_PIC) -o $@ -lsqlite3 -lsystre -ltre -lintl -liconv
 else
-	$(CC) -shared -fPIC $(EXTENSION_OBJ) $(GENERATED_OBJS_PIC) $(PARSER_OBJS_PIC) $(TRANSFORM_OBJS_PIC) $(EXECUTOR_OBJS_PIC) -o $@
+	$(CC) -shared -fPIC $(EXTENSION_OBJ) $(GENERATED_OBJS_PIC) $(PARSER_OBJS_PIC) $(TRANSFORM_OBJS_PIC) $(EXECUTOR_OBJS_PIC) -o $@ -lpthread
 endif
 
 # Main application object
@@ -196,5 +196,17 @@ describe("Relationship Operations", function()
       local results = helper.cypher_query(db, "MATCH (a)-[:KNOWS]->(b)-[:KNOWS]->(c) RETURN a.name, b.name, c.name")
       assert.is_not_nil(results)
     end)
+
+    it("should replace a relationship property set with a different type", function()
+      helper.cypher_exec(db, 'CREATE (a:Person {name: "Alice"})-[:KNOWS {since: 2020}]->(b:Person {name: "Bob"})')
+      helper.cypher_exec(db, 'MATCH ()-[r:KNOWS]->() SET r.since = "long ago"')
+      local results = helper.cypher_query(db, "MATCH ()-[r:KNOWS]->() RETURN r.since")
+      assert.is_truthy(tostring(results[1][1]):find("long ago", 1, true))
+      local count = 0
+      for row in db:nrows("SELECT (SELECT count(*) FROM edge_props_int) + (SELECT count(*) FROM edge_props_text) AS c") do
+        count = row.c
+      end
+      assert.are.equal(1, count)
+    end)
   end)
 end)
@@ -168,5 +168,64 @@ describe("Variable-Length Path Patterns", function()
       local results = helper.cypher_query(db, "MATCH (c:Node {name: \"C\"})-[*1..2]->(target) RETURN target.name ORDER BY target.name")
       assert.is_not_nil(results)
     end)
+
+    it("should not revisit nodes on a cycle", function()
+      helper.cypher_exec(db, 'MATCH (e:Node {name: "E"}), (a:Node {name: "A"}) CREATE (e)-[:NEXT]->(a)')
+      local results = helper.cypher_query(db, "MATCH (a:Node {name: \"A\"})-[:NEXT*]->(target) RETURN count(target) AS cnt")
+      assert.is_truthy(tostring(results[1][1]):find("4"))
+    end)
+
+    it("should walk through very large node ids", function()
+      db:exec("INSERT INTO nodes(id) VALUES (35184372088832)")
+      db:exec("INSERT INTO edges(source_id, target_id, type) " ..
+              "SELECT id, 35184372088832, 'NEXT' FROM nodes WHERE id = (SELECT min(id) FROM nodes)")
+      db:exec("INSERT INTO edges(source_id, target_id, type) " ..
+              "SELECT 35184372088832, id, 'NEXT' FROM nodes WHERE id = (SELECT min(id) FROM nodes)")
+      local results = helper.cypher_query(db, "MATCH (a:Node {name: \"A\"})-[*1..2]->(target) RETURN count(target) AS cnt")
+      assert.is_truthy(tostring(results[1][1]):find("3"))
+    end)
+  end)
+
+  -- =======================================================================
+  -- SECTION 7: gql_varlen_paths Table Function
+  -- =======================================================================
+  describe("gql_varlen_paths Table Function", function()
+    local function start_id(name)
+      for row in db:nrows(string.format(
+          "SELECT n.id AS id FROM nodes n JOIN node_props_text p ON p.node_id = n.id " ..
+          "JOIN property_keys k ON k.id = p.key_id WHERE k.key = 'name' AND p.value = '%s'", name)) do
+        return row.id
+      end
+    end
+
+    it("should stream paths from a bound start node", function()
+      local a = start_id("A")
+      local rows = {}
+      for row in db:nrows(string.format(
+          "SELECT depth, path_ids FROM gql_varlen_paths(NULL, 1, 1, 3) WHERE start_id = %d ORDER BY depth", a)) do
+        table.insert(rows, row)
+      end
+      assert.are.equal(3, #rows)
+      assert.are.equal(1, rows[1].depth)
+      assert.are.equal(3, #(rows[3].path_ids:gsub("[^,]", "")))
+    end)
+
+    it("should filter by relationship type", function()
+      local cnt = 0
+      for row in db:nrows("SELECT count(*) AS c FROM gql_varlen_paths('[\"PARENT_OF\"]', 1, 1, 5)") do
+        cnt = row.c
+      end
+      assert.are.equal(4, cnt)
+    end)
+
+    it("should walk incoming edges with direction -1", function()
+      local e = start_id("E")
+      local cnt = 0
+      for row in db:nrows(string.format(
+          "SELECT count(*) AS c FROM gql_varlen_paths(NULL, -1, 1, 10) WHERE start_id = %d", e)) do
+        cnt = row.c
+      end
+      assert.are.equal(4, cnt)
+    end)
   end)
 end)
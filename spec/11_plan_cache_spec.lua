@@ -0,0 +1,105 @@
+-- ========================================================================
+-- Test 11: Query Plan Cache
+-- ========================================================================
+-- PURPOSE: Repeated query text must give the same answers as a fresh parse
+-- COVERS:  parameter rebinding, whitespace normalization, cached RETURN *,
+--          writes through cached plans, schema changes between calls,
+--          repeated MATCH...CREATE and MATCH...DELETE
+-- ========================================================================
+
+local sqlite3 = require("lsqlite3")
+local helper = require("spec.helper")
+
+-- 执行带参数的查询并返回 JSON 字符串
+describe("Query Plan Cache", function()
+  local db
+
+  before_each(function()
+    db = sqlite3.open_memory()
+    assert.is_not_nil(db, "Failed to open database")
+    helper.ensure_graphqlite(db)
+    helper.cypher_exec(db, 'CREATE (a:Person {name: "Alice", age: 30})-[:KNOWS]->(b:Person {name: "Bob", age: 40})')
+  end)
+
+  after_each(function()
+    if db then
+      db:close()
+      db = nil
+    end
+  end)
+
+  describe("Parameter rebinding", function()
+    it("should rebind parameters on repeated MATCH+RETURN", function()
+      local q = "MATCH (n:Person) WHERE n.age > $a RETURN n.name"
+      local r1 = helper.cypher_params(db, q, '{"a": 25}')
+      local r2 = helper.cypher_params(db, q, '{"a": 35}')
+      local r3 = helper.cypher_params(db, q, '{"a": 45}')
+      assert.is_truthy(r1:find("Alice"))
+      assert.is_truthy(r1:find("Bob"))
+      assert.is_falsy(r2:find("Alice"))
+      assert.is_truthy(r2:find("Bob"))
+      assert.is_falsy(r3:find("Bob"))
+    end)
+
+    it("should treat whitespace variants as the same query", function()
+      local r1 = helper.cypher_params(db, "MATCH (n:Person) WHERE n.age > $a RETURN n.name", '{"a": 35}')
+      local r2 = helper.cypher_params(db, "MATCH   (n:Person)\n  WHERE n.age > $a  RETURN n.name", '{"a": 25}')
+      assert.is_falsy(r1:find("Alice"))
+      assert.is_truthy(r2:find("Alice"))
+    end)
+
+    it("should keep whitespace inside string literals", function()
+      helper.cypher_exec(db, 'CREATE (:Person {name: "A  B"})')
+      local r1 = helper.cypher_query(db, 'MATCH (n:Person) WHERE n.name = "A  B" RETURN n.name')
+      local r2 = helper.cypher_query(db, 'MATCH (n:Person) WHERE n.name = "A B" RETURN n.name')
+      assert.is_truthy(tostring(r1[1][1]):find("A  B", 1, true))
+      assert.is_falsy(tostring(r2[1][1]):find("A  B", 1, true))
+    end)
+  end)
+
+  describe("Repeated execution", function()
+    it("should return identical results for cached RETURN *", function()
+      local q = "MATCH (n:Person)-[]->(m) RETURN *"
+      local r1 = helper.cypher_query(db, q)
+      local r2 = helper.cypher_query(db, q)
+      assert.are.equal(r1[1][1], r2[1][1])
+    end)
+
+    it("should run cached CREATE with new parameters each time", function()
+      local q = "CREATE (c:Person {name: $n})"
+      helper.cypher_params(db, q, '{"n": "Carol"}')
+      helper.cypher_params(db, q, '{"n": "Dave"}')
+      local results = helper.cypher_query(db, "MATCH (n:Person) RETURN count(n) AS cnt")
+      assert.is_truthy(tostring(results[1][1]):find("4"))
+    end)
+
+    it("should see index changes between calls", function()
+      local q = "MATCH (n:Person) WHERE n.age > $a RETURN n.name"
+      helper.cypher_params(db, q, '{"a": 25}')
+      db:exec("CREATE INDEX idx_test_nodes ON nodes(id)")
+      local r = helper.cypher_params(db, q, '{"a": 35}')
+      assert.is_truthy(r:find("Bob"))
+    end)
+
+    it("should match by inline properties on repeated MATCH...CREATE", function()
+      local q = 'MATCH (a:Person {name: "Alice"}), (b:Person {name: "Bob"}) CREATE (a)-[:LIKES]->(b)'
+      helper.cypher_exec(db, q)
+      helper.cypher_exec(db, q)
+      local results = helper.cypher_query(db, "MATCH (a)-[:LIKES]->(b) RETURN a.name, b.name")
+      local rows = tostring(results[1][1])
+      assert.is_falsy(rows:find('"b.name":"Alice"', 1, true))
+      assert.are.equal(2, select(2, rows:gsub('"b.name":"Bob"', "")))
+    end)
+
+    it("should match by inline properties on repeated MATCH...DELETE", function()
+      local q = 'MATCH (a:Person {name: "Alice"}) DETACH DELETE a'
+      helper.cypher_exec(db, q)
+      helper.cypher_exec(db, 'CREATE (:Person {name: "Alice"})')
+      helper.cypher_exec(db, q)
+      local results = helper.cypher_query(db, "MATCH (n:Person) RETURN n.name")
+      local rows = tostring(results[1][1])
+      assert.is_falsy(rows:find("Alice"))
+      assert.is_truthy(rows:find("Bob"))
+    end)
+  end)
+end)
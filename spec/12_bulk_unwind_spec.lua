@@ -0,0 +1,105 @@
+-- ========================================================================
+-- Test 12: Bulk UNWIND Import
+-- ========================================================================
+-- PURPOSE: Batched UNWIND+CREATE / UNWIND+MERGE must match per-row results
+-- COVERS:  row maps (r.key), typed values, constants and parameters,
+--          batches larger than one INSERT, MERGE dedupe within a batch
+-- ========================================================================
+
+local sqlite3 = require("lsqlite3")
+local helper = require("spec.helper")
+
+-- 执行带参数的查询并返回 JSON 字符串
+describe("Bulk UNWIND Import", function()
+  local db
+
+  before_each(function()
+    db = sqlite3.open_memory()
+    assert.is_not_nil(db, "Failed to open database")
+    helper.ensure_graphqlite(db)
+  end)
+
+  after_each(function()
+    if db then
+      db:close()
+      db = nil
+    end
+  end)
+
+  describe("UNWIND+CREATE", function()
+    it("should read properties from row maps", function()
+      helper.cypher_params(db, "UNWIND $rows AS r CREATE (:Person {name: r.name, age: r.age})",
+        '{"rows": [{"name": "Alice", "age": 30}, {"name": "Bob", "age": 40}]}')
+      local results = helper.cypher_query(db, "MATCH (n:Person) WHERE n.age > 35 RETURN n.name")
+      assert.is_truthy(tostring(results[1][1]):find("Bob"))
+      assert.is_falsy(tostring(results[1][1]):find("Alice"))
+    end)
+
+    it("should keep value types", function()
+      helper.cypher_params(db, "UNWIND $xs AS x CREATE (:V {v: x})", '{"xs": [1, 2.5, "s", [1, 2]]}')
+      local results = helper.cypher_query(db, "MATCH (n:V) WHERE n.v = 2.5 RETURN count(n) AS c")
+      assert.is_truthy(tostring(results[1][1]):find("1"))
+    end)
+
+    it("should skip null values", function()
+      helper.cypher_params(db, "UNWIND $rows AS r CREATE (:N {a: r.a, b: r.b})", '{"rows": [{"a": 1}]}')
+      local results = helper.cypher_query(db, "MATCH (n:N) RETURN keys(n)")
+      assert.is_falsy(tostring(results[1][1]):find("b"))
+    end)
+
+    it("should combine constants, parameters and list literals", function()
+      helper.cypher_params(db, 'UNWIND [1, 2, 3] AS i CREATE (:C {i: i, src: $src, kind: "lit"})', '{"src": "test"}')
+      local results = helper.cypher_query(db, 'MATCH (n:C {src: "test", kind: "lit"}) RETURN count(n) AS c')
+      assert.is_truthy(tostring(results[1][1]):find("3"))
+    end)
+
+    it("should import more rows than one batch", function()
+      local xs = {}
+      for i = 1, 1000 do
+        xs[#xs + 1] = tostring(i)
+      end
+      helper.cypher_params(db, "UNWIND $xs AS x CREATE (:B {x: x}), (:B2 {x: x})", '{"xs": [' .. table.concat(xs, ",") .. ']}')
+      local results = helper.cypher_query(db, "MATCH (n:B) RETURN count(n) AS c, sum(n.x) AS s")
+      assert.is_truthy(tostring(results[1][1]):find("1000"))
+      assert.is_truthy(tostring(results[1][1]):find("500500"))
+    end)
+
+    it("should continue node ids after the import", function()
+      helper.cypher_params(db, "UNWIND $xs AS x CREATE (:I {x: x})", '{"xs": [1, 2, 3]}')
+      helper.cypher_exec(db, "CREATE (:After)")
+      local results = helper.cypher_query(db, "MATCH (n:After) RETURN id(n)")
+      assert.is_truthy(tostring(results[1][1]):find("4"))
+    end)
+  end)
+
+  describe("UNWIND+MERGE", function()
+    it("should match existing nodes and dedupe within the batch", function()
+      helper.cypher_exec(db, 'CREATE (:Tag {name: "a"})')
+      helper.cypher_params(db, "UNWIND $rows AS r MERGE (:Tag {name: r.name})",
+        '{"rows": [{"name": "a"}, {"name": "b"}, {"name": "b"}]}')
+      local results = helper.cypher_query(db, "MATCH (n:Tag) RETURN count(n) AS c")
+      assert.is_truthy(tostring(results[1][1]):find("2"))
+    end)
+
+    it("should compare values by type", function()
+      helper.cypher_params(db, "UNWIND $xs AS x MERGE (:K {v: x})", '{"xs": [1, "1", 1]}')
+      local results = helper.cypher_query(db, "MATCH (n:K) RETURN count(n) AS c")
+      assert.is_truthy(tostring(results[1][1]):find("2"))
+    end)
+
+    it("should reject null merge values and leave nothing behind", function()
+      pcall(helper.cypher_params, db, "UNWIND $rows AS r MERGE (:Z {name: r.name})",
+        '{"rows": [{"name": "a"}, {"other": 1}]}')
+      local results = helper.cypher_query(db, "MATCH (n:Z) RETURN count(n) AS c")
+      assert.is_truthy(tostring(results[1][1]):find("0"))
+    end)
+
+    it("should forget property keys created by a failed merge", function()
+      pcall(helper.cypher_params, db, "UNWIND $rows AS r MERGE (:Z {k: r.k, brandnew: r.b})",
+        '{"rows": [{"k": 1, "b": 5}, {"b": 6}]}')
+      helper.cypher_query(db, "CREATE (:N {brandnew: 9})")
+      local results = helper.cypher_query(db, "MATCH (n:N) RETURN n.brandnew")
+      assert.is_truthy(tostring(results[1][1]):find("9"))
+    end)
+  end)
+end)
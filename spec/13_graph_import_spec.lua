@@ -0,0 +1,149 @@
+-- ========================================================================
+-- Test 13: Bulk Graph Import
+-- ========================================================================
+-- PURPOSE: gql_import() must load CSV / JSONL files like the equivalent
+--          CREATE statements would
+-- COVERS:  header roles and typed columns, quoting, type inference,
+--          edge endpoint resolution, JSONL, rollback on error, error JSON
+-- ========================================================================
+
+local sqlite3 = require("lsqlite3")
+local helper = require("spec.helper")
+
+-- 写入临时文件并返回路径
+local function write_temp(suffix, content)
+  local path = os.tmpname() .. suffix
+  local f = assert(io.open(path, "w"))
+  f:write(content)
+  f:close()
+  return path
+end
+
+local function import(db, nodes, edges, options)
+  local stmt = db:prepare("SELECT gql_import(?, ?, ?)")
+  stmt:bind_values(nodes, edges, options)
+  local value = nil
+  for row in stmt:rows() do
+    value = row[1]
+  end
+  stmt:finalize()
+  return value
+end
+
+describe("Bulk Graph Import", function()
+  local db
+  local files
+
+  before_each(function()
+    db = sqlite3.open_memory()
+    assert.is_not_nil(db, "Failed to open database")
+    helper.ensure_graphqlite(db)
+    files = {}
+  end)
+
+  after_each(function()
+    if db then
+      db:close()
+      db = nil
+    end
+    for _, path in ipairs(files) do
+      os.remove(path)
+    end
+  end)
+
+  local function temp(suffix, content)
+    local path = write_temp(suffix, content)
+    files[#files + 1] = path
+    return path
+  end
+
+  describe("CSV", function()
+    it("should load nodes, labels and typed properties", function()
+      local nodes = temp(".csv", 'id,label,name,age:int,zip\n' ..
+        '1,Person;Employee,"Smith, ""Al""",30,01234\n' ..
+        '2,Person,Bob,,\n')
+      local stats = import(db, nodes, nil, nil)
+      assert.is_truthy(stats:find('"nodes":2'))
+
+      local results = helper.cypher_query(db, "MATCH (n:Employee) RETURN n.name, n.age, n.zip")
+      local row = tostring(results[1][1])
+      assert.is_truthy(row:find('Smith, \\"Al\\"', 1, true))
+      assert.is_truthy(row:find('"n.age":30', 1, true))
+      assert.is_truthy(row:find('"n.zip":"01234"', 1, true))
+    end)
+
+    it("should resolve edge endpoints and skip unknown ones", function()
+      local nodes = temp(".csv", "id:ID,name\na,Alice\nb,Bob\n")
+      local edges = temp(".csv", ":START_ID,:END_ID,:TYPE,since\na,b,KNOWS,2020\na,zz,KNOWS,1\n")
+      local stats = import(db, nodes, edges, nil)
+      assert.is_truthy(stats:find('"edges":1'))
+      assert.is_truthy(stats:find('"skipped":1'))
+
+      local results = helper.cypher_query(db, "MATCH (a)-[r:KNOWS]->(b) RETURN a.name, r.since, b.name")
+      assert.is_truthy(tostring(results[1][1]):find("Bob"))
+      assert.is_truthy(tostring(results[1][1]):find("2020"))
+    end)
+
+    it("should connect edges to nodes loaded earlier", function()
+      import(db, temp(".csv", "id,name\n1,Alice\n2,Bob\n"), nil, nil)
+      import(db, nil, temp(".csv", "source,target\n1,2\n"), '{"type": "LIKES"}')
+      local results = helper.cypher_query(db, "MATCH (a)-[:LIKES]->(b) RETURN b.name")
+      assert.is_truthy(tostring(results[1][1]):find("Bob"))
+    end)
+
+    it("should skip a UTF-8 byte order mark before the header", function()
+      local nodes = temp(".csv", "\239\187\191id,name\n1,Alice\n2,Bob\n")
+      local edges = temp(".csv", "\239\187\191source,target\n1,2\n")
+      local stats = import(db, nodes, edges, '{"type": "KNOWS"}')
+      assert.is_truthy(stats:find('"edges":1'))
+
+      local results = helper.cypher_query(db, "MATCH (a)-[:KNOWS]->(b) RETURN a.id, b.name")
+      assert.is_truthy(tostring(results[1][1]):find('"a.id":1', 1, true))
+    end)
+
+    it("should rebuild the graph indexes", function()
+      import(db, temp(".csv", "id\n1\n"), nil, nil)
+      local count = 0
+      for _ in db:nrows("SELECT name FROM sqlite_master WHERE name = 'idx_edges_source'") do
+        count = count + 1
+      end
+      assert.are.equal(1, count)
+    end)
+  end)
+
+  describe("JSONL", function()
+    it("should load nested and top-level properties", function()
+      local nodes = temp(".jsonl", '{"id": "a", "labels": ["P"], "properties": {"n": 1}}\n' ..
+        '{"id": "b", "label": "P", "n": 2}\n')
+      local edges = temp(".jsonl", '{"source": "a", "target": "b", "type": "R", "w": 0.5}\n')
+      import(db, nodes, edges, nil)
+      local results = helper.cypher_query(db, "MATCH (a:P)-[r:R]->(b:P) RETURN a.n, r.w, b.n")
+      local row = tostring(results[1][1])
+      assert.is_truthy(row:find('"a.n":1', 1, true))
+      assert.is_truthy(row:find('"b.n":2', 1, true))
+    end)
+  end)
+
+  describe("Errors", function()
+    it("should leave nothing behind on a duplicate id", function()
+      pcall(import, db, temp(".csv", "id\n1\n2\n1\n"), nil, nil)
+      local results = helper.cypher_query(db, "MATCH (n) RETURN count(n) AS c")
+      assert.is_truthy(tostring(results[1][1]):find("0"))
+    end)
+
+    it("should report errors as valid JSON", function()
+      pcall(import, db, nil, temp(".csv", "a,b\n1,2\n"), nil)
+      local message = db:errmsg()
+      assert.is_truthy(message:find("edge files need", 1, true))
+
+      local stmt = db:prepare("SELECT json_valid(?)")
+      stmt:bind_values(message)
+      local valid = nil
+      for row in stmt:rows() do
+        valid = row[1]
+      end
+      stmt:finalize()
+      assert.are.equal(1, valid)
+    end)
+  end)
+end)
@@ -0,0 +1,126 @@
+-- ========================================================================
+-- Test 14: Property Type Catalog
+-- ========================================================================
+-- PURPOSE: Property access resolved against the key/type catalog must see
+--          every write, including ones made after the query was cached
+-- COVERS:  new types for a cached query, mixed types, map projections,
+--          ROLLBACK and ROLLBACK TO, catalog backfill, dropped triggers
+-- ========================================================================
+
+local sqlite3 = require("lsqlite3")
+local helper = require("spec.helper")
+
+describe("Property Type Catalog", function()
+  local db
+
+  before_each(function()
+    db = sqlite3.open_memory()
+    assert.is_not_nil(db, "Failed to open database")
+    helper.ensure_graphqlite(db)
+  end)
+
+  after_each(function()
+    if db then
+      db:close()
+      db = nil
+    end
+  end)
+
+  describe("Cached queries", function()
+    it("should see a type first written after the query was cached", function()
+      helper.cypher_exec(db, 'CREATE (:T {v: 1})')
+      helper.cypher_query(db, "MATCH (n:T) RETURN n.v")
+      helper.cypher_exec(db, 'CREATE (:T {v: "two"})')
+      local results = helper.cypher_query(db, "MATCH (n:T) RETURN n.v")
+      assert.is_truthy(tostring(results[1][1]):find('"two"', 1, true))
+    end)
+
+    it("should see a key first created after the query was cached", function()
+      helper.cypher_exec(db, 'CREATE (:T {v: 1})')
+      helper.cypher_query(db, "MATCH (n:T) RETURN n.later")
+      helper.cypher_exec(db, 'MATCH (n:T) SET n.later = 5')
+      local results = helper.cypher_query(db, "MATCH (n:T) RETURN n.later")
+      assert.is_truthy(tostring(results[1][1]):find("5"))
+    end)
+
+    it("should compare keys holding several types", function()
+      helper.cypher_exec(db, 'CREATE (:M {v: 10}), (:M {v: 2.5}), (:M {v: "x"}), (:M {v: true})')
+      local results = helper.cypher_query(db, 'MATCH (n:M) WHERE n.v = 2.5 OR n.v = "x" RETURN count(n) AS c')
+      assert.is_truthy(tostring(results[1][1]):find("2"))
+    end)
+
+    it("should keep node and edge types apart", function()
+      helper.cypher_exec(db, 'CREATE (:E {w: "node"})-[:R {w: 7}]->(:E)')
+      local results = helper.cypher_query(db, "MATCH (a)-[r:R]->(b) RETURN a.w, r.w, b.w")
+      local row = tostring(results[1][1])
+      assert.is_truthy(row:find('"a.w":"node"', 1, true))
+      assert.is_truthy(row:find('"r.w":7', 1, true))
+    end)
+
+    it("should resolve map projection values", function()
+      helper.cypher_exec(db, 'CREATE (:P {name: "Al", tags: [1, 2], ok: true})')
+      local results = helper.cypher_query(db, "MATCH (n:P) RETURN n {.name, .tags, .ok}")
+      local row = tostring(results[1][1])
+      assert.is_truthy(row:find('"tags":[1,2]', 1, true))
+      assert.is_truthy(row:find('"ok":"true"', 1, true))
+    end)
+  end)
+
+  describe("Rollback", function()
+    it("should not reuse key ids from a rolled back transaction", function()
+      db:exec("BEGIN")
+      helper.cypher_exec(db, 'CREATE (:R {gone: 1})')
+      helper.cypher_query(db, "MATCH (n:R) RETURN n.gone")
+      db:exec("ROLLBACK")
+
+      helper.cypher_exec(db, 'CREATE (:R {kept: "yes"})')
+      local results = helper.cypher_query(db, "MATCH (n:R) RETURN n.kept, n.gone")
+      local row = tostring(results[1][1])
+      assert.is_truthy(row:find('"n.kept":"yes"', 1, true))
+      assert.is_truthy(row:find('"n.gone":null', 1, true))
+    end)
+
+    it("should notice ROLLBACK TO a savepoint", function()
+      db:exec("SAVEPOINT s")
+      helper.cypher_exec(db, 'CREATE (:S {a: 1})')
+      db:exec("ROLLBACK TO s")
+      db:exec("RELEASE s")
+
+      helper.cypher_exec(db, 'CREATE (:S {b: "two"})')
+      helper.cypher_exec(db, 'MATCH (n:S) SET n.a = 5')
+      local results = helper.cypher_query(db, "MATCH (n:S) RETURN n.a, n.b")
+      local row = tostring(results[1][1])
+      assert.is_truthy(row:find('"n.a":5', 1, true))
+      assert.is_truthy(row:find('"n.b":"two"', 1, true))
+    end)
+  end)
+
+  describe("Catalog table", function()
+    it("should record the types written", function()
+      helper.cypher_exec(db, 'CREATE (:C {i: 1, s: "s"})-[:R {r: 0.5}]->(:C)')
+      local types = {}
+      for row in db:nrows("SELECT pk.key, t.owner, t.type FROM property_key_types t " ..
+                          "JOIN property_keys pk ON pk.id = t.key_id ORDER BY pk.key") do
+        types[#types + 1] = row.key .. ":" .. row.owner .. ":" .. row.type
+      end
+      assert.are.same({ "i:node:int", "r:edge:real", "s:node:text" }, types)
+    end)
+
+    it("should restore triggers an interrupted import left dropped", function()
+      local path = os.tmpname()
+      local conn = sqlite3.open(path)
+      helper.ensure_graphqlite(conn)
+      helper.cypher_exec(conn, 'CREATE (:X {s: 1})')
+      conn:exec("DROP TRIGGER node_props_real_catalog")
+      conn:close()
+
+      conn = sqlite3.open(path)
+      helper.ensure_graphqlite(conn)
+      helper.cypher_exec(conn, 'CREATE (:X {s: 2.5})')
+      local results = helper.cypher_query(conn, "MATCH (n:X) WHERE n.s = 2.5 RETURN n.s")
+      conn:close()
+      os.remove(path)
+      assert.is_truthy(tostring(results[1][1]):find('"n.s":%s*2%.5'))
+    end)
+  end)
+end)
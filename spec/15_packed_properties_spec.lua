@@ -0,0 +1,119 @@
+-- ========================================================================
+-- Test 15: Packed Property Records
+-- ========================================================================
+-- PURPOSE: With gql_packed_properties(1), whole-entity reads come from the
+--          packed records and must match what the typed tables hold
+-- COVERS:  enable with existing data, CREATE / SET / REMOVE / DELETE,
+--          value types when enabled late, edges, properties(), bulk import,
+--          disabling
+-- ========================================================================
+
+local sqlite3 = require("lsqlite3")
+local helper = require("spec.helper")
+
+describe("Packed Property Records", function()
+  local db
+
+  before_each(function()
+    db = sqlite3.open_memory()
+    assert.is_not_nil(db, "Failed to open database")
+    helper.ensure_graphqlite(db)
+  end)
+
+  after_each(function()
+    if db then
+      db:close()
+      db = nil
+    end
+  end)
+
+  describe("Enabling", function()
+    it("should pack properties written before it was enabled", function()
+      helper.cypher_exec(db, 'CREATE (:P {name: "Al", age: 30, tags: [1, 2]})')
+      assert.is_truthy(helper.scalar(db, "SELECT gql_packed_properties(1)"):find("enabled"))
+
+      assert.are.equal('{"name":"Al","age":30,"tags":[1,2]}', helper.scalar(db, "SELECT props FROM node_props_packed"))
+      local results = helper.cypher_query(db, "MATCH (n:P) RETURN n")
+      local row = tostring(results[1][1])
+      assert.is_truthy(row:find('"name": "Al"', 1, true))
+      assert.is_truthy(row:find('"tags": [1,2]', 1, true))
+    end)
+
+    it("should keep the types of numbers and booleans written before it was enabled", function()
+      helper.cypher_exec(db, 'CREATE (:P {name: "Al", age: 30, score: 2.5, active: true})')
+      helper.scalar(db, "SELECT gql_packed_properties(1)")
+      helper.cypher_exec(db, 'CREATE (:P {name: "Bo", age: 31, score: 3.5, active: false})')
+
+      assert.are.equal('{"name":"Al","age":30,"score":2.5,"active":1}',
+                       helper.scalar(db, "SELECT props FROM node_props_packed WHERE node_id = 1"))
+      local results = helper.cypher_query(db, "MATCH (n:P) RETURN properties(n)")
+      local row = tostring(results[1][1])
+      assert.is_truthy(row:find('"age":30,', 1, true))
+      assert.is_truthy(row:find('"score":2.5,', 1, true))
+      assert.is_truthy(row:find('"age":31,', 1, true))
+    end)
+
+    it("should drop the records when disabled", function()
+      helper.scalar(db, "SELECT gql_packed_properties(1)")
+      helper.cypher_exec(db, 'CREATE (:P {name: "Al"})')
+      helper.scalar(db, "SELECT gql_packed_properties(0)")
+
+      assert.are.equal(0, helper.scalar(db, "SELECT count(*) FROM sqlite_master WHERE name = 'node_props_packed'"))
+      local results = helper.cypher_query(db, "MATCH (n:P) RETURN n")
+      assert.is_truthy(tostring(results[1][1]):find('"name": "Al"', 1, true))
+    end)
+  end)
+
+  describe("Writes", function()
+    before_each(function()
+      helper.scalar(db, "SELECT gql_packed_properties(1)")
+    end)
+
+    it("should follow SET and REMOVE", function()
+      helper.cypher_exec(db, 'CREATE (:P {name: "Al", age: 30})')
+      helper.cypher_exec(db, 'MATCH (n:P) SET n.age = "thirty", n.city = "Oslo"')
+      helper.cypher_exec(db, 'MATCH (n:P) REMOVE n.name')
+      assert.are.equal('{"age":"thirty","city":"Oslo"}', helper.scalar(db, "SELECT props FROM node_props_packed"))
+
+      helper.cypher_exec(db, 'MATCH (n:P) SET n = {only: 1}')
+      local results = helper.cypher_query(db, "MATCH (n:P) RETURN properties(n)")
+      assert.are.equal('{"properties(n)":{"only":1}}', tostring(results[1][1]):match("{.*}"))
+    end)
+
+    it("should drop the record of a deleted entity", function()
+      helper.cypher_exec(db, 'CREATE (:A {v: 1})-[:R {w: 2}]->(:B {v: 2})')
+      assert.are.equal('{"w":2}', helper.scalar(db, "SELECT props FROM edge_props_packed"))
+
+      helper.cypher_exec(db, 'MATCH (a:A) DETACH DELETE a')
+      assert.are.equal(0, helper.scalar(db, "SELECT count(*) FROM edge_props_packed"))
+      assert.are.equal(1, helper.scalar(db, "SELECT count(*) FROM node_props_packed"))
+    end)
+
+    it("should keep no record for an entity without properties", function()
+      helper.cypher_exec(db, 'CREATE (:E {v: 1})')
+      helper.cypher_exec(db, 'MATCH (n:E) REMOVE n.v')
+      assert.are.equal(0, helper.scalar(db, "SELECT count(*) FROM node_props_packed"))
+      local results = helper.cypher_query(db, "MATCH (n:E) RETURN n")
+      assert.is_truthy(tostring(results[1][1]):find('"properties": {}', 1, true))
+    end)
+  end)
+
+  describe("Bulk import", function()
+    it("should rebuild records after a deferred load", function()
+      helper.scalar(db, "SELECT gql_packed_properties(1)")
+      local path = os.tmpname() .. ".csv"
+      local f = assert(io.open(path, "w"))
+      f:write("id,name,age:int\n1,Al,30\n2,Bo,\n")
+      f:close()
+      local stmt = db:prepare("SELECT gql_import(?, NULL)")
+      stmt:bind_values(path)
+      for _ in stmt:rows() do end
+      stmt:finalize()
+      os.remove(path)
+
+      assert.are.equal('{"id":1,"name":"Al","age":30}',
+                       helper.scalar(db, "SELECT props FROM node_props_packed ORDER BY node_id LIMIT 1"))
+      assert.are.equal(1, helper.scalar(db, "SELECT count(*) FROM sqlite_master WHERE name = 'nodes_packed_delete'"))
+    end)
+  end)
+end)
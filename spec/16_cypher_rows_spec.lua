@@ -0,0 +1,95 @@
+-- ========================================================================
+-- Test 16: cypher_rows Table-Valued Function
+-- ========================================================================
+-- PURPOSE: cypher_rows(query, params) must yield the same cells as
+--          cypher(), one row per cell with typed values
+-- COVERS:  typed values, entity JSON, params, LIMIT and row bounds,
+--          write queries, errors
+-- ========================================================================
+
+local sqlite3 = require("lsqlite3")
+local helper = require("spec.helper")
+
+local function cells(db, sql)
+  local out = {}
+  for row in db:nrows(sql) do
+    out[#out + 1] = row
+  end
+  return out
+end
+
+describe("cypher_rows", function()
+  local db
+
+  before_each(function()
+    db = sqlite3.open_memory()
+    assert.is_not_nil(db, "Failed to open database")
+    helper.ensure_graphqlite(db)
+    helper.cypher_exec(db, 'CREATE (:P {name: "Al", age: 30})-[:K {w: 1.5}]->(:P {name: "Bo", age: 25})')
+  end)
+
+  after_each(function()
+    if db then
+      db:close()
+      db = nil
+    end
+  end)
+
+  describe("Values", function()
+    it("should return one typed cell per column", function()
+      local rows = cells(db, "SELECT row, col, name, value, typeof(value) AS t " ..
+                             "FROM cypher_rows('MATCH (n:P) RETURN n.name, n.age ORDER BY n.age')")
+      assert.are.equal(4, #rows)
+      assert.are.same({ 0, 0, "n.name", "Bo", "text" }, { rows[1].row, rows[1].col, rows[1].name, rows[1].value, rows[1].t })
+      assert.are.same({ 0, 1, "n.age", 25, "integer" }, { rows[2].row, rows[2].col, rows[2].name, rows[2].value, rows[2].t })
+      assert.are.equal(1, rows[3].row)
+    end)
+
+    it("should give entities their id and agtype JSON", function()
+      local rows = cells(db, "SELECT name, value, json FROM cypher_rows('MATCH (a)-[r:K]->(b) RETURN a, r, b.name')")
+      assert.are.equal(1, rows[1].value)
+      assert.is_truthy(rows[1].json:find('"name": "Al"', 1, true))
+      assert.is_truthy(rows[2].json:find('"type": "K"', 1, true))
+      assert.is_nil(rows[3].json)
+    end)
+
+    it("should bind parameters", function()
+      local rows = cells(db, "SELECT value FROM cypher_rows('MATCH (n:P) WHERE n.age > $min RETURN n.name', " ..
+                             "'{\"min\": 26}')")
+      assert.are.equal(1, #rows)
+      assert.are.equal("Al", rows[1].value)
+    end)
+  end)
+
+  describe("Streaming", function()
+    it("should stop at LIMIT and row bounds", function()
+      helper.cypher_exec(db, "UNWIND [1, 2, 3, 4, 5] AS i CREATE (:N {i: i})")
+      assert.are.equal(2, #cells(db, "SELECT * FROM cypher_rows('MATCH (n:N) RETURN n.i') LIMIT 2"))
+      local rows = cells(db, "SELECT row, value FROM cypher_rows('MATCH (n:N) RETURN n.i ORDER BY n.i') WHERE row <= 1")
+      assert.are.same({ 1, 2 }, { rows[1].value, rows[2].value })
+      rows = cells(db, "SELECT value FROM cypher_rows('MATCH (n:N) RETURN n.i ORDER BY n.i') WHERE row = 3")
+      assert.are.equal(4, rows[1].value)
+    end)
+
+    it("should join with other tables", function()
+      db:exec("CREATE TABLE ages(age INTEGER, label TEXT); INSERT INTO ages VALUES (30, 'thirty')")
+      local rows = cells(db, "SELECT a.label FROM cypher_rows('MATCH (n:P) RETURN n.age') c " ..
+                             "JOIN ages a ON a.age = c.value")
+      assert.are.equal("thirty", rows[1].label)
+    end)
+  end)
+
+  describe("Writes and errors", function()
+    it("should run write queries once", function()
+      cells(db, "SELECT * FROM cypher_rows('CREATE (:W {v: 1})')")
+      local rows = cells(db, "SELECT value FROM cypher_rows('MATCH (w:W) RETURN count(w) AS c')")
+      assert.are.equal(1, rows[1].value)
+    end)
+
+    it("should report query errors", function()
+      local ok = pcall(cells, db, "SELECT * FROM cypher_rows('MATCH (n RETURN n')")
+      assert.is_false(ok)
+      assert.is_truthy(db:errmsg():find("syntax error"))
+    end)
+  end)
+end)
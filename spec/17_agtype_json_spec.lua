@@ -0,0 +1,59 @@
+-- ========================================================================
+-- Test 17: Entity JSON Round-Trip
+-- ========================================================================
+-- PURPOSE: Nodes and relationships returned whole must carry every
+--          property value through the agtype parser unchanged
+-- COVERS:  escapes and unicode, nested lists and maps, integer limits,
+--          relationship types and endpoints
+-- ========================================================================
+
+local sqlite3 = require("lsqlite3")
+local helper = require("spec.helper")
+
+describe("Entity JSON Round-Trip", function()
+  local db
+
+  before_each(function()
+    db = sqlite3.open_memory()
+    assert.is_not_nil(db, "Failed to open database")
+    helper.ensure_graphqlite(db)
+  end)
+
+  after_each(function()
+    if db then
+      db:close()
+      db = nil
+    end
+  end)
+
+  it("should keep escaped and unicode strings", function()
+    helper.cypher_exec(db, 'CREATE (:S {q: "say \\"hi\\"", p: "a\\\\b", u: "héllo ☃"})')
+    local row = tostring(helper.cypher_query(db, "MATCH (n:S) RETURN n")[1][1])
+    assert.is_truthy(row:find('"q": "say \\"hi\\""', 1, true))
+    assert.is_truthy(row:find('"p": "a\\\\b"', 1, true))
+    assert.is_truthy(row:find('"u": "héllo ☃"', 1, true))
+  end)
+
+  it("should keep nested lists and maps as JSON", function()
+    helper.cypher_exec(db, 'CREATE (:N {l: [1, "x", [2]], m: {a: {b: [1.5, null]}}})')
+    local row = tostring(helper.cypher_query(db, "MATCH (n:N) RETURN n")[1][1])
+    assert.is_truthy(row:find('"l": [1,"x",[2]]', 1, true))
+    assert.is_truthy(row:find('"m": {"a":{"b":[1.5,null]}}', 1, true))
+  end)
+
+  it("should keep numbers and labels", function()
+    helper.cypher_exec(db, 'CREATE (:A:B {big: 9223372036854775807, neg: -42, r: 0.25})')
+    local row = tostring(helper.cypher_query(db, "MATCH (n:A) RETURN n")[1][1])
+    assert.is_truthy(row:find('"labels": ["A","B"]', 1, true))
+    assert.is_truthy(row:find('"big": 9223372036854775807', 1, true))
+    assert.is_truthy(row:find('"neg": -42', 1, true))
+    assert.is_truthy(row:find('"r": 0.25', 1, true))
+  end)
+
+  it("should read relationship type, endpoints and properties", function()
+    helper.cypher_exec(db, 'CREATE (:X)-[:REL {w: "z", e: []}]->(:Y)')
+    local row = tostring(helper.cypher_query(db, "MATCH ()-[r]->() RETURN r")[1][1])
+    assert.is_truthy(row:find('"type": "REL", "startNode": 1, "endNode": 2', 1, true))
+    assert.is_truthy(row:find('"properties": {"w": "z", "e": []}', 1, true))
+  end)
+end)
@@ -0,0 +1,108 @@
+-- ========================================================================
+-- Test 18: Incremental Graph Cache
+-- ========================================================================
+-- PURPOSE: A graph cache loaded with {"incremental": true} must follow
+--          writes and give the same algorithm results as a reload
+-- COVERS:  node and edge inserts and deletes, parallel edges, id changes,
+--          rolled back writes, mode kept across reload and unload,
+--          DELETE without WHERE, application update hooks
+-- ========================================================================
+
+local sqlite3 = require("lsqlite3")
+local helper = require("spec.helper")
+
+describe("Incremental Graph Cache", function()
+  local db
+
+  before_each(function()
+    db = sqlite3.open_memory()
+    assert.is_not_nil(db, "Failed to open database")
+    helper.ensure_graphqlite(db)
+    helper.cypher_exec(db, 'CREATE (a:P {id: "a"}), (b:P {id: "b"}), (c:P {id: "c"})')
+    helper.cypher_exec(db, 'MATCH (a {id: "a"}), (b {id: "b"}), (c {id: "c"}) ' ..
+                           'CREATE (a)-[:R]->(b), (a)-[:R]->(b), (b)-[:R]->(c)')
+  end)
+
+  after_each(function()
+    if db then
+      db:close()
+      db = nil
+    end
+  end)
+
+  local function matches_reload(query)
+    local incremental = helper.scalar(db, "SELECT cypher('" .. query .. "')")
+    helper.scalar(db, "SELECT gql_reload_graph()")
+    assert.are.equal(helper.scalar(db, "SELECT cypher('" .. query .. "')"), incremental)
+  end
+
+  it("should report incremental mode and pending changes", function()
+    assert.is_truthy(helper.scalar(db, "SELECT gql_load_graph('{\"incremental\": true}')"):find('"incremental":true', 1, true))
+    helper.cypher_exec(db, 'CREATE (:P {id: "d"})')
+    assert.is_truthy(helper.scalar(db, "SELECT gql_graph_loaded()"):find('"pending_changes":2', 1, true))
+  end)
+
+  it("should follow inserts and deletes", function()
+    helper.scalar(db, "SELECT gql_load_graph('{\"incremental\": true}')")
+    helper.cypher_exec(db, 'MATCH (c {id: "c"}) CREATE (c)-[:R]->(:P {id: "d"})')
+    helper.cypher_exec(db, 'MATCH (b {id: "b"}) DETACH DELETE b')
+    local degrees = helper.scalar(db, "SELECT cypher('RETURN degreeCentrality()')")
+    assert.is_falsy(degrees:find('"user_id":"b"', 1, true))
+    assert.is_truthy(degrees:find('"user_id":"d"', 1, true))
+    assert.is_truthy(helper.scalar(db, "SELECT gql_graph_loaded()"):find('"nodes":3,"edges":1', 1, true))
+    matches_reload("RETURN pageRank()")
+  end)
+
+  it("should drop one of several parallel edges", function()
+    helper.scalar(db, "SELECT gql_load_graph('{\"incremental\": true}')")
+    db:exec("DELETE FROM edges WHERE id = 1")
+    matches_reload("RETURN degreeCentrality()")
+    assert.is_truthy(helper.scalar(db, "SELECT gql_graph_loaded()"):find('"edges":2', 1, true))
+  end)
+
+  it("should pick up changed ids", function()
+    helper.scalar(db, "SELECT gql_load_graph('{\"incremental\": true}')")
+    helper.cypher_exec(db, 'MATCH (c {id: "c"}) SET c.id = "z"')
+    assert.is_truthy(helper.scalar(db, "SELECT cypher('RETURN dijkstra(\"a\", \"z\")')"):find('"found":true', 1, true))
+  end)
+
+  it("should ignore rolled back writes", function()
+    helper.scalar(db, "SELECT gql_load_graph('{\"incremental\": true}')")
+    db:exec("BEGIN")
+    helper.cypher_exec(db, 'MATCH (a {id: "a"}) DETACH DELETE a')
+    db:exec("ROLLBACK")
+    assert.is_truthy(helper.scalar(db, "SELECT cypher('RETURN degreeCentrality()')"):find('"user_id":"a"', 1, true))
+  end)
+
+  it("should keep the mode across reload and drop it on unload", function()
+    helper.scalar(db, "SELECT gql_load_graph('{\"incremental\": true}')")
+    helper.scalar(db, "SELECT gql_reload_graph()")
+    assert.is_truthy(helper.scalar(db, "SELECT gql_graph_loaded()"):find('"incremental":true', 1, true))
+    helper.scalar(db, "SELECT gql_unload_graph()")
+    helper.scalar(db, "SELECT gql_load_graph()")
+    assert.is_falsy(helper.scalar(db, "SELECT gql_graph_loaded()"):find('incremental', 1, true))
+  end)
+
+  it("should follow a DELETE without a WHERE clause", function()
+    helper.scalar(db, "SELECT gql_load_graph('{\"incremental\": true}')")
+    db:exec("DELETE FROM edges")
+    assert.is_truthy(helper.scalar(db, "SELECT gql_graph_loaded()"):find('"pending_changes":3', 1, true))
+    matches_reload("RETURN degreeCentrality()")
+    assert.is_truthy(helper.scalar(db, "SELECT gql_graph_loaded()"):find('"edges":0', 1, true))
+  end)
+
+  it("should leave the application's update hook in place", function()
+    local calls = 0
+    db:update_hook(function() calls = calls + 1 end)
+    helper.scalar(db, "SELECT gql_load_graph('{\"incremental\": true}')")
+    db:exec("INSERT INTO nodes DEFAULT VALUES")
+    helper.scalar(db, "SELECT gql_unload_graph()")
+    db:exec("INSERT INTO nodes DEFAULT VALUES")
+    assert.are.equal(2, calls)
+  end)
+
+  it("should reject options that are not an object", function()
+    assert.are_not.equal(sqlite3.OK, db:exec("SELECT gql_load_graph('[1]')"))
+    assert.is_truthy(db:errmsg():find("JSON object", 1, true))
+  end)
+end)
@@ -0,0 +1,88 @@
+-- ========================================================================
+-- Test 19: Graph Snapshots
+-- ========================================================================
+-- PURPOSE: gql_load_graph('{"snapshot": true}') must persist the CSR next
+--          to the database, map it on later loads and drop it on writes
+-- COVERS:  save then map across connections, invalidation by node, edge
+--          and id writes, reload, in-memory databases, option conflicts
+-- ========================================================================
+
+local sqlite3 = require("lsqlite3")
+local helper = require("spec.helper")
+
+local SNAPSHOT = "SELECT gql_load_graph('{\"snapshot\": true}')"
+
+describe("Graph Snapshots", function()
+  local path, db
+
+  local function open()
+    local conn = sqlite3.open(path)
+    helper.ensure_graphqlite(conn)
+    return conn
+  end
+
+  before_each(function()
+    path = os.tmpname()
+    os.remove(path)
+    db = open()
+    helper.cypher_exec(db, 'CREATE (a:P {id: "a"}), (b:P {id: "b"}), (c:P {id: "c"})')
+    helper.cypher_exec(db, 'MATCH (a {id: "a"}), (b {id: "b"}), (c {id: "c"}) ' ..
+                           'CREATE (a)-[:R]->(b), (b)-[:R]->(c)')
+  end)
+
+  after_each(function()
+    if db then
+      db:close()
+      db = nil
+    end
+    os.remove(path)
+    os.remove(path .. "-graph")
+  end)
+
+  it("should save on first load and map afterwards", function()
+    assert.is_truthy(helper.scalar(db, SNAPSHOT):find('"snapshot":"saved"', 1, true))
+    local other = open()
+    assert.is_truthy(helper.scalar(other, SNAPSHOT):find('"nodes":3,"edges":2,"snapshot":"mapped"', 1, true))
+    assert.are.equal(helper.scalar(db, "SELECT cypher('RETURN pageRank()')"),
+                     helper.scalar(other, "SELECT cypher('RETURN pageRank()')"))
+    assert.is_truthy(helper.scalar(other, "SELECT cypher('RETURN dijkstra(\"a\", \"c\")')"):find('"found":true', 1, true))
+    other:close()
+  end)
+
+  it("should be invalidated by graph writes but not other properties", function()
+    helper.scalar(db, SNAPSHOT)
+    helper.cypher_exec(db, 'MATCH (c {id: "c"}) SET c.age = 3')
+    assert.are.equal(1, helper.scalar(db, "SELECT count(*) FROM graph_snapshot"))
+    helper.cypher_exec(db, 'MATCH (c {id: "c"}) SET c.id = "z"')
+    assert.are.equal(0, helper.scalar(db, "SELECT count(*) FROM graph_snapshot"))
+
+    helper.scalar(db, SNAPSHOT)
+    helper.cypher_exec(db, "CREATE (:P)")
+    assert.are.equal(0, helper.scalar(db, "SELECT count(*) FROM graph_snapshot"))
+
+    local other = open()
+    local loaded = helper.scalar(other, SNAPSHOT)
+    assert.is_truthy(loaded:find('"nodes":4', 1, true))
+    assert.is_truthy(loaded:find('"snapshot":"saved"', 1, true))
+    other:close()
+  end)
+
+  it("should remap or rebuild on reload", function()
+    helper.scalar(db, SNAPSHOT)
+    helper.cypher_exec(db, 'MATCH (b {id: "b"}) DETACH DELETE b')
+    assert.is_truthy(helper.scalar(db, "SELECT gql_reload_graph()"):find('"nodes":2,"edges":0', 1, true))
+    assert.is_truthy(helper.scalar(db, "SELECT gql_graph_loaded()"):find('"snapshot":true', 1, true))
+  end)
+
+  it("should fall back to an unsaved graph in memory", function()
+    local mem = sqlite3.open_memory()
+    helper.ensure_graphqlite(mem)
+    helper.cypher_exec(mem, "CREATE (:P)")
+    assert.is_truthy(helper.scalar(mem, SNAPSHOT):find('"snapshot":"unsaved"', 1, true))
+    mem:close()
+  end)
+
+  it("should refuse incremental snapshots", function()
+    assert.are_not.equal(sqlite3.OK, db:exec("SELECT gql_load_graph('{\"snapshot\": true, \"incremental\": true}')"))
+  end)
+end)
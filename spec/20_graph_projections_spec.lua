@@ -0,0 +1,70 @@
+-- ========================================================================
+-- Test 20: Graph Projections
+-- ========================================================================
+-- PURPOSE: gql_project() must build named subgraphs that algorithms can
+--          select with a trailing {graph: 'name'} argument
+-- COVERS:  label and type filters, edge weights in shortest paths,
+--          parameters, unknown and dropped projections, bad options
+-- ========================================================================
+
+local sqlite3 = require("lsqlite3")
+local helper = require("spec.helper")
+
+describe("Graph Projections", function()
+  local db
+
+  before_each(function()
+    db = sqlite3.open_memory()
+    assert.is_not_nil(db, "Failed to open database")
+    helper.ensure_graphqlite(db)
+    helper.cypher_exec(db, 'CREATE (a:User {id: "a"}), (b:User {id: "b"}), (c:User {id: "c"}), (:Post {id: "x"})')
+    helper.cypher_exec(db, 'MATCH (a {id: "a"}), (b {id: "b"}), (c {id: "c"}), (x {id: "x"}) ' ..
+                           'CREATE (a)-[:FOLLOWS {w: 5.0}]->(b), (b)-[:FOLLOWS {w: 1.0}]->(c), ' ..
+                           '(a)-[:FOLLOWS {w: 10}]->(c), (a)-[:LIKES]->(x), (x)-[:LIKES]->(c)')
+  end)
+
+  after_each(function()
+    if db then
+      db:close()
+      db = nil
+    end
+  end)
+
+  it("should keep only the projected labels and types", function()
+    local projected = helper.scalar(db, "SELECT gql_project('social', '{\"labels\": [\"User\"], \"types\": [\"FOLLOWS\"]}')")
+    assert.is_truthy(projected:find('"nodes":3,"edges":3,"types":1,"weighted":false', 1, true))
+    local degrees = helper.scalar(db, "SELECT cypher('RETURN degreeCentrality({graph: \"social\"})')")
+    assert.is_falsy(degrees:find('"user_id":"x"', 1, true))
+  end)
+
+  it("should match the whole graph when unfiltered", function()
+    helper.scalar(db, "SELECT gql_project('all', '{}')")
+    assert.are.equal(helper.scalar(db, "SELECT cypher('RETURN pageRank()')"),
+                     helper.scalar(db, "SELECT cypher('RETURN pageRank({graph: \"all\"})')"))
+  end)
+
+  it("should use projected weights in shortest paths", function()
+    helper.scalar(db, "SELECT gql_project('social', '{\"types\": \"FOLLOWS\", \"weight\": \"w\"}')")
+    assert.is_truthy(helper.scalar(db, "SELECT cypher('RETURN dijkstra(\"a\", \"c\")')"):find('"path":["a","c"]', 1, true))
+    local weighted = helper.scalar(db, "SELECT cypher('RETURN dijkstra(\"a\", \"c\", {graph: \"social\"})')")
+    assert.is_truthy(weighted:find('"path":["a","b","c"],"distance":6', 1, true))
+  end)
+
+  it("should take the projection name from a parameter", function()
+    helper.scalar(db, "SELECT gql_project('social', '{\"labels\": \"User\"}')")
+    assert.is_truthy(helper.scalar(db, "SELECT cypher('RETURN wcc({graph: $g})', '{\"g\": \"social\"}')"))
+  end)
+
+  it("should reject unknown and dropped projections", function()
+    assert.are_not.equal(sqlite3.OK, db:exec("SELECT cypher('RETURN wcc({graph: \"nope\"})')"))
+    helper.scalar(db, "SELECT gql_project('likes', '{\"types\": \"LIKES\"}')")
+    assert.is_truthy(helper.scalar(db, "SELECT gql_drop_projection('likes')"):find('dropped', 1, true))
+    assert.are_not.equal(sqlite3.OK, db:exec("SELECT cypher('RETURN wcc({graph: \"likes\"})')"))
+  end)
+
+  it("should reject bad options", function()
+    assert.are_not.equal(sqlite3.OK, db:exec("SELECT gql_project('p', '[1]')"))
+    assert.are_not.equal(sqlite3.OK, db:exec("SELECT gql_project('p', '{\"labelz\": 1}')"))
+    assert.are_not.equal(sqlite3.OK, db:exec("SELECT gql_project('p', '{\"labels\": \"Nope\"}')"))
+  end)
+end)
@@ -0,0 +1,68 @@
+-- ========================================================================
+-- Test 21: Graph Worker Threads
+-- ========================================================================
+-- PURPOSE: gql_graph_threads() must size the per-connection worker pool
+--          without changing any algorithm result
+-- COVERS:  PageRank, label propagation, WCC and eigenvector centrality
+--          on one and several threads, reporting, invalid counts
+-- ========================================================================
+
+local sqlite3 = require("lsqlite3")
+local helper = require("spec.helper")
+
+local QUERIES = {
+  "RETURN pageRank()",
+  "RETURN labelPropagation()",
+  "RETURN wcc()",
+  "RETURN eigenvectorCentrality()",
+}
+
+describe("Graph Worker Threads", function()
+  local db
+
+  before_each(function()
+    db = sqlite3.open_memory()
+    assert.is_not_nil(db, "Failed to open database")
+    helper.ensure_graphqlite(db)
+
+    -- Large enough for the kernels to split the graph into parts
+    db:exec("BEGIN")
+    db:exec("WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 20000) " ..
+            "INSERT INTO nodes(id) SELECT i FROM n")
+    db:exec("WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 20000) " ..
+            "INSERT INTO edges(source_id, target_id, type) " ..
+            "SELECT i, (i * 7919) % 20000 + 1, 'R' FROM n UNION ALL " ..
+            "SELECT i, (i + 1) % 20000 + 1, 'R' FROM n WHERE i % 50 <> 0 UNION ALL " ..
+            "SELECT i, (i * 31) % 20000 + 1, 'R' FROM n WHERE i % 3 = 0")
+    db:exec("COMMIT")
+    helper.scalar(db, "SELECT gql_load_graph()")
+  end)
+
+  after_each(function()
+    if db then
+      db:close()
+      db = nil
+    end
+  end)
+
+  it("should default to one thread", function()
+    assert.are.equal('{"threads":1}', helper.scalar(db, "SELECT gql_graph_threads()"))
+  end)
+
+  it("should give the same results on several threads", function()
+    local serial = {}
+    for i, query in ipairs(QUERIES) do
+      serial[i] = helper.scalar(db, "SELECT cypher('" .. query .. "')")
+    end
+
+    assert.are.equal('{"threads":4}', helper.scalar(db, "SELECT gql_graph_threads(4)"))
+    for i, query in ipairs(QUERIES) do
+      assert.are.equal(serial[i], helper.scalar(db, "SELECT cypher('" .. query .. "')"))
+    end
+  end)
+
+  it("should reject negative and non-integer counts", function()
+    assert.are_not.equal(sqlite3.OK, db:exec("SELECT gql_graph_threads(-1)"))
+    assert.are_not.equal(sqlite3.OK, db:exec("SELECT gql_graph_threads('many')"))
+  end)
+end)
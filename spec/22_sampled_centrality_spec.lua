@@ -0,0 +1,71 @@
+-- ========================================================================
+-- Test 22: Parallel and Sampled Centrality
+-- ========================================================================
+-- PURPOSE: betweenness() and closeness() must give the same scores on any
+--          number of threads, and estimate them from sampled pivots when
+--          given a sample count
+-- COVERS:  exact results on several threads, sampling every source,
+--          standard errors, seeds and parameters, non-positive counts
+-- ========================================================================
+
+local sqlite3 = require("lsqlite3")
+local helper = require("spec.helper")
+
+describe("Parallel and Sampled Centrality", function()
+  local db
+
+  before_each(function()
+    db = sqlite3.open_memory()
+    assert.is_not_nil(db, "Failed to open database")
+    helper.ensure_graphqlite(db)
+
+    db:exec("BEGIN")
+    db:exec("WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 2000) " ..
+            "INSERT INTO nodes(id) SELECT i FROM n")
+    db:exec("WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 2000) " ..
+            "INSERT INTO edges(source_id, target_id, type) " ..
+            "SELECT i, (i * 7919) % 2000 + 1, 'R' FROM n UNION ALL " ..
+            "SELECT i, i % 2000 + 1, 'R' FROM n WHERE i % 50 <> 0 UNION ALL " ..
+            "SELECT i, (i * 31) % 2000 + 1, 'R' FROM n WHERE i % 3 = 0")
+    db:exec("COMMIT")
+    helper.scalar(db, "SELECT gql_load_graph()")
+  end)
+
+  after_each(function()
+    if db then
+      db:close()
+      db = nil
+    end
+  end)
+
+  it("should give the same exact scores on several threads", function()
+    local betweenness = helper.scalar(db, "SELECT cypher('RETURN betweenness()')")
+    local closeness = helper.scalar(db, "SELECT cypher('RETURN closeness()')")
+    assert.is_falsy(betweenness:find('"stderr"', 1, true))
+
+    helper.scalar(db, "SELECT gql_graph_threads(4)")
+    assert.are.equal(betweenness, helper.scalar(db, "SELECT cypher('RETURN betweenness()')"))
+    assert.are.equal(closeness, helper.scalar(db, "SELECT cypher('RETURN closeness()')"))
+  end)
+
+  it("should match the exact scores when every source is sampled", function()
+    local exact = helper.scalar(db, "SELECT cypher('RETURN betweennessCentrality()')")
+    local sampled = helper.scalar(db, "SELECT cypher('RETURN betweennessCentrality(5000)')")
+    assert.are.equal(exact, (sampled:gsub(',"stderr":0%.000000', '')))
+  end)
+
+  it("should estimate from pivots with standard errors", function()
+    local sampled = helper.scalar(db, "SELECT cypher('RETURN closeness(200, 7)')")
+    assert.is_truthy(sampled:find('"stderr":', 1, true))
+    assert.are.equal(sampled, helper.scalar(db, "SELECT cypher('RETURN closeness($k, $seed)', '{\"k\": 200, \"seed\": 7}')"))
+    assert.are_not.equal(sampled, helper.scalar(db, "SELECT cypher('RETURN closeness(200, 8)')"))
+
+    helper.scalar(db, "SELECT gql_graph_threads(3)")
+    assert.are.equal(sampled, helper.scalar(db, "SELECT cypher('RETURN closeness(200, 7)')"))
+  end)
+
+  it("should run exactly for non-positive sample counts", function()
+    assert.are.equal(helper.scalar(db, "SELECT cypher('RETURN closeness()')"),
+                     helper.scalar(db, "SELECT cypher('RETURN closeness(0)')"))
+  end)
+end)
@@ -67,4 +67,28 @@ function helper.cypher_query(db, cypher_query)
   return results
 end
 
+-- 带参数执行 Cypher 查询，返回 JSON 结果
+function helper.cypher_params(db, query, params)
+  local stmt = db:prepare("SELECT cypher(?, ?)")
+  stmt:bind_values(query, params)
+  local value = nil
+  for row in stmt:rows() do
+    value = row[1]
+  end
+  stmt:finalize()
+  return value
+end
+
+-- 执行 SQL，返回第一行第一列的值
+function helper.scalar(db, sql)
+  local stmt = db:prepare(sql)
+  local value = nil
+  for row in stmt:rows() do
+    value = row[1]
+    break
+  end
+  stmt:finalize()
+  return value
+end
+
 return helper